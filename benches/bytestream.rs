@@ -3,7 +3,7 @@
 use std::hint::black_box;
 
 use criterion::{criterion_group, criterion_main, Criterion, Throughput};
-use gosub_shared::byte_stream::{ByteStream, Encoding, Stream};
+use gosub_shared::byte_stream::{ByteStream, Config, Encoding, Stream};
 
 /// Build a ~`target` byte UTF-8 input by repeating the sample test file.
 fn make_input(target: usize) -> String {
@@ -15,18 +15,38 @@ fn make_input(target: usize) -> String {
     s
 }
 
-/// Eager decode: how long `from_str` (buffer -> chars + offsets + line_starts) takes.
+/// Storage modes under test: UTF-8 walked in place, and the pre-decoded character table.
+const MODES: [(&str, bool); 2] = [("in-place", true), ("decoded", false)];
+
+/// Build a closed stream over `input` in the given storage mode.
+fn make_stream(input: &str, in_place: bool) -> ByteStream {
+    let mut stream = ByteStream::new(
+        Encoding::UTF8,
+        Some(Config {
+            utf8_in_place: in_place,
+            ..Config::default()
+        }),
+    );
+    stream.read_from_str(input, None);
+    stream.close();
+    stream
+}
+
+/// Eager decode: how long loading takes (buffer -> line_starts, plus chars + offsets
+/// in decoded mode).
 fn decode(c: &mut Criterion) {
     let mut group = c.benchmark_group("bytestream/decode");
     for &size in &[16 * 1024usize, 1024 * 1024, 8 * 1024 * 1024] {
         let input = make_input(size);
         group.throughput(Throughput::Bytes(input.len() as u64));
-        group.bench_function(format!("{}KB", input.len() / 1024), |b| {
-            b.iter(|| {
-                let stream = ByteStream::from_str(black_box(&input), Encoding::UTF8);
-                black_box(stream.tell_bytes());
+        for (mode, in_place) in MODES {
+            group.bench_function(format!("{mode}/{}KB", input.len() / 1024), |b| {
+                b.iter(|| {
+                    let stream = make_stream(black_box(&input), in_place);
+                    black_box(stream.tell_bytes());
+                });
             });
-        });
+        }
     }
     group.finish();
 }
@@ -36,20 +56,34 @@ fn iterate(c: &mut Criterion) {
     let mut group = c.benchmark_group("bytestream/iterate");
     for &size in &[1024 * 1024usize, 8 * 1024 * 1024] {
         let input = make_input(size);
-        let mut stream = ByteStream::from_str(&input, Encoding::UTF8);
         group.throughput(Throughput::Bytes(input.len() as u64));
-        group.bench_function(format!("{}KB", input.len() / 1024), |b| {
-            b.iter(|| {
-                stream.reset_stream();
-                while !stream.eof() {
-                    black_box(stream.read_and_next());
-                }
+        for (mode, in_place) in MODES {
+            let mut stream = make_stream(&input, in_place);
+            group.bench_function(format!("{mode}/{}KB", input.len() / 1024), |b| {
+                b.iter(|| {
+                    stream.reset_stream();
+                    while !stream.eof() {
+                        black_box(stream.read_and_next());
+                    }
+                });
             });
-        });
+        }
     }
     group.finish();
 }
 
+/// Resident memory per MB of input for each storage mode. Criterion only measures time,
+/// so this is printed once next to the throughput numbers rather than benchmarked.
+fn memory(_c: &mut Criterion) {
+    let input = make_input(8 * 1024 * 1024);
+    let mb = input.len() as f64 / (1024.0 * 1024.0);
+    for (mode, in_place) in MODES {
+        let stream = make_stream(&input, in_place);
+        let per_mb = stream.resident_bytes() as f64 / mb / (1024.0 * 1024.0);
+        println!("bytestream/memory/{mode}: {per_mb:.2} MB resident per MB of input");
+    }
+}
+
 /// Streaming append: feed the input in fixed-size chunks via append_str.
 /// Exposes the O(n^2) full re-decode on every append.
 fn append_chunks(c: &mut Criterion) {
@@ -76,5 +110,5 @@ fn append_chunks(c: &mut Criterion) {
     group.finish();
 }
 
-criterion_group!(benches, decode, iterate, append_chunks);
+criterion_group!(benches, decode, iterate, append_chunks, memory);
 criterion_main!(benches);
@@ -0,0 +1,119 @@
+// Benchmark code: panicking on bad input is the desired behavior, as in any test code.
+#![allow(clippy::unwrap_used, clippy::expect_used, clippy::panic)]
+use std::hint::black_box;
+
+use criterion::{criterion_group, criterion_main, Criterion, Throughput};
+use gosub_interface::render::backend::{CachedTile, TileAnchor};
+use gosub_render_pipeline::render::{argb_u32_to_rgba8_into, composite_tiles, PixelFormat, TileTarget};
+
+/// Viewport in CSS px; tiles are 256 CSS px squares, as the tiler produces them.
+const VIEWPORT: (usize, usize) = (1920, 1080);
+const TILE_CSS: usize = 256;
+
+/// Tile contents under test: fully opaque (row-copy fast path), translucent premultiplied
+/// pixels, and translucent pixels on a layer faded to 50% opacity.
+const CASES: [(&str, bool, f32); 3] = [
+    ("opaque", true, 1.0),
+    ("translucent", false, 1.0),
+    ("faded", false, 0.5),
+];
+
+const FORMATS: [(&str, PixelFormat); 2] = [("argb", PixelFormat::PreMulArgb32), ("rgba8", PixelFormat::Rgba8)];
+
+/// One tile's worth of premultiplied pixels. Translucent tiles mix transparent, opaque and
+/// partially covered pixels so every kernel branch is exercised.
+fn tile_pixels(side: usize, opaque: bool) -> Vec<u8> {
+    let mut state = 0x1234_5678u32;
+    let mut data = Vec::with_capacity(side * side * 4);
+    for _ in 0..side * side {
+        state = state.wrapping_mul(1_664_525).wrapping_add(1_013_904_223);
+        let a = if opaque {
+            255
+        } else {
+            match state >> 30 {
+                0 => 0,
+                1 => 255,
+                _ => (state >> 8) & 0xFF,
+            }
+        };
+        let channel = |shift: u32| (((state >> shift) & 0xFF) * a / 255) as u8;
+        // Byte order is irrelevant for throughput; both formats carry alpha in the top byte.
+        data.extend_from_slice(&[channel(0), channel(8), channel(16), a as u8]);
+    }
+    data
+}
+
+/// The tiles covering the viewport at `dpr`, all sharing one pixel buffer.
+fn viewport_tiles(dpr: usize, opaque: bool, opacity: f32, format: PixelFormat) -> Vec<CachedTile> {
+    let side = TILE_CSS * dpr;
+    let data = bytes::Bytes::from(tile_pixels(side, opaque));
+    let mut tiles = Vec::new();
+    for ty in 0..VIEWPORT.1.div_ceil(TILE_CSS) {
+        for tx in 0..VIEWPORT.0.div_ceil(TILE_CSS) {
+            tiles.push(CachedTile {
+                page_x: (tx * TILE_CSS) as f32,
+                page_y: (ty * TILE_CSS) as f32,
+                width: side as u32,
+                height: side as u32,
+                data: data.clone(),
+                format,
+                opacity,
+                anchor: TileAnchor::Scroll,
+                layer_id: 0,
+                opaque,
+            });
+        }
+    }
+    tiles
+}
+
+/// Source-over compositing a full viewport of tiles into the window buffer.
+fn composite(c: &mut Criterion) {
+    let mut group = c.benchmark_group("tile_composite/composite");
+    for dpr in [1usize, 2] {
+        let (w, h) = (VIEWPORT.0 * dpr, VIEWPORT.1 * dpr);
+        let mut buf = vec![0xFFFF_FFFFu32; w * h];
+        group.throughput(Throughput::Bytes((w * h * 4) as u64));
+        for (case, opaque, opacity) in CASES {
+            for (fmt, format) in FORMATS {
+                let tiles = viewport_tiles(dpr, opaque, opacity, format);
+                group.bench_function(format!("{case}/{fmt}/{dpr}x"), |b| {
+                    b.iter(|| {
+                        let mut target = TileTarget {
+                            buf: &mut buf,
+                            stride: w,
+                            origin_x: 0,
+                            origin_y: 0,
+                            width: w,
+                            height: h,
+                        };
+                        composite_tiles(black_box(&tiles), dpr as u32, (0.0, 0.0), &mut target);
+                    });
+                    black_box(&buf);
+                });
+            }
+        }
+    }
+    group.finish();
+}
+
+/// Converting the composited window buffer to RGBA8 bytes for presentation.
+fn convert(c: &mut Criterion) {
+    let mut group = c.benchmark_group("tile_composite/to_rgba8");
+    for dpr in [1usize, 2] {
+        let (w, h) = (VIEWPORT.0 * dpr, VIEWPORT.1 * dpr);
+        let buf: Vec<u32> = (0..(w * h) as u32).map(|i| i.wrapping_mul(2_654_435_761)).collect();
+        let mut out = Vec::new();
+        group.throughput(Throughput::Bytes((w * h * 4) as u64));
+        group.bench_function(format!("{dpr}x"), |b| {
+            b.iter(|| {
+                argb_u32_to_rgba8_into(black_box(&buf), &mut out);
+                black_box(&out);
+            });
+        });
+    }
+    group.finish();
+}
+
+criterion_group!(benches, composite, convert);
+criterion_main!(benches);
@@ -0,0 +1,713 @@
+//! End-to-end pipeline benchmark with a per-stage breakdown.
+//!
+//! Runs a corpus of saved pages (HTML, stylesheets and images on disk, no network) through the
+//! same stages `gosub-screenshot` renders with and reports, per stage, wall time, heap allocations
+//! and the resident-set peak as JSON. Save the output of two commits and diff them, or pass the
+//! older one as `--baseline` to get the median deltas printed.
+//!
+//! Run:     cargo bench -p gosub-screenshot --bench pipeline_stages
+//! Options: -- --iterations 20 --width 1280 --height 800 --page some/page.html --out run.json
+//!          -- --baseline previous.json
+//!
+//! `rasterize` uses the backend the screenshot tool is built with (Skia by default, Cairo with
+//! `--features backend_cairo`); `rasterize_null` hands the same tiles to the `NullRasterizer`, so
+//! the difference between the two is the cost of actually drawing.
+//!
+//! Allocations are counted by a global allocator and include every thread the stage fans out to.
+//! Peak RSS is only available on Linux, where it is reset before each stage through
+//! `/proc/self/clear_refs`; where that reset is not permitted the value is the process peak so far.
+// Benchmark code: panicking on bad input is the desired behavior, as in any test code. The counting
+// allocator needs `unsafe impl GlobalAlloc`.
+#![allow(clippy::unwrap_used, clippy::expect_used, clippy::panic, unsafe_code)]
+
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Arc;
+use std::time::{Duration, Instant};
+
+use gosub_engine::html::{parse_main_document_stream, EngineDocument, HtmlParseConfig};
+use gosub_engine::DefaultRenderConfig;
+use gosub_render_pipeline::common::browser_state::{BrowserState, WireframeState};
+use gosub_render_pipeline::common::document::pipeline_doc::GosubDocumentAdapter;
+use gosub_render_pipeline::common::geo::{Dimension, Rect};
+use gosub_render_pipeline::common::media::{FetchedMedia, MediaFetchDone, MediaFetcher, MediaStore};
+use gosub_render_pipeline::layering::layer::{LayerId, LayerList};
+use gosub_render_pipeline::layouter::taffy::TaffyLayouter;
+use gosub_render_pipeline::layouter::CanLayout;
+use gosub_render_pipeline::painter::display_list::DisplayList;
+use gosub_render_pipeline::painter::Painter;
+use gosub_render_pipeline::rasterizer::{
+    cpu_cached_tiles, downcast_rasterizer, rasterize_parallel, NullRasterizer, Rasterable, TilePixelCache,
+};
+use gosub_render_pipeline::render::{composite_tiles, RenderBackend as _, TileTarget};
+use gosub_render_pipeline::rendertree_builder::RenderTree;
+use gosub_render_pipeline::tiler::{TileList, TileState};
+use serde_json::{json, Value};
+use tokio::runtime::{Builder, Runtime};
+use tokio_util::sync::CancellationToken;
+use url::Url;
+
+#[cfg(all(feature = "backend_skia", not(feature = "backend_cairo")))]
+use gosub_renderer_skia::{SkiaBackend as Backend, SkiaFontSystem as Fonts};
+
+#[cfg(feature = "backend_cairo")]
+use gosub_renderer_cairo::{CairoBackend as Backend, PangoFontSystem as Fonts};
+
+/// Same configuration as the `gosub-screenshot` binary.
+type AppConfig = DefaultRenderConfig<Backend, Fonts>;
+
+const BACKEND: &str = if cfg!(feature = "backend_cairo") {
+    "cairo"
+} else {
+    "skia"
+};
+
+/// Tile size the engine renders with.
+const TILE_SIZE: f64 = 256.0;
+
+/// Untimed passes per page before measuring. Images decode in the background, so the first passes
+/// lay out placeholders; warming up stops as soon as a pass completes no further media.
+const MAX_WARMUP_PASSES: usize = 10;
+
+/// The default corpus, relative to `tests/data`.
+const CORPUS: &[&str] = &[
+    "pipeline/article.html",
+    "images/image-test.html",
+    "sticky-navbar.html",
+    "tree_iterator/wikipedia_main.html",
+    "tree_iterator/stackoverflow.html",
+];
+
+// ── Allocation counting ────────────────────────────────────────────────────
+
+static ALLOC_OPS: AtomicU64 = AtomicU64::new(0);
+static ALLOC_BYTES: AtomicU64 = AtomicU64::new(0);
+static LIVE_BYTES: AtomicU64 = AtomicU64::new(0);
+static PEAK_LIVE_BYTES: AtomicU64 = AtomicU64::new(0);
+
+struct CountingAllocator;
+
+impl CountingAllocator {
+    fn grow(by: usize) {
+        let live = LIVE_BYTES.fetch_add(by as u64, Ordering::Relaxed) + by as u64;
+        PEAK_LIVE_BYTES.fetch_max(live, Ordering::Relaxed);
+    }
+
+    fn shrink(by: usize) {
+        LIVE_BYTES.fetch_sub(by as u64, Ordering::Relaxed);
+    }
+}
+
+unsafe impl GlobalAlloc for CountingAllocator {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        ALLOC_OPS.fetch_add(1, Ordering::Relaxed);
+        ALLOC_BYTES.fetch_add(layout.size() as u64, Ordering::Relaxed);
+        Self::grow(layout.size());
+        System.alloc(layout)
+    }
+
+    unsafe fn alloc_zeroed(&self, layout: Layout) -> *mut u8 {
+        ALLOC_OPS.fetch_add(1, Ordering::Relaxed);
+        ALLOC_BYTES.fetch_add(layout.size() as u64, Ordering::Relaxed);
+        Self::grow(layout.size());
+        System.alloc_zeroed(layout)
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        Self::shrink(layout.size());
+        System.dealloc(ptr, layout)
+    }
+
+    unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+        ALLOC_OPS.fetch_add(1, Ordering::Relaxed);
+        if new_size > layout.size() {
+            ALLOC_BYTES.fetch_add((new_size - layout.size()) as u64, Ordering::Relaxed);
+            Self::grow(new_size - layout.size());
+        } else {
+            Self::shrink(layout.size() - new_size);
+        }
+        System.realloc(ptr, layout, new_size)
+    }
+}
+
+#[global_allocator]
+static GLOBAL: CountingAllocator = CountingAllocator;
+
+// ── Resident set (Linux only) ──────────────────────────────────────────────
+
+/// Resets the kernel's high-water mark of the resident set, so the next `VmHWM` read covers only
+/// what ran since. Returns false where that is not supported or not permitted.
+fn reset_peak_rss() -> bool {
+    std::fs::write("/proc/self/clear_refs", "5").is_ok()
+}
+
+fn peak_rss_kb() -> Option<u64> {
+    let status = std::fs::read_to_string("/proc/self/status").ok()?;
+    let line = status.lines().find_map(|line| line.strip_prefix("VmHWM:"))?;
+    line.trim().trim_end_matches("kB").trim().parse().ok()
+}
+
+// ── Stages and samples ─────────────────────────────────────────────────────
+
+#[derive(Clone, Copy)]
+enum Stage {
+    Parse,
+    Style,
+    RenderTree,
+    Layout,
+    Layering,
+    Tiling,
+    Paint,
+    RasterizeNull,
+    Rasterize,
+    Composite,
+}
+
+impl Stage {
+    const ALL: [Stage; 10] = [
+        Stage::Parse,
+        Stage::Style,
+        Stage::RenderTree,
+        Stage::Layout,
+        Stage::Layering,
+        Stage::Tiling,
+        Stage::Paint,
+        Stage::RasterizeNull,
+        Stage::Rasterize,
+        Stage::Composite,
+    ];
+
+    fn name(self) -> &'static str {
+        match self {
+            Stage::Parse => "parse",
+            Stage::Style => "style",
+            Stage::RenderTree => "render_tree",
+            Stage::Layout => "layout",
+            Stage::Layering => "layering",
+            Stage::Tiling => "tiling",
+            Stage::Paint => "paint",
+            Stage::RasterizeNull => "rasterize_null",
+            Stage::Rasterize => "rasterize",
+            Stage::Composite => "composite",
+        }
+    }
+}
+
+/// What one run of one stage cost.
+struct StageSample {
+    wall: Duration,
+    allocs: u64,
+    alloc_bytes: u64,
+    /// Highest heap growth over the live bytes at the start of the stage.
+    heap_peak_bytes: u64,
+    peak_rss_kb: Option<u64>,
+}
+
+#[derive(Default)]
+struct Samples([Vec<StageSample>; Stage::ALL.len()]);
+
+impl Samples {
+    fn measure<T>(&mut self, stage: Stage, f: impl FnOnce() -> T) -> T {
+        reset_peak_rss();
+        let ops = ALLOC_OPS.load(Ordering::Relaxed);
+        let bytes = ALLOC_BYTES.load(Ordering::Relaxed);
+        let live = LIVE_BYTES.load(Ordering::Relaxed);
+        PEAK_LIVE_BYTES.store(live, Ordering::Relaxed);
+        let start = Instant::now();
+
+        let out = f();
+
+        let wall = start.elapsed();
+        let sample = StageSample {
+            wall,
+            allocs: ALLOC_OPS.load(Ordering::Relaxed) - ops,
+            alloc_bytes: ALLOC_BYTES.load(Ordering::Relaxed) - bytes,
+            heap_peak_bytes: PEAK_LIVE_BYTES.load(Ordering::Relaxed).saturating_sub(live),
+            peak_rss_kb: peak_rss_kb(),
+        };
+        self.0[stage as usize].push(sample);
+        out
+    }
+}
+
+fn median<T: Copy + PartialOrd>(values: &mut [T]) -> T {
+    values.sort_by(|a, b| a.partial_cmp(b).unwrap_or(std::cmp::Ordering::Equal));
+    values[values.len() / 2]
+}
+
+fn stage_report(stage: Stage, samples: &[StageSample]) -> Value {
+    let mut wall: Vec<f64> = samples.iter().map(|s| s.wall.as_secs_f64() * 1000.0).collect();
+    let n = wall.len() as f64;
+    let mean = wall.iter().sum::<f64>() / n;
+    let stddev = (wall.iter().map(|w| (w - mean) * (w - mean)).sum::<f64>() / n).sqrt();
+    let min = wall.iter().copied().fold(f64::INFINITY, f64::min);
+    let max = wall.iter().copied().fold(0.0, f64::max);
+
+    json!({
+        "stage": stage.name(),
+        "wall_ms": {
+            "median": median(&mut wall),
+            "mean": mean,
+            "stddev": stddev,
+            "min": min,
+            "max": max,
+        },
+        "allocs": median(&mut samples.iter().map(|s| s.allocs).collect::<Vec<_>>()),
+        "alloc_bytes": median(&mut samples.iter().map(|s| s.alloc_bytes).collect::<Vec<_>>()),
+        "heap_peak_bytes": median(&mut samples.iter().map(|s| s.heap_peak_bytes).collect::<Vec<_>>()),
+        "peak_rss_kb": samples.iter().filter_map(|s| s.peak_rss_kb).max(),
+    })
+}
+
+// ── Corpus ─────────────────────────────────────────────────────────────────
+
+struct Page {
+    name: String,
+    path: PathBuf,
+    url: Url,
+    html: Vec<u8>,
+}
+
+impl Page {
+    fn load(name: String, path: &Path) -> Option<Page> {
+        let path = std::fs::canonicalize(path).ok()?;
+        let html = std::fs::read(&path).ok()?;
+        let url = Url::from_file_path(&path).ok()?;
+        Some(Page { name, path, url, html })
+    }
+}
+
+fn corpus(extra: &[PathBuf]) -> Vec<Page> {
+    if !extra.is_empty() {
+        return extra
+            .iter()
+            .map(|path| {
+                let name = path
+                    .file_stem()
+                    .map_or_else(String::new, |s| s.to_string_lossy().into_owned());
+                Page::load(name, path).unwrap_or_else(|| panic!("cannot read page {}", path.display()))
+            })
+            .collect();
+    }
+
+    let data = Path::new(env!("CARGO_MANIFEST_DIR")).join("../../tests/data");
+    CORPUS
+        .iter()
+        .filter_map(|rel| {
+            let name = rel.trim_end_matches(".html").to_string();
+            let page = Page::load(name, &data.join(rel));
+            if page.is_none() {
+                eprintln!("skipping {rel}: not found under {}", data.display());
+            }
+            page
+        })
+        .collect()
+}
+
+/// Loads media straight from disk, so a run never touches the network and never waits on it.
+struct FileMediaFetcher;
+
+impl MediaFetcher for FileMediaFetcher {
+    fn fetch(&self, url: Url, done: MediaFetchDone) {
+        let result = url
+            .to_file_path()
+            .map_err(|()| anyhow::anyhow!("not a file URL: {url}"))
+            .and_then(|path| Ok(std::fs::read(path)?))
+            .map(|body| FetchedMedia {
+                content_type: None,
+                body: body.into(),
+            });
+        done(result);
+    }
+}
+
+// ── Pipeline ───────────────────────────────────────────────────────────────
+
+struct Pipeline {
+    runtime: Runtime,
+    viewport: (f32, f32),
+    layouter: TaffyLayouter,
+    rasterizer: Box<dyn Rasterable + Send + Sync>,
+    dpr: u32,
+    media_store: Arc<MediaStore>,
+}
+
+/// Sizes of the last pass, to put the timings in context.
+#[derive(Default)]
+struct PageShape {
+    elements: usize,
+    page_height: f64,
+    tiles: usize,
+    rasterized_tiles: usize,
+}
+
+impl Pipeline {
+    fn new(viewport: (f32, f32)) -> Self {
+        let runtime = Builder::new_multi_thread()
+            .enable_io()
+            .enable_time()
+            .thread_name("pipeline-bench-rt")
+            .build()
+            .expect("tokio runtime");
+
+        let backend = Backend::new();
+        let rasterizer = downcast_rasterizer(backend.create_rasterizer(Arc::new(Fonts::default())))
+            .expect("backend has no CPU rasterizer");
+
+        let media_store = Arc::new(MediaStore::new());
+        media_store.set_fetcher(Arc::new(FileMediaFetcher));
+        // As in the engine: measure with the rasterizer's fonts when it shapes through a font system.
+        let mut layouter = match rasterizer.font_system() {
+            Some(font_system) => TaffyLayouter::with_font_system(font_system),
+            None => TaffyLayouter::new(),
+        };
+        layouter.set_media_store(Arc::clone(&media_store));
+
+        Self {
+            runtime,
+            viewport,
+            layouter,
+            rasterizer,
+            dpr: backend.device_pixel_ratio().max(1),
+            media_store,
+        }
+    }
+
+    /// Renders `page` once, recording every stage into `samples`.
+    fn run(&mut self, page: &Page, samples: &mut Samples) -> PageShape {
+        let (width, height) = self.viewport;
+        let mut shape = PageShape::default();
+
+        let reader = std::io::Cursor::new(page.html.clone());
+        let doc: EngineDocument<AppConfig> = samples.measure(Stage::Parse, || {
+            self.runtime
+                .block_on(parse_main_document_stream::<AppConfig, _, _>(
+                    page.url.clone(),
+                    reader,
+                    CancellationToken::new(),
+                    HtmlParseConfig::default(),
+                    |_| {},
+                ))
+                .expect("failed to parse page")
+        });
+
+        gosub_css3::stylesheet::set_layout_viewport(width, height);
+        let adapter = GosubDocumentAdapter::<AppConfig>::new(Arc::new(doc));
+        samples.measure(Stage::Style, || {
+            adapter.resolve_styles_parallel(&move || gosub_css3::stylesheet::set_layout_viewport(width, height));
+        });
+
+        let render_tree = samples.measure(Stage::RenderTree, || {
+            let mut render_tree = RenderTree::new(Arc::new(adapter));
+            render_tree.parse().expect("failed to build render tree");
+            render_tree
+        });
+        shape.elements = render_tree.count_elements();
+
+        self.layouter.reset_tree();
+        let viewport = Dimension::new(f64::from(width), f64::from(height));
+        let layout_tree = samples.measure(Stage::Layout, || self.layouter.layout(render_tree, Some(viewport), 1.0));
+        shape.page_height = layout_tree.root_dimension.height;
+
+        let layer_list = samples.measure(Stage::Layering, || LayerList::new(layout_tree));
+
+        let mut tile_list = samples.measure(Stage::Tiling, || {
+            let mut tile_list = TileList::new(layer_list, Dimension::new(TILE_SIZE, TILE_SIZE));
+            tile_list.generate();
+            tile_list
+        });
+        shape.tiles = tile_list.arena.len();
+
+        let full_page_rect = Rect::new(0.0, 0.0, f64::from(width), shape.page_height.max(f64::from(height)));
+        let layer_ids = tile_list.layer_list.layer_ids.read().clone();
+        samples.measure(Stage::Paint, || {
+            paint(&mut tile_list, &layer_ids, full_page_rect, &self.layouter)
+        });
+
+        // Fresh caches per pass: reusing pixels from the previous iteration would time a repaint
+        // of an unchanged page, not a first render.
+        let null_cache = TilePixelCache::new(u64::MAX, None);
+        samples.measure(Stage::RasterizeNull, || {
+            rasterize_parallel(
+                &NullRasterizer,
+                &layer_ids,
+                &mut tile_list,
+                full_page_rect,
+                &self.media_store,
+                &null_cache,
+                "bench.rasterize_null",
+            )
+        });
+
+        tile_list.invalidate_all();
+        let tile_cache = TilePixelCache::new(u64::MAX, None);
+        let baked = samples.measure(Stage::Rasterize, || {
+            rasterize_parallel(
+                self.rasterizer.as_ref(),
+                &layer_ids,
+                &mut tile_list,
+                full_page_rect,
+                &self.media_store,
+                &tile_cache,
+                "bench.rasterize",
+            )
+        });
+        shape.rasterized_tiles = baked.len();
+
+        let dpr = self.dpr;
+        let (target_w, target_h) = (width as usize * dpr as usize, height as usize * dpr as usize);
+        let mut frame = vec![0u32; target_w * target_h];
+        samples.measure(Stage::Composite, || {
+            let tiles = cpu_cached_tiles(&baked);
+            composite_tiles(
+                &tiles,
+                dpr,
+                (0.0, 0.0),
+                &mut TileTarget {
+                    buf: &mut frame,
+                    stride: target_w,
+                    origin_x: 0,
+                    origin_y: 0,
+                    width: target_w,
+                    height: target_h,
+                },
+            );
+        });
+
+        shape
+    }
+
+    /// Runs untimed passes until the page's images have loaded and settled at their display size.
+    fn warm_up(&mut self, page: &Page) {
+        for _ in 0..MAX_WARMUP_PASSES {
+            self.run(page, &mut Samples::default());
+            std::thread::sleep(Duration::from_millis(50));
+            self.media_store.apply_display_sizes();
+            if !self.media_store.take_completed() {
+                break;
+            }
+        }
+    }
+}
+
+/// Builds the display list for the whole page and hands each dirty tile its paint commands.
+fn paint(tile_list: &mut TileList, layer_ids: &[LayerId], full_page_rect: Rect, layouter: &TaffyLayouter) {
+    let state = BrowserState {
+        visible_layer_list: vec![true; layer_ids.len()],
+        wireframed: WireframeState::None,
+        debug_hover: false,
+        current_hovered_element: None,
+        show_tilegrid: false,
+        debug_table_cells: false,
+        viewport: full_page_rect,
+        tile_list: None,
+        dpi_scale_factor: 1.0,
+    };
+    let painter = Painter::new(tile_list.layer_list.clone(), Some(layouter.font_system()));
+    let display_list = DisplayList::build(&painter, &state, None, &Default::default());
+
+    for &layer_id in layer_ids {
+        for tile_id in tile_list.get_intersecting_tiles(layer_id, full_page_rect) {
+            if let Some(tile) = tile_list.get_tile_mut(tile_id) {
+                if tile.state == TileState::Dirty {
+                    for tiled_element in &mut tile.elements {
+                        tiled_element.paint_commands = display_list.slice(tiled_element.id);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// ── Command line ───────────────────────────────────────────────────────────
+
+struct Options {
+    iterations: usize,
+    width: f32,
+    height: f32,
+    pages: Vec<PathBuf>,
+    out: Option<PathBuf>,
+    baseline: Option<PathBuf>,
+}
+
+fn value<T: std::str::FromStr>(args: &mut impl Iterator<Item = String>, flag: &str) -> T {
+    args.next()
+        .and_then(|v| v.parse().ok())
+        .unwrap_or_else(|| panic!("{flag} needs a valid value"))
+}
+
+fn parse_args() -> Options {
+    let mut options = Options {
+        iterations: 10,
+        width: 1280.0,
+        height: 800.0,
+        pages: Vec::new(),
+        out: None,
+        baseline: None,
+    };
+
+    let mut args = std::env::args().skip(1);
+    while let Some(arg) = args.next() {
+        match arg.as_str() {
+            "--iterations" | "-n" => options.iterations = value::<usize>(&mut args, &arg).max(1),
+            "--width" => options.width = value(&mut args, &arg),
+            "--height" => options.height = value(&mut args, &arg),
+            "--page" => options.pages.push(value(&mut args, &arg)),
+            "--out" => options.out = Some(value(&mut args, &arg)),
+            "--baseline" => options.baseline = Some(value(&mut args, &arg)),
+            // `cargo bench` passes `--bench`, and a filter when one is given; neither applies here.
+            _ => {}
+        }
+    }
+    options
+}
+
+// ── Output ─────────────────────────────────────────────────────────────────
+
+fn print_summary(report: &Value) {
+    for page in report["pages"].as_array().into_iter().flatten() {
+        eprintln!(
+            "\n{} ({} elements, {} tiles, {:.0}px tall)",
+            page["name"].as_str().unwrap_or_default(),
+            page["elements"],
+            page["tiles"],
+            page["page_height"].as_f64().unwrap_or_default()
+        );
+        eprintln!(
+            "  {:<16} {:>10} {:>9} {:>10} {:>12} {:>12} {:>12}",
+            "stage", "median ms", "± ms", "min ms", "allocs", "alloc KiB", "peak RSS KiB"
+        );
+        for stage in page["stages"].as_array().into_iter().flatten() {
+            let wall = &stage["wall_ms"];
+            eprintln!(
+                "  {:<16} {:>10.3} {:>9.3} {:>10.3} {:>12} {:>12} {:>12}",
+                stage["stage"].as_str().unwrap_or_default(),
+                wall["median"].as_f64().unwrap_or_default(),
+                wall["stddev"].as_f64().unwrap_or_default(),
+                wall["min"].as_f64().unwrap_or_default(),
+                stage["allocs"].as_u64().unwrap_or_default(),
+                stage["alloc_bytes"].as_u64().unwrap_or_default() / 1024,
+                stage["peak_rss_kb"]
+                    .as_u64()
+                    .map_or_else(|| "-".to_string(), |kb| kb.to_string()),
+            );
+        }
+    }
+}
+
+/// Prints the change in median wall time and allocation count for every stage both runs have.
+fn print_baseline_deltas(baseline: &Value, report: &Value) {
+    eprintln!(
+        "\nagainst baseline {}:",
+        baseline["commit"].as_str().unwrap_or("(unknown commit)")
+    );
+    for page in report["pages"].as_array().into_iter().flatten() {
+        let Some(old_page) = baseline["pages"]
+            .as_array()
+            .into_iter()
+            .flatten()
+            .find(|p| p["name"] == page["name"])
+        else {
+            continue;
+        };
+        eprintln!("  {}", page["name"].as_str().unwrap_or_default());
+        for stage in page["stages"].as_array().into_iter().flatten() {
+            let Some(old) = old_page["stages"]
+                .as_array()
+                .into_iter()
+                .flatten()
+                .find(|s| s["stage"] == stage["stage"])
+            else {
+                continue;
+            };
+            let (old_ms, new_ms) = (
+                old["wall_ms"]["median"].as_f64().unwrap_or_default(),
+                stage["wall_ms"]["median"].as_f64().unwrap_or_default(),
+            );
+            let pct = if old_ms > 0.0 {
+                (new_ms - old_ms) / old_ms * 100.0
+            } else {
+                0.0
+            };
+            let allocs = stage["allocs"].as_i64().unwrap_or_default() - old["allocs"].as_i64().unwrap_or_default();
+            eprintln!(
+                "    {:<16} {:>10.3} -> {:>10.3} ms ({:+6.1}%)  allocs {:+}",
+                stage["stage"].as_str().unwrap_or_default(),
+                old_ms,
+                new_ms,
+                pct,
+                allocs
+            );
+        }
+    }
+}
+
+fn main() {
+    simple_logger::SimpleLogger::new()
+        .with_level(log::LevelFilter::Error)
+        .env()
+        .init()
+        .unwrap_or_default();
+
+    let options = parse_args();
+    let pages = corpus(&options.pages);
+    assert!(!pages.is_empty(), "no pages to run");
+
+    let mut pipeline = Pipeline::new((options.width, options.height));
+    let rss_resets = reset_peak_rss();
+
+    let mut page_reports = Vec::new();
+    for page in &pages {
+        eprintln!("running {} ({} iterations)", page.name, options.iterations);
+        pipeline.warm_up(page);
+
+        let mut samples = Samples::default();
+        let mut shape = PageShape::default();
+        for _ in 0..options.iterations {
+            shape = pipeline.run(page, &mut samples);
+        }
+
+        let stages: Vec<Value> = Stage::ALL
+            .iter()
+            .map(|&stage| stage_report(stage, &samples.0[stage as usize]))
+            .collect();
+        page_reports.push(json!({
+            "name": page.name,
+            "path": page.path.display().to_string(),
+            "elements": shape.elements,
+            "page_height": shape.page_height,
+            "tiles": shape.tiles,
+            "rasterized_tiles": shape.rasterized_tiles,
+            "stages": stages,
+        }));
+    }
+
+    let report = json!({
+        "commit": env!("BUILD_GIT_SHA"),
+        "date": env!("BUILD_DATE"),
+        "backend": BACKEND,
+        "iterations": options.iterations,
+        "viewport": { "width": options.width, "height": options.height },
+        "tile_size": TILE_SIZE,
+        "threads": std::thread::available_parallelism().map_or(1, |n| n.get()),
+        "peak_rss_per_stage": rss_resets,
+        "pages": page_reports,
+    });
+
+    print_summary(&report);
+    if let Some(path) = &options.baseline {
+        let baseline = std::fs::read_to_string(path).expect("cannot read baseline");
+        let baseline: Value = serde_json::from_str(&baseline).expect("baseline is not valid JSON");
+        print_baseline_deltas(&baseline, &report);
+    }
+
+    let json = serde_json::to_string_pretty(&report).expect("report serializes");
+    match &options.out {
+        Some(path) => {
+            std::fs::write(path, json).expect("cannot write report");
+            eprintln!("\nwrote {}", path.display());
+        }
+        None => println!("{json}"),
+    }
+}
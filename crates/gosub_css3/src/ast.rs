@@ -1,12 +1,15 @@
 use cow_utils::CowUtils;
 use log::warn;
 
+use crate::matcher::rule_index::RuleIndex;
 use crate::node::{Node as CssNode, NodeType};
 use crate::stylesheet::{
     AttributeSelector, Combinator, CssDeclaration, CssRule, CssSelector, CssSelectorPart, CssStylesheet, CssValue,
     FontFace, MatcherType,
 };
-use gosub_interface::css3::CssOrigin;
+use crate::system::rule_hover_fingerprints;
+use gosub_interface::css3::{CssOrigin, HoverFingerprints};
+use gosub_shared::atom::Atom;
 use gosub_shared::errors::{CssError, CssResult};
 
 /*
@@ -83,7 +86,7 @@ fn collect_rule(node: &CssNode) -> CssResult<Option<CssRule>> {
 
             for node in selector_children {
                 let part = match &*node.node_type {
-                    NodeType::Ident { value } => CssSelectorPart::Type(value.clone()),
+                    NodeType::Ident { value } => CssSelectorPart::Type(Atom::new(value)),
                     NodeType::ClassSelector { value } => CssSelectorPart::Class(value.clone()),
                     NodeType::Combinator { value } => {
                         let combinator = match value.as_str() {
@@ -102,7 +105,7 @@ fn collect_rule(node: &CssNode) -> CssResult<Option<CssRule>> {
                     NodeType::TypeSelector { value, .. } if value == "*" => CssSelectorPart::Universal,
                     NodeType::PseudoClassSelector { value, .. } => CssSelectorPart::PseudoClass(value.to_string()),
                     NodeType::PseudoElementSelector { value, .. } => CssSelectorPart::PseudoElement(value.to_string()),
-                    NodeType::TypeSelector { value, .. } => CssSelectorPart::Type(value.clone()),
+                    NodeType::TypeSelector { value, .. } => CssSelectorPart::Type(Atom::new(value)),
                     NodeType::AttributeSelector {
                         name,
                         value,
@@ -191,7 +194,7 @@ fn collect_rule(node: &CssNode) -> CssResult<Option<CssRule>> {
             };
 
             rule.declarations.push(CssDeclaration {
-                property: property.clone(),
+                property: Atom::new(property),
                 value,
                 important: *important,
             });
@@ -335,9 +338,13 @@ pub fn convert_ast_to_stylesheet(css_ast: &CssNode, origin: CssOrigin, url: &str
         origin,
         url: url.to_string(),
         parse_log: vec![],
+        index: RuleIndex::default(),
+        hover: HoverFingerprints::default(),
     };
 
     collect_rules(children, &mut sheet.rules, &mut sheet.font_faces)?;
+    sheet.index = RuleIndex::build(&sheet.rules);
+    sheet.hover = rule_hover_fingerprints(&sheet.rules);
     Ok(sheet)
 }
 
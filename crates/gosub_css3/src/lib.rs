@@ -13,6 +13,7 @@ use gosub_shared::config::Context;
 use gosub_shared::config::ParserConfig;
 use gosub_shared::errors::{CssError, CssResult};
 use gosub_shared::{timing_start, timing_stop};
+use std::sync::{Arc, LazyLock};
 
 pub mod ast;
 pub mod colors;
@@ -132,9 +133,8 @@ impl<'stream> Css3<'stream> {
     }
 }
 
-/// Loads the default user agent stylesheet
-#[must_use]
-pub fn load_default_useragent_stylesheet() -> CssStylesheet {
+/// The user agent stylesheet, parsed on first use and shared by every document after that.
+static USERAGENT_STYLESHEET: LazyLock<Arc<CssStylesheet>> = LazyLock::new(|| {
     // @todo: we should be able to browse to gosub:useragent.css and see the actual useragent css file
     let url = "gosub:useragent.css";
 
@@ -146,7 +146,16 @@ pub fn load_default_useragent_stylesheet() -> CssStylesheet {
 
     let css_data = include_str!("../resources/useragent.css");
     #[allow(clippy::expect_used)] // PANIC-SAFE: compiled-in stylesheet, exercised by every parser test
-    Css3::parse_str(css_data, config, CssOrigin::UserAgent, url).expect("Could not parse useragent stylesheet")
+    let sheet =
+        Css3::parse_str(css_data, config, CssOrigin::UserAgent, url).expect("Could not parse useragent stylesheet");
+    Arc::new(sheet)
+});
+
+/// Loads the default user agent stylesheet. It is parsed once per process; every call after the
+/// first returns the same sheet.
+#[must_use]
+pub fn load_default_useragent_stylesheet() -> Arc<CssStylesheet> {
+    Arc::clone(&USERAGENT_STYLESHEET)
 }
 
 #[cfg(test)]
@@ -173,4 +182,48 @@ mod tests {
             println!("{:?}", res.err().unwrap());
         }
     }
+
+    #[test]
+    fn useragent_stylesheet_is_parsed_once() {
+        let first = load_default_useragent_stylesheet();
+        let second = load_default_useragent_stylesheet();
+        assert!(Arc::ptr_eq(&first, &second));
+        assert!(!first.rules.is_empty());
+    }
+
+    #[test]
+    fn hover_fingerprints_are_collected_per_sheet() {
+        use crate::system::Css3System;
+        use gosub_interface::css3::CssSystem;
+
+        let parse =
+            |css: &str| Css3System::parse_str(css, ParserConfig::default(), CssOrigin::Author, "test.css").unwrap();
+        let menu = parse("nav a:hover { color: red } .menu > li:hover { color: blue }");
+        let plain = parse("p { color: green }");
+        assert!(menu.hover.types.contains("a"));
+        assert!(menu.hover.classes.is_empty(), ".menu is not in the :hover compound");
+        assert_eq!(plain.hover, Default::default());
+
+        let fp = Css3System::hover_fingerprints(&[menu.clone(), plain.clone()]);
+        assert_eq!(fp.types.len(), 2);
+        assert!(!fp.has_universal);
+
+        let any = parse(":hover { outline: 1px solid }");
+        assert!(Css3System::hover_fingerprints(&[menu, any, plain]).has_universal);
+    }
+
+    #[test]
+    fn viewport_units_are_detected_in_nested_values() {
+        use crate::system::Css3System;
+        use gosub_interface::css3::CssSystem;
+
+        let parse =
+            |css: &str| Css3System::parse_str(css, ParserConfig::default(), CssOrigin::Author, "test.css").unwrap();
+        let fixed = parse("p { width: 50%; margin: 1em 2px; border-radius: calc(4px + 1rem) }");
+        let fluid = parse("h1 { font-size: clamp(1rem, 2.5vw, 3rem) }");
+        assert!(!Css3System::uses_viewport_units(&[fixed.clone()]));
+        assert!(Css3System::uses_viewport_units(&[fixed.clone(), fluid]));
+        let calc = parse("div { width: calc(100vw - 2em) }");
+        assert!(Css3System::uses_viewport_units(&[fixed, calc]));
+    }
 }
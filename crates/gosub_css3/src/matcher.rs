@@ -1,4 +1,5 @@
 pub mod property_definitions;
+pub mod rule_index;
 pub mod shorthands;
 pub mod styling;
 pub mod syntax;
@@ -0,0 +1,598 @@
+//! Per-stylesheet selector index.
+//!
+//! Matching every selector of every rule against every element is quadratic in practice: a page
+//! with 10k rules and 5k elements runs 50M selector matches. The [`RuleIndex`] buckets each
+//! selector by the most specific key of its rightmost compound (id, class, tag or universal), so
+//! an element only tests the selectors whose subject could possibly be that element. Each entry
+//! also records hashes of the id/class/tag keys its ancestor compounds require, which are checked
+//! against an [`AncestorFilter`] (a Bloom filter of the element's ancestors) before the selector
+//! itself is matched.
+//!
+//! The index is built once when the stylesheet is created and lives alongside its rules.
+
+use std::collections::HashMap;
+use std::fmt::{Debug, Formatter};
+
+use gosub_interface::config::HasDocument;
+use gosub_interface::document::Document;
+use gosub_interface::node::NodeType;
+use gosub_shared::atom::Atom;
+use gosub_shared::node::NodeId;
+
+use crate::stylesheet::{Combinator, CssRule, CssSelectorPart, CssStylesheet, CssValue};
+
+/// Maximum number of ancestor hashes stored per entry. Checking a few of them rejects nearly all
+/// non-matching descendant selectors; storing them all would only grow the index.
+const MAX_ANCESTOR_HASHES: usize = 4;
+
+/// Number of counters in an [`AncestorFilter`]
+const FILTER_SLOTS: usize = 2048;
+const FILTER_MASK: u64 = (FILTER_SLOTS - 1) as u64;
+
+#[derive(Clone, Copy)]
+enum KeyKind {
+    Id = 1,
+    Class = 2,
+    Type = 3,
+}
+
+/// FNV-1a over the key kind and name. Only used for the Bloom filter, so it needs to be fast and
+/// stable, not collision resistant.
+fn key_hash(kind: KeyKind, name: &str) -> u64 {
+    const PRIME: u64 = 0x0000_0100_0000_01b3;
+    let mut hash: u64 = 0xcbf2_9ce4_8422_2325;
+    hash = (hash ^ kind as u64).wrapping_mul(PRIME);
+    for &b in name.as_bytes() {
+        hash = (hash ^ u64::from(b)).wrapping_mul(PRIME);
+    }
+    hash
+}
+
+/// Bloom filter over the id, classes and tag names of an element's ancestors. A selector whose
+/// ancestor compounds need a key that is not in the filter cannot match the element.
+///
+/// A tree walk keeps one filter for the whole traversal: [`Self::push_element`] when it enters an
+/// element (before its children) and [`Self::pop_element`] when it leaves it, so each element's
+/// keys are hashed once instead of once per descendant. The filter counts rather than sets bits
+/// so that leaving an element can take its keys out again; a counter that saturates stays set,
+/// which can only cost a false positive.
+#[derive(Clone, PartialEq)]
+pub struct AncestorFilter {
+    counts: Box<[u8; FILTER_SLOTS]>,
+    /// Every hash inserted, in order, so a pop knows what to take out
+    hashes: Vec<u64>,
+    /// Per entered element: the length of `hashes` before its keys were inserted
+    frames: Vec<usize>,
+}
+
+impl Default for AncestorFilter {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl AncestorFilter {
+    #[must_use]
+    pub fn new() -> Self {
+        Self {
+            counts: Box::new([0; FILTER_SLOTS]),
+            hashes: Vec::new(),
+            frames: Vec::new(),
+        }
+    }
+
+    /// Builds the filter for all ancestors of `id`, for matching a node outside a traversal
+    pub fn for_node<C: HasDocument>(doc: &C::Document, id: NodeId) -> Self {
+        let mut chain = Vec::new();
+        let mut current = doc.parent(id);
+        while let Some(ancestor) = current {
+            chain.push(ancestor);
+            current = doc.parent(ancestor);
+        }
+
+        let mut filter = Self::new();
+        for &ancestor in chain.iter().rev() {
+            filter.push_element::<C>(doc, ancestor);
+        }
+        filter
+    }
+
+    /// Enters `id`: adds its keys, so the filter now covers the ancestors of `id`'s children.
+    /// Non-element nodes add nothing but must still be popped.
+    pub fn push_element<C: HasDocument>(&mut self, doc: &C::Document, id: NodeId) {
+        self.frames.push(self.hashes.len());
+        if doc.node_type(id) != NodeType::ElementNode {
+            return;
+        }
+        if let Some(tag) = doc.tag_name(id) {
+            self.insert(key_hash(KeyKind::Type, tag));
+        }
+        if let Some(element_id) = doc.attribute(id, "id") {
+            self.insert(key_hash(KeyKind::Id, element_id));
+        }
+        doc.for_each_class(id, &mut |class| self.insert(key_hash(KeyKind::Class, class)));
+    }
+
+    /// Leaves the element entered last, taking its keys out again
+    pub fn pop_element(&mut self) {
+        let Some(start) = self.frames.pop() else {
+            return;
+        };
+        let popped = self.hashes.split_off(start);
+        for hash in popped {
+            for slot in Self::slots_of(hash) {
+                let count = &mut self.counts[slot];
+                if *count != u8::MAX {
+                    *count -= 1;
+                }
+            }
+        }
+    }
+
+    /// Number of entered elements not popped yet
+    #[must_use]
+    pub fn depth(&self) -> usize {
+        self.frames.len()
+    }
+
+    fn slots_of(hash: u64) -> [usize; 2] {
+        [(hash & FILTER_MASK) as usize, ((hash >> 32) & FILTER_MASK) as usize]
+    }
+
+    fn insert(&mut self, hash: u64) {
+        for slot in Self::slots_of(hash) {
+            let count = &mut self.counts[slot];
+            *count = count.saturating_add(1);
+        }
+        self.hashes.push(hash);
+    }
+
+    /// False when `hash` was definitely never inserted
+    fn might_contain(&self, hash: u64) -> bool {
+        Self::slots_of(hash).iter().all(|&slot| self.counts[slot] != 0)
+    }
+}
+
+/// One indexed selector alternative (a single part list of a selector)
+#[derive(Clone, PartialEq)]
+struct Entry {
+    rule: usize,
+    selector: usize,
+    /// Keys some ancestor of the subject must carry for this alternative to match
+    ancestors: Vec<u64>,
+}
+
+/// Selector index of a stylesheet. See the module documentation.
+#[derive(Clone, Default, PartialEq)]
+pub struct RuleIndex {
+    entries: Vec<Entry>,
+    by_id: HashMap<String, Vec<usize>>,
+    by_class: HashMap<String, Vec<usize>>,
+    by_type: HashMap<Atom, Vec<usize>>,
+    universal: Vec<usize>,
+    /// Number of rules the index was built from, to detect a stale index
+    rule_count: usize,
+    /// Whether any rule declares a custom property (`--*`)
+    custom_properties: bool,
+    /// Per rule: whether a declaration reads per-node input (`attr()`, `var()`)
+    node_dependent: Vec<bool>,
+}
+
+impl Debug for RuleIndex {
+    fn fmt(&self, f: &mut Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("RuleIndex")
+            .field("entries", &self.entries.len())
+            .field("ids", &self.by_id.len())
+            .field("classes", &self.by_class.len())
+            .field("types", &self.by_type.len())
+            .field("universal", &self.universal.len())
+            .finish()
+    }
+}
+
+impl RuleIndex {
+    #[must_use]
+    pub fn build(rules: &[CssRule]) -> Self {
+        let mut index = Self {
+            rule_count: rules.len(),
+            ..Self::default()
+        };
+
+        for (rule_idx, rule) in rules.iter().enumerate() {
+            if rule.declarations.iter().any(|d| d.property.starts_with("--")) {
+                index.custom_properties = true;
+            }
+            index
+                .node_dependent
+                .push(rule.declarations.iter().any(|d| reads_node(&d.value)));
+            for (selector_idx, selector) in rule.selectors.iter().enumerate() {
+                for parts in &selector.parts {
+                    index.add(rule_idx, selector_idx, parts);
+                }
+            }
+        }
+
+        index
+    }
+
+    fn add(&mut self, rule: usize, selector: usize, parts: &[CssSelectorPart]) {
+        let entry_idx = self.entries.len();
+
+        // The rightmost compound is everything after the last combinator; it is matched against
+        // the subject element itself.
+        let subject_start = parts
+            .iter()
+            .rposition(|p| matches!(p, CssSelectorPart::Combinator(_)))
+            .map_or(0, |pos| pos + 1);
+        let subject = parts.get(subject_start..).unwrap_or_default();
+
+        let id = subject.iter().find_map(|p| match p {
+            CssSelectorPart::Id(id) => Some(id),
+            _ => None,
+        });
+        let class = subject.iter().find_map(|p| match p {
+            CssSelectorPart::Class(class) => Some(class),
+            _ => None,
+        });
+        let tag = subject.iter().find_map(|p| match p {
+            CssSelectorPart::Type(tag) => Some(tag.clone()),
+            _ => None,
+        });
+
+        if let Some(id) = id {
+            self.by_id.entry(id.clone()).or_default().push(entry_idx);
+        } else if let Some(class) = class {
+            self.by_class.entry(class.clone()).or_default().push(entry_idx);
+        } else if let Some(tag) = tag {
+            self.by_type.entry(tag).or_default().push(entry_idx);
+        } else {
+            self.universal.push(entry_idx);
+        }
+
+        self.entries.push(Entry {
+            rule,
+            selector,
+            ancestors: ancestor_hashes(parts.get(..subject_start).unwrap_or_default()),
+        });
+    }
+
+    /// True when the index was built from `rules` (as far as can be told without comparing
+    /// them). Code that edits a stylesheet's rules after parsing must rebuild the index.
+    #[must_use]
+    pub fn covers(&self, rules: &[CssRule]) -> bool {
+        self.rule_count == rules.len()
+    }
+
+    /// Whether any indexed rule declares a custom property
+    #[must_use]
+    pub fn has_custom_properties(&self) -> bool {
+        self.custom_properties
+    }
+
+    /// Whether the declarations of `rule` depend on the node they are applied to, so the cascade
+    /// result cannot be shared with other nodes matching the same rules. Unknown rules (a stale
+    /// index) are assumed to.
+    #[must_use]
+    pub fn reads_node(&self, rule: usize) -> bool {
+        self.node_dependent.get(rule).copied().unwrap_or(true)
+    }
+}
+
+/// True when `value` contains an `attr()` or `var()` call anywhere
+fn reads_node(value: &CssValue) -> bool {
+    match value {
+        CssValue::Function(name, args) => {
+            name.eq_ignore_ascii_case("attr") || name.eq_ignore_ascii_case("var") || args.iter().any(reads_node)
+        }
+        CssValue::List(values) => values.iter().any(reads_node),
+        _ => false,
+    }
+}
+
+/// Collects the hashes of the id/class/tag keys in the compounds that must match an ancestor of
+/// the subject. `parts` is the selector without its rightmost compound.
+///
+/// Walking right to left, the compound left of a descendant or child combinator matches an
+/// ancestor of whatever its right-hand side matched, which is the subject, one of its ancestors or
+/// a sibling of one of those; in every case an ancestor of the subject. The compound left of a
+/// sibling combinator is only a sibling, so it is skipped.
+fn ancestor_hashes(parts: &[CssSelectorPart]) -> Vec<u64> {
+    let mut hashes = Vec::new();
+    let mut is_ancestor = false;
+
+    for part in parts.iter().rev() {
+        let hash = match part {
+            CssSelectorPart::Combinator(Combinator::Descendant | Combinator::Child) => {
+                is_ancestor = true;
+                continue;
+            }
+            CssSelectorPart::Combinator(Combinator::NextSibling | Combinator::SubsequentSibling) => {
+                is_ancestor = false;
+                continue;
+            }
+            // Namespace prefixes reuse the type part for the namespace name; don't guess.
+            CssSelectorPart::Combinator(Combinator::Namespace | Combinator::Column) => break,
+            _ if !is_ancestor => continue,
+            CssSelectorPart::Id(id) => key_hash(KeyKind::Id, id),
+            CssSelectorPart::Class(class) => key_hash(KeyKind::Class, class),
+            CssSelectorPart::Type(tag) => key_hash(KeyKind::Type, tag),
+            _ => continue,
+        };
+
+        if hashes.len() == MAX_ANCESTOR_HASHES {
+            break;
+        }
+        if !hashes.contains(&hash) {
+            hashes.push(hash);
+        }
+    }
+
+    hashes
+}
+
+/// Fills `out` with the `(rule, selector)` index pairs of `sheet` whose selectors may match `id`,
+/// in stylesheet order, so declarations are still applied in source order. `ancestors` must be
+/// the filter of `id`'s ancestors. Falls back to every selector when the index is stale.
+pub(crate) fn candidate_selectors<C: HasDocument>(
+    sheet: &CssStylesheet,
+    doc: &C::Document,
+    id: NodeId,
+    ancestors: &AncestorFilter,
+    out: &mut Vec<(usize, usize)>,
+) {
+    out.clear();
+
+    let index = &sheet.index;
+    if !index.covers(&sheet.rules) {
+        for (rule_idx, rule) in sheet.rules.iter().enumerate() {
+            out.extend((0..rule.selectors.len()).map(|selector_idx| (rule_idx, selector_idx)));
+        }
+        return;
+    }
+
+    // Entry indices are collected in the first slot and mapped to rule/selector pairs below.
+    let mut push_bucket = |bucket: &[usize]| {
+        for &entry_idx in bucket {
+            let Some(entry) = index.entries.get(entry_idx) else {
+                continue;
+            };
+            if entry.ancestors.iter().all(|&hash| ancestors.might_contain(hash)) {
+                out.push((entry_idx, 0));
+            }
+        }
+    };
+
+    push_bucket(&index.universal);
+
+    if doc.node_type(id) == NodeType::ElementNode {
+        if let Some(bucket) = doc.tag_atom(id).and_then(|tag| index.by_type.get(&tag)) {
+            push_bucket(bucket);
+        }
+        if let Some(bucket) = doc.attribute(id, "id").and_then(|v| index.by_id.get(v)) {
+            push_bucket(bucket);
+        }
+        if !index.by_class.is_empty() {
+            doc.for_each_class(id, &mut |class| {
+                if let Some(bucket) = index.by_class.get(class) {
+                    push_bucket(bucket);
+                }
+            });
+        }
+    }
+
+    // Entries are stored in (rule, selector, alternative) order, so sorting by entry index
+    // restores source order and leaves alternatives of the same selector adjacent.
+    out.sort_unstable();
+    out.retain_mut(|slot| match index.entries.get(slot.0) {
+        Some(entry) => {
+            *slot = (entry.rule, entry.selector);
+            true
+        }
+        None => false,
+    });
+    out.dedup();
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::Css3;
+    use gosub_interface::css3::CssOrigin;
+    use gosub_shared::config::ParserConfig;
+
+    fn index_of(css: &str) -> RuleIndex {
+        let sheet = Css3::parse_str(css, ParserConfig::default(), CssOrigin::Author, "test.css").unwrap();
+        assert!(sheet.index.covers(&sheet.rules));
+        sheet.index
+    }
+
+    #[test]
+    fn buckets_by_rightmost_key() {
+        let index = index_of("div #main .a.b {} p.c {} span {} * {} :hover {} .x > em {}");
+
+        assert_eq!(index.by_id.get("main").map(Vec::len), None, "#main is an ancestor");
+        assert_eq!(index.by_class.get("a").map(Vec::len), Some(1));
+        assert_eq!(index.by_class.get("b"), None, "only the first class is used as key");
+        assert_eq!(
+            index.by_class.get("c").map(Vec::len),
+            Some(1),
+            "classes rank above tags"
+        );
+        assert_eq!(index.by_type.get("span").map(Vec::len), Some(1));
+        assert_eq!(index.by_type.get("em").map(Vec::len), Some(1));
+        assert_eq!(index.universal.len(), 2);
+        assert_eq!(index.entries.len(), 6);
+    }
+
+    #[test]
+    fn selector_lists_index_each_alternative() {
+        let index = index_of("h1, .title, #top { color: red }");
+        assert_eq!(index.entries.len(), 3);
+        assert!(index.entries.iter().all(|e| e.rule == 0));
+        assert_eq!(index.by_id.get("top").map(Vec::len), Some(1));
+    }
+
+    #[test]
+    fn only_true_ancestors_are_hashed() {
+        let index = index_of(".x + .y .z {} .a > .b + .c {} ul li {}");
+
+        let z = &index.entries[0];
+        assert_eq!(z.ancestors, vec![key_hash(KeyKind::Class, "y")]);
+
+        let c = &index.entries[1];
+        assert_eq!(c.ancestors, vec![key_hash(KeyKind::Class, "a")]);
+
+        let li = &index.entries[2];
+        assert_eq!(li.ancestors, vec![key_hash(KeyKind::Type, "ul")]);
+    }
+
+    #[test]
+    fn filter_has_no_false_negatives() {
+        let mut filter = AncestorFilter::new();
+        let names: Vec<String> = (0..200).map(|i| format!("name-{i}")).collect();
+        for name in &names {
+            filter.insert(key_hash(KeyKind::Class, name));
+        }
+        assert!(names.iter().all(|n| filter.might_contain(key_hash(KeyKind::Class, n))));
+
+        let empty = AncestorFilter::new();
+        assert!(!empty.might_contain(key_hash(KeyKind::Id, "main")));
+    }
+
+    #[test]
+    fn pop_takes_an_element_out_again() {
+        let mut filter = AncestorFilter::new();
+        let inner = key_hash(KeyKind::Class, "inner");
+        let outer = key_hash(KeyKind::Class, "outer");
+        filter.frames.push(filter.hashes.len());
+        filter.insert(outer);
+        filter.frames.push(filter.hashes.len());
+        filter.insert(inner);
+        filter.insert(outer);
+        assert_eq!(filter.depth(), 2);
+
+        filter.pop_element();
+        assert!(!filter.might_contain(inner));
+        assert!(filter.might_contain(outer), "still held by the outer element");
+        filter.pop_element();
+        assert!(filter == AncestorFilter::new());
+    }
+
+    #[test]
+    fn candidates_cover_every_matching_selector() {
+        use crate::matcher::styling::match_selector;
+        use crate::system::Css3System;
+        use gosub_html5::document::document_impl::DocumentImpl;
+        use gosub_html5::html_compile;
+        use gosub_html5::parser::Html5Parser;
+        use gosub_interface::config::ModuleConfiguration;
+
+        #[derive(Clone, Debug, PartialEq)]
+        struct Config;
+
+        impl ModuleConfiguration for Config {
+            type CssSystem = Css3System;
+            type Document = DocumentImpl<Self>;
+            type HtmlParser = Html5Parser<'static, Self>;
+        }
+
+        let css = r#"
+            * { margin: 0 }
+            html body { color: black }
+            div { display: block }
+            #main { width: 10px }
+            #main .item { color: red }
+            .list > li, ul li.item { list-style: none }
+            .item.active, li:first-child { font-weight: bold }
+            nav a[href] { color: blue }
+            section #deep p span { color: green }
+            .card + .card { margin-top: 4px }
+            .card ~ p { margin: 1px }
+            article em, aside em { font-style: normal }
+            ul ul li { padding: 0 }
+            .list span, li > span { color: gray }
+            #missing div { color: pink }
+            .nowhere .item { color: pink }
+            table td { padding: 1px }
+        "#;
+        let html = r#"<html><body>
+            <nav><a href="/">home</a><a>plain</a></nav>
+            <div id="main">
+                <ul class="list">
+                    <li class="item active">one</li>
+                    <li class="item">two <span>x</span></li>
+                    <li><ul><li>nested</li></ul></li>
+                </ul>
+                <div class="card">a</div><div class="card">b</div><p>after</p>
+            </div>
+            <section><div id="deep"><div><p>text <span>deep</span></p></div></div></section>
+            <article><p><em>em</em></p></article>
+            <table><tr><td>cell</td></tr></table>
+        </body></html>"#;
+
+        let sheet = Css3::parse_str(css, ParserConfig::default(), CssOrigin::Author, "test.css").unwrap();
+        assert!(sheet.index.covers(&sheet.rules));
+        let doc = html_compile::<Config>(html);
+
+        // Walk the document the way style resolution does, entering and leaving elements.
+        let mut filter = AncestorFilter::new();
+        let mut candidates = Vec::new();
+        let (mut scanned, mut matched, mut kept) = (0, 0, 0);
+        let mut stack = vec![Some(doc.root())];
+        while let Some(next) = stack.pop() {
+            let Some(id) = next else {
+                filter.pop_element();
+                continue;
+            };
+            if doc.node_type(id) == NodeType::ElementNode {
+                assert!(filter == AncestorFilter::for_node::<Config>(&doc, id), "{id:?}");
+                candidate_selectors::<Config>(&sheet, &doc, id, &filter, &mut candidates);
+                assert!(candidates.windows(2).all(|w| w[0] < w[1]), "source order");
+                for (rule_idx, rule) in sheet.rules.iter().enumerate() {
+                    for (selector_idx, selector) in rule.selectors.iter().enumerate() {
+                        scanned += 1;
+                        if match_selector::<Config>(&doc, id, selector, None).0 {
+                            matched += 1;
+                            assert!(
+                                candidates.contains(&(rule_idx, selector_idx)),
+                                "rule {rule_idx} selector {selector_idx} matches {id:?} but was filtered out"
+                            );
+                        }
+                    }
+                }
+                kept += candidates.len();
+            }
+            filter.push_element::<Config>(&doc, id);
+            stack.push(None);
+            stack.extend(doc.children(id).iter().rev().map(|&child| Some(child)));
+        }
+
+        assert_eq!(filter.depth(), 0);
+        assert!(matched > 30, "{matched} matches");
+        assert!(kept < scanned / 2, "{kept} of {scanned} selectors kept");
+    }
+
+    #[test]
+    fn stale_index_is_detected() {
+        let mut sheet = Css3::parse_str("p {}", ParserConfig::default(), CssOrigin::Author, "test.css").unwrap();
+        let extra = sheet.rules[0].clone();
+        sheet.rules.push(extra);
+        assert!(!sheet.index.covers(&sheet.rules));
+        assert!(!sheet.index.has_custom_properties());
+
+        let with_vars = index_of(":root { --accent: red }");
+        assert!(with_vars.has_custom_properties());
+    }
+
+    #[test]
+    fn node_dependent_rules_are_flagged() {
+        let index = index_of("p { color: red } a { color: var(--link) } a::after { content: attr(href) }");
+        assert!(!index.reads_node(0));
+        assert!(index.reads_node(1));
+        assert!(index.reads_node(2));
+        assert!(
+            index.reads_node(3),
+            "rules outside the index are treated as node dependent"
+        );
+    }
+}
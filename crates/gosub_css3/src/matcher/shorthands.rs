@@ -1,5 +1,6 @@
 use crate::stylesheet::{CssValue, Specificity};
 use gosub_interface::css3::CssOrigin;
+use gosub_shared::atom::Atom;
 use std::collections::hash_map::Entry;
 
 use crate::matcher::property_definitions::CssDefinitions;
@@ -440,7 +441,7 @@ impl FixList {
                 continue;
             };
 
-            match props.properties.entry(name.clone()) {
+            match props.properties.entry(Atom::new(name)) {
                 Entry::Occupied(mut entry) => {
                     let prop = entry.get_mut();
 
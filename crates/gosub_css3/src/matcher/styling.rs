@@ -9,6 +9,7 @@ use gosub_interface::css3;
 use gosub_interface::css3::{CssOrigin, CssPropertyMap};
 use gosub_interface::document::Document;
 use gosub_interface::node::NodeType;
+use gosub_shared::atom::Atom;
 use gosub_shared::node::NodeId;
 
 use crate::matcher::property_definitions::get_css_definitions;
@@ -100,7 +101,7 @@ fn match_selector_part<C: HasDocument>(
     match part {
         CssSelectorPart::Universal => true,
         CssSelectorPart::Type(name) => {
-            doc.node_type(current_id) == NodeType::ElementNode && doc.tag_name(current_id).is_some_and(|t| t == name)
+            doc.node_type(current_id) == NodeType::ElementNode && doc.tag_atom(current_id).as_ref() == Some(name)
         }
         CssSelectorPart::Class(name) => doc.has_class(current_id, name),
         CssSelectorPart::Id(name) => {
@@ -348,7 +349,7 @@ fn match_selector_part<C: HasDocument>(
                     return false;
                 };
 
-                doc.namespace(current_id).is_some_and(|ns| ns == namespace)
+                doc.namespace(current_id).is_some_and(|ns| ns == namespace.as_str())
             }
             Combinator::Column => false,
         },
@@ -427,8 +428,8 @@ impl Ord for DeclarationProperty {
 /// all the computed values.
 #[derive(Debug, Clone)]
 pub struct CssProperty {
-    /// The name of the property
-    pub name: String,
+    /// The (interned) name of the property
+    pub name: Atom,
     /// True when this property needs to be recalculated
     pub dirty: bool,
     /// List of all declared values for this property
@@ -447,9 +448,9 @@ pub struct CssProperty {
 
 impl CssProperty {
     #[must_use]
-    pub fn new(prop_name: &str) -> Self {
+    pub fn new(prop_name: impl Into<Atom>) -> Self {
         Self {
-            name: prop_name.to_string(),
+            name: prop_name.into(),
             dirty: true,
             declared: Vec::new(),
             cascaded: None,
@@ -678,7 +679,8 @@ impl css3::CssProperty<Css3System> for CssProperty {
 /// the non-existing properties.
 #[derive(Debug)]
 pub struct CssProperties {
-    pub properties: HashMap<String, CssProperty>,
+    /// Keyed by interned property name; lookups by `&str` go through `Borrow<str>`
+    pub properties: HashMap<Atom, CssProperty>,
     pub dirty: bool,
 }
 
@@ -702,13 +704,23 @@ impl CssProperties {
     }
 }
 
+/// Key for `name`, reusing the property's own atom when it matches (the common case) so only
+/// renamed entries are interned again.
+fn prop_atom(name: &str, value: &CssProperty) -> Atom {
+    if value.name == name {
+        value.name.clone()
+    } else {
+        Atom::new(name)
+    }
+}
+
 impl CssPropertyMap<Css3System> for CssProperties {
     fn insert_inherited(&mut self, name: &str, value: CssProperty) {
-        self.properties.entry(name.to_string()).or_insert(value);
+        self.properties.entry(prop_atom(name, &value)).or_insert(value);
     }
 
     fn insert(&mut self, name: &str, value: CssProperty) {
-        self.properties.insert(name.to_string(), value);
+        self.properties.insert(prop_atom(name, &value), value);
     }
 
     fn get(&self, name: &str) -> Option<&CssProperty> {
@@ -1,7 +1,8 @@
 use core::fmt::Debug;
 use core::slice;
 use cow_utils::CowUtils;
-use gosub_interface::css3::CssOrigin;
+use gosub_interface::css3::{CssOrigin, HoverFingerprints};
+use gosub_shared::atom::Atom;
 use gosub_shared::byte_stream::Location;
 use gosub_shared::errors::CssError;
 use gosub_shared::errors::CssResult;
@@ -10,6 +11,7 @@ use std::cmp::Ordering;
 use std::fmt::Display;
 
 use crate::colors::{oklab_to_srgb, oklch_to_srgb, RgbColor};
+use crate::matcher::rule_index::RuleIndex;
 
 thread_local! {
     /// Viewport size (CSS px) used to resolve viewport-relative units (`vw`/`vh`/`vmin`/`vmax`)
@@ -34,7 +36,7 @@ fn layout_viewport() -> (f32, f32) {
 }
 
 /// Severity of a CSS error
-#[derive(Debug, PartialEq)]
+#[derive(Debug, PartialEq, Clone, Copy)]
 pub enum Severity {
     /// A critical error that will prevent the stylesheet from being applied
     Error,
@@ -55,7 +57,7 @@ impl Display for Severity {
 }
 
 /// Defines a CSS log during
-#[derive(PartialEq)]
+#[derive(PartialEq, Clone)]
 pub struct CssLog {
     /// Severity of the error
     pub severity: Severity,
@@ -137,7 +139,7 @@ pub struct FontFace {
 }
 
 /// Defines a complete stylesheet with all its rules and the location where it was found
-#[derive(Debug, PartialEq)]
+#[derive(Debug, PartialEq, Clone)]
 pub struct CssStylesheet {
     /// List of rules found in this stylesheet
     pub rules: Vec<CssRule>,
@@ -149,6 +151,10 @@ pub struct CssStylesheet {
     pub url: String,
     /// Any issues during parsing of the stylesheet
     pub parse_log: Vec<CssLog>,
+    /// Selector index over `rules`, built once after parsing
+    pub index: RuleIndex,
+    /// `:hover` fingerprints of `rules`, collected once after parsing
+    pub hover: HoverFingerprints,
 }
 
 impl gosub_interface::css3::CssStylesheet for CssStylesheet {
@@ -192,8 +198,8 @@ impl CssRule {
 /// A CSS declaration, which contains a property, value and a flag for !important
 #[derive(Debug, PartialEq, Clone)]
 pub struct CssDeclaration {
-    // Css property color
-    pub property: String,
+    // Css property color, interned when the stylesheet is parsed
+    pub property: Atom,
     // Raw values of the declaration. It is not calculated or converted in any way (ie: "red", "50px" etc.)
     // There can be multiple values  (ie:   "1px solid black" are split into 3 values)
     pub value: CssValue,
@@ -229,7 +235,8 @@ pub enum CssSelectorPart {
     PseudoClass(String),
     PseudoElement(String),
     Combinator(Combinator),
-    Type(String),
+    /// Type (tag name) selector, interned so matching is an identity compare
+    Type(Atom),
 }
 
 #[derive(PartialEq, Clone, Default, Debug)]
@@ -340,7 +347,7 @@ impl Display for MatcherType {
 }
 
 /// Defines the specificity for a selector
-#[derive(Debug, PartialEq, Eq, Clone, Copy)]
+#[derive(Debug, PartialEq, Eq, Hash, Clone, Copy)]
 pub struct Specificity(u32, u32, u32);
 
 impl Specificity {
@@ -514,6 +521,28 @@ impl CssValue {
         }
     }
 
+    /// Whether the value, or a value nested in it, is a length [`Self::unit_to_px`] resolves
+    /// against the layout viewport.
+    #[must_use]
+    pub fn uses_viewport_units(&self) -> bool {
+        match self {
+            CssValue::Unit(_, unit) => matches!(
+                unit.as_str(),
+                "vw" | "svw" | "lvw" | "dvw" | "vh" | "svh" | "lvh" | "dvh" | "vmin" | "vmax"
+            ),
+            // `calc()` keeps its body as raw text, so look for the unit names in it.
+            CssValue::Function(name, args) if name == "calc" => args.iter().any(|arg| match arg {
+                CssValue::String(body) => {
+                    let body = body.to_ascii_lowercase();
+                    ["vw", "vh", "vmin", "vmax"].iter().any(|unit| body.contains(unit))
+                }
+                _ => arg.uses_viewport_units(),
+            }),
+            CssValue::Function(_, args) | CssValue::List(args) => args.iter().any(CssValue::uses_viewport_units),
+            _ => false,
+        }
+    }
+
     #[must_use]
     pub fn from_vec(mut value: Vec<Self>) -> Self {
         match value.len() {
@@ -929,10 +958,10 @@ mod test {
     fn test_css_rule() {
         let rule = CssRule {
             selectors: vec![CssSelector {
-                parts: vec![vec![CssSelectorPart::Type("h1".to_string())]],
+                parts: vec![vec![CssSelectorPart::Type("h1".into())]],
             }],
             declarations: vec![CssDeclaration {
-                property: "color".to_string(),
+                property: Atom::from_static("color"),
                 value: CssValue::String("red".to_string()),
                 important: false,
             }],
@@ -949,7 +978,7 @@ mod test {
             .first()
             .unwrap();
 
-        assert_eq!(part, &CssSelectorPart::Type("h1".to_string()));
+        assert_eq!(part, &CssSelectorPart::Type("h1".into()));
         assert_eq!(rule.declarations().len(), 1);
         assert_eq!(rule.declarations().first().unwrap().property, "color");
     }
@@ -958,7 +987,7 @@ mod test {
     fn test_specificity() {
         let selector = CssSelector {
             parts: vec![vec![
-                CssSelectorPart::Type("h1".to_string()),
+                CssSelectorPart::Type("h1".into()),
                 CssSelectorPart::Class("myclass".to_string()),
                 CssSelectorPart::Id("myid".to_string()),
             ]],
@@ -969,7 +998,7 @@ mod test {
 
         let selector = CssSelector {
             parts: vec![vec![
-                CssSelectorPart::Type("h1".to_string()),
+                CssSelectorPart::Type("h1".into()),
                 CssSelectorPart::Class("myclass".to_string()),
             ]],
         };
@@ -978,7 +1007,7 @@ mod test {
         assert_eq!(specificity, vec![Specificity::new(0, 1, 1)]);
 
         let selector = CssSelector {
-            parts: vec![vec![CssSelectorPart::Type("h1".to_string())]],
+            parts: vec![vec![CssSelectorPart::Type("h1".into())]],
         };
 
         let specificity = selector.specificity();
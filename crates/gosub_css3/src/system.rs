@@ -2,20 +2,23 @@ use crate::functions::attr::resolve_attr;
 use crate::functions::math::resolve_math;
 use crate::functions::var::resolve_var;
 use crate::matcher::property_definitions::get_css_definitions;
+use crate::matcher::rule_index::{candidate_selectors, AncestorFilter};
 use crate::matcher::shorthands::{FixList, FixListInfo};
 use crate::matcher::styling::{match_selector, CssProperties, CssProperty, DeclarationProperty};
-use crate::stylesheet::{CssDeclaration, CssStylesheet, CssValue, Specificity};
+use crate::stylesheet::{CssDeclaration, CssRule, CssStylesheet, CssValue, Specificity};
 use crate::{load_default_useragent_stylesheet, Css3};
 use cow_utils::CowUtils;
 use gosub_interface::config::HasDocument;
 use gosub_interface::css3::{CssOrigin, CssPropertyMap, CssSystem, HoverFingerprints};
 use gosub_interface::document::Document;
 use gosub_interface::node::NodeType;
+use gosub_shared::atom::Atom;
 use gosub_shared::config::ParserConfig;
 use gosub_shared::errors::CssResult;
 use gosub_shared::node::NodeId;
 use std::collections::HashMap;
 use std::slice;
+use std::sync::Arc;
 
 /// Strip a vendor prefix (-webkit-, -moz-, -ms-, -o-) from a CSS keyword, returning
 /// the unprefixed form. E.g. "-webkit-match-parent" → "match-parent".
@@ -37,19 +40,39 @@ fn normalize_vendor_prefixes(value: CssValue) -> CssValue {
     }
 }
 
+/// One matched selector: the rule it belongs to and the specificity it matched with
+#[derive(Debug, Clone, PartialEq, Eq, Hash)]
+pub struct MatchedRule {
+    sheet: usize,
+    rule: usize,
+    specificity: Specificity,
+}
+
+/// Selector-matching result for a node, in cascade order. Nodes with equal `MatchedRules` get
+/// identical property maps, which is what style sharing relies on.
+#[derive(Debug, Clone, Default, PartialEq, Eq, Hash)]
+pub struct MatchedRules {
+    rules: Vec<MatchedRule>,
+    /// Set when a matched rule reads per-node input (`attr()`, `var()`), which ties the result
+    /// to this node and keeps it from being shared.
+    node: Option<NodeId>,
+}
+
 #[derive(Debug, Clone)]
 pub struct Css3System;
 
 impl CssSystem for Css3System {
-    type Stylesheet = crate::stylesheet::CssStylesheet;
+    type Stylesheet = Arc<CssStylesheet>;
 
     type PropertyMap = CssProperties;
 
     type Property = CssProperty;
     type Value = CssValue;
+    type MatchedRules = MatchedRules;
+    type AncestorFilter = AncestorFilter;
 
     fn parse_str(str: &str, config: ParserConfig, origin: CssOrigin, url: &str) -> CssResult<Self::Stylesheet> {
-        Css3::parse_str(str, config, origin, url)
+        Css3::parse_str(str, config, origin, url).map(Arc::new)
     }
 
     fn properties_from_node<C: HasDocument<CssSystem = Self>>(
@@ -60,6 +83,44 @@ impl CssSystem for Css3System {
         compute_properties::<C>(doc, id, sheets, None)
     }
 
+    fn match_rules<C: HasDocument<CssSystem = Self>>(
+        doc: &C::Document,
+        id: NodeId,
+        sheets: &[Self::Stylesheet],
+    ) -> Option<Self::MatchedRules> {
+        match_rules::<C>(doc, id, sheets, None, None)
+    }
+
+    fn match_rules_in<C: HasDocument<CssSystem = Self>>(
+        doc: &C::Document,
+        id: NodeId,
+        sheets: &[Self::Stylesheet],
+        ancestors: &Self::AncestorFilter,
+    ) -> Option<Self::MatchedRules> {
+        match_rules::<C>(doc, id, sheets, None, Some(ancestors))
+    }
+
+    fn enter_element<C: HasDocument<CssSystem = Self>>(
+        ancestors: &mut Self::AncestorFilter,
+        doc: &C::Document,
+        id: NodeId,
+    ) {
+        ancestors.push_element::<C>(doc, id);
+    }
+
+    fn leave_element(ancestors: &mut Self::AncestorFilter) {
+        ancestors.pop_element();
+    }
+
+    fn properties_from_matched<C: HasDocument<CssSystem = Self>>(
+        doc: &C::Document,
+        id: NodeId,
+        sheets: &[Self::Stylesheet],
+        matched: &Self::MatchedRules,
+    ) -> Self::PropertyMap {
+        cascade_properties::<C>(doc, id, sheets, matched)
+    }
+
     fn pseudo_properties_from_node<C: HasDocument<CssSystem = Self>>(
         doc: &C::Document,
         id: NodeId,
@@ -84,6 +145,14 @@ impl CssSystem for Css3System {
     fn hover_fingerprints(sheets: &[Self::Stylesheet]) -> HoverFingerprints {
         hover_fingerprints_impl(sheets)
     }
+
+    fn uses_viewport_units(sheets: &[Self::Stylesheet]) -> bool {
+        sheets
+            .iter()
+            .flat_map(|sheet| &sheet.rules)
+            .flat_map(|rule| &rule.declarations)
+            .any(|declaration| declaration.value.uses_viewport_units())
+    }
 }
 
 /// Shared style-collection core for both real elements (`pseudo == None`) and pseudo-elements
@@ -92,192 +161,250 @@ impl CssSystem for Css3System {
 fn compute_properties<C: HasDocument<CssSystem = Css3System>>(
     doc: &C::Document,
     id: NodeId,
-    sheets: &[CssStylesheet],
+    sheets: &[Arc<CssStylesheet>],
     pseudo: Option<&str>,
 ) -> Option<CssProperties> {
-    let mut css_map_entry = CssProperties::new();
+    let matched = match_rules::<C>(doc, id, sheets, pseudo, None)?;
+    Some(cascade_properties::<C>(doc, id, sheets, &matched))
+}
 
+/// Selector matching phase: collects the selectors of `sheets` that match `id`, in cascade
+/// order. `None` when the node is not renderable. `ancestors` is the filter of a tree walk that
+/// reached `id`; without one it is built from `id`'s ancestors.
+fn match_rules<C: HasDocument<CssSystem = Css3System>>(
+    doc: &C::Document,
+    id: NodeId,
+    sheets: &[Arc<CssStylesheet>],
+    pseudo: Option<&str>,
+    ancestors: Option<&AncestorFilter>,
+) -> Option<MatchedRules> {
     // The unrenderable check applies to real elements only; a pseudo-element is generated
     // content hanging off a (renderable) originating element.
     if pseudo.is_none() && node_is_unrenderable::<C>(doc, id) {
         return None;
     }
 
+    let own_filter;
+    let ancestors = match ancestors {
+        Some(ancestors) => ancestors,
+        None => {
+            own_filter = AncestorFilter::for_node::<C>(doc, id);
+            &own_filter
+        }
+    };
+    let mut candidates = Vec::new();
+    let mut matched = MatchedRules::default();
+
+    for (sheet_idx, sheet) in sheets.iter().enumerate() {
+        candidate_selectors::<C>(sheet, doc, id, ancestors, &mut candidates);
+        for &(rule_idx, selector_idx) in &candidates {
+            let Some(selector) = sheet.rules.get(rule_idx).and_then(|r| r.selectors.get(selector_idx)) else {
+                continue;
+            };
+            let (is_match, specificity) = match_selector::<C>(doc, id, selector, pseudo);
+            if !is_match {
+                continue;
+            }
+            if sheet.index.reads_node(rule_idx) {
+                matched.node = Some(id);
+            }
+            matched.rules.push(MatchedRule {
+                sheet: sheet_idx,
+                rule: rule_idx,
+                specificity,
+            });
+        }
+    }
+
+    Some(matched)
+}
+
+/// Cascade phase: applies the declarations of the `matched` rules of `id`, in order.
+fn cascade_properties<C: HasDocument<CssSystem = Css3System>>(
+    doc: &C::Document,
+    id: NodeId,
+    sheets: &[Arc<CssStylesheet>],
+    matched: &MatchedRules,
+) -> CssProperties {
+    let mut css_map_entry = CssProperties::new();
+
     let definitions = get_css_definitions();
 
-    // Pass 1: collect all custom property values visible to this node (with inheritance).
-    let custom_props = collect_custom_props::<C>(doc, id, sheets);
+    // Pass 1: collect all custom property values visible to this node (with inheritance). They
+    // only feed `var()`, and a rule using it marks the match as node-specific.
+    let custom_props = if matched.node.is_some() {
+        collect_custom_props::<C>(doc, id, sheets)
+    } else {
+        HashMap::new()
+    };
 
     let mut fix_list = FixList::new();
 
-    for sheet in sheets {
-        for rule in &sheet.rules {
-            for selector in rule.selectors() {
-                let (matched, specificity) = match_selector::<C>(doc, id, selector, pseudo);
-
-                if !matched {
-                    continue;
-                }
+    for m in &matched.rules {
+        let Some(sheet) = sheets.get(m.sheet) else {
+            continue;
+        };
+        let Some(rule) = sheet.rules.get(m.rule) else {
+            continue;
+        };
+        let specificity = m.specificity;
+
+        for declaration in rule.declarations() {
+            // Custom property declarations are consumed by collect_custom_props;
+            // skip them here so they don't clutter the regular property map.
+            if declaration.property.starts_with("--") {
+                continue;
+            }
+            let value = resolve_functions::<C>(&declaration.value, doc, id, &custom_props);
+            // Normalize vendor-prefixed values (-webkit-X → X) so they match
+            // against the standard keyword definitions.
+            let value = normalize_vendor_prefixes(value);
+
+            // `content` carries arbitrary tokens (strings, `attr()`, counters,
+            // quotes) that the property-syntax matcher cannot validate - notably the
+            // empty string `content: ""`. Pass it through verbatim; the render
+            // pipeline resolves it into generated text itself.
+            if declaration.property == "content" {
+                add_property_to_map(
+                    &mut css_map_entry,
+                    sheet,
+                    specificity,
+                    &CssDeclaration {
+                        property: Atom::from_static("content"),
+                        value,
+                        important: declaration.important,
+                    },
+                );
+                continue;
+            }
 
-                // Selector matched, so we add all declared values to the map
-                for declaration in rule.declarations() {
-                    // Custom property declarations are consumed by collect_custom_props;
-                    // skip them here so they don't clutter the regular property map.
-                    if declaration.property.starts_with("--") {
-                        continue;
-                    }
-                    let value = resolve_functions::<C>(&declaration.value, doc, id, &custom_props);
-                    // Normalize vendor-prefixed values (-webkit-X → X) so they match
-                    // against the standard keyword definitions.
-                    let value = normalize_vendor_prefixes(value);
-
-                    // `content` carries arbitrary tokens (strings, `attr()`, counters,
-                    // quotes) that the property-syntax matcher cannot validate - notably the
-                    // empty string `content: ""`. Pass it through verbatim; the render
-                    // pipeline resolves it into generated text itself.
-                    if declaration.property == "content" {
-                        add_property_to_map(
-                            &mut css_map_entry,
-                            sheet,
-                            specificity,
-                            &CssDeclaration {
-                                property: "content".to_string(),
-                                value,
-                                important: declaration.important,
-                            },
-                        );
+            // If the property has a definition, validate and expand shorthands.
+            // If not (e.g. margin-top, padding-bottom - longhand properties not yet
+            // in the definition list), insert the value directly without validation.
+            match definitions.find_property(&declaration.property) {
+                Some(definition) => {
+                    let match_value = if let CssValue::List(value) = &value {
+                        &**value
+                    } else {
+                        slice::from_ref(&value)
+                    };
+
+                    // Tag the expanded longhands with this declaration's cascade origin
+                    // and specificity, so e.g. an author `margin: 0` outranks the UA
+                    // `body { margin: 8px }` instead of losing to it on processing order.
+                    fix_list.set_info(FixListInfo::new(
+                        sheet.origin,
+                        declaration.important,
+                        sheet.url.clone(),
+                        specificity,
+                    ));
+
+                    // Each CSS declaration starts with a fresh TRBL multiplier
+                    // counter for this shorthand name. Without this reset, a prior
+                    // rule's `margin: 0` (count→1) would corrupt a later rule's
+                    // `margin: 0 auto` expansion (starting at multi=1 instead of 0).
+                    fix_list.reset_multiplier(&declaration.property);
+                    if !definition.matches_and_shorthands(match_value, &mut fix_list) {
+                        // Special-case: the full `background` shorthand grammar
+                        // (comma-separated `<bg-layer>` lists) is stricter than the
+                        // matcher supports, so common forms like
+                        // `background: url(x) no-repeat` or `background: #fff` fail
+                        // validation and would be dropped entirely. Recover the parts
+                        // the consumer understands - `background-image` (a `url()`)
+                        // and `background-color` (a color) - and emit them as the
+                        // corresponding longhands. Position/repeat/size are still
+                        // ignored.
+                        if declaration.property == "background" {
+                            let mut recovered = false;
+                            // `url(...)` or a `*-gradient(...)` both become the
+                            // `background-image` longhand the consumer reads.
+                            if let Some(image_value) =
+                                find_background_url(&value).or_else(|| find_background_gradient(&value))
+                            {
+                                add_property_to_map(
+                                    &mut css_map_entry,
+                                    sheet,
+                                    specificity,
+                                    &CssDeclaration {
+                                        property: Atom::from_static("background-image"),
+                                        value: image_value,
+                                        important: declaration.important,
+                                    },
+                                );
+                                recovered = true;
+                            }
+                            if let Some(color_value) = find_background_color(&value) {
+                                add_property_to_map(
+                                    &mut css_map_entry,
+                                    sheet,
+                                    specificity,
+                                    &CssDeclaration {
+                                        property: Atom::from_static("background-color"),
+                                        value: color_value,
+                                        important: declaration.important,
+                                    },
+                                );
+                                recovered = true;
+                            }
+                            if recovered {
+                                continue;
+                            }
+                        }
+                        log::debug!("Declaration does not match definition: {declaration:?}");
                         continue;
                     }
 
-                    // If the property has a definition, validate and expand shorthands.
-                    // If not (e.g. margin-top, padding-bottom - longhand properties not yet
-                    // in the definition list), insert the value directly without validation.
-                    match definitions.find_property(&declaration.property) {
-                        Some(definition) => {
-                            let match_value = if let CssValue::List(value) = &value {
-                                &**value
-                            } else {
-                                slice::from_ref(&value)
-                            };
-
-                            // Tag the expanded longhands with this declaration's cascade origin
-                            // and specificity, so e.g. an author `margin: 0` outranks the UA
-                            // `body { margin: 8px }` instead of losing to it on processing order.
-                            fix_list.set_info(FixListInfo::new(
-                                sheet.origin,
-                                declaration.important,
-                                sheet.url.clone(),
-                                specificity,
-                            ));
-
-                            // Each CSS declaration starts with a fresh TRBL multiplier
-                            // counter for this shorthand name. Without this reset, a prior
-                            // rule's `margin: 0` (count→1) would corrupt a later rule's
-                            // `margin: 0 auto` expansion (starting at multi=1 instead of 0).
-                            fix_list.reset_multiplier(&declaration.property);
-                            if !definition.matches_and_shorthands(match_value, &mut fix_list) {
-                                // Special-case: the full `background` shorthand grammar
-                                // (comma-separated `<bg-layer>` lists) is stricter than the
-                                // matcher supports, so common forms like
-                                // `background: url(x) no-repeat` or `background: #fff` fail
-                                // validation and would be dropped entirely. Recover the parts
-                                // the consumer understands - `background-image` (a `url()`)
-                                // and `background-color` (a color) - and emit them as the
-                                // corresponding longhands. Position/repeat/size are still
-                                // ignored.
-                                if declaration.property == "background" {
-                                    let mut recovered = false;
-                                    // `url(...)` or a `*-gradient(...)` both become the
-                                    // `background-image` longhand the consumer reads.
-                                    if let Some(image_value) =
-                                        find_background_url(&value).or_else(|| find_background_gradient(&value))
-                                    {
-                                        add_property_to_map(
-                                            &mut css_map_entry,
-                                            sheet,
-                                            specificity,
-                                            &CssDeclaration {
-                                                property: "background-image".to_string(),
-                                                value: image_value,
-                                                important: declaration.important,
-                                            },
-                                        );
-                                        recovered = true;
-                                    }
-                                    if let Some(color_value) = find_background_color(&value) {
-                                        add_property_to_map(
-                                            &mut css_map_entry,
-                                            sheet,
-                                            specificity,
-                                            &CssDeclaration {
-                                                property: "background-color".to_string(),
-                                                value: color_value,
-                                                important: declaration.important,
-                                            },
-                                        );
-                                        recovered = true;
-                                    }
-                                    if recovered {
-                                        continue;
-                                    }
-                                }
-                                log::debug!("Declaration does not match definition: {declaration:?}");
-                                continue;
+                    let value = if let CssValue::List(mut values) = value {
+                        match values.pop() {
+                            Some(single) if values.is_empty() => single,
+                            Some(last) => {
+                                values.push(last);
+                                CssValue::List(values)
                             }
-
-                            let value = if let CssValue::List(mut values) = value {
-                                match values.pop() {
-                                    Some(single) if values.is_empty() => single,
-                                    Some(last) => {
-                                        values.push(last);
-                                        CssValue::List(values)
-                                    }
-                                    None => CssValue::List(values),
-                                }
-                            } else {
-                                value
-                            };
-
-                            add_property_to_map(
-                                &mut css_map_entry,
-                                sheet,
-                                specificity,
-                                &CssDeclaration {
-                                    property: declaration.property.clone(),
-                                    value,
-                                    important: declaration.important,
-                                },
-                            );
+                            None => CssValue::List(values),
                         }
-                        None => {
-                            // No definition: pass the value through as-is so that properties
-                            // like margin-top, padding-left, font-size etc. (which are valid
-                            // CSS but happen not to have their own PropertyDefinition entry)
-                            // still reach the style consumer.
-                            let value = if let CssValue::List(mut values) = value {
-                                match values.pop() {
-                                    Some(single) if values.is_empty() => single,
-                                    Some(last) => {
-                                        values.push(last);
-                                        CssValue::List(values)
-                                    }
-                                    None => CssValue::List(values),
-                                }
-                            } else {
-                                value
-                            };
-                            add_property_to_map(
-                                &mut css_map_entry,
-                                sheet,
-                                specificity,
-                                &CssDeclaration {
-                                    property: declaration.property.clone(),
-                                    value,
-                                    important: declaration.important,
-                                },
-                            );
+                    } else {
+                        value
+                    };
+
+                    add_property_to_map(
+                        &mut css_map_entry,
+                        sheet,
+                        specificity,
+                        &CssDeclaration {
+                            property: declaration.property.clone(),
+                            value,
+                            important: declaration.important,
+                        },
+                    );
+                }
+                None => {
+                    // No definition: pass the value through as-is so that properties
+                    // like margin-top, padding-left, font-size etc. (which are valid
+                    // CSS but happen not to have their own PropertyDefinition entry)
+                    // still reach the style consumer.
+                    let value = if let CssValue::List(mut values) = value {
+                        match values.pop() {
+                            Some(single) if values.is_empty() => single,
+                            Some(last) => {
+                                values.push(last);
+                                CssValue::List(values)
+                            }
+                            None => CssValue::List(values),
                         }
-                    }
+                    } else {
+                        value
+                    };
+                    add_property_to_map(
+                        &mut css_map_entry,
+                        sheet,
+                        specificity,
+                        &CssDeclaration {
+                            property: declaration.property.clone(),
+                            value,
+                            important: declaration.important,
+                        },
+                    );
                 }
             }
         }
@@ -287,56 +414,67 @@ fn compute_properties<C: HasDocument<CssSystem = Css3System>>(
 
     fix_list.apply(&mut css_map_entry);
 
-    Some(css_map_entry)
+    css_map_entry
+}
+
+fn hover_fingerprints_impl(sheets: &[Arc<CssStylesheet>]) -> HoverFingerprints {
+    let mut fp = HoverFingerprints::default();
+    for sheet in sheets {
+        fp.merge(&sheet.hover);
+        if fp.has_universal {
+            break;
+        }
+    }
+    fp
 }
 
-fn hover_fingerprints_impl(sheets: &[CssStylesheet]) -> HoverFingerprints {
+/// The [`HoverFingerprints`] of one stylesheet's rules; kept on the stylesheet so the fingerprints
+/// of a document are a merge, not a walk over every selector.
+pub(crate) fn rule_hover_fingerprints(rules: &[CssRule]) -> HoverFingerprints {
     use crate::stylesheet::CssSelectorPart;
 
     let mut fp = HoverFingerprints::default();
 
-    for sheet in sheets {
-        for rule in &sheet.rules {
-            for selector in &rule.selectors {
-                for part_list in &selector.parts {
-                    // Split the part list into compounds (groups between Combinators).
-                    // :hover belongs to the compound it appears in; that compound's
-                    // Type/Class/Id parts are the hover-subject fingerprint.
-                    let mut compound: Vec<&CssSelectorPart> = Vec::new();
-                    for part in part_list {
-                        if matches!(part, CssSelectorPart::Combinator(_)) {
-                            compound.clear();
-                            continue;
-                        }
-                        compound.push(part);
-                        if !matches!(part, CssSelectorPart::PseudoClass(n) if n == "hover") {
-                            continue;
-                        }
-                        // Found :hover - classify this compound.
-                        let mut specific = false;
-                        for p in &compound {
-                            match p {
-                                CssSelectorPart::Type(t) => {
-                                    fp.types.insert(t.clone());
-                                    specific = true;
-                                }
-                                CssSelectorPart::Class(c) => {
-                                    fp.classes.insert(c.clone());
-                                    specific = true;
-                                }
-                                CssSelectorPart::Id(id) => {
-                                    fp.ids.insert(id.clone());
-                                    specific = true;
-                                }
-                                _ => {}
+    for rule in rules {
+        for selector in &rule.selectors {
+            for part_list in &selector.parts {
+                // Split the part list into compounds (groups between Combinators).
+                // :hover belongs to the compound it appears in; that compound's
+                // Type/Class/Id parts are the hover-subject fingerprint.
+                let mut compound: Vec<&CssSelectorPart> = Vec::new();
+                for part in part_list {
+                    if matches!(part, CssSelectorPart::Combinator(_)) {
+                        compound.clear();
+                        continue;
+                    }
+                    compound.push(part);
+                    if !matches!(part, CssSelectorPart::PseudoClass(n) if n == "hover") {
+                        continue;
+                    }
+                    // Found :hover - classify this compound.
+                    let mut specific = false;
+                    for p in &compound {
+                        match p {
+                            CssSelectorPart::Type(t) => {
+                                fp.types.insert(t.to_string());
+                                specific = true;
                             }
-                        }
-                        if !specific {
-                            // Bare :hover or *:hover - everything is sensitive.
-                            fp.has_universal = true;
-                            return fp;
+                            CssSelectorPart::Class(c) => {
+                                fp.classes.insert(c.clone());
+                                specific = true;
+                            }
+                            CssSelectorPart::Id(id) => {
+                                fp.ids.insert(id.clone());
+                                specific = true;
+                            }
+                            _ => {}
                         }
                     }
+                    if !specific {
+                        // Bare :hover or *:hover - everything is sensitive.
+                        fp.has_universal = true;
+                        return fp;
+                    }
                 }
             }
         }
@@ -371,8 +509,8 @@ pub fn add_property_to_map(
 
     css_map_entry
         .properties
-        .entry(property_name.clone())
-        .or_insert_with(|| CssProperty::new(property_name.as_str()))
+        .entry(property_name)
+        .or_insert_with_key(|name| CssProperty::new(name.clone()))
         .declared
         .push(declaration);
 }
@@ -392,7 +530,7 @@ pub fn node_is_unrenderable<C: HasDocument>(doc: &C::Document, id: NodeId) -> bo
 fn collect_custom_props<C: HasDocument<CssSystem = Css3System>>(
     doc: &C::Document,
     id: NodeId,
-    sheets: &[CssStylesheet],
+    sheets: &[Arc<CssStylesheet>],
 ) -> HashMap<String, CssValue> {
     let mut chain = vec![id];
     let mut cur = id;
@@ -403,22 +541,38 @@ fn collect_custom_props<C: HasDocument<CssSystem = Css3System>>(
     chain.reverse(); // root first - descendants override ancestors
 
     let mut custom_props: HashMap<String, CssValue> = HashMap::new();
+    if !sheets.iter().any(|sheet| sheet.index.has_custom_properties()) {
+        return custom_props;
+    }
+
+    // Walking root first, the filter for each node is its parent's filter plus the parent.
+    let mut ancestors = AncestorFilter::new();
+    let mut candidates = Vec::new();
     for node_id in chain {
-        for sheet in sheets {
-            for rule in &sheet.rules {
-                for selector in rule.selectors() {
-                    let (matched, _) = match_selector::<C>(doc, node_id, selector, None);
-                    if !matched {
-                        continue;
-                    }
-                    for decl in rule.declarations() {
-                        if decl.property.starts_with("--") {
-                            custom_props.insert(decl.property.clone(), decl.value.clone());
-                        }
+        for sheet in sheets.iter().filter(|sheet| sheet.index.has_custom_properties()) {
+            candidate_selectors::<C>(sheet, doc, node_id, &ancestors, &mut candidates);
+            for &(rule_idx, selector_idx) in &candidates {
+                let Some(rule) = sheet.rules.get(rule_idx) else {
+                    continue;
+                };
+                let Some(selector) = rule.selectors.get(selector_idx) else {
+                    continue;
+                };
+                if !rule.declarations().iter().any(|decl| decl.property.starts_with("--")) {
+                    continue;
+                }
+                let (matched, _) = match_selector::<C>(doc, node_id, selector, None);
+                if !matched {
+                    continue;
+                }
+                for decl in rule.declarations() {
+                    if decl.property.starts_with("--") {
+                        custom_props.insert(decl.property.to_string(), decl.value.clone());
                     }
                 }
             }
         }
+        ancestors.push_element::<C>(doc, node_id);
     }
     custom_props
 }
@@ -12,22 +12,28 @@ use crate::engine::storage::{StorageArea, StorageHandles};
 use crate::html::EngineDocument;
 use gosub_config::{Config, HasConfig};
 use gosub_render_pipeline::rasterizer::{
-    collect_placed_gpu_tiles, cpu_cached_tiles, rasterize_parallel, rasterize_sequential, BakedTile, RasterStrategy,
-    Rasterable, TilePixelCache,
+    collect_placed_gpu_tiles, cpu_cached_tiles, rasterize_sequential, rasterize_tiles, split_viewport_tiles, BakedTile,
+    FillBatch, RasterFill, RasterStrategy, Rasterable, TilePixelCache,
 };
 use gosub_render_pipeline::render::{Color, DisplayItem, RenderContext, RenderList, Viewport};
 use std::sync::Arc;
 
 use crate::html::RenderConfiguration;
+use gosub_html5::document::task_queue::DocumentTaskQueue;
 use gosub_interface::css3::{CssSystem, HoverFingerprints};
-use gosub_interface::document::Document as _;
+use gosub_interface::document::{Document as _, DocumentType, DomDamage};
+use gosub_render_pipeline::common::document::pipeline_doc::{GosubDocumentAdapter, PipelineDocument};
 use gosub_render_pipeline::common::texture::TilePixels;
+use gosub_render_pipeline::common::tile_cache::TileCacheBudget;
 use gosub_render_pipeline::layering::layer::LayerList;
+use gosub_render_pipeline::layouter::taffy::TaffyLayouter;
 use gosub_render_pipeline::layouter::LayoutElementId;
+use gosub_render_pipeline::painter::display_list::DisplayList;
 use gosub_render_pipeline::painter::{PaintScene, Painter};
 use gosub_render_pipeline::render::backend::{CachedTile, ExternalHandle};
 use gosub_shared::node::NodeId;
 use std::any::Any;
+use std::collections::HashSet;
 
 /// GPU-scene cache: the layer list (for hit-testing) plus the whole-page paint command list
 /// (for the backend to render). The GPU equivalent of [`PipelineCache`] - it skips tiling,
@@ -62,6 +68,26 @@ fn hover_matches<C: RenderConfiguration>(fp: &HoverFingerprints, doc: &EngineDoc
     }
     false
 }
+
+/// True if the document's styles resolve differently at another viewport size: a stylesheet or
+/// an inline `style` attribute uses a viewport-relative length.
+fn uses_viewport_units<C: RenderConfiguration>(doc: &EngineDocument<C>) -> bool {
+    if <C::CssSystem as CssSystem>::uses_viewport_units(doc.stylesheets()) {
+        return true;
+    }
+    let mut stack = vec![doc.root()];
+    while let Some(node_id) = stack.pop() {
+        if let Some(style) = doc.attribute(node_id, "style") {
+            let style = style.to_ascii_lowercase();
+            if ["vw", "vh", "vmin", "vmax"].iter().any(|unit| style.contains(unit)) {
+                return true;
+            }
+        }
+        stack.extend_from_slice(doc.children(node_id));
+    }
+    false
+}
+
 /// Cached output of stages 1–6 for the whole page. Re-used on every scroll tick.
 struct PipelineCache {
     tiles: Vec<BakedTile>,
@@ -70,10 +96,142 @@ struct PipelineCache {
     cached_tiles: Arc<Vec<CachedTile>>,
     /// Layer list retained for hit-testing (hover).
     layer_list: Arc<LayerList>,
-    /// Rasterized tile data keyed by (page_x, page_y, layer_id, content_hash).
-    /// Passed to the next render so unchanged tiles skip rasterization.
-    /// Value is (physical_width, physical_height, pixel_data).
-    tile_pixel_cache: TilePixelCache,
+    /// Paint commands of `layer_list`, retained so the next incremental rebuild only repaints
+    /// the elements that changed.
+    display_list: Arc<DisplayList>,
+    /// Background fill-in of the tiles outside the viewport, still running after a viewport-first
+    /// render (see [`pipeline_build_cache`]). Its batches are merged into `tiles` as they land;
+    /// dropping the cache cancels it.
+    fill: Option<RasterFill>,
+    /// Tiles handed to `fill` that it has not delivered yet, by [`tile_key`]. A rebuild that
+    /// starts from this cache rasterizes them again instead of waiting for the fill.
+    unfilled: HashSet<TileKey>,
+}
+
+/// A tile's position in its layer, `(page_x bits, page_y bits, layer_id)`. Carries tiles over
+/// between two tile lists of the same layout.
+type TileKey = (u64, u64, u64);
+
+fn tile_key(rect: gosub_render_pipeline::common::geo::Rect, layer_id: u64) -> TileKey {
+    (rect.x.to_bits(), rect.y.to_bits(), layer_id)
+}
+
+fn baked_tile_key(tile: &BakedTile) -> TileKey {
+    (tile.page_x.to_bits(), tile.page_y.to_bits(), tile.layer_id)
+}
+
+impl PipelineCache {
+    /// Merges finished fill-in batches into the tile list, keeping it in back-to-front layer
+    /// order. Tiles of one layer never overlap, so a stable sort on the layer's position is
+    /// enough to slot the new tiles in.
+    fn merge_fill(&mut self, batches: Vec<FillBatch>) {
+        if batches.is_empty() {
+            return;
+        }
+        let rank: std::collections::HashMap<u64, usize> = self
+            .layer_list
+            .layer_ids
+            .read()
+            .iter()
+            .enumerate()
+            .map(|(i, id)| (id.as_u64(), i))
+            .collect();
+        let rank_of = |t: &BakedTile| rank.get(&t.layer_id).copied().unwrap_or(usize::MAX);
+
+        for batch in &batches {
+            for (rect, layer_id) in &batch.covered {
+                self.unfilled.remove(&tile_key(*rect, layer_id.as_u64()));
+            }
+        }
+
+        let old_tiles = std::mem::take(&mut self.tiles);
+        // CPU tiles map one-to-one onto their CachedTile; reuse those instead of rescanning
+        // every tile's pixels for opacity.
+        let one_to_one =
+            old_tiles.len() == self.cached_tiles.len() && batches.iter().all(|b| b.tiles.len() == b.cached_tiles.len());
+        if one_to_one {
+            let mut merged: Vec<(usize, BakedTile, CachedTile)> = old_tiles
+                .into_iter()
+                .zip(self.cached_tiles.iter().cloned())
+                .map(|(t, c)| (rank_of(&t), t, c))
+                .collect();
+            for batch in batches {
+                merged.extend(
+                    batch
+                        .tiles
+                        .into_iter()
+                        .zip(batch.cached_tiles)
+                        .map(|(t, c)| (rank_of(&t), t, c)),
+                );
+            }
+            merged.sort_by_key(|(r, _, _)| *r);
+            let (tiles, cached): (Vec<_>, Vec<_>) = merged.into_iter().map(|(_, t, c)| (t, c)).unzip();
+            self.tiles = tiles;
+            self.cached_tiles = Arc::new(cached);
+        } else {
+            let mut tiles = old_tiles;
+            for batch in batches {
+                tiles.extend(batch.tiles);
+            }
+            tiles.sort_by_key(rank_of);
+            self.cached_tiles = Arc::new(cpu_cached_tiles(&tiles));
+            self.tiles = tiles;
+        }
+    }
+
+    /// Stops the background fill, merges the batches it already finished and returns the tiles
+    /// it never got to. Used before reusing the cache for an incremental repaint, which queues
+    /// those tiles again rather than blocking on the fill.
+    fn stop_fill(&mut self) -> HashSet<TileKey> {
+        if let Some(fill) = self.fill.take() {
+            fill.cancel();
+            let (batches, _) = fill.try_take();
+            self.merge_fill(batches);
+        }
+        std::mem::take(&mut self.unfilled)
+    }
+
+    /// Stops the background fill and waits out the batch in flight, merging whatever it
+    /// finished. Unlike [`Self::stop_fill`] the tiles it never got to stay in `unfilled`; once
+    /// this returns, the fill thread no longer refers to the layer list.
+    fn finish_fill(&mut self) {
+        if let Some(fill) = self.fill.take() {
+            fill.cancel();
+            let batches = fill.wait();
+            self.merge_fill(batches);
+        }
+    }
+
+    /// Points the render tree this cache was built from at `doc` (see
+    /// [`LayerList::retarget_document`]). The display list shares the cache's layer list, so the
+    /// cache lets go of its own handle while the display list retargets it. The flag is false
+    /// when some other owner kept the old document referenced.
+    fn retarget_document(self, doc: Arc<dyn PipelineDocument>) -> (Self, bool) {
+        if !Arc::ptr_eq(&self.layer_list, self.display_list.layer_list()) {
+            return (self, false);
+        }
+        let Self {
+            tiles,
+            page_height,
+            cached_tiles,
+            layer_list,
+            mut display_list,
+            fill,
+            unfilled,
+        } = self;
+        drop(layer_list);
+        let retargeted = Arc::get_mut(&mut display_list).is_some_and(|list| list.retarget_document(doc));
+        let cache = Self {
+            tiles,
+            page_height,
+            cached_tiles,
+            layer_list: Arc::clone(display_list.layer_list()),
+            display_list,
+            fill,
+            unfilled,
+        };
+        (cache, retargeted)
+    }
 }
 
 /// BrowsingContext dedicated to a specific tab
@@ -106,7 +264,10 @@ pub struct BrowsingContext<C: RenderConfiguration = crate::html::DefaultRenderCo
     /// Current scroll offset in CSS pixels.
     scroll_x: f64,
     scroll_y: f64,
-    /// True when only the scroll offset changed (no full re-layout needed).
+    /// Direction of the last vertical scroll (1.0 down, -1.0 up); steers background tile fill-in.
+    scroll_dir: f64,
+    /// True when the cached tiles only need re-compositing: the scroll offset changed, or a
+    /// background fill-in batch landed (no full re-layout needed).
     scroll_dirty: bool,
 
     /// Cached rasterized tiles for the full page. Valid until render_dirty is set.
@@ -128,6 +289,13 @@ pub struct BrowsingContext<C: RenderConfiguration = crate::html::DefaultRenderCo
     hover_layout_element: Option<LayoutElementId>,
     /// Cached :hover fingerprints for the current document; rebuilt on document change.
     hover_fingerprints: Option<HoverFingerprints>,
+    /// Whether the current document uses viewport-relative lengths; computed on first need and
+    /// reset on document change.
+    viewport_units: Option<bool>,
+    /// Viewport size (width, height) the pipeline cache was last laid out at.
+    layout_viewport: (u32, u32),
+    /// Display list of the pipeline cache a resize dropped, kept for the rebuild that follows.
+    resized_display_list: Option<Arc<DisplayList>>,
     /// True when the last hover chain contained a fingerprint-sensitive node.
     hover_chain_sensitive: bool,
     /// The href of the link currently under the pointer, if any.
@@ -135,7 +303,7 @@ pub struct BrowsingContext<C: RenderConfiguration = crate::html::DefaultRenderCo
 
     /// The active backend's per-tile rasterizer and how to drive it. Built once by the tab
     /// worker from the engine's `RenderBackend` (replacing the former per-backend cfg cascade).
-    rasterizer: Option<Box<dyn Rasterable + Send + Sync>>,
+    rasterizer: Option<Arc<dyn Rasterable + Send + Sync>>,
     raster_strategy: RasterStrategy,
 
     /// Media store shared between the layout and rasterization stages. The layouter loads
@@ -143,9 +311,29 @@ pub struct BrowsingContext<C: RenderConfiguration = crate::html::DefaultRenderCo
     /// across renders so paint-only repaints (e.g. hover) still find previously loaded media.
     media_store: std::sync::Arc<gosub_render_pipeline::common::media::MediaStore>,
 
+    /// Rasterized tile pixels kept across renders, so tiles whose content did not change are
+    /// not rasterized again. Bounded by the tab's and the zone's tile-cache budgets (see
+    /// [`Self::set_tile_cache_budget`]); unbounded until the worker sets them.
+    tile_cache: Arc<TilePixelCache>,
+
+    /// Layouter kept across renders so its taffy tree (and taffy's per-node layout cache)
+    /// survives: relayout only recomputes what changed. Created on first use with the
+    /// rasterizer's font system; dropped when the document or rasterizer changes.
+    layouter: Option<TaffyLayouter>,
+
     /// Per-engine settings store (cloned from the zone/engine). Read settings or subscribe to
     /// changes via [`HasConfig::config`].
     config_store: Config,
+
+    /// Resolve styles on the rayon pool, rather than in one walk on this thread, before building
+    /// the render tree (per-zone setting).
+    parallel_style: bool,
+
+    /// Style caches of the document the tile pipeline last rendered. An incremental rebuild
+    /// starts from these and restyles only the damaged subtrees.
+    styles: Option<Arc<GosubDocumentAdapter<C>>>,
+    /// DOM damage reported through [`Self::apply_dom_damage`] since the last rebuild.
+    pending_damage: Vec<(NodeId, DomDamage)>,
 }
 
 impl<C: RenderConfiguration> BrowsingContext<C> {
@@ -163,6 +351,7 @@ impl<C: RenderConfiguration> BrowsingContext<C> {
             layout_dirty: false,
             scroll_x: 0.0,
             scroll_y: 0.0,
+            scroll_dir: 1.0,
             scroll_dirty: false,
             pipeline_cache: None,
             scene_cache: None,
@@ -172,12 +361,20 @@ impl<C: RenderConfiguration> BrowsingContext<C> {
             hover_dirty_nodes: Vec::new(),
             hover_layout_element: None,
             hover_fingerprints: None,
+            viewport_units: None,
+            layout_viewport: (0, 0),
+            resized_display_list: None,
             hover_chain_sensitive: false,
             hover_link_url: None,
             rasterizer: None,
+            layouter: None,
             raster_strategy: RasterStrategy::None,
             media_store: std::sync::Arc::new(gosub_render_pipeline::common::media::MediaStore::new()),
+            tile_cache: Arc::new(TilePixelCache::default()),
             config_store,
+            parallel_style: false,
+            styles: None,
+            pending_damage: Vec::new(),
         }
     }
 
@@ -189,8 +386,41 @@ impl<C: RenderConfiguration> BrowsingContext<C> {
     /// Installs the active backend's per-tile rasterizer and raster strategy. Called once by the
     /// tab worker from `RenderBackend::create_rasterizer` / `raster_strategy`.
     pub fn set_rasterizer(&mut self, rasterizer: Box<dyn Rasterable + Send + Sync>, strategy: RasterStrategy) {
-        self.rasterizer = Some(rasterizer);
+        self.rasterizer = Some(Arc::from(rasterizer));
         self.raster_strategy = strategy;
+        // The layouter measures text with the rasterizer's font system.
+        self.layouter = None;
+    }
+
+    /// Bounds the tile-pixel cache to `tab_limit_bytes`, and to `zone_budget` together with the
+    /// other tabs of the zone. Starts from an empty cache.
+    pub fn set_tile_cache_budget(&mut self, tab_limit_bytes: u64, zone_budget: Arc<TileCacheBudget>) {
+        self.tile_cache = Arc::new(TilePixelCache::new(tab_limit_bytes, Some(zone_budget)));
+    }
+
+    /// Routes the media store's background loads through `fetcher`, keeping at most
+    /// `max_per_origin` of them in flight per origin.
+    pub fn set_media_fetcher(
+        &mut self,
+        fetcher: Arc<dyn gosub_render_pipeline::common::media::MediaFetcher>,
+        max_per_origin: usize,
+    ) {
+        self.media_store.set_fetcher(fetcher);
+        self.media_store.set_max_fetches_per_origin(max_per_origin);
+    }
+
+    /// Forgets the media loads the previous document started, so they neither hold up nor get
+    /// cached for the next one (see [`MediaStore::abandon_loads`]). The media store itself, and
+    /// everything it already loaded, outlives the navigation.
+    ///
+    /// [`MediaStore::abandon_loads`]: gosub_render_pipeline::common::media::MediaStore::abandon_loads
+    pub fn abandon_media_loads(&self) {
+        self.media_store.abandon_loads();
+    }
+
+    /// Selects parallel (rayon) or lazy on-demand style resolution for subsequent renders.
+    pub fn set_parallel_style(&mut self, on: bool) {
+        self.parallel_style = on;
     }
 
     /// Binds the storage handles to the browsing context (@TODO: Why not via the ::new()?).
@@ -212,14 +442,118 @@ impl<C: RenderConfiguration> BrowsingContext<C> {
         self.layout_dirty = true;
         self.invalidate_render();
         self.pipeline_cache = None;
+        self.resized_display_list = None;
         self.scene_cache = None;
+        self.styles = None;
+        self.pending_damage.clear();
+        self.layouter = None;
         self.hover_dirty = false;
         self.hover_leaf = None;
         self.hover_layout_element = None;
         self.hover_fingerprints = None;
+        self.viewport_units = None;
         self.hover_chain_sensitive = false;
     }
 
+    /// Swaps in `doc`, a mutated version of the current document, invalidating only what
+    /// `damage` covers (see [`Document::take_damage`](gosub_interface::document::Document::take_damage)).
+    /// The next rebuild restyles the damaged subtrees, reruns layout only if some damage goes
+    /// beyond paint, and re-rasterizes only the tiles that overlap boxes that changed. Without a
+    /// previous render to start from this is the same as [`Self::set_document`].
+    pub fn apply_dom_damage(&mut self, doc: Arc<EngineDocument<C>>, damage: &[(NodeId, DomDamage)]) {
+        if self.document.is_none() || self.pipeline_cache.is_none() {
+            self.set_document(doc);
+            return;
+        }
+        if damage.is_empty() {
+            return;
+        }
+
+        self.document = Some(doc);
+        self.pending_damage.extend_from_slice(damage);
+        self.dom_dirty = true;
+        if damage.iter().any(|(_, d)| *d == DomDamage::Style) {
+            self.style_dirty = true;
+        }
+        if damage.iter().any(|(_, d)| *d >= DomDamage::Layout) {
+            self.layout_dirty = true;
+        }
+        // Hover fingerprints and the viewport-unit check were computed against the previous document.
+        self.hover_fingerprints = None;
+        self.viewport_units = None;
+    }
+
+    /// Runs `mutate` against the current document and schedules the incremental rebuild for
+    /// what it touched: damage tracking is switched on for the edit and the recorded damage goes
+    /// to [`Self::apply_dom_damage`]. The previous render first lets go of the document (see
+    /// [`Self::release_document`]), so the edit happens in place; only a document still shared
+    /// elsewhere is copied. Returns `None` (without calling `mutate`) when no document has been
+    /// loaded yet.
+    pub fn mutate_document<R>(&mut self, mutate: impl FnOnce(&mut EngineDocument<C>) -> R) -> Option<R>
+    where
+        EngineDocument<C>: Clone,
+    {
+        self.document.as_ref()?;
+        if !self.release_document() {
+            log::debug!("Document is still shared with an older render; editing a copy");
+        }
+        let doc = self.document.as_mut()?;
+        let edit = Arc::make_mut(doc);
+        edit.track_damage(true);
+        let out = mutate(edit);
+        let damage = edit.take_damage();
+        let doc = Arc::clone(doc);
+        if damage.is_empty() && (self.pipeline_cache.is_some() || self.scene_cache.is_some()) {
+            // Nothing to restyle, but the render no longer points at the document: the rebuild
+            // carries every tile over and points it back.
+            self.dom_dirty = true;
+        }
+        self.apply_dom_damage(doc, &damage);
+        Some(out)
+    }
+
+    /// Commits the DOM edits queued in `queue` (see [`DocumentTaskQueue::flush`]) through
+    /// [`Self::mutate_document`], so they are rendered incrementally. Returns the errors of the
+    /// tasks that could not be applied.
+    pub fn apply_document_tasks(&mut self, queue: &mut DocumentTaskQueue) -> Vec<String>
+    where
+        EngineDocument<C>: Clone,
+    {
+        self.mutate_document(|doc| queue.flush::<C>(doc)).unwrap_or_default()
+    }
+
+    /// Makes the document's only owner this context, so it can be edited without a copy. The
+    /// previous render keeps what the incremental rebuild starts from - tiles, boxes, paint
+    /// commands and the resolved styles - but its render tree is pointed at an adapter over an
+    /// empty placeholder document, which takes over the styles. Until the rebuild, hit-testing
+    /// finds no DOM node under the pointer. Returns false if some reference could not be dropped.
+    fn release_document(&mut self) -> bool {
+        if self.document.as_ref().is_some_and(|doc| Arc::strong_count(doc) == 1) {
+            return true;
+        }
+        // Painted from the old version of the document, so a later rebuild can't reuse it anyway.
+        self.resized_display_list = None;
+
+        let placeholder = Arc::new(EngineDocument::<C>::new(DocumentType::HTML, None));
+        let detached = Arc::new(match &self.styles {
+            Some(styles) => GosubDocumentAdapter::with_styles_taken_from(placeholder, styles),
+            None => GosubDocumentAdapter::new(placeholder),
+        });
+        if self.styles.is_some() {
+            self.styles = Some(Arc::clone(&detached));
+        }
+        let detached: Arc<dyn PipelineDocument> = detached;
+        if let Some(mut cache) = self.pipeline_cache.take() {
+            cache.finish_fill();
+            let (cache, _) = cache.retarget_document(Arc::clone(&detached));
+            self.pipeline_cache = Some(cache);
+        }
+        if let Some(scene) = self.scene_cache.as_mut() {
+            LayerList::retarget_document(&mut scene.layer_list, detached);
+        }
+        self.document.as_ref().is_some_and(|doc| Arc::strong_count(doc) == 1)
+    }
+
     /// Update the viewport SIZE. Only triggers a full re-layout when width or height changes.
     /// Scroll offset is managed separately via `set_scroll`.
     pub fn set_viewport(&mut self, vp: Viewport) {
@@ -230,7 +564,9 @@ impl<C: RenderConfiguration> BrowsingContext<C> {
         self.viewport.height = vp.height;
         self.layout_dirty = true;
         self.invalidate_render();
-        self.pipeline_cache = None;
+        if let Some(cache) = self.pipeline_cache.take() {
+            self.resized_display_list = Some(cache.display_list);
+        }
         self.scene_cache = None;
     }
 
@@ -246,9 +582,27 @@ impl<C: RenderConfiguration> BrowsingContext<C> {
         if (self.scroll_x - x).abs() < 0.5 && (self.scroll_y - y).abs() < 0.5 {
             return;
         }
+        if y != self.scroll_y {
+            self.scroll_dir = (y - self.scroll_y).signum();
+        }
         self.scroll_x = x;
         self.scroll_y = y;
         self.scroll_dirty = true;
+        let visible = self.visible_page_rect();
+        self.tile_cache.set_viewport(visible);
+        if let Some(fill) = self.pipeline_cache.as_ref().and_then(|c| c.fill.as_ref()) {
+            fill.set_viewport(visible, self.scroll_dir);
+        }
+    }
+
+    /// The viewport in page coordinates.
+    fn visible_page_rect(&self) -> gosub_render_pipeline::common::geo::Rect {
+        gosub_render_pipeline::common::geo::Rect::new(
+            self.scroll_x,
+            self.scroll_y,
+            self.viewport.width as f64,
+            self.viewport.height as f64,
+        )
     }
 
     /// Reset scroll to the top (called on navigation).
@@ -284,32 +638,132 @@ impl<C: RenderConfiguration> BrowsingContext<C> {
         }
     }
 
-    /// Full pipeline rebuild (stages 1–6): re-tiles and re-rasterizes the whole page,
-    /// carrying over the previous tile-pixel cache, then clears the content dirty flags.
+    /// Poll the background tile fill-in started by the last full render. Batches that finished
+    /// since the last call are merged into the pipeline cache; when there were any, the cached
+    /// tiles are flagged for re-compositing and `true` is returned so the caller can wake its
+    /// draw loop.
+    pub fn poll_raster_fill(&mut self) -> bool {
+        let Some(cache) = self.pipeline_cache.as_mut() else {
+            return false;
+        };
+        let Some(fill) = cache.fill.as_ref() else {
+            return false;
+        };
+        let (batches, done) = fill.try_take();
+        if done {
+            cache.fill = None;
+        }
+        if batches.is_empty() {
+            return false;
+        }
+        cache.merge_fill(batches);
+        self.scroll_dirty = true;
+        true
+    }
+
+    /// Full pipeline rebuild (stages 1–6): re-tiles and re-rasterizes the whole page through
+    /// the tab's tile-pixel cache, then clears the content dirty flags.
     /// Shared by [`Self::rebuild_pipeline_cache_if_needed`] and
     /// [`Self::rebuild_render_list_if_needed`].
+    ///
+    /// When the document is the one the cache was built from (a resize, a relayout after media
+    /// loaded), the previous display list is handed to the painter, which keeps the commands of
+    /// every element whose box and content came out the same.
     fn rebuild_full_pipeline(&mut self) {
-        if let Some(doc) = &self.document {
-            let prev_tile_cache = self
-                .pipeline_cache
-                .as_mut()
-                .map(|c| std::mem::take(&mut c.tile_pixel_cache))
-                .unwrap_or_default();
+        if let Some(doc) = self.document.clone() {
+            // A new layout supersedes whatever the previous render was still filling in.
+            if let Some(c) = self.pipeline_cache.as_mut() {
+                c.fill = None;
+            }
+            let prev_display_list = self.reusable_display_list(&doc);
+            let styles = Arc::new(GosubDocumentAdapter::new(doc));
+            self.styles = Some(Arc::clone(&styles));
+            let layouter = persistent_layouter(&mut self.layouter, self.rasterizer.as_deref(), &self.media_store);
+            let visible = self.visible_page_rect();
+            self.tile_cache.set_viewport(visible);
             self.pipeline_cache = Some(pipeline_build_cache(
-                doc.clone(),
+                styles,
+                layouter,
                 &self.viewport,
-                self.rasterizer.as_deref(),
+                visible,
+                self.scroll_dir,
+                self.rasterizer.as_ref(),
                 self.raster_strategy,
-                prev_tile_cache,
+                &self.tile_cache,
                 self.media_store.clone(),
                 self.config_store.get_uint("renderer.tile.size") as f64,
+                self.parallel_style,
+                prev_display_list.as_deref(),
             ));
+            self.layout_viewport = (self.viewport.width, self.viewport.height);
+        }
+        self.clear_content_dirty();
+    }
+
+    /// The cached display list, if a full rebuild of `doc` may start from it. Elements are
+    /// matched by node id, so only a list painted from this same document qualifies; a pending
+    /// hover change alters paint without changing any box, and viewport-relative lengths can
+    /// change paint (e.g. a `border-radius` in `vw`) without changing the box either.
+    fn reusable_display_list(&mut self, doc: &Arc<EngineDocument<C>>) -> Option<Arc<DisplayList>> {
+        let resized = self.resized_display_list.take();
+        if self.hover_dirty || !self.styles.as_ref().is_some_and(|s| Arc::ptr_eq(&s.doc, doc)) {
+            return None;
         }
+        let display_list = match &self.pipeline_cache {
+            Some(cache) => Arc::clone(&cache.display_list),
+            None => resized?,
+        };
+        if self.layout_viewport != (self.viewport.width, self.viewport.height)
+            && *self.viewport_units.get_or_insert_with(|| uses_viewport_units(doc))
+        {
+            return None;
+        }
+        Some(display_list)
+    }
+
+    fn clear_content_dirty(&mut self) {
         self.render_dirty = false;
         self.hover_dirty = false;
         self.dom_dirty = false;
         self.style_dirty = false;
         self.layout_dirty = false;
+        self.pending_damage.clear();
+    }
+
+    /// Incremental rebuild after [`Self::apply_dom_damage`]. Falls back to a full rebuild when
+    /// there is no previous render to start from.
+    fn rebuild_damaged_pipeline(&mut self) {
+        let (Some(doc), Some(styles), Some(mut prev)) =
+            (self.document.clone(), self.styles.clone(), self.pipeline_cache.take())
+        else {
+            self.rebuild_full_pipeline();
+            return;
+        };
+        // Tiles are carried over from `prev`; the ones its fill never delivered are queued again.
+        let unfilled = prev.stop_fill();
+
+        let layouter = persistent_layouter(&mut self.layouter, self.rasterizer.as_deref(), &self.media_store);
+        let visible = self.visible_page_rect();
+        let (cache, styles) = pipeline_rebuild_damaged(
+            doc,
+            &styles,
+            layouter,
+            prev,
+            unfilled,
+            &self.pending_damage,
+            &self.viewport,
+            visible,
+            self.scroll_dir,
+            self.rasterizer.as_ref(),
+            self.raster_strategy,
+            &self.tile_cache,
+            self.media_store.clone(),
+            self.config_store.get_uint("renderer.tile.size") as f64,
+            self.parallel_style,
+        );
+        self.pipeline_cache = Some(cache);
+        self.styles = Some(styles);
+        self.clear_content_dirty();
     }
 
     /// Rebuild stages 1-6 (pipeline cache) if content has changed, without building a display
@@ -319,50 +773,71 @@ impl<C: RenderConfiguration> BrowsingContext<C> {
     /// Two paths:
     /// - **Full pipeline** (`render_dirty`): runs stages 1–6 for the whole page and caches
     ///   tiles. Triggered by navigation, DOM/style changes, or viewport resize.
+    /// - **Damage rebuild** (`dom_dirty`): restyles the damaged subtrees and re-rasterizes only
+    ///   the tiles over boxes that changed. See [`Self::apply_dom_damage`].
     /// - **Paint-only repaint** (`hover_dirty`): reuses the cached layout tree and repaints
     ///   only the affected tiles, skipping stages 1–2.
     pub fn rebuild_pipeline_cache_if_needed(&mut self) {
-        if !self.render_dirty && !self.hover_dirty && !self.scroll_dirty {
+        if !self.render_dirty && !self.dom_dirty && !self.hover_dirty && !self.scroll_dirty {
             return;
         }
         if self.render_dirty {
             self.rebuild_full_pipeline();
+        } else if self.dom_dirty {
+            self.rebuild_damaged_pipeline();
         } else if self.hover_dirty {
             // Paint-only repaint: reuse the cached layout tree, skip stages 1–2.
-            if let Some(old_cache) = self.pipeline_cache.take() {
+            if let Some(mut old_cache) = self.pipeline_cache.take() {
+                let unfilled = old_cache.stop_fill();
+                let visible = self.visible_page_rect();
                 let PipelineCache {
                     layer_list,
+                    display_list,
                     page_height,
-                    tile_pixel_cache: prev_tile_cache,
                     tiles: prev_baked_tiles,
                     ..
                 } = old_cache;
                 self.pipeline_cache = Some(pipeline_hover_repaint(
                     layer_list,
+                    display_list,
                     page_height,
                     prev_baked_tiles,
+                    unfilled,
                     self.hover_old_lei,
                     self.hover_layout_element,
                     &self.hover_dirty_nodes,
                     &self.viewport,
-                    self.rasterizer.as_deref(),
+                    visible,
+                    self.scroll_dir,
+                    self.rasterizer.as_ref(),
                     self.raster_strategy,
-                    prev_tile_cache,
+                    &self.tile_cache,
                     self.media_store.clone(),
                     self.config_store.get_uint("renderer.tile.size") as f64,
                 ));
             } else {
                 // No cached layout yet - fall back to a full rebuild.
                 if let Some(doc) = &self.document {
+                    let styles = Arc::new(GosubDocumentAdapter::new(doc.clone()));
+                    self.styles = Some(Arc::clone(&styles));
+                    let visible = self.visible_page_rect();
+                    let layouter =
+                        persistent_layouter(&mut self.layouter, self.rasterizer.as_deref(), &self.media_store);
                     self.pipeline_cache = Some(pipeline_build_cache(
-                        doc.clone(),
+                        styles,
+                        layouter,
                         &self.viewport,
-                        self.rasterizer.as_deref(),
+                        visible,
+                        self.scroll_dir,
+                        self.rasterizer.as_ref(),
                         self.raster_strategy,
-                        std::collections::HashMap::new(),
+                        &self.tile_cache,
                         self.media_store.clone(),
                         self.config_store.get_uint("renderer.tile.size") as f64,
+                        self.parallel_style,
+                        None,
                     ));
+                    self.layout_viewport = (self.viewport.width, self.viewport.height);
                 }
             }
             self.hover_dirty = false;
@@ -379,12 +854,14 @@ impl<C: RenderConfiguration> BrowsingContext<C> {
     /// - **Scroll composite** (`scroll_dirty`): re-composites visible tiles from the cache with
     ///   the new scroll offset. No layout or rasterization work.
     pub fn rebuild_render_list_if_needed(&mut self) {
-        if !self.render_dirty && !self.scroll_dirty {
+        if !self.render_dirty && !self.dom_dirty && !self.scroll_dirty {
             return;
         }
 
         if self.render_dirty {
             self.rebuild_full_pipeline();
+        } else if self.dom_dirty {
+            self.rebuild_damaged_pipeline();
         }
 
         let mut rl = RenderList::default();
@@ -414,26 +891,25 @@ impl<C: RenderConfiguration> BrowsingContext<C> {
     /// don't rebuild anything (the backend re-renders with a new translate); they just advance the
     /// scene epoch so the worker emits a frame.
     pub fn rebuild_scene_cache_if_needed(&mut self) {
-        if !self.render_dirty && !self.hover_dirty && !self.scroll_dirty {
+        if !self.render_dirty && !self.dom_dirty && !self.hover_dirty && !self.scroll_dirty {
             return;
         }
-        // Both content changes and hover-style changes rebuild the command list. Hover could reuse
-        // the cached layout (it only changes paint), but a GPU re-paint is cheap and avoids the
-        // tile path's hover-repaint bookkeeping; revisit if hover proves hot.
-        if self.render_dirty || self.hover_dirty {
+        // Content, DOM-damage and hover-style changes all rebuild the command list. They could
+        // reuse the cached layout, but a GPU re-paint is cheap and avoids the tile path's
+        // damage bookkeeping; revisit if this proves hot.
+        if self.render_dirty || self.dom_dirty || self.hover_dirty {
             if let Some(doc) = &self.document {
+                let layouter = persistent_layouter(&mut self.layouter, self.rasterizer.as_deref(), &self.media_store);
                 self.scene_cache = Some(pipeline_build_scene(
                     doc.clone(),
+                    layouter,
                     &self.viewport,
                     self.rasterizer.as_deref(),
                     self.media_store.clone(),
+                    self.parallel_style,
                 ));
             }
-            self.render_dirty = false;
-            self.hover_dirty = false;
-            self.dom_dirty = false;
-            self.style_dirty = false;
-            self.layout_dirty = false;
+            self.clear_content_dirty();
         }
         self.scroll_dirty = false;
         self.scene_epoch = self.scene_epoch.wrapping_add(1);
@@ -462,7 +938,7 @@ impl<C: RenderConfiguration> BrowsingContext<C> {
     ///
     /// Calling this consumes the scroll-dirty flag and advances the scene epoch.
     pub fn take_scroll_handle(&mut self, dpr: u32) -> Option<ExternalHandle> {
-        if !self.scroll_dirty || self.render_dirty || self.hover_dirty {
+        if !self.scroll_dirty || self.render_dirty || self.dom_dirty || self.hover_dirty {
             return None;
         }
         let cache = self.pipeline_cache.as_ref()?;
@@ -510,6 +986,32 @@ impl<C: RenderConfiguration> BrowsingContext<C> {
             .unwrap_or_default()
     }
 
+    /// Checks that the GPU tiles in and around the viewport are still resident: the backend pins
+    /// only those, and may have evicted the rest of the page under memory pressure. When some are
+    /// gone, the render is invalidated so the next rebuild rasterizes them again (tiles still
+    /// resident come from the tile cache), and `true` is returned.
+    pub fn recover_evicted_gpu_tiles(&mut self) -> bool {
+        use gosub_render_pipeline::render::backend::anchored_tile_pos;
+
+        let (Some(cache), Some(rasterizer)) = (&self.pipeline_cache, &self.rasterizer) else {
+            return false;
+        };
+        let (vw, vh) = (self.viewport.width as f64, self.viewport.height as f64);
+        let evicted = cache.tiles.iter().any(|t| {
+            let TilePixels::Gpu(id) = t.pixels else {
+                return false;
+            };
+            let (x, y) = anchored_tile_pos(t.page_x, t.page_y, self.scroll_x, self.scroll_y, t.anchor);
+            let near = x + f64::from(t.width) > 0.0 && x < vw && y + f64::from(t.height) > -vh && y < 2.0 * vh;
+            near && !rasterizer.retain_gpu_tile(id)
+        });
+        if evicted {
+            log::debug!("GPU tiles near the viewport were evicted; rasterizing them again");
+            self.invalidate_render();
+        }
+        evicted
+    }
+
     /// Current scroll offset in CSS pixels.
     pub fn scroll_xy(&self) -> (f64, f64) {
         (self.scroll_x, self.scroll_y)
@@ -666,19 +1168,56 @@ impl<C: RenderConfiguration> RenderContext for BrowsingContext<C> {
     }
 }
 
+/// The layouter kept in `slot`, created on first use.
+///
+/// It shares the rasterizer's font system so layout and rendering measure/draw against the
+/// same font collection. Backends without a FontSystem (null, Cairo/Pango) fall back to the
+/// layouter's own instance. It also shares the persistent media store so resources loaded
+/// during layout are visible to the rasterizer (which resolves them by id); otherwise every
+/// image renders as a placeholder.
+fn persistent_layouter<'a>(
+    slot: &'a mut Option<TaffyLayouter>,
+    rasterizer: Option<&(dyn Rasterable + Send + Sync)>,
+    media_store: &Arc<gosub_render_pipeline::common::media::MediaStore>,
+) -> &'a mut TaffyLayouter {
+    let layouter = slot.get_or_insert_with(|| match rasterizer.and_then(|r| r.font_system()) {
+        Some(font_system) => TaffyLayouter::with_font_system(font_system),
+        None => TaffyLayouter::new(),
+    });
+    layouter.set_media_store(Arc::clone(media_store));
+    layouter
+}
+
+/// Resolves every element's styles ahead of render-tree construction, in one tree walk that
+/// carries the ancestor filter down instead of rebuilding it per element. With `parallel` the
+/// walk forks onto the rayon pool; the CSS viewport is thread-local in gosub_css3, so each worker
+/// task re-applies this thread's.
+fn resolve_styles<C: RenderConfiguration>(
+    adapter: &gosub_render_pipeline::common::document::pipeline_doc::GosubDocumentAdapter<C>,
+    viewport: &Viewport,
+    parallel: bool,
+) {
+    if !parallel {
+        adapter.resolve_styles();
+        return;
+    }
+    let (width, height) = (viewport.width as f32, viewport.height as f32);
+    adapter.resolve_styles_parallel(&move || gosub_css3::stylesheet::set_layout_viewport(width, height));
+}
+
 /// GPU-scene build: stages 1–3 (render tree → layout → layering) plus a paint pass over every
 /// element, producing one ordered paint-command list for the whole page. Skips tiling,
 /// rasterization, and compositing - the backend renders the commands into a GPU texture.
 fn pipeline_build_scene<C: RenderConfiguration>(
     doc: Arc<EngineDocument<C>>,
+    layouter: &mut TaffyLayouter,
     viewport: &Viewport,
     rasterizer: Option<&(dyn Rasterable + Send + Sync)>,
     media_store: Arc<gosub_render_pipeline::common::media::MediaStore>,
+    parallel_style: bool,
 ) -> SceneCache {
     use gosub_render_pipeline::common::browser_state::{BrowserState, WireframeState};
-    use gosub_render_pipeline::common::document::pipeline_doc::GosubDocumentAdapter;
     use gosub_render_pipeline::common::geo::{Dimension as PipelineDimension, Rect as PipelineRect};
-    use gosub_render_pipeline::layouter::taffy::TaffyLayouter;
     use gosub_render_pipeline::layouter::CanLayout;
     use gosub_render_pipeline::rendertree_builder::RenderTree;
 
@@ -688,6 +1227,7 @@ fn pipeline_build_scene<C: RenderConfiguration>(
 
     // Stage 1: render tree
     let adapter = GosubDocumentAdapter::<C>::new(doc);
+    resolve_styles(&adapter, viewport, parallel_style);
     let mut render_tree = RenderTree::new(Arc::new(adapter));
     if let Err(e) = render_tree.parse() {
         log::error!("Failed to build render tree: {e}");
@@ -699,12 +1239,7 @@ fn pipeline_build_scene<C: RenderConfiguration>(
         None
     };
 
-    // Stage 2: layout (share the rasterizer's font system, as the tile path does)
-    let mut layouter = match rasterizer.and_then(|r| r.font_system()) {
-        Some(font_system) => TaffyLayouter::with_font_system(font_system),
-        None => TaffyLayouter::new(),
-    };
-    layouter.set_media_store(Arc::clone(&media_store));
+    // Stage 2: layout
     let layout_tree = layouter.layout(render_tree, vp_dim, 1.0);
     let page_height = layout_tree.root_dimension.height;
 
@@ -744,20 +1279,32 @@ fn pipeline_build_scene<C: RenderConfiguration>(
 ///
 /// Splitting the full pipeline from compositing lets scroll re-use the cached tiles without
 /// re-running layout or rasterization.
+///
+/// With the parallel strategy only the tiles under `visible` (the viewport in page coordinates)
+/// are rasterized before returning, so the first frame can go out right away; the rest of the
+/// page is filled in by the cache's [`RasterFill`], nearest the viewport and in `scroll_dir`
+/// first.
+///
+/// `prev_display_list` is the display list of an earlier render of the same document; elements
+/// that lay out and paint the same keep their commands from it instead of being repainted.
+#[allow(clippy::too_many_arguments)]
 fn pipeline_build_cache<C: RenderConfiguration>(
-    doc: Arc<EngineDocument<C>>,
+    styles: Arc<GosubDocumentAdapter<C>>,
+    layouter: &mut TaffyLayouter,
     viewport: &Viewport,
-    rasterizer: Option<&(dyn Rasterable + Send + Sync)>,
+    visible: gosub_render_pipeline::common::geo::Rect,
+    scroll_dir: f64,
+    rasterizer: Option<&Arc<dyn Rasterable + Send + Sync>>,
     strategy: RasterStrategy,
-    prev_tile_cache: TilePixelCache,
+    tile_cache: &Arc<TilePixelCache>,
     media_store: Arc<gosub_render_pipeline::common::media::MediaStore>,
     tile_size: f64,
+    parallel_style: bool,
+    prev_display_list: Option<&DisplayList>,
 ) -> PipelineCache {
     use gosub_render_pipeline::common::browser_state::{BrowserState, WireframeState};
-    use gosub_render_pipeline::common::document::pipeline_doc::GosubDocumentAdapter;
     use gosub_render_pipeline::common::geo::{Dimension as PipelineDimension, Rect as PipelineRect};
     use gosub_render_pipeline::layering::layer::LayerList;
-    use gosub_render_pipeline::layouter::taffy::TaffyLayouter;
     use gosub_render_pipeline::layouter::CanLayout;
     use gosub_render_pipeline::painter::Painter;
     use gosub_render_pipeline::rendertree_builder::RenderTree;
@@ -771,9 +1318,11 @@ fn pipeline_build_cache<C: RenderConfiguration>(
     gosub_css3::stylesheet::set_layout_viewport(viewport.width as f32, viewport.height as f32);
 
     // Stage 1: render tree
+    let ts_style = timing_start!("pipeline.style");
+    resolve_styles(&styles, viewport, parallel_style);
+    timing_stop!(ts_style);
     let ts1 = timing_start!("pipeline.render_tree");
-    let adapter = GosubDocumentAdapter::<C>::new(doc);
-    let mut render_tree = RenderTree::new(Arc::new(adapter));
+    let mut render_tree = RenderTree::new(styles);
     if let Err(e) = render_tree.parse() {
         // The layouter tolerates a tree without a root; the frame degrades to empty.
         log::error!("Failed to build render tree: {e}");
@@ -788,16 +1337,6 @@ fn pipeline_build_cache<C: RenderConfiguration>(
 
     // Stage 2: layout
     let ts2 = timing_start!("pipeline.layout");
-    // Share the rasterizer's font system so layout and rendering measure/draw against the
-    // same font collection (and it's created once, not per layout pass). Backends without a
-    // FontSystem (null, Cairo/Pango) fall back to the layouter's own instance.
-    let mut layouter = match rasterizer.and_then(|r| r.font_system()) {
-        Some(font_system) => TaffyLayouter::with_font_system(font_system),
-        None => TaffyLayouter::new(),
-    };
-    // Share the persistent media store so resources loaded during layout are visible to the
-    // rasterizer (which resolves them by id). Otherwise every image renders as a placeholder.
-    layouter.set_media_store(Arc::clone(&media_store));
     let layout_tree = layouter.layout(render_tree, vp_dim, 1.0);
     timing_stop!(ts2);
     let page_height = layout_tree.root_dimension.height;
@@ -834,7 +1373,15 @@ fn pipeline_build_cache<C: RenderConfiguration>(
         tile_list: None,
         dpi_scale_factor: 1.0,
     };
+    // Each element is painted once into the display list; its tiles share slices of it. Elements
+    // that come out of layout unchanged keep their commands from `prev_display_list`.
     let painter = Painter::new(tile_list.layer_list.clone(), rasterizer.and_then(|r| r.font_system()));
+    let display_list = Arc::new(DisplayList::build(
+        &painter,
+        &paint_state,
+        prev_display_list,
+        &HashSet::new(),
+    ));
     for &layer_id in &layer_ids {
         let tile_ids = tile_list.get_intersecting_tiles(layer_id, full_page_rect);
         for tile_id in tile_ids {
@@ -845,7 +1392,7 @@ fn pipeline_build_cache<C: RenderConfiguration>(
                 continue;
             }
             for tiled_element in &mut tile.elements {
-                tiled_element.paint_commands = painter.paint(tiled_element, &paint_state);
+                tiled_element.paint_commands = display_list.slice(tiled_element.id);
             }
         }
     }
@@ -855,20 +1402,43 @@ fn pipeline_build_cache<C: RenderConfiguration>(
     // runtime by the engine's RenderBackend; no per-backend cfg here). Vello stays
     // sequential because all tiles share a Mutex<Renderer>; batching (not parallelism)
     // is the fix there.
-    let (baked_tiles, new_tile_cache) = match (strategy, rasterizer) {
-        (RasterStrategy::ParallelCached, Some(rasterizer)) => rasterize_parallel(
-            rasterizer,
+    //
+    // The parallel strategy rasterizes the viewport now and hands the rest of the page to a
+    // background fill; the tile list moves to the fill thread with it.
+    let mut fill = None;
+    let mut unfilled = HashSet::new();
+    let baked_tiles = match (strategy, rasterizer) {
+        (RasterStrategy::ParallelCached, Some(rasterizer)) => {
+            let (now, later) = split_viewport_tiles(&tile_list, &layer_ids, full_page_rect, visible);
+            let first = rasterize_tiles(
+                rasterizer.as_ref(),
+                &mut tile_list,
+                &now,
+                &media_store,
+                tile_cache,
+                "pipeline.rasterize",
+            );
+            unfilled = tile_keys(&tile_list, &later);
+            fill = RasterFill::spawn(
+                Arc::clone(rasterizer),
+                tile_list,
+                later,
+                Arc::clone(&media_store),
+                Arc::clone(tile_cache),
+                visible,
+                scroll_dir,
+            );
+            first
+        }
+        (RasterStrategy::Sequential, Some(rasterizer)) => rasterize_sequential(
+            rasterizer.as_ref(),
             &layer_ids,
             &mut tile_list,
             full_page_rect,
             &media_store,
-            &prev_tile_cache,
-            "pipeline.rasterize",
+            tile_cache,
         ),
-        (RasterStrategy::Sequential, Some(rasterizer)) => {
-            rasterize_sequential(rasterizer, &layer_ids, &mut tile_list, full_page_rect, &media_store)
-        }
-        _ => (Vec::new(), std::collections::HashMap::new()),
+        _ => Vec::new(),
     };
 
     timing_stop!(ts_total);
@@ -881,32 +1451,212 @@ fn pipeline_build_cache<C: RenderConfiguration>(
         page_height,
         cached_tiles,
         layer_list: saved_layer_list,
-        tile_pixel_cache: new_tile_cache,
+        display_list,
+        fill,
+        unfilled,
     }
 }
 
+/// [`tile_key`]s of `ids` in `tile_list`.
+fn tile_keys(
+    tile_list: &gosub_render_pipeline::tiler::TileList,
+    ids: &[gosub_render_pipeline::tiler::TileId],
+) -> HashSet<TileKey> {
+    ids.iter()
+        .filter_map(|id| tile_list.arena.get(id))
+        .map(|t| tile_key(t.rect, t.layer_id.as_u64()))
+        .collect()
+}
+
+/// Incremental rebuild after DOM mutations: restyles only the subtrees `damage` points at,
+/// reruns layout only when some damage goes beyond paint, and re-rasterizes only the tiles that
+/// overlap boxes that changed (see [`LayoutTree::changed_rects`]). All other tiles are carried
+/// over from `prev`, except the `unfilled` ones its background fill never delivered, which are
+/// rasterized again (viewport first, like a full render).
+///
+/// Returns the new cache and the style caches it was rendered with, which the next incremental
+/// rebuild starts from.
+///
+/// [`LayoutTree::changed_rects`]: gosub_render_pipeline::layouter::LayoutTree::changed_rects
+#[allow(clippy::too_many_arguments)]
+fn pipeline_rebuild_damaged<C: RenderConfiguration>(
+    doc: Arc<EngineDocument<C>>,
+    prev_styles: &GosubDocumentAdapter<C>,
+    layouter: &mut TaffyLayouter,
+    prev: PipelineCache,
+    unfilled: HashSet<TileKey>,
+    damage: &[(NodeId, DomDamage)],
+    viewport: &Viewport,
+    visible: gosub_render_pipeline::common::geo::Rect,
+    scroll_dir: f64,
+    rasterizer: Option<&Arc<dyn Rasterable + Send + Sync>>,
+    strategy: RasterStrategy,
+    tile_cache: &Arc<TilePixelCache>,
+    media_store: Arc<gosub_render_pipeline::common::media::MediaStore>,
+    tile_size: f64,
+    parallel_style: bool,
+) -> (PipelineCache, Arc<GosubDocumentAdapter<C>>) {
+    use gosub_render_pipeline::common::geo::{Dimension as PipelineDimension, Rect as PipelineRect};
+    use gosub_render_pipeline::layouter::{CanLayout, LayoutTree};
+    use gosub_render_pipeline::rendertree_builder::RenderTree;
+    use gosub_render_pipeline::tiler::{TileList, TileState};
+    use gosub_shared::{timing_start, timing_stop};
+    use std::collections::HashMap;
+
+    let ts_total = timing_start!("pipeline.damage.total");
+
+    gosub_css3::stylesheet::set_layout_viewport(viewport.width as f32, viewport.height as f32);
+
+    // Style damage restyles from the parent: sibling combinators and :nth-child() let a change
+    // on one child affect the styles of its siblings.
+    let mut restyle_roots = Vec::new();
+    let mut damaged = HashSet::new();
+    let mut needs_layout = false;
+    for &(id, level) in damage {
+        match level {
+            DomDamage::Paint => {
+                restyle_roots.push(id);
+            }
+            DomDamage::Layout => {
+                needs_layout = true;
+                damaged.insert(id);
+                damaged.extend(doc.parent(id));
+            }
+            DomDamage::Style => {
+                needs_layout = true;
+                restyle_roots.push(doc.parent(id).unwrap_or(id));
+            }
+        }
+    }
+    let mut stack = restyle_roots.clone();
+    while let Some(id) = stack.pop() {
+        if damaged.insert(id) {
+            stack.extend_from_slice(doc.children(id));
+        }
+    }
+
+    let styles = Arc::new(GosubDocumentAdapter::with_styles_from(
+        Arc::clone(&doc),
+        prev_styles,
+        &restyle_roots,
+    ));
+    // Sequentially, only the restyled subtrees are resolved, on demand; a full walk would
+    // re-enter every clean element just to rebuild the ancestor filter.
+    if parallel_style {
+        let ts_style = timing_start!("pipeline.damage.style");
+        resolve_styles(&styles, viewport, true);
+        timing_stop!(ts_style);
+    }
+
+    let prev_layer_list = prev.layer_list;
+    let prev_display_list = prev.display_list;
+    let layout_tree = if needs_layout {
+        let ts1 = timing_start!("pipeline.damage.render_tree");
+        let mut render_tree = RenderTree::new(Arc::clone(&styles));
+        if let Err(e) = render_tree.parse() {
+            log::error!("Failed to build render tree: {e}");
+        }
+        timing_stop!(ts1);
+
+        let vp_dim = if viewport.width > 0 && viewport.height > 0 {
+            Some(PipelineDimension::new(viewport.width as f64, viewport.height as f64))
+        } else {
+            None
+        };
+        let ts2 = timing_start!("pipeline.damage.layout");
+        let layout_tree = layouter.layout(render_tree, vp_dim, 1.0);
+        timing_stop!(ts2);
+        layout_tree
+    } else {
+        // Paint-only damage: boxes stay where they are, only the styles they paint with change.
+        let mut layout_tree = LayoutTree::clone(&prev_layer_list.layout_tree);
+        layout_tree.render_tree.doc = Arc::clone(&styles);
+        layout_tree
+    };
+    let page_height = layout_tree.root_dimension.height;
+    let changed = layout_tree.changed_rects(&prev_layer_list.layout_tree, &damaged);
+
+    let ts3 = timing_start!("pipeline.damage.layering");
+    let layer_list = LayerList::new(layout_tree);
+    timing_stop!(ts3);
+
+    let ts4 = timing_start!("pipeline.damage.tiling");
+    let mut tile_list = TileList::new(layer_list, PipelineDimension::new(tile_size, tile_size));
+    tile_list.generate();
+    timing_stop!(ts4);
+
+    let full_page_rect = PipelineRect::new(0.0, 0.0, viewport.width as f64, page_height.max(1.0));
+    let layer_ids = tile_list.layer_list.layer_ids.read().clone();
+
+    // Tiles can only be carried over when the layer structure is unchanged; layer ids are
+    // handed out in tree order, so an added or removed layer shifts every id after it.
+    let mut clean_baked = Vec::new();
+    if layer_ids == *prev_layer_list.layer_ids.read() {
+        let mut prev_by_pos: HashMap<TileKey, BakedTile> =
+            prev.tiles.into_iter().map(|t| (baked_tile_key(&t), t)).collect();
+        for tile in tile_list.arena.values_mut() {
+            if !unfilled.contains(&tile_key(tile.rect, tile.layer_id.as_u64())) {
+                tile.state = TileState::Ready;
+            }
+        }
+        for rect in changed {
+            tile_list.invalidate_rect(rect);
+        }
+        for tile in tile_list.arena.values() {
+            if tile.state != TileState::Ready {
+                continue;
+            }
+            if let Some(baked) = prev_by_pos.remove(&tile_key(tile.rect, tile.layer_id.as_u64())) {
+                clean_baked.push(baked);
+            }
+        }
+    }
+
+    let cache = repaint_dirty_tiles(
+        tile_list,
+        &layer_ids,
+        full_page_rect,
+        visible,
+        scroll_dir,
+        page_height,
+        clean_baked,
+        Some(&prev_display_list),
+        &damaged,
+        rasterizer,
+        strategy,
+        &media_store,
+        tile_cache,
+        "pipeline.damage",
+    );
+    timing_stop!(ts_total);
+    (cache, styles)
+}
+
 /// Hover-only repaint: skip stages 1–2 (render-tree + layout), reuse the cached
 /// `LayerList`, and only repaint tiles that intersect the old or new hovered element.
 /// All other tiles are carried over from `prev_baked_tiles` unchanged - no CSS
-/// re-evaluation, no re-rasterization.
+/// re-evaluation, no re-rasterization - except the `unfilled` ones the previous background fill
+/// never delivered, which are rasterized again.
 #[allow(clippy::too_many_arguments)]
 fn pipeline_hover_repaint(
     layer_list: Arc<gosub_render_pipeline::layering::layer::LayerList>,
+    display_list: Arc<DisplayList>,
     page_height: f64,
     prev_baked_tiles: Vec<BakedTile>,
+    unfilled: HashSet<TileKey>,
     old_hover_lei: Option<LayoutElementId>,
     new_hover_lei: Option<LayoutElementId>,
     hover_dirty_nodes: &[NodeId],
     viewport: &gosub_render_pipeline::render::Viewport,
-    rasterizer: Option<&(dyn Rasterable + Send + Sync)>,
+    visible: gosub_render_pipeline::common::geo::Rect,
+    scroll_dir: f64,
+    rasterizer: Option<&Arc<dyn Rasterable + Send + Sync>>,
     strategy: RasterStrategy,
-    prev_tile_cache: TilePixelCache,
+    tile_cache: &Arc<TilePixelCache>,
     media_store: Arc<gosub_render_pipeline::common::media::MediaStore>,
     tile_size: f64,
 ) -> PipelineCache {
-    use gosub_render_pipeline::common::browser_state::{BrowserState, WireframeState};
     use gosub_render_pipeline::common::geo::{Dimension as PipelineDimension, Rect as PipelineRect};
-    use gosub_render_pipeline::painter::Painter;
     use gosub_render_pipeline::tiler::{TileList, TileState};
     use gosub_shared::{timing_start, timing_stop};
 
@@ -923,10 +1673,8 @@ fn pipeline_hover_repaint(
     // change. The layer id is essential: overlapping layers (e.g. the base layer and a sticky
     // header) share a page position, and keying by position alone would collapse them into one,
     // dropping the other tile and leaving a blank gap on the next hover repaint.
-    let mut prev_by_pos: std::collections::HashMap<(u64, u64, u64), BakedTile> = prev_baked_tiles
-        .into_iter()
-        .map(|t| ((t.page_x.to_bits(), t.page_y.to_bits(), t.layer_id), t))
-        .collect();
+    let mut prev_by_pos: std::collections::HashMap<TileKey, BakedTile> =
+        prev_baked_tiles.into_iter().map(|t| (baked_tile_key(&t), t)).collect();
 
     // Compute the union bounding box of old and new hovered elements.  Tiles that
     // don't intersect this region cannot have changed visually, so we skip them.
@@ -956,14 +1704,36 @@ fn pipeline_hover_repaint(
     let full_page_rect = PipelineRect::new(0.0, 0.0, viewport.width as f64, page_height.max(1.0));
     let layer_ids = tile_list.layer_list.layer_ids.read().clone();
 
+    if hover_rect.is_none() && unfilled.is_empty() {
+        // No hover element visible - carry every previous tile forward, but re-emit in
+        // back-to-front layer order (see order_baked_tiles_by_layer): `into_values()` is
+        // unordered and would scramble overlapping-layer compositing.
+        let all_tiles = order_baked_tiles_by_layer(&tile_list, &layer_ids, full_page_rect, prev_by_pos);
+        let cached_tiles = Arc::new(cpu_cached_tiles(&all_tiles));
+        return PipelineCache {
+            tiles: all_tiles,
+            page_height,
+            cached_tiles,
+            layer_list,
+            display_list,
+            fill: None,
+            unfilled,
+        };
+    }
+
     // Mark tiles that DON'T intersect the hover region as Clean.  For Clean tiles we
     // carry the previous BakedTile forward; for Dirty tiles we re-evaluate CSS only
-    // for the elements they contain (targeted invalidation).
+    // for the elements they contain (targeted invalidation). Tiles the previous fill never
+    // delivered stay Dirty.
     let mut clean_baked: Vec<BakedTile> = Vec::with_capacity(total_tiles);
-    if let Some(hover_rect) = hover_rect {
-        let doc = &layer_list.layout_tree.render_tree.doc;
-        for tile in tile_list.arena.values_mut() {
-            let tile_rect = tile.rect;
+    let doc = &layer_list.layout_tree.render_tree.doc;
+    for tile in tile_list.arena.values_mut() {
+        let tile_rect = tile.rect;
+        let key = tile_key(tile_rect, tile.layer_id.as_u64());
+        if unfilled.contains(&key) {
+            continue;
+        }
+        if let Some(hover_rect) = hover_rect {
             let overlaps = tile_rect.x < hover_rect.x + hover_rect.width
                 && tile_rect.x + tile_rect.width > hover_rect.x
                 && tile_rect.y < hover_rect.y + hover_rect.height
@@ -975,31 +1745,73 @@ fn pipeline_hover_repaint(
                 doc.invalidate_style_for_nodes(hover_dirty_nodes);
                 continue;
             }
+        }
 
-            tile.state = TileState::Ready;
-            let key = (tile_rect.x.to_bits(), tile_rect.y.to_bits(), tile.layer_id.as_u64());
-            if let Some(baked) = prev_by_pos.remove(&key) {
-                clean_baked.push(baked);
-            }
+        tile.state = TileState::Ready;
+        if let Some(baked) = prev_by_pos.remove(&key) {
+            clean_baked.push(baked);
+        }
+    }
+
+    // The hover chain restyles, and its descendants may inherit from it; every other element
+    // keeps the commands it was painted with.
+    let mut damaged = HashSet::new();
+    let mut stack = hover_dirty_nodes.to_vec();
+    while let Some(id) = stack.pop() {
+        if damaged.insert(id) {
+            stack.extend(doc.children(id));
         }
-    } else {
-        // No hover element visible - carry every previous tile forward, but re-emit in
-        // back-to-front layer order (see order_baked_tiles_by_layer): `into_values()` is
-        // unordered and would scramble overlapping-layer compositing.
-        let all_tiles = order_baked_tiles_by_layer(&tile_list, &layer_ids, full_page_rect, prev_by_pos);
-        let cached_tiles = Arc::new(cpu_cached_tiles(&all_tiles));
-        return PipelineCache {
-            tiles: all_tiles,
-            page_height,
-            cached_tiles,
-            layer_list,
-            tile_pixel_cache: prev_tile_cache,
-        };
     }
 
-    // Stage 5: paint ONLY dirty (hover-affected) tiles. `full_page_rect` and `layer_ids` were
-    // computed above (shared with the carry-over ordering).
-    let ts5 = timing_start!("pipeline.hover.painting");
+    // Stages 5–6: paint and rasterize ONLY the dirty (hover-affected) tiles, then merge them with
+    // the carried-over clean ones.
+    repaint_dirty_tiles(
+        tile_list,
+        &layer_ids,
+        full_page_rect,
+        visible,
+        scroll_dir,
+        page_height,
+        clean_baked,
+        Some(&display_list),
+        &damaged,
+        rasterizer,
+        strategy,
+        &media_store,
+        tile_cache,
+        "pipeline.hover",
+    )
+}
+
+/// Stages 5–6 for the tiles of `tile_list` still marked dirty: paint and rasterize them, then
+/// merge the result with `clean_baked` (tiles carried over from the previous render) in
+/// back-to-front layer order. The display list is built from `prev_display_list` by repainting
+/// only the elements of `damaged` nodes and those whose layout changed. Like a full render, the
+/// parallel strategy rasterizes the dirty tiles in `visible` right away and hands the rest to a
+/// background fill. Timings are recorded under `{timing_prefix}.painting` and
+/// `{timing_prefix}.rasterize`.
+#[allow(clippy::too_many_arguments)]
+fn repaint_dirty_tiles(
+    mut tile_list: gosub_render_pipeline::tiler::TileList,
+    layer_ids: &[gosub_render_pipeline::layering::layer::LayerId],
+    full_page_rect: gosub_render_pipeline::common::geo::Rect,
+    visible: gosub_render_pipeline::common::geo::Rect,
+    scroll_dir: f64,
+    page_height: f64,
+    clean_baked: Vec<BakedTile>,
+    prev_display_list: Option<&DisplayList>,
+    damaged: &HashSet<NodeId>,
+    rasterizer: Option<&Arc<dyn Rasterable + Send + Sync>>,
+    strategy: RasterStrategy,
+    media_store: &Arc<gosub_render_pipeline::common::media::MediaStore>,
+    tile_cache: &Arc<TilePixelCache>,
+    timing_prefix: &str,
+) -> PipelineCache {
+    use gosub_render_pipeline::common::browser_state::{BrowserState, WireframeState};
+    use gosub_render_pipeline::tiler::TileState;
+    use gosub_shared::{timing_start, timing_stop};
+
+    let ts5 = timing_start!(&format!("{timing_prefix}.painting"));
     let paint_state = BrowserState {
         visible_layer_list: vec![true; layer_ids.len()],
         wireframed: WireframeState::None,
@@ -1011,8 +1823,10 @@ fn pipeline_hover_repaint(
         tile_list: None,
         dpi_scale_factor: 1.0,
     };
-    let painter = Painter::new(tile_list.layer_list.clone(), rasterizer.and_then(|r| r.font_system()));
-    for &layer_id in &layer_ids {
+    let layer_list = Arc::clone(&tile_list.layer_list);
+    let painter = Painter::new(Arc::clone(&layer_list), rasterizer.and_then(|r| r.font_system()));
+    let display_list = Arc::new(DisplayList::build(&painter, &paint_state, prev_display_list, damaged));
+    for &layer_id in layer_ids {
         let tile_ids = tile_list.get_intersecting_tiles(layer_id, full_page_rect);
         for tile_id in tile_ids {
             let Some(tile) = tile_list.get_tile_mut(tile_id) else {
@@ -1022,48 +1836,69 @@ fn pipeline_hover_repaint(
                 continue;
             }
             for tiled_element in &mut tile.elements {
-                tiled_element.paint_commands = painter.paint(tiled_element, &paint_state);
+                tiled_element.paint_commands = display_list.slice(tiled_element.id);
             }
         }
     }
     timing_stop!(ts5);
 
-    // Stage 6 (hover): rasterize the dirty tiles with the active backend's rasterizer + strategy.
-    let (baked_tiles, new_tile_cache) = match (strategy, rasterizer) {
-        (RasterStrategy::ParallelCached, Some(rasterizer)) => rasterize_parallel(
-            rasterizer,
-            &layer_ids,
+    let mut deferred = Vec::new();
+    let baked_tiles = match (strategy, rasterizer) {
+        (RasterStrategy::ParallelCached, Some(rasterizer)) => {
+            let (now, later) = split_viewport_tiles(&tile_list, layer_ids, full_page_rect, visible);
+            deferred = later;
+            rasterize_tiles(
+                rasterizer.as_ref(),
+                &mut tile_list,
+                &now,
+                media_store,
+                tile_cache,
+                &format!("{timing_prefix}.rasterize"),
+            )
+        }
+        (RasterStrategy::Sequential, Some(rasterizer)) => rasterize_sequential(
+            rasterizer.as_ref(),
+            layer_ids,
             &mut tile_list,
             full_page_rect,
-            &media_store,
-            &prev_tile_cache,
-            "pipeline.hover.rasterize",
+            media_store,
+            tile_cache,
         ),
-        (RasterStrategy::Sequential, Some(rasterizer)) => {
-            rasterize_sequential(rasterizer, &layer_ids, &mut tile_list, full_page_rect, &media_store)
-        }
-        _ => (Vec::new(), std::collections::HashMap::new()),
+        _ => Vec::new(),
     };
 
-    // Merge newly rasterized hover tiles + carried-over clean tiles, keyed by position+layer, then
+    // Merge the newly rasterized tiles with the carried-over ones, keyed by position+layer, then
     // re-emit in back-to-front layer order so overlapping layers composite correctly (a plain
     // `dirty ++ clean` concat scrambles the order - `clean_baked` came out of a HashMap - which
     // corrupts overlap regions like a sticky header and every scroll frame reusing this cache).
-    let by_key: std::collections::HashMap<(u64, u64, u64), BakedTile> = baked_tiles
+    let by_key: std::collections::HashMap<TileKey, BakedTile> = baked_tiles
         .into_iter()
         .chain(clean_baked)
-        .map(|t| ((t.page_x.to_bits(), t.page_y.to_bits(), t.layer_id), t))
+        .map(|t| (baked_tile_key(&t), t))
         .collect();
-    let all_baked_tiles = order_baked_tiles_by_layer(&tile_list, &layer_ids, full_page_rect, by_key);
-
-    let cached_tiles = Arc::new(cpu_cached_tiles(&all_baked_tiles));
-
+    let tiles = order_baked_tiles_by_layer(&tile_list, layer_ids, full_page_rect, by_key);
+    let cached_tiles = Arc::new(cpu_cached_tiles(&tiles));
+
+    let unfilled = tile_keys(&tile_list, &deferred);
+    let fill = rasterizer.and_then(|rasterizer| {
+        RasterFill::spawn(
+            Arc::clone(rasterizer),
+            tile_list,
+            deferred,
+            Arc::clone(media_store),
+            Arc::clone(tile_cache),
+            visible,
+            scroll_dir,
+        )
+    });
     PipelineCache {
-        tiles: all_baked_tiles,
+        tiles,
         page_height,
         cached_tiles,
         layer_list,
-        tile_pixel_cache: new_tile_cache,
+        display_list,
+        fill,
+        unfilled,
     }
 }
 
@@ -1077,7 +1912,7 @@ fn order_baked_tiles_by_layer(
     tile_list: &gosub_render_pipeline::tiler::TileList,
     layer_ids: &[gosub_render_pipeline::layering::layer::LayerId],
     full_page_rect: gosub_render_pipeline::common::geo::Rect,
-    mut by_key: std::collections::HashMap<(u64, u64, u64), BakedTile>,
+    mut by_key: std::collections::HashMap<TileKey, BakedTile>,
 ) -> Vec<BakedTile> {
     let mut ordered = Vec::with_capacity(by_key.len());
     for &layer_id in layer_ids {
@@ -1085,8 +1920,7 @@ fn order_baked_tiles_by_layer(
             let Some(tile) = tile_list.arena.get(&tile_id) else {
                 continue;
             };
-            let key = (tile.rect.x.to_bits(), tile.rect.y.to_bits(), tile.layer_id.as_u64());
-            if let Some(t) = by_key.remove(&key) {
+            if let Some(t) = by_key.remove(&tile_key(tile.rect, tile.layer_id.as_u64())) {
                 ordered.push(t);
             }
         }
@@ -1133,7 +1967,182 @@ fn pipeline_composite(cache: &PipelineCache, scroll_x: f64, scroll_y: f64, vp_w:
 
 #[cfg(test)]
 mod tests {
-    use super::parse_clear_color;
+    use super::*;
+    use crate::engine::settings_store::default_config;
+    use crate::html::{parse_main_document_stream, DefaultRenderConfig, HtmlParseConfig};
+    use bytes::Bytes;
+    use futures::stream;
+    use gosub_html5::node::HTML_NAMESPACE;
+    use gosub_html5::parser::tree_builder::TreeBuilder;
+    use gosub_render_pipeline::common::media::MediaStore;
+    use gosub_render_pipeline::common::texture::TextureId;
+    use gosub_render_pipeline::common::texture_store::TextureStore;
+    use gosub_render_pipeline::tiler::Tile;
+    use gosub_shared::byte_stream::Location;
+    use std::io;
+    use std::sync::atomic::{AtomicUsize, Ordering};
+    use tokio_util::io::StreamReader;
+    use tokio_util::sync::CancellationToken;
+    use url::Url;
+
+    /// Counts the tiles it is asked to rasterize. It produces no pixels, so nothing lands in the
+    /// tile-pixel cache and every dirty tile reaches `rasterize`.
+    struct CountingRasterizer(Arc<AtomicUsize>);
+
+    impl Rasterable for CountingRasterizer {
+        fn rasterize(
+            &self,
+            _tile: &Tile,
+            _texture_store: &mut TextureStore,
+            _media_store: &MediaStore,
+        ) -> Option<TextureId> {
+            self.0.fetch_add(1, Ordering::Relaxed);
+            None
+        }
+    }
+
+    /// A rendered 800x600 context over 40 stacked 100px boxes (`#d0`..`#d39`), each wrapped
+    /// so a style change restyles only its own wrapper. Also returns the rasterize count.
+    async fn stacked_boxes(strategy: RasterStrategy) -> (BrowsingContext<DefaultRenderConfig>, Arc<AtomicUsize>) {
+        let mut html = String::from("<html><body>");
+        for i in 0..40 {
+            html.push_str(&format!(
+                r#"<div><div id="d{i}" style="height: 100px; background: #eee"></div></div>"#
+            ));
+        }
+        html.push_str("</body></html>");
+        let reader = StreamReader::new(stream::iter(vec![Ok::<Bytes, io::Error>(Bytes::from(html))]));
+        let doc = parse_main_document_stream::<DefaultRenderConfig, _, _>(
+            Url::parse("https://example.com/").unwrap(),
+            reader,
+            CancellationToken::new(),
+            HtmlParseConfig::default(),
+            |_| {},
+        )
+        .await
+        .unwrap();
+
+        let rasterized = Arc::new(AtomicUsize::new(0));
+        let mut ctx = BrowsingContext::<DefaultRenderConfig>::new(default_config());
+        ctx.set_rasterizer(Box::new(CountingRasterizer(Arc::clone(&rasterized))), strategy);
+        ctx.set_viewport(Viewport {
+            x: 0,
+            y: 0,
+            width: 800,
+            height: 600,
+        });
+        ctx.set_document(Arc::new(doc));
+        ctx.rebuild_pipeline_cache_if_needed();
+        (ctx, rasterized)
+    }
+
+    fn restyle_box(ctx: &mut BrowsingContext<DefaultRenderConfig>, id: &str) {
+        ctx.mutate_document(|doc| {
+            let target = doc.node_by_named_id(id).unwrap();
+            doc.set_attribute(target, "style", "height: 100px; background: red");
+        })
+        .unwrap();
+    }
+
+    #[tokio::test(flavor = "current_thread")]
+    async fn dom_mutation_rerasterizes_only_damaged_tiles() {
+        let (mut ctx, rasterized) = stacked_boxes(RasterStrategy::Sequential).await;
+        let full = rasterized.swap(0, Ordering::Relaxed);
+        // 4000px of boxes in 256px tiles, four columns wide.
+        assert!(full >= 60, "full render rasterized only {full} tiles");
+
+        restyle_box(&mut ctx, "d20");
+        ctx.rebuild_pipeline_cache_if_needed();
+
+        // The box at y=2008..2108 straddles two tile rows.
+        let repainted = rasterized.load(Ordering::Relaxed);
+        assert!(
+            repainted > 0 && repainted <= 8,
+            "re-rasterized {repainted} of {full} tiles for one changed box"
+        );
+    }
+
+    #[tokio::test(flavor = "current_thread")]
+    async fn dom_mutation_edits_the_document_in_place() {
+        // With a fill still running, which also refers to the document until it is stopped.
+        let (mut ctx, _) = stacked_boxes(RasterStrategy::ParallelCached).await;
+        let before = Arc::as_ptr(ctx.document.as_ref().unwrap());
+
+        // Queued the way the parser's tree builder queues them; flushed into the live document.
+        let target = ctx.document.as_ref().unwrap().node_by_named_id("d3").unwrap();
+        let mut queue = DocumentTaskQueue::new::<DefaultRenderConfig>(ctx.document.as_deref().unwrap());
+        let added = queue.create_element("span", target, None, HTML_NAMESPACE, Location::default());
+        queue
+            .insert_attribute("id", "added", added, Location::default())
+            .unwrap();
+        assert!(ctx.apply_document_tasks(&mut queue).is_empty());
+
+        let doc = ctx.document.as_ref().unwrap();
+        assert_eq!(Arc::as_ptr(doc), before, "the edit copied the document");
+        assert_eq!(doc.node_by_named_id("added"), Some(added));
+
+        // The rebuild points the render back at the edited document.
+        ctx.rebuild_pipeline_cache_if_needed();
+        let doc = ctx.document.as_ref().unwrap();
+        assert!(Arc::ptr_eq(&ctx.styles.as_ref().unwrap().doc, doc));
+        let layer_list = &ctx.pipeline_cache.as_ref().unwrap().layer_list;
+        assert_eq!(layer_list.layout_tree.render_tree.doc.parent(added), Some(target));
+    }
+
+    #[tokio::test(flavor = "current_thread")]
+    async fn damage_rebuild_requeues_tiles_the_fill_never_delivered() {
+        let (mut ctx, rasterized) = stacked_boxes(RasterStrategy::ParallelCached).await;
+        // Abandon the fill before taking anything from it: every off-viewport tile is unfilled.
+        let cache = ctx.pipeline_cache.as_mut().unwrap();
+        cache.fill = None;
+        let unfilled = cache.unfilled.clone();
+        assert!(!unfilled.is_empty());
+        rasterized.store(0, Ordering::Relaxed);
+
+        // Damage inside the viewport: the rebuild carries the clean viewport tiles over and hands
+        // every tile the old fill owed to the new one.
+        restyle_box(&mut ctx, "d2");
+        ctx.rebuild_pipeline_cache_if_needed();
+        let cache = ctx.pipeline_cache.as_ref().unwrap();
+        assert!(unfilled.is_subset(&cache.unfilled));
+
+        let deadline = std::time::Instant::now() + std::time::Duration::from_secs(10);
+        while ctx.pipeline_cache.as_ref().is_some_and(|c| c.fill.is_some()) {
+            assert!(std::time::Instant::now() < deadline, "raster fill did not finish");
+            ctx.poll_raster_fill();
+            std::thread::sleep(std::time::Duration::from_millis(1));
+        }
+        assert!(ctx.pipeline_cache.as_ref().unwrap().unfilled.is_empty());
+        assert!(rasterized.load(Ordering::Relaxed) >= unfilled.len());
+    }
+
+    #[tokio::test(flavor = "current_thread")]
+    async fn relayout_of_the_same_document_reuses_the_display_list() {
+        let (mut ctx, _) = stacked_boxes(RasterStrategy::Sequential).await;
+        let elements = ctx.pipeline_cache.as_ref().unwrap().display_list.painted();
+
+        // A relayout after a media load: every box comes out the same.
+        ctx.invalidate_render();
+        ctx.rebuild_pipeline_cache_if_needed();
+        assert_eq!(ctx.pipeline_cache.as_ref().unwrap().display_list.painted(), 0);
+
+        // A taller viewport leaves the stacked boxes where they were.
+        ctx.set_viewport(Viewport {
+            x: 0,
+            y: 0,
+            width: 800,
+            height: 700,
+        });
+        ctx.rebuild_pipeline_cache_if_needed();
+        let painted = ctx.pipeline_cache.as_ref().unwrap().display_list.painted();
+        assert!(painted < elements / 4, "repainted {painted} of {elements} elements");
+
+        // A new document is always painted from scratch.
+        let doc = ctx.document.as_deref().unwrap().clone();
+        ctx.set_document(Arc::new(doc));
+        ctx.rebuild_pipeline_cache_if_needed();
+        assert_eq!(ctx.pipeline_cache.as_ref().unwrap().display_list.painted(), elements);
+    }
 
     #[test]
     fn parse_clear_color_handles_rgb_rgba_and_garbage() {
@@ -9,7 +9,7 @@
 //! - [`Cookie`] - A single HTTP cookie (name, value, domain, path, expiry, SameSite, etc.).
 //! - [`CookieJar`] - Thread-safe, in-memory cookie jar implementing RFC 6265 semantics.
 //! - [`DefaultCookieJar`] - The engine’s default in-memory [`CookieJar`] (ephemeral).
-//! - [`PersistentCookieJar`] - A [`CookieJar`] wrapper that snapshots changes to a
+//! - [`PersistentCookieJar`] - A [`CookieJar`] wrapper that reports changes to a
 //!   persistent [`CookieStore`] backend.
 //! - [`CookieStore`] - Trait for durable storage backends.
 //!   - [`InMemoryCookieStore`] - Non-persistent store (useful for tests).
@@ -52,7 +52,7 @@
 //! ```
 //!
 //! 2. **Persistent cookies** - supply a `cookie_store` and omit `cookie_jar`. The engine
-//!    will attach a `PersistentCookieJar` for this zone that snapshots on every mutation:
+//!    will attach a `PersistentCookieJar` for this zone that reports every mutation to the store:
 //!
 //! ```no_run
 //! # use std::sync::Arc;
@@ -92,8 +92,8 @@
 //! ## Concurrency & safety
 //!
 //! - `CookieJarHandle` is cloneable (`Send + Sync`). Reads are concurrent; writes are
-//!   serialized internally. If using a persistent jar, each mutation triggers a snapshot
-//!   to the store so state stays consistent across restarts.
+//!   serialized internally. If using a persistent jar, each mutation is reported to the
+//!   store, which writes changes out in batches so state stays consistent across restarts.
 //!
 //! ## See also
 //!
@@ -113,6 +113,7 @@ pub use cookies::Cookie;
 pub use cookies::CookieJarHandle;
 pub use cookies::CookieStoreHandle;
 
+pub(crate) use cookie_jar::same_site;
 pub use cookie_jar::CookieJar;
 pub use cookie_jar::DefaultCookieJar;
 pub use cookie_jar::SameSiteContext;
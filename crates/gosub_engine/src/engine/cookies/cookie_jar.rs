@@ -13,8 +13,9 @@
 //!   `HttpOnly`, and `SameSite` are parsed and enforced; expired cookies are
 //!   filtered on read and can be removed via [`CookieJar::purge_expired`].
 //!   Priorities, size limits, and eviction policies are not (yet) implemented.
-//! - Cookies are bucketed by **origin** (`url.origin().ascii_serialization()`).
-//!   Within a bucket, simple host/subdomain and path prefix checks are applied.
+//! - Cookies remember the **origin** (`url.origin().ascii_serialization()`) that set
+//!   them and are indexed by the host they are scoped to, then by path; see
+//!   [`DefaultCookieJar`]. Host-only cookies are only sent back to that exact origin.
 //! - This module is **not** internally synchronized. Use it via a
 //!   `CookieJarHandle = Arc<RwLock<dyn CookieJar + Send + Sync>>`.
 //!
@@ -24,8 +25,9 @@ use crate::engine::cookies::Cookie;
 use chrono::Utc;
 use cow_utils::CowUtils;
 use http::HeaderMap;
+use parking_lot::Mutex;
 use psl::Psl as _;
-use serde::{Deserialize, Serialize};
+use serde::{Deserialize, Deserializer, Serialize, Serializer};
 use std::any::Any;
 use std::collections::HashMap;
 use url::Url;
@@ -106,7 +108,7 @@ fn parse_http_date(s: &str) -> Option<i64> {
 /// Uses the compile-time embedded Mozilla Public Suffix List (`psl` crate) for
 /// accurate comparison. Falls back to exact hostname equality for IP addresses,
 /// `localhost`, and other labels not present in the PSL.
-fn same_site(host_a: &str, host_b: &str) -> bool {
+pub(crate) fn same_site(host_a: &str, host_b: &str) -> bool {
     let registrable = |host: &str| -> Option<String> {
         let d = psl::List.domain(host.as_bytes())?;
         std::str::from_utf8(d.as_bytes()).ok().map(str::to_owned)
@@ -122,7 +124,7 @@ fn same_site(host_a: &str, host_b: &str) -> bool {
 /// Applied by [`DefaultCookieJar::get_request_cookies`] and
 /// [`DefaultCookieJar::store_response_cookies`] when a `top_level` URL is supplied
 /// and its registrable domain differs from the request URL's registrable domain.
-#[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize, Default)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash, Serialize, Deserialize, Default)]
 pub enum ThirdPartyCookiePolicy {
     /// All cookies are sent/stored regardless of cross-site context. (Default; matches
     /// legacy browser behavior.)
@@ -148,7 +150,7 @@ pub enum ThirdPartyCookiePolicy {
 /// | `SameSite=Lax`      | ✓ | ✓ | ✗ |
 /// | *(no attribute)*    | ✓ | ✓ | ✗ |
 /// | `SameSite=None; Secure` | ✓ | ✓ | ✓ |
-#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash, Default)]
 pub enum SameSiteContext {
     /// Same-site request. All `SameSite` attribute values are eligible.
     #[default]
@@ -226,11 +228,207 @@ pub trait CookieJar: Send + Sync {
     fn purge_expired(&mut self);
 }
 
+/// `Cookie` header values a jar remembers before it starts over.
+const HEADER_CACHE_CAPACITY: usize = 256;
+
+/// A cookie together with the origin whose response set it.
+#[derive(Debug, Clone)]
+struct StoredCookie {
+    /// Origin string from `Url::origin().ascii_serialization()`.
+    origin: String,
+    /// Insertion order; the last tie-break when ordering the `Cookie` header.
+    seq: u64,
+    cookie: Cookie,
+}
+
+/// One segment of a path trie.
+///
+/// A cookie sits at the node its path ends on (ignoring a trailing `/`), so every cookie
+/// that can path-match a request path lies on the walk down that path's segments.
+#[derive(Debug, Clone, Default)]
+struct PathNode {
+    cookies: Vec<StoredCookie>,
+    children: HashMap<String, PathNode>,
+}
+
+impl PathNode {
+    fn is_empty(&self) -> bool {
+        self.cookies.is_empty() && self.children.is_empty()
+    }
+
+    /// Keeps the cookies `keep` accepts, dropping nodes left empty.
+    fn retain(&mut self, keep: &mut impl FnMut(&StoredCookie) -> bool) {
+        self.cookies.retain(|c| keep(c));
+        for child in self.children.values_mut() {
+            child.retain(keep);
+        }
+        self.children.retain(|_, child| !child.is_empty());
+    }
+
+    fn collect<'a>(&'a self, out: &mut Vec<&'a StoredCookie>) {
+        out.extend(&self.cookies);
+        for child in self.children.values() {
+            child.collect(out);
+        }
+    }
+}
+
+/// The cookies scoped to one host: the `Domain` attribute of a domain cookie, or the host that
+/// set a host-only cookie.
+#[derive(Debug, Clone, Default)]
+struct HostCookies {
+    paths: PathNode,
+    /// Cookies whose path does not start with `/`; they only match non-hierarchical URL paths.
+    relative: Vec<StoredCookie>,
+}
+
+impl HostCookies {
+    fn is_empty(&self) -> bool {
+        self.paths.is_empty() && self.relative.is_empty()
+    }
+
+    /// The list holding cookies with `path`, creating its trie nodes when missing.
+    fn slot_mut(&mut self, path: Option<&str>) -> &mut Vec<StoredCookie> {
+        match path_segments(path) {
+            Some(segments) => {
+                let node = segments.fold(&mut self.paths, |node, segment| {
+                    node.children.entry(segment.to_string()).or_default()
+                });
+                &mut node.cookies
+            }
+            None => &mut self.relative,
+        }
+    }
+
+    fn retain(&mut self, mut keep: impl FnMut(&StoredCookie) -> bool) {
+        self.paths.retain(&mut keep);
+        self.relative.retain(|c| keep(c));
+    }
+
+    fn collect<'a>(&'a self, out: &mut Vec<&'a StoredCookie>) {
+        self.paths.collect(out);
+        out.extend(&self.relative);
+    }
+}
+
+/// The trie segments of a cookie path, or `None` when the path does not start with `/`.
+///
+/// A missing or empty path matches every request path and lives at the root, as does `/`.
+fn path_segments(path: Option<&str>) -> Option<impl Iterator<Item = &str>> {
+    let path = path.unwrap_or_default();
+    let trimmed = path.strip_suffix('/').unwrap_or(path);
+    let rest = if trimmed.is_empty() {
+        None
+    } else {
+        Some(trimmed.strip_prefix('/')?)
+    };
+    Some(rest.into_iter().flat_map(|rest| rest.split('/')))
+}
+
+/// RFC 6265 §5.1.4 path-match of `request_path` against a cookie path.
+fn path_matches(request_path: &str, cookie_path: Option<&str>) -> bool {
+    match cookie_path {
+        Some(cookie_path) => {
+            request_path == cookie_path
+                || (request_path.starts_with(cookie_path)
+                    && (cookie_path.ends_with('/') || request_path[cookie_path.len()..].starts_with('/')))
+        }
+        None => true,
+    }
+}
+
+/// `host` followed by each of its parent domains: `a.b.c`, `b.c`, `c`.
+fn domain_suffixes(host: &str) -> impl Iterator<Item = &str> {
+    std::iter::successors(Some(host), |h| h.split_once('.').map(|(_, parent)| parent))
+}
+
+/// The trie nodes a request path passes through, over every host the request may get cookies from.
+struct PathWalk<'a> {
+    nodes: Vec<&'a PathNode>,
+    relative: Vec<&'a [StoredCookie]>,
+    /// The request path up to the deepest node reached; `None` for non-hierarchical paths.
+    prefix: Option<&'a str>,
+    /// Whether the request path continues past `prefix`.
+    beyond: bool,
+}
+
+impl<'a> PathWalk<'a> {
+    fn new(hosts: &[&'a HostCookies], path: &'a str) -> Self {
+        let Some(rest) = path.strip_prefix('/') else {
+            return Self {
+                nodes: hosts.iter().map(|h| &h.paths).collect(),
+                relative: hosts.iter().map(|h| h.relative.as_slice()).collect(),
+                prefix: None,
+                beyond: false,
+            };
+        };
+
+        let mut nodes = Vec::with_capacity(hosts.len() * 2);
+        let (mut depth, mut prefix_end) = (0, 0);
+        for host in hosts {
+            let mut node = &host.paths;
+            nodes.push(node);
+            let (mut d, mut end) = (0, 0);
+            for segment in rest.split('/') {
+                let Some(child) = node.children.get(segment) else {
+                    break;
+                };
+                node = child;
+                nodes.push(node);
+                d += 1;
+                end += 1 + segment.len();
+            }
+            if d > depth {
+                (depth, prefix_end) = (d, end);
+            }
+        }
+        Self {
+            nodes,
+            relative: Vec::new(),
+            prefix: Some(&path[..prefix_end]),
+            beyond: depth < rest.split('/').count(),
+        }
+    }
+
+    fn candidates(&self) -> impl Iterator<Item = &'a StoredCookie> + '_ {
+        self.nodes
+            .iter()
+            .flat_map(|node| node.cookies.iter())
+            .chain(self.relative.iter().flat_map(|cookies| cookies.iter()))
+    }
+}
+
+/// What a cached `Cookie` header depends on besides the cookies themselves.
+///
+/// Two request paths that reach the same deepest trie node, and agree on whether they continue
+/// past it, path-match exactly the same cookies, so they share one entry.
+#[derive(Debug, Clone, PartialEq, Eq, Hash)]
+struct HeaderKey {
+    /// Lowercased request host.
+    host: String,
+    origin: String,
+    prefix: String,
+    beyond: bool,
+    samesite: SameSiteContext,
+    third_party: bool,
+    policy: ThirdPartyCookiePolicy,
+}
+
+#[derive(Debug, Clone)]
+struct CachedHeader {
+    header: Option<String>,
+    /// Earliest expiry among the cookies in `header`; the entry is stale from then on.
+    valid_until: Option<i64>,
+}
+
 /// Default cookie jar which holds cookies for a single zone.
 ///
 /// This implementation is **in-memory only** and performs **no persistence**.
-/// Cookies are stored per **origin** (`scheme://host:port`) and matched to
-/// requests via basic domain/path rules.
+/// Cookies are indexed by the host they are scoped to (the `Domain` attribute, or the
+/// setting host for host-only cookies) and, within a host, by a path trie. A request
+/// only visits the hosts its own host domain-matches and the trie nodes along its path.
+/// The resulting `Cookie` header is cached per request host and matched path prefix until
+/// the cookies of one of those hosts change or one of the sent cookies expires.
 ///
 /// ### Third-party policy
 /// When `top_level` is provided to `get_request_cookies` or `store_response_cookies`,
@@ -246,15 +444,22 @@ pub trait CookieJar: Send + Sync {
 ///   (parsed into a unix timestamp), `SameSite` (`Strict`/`Lax`/`None`, case-insensitive),
 ///   `Secure`, `HttpOnly`.
 /// - If `Path` is absent, a default path is derived from the request URL.
-/// - Expired cookies are filtered out on read; [`Self::purge_expired`] removes them
-///   from the jar.
-#[derive(Debug, Clone, Serialize, Deserialize)]
+/// - Expired cookies are filtered out on read and dropped the next time their host gets a
+///   cookie; [`Self::purge_expired`] removes all of them.
+///
+/// ### Serialization
+/// Serializes as `{ "entries": { <origin>: [Cookie, ...] }, "third_party_policy": ... }`,
+/// the cookies of each origin in insertion order. The index is rebuilt on load.
+#[derive(Debug)]
 pub struct DefaultCookieJar {
-    /// Simple hashmap of cookies, bucketed by **origin**.
-    ///
-    /// Key: origin string from `Url::origin().ascii_serialization()`.
-    /// Value: vector of cookie records for that origin.
-    pub entries: HashMap<String, Vec<Cookie>>,
+    /// Cookies by the lowercased host they are scoped to.
+    hosts: HashMap<String, HostCookies>,
+
+    /// Next [`StoredCookie::seq`].
+    next_seq: u64,
+
+    /// See [`HeaderKey`].
+    header_cache: Mutex<HashMap<HeaderKey, CachedHeader>>,
 
     /// Policy applied when a cross-site `top_level` URL is detected.
     pub third_party_policy: ThirdPartyCookiePolicy,
@@ -266,11 +471,64 @@ impl Default for DefaultCookieJar {
     }
 }
 
+impl Clone for DefaultCookieJar {
+    fn clone(&self) -> Self {
+        Self {
+            hosts: self.hosts.clone(),
+            next_seq: self.next_seq,
+            header_cache: Mutex::default(),
+            third_party_policy: self.third_party_policy,
+        }
+    }
+}
+
+/// Serialized form of a [`DefaultCookieJar`]: cookies bucketed by the origin that set them.
+#[derive(Serialize)]
+struct JarEntriesRef<'a> {
+    entries: HashMap<&'a str, Vec<&'a Cookie>>,
+    third_party_policy: ThirdPartyCookiePolicy,
+}
+
+#[derive(Deserialize)]
+struct JarEntries {
+    entries: HashMap<String, Vec<Cookie>>,
+    third_party_policy: ThirdPartyCookiePolicy,
+}
+
+impl Serialize for DefaultCookieJar {
+    fn serialize<S: Serializer>(&self, serializer: S) -> Result<S::Ok, S::Error> {
+        let mut entries: HashMap<&str, Vec<&Cookie>> = HashMap::new();
+        for (origin, cookie) in self.cookies() {
+            entries.entry(origin).or_default().push(cookie);
+        }
+        JarEntriesRef {
+            entries,
+            third_party_policy: self.third_party_policy,
+        }
+        .serialize(serializer)
+    }
+}
+
+impl<'de> Deserialize<'de> for DefaultCookieJar {
+    fn deserialize<D: Deserializer<'de>>(deserializer: D) -> Result<Self, D::Error> {
+        let stored = JarEntries::deserialize(deserializer)?;
+        let mut jar = Self::new().with_policy(stored.third_party_policy);
+        for (origin, cookies) in stored.entries {
+            for cookie in cookies {
+                jar.insert(origin.clone(), cookie);
+            }
+        }
+        Ok(jar)
+    }
+}
+
 impl DefaultCookieJar {
     /// Creates an empty in-memory cookie jar with `ThirdPartyCookiePolicy::Allow`.
     pub fn new() -> Self {
         DefaultCookieJar {
-            entries: HashMap::new(),
+            hosts: HashMap::new(),
+            next_seq: 0,
+            header_cache: Mutex::default(),
             third_party_policy: ThirdPartyCookiePolicy::default(),
         }
     }
@@ -280,6 +538,82 @@ impl DefaultCookieJar {
         self.third_party_policy = policy;
         self
     }
+
+    /// Adds `cookie` as set by `origin`, replacing a cookie from that origin with the same
+    /// name, domain and path.
+    ///
+    /// Meant for restoring persisted cookies: no `Set-Cookie` validation is applied and
+    /// `created_at` is kept as given.
+    pub fn insert(&mut self, origin: String, cookie: Cookie) {
+        let origin_host = Url::parse(&origin)
+            .ok()
+            .and_then(|url| url.host_str().map(str::to_ascii_lowercase))
+            .unwrap_or_default();
+        let scope = cookie_scope(&origin_host, &cookie);
+        let slot = self
+            .hosts
+            .entry(scope.clone())
+            .or_default()
+            .slot_mut(cookie.path.as_deref());
+        if let Some(existing) = slot
+            .iter_mut()
+            .find(|s| s.origin == origin && same_identity(&s.cookie, &cookie))
+        {
+            existing.cookie = cookie;
+        } else {
+            slot.push(StoredCookie {
+                origin,
+                seq: self.next_seq,
+                cookie,
+            });
+            self.next_seq += 1;
+        }
+        self.invalidate(&scope);
+    }
+
+    /// Every cookie in the jar with the origin that set it, in insertion order.
+    pub fn cookies(&self) -> Vec<(&str, &Cookie)> {
+        self.stored()
+            .into_iter()
+            .map(|s| (s.origin.as_str(), &s.cookie))
+            .collect()
+    }
+
+    fn stored(&self) -> Vec<&StoredCookie> {
+        let mut out = Vec::new();
+        for host in self.hosts.values() {
+            host.collect(&mut out);
+        }
+        out.sort_unstable_by_key(|s| s.seq);
+        out
+    }
+
+    /// Drops cached headers of request hosts that get cookies scoped to `scope`.
+    fn invalidate(&mut self, scope: &str) {
+        let dotted = format!(".{scope}");
+        self.header_cache
+            .get_mut()
+            .retain(|key, _| key.host != scope && !key.host.ends_with(&dotted));
+    }
+
+    /// Applies `keep` to every cookie, dropping emptied hosts and all cached headers.
+    fn retain(&mut self, mut keep: impl FnMut(&StoredCookie) -> bool) {
+        for host in self.hosts.values_mut() {
+            host.retain(&mut keep);
+        }
+        self.hosts.retain(|_, host| !host.is_empty());
+        self.header_cache.get_mut().clear();
+    }
+}
+
+/// The index key of `cookie`: its domain, or the host that set it when host-only.
+fn cookie_scope(origin_host: &str, cookie: &Cookie) -> String {
+    cookie.domain.as_deref().unwrap_or(origin_host).to_ascii_lowercase()
+}
+
+/// Cookies are unique by (name, domain, path) - RFC 6265bis §5.6.
+fn same_identity(a: &Cookie, b: &Cookie) -> bool {
+    a.name == b.name && a.domain == b.domain && a.path == b.path
 }
 
 impl CookieJar for DefaultCookieJar {
@@ -303,13 +637,15 @@ impl CookieJar for DefaultCookieJar {
         // SameSiteNoneOnly is handled per-cookie below.
 
         let request_host = url.host_str().unwrap_or_default();
+        let origin_host = request_host.to_ascii_lowercase();
         let origin = url.origin().ascii_serialization();
         let default_path = url
             .path()
             .rsplit_once('/')
             .map_or("/", |(a, _)| if a.is_empty() { "/" } else { a });
 
-        let bucket = self.entries.entry(origin).or_default();
+        // Hosts whose cookies changed; swept for expired cookies and invalidated afterwards.
+        let mut touched: Vec<String> = Vec::new();
 
         for header in headers.get_all("set-cookie") {
             // Use from_utf8 (not to_str) so that non-ASCII cookie values (e.g.
@@ -433,14 +769,21 @@ impl CookieJar for DefaultCookieJar {
                 continue;
             }
 
+            let scope = cookie_scope(&origin_host, &cookie);
+
             // Resolve expiry: Max-Age takes precedence over Expires (RFC 6265 §5.2).
             let now = Utc::now().timestamp();
             cookie.expires = if let Some(ma) = max_age {
                 if ma <= 0 {
                     // Max-Age=0 (or negative) means delete the cookie immediately.
-                    // Cookies are unique by (name, domain, path) - RFC 6265bis §5.6 - so
-                    // only evict the exact match, not every same-named cookie in this origin.
-                    bucket.retain(|c| !(c.name == cookie.name && c.domain == cookie.domain && c.path == cookie.path));
+                    // Only evict the exact (name, domain, path) match set by this origin,
+                    // not every same-named cookie.
+                    if let Some(host) = self.hosts.get_mut(&scope) {
+                        host.retain(|s| !(s.origin == origin && same_identity(&s.cookie, &cookie)));
+                    }
+                    if !touched.contains(&scope) {
+                        touched.push(scope);
+                    }
                     continue;
                 }
                 Some(now + ma)
@@ -457,21 +800,45 @@ impl CookieJar for DefaultCookieJar {
                 continue;
             }
 
-            // Cookies are unique by (name, domain, path) - RFC 6265bis §5.6.
             // On update, preserve the original creation time so path-based ordering
             // (RFC 6265bis §5.5) reflects when the cookie was *first* set.
-            if let Some(existing) = bucket
+            let slot = self
+                .hosts
+                .entry(scope.clone())
+                .or_default()
+                .slot_mut(cookie.path.as_deref());
+            if let Some(existing) = slot
                 .iter_mut()
-                .find(|c| c.name == cookie.name && c.domain == cookie.domain && c.path == cookie.path)
+                .find(|s| s.origin == origin && same_identity(&s.cookie, &cookie))
             {
-                let original_created_at = existing.created_at;
-                *existing = cookie;
-                existing.created_at = original_created_at;
+                let original_created_at = existing.cookie.created_at;
+                existing.cookie = cookie;
+                existing.cookie.created_at = original_created_at;
             } else {
                 cookie.created_at = Utc::now().timestamp_millis();
-                bucket.push(cookie);
+                slot.push(StoredCookie {
+                    origin: origin.clone(),
+                    seq: self.next_seq,
+                    cookie,
+                });
+                self.next_seq += 1;
+            }
+            if !touched.contains(&scope) {
+                touched.push(scope);
             }
         }
+
+        // Lazy expiry: hosts that just changed shed their expired cookies.
+        let now = Utc::now().timestamp();
+        for scope in touched {
+            if let Some(host) = self.hosts.get_mut(&scope) {
+                host.retain(|s| s.cookie.expires.is_none_or(|exp| exp > now));
+                if host.is_empty() {
+                    self.hosts.remove(&scope);
+                }
+            }
+            self.invalidate(&scope);
+        }
     }
 
     fn get_request_cookies(&self, url: &Url, top_level: Option<&Url>, samesite: SameSiteContext) -> Option<String> {
@@ -490,40 +857,56 @@ impl CookieJar for DefaultCookieJar {
             }
         }
 
-        let origin = url.origin().ascii_serialization();
         // RFC 4343: domain comparison is case-insensitive.
         let host_lower = url.host_str().unwrap_or_default().cow_to_ascii_lowercase();
+
+        // Domain cookies are indexed under their domain, host-only cookies under the host that
+        // set them; both can only match when that key is the request host or a parent domain.
+        let hosts: Vec<&HostCookies> = domain_suffixes(&host_lower).filter_map(|h| self.hosts.get(h)).collect();
+        if hosts.is_empty() {
+            return None;
+        }
+
+        let origin = url.origin().ascii_serialization();
         let path = url.path();
         let is_https = url.scheme() == "https";
-
         let now = Utc::now().timestamp();
 
-        // Scan ALL origin buckets:
-        // - Domain cookies (Some(domain)): send if request host matches the domain attribute,
-        //   regardless of which origin set the cookie.
-        // - Host-only cookies (None domain): send only from the exact same origin (RFC 6265 §5.3,
-        //   "host-only-flag").
-        let mut matching: Vec<&Cookie> = self
-            .entries
-            .iter()
-            .flat_map(|(bucket_origin, cookies)| cookies.iter().map(move |c| (bucket_origin.as_str(), c)))
-            .filter(|(_, cookie)| {
+        let walk = PathWalk::new(&hosts, path);
+        let key = walk.prefix.map(|prefix| HeaderKey {
+            host: host_lower.to_string(),
+            origin: origin.clone(),
+            prefix: prefix.to_string(),
+            beyond: walk.beyond,
+            samesite,
+            third_party: is_third_party,
+            policy: self.third_party_policy,
+        });
+        if let Some(cached) = key.as_ref().and_then(|key| self.header_cache.lock().get(key).cloned()) {
+            if cached.valid_until.is_none_or(|t| t > now) {
+                return cached.header;
+            }
+        }
+
+        let mut matching: Vec<&StoredCookie> = walk
+            .candidates()
+            .filter(|s| {
                 // Drop expired cookies (session cookies have expires == None).
-                cookie.expires.is_none_or(|exp| exp > now)
+                s.cookie.expires.is_none_or(|exp| exp > now)
             })
-            .filter(|(_, cookie)| {
+            .filter(|s| {
                 // Third-party policy: SameSiteNoneOnly allows only None+Secure cross-site.
                 if is_third_party && self.third_party_policy == ThirdPartyCookiePolicy::SameSiteNoneOnly {
-                    return matches!(cookie.same_site.as_deref(), Some("None")) && cookie.secure;
+                    return matches!(s.cookie.same_site.as_deref(), Some("None")) && s.cookie.secure;
                 }
                 true
             })
-            .filter(|(_, cookie)| {
+            .filter(|s| {
                 // SameSite attribute enforcement (RFC 6265bis).
                 // Cookies with no SameSite attribute default to Lax behavior.
-                match cookie.same_site.as_deref() {
+                match s.cookie.same_site.as_deref() {
                     Some("Strict") => samesite == SameSiteContext::SameSite,
-                    Some("None") => cookie.secure,
+                    Some("None") => s.cookie.secure,
                     // Lax (explicit) or absent (implicit Lax default)
                     _ => matches!(
                         samesite,
@@ -531,8 +914,8 @@ impl CookieJar for DefaultCookieJar {
                     ),
                 }
             })
-            .filter(|(bucket_origin, cookie)| {
-                match &cookie.domain {
+            .filter(|s| {
+                match &s.cookie.domain {
                     Some(domain) => {
                         // Domain cookie: case-insensitive match against request host.
                         let d = domain.cow_to_ascii_lowercase();
@@ -540,51 +923,60 @@ impl CookieJar for DefaultCookieJar {
                     }
                     None => {
                         // Host-only cookie: must originate from the exact same origin.
-                        *bucket_origin == origin.as_str()
+                        s.origin == origin
                     }
                 }
             })
-            .filter(|(_, cookie)| match &cookie.path {
-                // RFC 6265 §5.1.4 path-match.
-                Some(cookie_path) => {
-                    path == cookie_path
-                        || (path.starts_with(cookie_path.as_str())
-                            && (cookie_path.ends_with('/') || path[cookie_path.len()..].starts_with('/')))
-                }
-                None => true,
-            })
-            .filter(|(_, cookie)| !cookie.secure || is_https)
-            .map(|(_, c)| c)
+            .filter(|s| path_matches(path, s.cookie.path.as_deref()))
+            .filter(|s| !s.cookie.secure || is_https)
             .collect::<Vec<_>>();
 
         // RFC 6265bis §5.5: cookies with longer paths are sent first;
         // ties broken by creation time ascending (earlier = higher priority).
         matching.sort_by(|a, b| {
-            let len_a = a.path.as_deref().map_or(0, str::len);
-            let len_b = b.path.as_deref().map_or(0, str::len);
-            len_b.cmp(&len_a).then_with(|| a.created_at.cmp(&b.created_at))
+            let len_a = a.cookie.path.as_deref().map_or(0, str::len);
+            let len_b = b.cookie.path.as_deref().map_or(0, str::len);
+            len_b
+                .cmp(&len_a)
+                .then_with(|| a.cookie.created_at.cmp(&b.cookie.created_at))
+                .then_with(|| a.seq.cmp(&b.seq))
         });
 
         let header = matching
             .iter()
-            .map(|c| format!("{}={}", c.name, c.value))
+            .map(|s| format!("{}={}", s.cookie.name, s.cookie.value))
             .collect::<Vec<_>>()
             .join("; ");
+        let header = if header.is_empty() { None } else { Some(header) };
 
-        if header.is_empty() {
-            None
-        } else {
-            Some(header)
+        if let Some(key) = key {
+            let mut cache = self.header_cache.lock();
+            if cache.len() >= HEADER_CACHE_CAPACITY {
+                cache.clear();
+            }
+            cache.insert(
+                key,
+                CachedHeader {
+                    header: header.clone(),
+                    valid_until: matching.iter().filter_map(|s| s.cookie.expires).min(),
+                },
+            );
         }
+        header
     }
 
     fn clear(&mut self) {
-        self.entries.clear();
+        self.hosts.clear();
+        self.header_cache.get_mut().clear();
     }
 
     fn get_all_cookies(&self) -> Vec<(Url, String)> {
-        self.entries
-            .iter()
+        let mut by_origin: HashMap<&str, Vec<&Cookie>> = HashMap::new();
+        for (origin, cookie) in self.cookies() {
+            by_origin.entry(origin).or_default().push(cookie);
+        }
+        by_origin
+            .into_iter()
             .filter_map(|(origin, cookies)| {
                 Url::parse(origin).ok().map(|url| {
                     let str_ = cookies
@@ -600,22 +992,17 @@ impl CookieJar for DefaultCookieJar {
 
     fn remove_cookie(&mut self, url: &Url, cookie_name: &str) {
         let origin = url.origin().ascii_serialization();
-        if let Some(cookies) = self.entries.get_mut(&origin) {
-            cookies.retain(|c| c.name != cookie_name);
-        }
+        self.retain(|s| !(s.origin == origin && s.cookie.name == cookie_name));
     }
 
     fn remove_cookies_for_url(&mut self, url: &Url) {
         let origin = url.origin().ascii_serialization();
-        self.entries.remove(&origin);
+        self.retain(|s| s.origin != origin);
     }
 
     fn purge_expired(&mut self) {
         let now = Utc::now().timestamp();
-        for cookies in self.entries.values_mut() {
-            cookies.retain(|c| c.expires.is_none_or(|exp| exp > now));
-        }
-        self.entries.retain(|_, v| !v.is_empty());
+        self.retain(|s| s.cookie.expires.is_none_or(|exp| exp > now));
     }
 }
 
@@ -1168,10 +1555,9 @@ mod tests {
         let req = url("https://example.com/");
         jar.store_response_cookies(&req, &headers(&["good=1; Path=/; Max-Age=3600"]), None);
         // Manually insert an already-expired cookie to simulate time passing.
-        jar.entries
-            .entry(req.origin().ascii_serialization())
-            .or_default()
-            .push(crate::engine::cookies::Cookie {
+        jar.insert(
+            req.origin().ascii_serialization(),
+            crate::engine::cookies::Cookie {
                 name: "stale".into(),
                 value: "old".into(),
                 path: Some("/".into()),
@@ -1181,7 +1567,8 @@ mod tests {
                 same_site: None,
                 http_only: false,
                 created_at: 0,
-            });
+            },
+        );
 
         jar.purge_expired();
 
@@ -1212,4 +1599,75 @@ mod tests {
             );
         }
     }
+
+    #[test]
+    fn cached_header_follows_mutations() {
+        let mut jar = DefaultCookieJar::new();
+        let req = url("https://example.com/app/page");
+        jar.store_response_cookies(&req, &headers(&["a=1; Path=/"]), None);
+        let get = |jar: &DefaultCookieJar| jar.get_request_cookies(&req, None, SameSiteContext::SameSite);
+        assert_eq!(get(&jar).as_deref(), Some("a=1"));
+        assert_eq!(get(&jar).as_deref(), Some("a=1"), "served from the header cache");
+
+        jar.store_response_cookies(
+            &url("https://www.example.com/"),
+            &headers(&["d=4; Domain=example.com; Path=/app"]),
+            None,
+        );
+        assert_eq!(
+            get(&jar).as_deref(),
+            Some("d=4; a=1"),
+            "a parent-domain cookie invalidates"
+        );
+
+        jar.store_response_cookies(&req, &headers(&["a=1; Path=/; Max-Age=0"]), None);
+        assert_eq!(get(&jar).as_deref(), Some("d=4"));
+
+        jar.remove_cookies_for_url(&url("https://www.example.com/"));
+        assert_eq!(get(&jar), None);
+    }
+
+    #[test]
+    fn cached_headers_keep_paths_sharing_a_node_apart() {
+        let mut jar = DefaultCookieJar::new();
+        let req = url("https://example.com/");
+        jar.store_response_cookies(&req, &headers(&["dir=1; Path=/docs/", "exact=2; Path=/docs"]), None);
+        let get = |path: &str| jar.get_request_cookies(&req.join(path).unwrap(), None, SameSiteContext::SameSite);
+
+        assert_eq!(get("/docs").as_deref(), Some("exact=2"));
+        assert_eq!(get("/docs/").as_deref(), Some("dir=1; exact=2"));
+        assert_eq!(get("/docs/a/b").as_deref(), Some("dir=1; exact=2"));
+        assert_eq!(get("/docsx"), None);
+        // Repeated after the cache is warm.
+        assert_eq!(get("/docs").as_deref(), Some("exact=2"));
+        assert_eq!(get("/docs/x").as_deref(), Some("dir=1; exact=2"));
+    }
+
+    #[test]
+    fn serialization_round_trips_by_origin() {
+        let mut jar = DefaultCookieJar::new().with_policy(ThirdPartyCookiePolicy::Block);
+        jar.store_response_cookies(
+            &url("https://example.com/"),
+            &headers(&["a=1; Path=/", "b=2; Path=/"]),
+            None,
+        );
+        jar.store_response_cookies(&url("https://other.org/x/y"), &headers(&["c=3"]), None);
+
+        let json = serde_json::to_value(&jar).unwrap();
+        assert_eq!(json["entries"]["https://example.com"].as_array().map(Vec::len), Some(2));
+        assert_eq!(json["entries"]["https://other.org"][0]["path"], "/x");
+
+        let back: DefaultCookieJar = serde_json::from_value(json).unwrap();
+        assert_eq!(back.third_party_policy, ThirdPartyCookiePolicy::Block);
+        assert_eq!(
+            back.get_request_cookies(&url("https://example.com/"), None, SameSiteContext::SameSite)
+                .as_deref(),
+            Some("a=1; b=2")
+        );
+        assert_eq!(
+            back.get_request_cookies(&url("https://other.org/x/z"), None, SameSiteContext::SameSite)
+                .as_deref(),
+            Some("c=3")
+        );
+    }
 }
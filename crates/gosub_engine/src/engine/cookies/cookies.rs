@@ -165,6 +165,9 @@ impl CookieStoreHandle {
     pub fn persist_zone_from_snapshot(&self, zone: ZoneId, snap: &DefaultCookieJar) {
         self.0.persist_zone_from_snapshot(zone, snap);
     }
+    pub fn jar_changed(&self, zone: ZoneId, jar: &DefaultCookieJar) {
+        self.0.jar_changed(zone, jar);
+    }
     pub fn persist_all(&self) {
         self.0.persist_all();
     }
@@ -4,9 +4,11 @@ use crate::engine::zone::ZoneId;
 use http::HeaderMap;
 use url::Url;
 
-/// A `CookieJar` decorator that persists changes after each mutation.
+/// A `CookieJar` decorator that reports every mutation to its cookie store.
 ///
-/// This type is *transparent* for reads but *eagerly* persists after writes.
+/// This type is *transparent* for reads. After each write it hands the jar to
+/// [`CookieStore::jar_changed`](crate::engine::cookies::CookieStore::jar_changed); the
+/// persisting stores batch those into background writes.
 pub struct PersistentCookieJar {
     /// Zone ID associated with this jar (used to address the store).
     zone_id: ZoneId,
@@ -19,7 +21,7 @@ pub struct PersistentCookieJar {
 impl PersistentCookieJar {
     /// Creates a new persistence-enabled wrapper around an existing jar.
     ///
-    /// The `store` will be used to persist snapshots after each mutation.
+    /// The `store` is told about every mutation so it can persist it.
     pub fn new(zone_id: ZoneId, jar: CookieJarHandle, store_handle: CookieStoreHandle) -> Self {
         Self {
             zone_id,
@@ -28,23 +30,17 @@ impl PersistentCookieJar {
         }
     }
 
-    /// Snapshots the inner jar and persists it to the backing store.
+    /// Reports the inner jar's state to the backing store.
     ///
     /// Persistence is best-effort: if the inner jar is not a [`DefaultCookieJar`]
-    /// (the downcast is required to obtain a cloneable snapshot), the snapshot is
-    /// skipped and an error is logged.
+    /// (the only shape stores can serialize), nothing is reported and an error is logged.
     fn persist(&self) {
-        // Create a snapshot of the current state of the cookie jar. This is what we will store with "persist()"
-        let snapshot = {
-            let inner = self.inner.read();
-            let Some(jar) = inner.as_any().downcast_ref::<DefaultCookieJar>() else {
-                log::error!("Inner jar is not a DefaultCookieJar; skipping cookie persistence");
-                return;
-            };
-            jar.clone()
+        let inner = self.inner.read();
+        let Some(jar) = inner.as_any().downcast_ref::<DefaultCookieJar>() else {
+            log::error!("Inner jar is not a DefaultCookieJar; skipping cookie persistence");
+            return;
         };
-
-        self.store_handle.persist_zone_from_snapshot(self.zone_id, &snapshot);
+        self.store_handle.jar_changed(self.zone_id, jar);
     }
 }
 
@@ -7,7 +7,7 @@
 //! - Provide a **`cookie_store`** in `ZoneServices`. The engine will obtain (or
 //!   initialize) the zone’s jar via [`CookieStore::jar_for`] and wrap it in a
 //!   [`PersistentCookieJar`](crate::engine::cookies::PersistentCookieJar) so that
-//!   **every mutation** snapshots to the store.
+//!   every mutation is reported to the store, which writes it out shortly after.
 //! - Or provide a **`cookie_jar`** directly (e.g., [`DefaultCookieJar`]) for
 //!   ephemeral/private zones with no persistence.
 //!
@@ -87,9 +87,11 @@
 //! - Implementations must be `Send + Sync` and safe for concurrent use.
 //! - [`CookieStore::jar_for`] should return the **same logical jar** for a given
 //!   `ZoneId` across calls, so all holders observe consistent state.
-//! - With a [`PersistentCookieJar`], the engine will call
-//!   [`CookieStore::persist_zone_from_snapshot`] after each mutation to keep durable
-//!   state in sync.
+//! - With a [`PersistentCookieJar`], every mutation calls [`CookieStore::jar_changed`].
+//!   The JSON and SQLite stores only mark the zone dirty there; a background writer
+//!   persists all zones changed within [`WRITE_BEHIND_DELAY`] in one file rewrite or one
+//!   transaction. [`CookieStore::release_zone`] and [`CookieStore::persist_all`] still
+//!   write synchronously, so nothing is pending once they return.
 //!
 //! ## Provided backends
 //! - [`JsonCookieStore`]: file-backed JSON (easy to inspect/debug).
@@ -105,6 +107,7 @@ use crate::engine::cookies::persistent_cookie_jar::PersistentCookieJar;
 use crate::engine::zone::ZoneId;
 use parking_lot::RwLock;
 use std::collections::HashMap;
+use std::time::Duration;
 
 /// In-memory cookie store
 pub use in_memory::InMemoryCookieStore;
@@ -145,6 +148,17 @@ pub trait CookieStore: Send + Sync {
     /// This should be **best-effort** and must not panic.
     fn persist_zone_from_snapshot(&self, zone_id: ZoneId, snapshot: &DefaultCookieJar);
 
+    /// Called by [`PersistentCookieJar`] after every mutation of `zone_id`'s jar, with the
+    /// jar's current state.
+    ///
+    /// The default persists `jar` right away via [`CookieStore::persist_zone_from_snapshot`].
+    /// Stores that batch their writes mark the zone dirty instead and persist it later.
+    ///
+    /// Runs while the jar is locked, so it must not block on the jar itself.
+    fn jar_changed(&self, zone_id: ZoneId, jar: &DefaultCookieJar) {
+        self.persist_zone_from_snapshot(zone_id, jar);
+    }
+
     /// Removes all persisted cookie data for `zone_id` from the store.
     ///
     /// Implementations should also drop any internal cache for this zone so that
@@ -216,6 +230,31 @@ pub(crate) fn evict_and_snapshot(
     zone_id: ZoneId,
 ) -> Option<DefaultCookieJar> {
     let handle = jars.write().remove(&zone_id)?;
+    snapshot(&handle)
+}
+
+/// Snapshots the cached jars of `zones`, skipping zones no longer cached.
+///
+/// The cache lock is released before the jars are read, so a jar being mutated (and
+/// reporting to the store) never waits on it.
+pub(crate) fn snapshot_zones(
+    jars: &RwLock<HashMap<ZoneId, CookieJarHandle>>,
+    zones: &[ZoneId],
+) -> Vec<(ZoneId, DefaultCookieJar)> {
+    let handles: Vec<(ZoneId, CookieJarHandle)> = {
+        let jars = jars.read();
+        zones
+            .iter()
+            .filter_map(|zone_id| jars.get(zone_id).map(|handle| (*zone_id, handle.clone())))
+            .collect()
+    };
+    handles
+        .into_iter()
+        .filter_map(|(zone_id, handle)| snapshot(&handle).map(|jar| (zone_id, jar)))
+        .collect()
+}
+
+fn snapshot(handle: &CookieJarHandle) -> Option<DefaultCookieJar> {
     let jar = handle.read();
     let persist = jar.as_any().downcast_ref::<PersistentCookieJar>()?;
     let inner = persist.inner.read();
@@ -243,3 +282,6 @@ pub(crate) fn snapshot_cached_jars(
         save(*zone_id, default);
     }
 }
+
+/// How long the persisting stores let jar changes pile up before writing them out together.
+pub(crate) const WRITE_BEHIND_DELAY: Duration = Duration::from_millis(500);
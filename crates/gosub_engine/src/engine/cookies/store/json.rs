@@ -2,8 +2,9 @@
 //!
 //! `JsonCookieStore` persists **all zones'** cookie jars in a single JSON file on disk.
 //! It implements the [`CookieStore`] trait and returns per-zone jars wrapped in
-//! [`PersistentCookieJar`], so that **every mutation** to a jar triggers a snapshot
-//! write back to this store.
+//! [`PersistentCookieJar`]. Jar mutations only mark the zone dirty; a background writer
+//! rewrites the file once for all zones changed within
+//! [`WRITE_BEHIND_DELAY`](super::WRITE_BEHIND_DELAY).
 //!
 //! ### Design
 //! - One file for all zones (`CookieStoreFile { zones: HashMap<ZoneId, DefaultCookieJar> }`).
@@ -17,8 +18,8 @@
 //! - Returned jars are `Arc<RwLock<_>>` and safe to share across threads.
 //!
 //! ### I/O characteristics & caveats
-//! - `persist_zone_from_snapshot` and `remove_zone` **read then rewrite** the entire
-//!   JSON file. For large datasets, consider an SQLite-backed store.
+//! - Each write-behind batch, `persist_zone_from_snapshot` and `remove_zone` **read then
+//!   rewrite** the entire JSON file. For large datasets, consider an SQLite-backed store.
 //! - Writes go to a temp file which is then renamed over the target (atomic on
 //!   POSIX filesystems).
 //! - Persistence is best-effort: I/O and serialization errors are logged, never panicked on.
@@ -34,12 +35,13 @@ use parking_lot::RwLock;
 use std::collections::HashMap;
 use std::fs;
 use std::path::PathBuf;
-use std::sync::Arc;
+use std::sync::{Arc, Weak};
 
 use crate::engine::cookies::cookie_jar::DefaultCookieJar;
-use crate::engine::cookies::store::CookieStore;
+use crate::engine::cookies::store::{snapshot_zones, CookieStore, WRITE_BEHIND_DELAY};
 use crate::engine::cookies::{CookieJarHandle, CookieStoreHandle};
 use crate::engine::zone::ZoneId;
+use crate::util::WriteBehind;
 use crate::EngineError;
 use serde::{Deserialize, Serialize};
 
@@ -55,7 +57,7 @@ struct CookieStoreFile {
 ///
 /// The store caches per-zone jars in memory and loads/saves them to a single JSON file.
 /// Jars returned by this store are wrapped in [`PersistentCookieJar`], so that writes
-/// automatically trigger persistence to disk.
+/// automatically reach the disk after a short write-behind delay.
 pub struct JsonCookieStore {
     /// Path to the JSON file where cookies are stored.
     path: PathBuf,
@@ -67,6 +69,9 @@ pub struct JsonCookieStore {
     ///
     /// This is initialized in [`new`](Self::new) and then read-only thereafter.
     store_self: RwLock<Option<CookieStoreHandle>>,
+
+    /// Batches the changes reported through [`CookieStore::jar_changed`].
+    write_behind: WriteBehind<ZoneId>,
 }
 
 impl JsonCookieStore {
@@ -86,10 +91,16 @@ impl JsonCookieStore {
             fs::write(&path, bytes).map_err(|e| EngineError::CookieStore(e.into()))?;
         }
 
-        let store = Arc::new(Self {
+        let store = Arc::new_cyclic(|store: &Weak<Self>| Self {
             path,
             jars: RwLock::new(HashMap::new()),
             store_self: RwLock::new(None),
+            write_behind: WriteBehind::spawn(
+                "cookie-json-writer",
+                WRITE_BEHIND_DELAY,
+                store.clone(),
+                Self::flush_zones,
+            ),
         });
 
         *store.store_self.write() = Some(CookieStoreHandle::from(store.clone()));
@@ -138,6 +149,19 @@ impl JsonCookieStore {
     }
 }
 
+impl JsonCookieStore {
+    /// Writes the current state of `zones` with one file rewrite.
+    fn flush_zones(&self, zones: Vec<ZoneId>) {
+        let snapshots = snapshot_zones(&self.jars, &zones);
+        if snapshots.is_empty() {
+            return;
+        }
+        let mut file = self.load_file();
+        file.zones.extend(snapshots);
+        self.save_file(&file);
+    }
+}
+
 impl CookieStore for JsonCookieStore {
     /// Returns the cookie jar handle for `zone_id`, creating it if needed.
     ///
@@ -158,16 +182,24 @@ impl CookieStore for JsonCookieStore {
 
     /// Persists a snapshot of `zone_id`'s jar to disk (best-effort).
     ///
-    /// Called by [`PersistentCookieJar`] after each mutation. This method reads
-    /// the current file, updates/replaces the zone entry, and writes the file back.
+    /// This method reads the current file, updates/replaces the zone entry, and writes
+    /// the file back.
     fn persist_zone_from_snapshot(&self, zone_id: ZoneId, snapshot: &DefaultCookieJar) {
         let mut store_file = self.load_file();
         store_file.zones.insert(zone_id, snapshot.clone());
         self.save_file(&store_file);
     }
 
+    /// Queues `zone_id` for the next write-behind batch.
+    fn jar_changed(&self, zone_id: ZoneId, jar: &DefaultCookieJar) {
+        if !self.write_behind.mark(zone_id) {
+            self.persist_zone_from_snapshot(zone_id, jar);
+        }
+    }
+
     /// Persists a final snapshot for `zone_id` and evicts its cached jar; on-disk data stays.
     fn release_zone(&self, zone_id: ZoneId) {
+        let _writing = self.write_behind.take(&zone_id);
         if let Some(snapshot) = crate::cookies::store::evict_and_snapshot(&self.jars, zone_id) {
             self.persist_zone_from_snapshot(zone_id, &snapshot);
         }
@@ -175,6 +207,7 @@ impl CookieStore for JsonCookieStore {
 
     /// Removes `zone_id` from both the in-memory cache and the on-disk file (best-effort).
     fn remove_zone(&self, zone_id: ZoneId) {
+        let _writing = self.write_behind.take(&zone_id);
         self.jars.write().remove(&zone_id);
 
         let mut file = self.load_file();
@@ -187,6 +220,7 @@ impl CookieStore for JsonCookieStore {
     /// Only jars of type [`PersistentCookieJar`] that wrap a [`DefaultCookieJar`]
     /// are snapshotted here. This avoids double-wrapping and keeps the format stable.
     fn persist_all(&self) {
+        let _writing = self.write_behind.take_all();
         let jars = self.jars.read();
 
         let mut file = self.load_file();
@@ -202,6 +236,7 @@ impl CookieStore for JsonCookieStore {
 mod tests {
     use super::*;
     use crate::engine::cookies::persistent_cookie_jar::PersistentCookieJar;
+    use crate::engine::cookies::{CookieJar, SameSiteContext};
     use http::HeaderMap;
     use std::fs::File;
     use std::io::Read;
@@ -309,4 +344,37 @@ mod tests {
         let parsed2: CookieStoreFile = serde_json::from_str(&s2).unwrap();
         assert!(parsed2.zones.contains_key(&z1));
     }
+
+    #[test]
+    fn jar_changes_are_written_behind_in_one_batch() {
+        let dir = tempdir().unwrap();
+        let path = dir.path().join("cookies.json");
+        let store = JsonCookieStore::new(path.clone()).unwrap();
+
+        let zone = ZoneId::new();
+        let handle = store.jar_for(zone).unwrap();
+        let url: Url = "https://example.com/".parse().unwrap();
+        handle
+            .write()
+            .store_response_cookies(&url, &mk_headers(&["a=1; Path=/"]), None);
+        handle
+            .write()
+            .store_response_cookies(&url, &mk_headers(&["b=2; Path=/"]), None);
+
+        let read_back = || {
+            let s = std::fs::read_to_string(&path).unwrap();
+            let parsed: CookieStoreFile = serde_json::from_str(&s).unwrap();
+            parsed
+                .zones
+                .get(&zone)
+                .and_then(|jar| CookieJar::get_request_cookies(jar, &url, None, SameSiteContext::SameSite))
+        };
+        assert_eq!(read_back(), None, "changes are not written synchronously");
+
+        let deadline = std::time::Instant::now() + std::time::Duration::from_secs(10);
+        while read_back().as_deref() != Some("a=1; b=2") {
+            assert!(std::time::Instant::now() < deadline, "write-behind batch never landed");
+            std::thread::sleep(std::time::Duration::from_millis(20));
+        }
+    }
 }
@@ -2,8 +2,9 @@
 //!
 //! `SqliteCookieStore` persists **all zones'** cookie jars in a single SQLite
 //! database. It implements the [`CookieStore`] trait and returns per-zone jars
-//! wrapped in a [`PersistentCookieJar`], so that **every mutation** to a jar
-//! triggers a snapshot write back to this store.
+//! wrapped in a [`PersistentCookieJar`]. Jar mutations only mark the zone dirty; a
+//! background writer saves all zones changed within
+//! [`WRITE_BEHIND_DELAY`](super::WRITE_BEHIND_DELAY) in a single transaction.
 //!
 //! ## Design
 //! - One **table** (`cookies`) for all zones; each row is a single cookie.
@@ -19,7 +20,8 @@
 //!   across threads.
 //!
 //! ## I/O characteristics & caveats
-//! - `save_zone` **rewrites** the set of cookies for a zone (DELETE + INSERT).
+//! - `save_zones` **rewrites** the set of cookies for each zone (DELETE + INSERT), one
+//!   transaction per batch.
 //! - Persistence is best-effort: database errors are logged, never panicked on.
 //!
 //! ## Example
@@ -33,22 +35,23 @@
 use parking_lot::RwLock;
 use std::collections::HashMap;
 use std::path::PathBuf;
-use std::sync::Arc;
+use std::sync::{Arc, Weak};
 
 use r2d2::{Pool, PooledConnection};
 use r2d2_sqlite::rusqlite::params;
 use r2d2_sqlite::SqliteConnectionManager;
 
 use crate::engine::cookies::cookie_jar::{CookieJar, DefaultCookieJar};
-use crate::engine::cookies::store::CookieStore;
+use crate::engine::cookies::store::{snapshot_zones, CookieStore, WRITE_BEHIND_DELAY};
 use crate::engine::cookies::{Cookie, CookieJarHandle, CookieStoreHandle};
 use crate::engine::zone::ZoneId;
+use crate::util::WriteBehind;
 use crate::EngineError;
 
 /// A SQLite-based cookie store that persists cookies across sessions.
 ///
-/// Creates per-zone jars on demand, caches them in memory, and snapshots them
-/// back to SQLite after each mutation (via [`PersistentCookieJar`]).
+/// Creates per-zone jars on demand, caches them in memory, and writes their
+/// changes back to SQLite in write-behind batches (via [`PersistentCookieJar`]).
 pub struct SqliteCookieStore {
     /// Connection pool for SQLite database (so it can run multithreaded)
     pool: Pool<SqliteConnectionManager>,
@@ -56,6 +59,8 @@ pub struct SqliteCookieStore {
     jars: RwLock<HashMap<ZoneId, CookieJarHandle>>,
     /// Self handle provided to persistent jars for callback persistence.
     store_self: RwLock<Option<CookieStoreHandle>>,
+    /// Batches the changes reported through [`CookieStore::jar_changed`].
+    write_behind: WriteBehind<ZoneId>,
 }
 
 impl SqliteCookieStore {
@@ -110,10 +115,16 @@ impl SqliteCookieStore {
             let _ = conn.execute_batch("ALTER TABLE cookies ADD COLUMN created_at INTEGER NOT NULL DEFAULT 0;");
         }
 
-        let store = Arc::new(Self {
+        let store = Arc::new_cyclic(|store: &Weak<Self>| Self {
             pool,
             jars: RwLock::new(HashMap::new()),
             store_self: RwLock::new(None),
+            write_behind: WriteBehind::spawn(
+                "cookie-sqlite-writer",
+                WRITE_BEHIND_DELAY,
+                store.clone(),
+                Self::flush_zones,
+            ),
         });
 
         {
@@ -178,7 +189,7 @@ impl SqliteCookieStore {
         };
 
         for (origin, entry) in rows.flatten() {
-            jar.entries.entry(origin).or_default().push(entry);
+            jar.insert(origin, entry);
         }
 
         // Remove any cookies that expired while the browser was closed.
@@ -186,27 +197,22 @@ impl SqliteCookieStore {
         jar
     }
 
-    /// Replaces all cookies for `zone_id` with the contents of `jar` in a transaction.
+    /// Replaces all cookies of each zone in `jars` with its snapshot, in one transaction.
     ///
-    /// DELETEs the existing rows for the zone and INSERTs the new set.
-    /// Best-effort: on database errors the snapshot is skipped and the error is logged.
-    fn save_zone(&self, zone_id: ZoneId, jar: &DefaultCookieJar) {
+    /// DELETEs the existing rows for each zone and INSERTs the new set.
+    /// Best-effort: on database errors the batch is skipped and the error is logged.
+    fn save_zones(&self, jars: &[(ZoneId, &DefaultCookieJar)]) {
         let Some(mut conn) = self.conn() else {
             return;
         };
         let tx = match conn.transaction() {
             Ok(tx) => tx,
             Err(e) => {
-                log::error!("Failed to start cookie transaction for zone {zone_id}: {e}");
+                log::error!("Failed to start cookie transaction: {e}");
                 return;
             }
         };
 
-        if let Err(e) = tx.execute("DELETE FROM cookies WHERE zone_id = ?1", [zone_id.to_string()]) {
-            log::error!("Failed to delete cookies for zone {zone_id}: {e}");
-            return;
-        }
-
         {
             let mut stmt = match tx.prepare(
                 "INSERT INTO cookies (zone_id, origin, name, value, path, domain, secure, expires, same_site, http_only, created_at)
@@ -219,8 +225,12 @@ impl SqliteCookieStore {
                 }
             };
 
-            for (origin, cookies) in &jar.entries {
-                for cookie in cookies {
+            for (zone_id, jar) in jars {
+                if let Err(e) = tx.execute("DELETE FROM cookies WHERE zone_id = ?1", [zone_id.to_string()]) {
+                    log::error!("Failed to delete cookies for zone {zone_id}: {e}");
+                    return;
+                }
+                for (origin, cookie) in jar.cookies() {
                     if let Err(e) = stmt.execute(params![
                         zone_id.to_string(),
                         origin,
@@ -242,7 +252,20 @@ impl SqliteCookieStore {
         }
 
         if let Err(e) = tx.commit() {
-            log::error!("Failed to commit cookie snapshot for zone {zone_id}: {e}");
+            log::error!("Failed to commit cookie snapshot of {} zone(s): {e}", jars.len());
+        }
+    }
+
+    /// Writes the current state of `zones` in one transaction.
+    fn flush_zones(&self, zones: Vec<ZoneId>) {
+        let snapshots = snapshot_zones(&self.jars, &zones);
+        if !snapshots.is_empty() {
+            self.save_zones(
+                &snapshots
+                    .iter()
+                    .map(|(zone_id, jar)| (*zone_id, jar))
+                    .collect::<Vec<_>>(),
+            );
         }
     }
 
@@ -273,31 +296,50 @@ impl CookieStore for SqliteCookieStore {
     }
 
     /// Persists a snapshot of `zone_id`'s jar to SQLite.
-    ///
-    /// Called by [`PersistentCookieJar`] after each mutation.
     fn persist_zone_from_snapshot(&self, zone_id: ZoneId, snapshot: &DefaultCookieJar) {
-        self.save_zone(zone_id, snapshot);
+        self.save_zones(&[(zone_id, snapshot)]);
+    }
+
+    /// Queues `zone_id` for the next write-behind batch.
+    fn jar_changed(&self, zone_id: ZoneId, jar: &DefaultCookieJar) {
+        if !self.write_behind.mark(zone_id) {
+            self.save_zones(&[(zone_id, jar)]);
+        }
     }
 
     /// Persists a final snapshot for `zone_id` and evicts its cached jar; database rows stay.
     fn release_zone(&self, zone_id: ZoneId) {
+        let _writing = self.write_behind.take(&zone_id);
         if let Some(snapshot) = crate::cookies::store::evict_and_snapshot(&self.jars, zone_id) {
-            self.save_zone(zone_id, &snapshot);
+            self.save_zones(&[(zone_id, &snapshot)]);
         }
     }
 
     /// Removes `zone_id` from both the in-memory cache and the database.
     fn remove_zone(&self, zone_id: ZoneId) {
+        let _writing = self.write_behind.take(&zone_id);
         self.jars.write().remove(&zone_id);
         self.remove_zone_from_db(zone_id);
     }
 
-    /// Persists **all** in-memory jars to SQLite by snapshotting them.
+    /// Persists **all** in-memory jars to SQLite by snapshotting them, in one transaction.
     ///
     /// Only jars of type [`PersistentCookieJar`] that wrap a [`DefaultCookieJar`]
     /// are snapshotted here to keep the on-disk format stable.
     fn persist_all(&self) {
-        let jars = self.jars.read();
-        crate::cookies::store::snapshot_cached_jars(&jars, |zone_id, snapshot| self.save_zone(zone_id, snapshot));
+        let _writing = self.write_behind.take_all();
+        let mut snapshots = Vec::new();
+        {
+            let jars = self.jars.read();
+            crate::cookies::store::snapshot_cached_jars(&jars, |zone_id, snapshot| {
+                snapshots.push((zone_id, snapshot.clone()));
+            });
+        }
+        self.save_zones(
+            &snapshots
+                .iter()
+                .map(|(zone_id, jar)| (*zone_id, jar))
+                .collect::<Vec<_>>(),
+        );
     }
 }
@@ -467,10 +467,9 @@ mod cookie_tests {
         let mut jar = jar();
         let origin = u("https://example.com/");
         jar.store_response_cookies(&origin, &set_headers(&["live=1; Path=/; Max-Age=3600"]), None);
-        jar.entries
-            .entry(origin.origin().ascii_serialization())
-            .or_default()
-            .push(crate::engine::cookies::Cookie {
+        jar.insert(
+            origin.origin().ascii_serialization(),
+            crate::engine::cookies::Cookie {
                 name: "dead".into(),
                 value: "0".into(),
                 path: Some("/".into()),
@@ -480,7 +479,8 @@ mod cookie_tests {
                 same_site: None,
                 http_only: false,
                 created_at: 0,
-            });
+            },
+        );
         jar.purge_expired();
         let result = get_cookies(&jar, "https://example.com/").unwrap_or_default();
         assert!(result.contains("live=1"));
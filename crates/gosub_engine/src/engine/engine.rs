@@ -27,11 +27,12 @@ use crate::engine::DEFAULT_CHANNEL_CAPACITY;
 use crate::html::RenderConfiguration;
 use crate::net::req_ref_tracker::RequestReferenceMap;
 use crate::net::{fetcher_config_from, spawn_io_thread, IoHandle};
+use crate::storage::StorageService;
 use crate::zone::{Zone, ZoneConfig, ZoneId, ZoneServices, ZoneSink};
 use crate::{EngineConfig, EngineError};
 use anyhow::Result;
 use gosub_config::Config;
-use parking_lot::{Mutex, RwLock};
+use parking_lot::RwLock;
 use std::collections::HashMap;
 use std::sync::{Arc, OnceLock};
 use std::time::Duration;
@@ -51,11 +52,13 @@ pub struct GosubEngine<C: RenderConfiguration = crate::html::DefaultRenderConfig
     compositor: Arc<C::CompositorSink>,
     /// The engine's single font system (the config's `FontSystem`), shared with the layouter
     /// (measurement) and the renderer (drawing) so the two agree.
-    font_system: Arc<Mutex<C::FontSystem>>,
+    font_system: Arc<C::FontSystem>,
     /// Zones managed by this engine, indexed by [`ZoneId`].
     zones: HashMap<ZoneId, Arc<ZoneSink>>,
     /// Cookie stores of zones that requested persistence, flushed on shutdown.
     cookie_stores: HashMap<ZoneId, CookieStoreHandle>,
+    /// Storage services of the zones, whose local storage is flushed on close and shutdown.
+    storages: HashMap<ZoneId, Arc<StorageService>>,
     /// Command sender used to send commands to the engine run loop.
     cmd_tx: mpsc::Sender<EngineCommand>,
     /// Command receiver (owned by the engine run loop).
@@ -137,9 +140,10 @@ impl<C: RenderConfiguration> GosubEngine<C> {
             }),
             render_backend: backend,
             compositor,
-            font_system: Arc::new(Mutex::new(C::FontSystem::default())),
+            font_system: Arc::new(C::FontSystem::default()),
             zones: HashMap::new(),
             cookie_stores: HashMap::new(),
+            storages: HashMap::new(),
             cmd_tx,
             cmd_rx: Some(cmd_rx),
             io_handle: None,
@@ -166,6 +170,13 @@ impl<C: RenderConfiguration> GosubEngine<C> {
         let _ = self.context.io_tx.set(io_handle.subscribe());
         self.io_handle = Some(io_handle);
 
+        // Decoded images and SVG rasters are shared by every tab, so their budgets are engine-wide.
+        let image_budget_mb = self.context.config_store.get_uint("renderer.image.cache_budget_mb") as u64;
+        gosub_render_pipeline::common::media::DecodedImageCache::global()
+            .set_limit(image_budget_mb.saturating_mul(1 << 20));
+        let svg_budget_mb = self.context.config_store.get_uint("renderer.svg.cache_budget_mb") as u64;
+        gosub_render_pipeline::common::media::SvgRasterCache::global().set_limit(svg_budget_mb.saturating_mul(1 << 20));
+
         // Start metrics HTTP server (GET http://127.0.0.1:9090/metrics)
         #[cfg(feature = "metrics")]
         crate::metrics::start(9090);
@@ -253,12 +264,18 @@ impl<C: RenderConfiguration> GosubEngine<C> {
         Ok(())
     }
 
-    /// Flush all persistent state (currently: cookie stores) to disk.
+    /// Flush all persistent state (cookie stores, local storage) to disk.
     fn flush_persistence(&self) {
         for (zone_id, store) in &self.cookie_stores {
             log::trace!("persisting cookie store of zone {zone_id}");
             store.persist_all();
         }
+        for (zone_id, storage) in &self.storages {
+            log::trace!("flushing local storage of zone {zone_id}");
+            if let Err(e) = storage.flush() {
+                log::error!("Failed to flush local storage of zone {zone_id}: {e}");
+            }
+        }
     }
 
     /// Create and register a new zone, returning a [`ZoneHandle`] for userland code.
@@ -286,6 +303,7 @@ impl<C: RenderConfiguration> GosubEngine<C> {
         }
         let config = config.unwrap_or_else(|| self.context.config.default_zone_config.clone());
         let cookie_store = services.cookie_store.clone();
+        let storage = services.storage.clone();
 
         let zone = match zone_id {
             Some(zone_id) => Zone::new_with_id(
@@ -312,6 +330,7 @@ impl<C: RenderConfiguration> GosubEngine<C> {
         if let Some(store) = cookie_store {
             self.cookie_stores.insert(zone_id, store);
         }
+        self.storages.insert(zone_id, storage);
 
         self.context
             .event_tx
@@ -321,10 +340,10 @@ impl<C: RenderConfiguration> GosubEngine<C> {
         Ok(zone)
     }
 
-    /// Close a zone: stop its tabs and fetcher, release its cookie jar, and free
-    /// its [`EngineConfig::max_zones`] slot.
+    /// Close a zone: stop its tabs and fetcher, release its cookie jar and local
+    /// storage, and free its [`EngineConfig::max_zones`] slot.
     ///
-    /// Persisted cookie data stays on disk (the zone can be reopened later with the
+    /// Persisted cookie and local storage data stays on disk (the zone can be reopened later with the
     /// same [`ZoneId`]); only the in-memory state is released. Emits
     /// [`EngineEvent::ZoneClosed`] when done.
     #[instrument(name = "engine.close_zone", level = "debug", skip(self, zone))]
@@ -348,6 +367,9 @@ impl<C: RenderConfiguration> GosubEngine<C> {
         if let Some(store) = self.cookie_stores.remove(&zone_id) {
             store.release_zone(zone_id);
         }
+        if let Some(storage) = self.storages.remove(&zone_id) {
+            storage.release_zone(zone_id);
+        }
 
         self.zones.remove(&zone_id);
 
@@ -361,6 +383,7 @@ mod tests {
     use crate::storage::{InMemoryLocalStore, InMemorySessionStore, PartitionPolicy, StorageService};
     use gosub_render_pipeline::render::backends::null::NullBackend;
     use gosub_render_pipeline::render::DefaultCompositor;
+    use parking_lot::Mutex;
 
     fn services() -> ZoneServices {
         ZoneServices {
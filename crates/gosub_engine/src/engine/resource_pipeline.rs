@@ -7,15 +7,19 @@ use crate::engine::resource_pipeline::font::{FontPipeline, FontPipelineImpl};
 use crate::engine::resource_pipeline::html::{HtmlPipeline, HtmlPipelineImpl};
 use crate::engine::resource_pipeline::image::{ImagePipeline, ImagePipelineImpl};
 use crate::engine::resource_pipeline::js::{JsPipeline, JsPipelineImpl};
+use crate::engine::resource_pipeline::preload::Preloads;
 use crate::engine::types::IoChannel;
 use crate::html::RenderConfiguration;
+use crate::net::http_cache::HttpCache;
 use crate::zone::ZoneId;
+use std::sync::Arc;
 
 pub mod css;
 pub mod font;
 pub mod html;
 pub mod image;
 pub mod js;
+pub mod preload;
 
 /// Resource pipeline entry points used by the router for each resource type.
 pub struct ResourcePipelines<C: RenderConfiguration> {
@@ -30,13 +34,24 @@ pub struct ResourcePipelines<C: RenderConfiguration> {
 }
 
 impl<C: RenderConfiguration> ResourcePipelines<C> {
-    pub fn new(zone_id: ZoneId, io_tx: IoChannel, accept_language: Option<String>, max_document_bytes: usize) -> Self {
+    /// `preloads` receives the sub-resources the HTML pipeline fetches ahead of their consumers;
+    /// those fetches go through the zone's `http_cache`.
+    pub fn new(
+        zone_id: ZoneId,
+        io_tx: IoChannel,
+        accept_language: Option<String>,
+        max_document_bytes: usize,
+        preloads: Arc<Preloads>,
+        http_cache: Arc<HttpCache>,
+    ) -> Self {
         Self {
             html: Box::new(HtmlPipelineImpl::new(
                 zone_id,
                 io_tx,
                 accept_language,
                 max_document_bytes,
+                preloads,
+                http_cache,
             )),
             css: Box::new(CssPipelineImpl {}),
             js: Box::new(JsPipelineImpl {}),
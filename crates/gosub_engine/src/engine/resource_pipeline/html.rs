@@ -1,7 +1,9 @@
+use crate::engine::resource_pipeline::preload::{stylesheet_parser, Preloaded, Preloads, StylesheetParser};
 use crate::engine::types::{IoChannel, PeekBuf, RequestId};
-use crate::html::{parse_main_document_stream, EngineDocument, RenderConfiguration, ResourceHint};
+use crate::html::{discover_font_faces, parse_main_document_stream, EngineDocument, RenderConfiguration, ResourceHint};
+use crate::net::http_cache::{CacheLookup, HttpCache};
 use crate::net::req_ref_tracker::REF_REGISTRY;
-use crate::net::types::{FetchHandle, FetchRequest, FetchResultMeta, Initiator};
+use crate::net::types::{FetchHandle, FetchRequest, FetchResultMeta, Initiator, ResourceKind};
 use crate::net::{submit_to_io, SharedBody};
 use crate::util::spawn_named;
 use crate::zone::ZoneId;
@@ -14,8 +16,10 @@ use http::Method;
 use parking_lot::Mutex;
 use std::sync::Arc;
 use tokio::io::AsyncRead;
+use tokio::select;
 use tokio::task::JoinHandle;
 use tokio_util::io::StreamReader;
+use tokio_util::sync::CancellationToken;
 
 #[async_trait]
 pub trait HtmlPipeline<C: RenderConfiguration> {
@@ -44,15 +48,28 @@ pub struct HtmlPipelineImpl {
     accept_language: Option<String>,
     /// Max document size in bytes (`net.document.max_bytes`); larger documents are truncated.
     max_document_bytes: usize,
+    /// Where the bodies of discovered stylesheets, fonts and images go for their consumers.
+    preloads: Arc<Preloads>,
+    /// The zone's HTTP cache, consulted before fetching a discovered resource.
+    http_cache: Arc<HttpCache>,
 }
 
 impl HtmlPipelineImpl {
-    pub fn new(zone_id: ZoneId, io_tx: IoChannel, accept_language: Option<String>, max_document_bytes: usize) -> Self {
+    pub fn new(
+        zone_id: ZoneId,
+        io_tx: IoChannel,
+        accept_language: Option<String>,
+        max_document_bytes: usize,
+        preloads: Arc<Preloads>,
+        http_cache: Arc<HttpCache>,
+    ) -> Self {
         Self {
             io_tx,
             zone_id,
             accept_language,
             max_document_bytes,
+            preloads,
+            http_cache,
         }
     }
 
@@ -69,19 +86,9 @@ impl HtmlPipelineImpl {
     {
         let cfg = crate::html::HtmlParseConfig {
             max_bytes: self.max_document_bytes,
+            stylesheet_source: Some(self.preloads.stylesheet_source()),
         };
 
-        let io_tx = self.io_tx.clone();
-        let zone_id = self.zone_id;
-        let parent_ref = request.reference;
-        let parent_cancel = handle.cancel.clone();
-
-        let child_handles = Arc::new(Mutex::new(Vec::<FetchHandle>::new()));
-        let child_tasks = Arc::new(Mutex::new(Vec::<JoinHandle<()>>::new()));
-
-        let child_handles_for_closure = child_handles.clone();
-        let child_tasks_for_closure = child_tasks.clone();
-
         let mut sub_headers = http::HeaderMap::new();
         if let Some(langs) = &self.accept_language {
             if let Ok(val) = langs.parse() {
@@ -89,44 +96,16 @@ impl HtmlPipelineImpl {
             }
         }
 
-        let mut on_discover = |hint: ResourceHint| {
-            let sub_req_id = RequestId::new();
-            REF_REGISTRY.register_request(sub_req_id, hint.kind, Initiator::Parser);
-            let sub_req = FetchRequest::builder(Method::GET, hint.url)
-                .with_req_id(sub_req_id)
-                .with_reference(parent_ref)
-                .with_priority(hint.priority)
-                .with_initiator(Initiator::Parser.to_net())
-                .with_kind(hint.kind.to_net())
-                .with_headers(sub_headers.clone())
-                .with_streaming(true)
-                .with_auto_decode(true)
-                .build();
-
-            let io_tx_cloned = io_tx.clone();
-            let parent_cancel_cloned = parent_cancel.clone();
-            let child_handles = child_handles_for_closure.clone();
-            let child_tasks = child_tasks_for_closure.clone();
-
-            // Parent cancelled, so we don't have to do anything
-            if parent_cancel_cloned.is_cancelled() {
-                return;
-            }
-
-            let join_handle = spawn_named("html-sub-resource", async move {
-                match submit_to_io(zone_id, sub_req, io_tx_cloned, Some(parent_cancel_cloned)).await {
-                    Ok((child_handle, rx)) => {
-                        child_handles.lock().push(child_handle);
-
-                        let _ = rx.await;
-                    }
-                    Err(e) => {
-                        log::warn!("Failed to submit discovered resource request: {:?}", e);
-                    }
-                }
-            });
-
-            child_tasks.lock().push(join_handle);
+        let fetcher = SubresourceFetcher {
+            zone_id: self.zone_id,
+            io_tx: self.io_tx.clone(),
+            parent_ref: request.reference,
+            parent_cancel: handle.cancel.clone(),
+            headers: sub_headers,
+            preloads: self.preloads.clone(),
+            http_cache: self.http_cache.clone(),
+            parse_stylesheet: stylesheet_parser::<C::CssSystem>(),
+            tasks: Arc::new(Mutex::new(Vec::new())),
         };
 
         let was_cancelled = handle.cancel.is_cancelled();
@@ -137,20 +116,18 @@ impl HtmlPipelineImpl {
             reader,
             handle.cancel.clone(),
             cfg,
-            &mut on_discover,
+            |hint| fetcher.fetch(hint),
         )
         .await;
 
-        // Cancel the parent token so that all child fetch tokens (which are children of
-        // parent_cancel via child_token()) are also cancelled. This works regardless of
-        // whether the spawned submission tasks have run yet, since the cancellation
-        // propagates to any child tokens created from parent_cancel in the future too.
-        parent_cancel.cancel();
-
-        // On error or parent cancellation, also await all child tasks to clean up.
+        // On error or parent cancellation, cancel the parent token so that all child fetch tokens
+        // (children of it via child_token()) are cancelled too, and await the child tasks to clean
+        // up. A parsed document keeps its preloads running: fonts and images are picked up after
+        // the parse. They end with the navigation, which cancels the parent token.
         if was_cancelled || res.is_err() {
+            fetcher.parent_cancel.cancel();
             let joins: Vec<JoinHandle<()>> = {
-                let mut g = child_tasks.lock();
+                let mut g = fetcher.tasks.lock();
                 std::mem::take(&mut *g)
             };
 
@@ -163,6 +140,135 @@ impl HtmlPipelineImpl {
     }
 }
 
+/// Fetches the sub-resources the document scan discovers, from the zone's HTTP cache or through
+/// its I/O thread, and hands the bodies of the ones the engine consumes to the [`Preloads`] store.
+#[derive(Clone)]
+struct SubresourceFetcher {
+    zone_id: ZoneId,
+    io_tx: IoChannel,
+    parent_ref: gosub_sonar::RequestReference,
+    parent_cancel: CancellationToken,
+    headers: http::HeaderMap,
+    preloads: Arc<Preloads>,
+    http_cache: Arc<HttpCache>,
+    /// Parses preloaded stylesheets as they arrive, for the tree builder.
+    parse_stylesheet: StylesheetParser,
+    tasks: Arc<Mutex<Vec<JoinHandle<()>>>>,
+}
+
+impl SubresourceFetcher {
+    fn fetch(&self, hint: ResourceHint) {
+        // Parent cancelled, so we don't have to do anything
+        if self.parent_cancel.is_cancelled() {
+            return;
+        }
+
+        // Scripts are not executed yet; their fetch only warms the connection.
+        let ticket = match hint.kind {
+            ResourceKind::Stylesheet | ResourceKind::Font | ResourceKind::Image => match self.preloads.begin(&hint.url)
+            {
+                Some(ticket) => Some(ticket),
+                // Already on its way.
+                None => return,
+            },
+            _ => None,
+        };
+
+        let mut headers = self.headers.clone();
+        let cached = match self.http_cache.lookup(&hint.url) {
+            CacheLookup::Hit(cached) => Some(cached),
+            CacheLookup::Revalidate(validators) => {
+                headers.extend(validators);
+                None
+            }
+            CacheLookup::Miss => None,
+        };
+        // A cached script has no connection left to warm.
+        if cached.is_some() && ticket.is_none() {
+            return;
+        }
+
+        let this = self.clone();
+        let join_handle = spawn_named("html-sub-resource", async move {
+            let cached = match cached {
+                Some(cached) => cached.load().await,
+                None => None,
+            };
+            let result = match cached {
+                Some(cached) => cached,
+                None => {
+                    let sub_req = this.request(&hint, headers);
+                    let (child_handle, rx) = match submit_to_io(
+                        this.zone_id,
+                        sub_req,
+                        this.io_tx.clone(),
+                        Some(this.parent_cancel.clone()),
+                    )
+                    .await
+                    {
+                        Ok(submitted) => submitted,
+                        Err(e) => {
+                            log::warn!("Failed to submit discovered resource request: {:?}", e);
+                            return;
+                        }
+                    };
+                    let result = select! {
+                        _ = child_handle.cancel.cancelled() => return,
+                        r = rx => r,
+                    };
+                    let Ok(result) = result else {
+                        return;
+                    };
+                    this.http_cache.complete(&hint.url, result).await
+                }
+            };
+            let Some(ticket) = ticket else {
+                return;
+            };
+            let Some(mut preloaded) = Preloaded::from_result(result).await else {
+                return;
+            };
+            if hint.kind == ResourceKind::Stylesheet {
+                let css = String::from_utf8_lossy(&preloaded.body).into_owned();
+                // Fonts of an external stylesheet are discovered as soon as the sheet arrives,
+                // rather than when the tab worker gets to them after the parse.
+                for font in discover_font_faces(&css, &hint.url) {
+                    this.fetch(font);
+                }
+                // Parsed on the blocking pool, next to the other sheets and the document, so
+                // the tree builder only adds it.
+                let parse = Arc::clone(&this.parse_stylesheet);
+                let url = hint.url.clone();
+                preloaded.stylesheet = tokio::task::spawn_blocking(move || {
+                    let _t = timing_guard!("css.stylesheet", url.as_str());
+                    parse(&css, &url)
+                })
+                .await
+                .ok()
+                .flatten();
+            }
+            ticket.complete(preloaded);
+        });
+
+        self.tasks.lock().push(join_handle);
+    }
+
+    fn request(&self, hint: &ResourceHint, headers: http::HeaderMap) -> FetchRequest {
+        let sub_req_id = RequestId::new();
+        REF_REGISTRY.register_request(sub_req_id, hint.kind, Initiator::Parser);
+        FetchRequest::builder(Method::GET, hint.url.clone())
+            .with_req_id(sub_req_id)
+            .with_reference(self.parent_ref)
+            .with_priority(hint.priority)
+            .with_initiator(Initiator::Parser.to_net())
+            .with_kind(hint.kind.to_net())
+            .with_headers(headers)
+            .with_streaming(false)
+            .with_auto_decode(true)
+            .build()
+    }
+}
+
 #[async_trait]
 impl<C: RenderConfiguration> HtmlPipeline<C> for HtmlPipelineImpl {
     async fn parse_stream(
@@ -197,7 +303,7 @@ mod tests {
     use crate::events::IoCommand;
     use crate::html::DefaultRenderConfig;
     use crate::net::req_ref_tracker::RequestReference;
-    use crate::net::types::{Priority, ResourceKind};
+    use crate::net::types::{FetchResult, Priority};
     use crate::NavigationId;
     use std::time::Duration;
     use tokio::sync::mpsc;
@@ -286,7 +392,8 @@ mod tests {
         // Arrange
         let (io_tx, seen_children) = start_dummy_io();
         let zone_id = ZoneId::new();
-        let mut pipeline = HtmlPipelineImpl::new(zone_id, io_tx, None, 10 * 1024 * 1024);
+        let mut pipeline =
+            HtmlPipelineImpl::new(zone_id, io_tx, None, 10 * 1024 * 1024, Arc::default(), Arc::default());
 
         let (req, handle) = test_request("https://example.com/path/index.html");
         let meta = test_meta("https://example.com/path/index.html");
@@ -309,13 +416,15 @@ mod tests {
     }
 
     #[tokio::test(flavor = "current_thread")]
-    async fn parse_bytes_cancels_children_on_finish() {
+    async fn parse_bytes_leaves_preloads_running_after_finish() {
         // Arrange
         let (io_tx, seen_children) = start_dummy_io();
         let zone_id = ZoneId::new();
-        let mut pipeline = HtmlPipelineImpl::new(zone_id, io_tx, None, 10 * 1024 * 1024);
+        let mut pipeline =
+            HtmlPipelineImpl::new(zone_id, io_tx, None, 10 * 1024 * 1024, Arc::default(), Arc::default());
 
         let (req, handle) = test_request("https://example.com/");
+        let document_cancel = handle.cancel.clone();
         let meta = test_meta("https://example.com/");
         let body = HTML_WITH_RESOURCES.as_bytes();
 
@@ -323,18 +432,60 @@ mod tests {
         let _ = HtmlPipeline::<DefaultRenderConfig>::parse_bytes(&mut pipeline, req, handle, meta, body)
             .await
             .expect("parse ok");
-
-        // Give the pipeline a tick to run the post-parse cancellation
         sleep(Duration::from_millis(10)).await;
 
-        // Assert: all recorded children are canceled (pipeline proactively cancels them at end)
+        // Assert: the children outlive the parse, and end with the document's fetch
         let children = seen_children.lock();
         assert!(!children.is_empty(), "expected subresource children to be recorded");
+        assert!(children.iter().all(|h| !h.cancel.is_cancelled()));
+        document_cancel.cancel();
         for h in children.iter() {
             assert!(
                 h.cancel.is_cancelled(),
-                "child handle should be canceled after parse end"
+                "child handle should be canceled with its document"
             );
         }
     }
+
+    #[tokio::test(flavor = "current_thread")]
+    async fn preloaded_stylesheets_reach_the_tree_builder() {
+        // An I/O thread serving every request with a stylesheet.
+        let (io_tx, mut rx) = mpsc::unbounded_channel::<IoCommand>();
+        let fetched = Arc::new(Mutex::new(0usize));
+        let fetched_by_io = fetched.clone();
+        tokio::spawn(async move {
+            while let Some(cmd) = rx.recv().await {
+                if let IoCommand::Fetch { reply_tx, .. } = cmd {
+                    *fetched_by_io.lock() += 1;
+                    let _ = reply_tx.send(FetchResult::Buffered {
+                        meta: test_meta("https://example.com/a.css"),
+                        body: Bytes::from_static(b"p { color: red; }"),
+                    });
+                }
+            }
+        });
+        let preloads = Arc::new(Preloads::default());
+        let mut pipeline = HtmlPipelineImpl::new(
+            ZoneId::new(),
+            io_tx,
+            None,
+            10 * 1024 * 1024,
+            preloads.clone(),
+            Arc::default(),
+        );
+
+        let html = r#"<html><head><link rel="stylesheet" href="/a.css"><link rel="preload" as="style" href="/a.css">
+            </head><body></body></html>"#;
+        let (req, handle) = test_request("https://example.com/");
+        let meta = test_meta("https://example.com/");
+        let doc = HtmlPipeline::<DefaultRenderConfig>::parse_bytes(&mut pipeline, req, handle, meta, html.as_bytes())
+            .await
+            .expect("parse ok");
+
+        // The author sheet came from the preload (fetching it directly would fail offline), which
+        // was requested once although the document names it twice.
+        use gosub_interface::document::Document as _;
+        assert_eq!(doc.stylesheets().len(), 2, "UA and author stylesheet");
+        assert_eq!(*fetched.lock(), 1);
+    }
 }
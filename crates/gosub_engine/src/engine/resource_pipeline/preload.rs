@@ -0,0 +1,345 @@
+//! Sub-resources fetched ahead of the code that uses them.
+//!
+//! The HTML pipeline scans the document bytes as they download and starts fetching the
+//! stylesheets, web fonts and images they reference right away. The bodies land in a
+//! [`Preloads`] store, keyed by URL. The tree builder (stylesheets), the tab worker (web fonts)
+//! and the media store (images) take them from there instead of fetching them again. A consumer
+//! that finds its URL still downloading waits for it, so the request is never made twice.
+//!
+//! Stylesheets are parsed as soon as their body arrives, on the blocking pool and in parallel with
+//! each other and with the document, so the tree builder gets them ready to add (see
+//! [`StylesheetParser`]).
+//!
+//! One store lives per navigation. A body is handed out once; a second consumer of the same URL
+//! fetches it the regular way.
+
+use crate::net::stream_to_bytes;
+use crate::net::types::FetchResult;
+use bytes::Bytes;
+use gosub_html5::parser::{parse_external_stylesheet, StylesheetSource, SuppliedStylesheet};
+use gosub_interface::css3::{CssOrigin, CssSystem};
+use parking_lot::{Condvar, Mutex};
+use std::any::Any;
+use std::collections::HashMap;
+use std::sync::Arc;
+use std::time::Duration;
+use tokio::sync::Notify;
+use url::Url;
+
+/// Bytes of preloaded bodies a store holds at once; preloads finishing over it are dropped and
+/// their consumers fetch on their own.
+pub const PRELOAD_BUDGET: u64 = 32 << 20;
+
+/// Longest a consumer waits for a preload still downloading before fetching on its own.
+pub const PRELOAD_WAIT: Duration = Duration::from_secs(30);
+
+/// Parses the body of a preloaded stylesheet into the document's `CssSystem::Stylesheet`, boxed
+/// for [`SuppliedStylesheet::Parsed`].
+pub type StylesheetParser = Arc<dyn Fn(&str, &Url) -> Option<Box<dyn Any + Send>> + Send + Sync>;
+
+/// A [`StylesheetParser`] for documents styled by `S`.
+pub fn stylesheet_parser<S: CssSystem>() -> StylesheetParser {
+    Arc::new(|css: &str, url: &Url| {
+        let sheet = parse_external_stylesheet::<S>(css, CssOrigin::Author, url)?;
+        Some(Box::new(sheet) as Box<dyn Any + Send>)
+    })
+}
+
+/// A successful (2xx) response body fetched ahead of its consumer.
+#[derive(Debug)]
+pub struct Preloaded {
+    pub content_type: Option<String>,
+    pub body: Bytes,
+    /// The body parsed by a [`StylesheetParser`], for stylesheets.
+    pub stylesheet: Option<Box<dyn Any + Send>>,
+}
+
+impl Preloaded {
+    /// The body of a 2xx fetch result, or `None` for anything else.
+    pub async fn from_result(result: FetchResult) -> Option<Self> {
+        let (meta, body) = match result {
+            FetchResult::Buffered { meta, body } => (meta, body),
+            FetchResult::Stream { meta, peek_buf, shared } => (meta, stream_to_bytes(peek_buf, shared).await.ok()?),
+            FetchResult::Error(_) => return None,
+        };
+        if !(200..300).contains(&meta.status) {
+            return None;
+        }
+        let content_type = meta
+            .headers
+            .get(http::header::CONTENT_TYPE)
+            .and_then(|v| v.to_str().ok())
+            .map(str::to_string);
+        Some(Self {
+            content_type,
+            body,
+            stylesheet: None,
+        })
+    }
+}
+
+enum SlotState {
+    Pending,
+    Ready(Preloaded),
+    /// Failed, dropped over budget, or already handed out.
+    Gone,
+}
+
+struct Slot {
+    state: Mutex<SlotState>,
+    /// Wakes blocking waiters once the slot leaves `Pending`.
+    settled: Condvar,
+    /// Wakes async waiters once the slot leaves `Pending`.
+    notify: Notify,
+}
+
+impl Slot {
+    /// Hands out the body once the slot has settled; `None` while it is still pending.
+    fn take_settled(state: &mut SlotState) -> Option<Option<Preloaded>> {
+        match std::mem::replace(state, SlotState::Gone) {
+            SlotState::Pending => {
+                *state = SlotState::Pending;
+                None
+            }
+            SlotState::Ready(preloaded) => Some(Some(preloaded)),
+            SlotState::Gone => Some(None),
+        }
+    }
+}
+
+#[derive(Default)]
+struct Inner {
+    slots: HashMap<Url, Arc<Slot>>,
+    /// Bytes held by `Ready` slots.
+    bytes: u64,
+}
+
+/// See the module documentation.
+pub struct Preloads {
+    inner: Mutex<Inner>,
+    budget: u64,
+}
+
+impl Default for Preloads {
+    fn default() -> Self {
+        Self::new(PRELOAD_BUDGET)
+    }
+}
+
+impl Preloads {
+    /// A store holding at most `budget` bytes of bodies.
+    pub fn new(budget: u64) -> Self {
+        Self {
+            inner: Mutex::new(Inner::default()),
+            budget,
+        }
+    }
+
+    /// Registers a preload of `url`, or `None` if it was already preloaded (or is being).
+    /// Consumers asking for `url` from now on wait for the returned ticket to complete.
+    pub fn begin(self: &Arc<Self>, url: &Url) -> Option<PreloadTicket> {
+        let mut inner = self.inner.lock();
+        if inner.slots.contains_key(url) {
+            return None;
+        }
+        let slot = Arc::new(Slot {
+            state: Mutex::new(SlotState::Pending),
+            settled: Condvar::new(),
+            notify: Notify::new(),
+        });
+        inner.slots.insert(url.clone(), Arc::clone(&slot));
+        Some(PreloadTicket {
+            store: Arc::clone(self),
+            slot,
+            settled: false,
+        })
+    }
+
+    fn slot(&self, url: &Url) -> Option<Arc<Slot>> {
+        self.inner.lock().slots.get(url).cloned()
+    }
+
+    fn handed_out(&self, preloaded: &Preloaded) {
+        let mut inner = self.inner.lock();
+        inner.bytes = inner.bytes.saturating_sub(preloaded.body.len() as u64);
+    }
+
+    /// The preloaded body of `url`, blocking up to `timeout` while it is still downloading. `None`
+    /// if it was never preloaded, failed, or is taking longer.
+    pub fn wait(&self, url: &Url, timeout: Duration) -> Option<Preloaded> {
+        let slot = self.slot(url)?;
+        let mut state = slot.state.lock();
+        slot.settled
+            .wait_while_for(&mut state, |s| matches!(s, SlotState::Pending), timeout);
+        let preloaded = Slot::take_settled(&mut state).flatten()?;
+        self.handed_out(&preloaded);
+        Some(preloaded)
+    }
+
+    /// Async [`Self::wait`], for consumers running on the runtime.
+    pub async fn take(&self, url: &Url, timeout: Duration) -> Option<Preloaded> {
+        let slot = self.slot(url)?;
+        let settled = async {
+            loop {
+                // Registered before the check so a completion in between is not missed.
+                let notified = slot.notify.notified();
+                let settled = Slot::take_settled(&mut slot.state.lock());
+                if let Some(preloaded) = settled {
+                    return preloaded;
+                }
+                notified.await;
+            }
+        };
+        let preloaded = tokio::time::timeout(timeout, settled).await.ok().flatten()?;
+        self.handed_out(&preloaded);
+        Some(preloaded)
+    }
+
+    /// A [`StylesheetSource`] for the tree builder that waits for preloaded stylesheets. Sheets
+    /// parsed on arrival are handed over as they are; the others as text.
+    pub fn stylesheet_source(self: &Arc<Self>) -> StylesheetSource {
+        let store = Arc::clone(self);
+        Arc::new(move |url: &Url| {
+            let preloaded = store.wait(url, PRELOAD_WAIT)?;
+            Some(match preloaded.stylesheet {
+                Some(sheet) => SuppliedStylesheet::Parsed(sheet),
+                None => SuppliedStylesheet::Text(String::from_utf8_lossy(&preloaded.body).into_owned()),
+            })
+        })
+    }
+}
+
+/// A preload in flight, see [`Preloads::begin`]. Dropping it without completing fails the
+/// preload, which releases anyone waiting for it.
+pub struct PreloadTicket {
+    store: Arc<Preloads>,
+    slot: Arc<Slot>,
+    settled: bool,
+}
+
+impl PreloadTicket {
+    /// Stores the body for its consumer.
+    pub fn complete(mut self, preloaded: Preloaded) {
+        let len = preloaded.body.len() as u64;
+        let admitted = {
+            let mut inner = self.store.inner.lock();
+            let admitted = inner.bytes + len <= self.store.budget;
+            if admitted {
+                inner.bytes += len;
+            }
+            admitted
+        };
+        if !admitted {
+            log::debug!("Preloaded body of {len} bytes exceeds the preload budget; dropping it");
+        }
+        self.settle(if admitted {
+            SlotState::Ready(preloaded)
+        } else {
+            SlotState::Gone
+        });
+    }
+
+    fn settle(&mut self, state: SlotState) {
+        self.settled = true;
+        *self.slot.state.lock() = state;
+        self.slot.settled.notify_all();
+        self.slot.notify.notify_waiters();
+    }
+}
+
+impl Drop for PreloadTicket {
+    fn drop(&mut self) {
+        if !self.settled {
+            self.settle(SlotState::Gone);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn url(path: &str) -> Url {
+        Url::parse("https://example.com/").unwrap().join(path).unwrap()
+    }
+
+    fn body(len: usize) -> Preloaded {
+        Preloaded {
+            content_type: Some("text/css".into()),
+            body: Bytes::from(vec![b'x'; len]),
+            stylesheet: None,
+        }
+    }
+
+    #[test]
+    fn hands_a_body_out_once() {
+        let store = Arc::new(Preloads::default());
+        let ticket = store.begin(&url("a.css")).unwrap();
+        assert!(store.begin(&url("a.css")).is_none(), "a URL is preloaded once");
+        ticket.complete(body(4));
+
+        assert_eq!(store.wait(&url("a.css"), Duration::ZERO).unwrap().body.len(), 4);
+        assert!(store.wait(&url("a.css"), Duration::ZERO).is_none());
+        assert!(store.wait(&url("b.css"), Duration::ZERO).is_none());
+    }
+
+    #[test]
+    fn waiters_block_until_the_preload_completes() {
+        let store = Arc::new(Preloads::default());
+        let ticket = store.begin(&url("a.css")).unwrap();
+        let waiter = {
+            let store = Arc::clone(&store);
+            std::thread::spawn(move || store.wait(&url("a.css"), PRELOAD_WAIT))
+        };
+        std::thread::sleep(Duration::from_millis(20));
+        ticket.complete(body(8));
+        assert_eq!(waiter.join().unwrap().map(|p| p.body.len()), Some(8));
+    }
+
+    #[test]
+    fn dropped_tickets_release_waiters() {
+        let store = Arc::new(Preloads::default());
+        let ticket = store.begin(&url("a.css")).unwrap();
+        drop(ticket);
+        assert!(store.wait(&url("a.css"), PRELOAD_WAIT).is_none());
+    }
+
+    #[test]
+    fn bodies_over_budget_are_dropped() {
+        let store = Arc::new(Preloads::new(10));
+        store.begin(&url("a.css")).unwrap().complete(body(8));
+        store.begin(&url("b.css")).unwrap().complete(body(8));
+        assert!(store.wait(&url("b.css"), Duration::ZERO).is_none());
+        // Handing a body out frees its share of the budget.
+        assert!(store.wait(&url("a.css"), Duration::ZERO).is_some());
+        store.begin(&url("c.css")).unwrap().complete(body(8));
+        assert!(store.wait(&url("c.css"), Duration::ZERO).is_some());
+    }
+
+    #[test]
+    fn parsed_stylesheets_are_handed_over_parsed() {
+        let store = Arc::new(Preloads::default());
+        let parse = stylesheet_parser::<gosub_css3::system::Css3System>();
+        let mut preloaded = body(4);
+        preloaded.stylesheet = parse("p { color: red; }", &url("a.css"));
+        assert!(preloaded.stylesheet.is_some());
+        store.begin(&url("a.css")).unwrap().complete(preloaded);
+        store.begin(&url("b.css")).unwrap().complete(body(4));
+
+        let source = store.stylesheet_source();
+        assert!(matches!(source(&url("a.css")), Some(SuppliedStylesheet::Parsed(_))));
+        assert!(matches!(source(&url("b.css")), Some(SuppliedStylesheet::Text(text)) if text == "xxxx"));
+    }
+
+    #[tokio::test(flavor = "current_thread")]
+    async fn async_consumers_wait_for_the_preload() {
+        let store = Arc::new(Preloads::default());
+        let ticket = store.begin(&url("logo.png")).unwrap();
+        tokio::spawn(async move {
+            tokio::time::sleep(Duration::from_millis(10)).await;
+            ticket.complete(body(3));
+        });
+        let got = store.take(&url("logo.png"), PRELOAD_WAIT).await;
+        assert_eq!(got.map(|p| p.body.len()), Some(3));
+    }
+}
@@ -144,6 +144,10 @@ mod test {
         let cfg = default_config();
         // Engine settings.
         assert_eq!(cfg.get_uint("renderer.tile.size"), 256);
+        assert_eq!(cfg.get_uint("renderer.tile.cache_budget_mb"), 256);
+        assert_eq!(cfg.get_uint("renderer.image.cache_budget_mb"), 512);
+        assert_eq!(cfg.get_uint("renderer.svg.cache_budget_mb"), 64);
+        assert_eq!(cfg.get_uint("net.media.per_origin"), 6);
         assert_eq!(cfg.get_uint("engine.channel_capacity"), 512);
         assert_eq!(cfg.get_string("security.sandbox_mode"), "balanced");
         // User-agent settings (namespaced via merge).
@@ -35,7 +35,9 @@
 //!
 //! # Choosing a backend
 //!
-//! - For persistent **LocalStorage**, use [`SqliteLocalStore`].
+//! - For persistent **LocalStorage**, use [`SqliteLocalStore`]. It serves reads from memory
+//!   and writes changes in batches shortly after; the engine flushes it when a zone closes
+//!   and at shutdown.
 //! - For ephemeral **SessionStorage**, use [`InMemorySessionStore`].
 //! - For testing or incognito modes, you can use in-memory for both.
 //!
@@ -34,6 +34,14 @@ pub trait StorageArea: Send + Sync {
 pub trait LocalStore: Send + Sync {
     /// Retrieves a storage area for the given zone, partition, and origin.
     fn area(&self, zone: ZoneId, part: &PartitionKey, origin: &url::Origin) -> Result<Arc<dyn StorageArea>>;
+
+    /// Writes out changes the store still holds in memory. Called at engine shutdown.
+    fn flush(&self) -> Result<()> {
+        Ok(())
+    }
+
+    /// Writes out and forgets the cached areas of `zone`. Called when the zone closes.
+    fn release_zone(&self, _zone: ZoneId) {}
 }
 
 /// Store for sessionStorage-like areas (isolated per (zone, tab, partition, origin)).
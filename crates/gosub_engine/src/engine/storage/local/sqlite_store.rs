@@ -1,16 +1,41 @@
+//! SQLite-backed localStorage.
+//!
+//! Each `(zone, partition, origin)` area is read from the database once, the first time it is
+//! asked for, and kept in memory; every tab of the zone shares that copy. Reads never touch
+//! SQLite. Mutations update the copy and are queued; a background writer applies everything
+//! changed within [`FLUSH_DELAY`] in one transaction. [`LocalStore::flush`] (engine shutdown)
+//! and [`LocalStore::release_zone`] (zone close) write synchronously, as does dropping the store.
+
 use anyhow::Result;
-use r2d2::{Pool, PooledConnection};
+use parking_lot::Mutex;
+use r2d2::Pool;
 use r2d2_sqlite::rusqlite::{params, OpenFlags};
 use r2d2_sqlite::SqliteConnectionManager;
-use std::sync::Arc;
+use std::collections::HashMap;
+use std::hash::{Hash, Hasher};
+use std::sync::{Arc, Weak};
+use std::time::Duration;
 
 use crate::engine::storage::area::{LocalStore, StorageArea};
 use crate::engine::storage::types::PartitionKey;
+use crate::util::WriteBehind;
 use crate::zone::ZoneId;
 
+/// How long mutations pile up before the writer applies them together.
+pub const FLUSH_DELAY: Duration = Duration::from_millis(500);
+
+/// `(zone, partition, origin)` as stored in the `local_storage` table.
+type AreaKey = (ZoneId, String, String);
+
 /// SQLite-based local storage implementation
 pub struct SqliteLocalStore {
+    inner: Arc<StoreInner>,
+}
+
+struct StoreInner {
     pool: Pool<SqliteConnectionManager>,
+    areas: Mutex<HashMap<AreaKey, Arc<SqliteLocalArea>>>,
+    write_behind: WriteBehind<DirtyArea>,
 }
 
 impl SqliteLocalStore {
@@ -41,110 +66,356 @@ impl SqliteLocalStore {
             .connection_timeout(std::time::Duration::from_secs(5))
             .build(manager)?;
 
-        Ok(Self { pool })
+        let inner = Arc::new_cyclic(|store: &Weak<StoreInner>| StoreInner {
+            pool,
+            areas: Mutex::new(HashMap::new()),
+            write_behind: WriteBehind::spawn(
+                "local-storage-writer",
+                FLUSH_DELAY,
+                store.clone(),
+                StoreInner::flush_batch,
+            ),
+        });
+        Ok(Self { inner })
     }
 }
 
 impl LocalStore for SqliteLocalStore {
     fn area(&self, zone: ZoneId, part: &PartitionKey, origin: &url::Origin) -> Result<Arc<dyn StorageArea>> {
-        Ok(Arc::new(SqliteLocalArea {
-            pool: self.pool.clone(),
-            zone,
-            partition: match part {
-                PartitionKey::None => "".to_string(),
-                PartitionKey::TopLevel(o) => format!("top:{}", o.ascii_serialization()),
-                PartitionKey::Custom(s) => s.to_string(),
-            },
-            origin: origin.ascii_serialization(),
-        }))
+        let partition = match part {
+            PartitionKey::None => "".to_string(),
+            PartitionKey::TopLevel(o) => format!("top:{}", o.ascii_serialization()),
+            PartitionKey::Custom(s) => s.to_string(),
+        };
+        let key = (zone, partition, origin.ascii_serialization());
+        if let Some(area) = self.inner.areas.lock().get(&key) {
+            return Ok(area.clone());
+        }
+
+        // Loaded outside the lock; when two callers race, the first inserted copy wins.
+        let items = self.inner.load(&key)?;
+        let mut areas = self.inner.areas.lock();
+        let area = areas.entry(key).or_insert_with_key(|(zone, partition, origin)| {
+            Arc::new_cyclic(|me| SqliteLocalArea {
+                zone: *zone,
+                partition: partition.clone(),
+                origin: origin.clone(),
+                store: Arc::downgrade(&self.inner),
+                me: me.clone(),
+                state: Mutex::new(AreaState {
+                    items,
+                    pending: Changes::default(),
+                }),
+            })
+        });
+        Ok(area.clone())
+    }
+
+    fn flush(&self) -> Result<()> {
+        let (_writing, queued) = self.inner.write_behind.drain();
+        self.inner.write(&queued)
+    }
+
+    fn release_zone(&self, zone: ZoneId) {
+        if let Err(e) = self.flush() {
+            log::error!("Failed to write local storage of zone {zone}: {e}");
+        }
+        self.inner
+            .areas
+            .lock()
+            .retain(|(area_zone, _, _), _| *area_zone != zone);
+    }
+}
+
+impl Drop for SqliteLocalStore {
+    fn drop(&mut self) {
+        if let Err(e) = self.flush() {
+            log::error!("Failed to write local storage on close: {e}");
+        }
     }
 }
 
+impl StoreInner {
+    fn load(&self, (zone, partition, origin): &AreaKey) -> Result<HashMap<String, String>> {
+        let conn = self.pool.get()?;
+        let mut stmt =
+            conn.prepare_cached("SELECT key, value FROM local_storage WHERE zone=?1 AND partition=?2 AND origin=?3")?;
+        let rows = stmt.query_map(params![zone.to_string(), partition, origin], |row| {
+            Ok((row.get::<_, String>(0)?, row.get::<_, String>(1)?))
+        })?;
+        Ok(rows.collect::<std::result::Result<_, _>>()?)
+    }
+
+    /// Writer thread callback.
+    fn flush_batch(&self, areas: Vec<DirtyArea>) {
+        if let Err(e) = self.write(&areas) {
+            log::warn!("Failed to write local storage, retrying with the next batch: {e}");
+        }
+    }
+
+    /// Applies the queued changes of `areas` in one transaction. On failure the changes are put
+    /// back and the areas queued again.
+    fn write(&self, areas: &[DirtyArea]) -> Result<()> {
+        let batches: Vec<_> = areas
+            .iter()
+            .filter_map(|area| area.0.take_changes().map(|changes| (area, changes)))
+            .collect();
+        if batches.is_empty() {
+            return Ok(());
+        }
+        let result = self.commit(&batches);
+        if result.is_err() {
+            for (area, changes) in batches {
+                area.0.restore(changes);
+                self.write_behind.mark(area.clone());
+            }
+        }
+        result
+    }
+
+    fn commit(&self, batches: &[(&DirtyArea, Changes)]) -> Result<()> {
+        let mut conn = self.pool.get()?;
+        let tx = conn.transaction()?;
+        {
+            let mut clear =
+                tx.prepare_cached("DELETE FROM local_storage WHERE zone=?1 AND partition=?2 AND origin=?3")?;
+            let mut upsert = tx.prepare_cached(
+                "INSERT INTO local_storage(zone,partition,origin,key,value) VALUES (?1,?2,?3,?4,?5)
+                 ON CONFLICT(zone,partition,origin,key) DO UPDATE
+                 SET value=excluded.value, updated_at=strftime('%s','now')",
+            )?;
+            let mut delete =
+                tx.prepare_cached("DELETE FROM local_storage WHERE zone=?1 AND partition=?2 AND origin=?3 AND key=?4")?;
+            for (area, changes) in batches {
+                let area = &area.0;
+                let zone = area.zone.to_string();
+                if changes.cleared {
+                    clear.execute(params![zone, area.partition, area.origin])?;
+                }
+                for (key, value) in &changes.items {
+                    match value {
+                        Some(value) => upsert.execute(params![zone, area.partition, area.origin, key, value])?,
+                        None => delete.execute(params![zone, area.partition, area.origin, key])?,
+                    };
+                }
+            }
+        }
+        tx.commit()?;
+        Ok(())
+    }
+}
+
+/// Mutations of an area not yet in the database.
+#[derive(Default)]
+struct Changes {
+    /// Delete every stored row of the area before applying `items`.
+    cleared: bool,
+    /// Latest value per key; `None` deletes it.
+    items: HashMap<String, Option<String>>,
+}
+
+impl Changes {
+    fn is_empty(&self) -> bool {
+        !self.cleared && self.items.is_empty()
+    }
+}
+
+struct AreaState {
+    /// The area's contents: what is stored plus `pending`.
+    items: HashMap<String, String>,
+    pending: Changes,
+}
+
 struct SqliteLocalArea {
-    pool: Pool<SqliteConnectionManager>,
     zone: ZoneId,
     partition: String,
     origin: String,
+    store: Weak<StoreInner>,
+    me: Weak<SqliteLocalArea>,
+    state: Mutex<AreaState>,
+}
+
+/// An area queued for writing, compared by identity.
+#[derive(Clone)]
+struct DirtyArea(Arc<SqliteLocalArea>);
+
+impl PartialEq for DirtyArea {
+    fn eq(&self, other: &Self) -> bool {
+        Arc::ptr_eq(&self.0, &other.0)
+    }
+}
+
+impl Eq for DirtyArea {}
+
+impl Hash for DirtyArea {
+    fn hash<H: Hasher>(&self, state: &mut H) {
+        Arc::as_ptr(&self.0).hash(state);
+    }
 }
 
 impl SqliteLocalArea {
-    fn conn(&self) -> Result<PooledConnection<SqliteConnectionManager>> {
-        Ok(self.pool.get()?)
+    /// Applies `mutate` to the state and queues the area if that left it with changes to
+    /// write. Without a writer thread the changes are written right away.
+    fn mutate(&self, mutate: impl FnOnce(&mut AreaState)) -> Result<()> {
+        let queue = {
+            let mut state = self.state.lock();
+            let was_clean = state.pending.is_empty();
+            mutate(&mut state);
+            // Pending areas are already queued (or being written).
+            was_clean && !state.pending.is_empty()
+        };
+        if !queue {
+            return Ok(());
+        }
+        let (Some(store), Some(me)) = (self.store.upgrade(), self.me.upgrade()) else {
+            log::warn!(
+                "Local storage of {} changed after its store closed; not persisted",
+                self.origin
+            );
+            return Ok(());
+        };
+        let area = DirtyArea(me);
+        if store.write_behind.mark(area.clone()) {
+            return Ok(());
+        }
+        let _writing = store.write_behind.take(&area);
+        store.write(std::slice::from_ref(&area))
+    }
+
+    fn take_changes(&self) -> Option<Changes> {
+        let mut state = self.state.lock();
+        if state.pending.is_empty() {
+            return None;
+        }
+        Some(std::mem::take(&mut state.pending))
+    }
+
+    /// Puts back changes whose write failed, underneath anything changed since.
+    fn restore(&self, mut older: Changes) {
+        let mut state = self.state.lock();
+        let newer = std::mem::take(&mut state.pending);
+        state.pending = if newer.cleared {
+            newer
+        } else {
+            older.items.extend(newer.items);
+            older
+        };
     }
 }
 
 impl StorageArea for SqliteLocalArea {
     fn get_item(&self, key: &str) -> Option<String> {
-        let conn = self.conn().ok()?;
-        conn.query_row(
-            "SELECT value FROM local_storage WHERE zone=?1 AND partition=?2 AND origin=?3 AND key=?4",
-            params![self.zone.to_string(), self.partition, self.origin, key],
-            |row| row.get::<_, String>(0),
-        )
-        .ok()
+        self.state.lock().items.get(key).cloned()
     }
 
     fn set_item(&self, key: &str, value: &str) -> Result<()> {
-        let conn = self.conn()?;
-        conn.execute(
-            "INSERT INTO local_storage(zone,partition,origin,key,value) VALUES (?1,?2,?3,?4,?5)
-             ON CONFLICT(zone,partition,origin,key) DO UPDATE
-             SET value=excluded.value, updated_at=strftime('%s','now')",
-            params![self.zone.to_string(), self.partition, self.origin, key, value],
-        )?;
-        Ok(())
+        self.mutate(|state| {
+            state.items.insert(key.to_string(), value.to_string());
+            state.pending.items.insert(key.to_string(), Some(value.to_string()));
+        })
     }
 
     fn remove_item(&self, key: &str) -> Result<()> {
-        let conn = self.conn()?;
-        conn.execute(
-            "DELETE FROM local_storage WHERE zone=?1 AND partition=?2 AND origin=?3 AND key=?4",
-            params![self.zone.to_string(), self.partition, self.origin, key],
-        )?;
-        Ok(())
+        self.mutate(|state| {
+            if state.items.remove(key).is_some() {
+                state.pending.items.insert(key.to_string(), None);
+            }
+        })
     }
 
     fn clear(&self) -> Result<()> {
-        let conn = self.conn()?;
-        conn.execute(
-            "DELETE FROM local_storage WHERE zone=?1 AND partition=?2 AND origin=?3",
-            params![self.zone.to_string(), self.partition, self.origin],
-        )?;
-        Ok(())
+        self.mutate(|state| {
+            if !state.items.is_empty() {
+                state.items.clear();
+                state.pending = Changes {
+                    cleared: true,
+                    items: HashMap::new(),
+                };
+            }
+        })
     }
 
     fn len(&self) -> usize {
-        let conn = match self.conn() {
-            Ok(c) => c,
-            Err(_) => return 0,
-        };
-        conn.query_row::<u32, _, _>(
-            "SELECT COUNT(*) FROM local_storage WHERE zone=?1 AND partition=?2 AND origin=?3",
-            params![self.zone.to_string(), self.partition, self.origin],
-            |row| row.get(0),
-        )
-        .unwrap_or(0) as usize
+        self.state.lock().items.len()
     }
 
     fn keys(&self) -> Vec<String> {
-        let conn = match self.conn() {
-            Ok(c) => c,
-            Err(_) => return vec![],
-        };
-        let mut stmt = match conn
-            .prepare("SELECT key FROM local_storage WHERE zone=?1 AND partition=?2 AND origin=?3 ORDER BY key")
+        let mut keys: Vec<String> = self.state.lock().items.keys().cloned().collect();
+        keys.sort();
+        keys
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn o(s: &str) -> url::Origin {
+        url::Url::parse(s).expect("valid URL").origin()
+    }
+
+    fn stored_rows(path: &str) -> i64 {
+        let conn = r2d2_sqlite::rusqlite::Connection::open(path).unwrap();
+        conn.query_row("SELECT COUNT(*) FROM local_storage", [], |row| row.get::<_, i64>(0))
+            .unwrap()
+    }
+
+    #[test]
+    fn areas_are_shared_and_survive_a_reopen() {
+        let dir = tempfile::tempdir().unwrap();
+        let path = dir.path().join("local.db");
+        let path = path.to_str().unwrap();
+        let zone = ZoneId::new();
+        let origin = o("https://example.com");
+
         {
-            Ok(s) => s,
-            Err(_) => return vec![],
-        };
+            let store = SqliteLocalStore::new(path).unwrap();
+            let a = store.area(zone, &PartitionKey::None, &origin).unwrap();
+            let b = store.area(zone, &PartitionKey::None, &origin).unwrap();
+            a.set_item("k", "1").unwrap();
+            a.set_item("gone", "x").unwrap();
+            a.remove_item("gone").unwrap();
+            assert_eq!(b.get_item("k").as_deref(), Some("1"), "tabs share one in-memory area");
+            assert_eq!(b.keys(), vec!["k".to_string()]);
+            // Dropping the store writes what is still queued.
+        }
 
-        let rows = match stmt.query_map(params![self.zone.to_string(), self.partition, self.origin], |row| {
-            row.get::<_, String>(0)
-        }) {
-            Ok(r) => r,
-            Err(_) => return vec![],
-        };
+        let store = SqliteLocalStore::new(path).unwrap();
+        let area = store.area(zone, &PartitionKey::None, &origin).unwrap();
+        assert_eq!(area.get_item("k").as_deref(), Some("1"));
+        assert_eq!(area.len(), 1);
+        let other = store.area(zone, &PartitionKey::None, &o("https://other.test")).unwrap();
+        assert!(other.is_empty());
+    }
+
+    #[test]
+    fn mutations_are_written_behind_in_one_batch() {
+        let dir = tempfile::tempdir().unwrap();
+        let path = dir.path().join("local.db");
+        let path = path.to_str().unwrap();
+        let store = SqliteLocalStore::new(path).unwrap();
+        let zone = ZoneId::new();
+        let area = store
+            .area(zone, &PartitionKey::None, &o("https://example.com"))
+            .unwrap();
+
+        for i in 0..50 {
+            area.set_item(&format!("k{i}"), "v").unwrap();
+        }
+        assert_eq!(area.len(), 50);
+        assert_eq!(stored_rows(path), 0, "nothing is written before the delay");
+
+        std::thread::sleep(FLUSH_DELAY * 4);
+        assert_eq!(stored_rows(path), 50);
+
+        area.clear().unwrap();
+        area.set_item("after", "clear").unwrap();
+        store.release_zone(zone);
+        assert_eq!(stored_rows(path), 1, "releasing a zone writes synchronously");
 
-        rows.filter_map(Result::ok).collect()
+        let again = store
+            .area(zone, &PartitionKey::None, &o("https://example.com"))
+            .unwrap();
+        assert_eq!(again.keys(), vec!["after".to_string()]);
     }
 }
@@ -88,6 +88,16 @@ impl StorageService {
         self.session.drop_tab(zone, tab);
     }
 
+    /// Writes out local storage changes still held in memory.
+    pub fn flush(&self) -> Result<()> {
+        self.local.flush()
+    }
+
+    /// Writes out and forgets the local storage the store caches for `zone`.
+    pub fn release_zone(&self, zone: ZoneId) {
+        self.local.release_zone(zone);
+    }
+
     fn wrap_notifying(
         &self,
         inner: Arc<dyn StorageArea>,
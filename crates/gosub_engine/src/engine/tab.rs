@@ -1,4 +1,5 @@
 mod handle;
+mod media_fetcher;
 mod options;
 mod scroll;
 pub mod services;
@@ -0,0 +1,222 @@
+use crate::cookies::{same_site, CookieJarHandle, SameSiteContext};
+use crate::engine::resource_pipeline::preload::{Preloads, PRELOAD_WAIT};
+use crate::engine::types::{IoChannel, RequestId};
+use crate::net::http_cache::{CacheLookup, HttpCache};
+use crate::net::req_ref_tracker::{RequestReference, REF_REGISTRY};
+use crate::net::stream_to_bytes;
+use crate::net::submit_to_io;
+use crate::net::types::{FetchRequest, FetchResult, Initiator, Priority, ResourceKind};
+use crate::zone::ZoneId;
+use gosub_render_pipeline::common::media::{FetchedMedia, MediaFetchCancelled, MediaFetchDone, MediaFetcher};
+use http::{HeaderMap, Method};
+use parking_lot::RwLock;
+use std::sync::Arc;
+use tokio_util::sync::CancellationToken;
+use url::Url;
+
+/// The document whose images are being loaded: its URL (the cookie top-level site), the request
+/// reference that routes net events to the tab, a token cancelling its loads, and the images its
+/// document scan already fetched.
+struct MediaDocument {
+    url: Url,
+    reference: RequestReference,
+    cancel: CancellationToken,
+    preloads: Arc<Preloads>,
+}
+
+/// Routes a tab's media loads through the zone's HTTP cache and I/O thread, so they share the zone
+/// fetcher's connection pool and per-origin limits and carry the tab's cookies. Installed on the
+/// tab's media store by the worker.
+pub(crate) struct TabMediaFetcher {
+    zone_id: ZoneId,
+    io_tx: IoChannel,
+    cookie_jar: CookieJarHandle,
+    accept_language: Option<String>,
+    http_cache: Arc<HttpCache>,
+    /// Runtime the fetch tasks run on; `fetch` is called from layout, outside of it.
+    runtime: tokio::runtime::Handle,
+    document: RwLock<Option<MediaDocument>>,
+}
+
+impl TabMediaFetcher {
+    pub fn new(
+        zone_id: ZoneId,
+        io_tx: IoChannel,
+        cookie_jar: CookieJarHandle,
+        accept_language: Option<String>,
+        http_cache: Arc<HttpCache>,
+        runtime: tokio::runtime::Handle,
+    ) -> Self {
+        Self {
+            zone_id,
+            io_tx,
+            cookie_jar,
+            accept_language,
+            http_cache,
+            runtime,
+            document: RwLock::new(None),
+        }
+    }
+
+    /// Loads from now on belong to the document at `url`, and are served from `preloads` where
+    /// possible. Loads still in flight for the previous document are cancelled and complete with
+    /// [`MediaFetchCancelled`].
+    pub fn set_document(&self, url: Url, reference: RequestReference, preloads: Arc<Preloads>) {
+        let previous = self.document.write().replace(MediaDocument {
+            url,
+            reference,
+            cancel: CancellationToken::new(),
+            preloads,
+        });
+        if let Some(previous) = previous {
+            previous.cancel.cancel();
+        }
+    }
+
+    /// The request for `url`, carrying `validators` when revalidating a cached response. It is
+    /// registered under `req_id` when submitted.
+    fn request_for(
+        &self,
+        req_id: RequestId,
+        url: &Url,
+        document: Option<&MediaDocument>,
+        validators: HeaderMap,
+    ) -> FetchRequest {
+        let top_level = document.map(|d| &d.url);
+        let samesite = match top_level {
+            Some(tl) if !same_site(url.host_str().unwrap_or_default(), tl.host_str().unwrap_or_default()) => {
+                SameSiteContext::CrossSite
+            }
+            _ => SameSiteContext::SameSite,
+        };
+
+        let mut headers = validators;
+        if let Some(cookie_str) = self.cookie_jar.read().get_request_cookies(url, top_level, samesite) {
+            if let Ok(val) = cookie_str.parse() {
+                headers.insert(http::header::COOKIE, val);
+            }
+        }
+        if let Some(langs) = &self.accept_language {
+            if let Ok(val) = langs.parse() {
+                headers.insert(http::header::ACCEPT_LANGUAGE, val);
+            }
+        }
+
+        let mut builder = FetchRequest::builder(Method::GET, url.clone())
+            .with_req_id(req_id)
+            .with_priority(Priority::Low)
+            .with_kind(ResourceKind::Image.to_net())
+            .with_initiator(Initiator::Parser.to_net())
+            .with_headers(headers)
+            .with_streaming(false)
+            .with_auto_decode(true);
+        if let Some(document) = document {
+            builder = builder.with_reference(REF_REGISTRY.to_net(document.reference));
+        }
+        builder.build()
+    }
+}
+
+impl MediaFetcher for TabMediaFetcher {
+    fn fetch(&self, url: Url, done: MediaFetchDone) {
+        let (cached, req, top_level, cancel, preloads) = {
+            let document = self.document.read();
+            let (cached, validators) = match self.http_cache.lookup(&url) {
+                // Served without a request. One whose body is still on disk keeps a request, for
+                // a body that turns out to be gone.
+                CacheLookup::Hit(cached) => {
+                    let fallback = (!cached.is_loaded()).then(HeaderMap::new);
+                    (Some(cached), fallback)
+                }
+                CacheLookup::Revalidate(validators) => (None, Some(validators)),
+                CacheLookup::Miss => (None, Some(HeaderMap::new())),
+            };
+            let req = validators.map(|validators| {
+                let req_id = RequestId::new();
+                (req_id, self.request_for(req_id, &url, document.as_ref(), validators))
+            });
+            let top_level = document.as_ref().map(|d| d.url.clone());
+            let cancel = document.as_ref().map(|d| d.cancel.clone());
+            let preloads = document.as_ref().map(|d| Arc::clone(&d.preloads));
+            (cached, req, top_level, cancel, preloads)
+        };
+        let zone_id = self.zone_id;
+        let io_tx = self.io_tx.clone();
+        let cookie_jar = self.cookie_jar.clone();
+        let http_cache = Arc::clone(&self.http_cache);
+
+        self.runtime.spawn(async move {
+            if let Some(preloads) = preloads {
+                if let Some(preloaded) = preloads.take(&url, PRELOAD_WAIT).await {
+                    return done(Ok(FetchedMedia {
+                        content_type: preloaded.content_type,
+                        body: preloaded.body,
+                    }));
+                }
+            }
+
+            if let Some(cached) = cached {
+                if let Some(result) = cached.load().await {
+                    return done(read_media(result).await);
+                }
+            }
+            // Only a loaded response comes without a request, and loading one never fails.
+            let Some((req_id, req)) = req else {
+                return done(Err(anyhow::anyhow!("cached response for {url} is gone")));
+            };
+            REF_REGISTRY.register_request(req_id, ResourceKind::Image, Initiator::Parser);
+            let (handle, rx) = match submit_to_io(zone_id, req, io_tx, cancel).await {
+                Ok(submitted) => submitted,
+                Err(e) => return done(Err(e)),
+            };
+            let fetch_result = tokio::select! {
+                _ = handle.cancel.cancelled() => return done(Err(MediaFetchCancelled.into())),
+                r = rx => match r {
+                    Ok(r) => r,
+                    // A cancelled request may see its reply dropped rather than answered.
+                    Err(_) if handle.cancel.is_cancelled() => return done(Err(MediaFetchCancelled.into())),
+                    Err(_) => return done(Err(anyhow::anyhow!("media fetch response channel closed"))),
+                },
+            };
+
+            if let Some(meta) = fetch_result.meta() {
+                cookie_jar
+                    .write()
+                    .store_response_cookies(&meta.final_url, &meta.headers, top_level.as_ref());
+            }
+
+            done(read_media(http_cache.complete(&url, fetch_result).await).await);
+        });
+    }
+}
+
+/// Collect a fetch result into the raw body and `Content-Type` the media store decodes.
+async fn read_media(fetch_result: FetchResult) -> anyhow::Result<FetchedMedia> {
+    let (meta, body) = match fetch_result {
+        FetchResult::Buffered { meta, body } => (meta, body),
+        FetchResult::Stream { meta, peek_buf, shared } => {
+            let body = stream_to_bytes(peek_buf, shared).await?;
+            (meta, body)
+        }
+        FetchResult::Error(e) => return Err(anyhow::anyhow!(e)),
+    };
+
+    if !(200..300).contains(&meta.status) {
+        anyhow::bail!("HTTP {} fetching resource", meta.status);
+    }
+
+    let content_type = meta
+        .headers
+        .get(http::header::CONTENT_TYPE)
+        .and_then(|v| v.to_str().ok())
+        .map(str::to_string);
+    Ok(FetchedMedia { content_type, body })
+}
+
+impl Drop for TabMediaFetcher {
+    fn drop(&mut self) {
+        if let Some(document) = self.document.get_mut().take() {
+            document.cancel.cancel();
+        }
+    }
+}
@@ -99,6 +99,15 @@ impl ScrollState {
         self.anim.is_some()
     }
 
+    /// The offset an in-flight animation is heading for (the current offset when idle).
+    pub(crate) fn target(&self) -> (f64, f64) {
+        self.target
+    }
+
+    pub(crate) fn behavior(&self) -> &ScrollBehavior {
+        &self.behavior
+    }
+
     /// Jump to an exact offset, cancelling any animation (navigation / programmatic set).
     pub(crate) fn reset(&mut self, x: f64, y: f64) {
         self.pos = (x, y);
@@ -13,6 +13,8 @@ pub struct EffectiveTabServices {
     pub cookie_jar: CookieJarHandle,
     /// `Accept-Language` header value for this tab's requests, if configured.
     pub accept_language: Option<String>,
+    /// Resolve styles in parallel before building the render tree (from the zone config).
+    pub parallel_style: bool,
 }
 
 /// Resolve the effective services for a tab based on the zone services/config and tab overrides.
@@ -67,5 +69,6 @@ pub fn resolve_tab_services(
         storage,
         cookie_jar,
         accept_language,
+        parallel_style: zone_config.parallel_style,
     }
 }
@@ -1,16 +1,19 @@
 use crate::cookies::SameSiteContext;
 use crate::engine::errors::NavigationError;
 use crate::engine::events::{EngineEvent, NavigationEvent};
+use crate::engine::resource_pipeline::preload::{Preloads, PRELOAD_WAIT};
 use crate::engine::resource_pipeline::ResourcePipelines;
 use crate::engine::types::{NavigationId, RequestId};
 use crate::engine::{BrowsingContext, UaPolicy};
 use crate::events::{IoCommand, TabCommand};
-use crate::html::RenderConfiguration;
+use crate::html::{unicode_range_covers_basic_latin, RenderConfiguration};
+use crate::net::http_cache::SFNT_ARTIFACT;
 use crate::net::req_ref_tracker::{RequestReference, REF_REGISTRY};
 use crate::net::types::{FetchRequest, FetchResult, Initiator, NetError, Priority, ResourceKind};
 use crate::net::{route_response_for, submit_to_io, RequestDestination, RoutedOutcome};
 use crate::storage::types::compute_partition_key;
 use crate::storage::StorageHandles;
+use crate::tab::media_fetcher::TabMediaFetcher;
 use crate::tab::scroll::{default_text_scroll, ScrollState};
 use crate::tab::services::EffectiveTabServices;
 use crate::tab::state::{TabRuntime, TabState};
@@ -18,6 +21,7 @@ use crate::tab::{TabId, TabSink};
 use crate::util::spawn_named;
 use crate::zone::{ZoneContext, ZoneId};
 use anyhow::{anyhow, Context};
+use gosub_render_pipeline::common::shape_cache::ShapeCache;
 use gosub_render_pipeline::rasterizer::RasterStrategy;
 use gosub_render_pipeline::render::backend::{CompositorSink, ErasedSurface, PresentMode, RenderBackend, SurfaceSize};
 use gosub_render_pipeline::render::Viewport;
@@ -123,32 +127,14 @@ pub struct TabWorker<C: RenderConfiguration> {
     load: Option<NavJoin<C>>,
     /// Current active navigation (if any)
     active_nav: Option<ActiveNav>,
+    /// Transport of the media store's image loads; told about each new document
+    media_fetcher: Option<Arc<TabMediaFetcher>>,
+    /// Sub-resources the current navigation's document scan fetched ahead of their use
+    preloads: Arc<Preloads>,
 }
 
-/// Whether a CSS `unicode-range` descriptor (e.g. `"U+0000-00FF, U+0131"`) includes the
-/// Basic-Latin letter `U+0041` ('A') - our proxy for "covers Latin-script text".
-fn unicode_range_covers_basic_latin(range: &str) -> bool {
-    const TARGET: u32 = 0x41; // 'A'
-    for token in range.split([',', ' ', '\t', '\n', '\r']).filter(|t| !t.is_empty()) {
-        let Some(hex) = token
-            .trim()
-            .strip_prefix("U+")
-            .or_else(|| token.trim().strip_prefix("u+"))
-        else {
-            continue;
-        };
-        let (lo, hi) = match hex.split_once('-') {
-            Some((a, b)) => (parse_hex_bound(a, false), parse_hex_bound(b, true)),
-            None => (parse_hex_bound(hex, false), parse_hex_bound(hex, true)),
-        };
-        if let (Some(lo), Some(hi)) = (lo, hi) {
-            if lo <= TARGET && TARGET <= hi {
-                return true;
-            }
-        }
-    }
-    false
-}
+/// Leading bytes of a WOFF2 font file.
+const WOFF2_MAGIC: &[u8; 4] = b"wOF2";
 
 /// Unwrap a downloaded web-font payload into raw SFNT bytes the font backends can decode.
 ///
@@ -160,8 +146,7 @@ fn unicode_range_covers_basic_latin(range: &str) -> bool {
 /// On a decode error we log and return the original bytes so the subsequent `register_font`
 /// surfaces a single, consistent failure path.
 fn decode_web_font(bytes: Vec<u8>, font_url: &Url) -> Vec<u8> {
-    const WOFF2_MAGIC: &[u8; 4] = b"wOF2";
-    if bytes.len() < 4 || &bytes[0..4] != WOFF2_MAGIC {
+    if !bytes.starts_with(WOFF2_MAGIC) {
         return bytes;
     }
     match woff2_to_sfnt(&bytes) {
@@ -255,30 +240,6 @@ fn sfnt_table_checksum(data: &[u8]) -> u32 {
     sum
 }
 
-/// Parse a `unicode-range` hex bound, expanding `?` wildcards to `0` (low bound) or `F`
-/// (high bound), e.g. `U+00??` → `0x0000..=0x00FF`.
-fn parse_hex_bound(s: &str, high: bool) -> Option<u32> {
-    let s = s.trim();
-    if s.is_empty() {
-        return None;
-    }
-    let filled: String = s
-        .chars()
-        .map(|c| {
-            if c == '?' {
-                if high {
-                    'F'
-                } else {
-                    '0'
-                }
-            } else {
-                c
-            }
-        })
-        .collect();
-    u32::from_str_radix(&filled, 16).ok()
-}
-
 impl<C: RenderConfiguration> TabWorker<C> {
     /// Creates a new tab. Does NOT spawn the tab worker
     pub fn new(
@@ -290,7 +251,29 @@ impl<C: RenderConfiguration> TabWorker<C> {
         cmd_rx: mpsc::Receiver<TabCommand>,
     ) -> Self {
         let config_store = zone_context.config_store.clone();
-        let context = BrowsingContext::new(config_store.clone());
+        let mut context = BrowsingContext::new(config_store.clone());
+        context.set_parallel_style(services.parallel_style);
+        context.set_tile_cache_budget(
+            config_store
+                .get_uint("renderer.tile.cache_budget_mb")
+                .saturating_mul(1 << 20) as u64,
+            Arc::clone(&zone_context.tile_cache_budget),
+        );
+        // Image loads go through the zone's I/O thread. Without a runtime (tests that never spawn
+        // the worker) the media store keeps its blocking fallback.
+        let media_fetcher = tokio::runtime::Handle::try_current().ok().map(|handle| {
+            Arc::new(TabMediaFetcher::new(
+                zone_id,
+                zone_context.io_tx.clone(),
+                services.cookie_jar.clone(),
+                services.accept_language.clone(),
+                Arc::clone(&zone_context.http_cache),
+                handle,
+            ))
+        });
+        if let Some(fetcher) = &media_fetcher {
+            context.set_media_fetcher(fetcher.clone(), config_store.get_uint("net.media.per_origin"));
+        }
         let runtime = TabRuntime::with_fps(config_store.get_uint("renderer.tab.default_fps") as u32);
 
         Self {
@@ -319,6 +302,8 @@ impl<C: RenderConfiguration> TabWorker<C> {
             runtime,
             load: None,
             active_nav: None,
+            media_fetcher,
+            preloads: Arc::default(),
         }
     }
 
@@ -411,9 +396,10 @@ impl<C: RenderConfiguration> TabWorker<C> {
 
     /// Fetch and register any `@font-face` web fonts declared in the document's stylesheets
     /// so the first layout/paint can use them. Runs once per navigation, before the first
-    /// render, and deduplicates by resolved font URL. Fetches are synchronous (blocking this
-    /// worker briefly during initial load); each face is registered under its CSS family so
-    /// the font system selects the right weight/style from the font's own metadata.
+    /// render, and deduplicates by resolved font URL. Fonts the document scan preloaded are taken
+    /// from there; the rest are fetched synchronously (blocking this worker briefly during initial
+    /// load), as is waiting for a preload still downloading. Each face is registered under its CSS
+    /// family so the font system selects the right weight/style from the font's own metadata.
     fn load_web_fonts(&self, doc: &C::Document, base_url: &Url) {
         use gosub_interface::css3::CssStylesheet as _;
         use gosub_interface::document::Document as _;
@@ -443,34 +429,57 @@ impl<C: RenderConfiguration> TabWorker<C> {
                     if !fetched.insert(font_url.to_string()) {
                         break; // this exact font file is already registered
                     }
-                    match gosub_sonar::net::simple::sync_fetch(&font_url) {
-                        Ok(resp) if resp.status == 200 && !resp.body.is_empty() => {
-                            // Web fonts are commonly served as WOFF2 (e.g. Google Fonts content-
-                            // negotiates WOFF2 for modern UAs like ours). The font backends
-                            // (Skia/fontconfig) only decode raw SFNT (TTF/OTF), so unwrap WOFF2
-                            // to TTF first. Other formats pass through unchanged.
-                            let font_bytes = decode_web_font(resp.body, &font_url);
-                            match self
-                                .zone_context
-                                .font_system
-                                .lock()
-                                .register_font(font_bytes, Some(&family))
-                            {
-                                Ok(()) => {
-                                    log::debug!("Registered web font '{family}' from {font_url}");
-                                    break; // family face loaded; skip remaining sources
-                                }
-                                Err(e) => log::warn!("Failed to register web font '{family}': {e:?}"),
+                    let body = match self.preloads.wait(&font_url, PRELOAD_WAIT) {
+                        Some(preloaded) => preloaded.body.to_vec(),
+                        None => match gosub_sonar::net::simple::sync_fetch(&font_url) {
+                            Ok(resp) if resp.status == 200 && !resp.body.is_empty() => resp.body,
+                            Ok(resp) => {
+                                log::warn!("Web font fetch {font_url} returned status {}", resp.status);
+                                continue;
+                            }
+                            Err(e) => {
+                                log::warn!("Web font fetch {font_url} failed: {e}");
+                                continue;
                             }
+                        },
+                    };
+                    // Web fonts are commonly served as WOFF2 (e.g. Google Fonts content-
+                    // negotiates WOFF2 for modern UAs like ours). The font backends
+                    // (Skia/fontconfig) only decode raw SFNT (TTF/OTF), so unwrap WOFF2
+                    // to TTF first. Other formats pass through unchanged.
+                    let font_bytes = self.decode_web_font_cached(body, &font_url);
+                    match self.zone_context.font_system.register_font(font_bytes, Some(&family)) {
+                        Ok(()) => {
+                            log::debug!("Registered web font '{family}' from {font_url}");
+                            // Text that asked for this family and fell back may now
+                            // resolve to this font.
+                            ShapeCache::global().forget_family(&self.zone_context.font_system, &family);
+                            break; // family face loaded; skip remaining sources
                         }
-                        Ok(resp) => log::warn!("Web font fetch {font_url} returned status {}", resp.status),
-                        Err(e) => log::warn!("Web font fetch {font_url} failed: {e}"),
+                        Err(e) => log::warn!("Failed to register web font '{family}': {e:?}"),
                     }
                 }
             }
         }
     }
 
+    /// [`decode_web_font`], reusing the SFNT the zone's HTTP cache kept from an earlier decode of
+    /// the same WOFF2 body, and keeping a new one there.
+    fn decode_web_font_cached(&self, body: Vec<u8>, font_url: &Url) -> Vec<u8> {
+        if !body.starts_with(WOFF2_MAGIC) {
+            return body;
+        }
+        let cache = &self.zone_context.http_cache;
+        if let Some(sfnt) = cache.artifact(font_url, SFNT_ARTIFACT, &body) {
+            return sfnt.to_vec();
+        }
+        let sfnt = decode_web_font(body.clone(), font_url);
+        if !sfnt.starts_with(WOFF2_MAGIC) {
+            cache.put_artifact(font_url, SFNT_ARTIFACT, &body, sfnt.clone().into());
+        }
+        sfnt
+    }
+
     fn on_nav_result(&mut self, res: NavigationResult<C>) {
         match res {
             NavigationResult::Ok {
@@ -480,6 +489,14 @@ impl<C: RenderConfiguration> TabWorker<C> {
                 doc,
             } => {
                 self.context.set_document(Arc::clone(&doc));
+                self.context.abandon_media_loads();
+                if let Some(fetcher) = &self.media_fetcher {
+                    fetcher.set_document(
+                        final_url.clone(),
+                        RequestReference::Navigation(nav_id),
+                        Arc::clone(&self.preloads),
+                    );
+                }
                 self.load_web_fonts(&doc, &final_url);
                 self.current_url = Some(final_url.clone());
                 if let Some(t) = title {
@@ -592,9 +609,13 @@ impl<C: RenderConfiguration> TabWorker<C> {
                             self.runtime.dirty = true;
                         }
                     }
-                    // Animated behavior: tick_draw advances the ease toward the new target. Request
-                    // an immediate tick so the first frame lands without waiting up to 1/fps.
+                    // Animated behavior: hand the ease to the compositor when it can run it, else
+                    // tick_draw advances it toward the new target. Request an immediate tick so the
+                    // first frame lands without waiting up to 1/fps.
                     None => {
+                        if self.hand_scroll_to_compositor() {
+                            return ControlFlow::Continue;
+                        }
                         self.runtime.render_now = true;
                     }
                 }
@@ -689,6 +710,46 @@ impl<C: RenderConfiguration> TabWorker<C> {
         }
     }
 
+    /// Lets the compositor ease the scroll toward its target on its own clock, so the worker lands
+    /// one frame at the target instead of one per animation step. Only CPU-tile backends qualify:
+    /// the compositor re-positions their TileCache frames, while GPU backends bake the scroll into
+    /// what they present. Returns false when the worker has to animate the scroll itself.
+    fn hand_scroll_to_compositor(&mut self) -> bool {
+        let backend = &self.zone_context.render_backend;
+        if backend.raster_strategy() == RasterStrategy::None
+            || backend.gpu_tile_compositing()
+            || backend.renders_to_gpu_texture()
+        {
+            return false;
+        }
+        let dpr = backend.device_pixel_ratio();
+
+        // The integer offset the worker's frames will be at, like every other scroll path.
+        let (x, y) = self.scroll.target();
+        let (x, y) = (x.round(), y.round());
+        if !self
+            .zone_context
+            .compositor
+            .scroll_to(self.tab_id, (x as f32, y as f32), self.scroll.behavior())
+        {
+            return false;
+        }
+
+        self.scroll.reset(x, y);
+        self.scroll_anim_last = None;
+        self.scroll_x = x as i32;
+        self.scroll_y = y as i32;
+        self.context.set_scroll(x, y);
+        match self.context.take_scroll_handle(dpr) {
+            Some(handle) => {
+                self.runtime.committed_scene_epoch = self.context.scene_epoch();
+                self.zone_context.compositor.submit_frame(self.tab_id, handle);
+            }
+            None => self.runtime.dirty = true,
+        }
+        true
+    }
+
     /// Navigate to a new URL, cancelling any in-flight navigation.
     fn navigate_to(&mut self, url: impl Into<String>, _ignore_cache: bool) {
         self.scroll_x = 0;
@@ -787,6 +848,10 @@ impl<C: RenderConfiguration> TabWorker<C> {
         let cookie_jar = self.services.cookie_jar.clone();
         let accept_language = self.services.accept_language.clone();
         let max_document_bytes = self.zone_context.config_store.get_uint("net.document.max_bytes");
+        let http_cache = Arc::clone(&self.zone_context.http_cache);
+        // A fresh store per navigation; the previous document's unused preloads go with it.
+        self.preloads = Arc::default();
+        let preloads = Arc::clone(&self.preloads);
 
         let span = tracing::info_span!(
             "tab_nav",
@@ -851,8 +916,14 @@ impl<C: RenderConfiguration> TabWorker<C> {
                 allow_download_without_user_activation: false,
             };
 
-            let mut hooks =
-                ResourcePipelines::<C>::new(zone_id, io_tx.clone(), accept_language.clone(), max_document_bytes);
+            let mut hooks = ResourcePipelines::<C>::new(
+                zone_id,
+                io_tx.clone(),
+                accept_language.clone(),
+                max_document_bytes,
+                preloads,
+                http_cache,
+            );
 
             let outcome = route_response_for(
                 RequestDestination::Document,
@@ -958,6 +1029,10 @@ impl<C: RenderConfiguration> TabWorker<C> {
         if self.context.poll_media_completed() {
             self.runtime.dirty = true;
         }
+        // Likewise for tiles the background fill-in rasterized after the viewport-first frame.
+        if self.context.poll_raster_fill() {
+            self.runtime.dirty = true;
+        }
 
         // Skip rendering when nothing has changed to avoid burning CPU at the tick rate.
         if !self.runtime.dirty {
@@ -1035,6 +1110,7 @@ impl<C: RenderConfiguration> TabWorker<C> {
                     // If `pipeline.rasterize` shows up here during a pure scroll, the page is being
                     // re-rasterized (it should not be - scroll only re-composites cached tiles).
                     let _t = gosub_shared::timing_guard!("gputile.rebuild");
+                    self.context.recover_evicted_gpu_tiles();
                     self.context.rebuild_pipeline_cache_if_needed();
                 }
                 let scene_epoch = self.context.scene_epoch();
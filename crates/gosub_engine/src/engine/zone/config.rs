@@ -46,6 +46,10 @@
 //! - `default_font_size`: Default font size in CSS px (default: 16).
 //! - `minimum_font_size`: Minimum allowed font size in CSS px (must be ≤ `default_font_size`).
 //! - `enable_local_file_access`: Allow `file://` (sandboxing concerns).
+//! - `parallel_style`: Resolve styles across DOM subtrees on a thread pool (default: off).
+//! - `tile_cache_budget_mb`: Memory shared by the tile-pixel caches of all tabs (default: 1024 MiB).
+//! - `http_cache_dir`: Directory persisting the zone's HTTP cache; `None` keeps it in memory.
+//! - `http_cache_mb`: Size of the zone's HTTP cache (default: 256 MiB).
 //!
 //! # Notes
 //!
@@ -60,6 +64,7 @@
 
 use crate::storage::PartitionPolicy;
 use std::fmt;
+use std::path::PathBuf;
 
 #[derive(Debug, Clone)]
 pub struct ZoneConfig {
@@ -89,6 +94,18 @@ pub struct ZoneConfig {
     pub enable_local_file_access: bool,
     /// Policy for storage partitioning (cookies, localStorage, etc.).
     pub partition_policy: PartitionPolicy,
+    /// Resolve element styles on a work-stealing thread pool, one task per sibling subtree,
+    /// instead of in one walk on the tab thread. Off by default until it is measured to beat the
+    /// sequential walk.
+    pub parallel_style: bool,
+    /// Memory budget (MiB) shared by the rasterized-tile caches of all tabs in this zone. Each
+    /// tab is further bounded by the `renderer.tile.cache_budget_mb` setting.
+    pub tile_cache_budget_mb: u64,
+    /// Directory the zone's HTTP cache persists its responses in. `None` keeps the cache in
+    /// memory, gone with the zone.
+    pub http_cache_dir: Option<PathBuf>,
+    /// Size (MiB) of the zone's HTTP cache: on disk with `http_cache_dir`, in memory without.
+    pub http_cache_mb: u64,
 }
 
 impl Default for ZoneConfig {
@@ -107,6 +124,10 @@ impl Default for ZoneConfig {
             minimum_font_size: 0,
             enable_local_file_access: false,
             partition_policy: PartitionPolicy::TopLevelOrigin,
+            parallel_style: false,
+            tile_cache_budget_mb: 1024,
+            http_cache_dir: None,
+            http_cache_mb: 256,
         }
     }
 }
@@ -182,6 +203,22 @@ impl ZoneConfigBuilder {
     pub fn partition_policy(self, policy: PartitionPolicy) -> Self {
         self.map(|c| c.partition_policy = policy)
     }
+    #[must_use]
+    pub fn parallel_style(self, on: bool) -> Self {
+        self.map(|c| c.parallel_style = on)
+    }
+    #[must_use]
+    pub fn tile_cache_budget_mb(self, mb: u64) -> Self {
+        self.map(|c| c.tile_cache_budget_mb = mb)
+    }
+    #[must_use]
+    pub fn http_cache_dir<P: Into<PathBuf>>(self, dir: P) -> Self {
+        self.map(|c| c.http_cache_dir = Some(dir.into()))
+    }
+    #[must_use]
+    pub fn http_cache_mb(self, mb: u64) -> Self {
+        self.map(|c| c.http_cache_mb = mb)
+    }
 
     /// Apply multiple changes in one go.
     pub fn with(self, f: impl FnOnce(&mut ZoneConfig)) -> Self {
@@ -258,6 +295,7 @@ mod tests {
         assert_eq!(c.minimum_font_size, 0);
         assert!(!c.enable_local_file_access);
         assert_eq!(c.partition_policy, PartitionPolicy::TopLevelOrigin);
+        assert!(!c.parallel_style);
     }
 
     #[test]
@@ -276,6 +314,7 @@ mod tests {
             .minimum_font_size(12)
             .enable_local_file_access(true)
             .partition_policy(PartitionPolicy::TopLevelOrigin)
+            .parallel_style(true)
             .build()
             .expect("valid config");
 
@@ -292,6 +331,7 @@ mod tests {
         assert_eq!(cfg.minimum_font_size, 12);
         assert!(cfg.enable_local_file_access);
         assert_eq!(cfg.partition_policy, PartitionPolicy::TopLevelOrigin);
+        assert!(cfg.parallel_style);
     }
 
     #[test]
@@ -7,6 +7,7 @@ use crate::engine::tab::TabId;
 use crate::engine::types::{EventChannel, IoChannel, TabChannel};
 use crate::events::TabCommand;
 use crate::html::RenderConfiguration;
+use crate::net::http_cache::HttpCache;
 use crate::net::req_ref_tracker::RequestReferenceMap;
 use crate::storage::types::PartitionPolicy;
 use crate::tab::services::resolve_tab_services;
@@ -15,7 +16,8 @@ use crate::util::spawn_named;
 use crate::zone::ZoneConfig;
 use crate::EngineError;
 use gosub_config::Config;
-use parking_lot::{Mutex, RwLock};
+use gosub_render_pipeline::common::tile_cache::TileCacheBudget;
+use parking_lot::RwLock;
 use rand::rngs::StdRng;
 use rand::{RngExt, SeedableRng};
 use serde::{Deserialize, Serialize};
@@ -122,9 +124,14 @@ pub struct ZoneContext<C: RenderConfiguration = crate::html::DefaultRenderConfig
     pub(crate) render_backend: Arc<C::RenderBackend>,
     /// The engine's shared font system (the config's `FontSystem`), used by the layouter for
     /// measurement and handed to the rasterizer for drawing.
-    pub(crate) font_system: Arc<Mutex<C::FontSystem>>,
+    pub(crate) font_system: Arc<C::FontSystem>,
     /// Per-engine settings store, cloned from the engine context and passed on to each tab.
     pub(crate) config_store: Config,
+    /// Byte budget shared by the tile-pixel caches of every tab in the zone
+    /// (`ZoneConfig::tile_cache_budget_mb`).
+    pub(crate) tile_cache_budget: Arc<TileCacheBudget>,
+    /// HTTP cache the zone's sub-resource loads go through (`ZoneConfig::http_cache_dir`).
+    pub(crate) http_cache: Arc<HttpCache>,
 }
 
 // Things that are shared upwards to the engine
@@ -210,7 +217,7 @@ impl<C: RenderConfiguration> Zone<C> {
         render_backend: Arc<C::RenderBackend>,
         compositor: Arc<C::CompositorSink>,
         // The engine's shared font system (the config's `FontSystem`)
-        font_system: Arc<Mutex<C::FontSystem>>,
+        font_system: Arc<C::FontSystem>,
     ) -> Result<Self, EngineError> {
         // We generate the color by using the zone id as a seed
         let mut rng = StdRng::seed_from_u64(zone_id.0.as_u64_pair().0);
@@ -226,6 +233,20 @@ impl<C: RenderConfiguration> Zone<C> {
         let io_tx = engine_context.io_tx.get().cloned().ok_or(EngineError::IoNotStarted)?;
         let request_reference_map = engine_context.request_reference_map.clone();
         let config_store = engine_context.config_store.clone();
+        let tile_cache_budget = Arc::new(TileCacheBudget::new(
+            config.tile_cache_budget_mb.saturating_mul(1 << 20),
+        ));
+        let http_cache_bytes = config.http_cache_mb.saturating_mul(1 << 20);
+        let http_cache = Arc::new(match &config.http_cache_dir {
+            Some(dir) => HttpCache::open(dir, http_cache_bytes).unwrap_or_else(|e| {
+                log::warn!(
+                    "Failed to open HTTP cache in {}: {e}; keeping it in memory",
+                    dir.display()
+                );
+                HttpCache::in_memory(http_cache_bytes)
+            }),
+            None => HttpCache::in_memory(http_cache_bytes),
+        });
 
         let zone = Self {
             engine_context,
@@ -248,6 +269,8 @@ impl<C: RenderConfiguration> Zone<C> {
                 render_backend,
                 font_system,
                 config_store,
+                tile_cache_budget,
+                http_cache,
             }),
             id: zone_id,
             tabs: HashMap::new(),
@@ -269,7 +292,7 @@ impl<C: RenderConfiguration> Zone<C> {
         engine_context: Arc<EngineContext>,
         render_backend: Arc<C::RenderBackend>,
         compositor: Arc<C::CompositorSink>,
-        font_system: Arc<Mutex<C::FontSystem>>,
+        font_system: Arc<C::FontSystem>,
     ) -> Result<Self, EngineError> {
         Self::new_with_id(
             ZoneId::new(),
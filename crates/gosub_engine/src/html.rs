@@ -5,6 +5,7 @@
 mod parser;
 
 pub use parser::parse_main_document_stream;
+pub(crate) use parser::{discover_font_faces, unicode_range_covers_basic_latin};
 pub use parser::{DocumentError, HtmlParseConfig, ResourceHint};
 
 use gosub_css3::system::Css3System;
@@ -5,13 +5,16 @@ use crate::net::types::{Priority, ResourceKind};
 use crate::net::RequestDestination;
 use cow_utils::CowUtils;
 use gosub_html5::document::builder::DocumentBuilderImpl;
-use gosub_html5::parser::Html5Parser;
+use gosub_html5::parser::{Html5Parser, Html5ParserOptions, ParseProgress, StylesheetSource};
 use gosub_interface::css3::CssSystem;
 use gosub_interface::document::Document as _;
-use gosub_shared::byte_stream::{ByteStream, Encoding};
+use gosub_shared::byte_stream::{ByteStream, Encoding, Stream as _};
 use once_cell::sync::Lazy;
 use regex::Regex;
 use tokio::io::{AsyncRead, AsyncReadExt};
+use tokio::select;
+use tokio::sync::mpsc;
+use tokio::task::JoinHandle;
 use tokio_util::sync::CancellationToken;
 use url::Url;
 
@@ -55,11 +58,14 @@ pub enum DocumentError {
 }
 
 /// Configuration for parsing a main document (see [`parse_main_document_stream`]).
-#[derive(Debug, Clone)]
+#[derive(Clone)]
 pub struct HtmlParseConfig {
-    /// Max bytes to buffer from the stream; a larger document is truncated (with a warning).
+    /// Max bytes to parse from the stream; a larger document is truncated (with a warning).
     /// The engine reads this from the `net.document.max_bytes` setting.
     pub max_bytes: usize,
+    /// Where the tree builder looks for external stylesheets before fetching them itself; the
+    /// HTML pipeline points this at the stylesheets it preloads.
+    pub stylesheet_source: Option<StylesheetSource>,
 }
 
 impl Default for HtmlParseConfig {
@@ -67,17 +73,37 @@ impl Default for HtmlParseConfig {
         // Matches the `net.document.max_bytes` schema default.
         Self {
             max_bytes: 10 * 1024 * 1024,
+            stylesheet_source: None,
         }
     }
 }
 
-/// Main entry point: buffer the HTML stream, parse it into a real DOM document,
-/// and report discovered sub-resources.
+impl std::fmt::Debug for HtmlParseConfig {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("HtmlParseConfig")
+            .field("max_bytes", &self.max_bytes)
+            .field("stylesheet_source", &self.stylesheet_source.is_some())
+            .finish()
+    }
+}
+
+/// Bytes held back until the encoding is detected and tree building starts; the window the HTML
+/// spec gives its encoding prescan.
+const ENCODING_SNIFF_BYTES: usize = 1024;
+
+/// Body chunks in flight between the reader and the tree builder thread.
+const TREE_BUILDER_QUEUE: usize = 16;
+
+/// Main entry point: stream the HTML into a real DOM document, and report discovered
+/// sub-resources.
+///
+/// The tree is built on a blocking thread that is fed the body chunk by chunk as it is read, so
+/// parsing overlaps the download instead of starting after the last byte.
 ///
 /// - `base_url`: used to resolve relative URLs and as the document URL.
 /// - `reader`: the response body stream (after the UA has chosen Render).
 /// - `cancel`: cancellation token (tab/nav cancellation).
-/// - `cfg`: buffer limit config.
+/// - `cfg`: size limit config.
 /// - `on_discover`: callback invoked for each sub-resource hint found.
 pub async fn parse_main_document_stream<C, R, F>(
     base_url: Url,
@@ -91,9 +117,11 @@ where
     R: AsyncRead + Unpin + Send + 'static,
     F: FnMut(ResourceHint) + Send,
 {
-    // Buffer the full stream (up to cfg.max_bytes); bail on cancellation.
-    let mut buf = Vec::with_capacity(32 * 1024);
     let mut tmp = [0u8; 16 * 1024];
+    let mut total = 0usize;
+    let mut sniffed = Vec::with_capacity(ENCODING_SNIFF_BYTES);
+    let mut tree: Option<TreeBuilder<C>> = None;
+    let mut discovery = StreamingDiscovery::default();
 
     loop {
         if cancel.is_cancelled() {
@@ -105,13 +133,31 @@ where
             break;
         }
 
-        let remaining = cfg.max_bytes.saturating_sub(buf.len()).min(n);
-        if remaining > 0 {
-            buf.extend_from_slice(&tmp[..remaining]);
+        let take = cfg.max_bytes.saturating_sub(total).min(n);
+        total += take;
+        let chunk = &tmp[..take];
+
+        // Fire sub-resource callbacks as their tags arrive, so that image/CSS/script fetches
+        // are submitted while the document is still downloading.
+        discovery.feed(chunk, &base_url, &mut on_discover);
+
+        if let Some(tree) = &tree {
+            tree.feed(chunk).await;
+        } else {
+            sniffed.extend_from_slice(chunk);
+            if sniffed.len() >= ENCODING_SNIFF_BYTES {
+                tree = Some(TreeBuilder::start(
+                    base_url.clone(),
+                    std::mem::take(&mut sniffed),
+                    cfg.stylesheet_source.clone(),
+                    cancel.clone(),
+                )?);
+            }
         }
+
         // If we hit the cap, we still drain the stream to EOF quickly
         // to avoid keeping the connection open unnecessarily.
-        if buf.len() >= cfg.max_bytes {
+        if total >= cfg.max_bytes {
             log::warn!(
                 "Document {base_url} exceeds the {} byte limit (net.document.max_bytes); parsing truncated content",
                 cfg.max_bytes
@@ -128,34 +174,130 @@ where
         }
     }
 
-    // Use lossy UTF-8 only for the fast resource-discovery regex scan.
-    let html_lossy = String::from_utf8_lossy(&buf);
+    let tree = match tree {
+        Some(tree) => tree,
+        None => TreeBuilder::start(base_url, sniffed, cfg.stylesheet_source, cancel.clone())?,
+    };
+    let mut doc = tree.finish(&cancel).await?;
+    let ua = <C::CssSystem as CssSystem>::load_default_useragent_stylesheet();
+    doc.add_stylesheet(ua);
+
+    Ok(doc)
+}
+
+/// The tree builder thread of [`parse_main_document_stream`] and the channel feeding it.
+struct TreeBuilder<C: RenderConfiguration> {
+    chunks: mpsc::Sender<Vec<u8>>,
+    handle: JoinHandle<Result<EngineDocument<C>, DocumentError>>,
+}
+
+impl<C: RenderConfiguration> TreeBuilder<C> {
+    /// Detects the encoding from the first bytes of the document and starts building the tree
+    /// from them.
+    fn start(
+        base_url: Url,
+        sniffed: Vec<u8>,
+        stylesheet_source: Option<StylesheetSource>,
+        cancel: CancellationToken,
+    ) -> Result<Self, DocumentError> {
+        // Detect encoding from the raw bytes (BOM check + chardetng), then build a
+        // properly-decoded stream.  We cannot call set_encoding() on an Unknown-
+        // encoded stream because tell_bytes() returns buffer.len() when chars is
+        // empty, which would advance the position to EOF.
+        let encoding = {
+            let mut tmp = ByteStream::new(Encoding::Unknown, None);
+            tmp.read_from_bytes(&sniffed)?;
+            tmp.detect_encoding()
+        };
+        let (chunks, rx) = mpsc::channel(TREE_BUILDER_QUEUE);
+        let options = Html5ParserOptions {
+            stylesheet_source,
+            ..Default::default()
+        };
+        let handle =
+            tokio::task::spawn_blocking(move || build_tree::<C>(base_url, encoding, sniffed, options, rx, cancel));
+        Ok(Self { chunks, handle })
+    }
+
+    /// Hands a chunk to the tree builder, waiting while it is [`TREE_BUILDER_QUEUE`] chunks behind.
+    async fn feed(&self, chunk: &[u8]) {
+        // A closed channel means the tree builder has stopped; `finish` reports why.
+        let _ = self.chunks.send(chunk.to_vec()).await;
+    }
 
-    // Fire sub-resource callbacks using the fast regex-based scanner so that
-    // image/CSS/script fetches are submitted before the full parse completes.
-    for hint in discover_resources(&html_lossy, &base_url) {
-        on_discover(hint);
+    /// Ends the input and waits for the finished document.
+    async fn finish(self, cancel: &CancellationToken) -> Result<EngineDocument<C>, DocumentError> {
+        drop(self.chunks);
+        select! {
+            res = self.handle => match res {
+                Ok(res) => res,
+                Err(e) => Err(DocumentError::Io(io::Error::other(format!("HTML tree builder failed: {e}")))),
+            },
+            _ = cancel.cancelled() => Err(DocumentError::Cancelled),
+        }
     }
+}
 
-    // Detect encoding from the raw bytes (BOM check + chardetng), then build a
-    // properly-decoded stream.  We cannot call set_encoding() on an Unknown-
-    // encoded stream because tell_bytes() returns buffer.len() when chars is
-    // empty, which would advance the position to EOF.
-    let encoding = {
-        let mut tmp = ByteStream::new(Encoding::Unknown, None);
-        tmp.read_from_bytes(&buf)?;
-        tmp.detect_encoding()
-    };
+/// Body of the tree builder thread: parses each chunk as it arrives, and finishes the document
+/// once the sender is dropped.
+fn build_tree<C: RenderConfiguration>(
+    base_url: Url,
+    encoding: Encoding,
+    first: Vec<u8>,
+    options: Html5ParserOptions,
+    mut chunks: mpsc::Receiver<Vec<u8>>,
+    cancel: CancellationToken,
+) -> Result<EngineDocument<C>, DocumentError> {
     let mut stream = ByteStream::new(encoding, None);
-    stream.read_from_bytes(&buf)?;
     let mut doc = DocumentBuilderImpl::new_document::<C>(Some(base_url));
-    let _ = Html5Parser::<C>::parse_document(&mut stream, &mut doc, None);
-    let ua = <C::CssSystem as CssSystem>::load_default_useragent_stylesheet();
-    doc.add_stylesheet(ua);
-
+    {
+        let mut parser = Html5Parser::<C>::start_document(&mut stream, &mut doc, Some(options));
+        let mut next = Some(first);
+        loop {
+            match next {
+                Some(chunk) => parser.stream_mut().append_bytes(&chunk),
+                None => parser.stream_mut().close(),
+            }
+            if cancel.is_cancelled() {
+                return Err(DocumentError::Cancelled);
+            }
+            match parser.resume() {
+                Ok(ParseProgress::NeedsInput) if !parser.stream_mut().closed() => {}
+                Ok(_) => break,
+                Err(e) => {
+                    log::warn!("Failed to parse HTML document: {e:?}");
+                    break;
+                }
+            }
+            next = chunks.blocking_recv();
+        }
+    }
     Ok(doc)
 }
 
+/// Runs [`discover_resources`] over a document as it streams in. Each scan ends at the last `>`
+/// received, so it only sees complete tags; the rest is carried over to the next chunk. The
+/// patterns cannot match across a `>`, so this finds what one scan of the whole document would.
+#[derive(Default)]
+struct StreamingDiscovery {
+    carry: Vec<u8>,
+}
+
+impl StreamingDiscovery {
+    fn feed(&mut self, chunk: &[u8], base_url: &Url, on_discover: &mut impl FnMut(ResourceHint)) {
+        self.carry.extend_from_slice(chunk);
+        let Some(end) = self.carry.iter().rposition(|&b| b == b'>') else {
+            return;
+        };
+        // Use lossy UTF-8 only for the fast resource-discovery regex scan.
+        let html_lossy = String::from_utf8_lossy(&self.carry[..=end]);
+        for hint in discover_resources(&html_lossy, base_url) {
+            on_discover(hint);
+        }
+        self.carry.drain(..=end);
+    }
+}
+
 // ======== Forgiving resource discovery (regex-based) ========
 fn unquote(s: &str) -> &str {
     let b = s.as_bytes();
@@ -172,12 +314,13 @@ fn re(pattern: &str) -> Regex {
     Regex::new(pattern).unwrap()
 }
 
-static RE_LINK_STYLESHEET: Lazy<Regex> = Lazy::new(|| {
-    // allow "..." or '...' or unquoted; capture into the *same* group `href`
-    re(
-        r#"(?is)<\s*link\b[^>]*\brel\s*=\s*(?:"stylesheet"|'stylesheet')[^>]*\bhref\s*=\s*(?P<href>"[^"]*"|'[^']*'|[^\s>]+)[^>]*>"#,
-    )
-});
+static RE_LINK_TAG: Lazy<Regex> = Lazy::new(|| re(r#"(?is)<\s*link\b[^>]*>"#));
+
+static RE_REL_ATTR: Lazy<Regex> = Lazy::new(|| re(r#"(?is)\brel\s*=\s*(?P<v>"[^"]*"|'[^']*'|[^\s>]+)"#));
+
+static RE_HREF_ATTR: Lazy<Regex> = Lazy::new(|| re(r#"(?is)\bhref\s*=\s*(?P<v>"[^"]*"|'[^']*'|[^\s>]+)"#));
+
+static RE_AS_ATTR: Lazy<Regex> = Lazy::new(|| re(r#"(?is)\bas\s*=\s*(?P<v>"[^"]*"|'[^']*'|[^\s>]+)"#));
 
 static RE_SCRIPT_SRC: Lazy<Regex> =
     Lazy::new(|| re(r#"(?is)<\s*script\b[^>]*\bsrc\s*=\s*(?P<src>"[^"]*"|'[^']*'|[^\s>]+)[^>]*>"#));
@@ -189,27 +332,55 @@ static RE_DEFER_ATTR: Lazy<Regex> = Lazy::new(|| re(r#"\bdefer\b"#));
 static RE_IMG_SRC: Lazy<Regex> =
     Lazy::new(|| re(r#"(?is)<\s*img\b[^>]*\bsrc\s*=\s*(?P<src>"[^"]*"|'[^']*'|[^\s>]+)[^>]*>"#));
 
+static RE_FONT_FACE: Lazy<Regex> = Lazy::new(|| re(r#"(?is)@font-face\s*\{(?P<body>[^}]*)\}"#));
+
+static RE_FONT_SRC_URL: Lazy<Regex> =
+    Lazy::new(|| re(r#"(?is)\bsrc\s*:[^;]*?\burl\(\s*(?P<url>"[^"]*"|'[^']*'|[^)\s]+)\s*\)"#));
+
+static RE_UNICODE_RANGE: Lazy<Regex> = Lazy::new(|| re(r#"(?is)\bunicode-range\s*:\s*(?P<range>[^;]+)"#));
+
+/// The unquoted value of the attribute `attr` matches in `tag`.
+fn attr<'t>(attr: &Regex, tag: &'t str) -> Option<&'t str> {
+    attr.captures(tag)
+        .and_then(|cap| cap.name("v"))
+        .map(|m| unquote(m.as_str()))
+}
+
 fn discover_resources(html: &str, base: &Url) -> Vec<ResourceHint> {
     let mut out = Vec::new();
 
-    // Stylesheets
-    for cap in RE_LINK_STYLESHEET.captures_iter(html) {
-        let Some(m) = cap.name("href") else {
+    // Stylesheets and preloads
+    for m in RE_LINK_TAG.find_iter(html) {
+        let tag = m.as_str();
+        let Some(rel) = attr(&RE_REL_ATTR, tag) else {
             continue;
         };
-        let Ok(u) = resolve(base, unquote(m.as_str())) else {
+        let rel = rel.cow_to_ascii_lowercase();
+        let rels: Vec<&str> = rel.split_ascii_whitespace().collect();
+        // Alternate stylesheets are not applied, so not worth fetching up front.
+        let kind = if rels.contains(&"stylesheet") && !rels.contains(&"alternate") {
+            ResourceKind::Stylesheet
+        } else if rels.contains(&"preload") {
+            let Some(kind) = attr(&RE_AS_ATTR, tag).and_then(preload_kind) else {
+                continue;
+            };
+            kind
+        } else {
+            continue;
+        };
+        let Some(Ok(u)) = attr(&RE_HREF_ATTR, tag).map(|href| resolve(base, href)) else {
             continue;
         };
         out.push(ResourceHint {
             url: u,
-            dest: RequestDestination::Document,
+            dest: destination_of(kind),
             referrer: None,
             cross_origin: false,
             integrity: None,
-            kind: ResourceKind::Stylesheet,
-            rel: Some("stylesheet".to_string()),
+            kind,
+            rel: Some(rel.into_owned()),
             from_attr: "href",
-            priority: Priority::High,
+            priority: priority_of(kind),
         });
     }
 
@@ -225,20 +396,21 @@ fn discover_resources(html: &str, base: &Url) -> Vec<ResourceHint> {
         let Ok(u) = resolve(base, unquote(m.as_str())) else {
             continue;
         };
+        let kind = ResourceKind::Script { blocking };
         out.push(ResourceHint {
             url: u,
-            kind: ResourceKind::Script { blocking },
+            kind,
             rel: None,
             from_attr: "src",
             dest: RequestDestination::Script,
             referrer: None,
             cross_origin: false,
             integrity: None,
-            priority: Priority::Normal,
+            priority: priority_of(kind),
         });
     }
 
-    // Images
+    // Images. `srcset` candidates are left alone: layout only ever loads `src`.
     for cap in RE_IMG_SRC.captures_iter(html) {
         let Some(m) = cap.name("src") else {
             continue;
@@ -255,13 +427,132 @@ fn discover_resources(html: &str, base: &Url) -> Vec<ResourceHint> {
             referrer: None,
             cross_origin: false,
             integrity: None,
-            priority: Priority::Low,
+            priority: priority_of(ResourceKind::Image),
         });
     }
 
+    // Web fonts of inline <style> blocks
+    out.extend(discover_font_faces(html, base));
+
     out
 }
 
+/// The web fonts the tab worker loads for the `@font-face` rules in `css`: the first `src` URL of
+/// each face covering Latin text (see [`unicode_range_covers_basic_latin`]), resolved against
+/// `base`, the stylesheet's URL.
+pub(crate) fn discover_font_faces(css: &str, base: &Url) -> Vec<ResourceHint> {
+    let mut out = Vec::new();
+    for face in RE_FONT_FACE.captures_iter(css) {
+        let Some(body) = face.name("body").map(|m| m.as_str()) else {
+            continue;
+        };
+        if let Some(range) = RE_UNICODE_RANGE.captures(body).and_then(|cap| cap.name("range")) {
+            if !unicode_range_covers_basic_latin(range.as_str()) {
+                continue;
+            }
+        }
+        let Some(src) = RE_FONT_SRC_URL.captures(body).and_then(|cap| cap.name("url")) else {
+            continue;
+        };
+        let Ok(u) = resolve(base, unquote(src.as_str())) else {
+            continue;
+        };
+        out.push(ResourceHint {
+            url: u,
+            kind: ResourceKind::Font,
+            rel: None,
+            from_attr: "src",
+            dest: RequestDestination::Font,
+            referrer: None,
+            cross_origin: false,
+            integrity: None,
+            priority: priority_of(ResourceKind::Font),
+        });
+    }
+    out
+}
+
+/// The kind of resource a `<link rel="preload" as="...">` fetches; `None` for destinations
+/// nothing in the engine consumes.
+fn preload_kind(as_value: &str) -> Option<ResourceKind> {
+    match as_value.trim().cow_to_ascii_lowercase().as_ref() {
+        "style" => Some(ResourceKind::Stylesheet),
+        "font" => Some(ResourceKind::Font),
+        "image" => Some(ResourceKind::Image),
+        "script" => Some(ResourceKind::Script { blocking: false }),
+        _ => None,
+    }
+}
+
+fn destination_of(kind: ResourceKind) -> RequestDestination {
+    match kind {
+        ResourceKind::Stylesheet => RequestDestination::Style,
+        ResourceKind::Font => RequestDestination::Font,
+        ResourceKind::Image => RequestDestination::Image,
+        ResourceKind::Script { .. } => RequestDestination::Script,
+        _ => RequestDestination::Other,
+    }
+}
+
+/// Fetch priority of a discovered resource: render-blocking stylesheets and the fonts text waits
+/// on first, then blocking scripts, then everything that can arrive after first paint.
+fn priority_of(kind: ResourceKind) -> Priority {
+    match kind {
+        ResourceKind::Stylesheet | ResourceKind::Font => Priority::High,
+        ResourceKind::Script { blocking: true } => Priority::Normal,
+        _ => Priority::Low,
+    }
+}
+
+/// Whether a CSS `unicode-range` descriptor (e.g. `"U+0000-00FF, U+0131"`) includes the
+/// Basic-Latin letter `U+0041` ('A') - our proxy for "covers Latin-script text".
+pub(crate) fn unicode_range_covers_basic_latin(range: &str) -> bool {
+    const TARGET: u32 = 0x41; // 'A'
+    for token in range.split([',', ' ', '\t', '\n', '\r']).filter(|t| !t.is_empty()) {
+        let Some(hex) = token
+            .trim()
+            .strip_prefix("U+")
+            .or_else(|| token.trim().strip_prefix("u+"))
+        else {
+            continue;
+        };
+        let (lo, hi) = match hex.split_once('-') {
+            Some((a, b)) => (parse_hex_bound(a, false), parse_hex_bound(b, true)),
+            None => (parse_hex_bound(hex, false), parse_hex_bound(hex, true)),
+        };
+        if let (Some(lo), Some(hi)) = (lo, hi) {
+            if lo <= TARGET && TARGET <= hi {
+                return true;
+            }
+        }
+    }
+    false
+}
+
+/// Parse a `unicode-range` hex bound, expanding `?` wildcards to `0` (low bound) or `F`
+/// (high bound), e.g. `U+00??` → `0x0000..=0x00FF`.
+fn parse_hex_bound(s: &str, high: bool) -> Option<u32> {
+    let s = s.trim();
+    if s.is_empty() {
+        return None;
+    }
+    let filled: String = s
+        .chars()
+        .map(|c| {
+            if c == '?' {
+                if high {
+                    'F'
+                } else {
+                    '0'
+                }
+            } else {
+                c
+            }
+        })
+        .collect();
+    u32::from_str_radix(&filled, 16).ok()
+}
+
 fn resolve(base: &Url, candidate: &str) -> Result<Url, url::ParseError> {
     // Tolerate whitespace, no-op fragments, etc.
     let trimmed = candidate.trim();
@@ -326,6 +617,65 @@ mod tests {
             .any(|h| h.kind == ResourceKind::Image && h.url.as_str() == "https://example.com/path/images/logo.png"));
     }
 
+    #[test]
+    fn discovers_preloads_and_inline_web_fonts() {
+        let html = r#"
+            <link href="/main.css" rel="stylesheet"><link rel="alternate stylesheet" href="/alt.css">
+            <link rel=preload as=font href="/f.woff2"><link rel="preload" as="fetch" href="/data.json">
+            <script async src="/a.js"></script>
+            <style>
+              @font-face { font-family: X; src: url("/latin.woff2") format("woff2"), url(/latin.woff);
+                           unicode-range: U+0000-00FF; }
+              @font-face { font-family: X; src: url(/cyrillic.woff2); unicode-range: U+0400-045F; }
+            </style>
+        "#;
+
+        let hints = discover_resources(html, &Url::parse("https://example.com/").unwrap());
+
+        let got: Vec<(&str, ResourceKind)> = hints.iter().map(|h| (h.url.as_str(), h.kind)).collect();
+        assert_eq!(
+            got,
+            [
+                ("https://example.com/main.css", ResourceKind::Stylesheet),
+                ("https://example.com/f.woff2", ResourceKind::Font),
+                ("https://example.com/a.js", ResourceKind::Script { blocking: false }),
+                ("https://example.com/latin.woff2", ResourceKind::Font),
+            ]
+        );
+        assert!(matches!(hints[0].priority, Priority::High));
+        assert!(matches!(hints[1].priority, Priority::High));
+        assert!(matches!(hints[2].priority, Priority::Low));
+    }
+
+    #[tokio::test(flavor = "current_thread")]
+    async fn parses_a_document_arriving_in_small_chunks() {
+        let html = format!(
+            "<html><head><title>Chunked</title><link rel=\"stylesheet\" href=\"/a.css\"></head>\
+             <body>{}<img src=\"b.png\"><p>caf\u{e9}</p></body></html>",
+            "<div>filler</div>".repeat(200)
+        );
+        let chunks: Vec<Result<Bytes, io::Error>> = html
+            .as_bytes()
+            .chunks(5)
+            .map(|c| Ok(Bytes::copy_from_slice(c)))
+            .collect();
+        let mut hints = Vec::new();
+
+        let doc = parse_main_document_stream::<DefaultRenderConfig, _, _>(
+            Url::parse("https://example.com/").unwrap(),
+            StreamReader::new(stream::iter(chunks)),
+            CancellationToken::new(),
+            HtmlParseConfig::default(),
+            |h| hints.push(h),
+        )
+        .await
+        .unwrap();
+
+        assert_eq!(crate::html::document_title(&doc).as_deref(), Some("Chunked"));
+        let urls: Vec<&str> = hints.iter().map(|h| h.url.as_str()).collect();
+        assert_eq!(urls, ["https://example.com/a.css", "https://example.com/b.png"]);
+    }
+
     #[tokio::test(flavor = "current_thread")]
     async fn honors_cancellation() {
         let base = Url::parse("https://e.test/").unwrap();
@@ -357,7 +707,10 @@ mod tests {
     async fn truncates_at_max_bytes() {
         let base = Url::parse("https://e.test/").unwrap();
         let big = "A".repeat(150_000); // 150 KiB
-        let cfg = HtmlParseConfig { max_bytes: 64 * 1024 }; // 64 KiB
+        let cfg = HtmlParseConfig {
+            max_bytes: 64 * 1024, // 64 KiB
+            ..Default::default()
+        };
 
         // Just verify truncated input still produces a valid document (no panic).
         parse_main_document_stream::<DefaultRenderConfig, _, _>(
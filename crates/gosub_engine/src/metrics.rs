@@ -6,9 +6,13 @@
 //!
 //! | Method | Path              | Description                            |
 //! |--------|-------------------|----------------------------------------|
-//! | GET    | `/metrics`        | JSON snapshot of all timing namespaces |
-//! | GET    | `/metrics/reset`  | Clear all timing counters              |
+//! | GET    | `/metrics`        | JSON snapshot of timings (with histograms), counters and cache totals |
+//! | GET    | `/metrics/trace`  | Recent timing spans as a Chrome trace (load in `chrome://tracing` or Perfetto) |
+//! | GET    | `/metrics/reset`  | Clear all timings and counters         |
 //! | GET    | `/health`         | Liveness probe (`{"status":"ok"}`)     |
+//!
+//! Each namespace under `namespaces` carries its duration histogram as `buckets`:
+//! `[lower_ns, upper_ns, count]` triples for the non-empty buckets.
 
 use tokio::io::{AsyncReadExt, AsyncWriteExt};
 use tokio::net::{TcpListener, TcpStream};
@@ -42,7 +46,13 @@ async fn handle(mut stream: TcpStream) {
 
     let (code, phrase, body) = if first_line.starts_with("GET /metrics/reset") {
         gosub_shared::timing::reset_stats();
+        gosub_render_pipeline::common::tile_cache::reset_stats();
+        gosub_render_pipeline::common::media::DecodedImageCache::global().reset_stats();
+        gosub_render_pipeline::common::media::SvgRasterCache::global().reset_stats();
+        crate::net::http_cache::reset_stats();
         (200u16, "OK", r#"{"status":"reset"}"#.to_string())
+    } else if first_line.starts_with("GET /metrics/trace") || first_line.starts_with("HEAD /metrics/trace") {
+        (200, "OK", gosub_shared::timing::chrome_trace())
     } else if first_line.starts_with("GET /metrics") || first_line.starts_with("HEAD /metrics") {
         (200, "OK", build_metrics_json())
     } else if first_line.starts_with("GET /health") {
@@ -65,13 +75,14 @@ async fn handle(mut stream: TcpStream) {
 }
 
 fn build_metrics_json() -> String {
-    use gosub_shared::timing::snapshot_stats;
+    use gosub_shared::timing::{snapshot_counters, snapshot_histograms};
     use serde_json::{json, Map, Value};
 
     let mut map = Map::new();
-    for s in snapshot_stats() {
+    for h in snapshot_histograms() {
+        let s = h.stats();
         map.insert(
-            s.namespace.clone(),
+            s.namespace,
             json!({
                 "count":    s.count,
                 "total_us": s.total_us,
@@ -82,9 +93,72 @@ fn build_metrics_json() -> String {
                 "p75_us":   s.p75_us,
                 "p95_us":   s.p95_us,
                 "p99_us":   s.p99_us,
+                "buckets":  h.buckets,
             }),
         );
     }
 
-    serde_json::to_string_pretty(&json!({ "namespaces": Value::Object(map) })).unwrap_or_else(|_| "{}".to_string())
+    let counters: Map<String, Value> = snapshot_counters()
+        .into_iter()
+        .map(|(name, value)| (name.to_string(), json!(value)))
+        .collect();
+
+    let tiles = gosub_render_pipeline::common::tile_cache::stats();
+    let lookups = tiles.hits + tiles.misses;
+    let tile_cache = json!({
+        "bytes":     tiles.bytes,
+        "tiles":     tiles.tiles,
+        "hits":      tiles.hits,
+        "misses":    tiles.misses,
+        "hit_rate":  if lookups == 0 { 0.0 } else { tiles.hits as f64 / lookups as f64 },
+        "evictions": tiles.evictions,
+        "recycled":  tiles.recycled,
+    });
+
+    let images = gosub_render_pipeline::common::media::DecodedImageCache::global().stats();
+    let lookups = images.hits + images.misses;
+    let decoded_images = json!({
+        "bytes":     images.bytes,
+        "images":    images.images,
+        "limit":     images.limit,
+        "hits":      images.hits,
+        "misses":    images.misses,
+        "hit_rate":  if lookups == 0 { 0.0 } else { images.hits as f64 / lookups as f64 },
+        "evictions": images.evictions,
+    });
+
+    let svgs = gosub_render_pipeline::common::media::SvgRasterCache::global().stats();
+    let lookups = svgs.hits + svgs.misses;
+    let svg_rasters = json!({
+        "bytes":     svgs.bytes,
+        "rasters":   svgs.rasters,
+        "limit":     svgs.limit,
+        "hits":      svgs.hits,
+        "misses":    svgs.misses,
+        "hit_rate":  if lookups == 0 { 0.0 } else { svgs.hits as f64 / lookups as f64 },
+        "evictions": svgs.evictions,
+    });
+
+    let http = crate::net::http_cache::stats();
+    let lookups = http.hits + http.revalidated + http.misses;
+    let http_cache = json!({
+        "bytes":         http.bytes,
+        "hits":          http.hits,
+        "revalidated":   http.revalidated,
+        "misses":        http.misses,
+        "hit_rate":      if lookups == 0 { 0.0 } else { (http.hits + http.revalidated) as f64 / lookups as f64 },
+        "stores":        http.stores,
+        "bytes_saved":   http.bytes_saved,
+        "artifact_hits": http.artifact_hits,
+    });
+
+    serde_json::to_string_pretty(&json!({
+        "namespaces": Value::Object(map),
+        "counters": Value::Object(counters),
+        "tile_cache": tile_cache,
+        "decoded_images": decoded_images,
+        "svg_rasters": svg_rasters,
+        "http_cache": http_cache,
+    }))
+    .unwrap_or_else(|_| "{}".to_string())
 }
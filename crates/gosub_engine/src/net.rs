@@ -14,6 +14,8 @@
 //! - A **router** that classifies responses and decides how the engine should handle them
 //!   ([`route_response_for`], [`RoutedOutcome`], [`decide_handling`]).
 //! - **Typed events** emitted during fetch & routing phases ([`events`]).
+//! - A per-zone **HTTP cache** that sub-resource loads consult before the network
+//!   ([`http_cache`]).
 //!
 //! ## Threading model (high level)
 //! ```text
@@ -55,6 +57,7 @@ mod decision_hub;
 mod emitter;
 pub mod events;
 mod fetcher;
+pub mod http_cache;
 mod io_runtime;
 pub mod req_ref_tracker;
 mod router;
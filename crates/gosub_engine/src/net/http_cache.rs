@@ -0,0 +1,1398 @@
+//! Per-zone HTTP cache.
+//!
+//! Sub-resource loads (stylesheets, fonts, images) consult the zone's [`HttpCache`] before going
+//! to the network. A fresh entry is served as a buffered [`FetchResult`] straight away; a stale one
+//! with a validator turns the request into a conditional one (`If-None-Match` /
+//! `If-Modified-Since`), and a `304 Not Modified` answer is served from the stored body. The
+//! fetcher itself lives in the external `gosub-sonar` crate, so the cache sits on the engine side
+//! of [`submit_to_io`](crate::net::submit_to_io): callers [`lookup`](HttpCache::lookup) before
+//! building their request and hand the answer to [`complete`](HttpCache::complete).
+//!
+//! Freshness follows a subset of RFC 9111 for a private cache: `Cache-Control: max-age`,
+//! `Expires`, `Age` and a heuristic (a tenth of the `Last-Modified` age, at most a day).
+//! `no-store` responses and responses varying on anything but `Accept-Encoding` are never stored;
+//! `no-cache` ones are stored but revalidated on every use.
+//!
+//! A disk-backed cache keeps an `index.json` with the response metadata and one file per body
+//! under `bodies/`. Bodies are read once into a shared [`Bytes`] and handed to every consumer by
+//! reference count, so repeated hits never copy them. The bytes held in memory are bounded
+//! separately from the bytes on disk.
+//!
+//! The lock around the index only ever guards memory. New bodies and index changes are written
+//! by a writer thread shortly after they happen, and changes are appended to `index.log` rather
+//! than rewriting the index, which is only written whole again once the journal outgrows it. A
+//! body that is not loaded comes with the [`CachedResponse`] a lookup returns and is read by
+//! [`CachedResponse::load`] on the blocking pool.
+//!
+//! Next to a response the cache keeps derived *artifacts*, such as the SFNT a WOFF2 font decodes
+//! to, so the transformation is not repeated on every load. An artifact is keyed by a fingerprint
+//! of the body it was derived from and goes when its response does.
+
+use crate::net::types::{FetchResult, FetchResultMeta};
+use crate::util::WriteBehind;
+use bytes::Bytes;
+use http::header::{self, HeaderMap, HeaderName, HeaderValue};
+use parking_lot::{Mutex, MutexGuard};
+use serde::{Deserialize, Serialize};
+use std::collections::{HashMap, HashSet};
+use std::hash::{Hash, Hasher};
+use std::io::Write;
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Weak};
+use std::time::{Duration, SystemTime, UNIX_EPOCH};
+use url::Url;
+
+/// Artifact kind for the SFNT (TTF/OTF) a WOFF2 web font decodes to.
+pub const SFNT_ARTIFACT: &str = "sfnt";
+
+/// Bytes an in-memory cache created through [`Default`] holds.
+pub const DEFAULT_MEMORY_BUDGET: u64 = 32 << 20;
+
+/// Bytes of bodies and artifacts a disk-backed cache keeps loaded in memory.
+const HOT_BUDGET: u64 = 32 << 20;
+
+/// Longest a heuristic freshness lifetime (no explicit expiry, only `Last-Modified`) may be.
+const MAX_HEURISTIC_LIFETIME: u64 = 24 * 60 * 60;
+
+/// How long the writer thread lets bodies and index changes pile up before writing them.
+const INDEX_FLUSH_INTERVAL: Duration = Duration::from_secs(2);
+
+/// Journal records allowed beyond twice the entries before the index is written whole again.
+const JOURNAL_SLACK: usize = 256;
+
+const INDEX_FILE: &str = "index.json";
+const JOURNAL_FILE: &str = "index.log";
+const BODIES_DIR: &str = "bodies";
+const INDEX_VERSION: u32 = 1;
+
+/// Response headers that are not stored: hop-by-hop ones, the length the cache tracks itself, and
+/// cookies, which were applied when the response arrived and must not be replayed on a hit.
+const UNSTORED_HEADERS: [HeaderName; 4] = [
+    header::CONTENT_LENGTH,
+    header::CONNECTION,
+    header::TRANSFER_ENCODING,
+    header::SET_COOKIE,
+];
+
+// Process-wide totals over every HTTP cache, for the metrics endpoint.
+static STORED_BYTES: AtomicU64 = AtomicU64::new(0);
+static HITS: AtomicU64 = AtomicU64::new(0);
+static MISSES: AtomicU64 = AtomicU64::new(0);
+static REVALIDATED: AtomicU64 = AtomicU64::new(0);
+static STORES: AtomicU64 = AtomicU64::new(0);
+static BYTES_SAVED: AtomicU64 = AtomicU64::new(0);
+static ARTIFACT_HITS: AtomicU64 = AtomicU64::new(0);
+
+/// Totals over every HTTP cache in the process. `bytes` is the current size of the stored bodies
+/// and artifacts; the rest count events since startup.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct HttpCacheStats {
+    pub bytes: u64,
+    /// Lookups served from a fresh entry.
+    pub hits: u64,
+    /// Lookups that went to the network and got a full response.
+    pub misses: u64,
+    /// Stale entries the server confirmed with a `304`.
+    pub revalidated: u64,
+    /// Responses written to a cache.
+    pub stores: u64,
+    /// Body bytes served from a cache instead of downloaded (hits and revalidations).
+    pub bytes_saved: u64,
+    /// Artifacts served instead of recomputed.
+    pub artifact_hits: u64,
+}
+
+/// Snapshot of the process-wide HTTP cache totals.
+pub fn stats() -> HttpCacheStats {
+    HttpCacheStats {
+        bytes: STORED_BYTES.load(Ordering::Relaxed),
+        hits: HITS.load(Ordering::Relaxed),
+        misses: MISSES.load(Ordering::Relaxed),
+        revalidated: REVALIDATED.load(Ordering::Relaxed),
+        stores: STORES.load(Ordering::Relaxed),
+        bytes_saved: BYTES_SAVED.load(Ordering::Relaxed),
+        artifact_hits: ARTIFACT_HITS.load(Ordering::Relaxed),
+    }
+}
+
+/// Zeroes the event counters. The size total tracks live caches and is left alone.
+pub fn reset_stats() {
+    for counter in [&HITS, &MISSES, &REVALIDATED, &STORES, &BYTES_SAVED, &ARTIFACT_HITS] {
+        counter.store(0, Ordering::Relaxed);
+    }
+}
+
+/// What the cache has for a URL, see [`HttpCache::lookup`].
+pub enum CacheLookup {
+    /// A fresh response; [load](CachedResponse::load) it and serve it without a request.
+    Hit(CachedResponse),
+    /// A stale response; send the request with these validator headers and pass the answer to
+    /// [`HttpCache::complete`].
+    Revalidate(HeaderMap),
+    /// Nothing usable stored.
+    Miss,
+}
+
+/// A stored response handed out by the cache. Its body may only be on disk, so it is read
+/// through [`load`](Self::load), on the blocking pool rather than the thread that looked it up.
+pub struct CachedResponse {
+    shared: Arc<Shared>,
+    key: String,
+    meta: FetchResultMeta,
+    file: u64,
+    body_len: u64,
+    body: Option<Bytes>,
+    /// The artifacts to read along with the body: kind, file and length.
+    artifacts: Vec<(String, u64, u64)>,
+}
+
+impl CachedResponse {
+    /// Whether the body is in memory, so [`load`](Self::load) neither reads nor fails.
+    pub fn is_loaded(&self) -> bool {
+        self.body.is_some()
+    }
+
+    /// The response, reading its body (and the artifacts derived from it) from disk when they
+    /// are not loaded. `None` when the body is gone from disk, which drops the entry.
+    pub async fn load(self) -> Option<FetchResult> {
+        let Self {
+            shared,
+            key,
+            meta,
+            file,
+            body_len,
+            body,
+            artifacts,
+        } = self;
+        let body = match body {
+            Some(body) => body,
+            None => {
+                let dir = shared.dir.clone()?;
+                let read = tokio::task::spawn_blocking(move || {
+                    let body = read_file(&dir, file, body_len);
+                    let artifacts: Vec<_> = artifacts
+                        .into_iter()
+                        .filter_map(|(kind, file, len)| Some((kind, file, read_file(&dir, file, len)?)))
+                        .collect();
+                    (body, artifacts)
+                })
+                .await;
+                let (body, artifacts) = match read {
+                    Ok(read) => read,
+                    Err(e) => {
+                        log::warn!("Failed to read HTTP cache body of {key}: {e}");
+                        return None;
+                    }
+                };
+                shared.install(&key, file, body.clone(), artifacts);
+                body?
+            }
+        };
+        BYTES_SAVED.fetch_add(body.len() as u64, Ordering::Relaxed);
+        Some(FetchResult::Buffered { meta, body })
+    }
+}
+
+/// A derived artifact of a stored response.
+struct Artifact {
+    /// Fingerprint of the body it was derived from.
+    source: u64,
+    file: u64,
+    len: u64,
+    data: Option<Bytes>,
+}
+
+struct Entry {
+    final_url: Url,
+    status_text: String,
+    headers: HeaderMap,
+    /// Unix seconds until which the response is fresh.
+    fresh_until: u64,
+    body_len: u64,
+    file: u64,
+    /// The body, when loaded. Always loaded in an in-memory cache.
+    body: Option<Bytes>,
+    artifacts: HashMap<String, Artifact>,
+    last_used: u64,
+}
+
+impl Entry {
+    fn size(&self) -> u64 {
+        self.body_len + self.artifacts.values().map(|a| a.len).sum::<u64>()
+    }
+
+    fn validators(&self) -> HeaderMap {
+        let mut validators = HeaderMap::new();
+        if let Some(etag) = self.headers.get(header::ETAG) {
+            validators.insert(header::IF_NONE_MATCH, etag.clone());
+        }
+        if let Some(modified) = self.headers.get(header::LAST_MODIFIED) {
+            validators.insert(header::IF_MODIFIED_SINCE, modified.clone());
+        }
+        validators
+    }
+
+    fn meta(&self) -> FetchResultMeta {
+        FetchResultMeta {
+            final_url: self.final_url.clone(),
+            status: 200,
+            status_text: self.status_text.clone(),
+            headers: self.headers.clone(),
+            content_length: None,
+            content_type: None,
+            has_body: true,
+        }
+    }
+}
+
+#[derive(Default)]
+struct Inner {
+    entries: HashMap<String, Entry>,
+    /// Bytes of all stored bodies and artifacts.
+    bytes: u64,
+    /// Bytes of the bodies and artifacts loaded in memory.
+    hot_bytes: u64,
+    next_file: u64,
+    tick: u64,
+    /// Keys whose entry changed since they were last handed to the writer thread.
+    changed: Vec<String>,
+    /// Body and artifact files waiting for the writer thread.
+    writes: Vec<(u64, Bytes)>,
+    /// Files waiting for the writer thread to delete them.
+    removes: Vec<u64>,
+    /// Files queued or being written. Their data stays loaded until it is on disk.
+    unwritten: HashSet<u64>,
+    /// Records appended to the journal since the index was last written whole.
+    journal_records: usize,
+    /// The next write replaces the index and empties the journal.
+    compact: bool,
+}
+
+/// See the module documentation.
+pub struct HttpCache {
+    shared: Arc<Shared>,
+}
+
+/// The cache proper, shared with the responses it hands out and with its writer thread.
+struct Shared {
+    /// Cache directory; `None` for an in-memory cache.
+    dir: Option<PathBuf>,
+    max_bytes: u64,
+    /// The in-memory index. No file is read or written under it.
+    inner: Mutex<Inner>,
+    /// Writes the bodies and index changes of a disk-backed cache.
+    write_behind: Option<WriteBehind<String>>,
+}
+
+impl Default for HttpCache {
+    fn default() -> Self {
+        Self::in_memory(DEFAULT_MEMORY_BUDGET)
+    }
+}
+
+impl HttpCache {
+    /// A cache holding at most `max_bytes` of bodies in memory, gone with the process.
+    pub fn in_memory(max_bytes: u64) -> Self {
+        Self {
+            shared: Arc::new(Shared {
+                dir: None,
+                max_bytes,
+                inner: Mutex::new(Inner::default()),
+                write_behind: None,
+            }),
+        }
+    }
+
+    /// A cache persisted in `dir`, holding at most `max_bytes` of bodies on disk. Entries stored
+    /// by an earlier run are picked up; an unreadable index starts the cache empty.
+    pub fn open(dir: &Path, max_bytes: u64) -> std::io::Result<Self> {
+        std::fs::create_dir_all(dir.join(BODIES_DIR))?;
+
+        let index = match std::fs::read(dir.join(INDEX_FILE)) {
+            Ok(raw) => match serde_json::from_slice::<Index>(&raw) {
+                Ok(index) if index.version == INDEX_VERSION => Some(index),
+                Ok(index) => {
+                    log::warn!(
+                        "HTTP cache index in {} has version {}; starting empty",
+                        dir.display(),
+                        index.version
+                    );
+                    None
+                }
+                Err(e) => {
+                    log::warn!(
+                        "Failed to read HTTP cache index in {}: {e}; starting empty",
+                        dir.display()
+                    );
+                    None
+                }
+            },
+            Err(e) if e.kind() == std::io::ErrorKind::NotFound => None,
+            Err(e) => return Err(e),
+        };
+
+        // The journal only means something on top of the index it follows.
+        let mut next_file = 0;
+        let mut records = HashMap::new();
+        if let Some(index) = index {
+            next_file = index.next_file;
+            records.extend(index.entries.into_iter().map(|record| (record.url.clone(), record)));
+            replay_journal(dir, &mut records);
+        }
+        // Past every file a record names, so a record the journal brought back never shares
+        // its file with a new body.
+        for record in records.values() {
+            let files = std::iter::once(record.file).chain(record.artifacts.iter().map(|a| a.file));
+            next_file = files.fold(next_file, |next, file| next.max(file + 1));
+        }
+
+        let shared = Arc::new_cyclic(|me: &Weak<Shared>| Shared {
+            dir: Some(dir.to_path_buf()),
+            max_bytes,
+            inner: Mutex::new(Inner::default()),
+            write_behind: Some(WriteBehind::spawn(
+                "http-cache-writer",
+                INDEX_FLUSH_INTERVAL,
+                me.clone(),
+                Shared::write,
+            )),
+        });
+        {
+            let mut inner = shared.inner.lock();
+            inner.next_file = next_file;
+            for record in records.into_values() {
+                if let Some((key, entry)) = shared.entry_from_record(record) {
+                    inner.bytes += entry.size();
+                    inner.entries.insert(key, entry);
+                }
+            }
+            STORED_BYTES.fetch_add(inner.bytes, Ordering::Relaxed);
+            shared.remove_orphans(&inner);
+            shared.evict(&mut inner, max_bytes);
+            // Covered by the index written whole below.
+            inner.changed.clear();
+            inner.compact = true;
+        }
+        shared.flush();
+        Ok(Self { shared })
+    }
+
+    /// What the cache has for a GET of `url`. Never touches the disk.
+    pub fn lookup(&self, url: &Url) -> CacheLookup {
+        self.shared.lookup(url)
+    }
+
+    /// Hands the answer to a GET of `url` to the cache and returns what the caller should use: a
+    /// `304` to a conditional request becomes the stored response, a cacheable `200` is stored,
+    /// and anything else passes through unchanged.
+    pub async fn complete(&self, url: &Url, result: FetchResult) -> FetchResult {
+        self.shared.complete(url, result).await
+    }
+
+    /// The artifact of `kind` derived from the stored response of `url`, if it was derived from
+    /// `source` and is loaded. Artifacts are read from disk along with the body they were
+    /// derived from ([`CachedResponse::load`]), never here.
+    pub fn artifact(&self, url: &Url, kind: &str, source: &[u8]) -> Option<Bytes> {
+        let key = cache_key(url);
+        let fingerprint = fingerprint(source);
+        let inner = self.shared.inner.lock();
+        let artifact = inner.entries.get(&key)?.artifacts.get(kind)?;
+        if artifact.source != fingerprint {
+            return None;
+        }
+        let data = artifact.data.clone()?;
+        ARTIFACT_HITS.fetch_add(1, Ordering::Relaxed);
+        Some(data)
+    }
+
+    /// Stores `data` as the artifact of `kind` derived from `source`, the body of `url`. Does
+    /// nothing if the response of `url` is not stored.
+    pub fn put_artifact(&self, url: &Url, kind: &str, source: &[u8], data: Bytes) {
+        self.shared.put_artifact(url, kind, source, data);
+    }
+
+    /// Writes the queued bodies and index changes to disk now, rather than when the writer
+    /// thread gets to them.
+    pub fn flush(&self) {
+        self.shared.flush();
+    }
+}
+
+impl Shared {
+    fn lookup(self: &Arc<Self>, url: &Url) -> CacheLookup {
+        let key = cache_key(url);
+        let mut inner = self.inner.lock();
+        inner.tick += 1;
+        let tick = inner.tick;
+
+        let Some(entry) = inner.entries.get_mut(&key) else {
+            return CacheLookup::Miss;
+        };
+        entry.last_used = tick;
+        if entry.fresh_until <= unix_now() {
+            let validators = entry.validators();
+            return if validators.is_empty() {
+                CacheLookup::Miss
+            } else {
+                CacheLookup::Revalidate(validators)
+            };
+        }
+
+        match self.cached(&inner, &key) {
+            Some(cached) => {
+                HITS.fetch_add(1, Ordering::Relaxed);
+                CacheLookup::Hit(cached)
+            }
+            None => CacheLookup::Miss,
+        }
+    }
+
+    async fn complete(self: &Arc<Self>, url: &Url, result: FetchResult) -> FetchResult {
+        let key = cache_key(url);
+        let Some(meta) = result.meta() else {
+            return result;
+        };
+
+        if meta.status == 304 {
+            let cached = {
+                let mut inner = self.inner.lock();
+                let Some(entry) = inner.entries.get_mut(&key) else {
+                    return result;
+                };
+                for (name, value) in &meta.headers {
+                    if !UNSTORED_HEADERS.contains(name) {
+                        entry.headers.insert(name.clone(), value.clone());
+                    }
+                }
+                entry.fresh_until = fresh_until(&entry.headers);
+                entry.headers.remove(header::AGE);
+                let cached = self.cached(&inner, &key);
+                self.changed(&mut inner, &key);
+                self.persist(inner);
+                cached
+            };
+            return match cached {
+                Some(cached) => match cached.load().await {
+                    Some(revalidated) => {
+                        REVALIDATED.fetch_add(1, Ordering::Relaxed);
+                        revalidated
+                    }
+                    None => result,
+                },
+                None => result,
+            };
+        }
+
+        MISSES.fetch_add(1, Ordering::Relaxed);
+        if let FetchResult::Buffered { meta, body } = &result {
+            if storable(meta) && body.len() as u64 <= self.max_bytes / 8 {
+                self.store(key, meta, body.clone());
+            } else {
+                // A response that may not be stored also replaces whatever was.
+                self.remove(&key);
+            }
+        }
+        result
+    }
+
+    fn put_artifact(&self, url: &Url, kind: &str, source: &[u8], data: Bytes) {
+        let key = cache_key(url);
+        let len = data.len() as u64;
+        if len > self.max_bytes / 8 {
+            return;
+        }
+        let mut inner = self.inner.lock();
+        if !inner.entries.contains_key(&key) {
+            return;
+        }
+
+        let file = inner.next_file;
+        inner.next_file += 1;
+        self.queue_write(&mut inner, file, data.clone());
+        let artifact = Artifact {
+            source: fingerprint(source),
+            file,
+            len,
+            data: Some(data),
+        };
+        let Some(entry) = inner.entries.get_mut(&key) else {
+            return;
+        };
+        let replaced = entry.artifacts.insert(kind.to_string(), artifact);
+        inner.bytes += len;
+        inner.hot_bytes += len;
+        STORED_BYTES.fetch_add(len, Ordering::Relaxed);
+        if let Some(replaced) = replaced {
+            self.release_artifact(&mut inner, replaced);
+        }
+        self.changed(&mut inner, &key);
+
+        self.evict(&mut inner, self.max_bytes);
+        self.shed_hot(&mut inner);
+        self.persist(inner);
+    }
+
+    fn store(&self, key: String, meta: &FetchResultMeta, body: Bytes) {
+        let mut inner = self.inner.lock();
+        let file = inner.next_file;
+        inner.next_file += 1;
+        self.queue_write(&mut inner, file, body.clone());
+
+        let mut headers = meta.headers.clone();
+        for name in UNSTORED_HEADERS.iter().chain([&header::AGE]) {
+            headers.remove(name);
+        }
+        inner.tick += 1;
+        let entry = Entry {
+            final_url: meta.final_url.clone(),
+            status_text: meta.status_text.clone(),
+            // `Age` only means something at receipt; it is not stored.
+            fresh_until: fresh_until(&meta.headers),
+            headers,
+            body_len: body.len() as u64,
+            file,
+            body: Some(body),
+            artifacts: HashMap::new(),
+            last_used: inner.tick,
+        };
+        let size = entry.size();
+        inner.bytes += size;
+        inner.hot_bytes += size;
+        STORED_BYTES.fetch_add(size, Ordering::Relaxed);
+        STORES.fetch_add(1, Ordering::Relaxed);
+        self.changed(&mut inner, &key);
+        if let Some(replaced) = inner.entries.insert(key, entry) {
+            self.release(&mut inner, replaced);
+        }
+
+        self.evict(&mut inner, self.max_bytes);
+        self.shed_hot(&mut inner);
+        self.persist(inner);
+    }
+
+    fn remove(&self, key: &str) {
+        let mut inner = self.inner.lock();
+        if let Some(entry) = inner.entries.remove(key) {
+            self.release(&mut inner, entry);
+            self.changed(&mut inner, key);
+        }
+        self.persist(inner);
+    }
+
+    /// The stored response of `key`, with its body if that is loaded.
+    fn cached(self: &Arc<Self>, inner: &Inner, key: &str) -> Option<CachedResponse> {
+        let entry = inner.entries.get(key)?;
+        let artifacts = match entry.body {
+            Some(_) => Vec::new(),
+            None => entry
+                .artifacts
+                .iter()
+                .filter(|(_, a)| a.data.is_none())
+                .map(|(kind, a)| (kind.clone(), a.file, a.len))
+                .collect(),
+        };
+        Some(CachedResponse {
+            shared: Arc::clone(self),
+            key: key.to_string(),
+            meta: entry.meta(),
+            file: entry.file,
+            body_len: entry.body_len,
+            body: entry.body.clone(),
+            artifacts,
+        })
+    }
+
+    /// Keeps the body and artifacts a [`CachedResponse`] read from file `file`, unless its entry
+    /// was replaced meanwhile. Drops the entry if the body could not be read.
+    fn install(&self, key: &str, file: u64, body: Option<Bytes>, artifacts: Vec<(String, u64, Bytes)>) {
+        let mut inner = self.inner.lock();
+        if !inner.entries.get(key).is_some_and(|e| e.file == file) {
+            return;
+        }
+        let Some(body) = body else {
+            if let Some(entry) = inner.entries.remove(key) {
+                self.release(&mut inner, entry);
+                self.changed(&mut inner, key);
+            }
+            self.persist(inner);
+            return;
+        };
+
+        let Some(entry) = inner.entries.get_mut(key) else {
+            return;
+        };
+        let mut loaded = 0;
+        if entry.body.is_none() {
+            loaded += body.len() as u64;
+            entry.body = Some(body);
+        }
+        for (kind, file, data) in artifacts {
+            if let Some(artifact) = entry
+                .artifacts
+                .get_mut(&kind)
+                .filter(|a| a.file == file && a.data.is_none())
+            {
+                loaded += artifact.len;
+                artifact.data = Some(data);
+            }
+        }
+        inner.hot_bytes += loaded;
+        self.shed_hot(&mut inner);
+    }
+
+    /// Evicts least recently used entries until the stored bytes fit `budget`.
+    fn evict(&self, inner: &mut Inner, budget: u64) {
+        while inner.bytes > budget {
+            let Some(key) = inner
+                .entries
+                .iter()
+                .min_by_key(|(_, e)| e.last_used)
+                .map(|(k, _)| k.clone())
+            else {
+                break;
+            };
+            if let Some(entry) = inner.entries.remove(&key) {
+                self.release(inner, entry);
+                self.changed(inner, &key);
+            }
+        }
+    }
+
+    /// Unloads least recently used bodies of a disk-backed cache until the loaded bytes fit the
+    /// hot budget. Consumers holding a body keep it alive until they are done. Data the writer
+    /// thread has not written yet stays, since there is nothing to read it back from.
+    fn shed_hot(&self, inner: &mut Inner) {
+        if self.dir.is_none() {
+            return;
+        }
+        let Inner {
+            entries,
+            hot_bytes,
+            unwritten,
+            ..
+        } = inner;
+        while *hot_bytes > HOT_BUDGET {
+            let Some(entry) = entries
+                .values_mut()
+                .filter(|e| e.body.is_some() || e.artifacts.values().any(|a| a.data.is_some()))
+                .filter(|e| !unwritten.contains(&e.file) && !e.artifacts.values().any(|a| unwritten.contains(&a.file)))
+                .min_by_key(|e| e.last_used)
+            else {
+                break;
+            };
+            let mut freed = entry.body.take().map_or(0, |b| b.len() as u64);
+            for artifact in entry.artifacts.values_mut() {
+                freed += artifact.data.take().map_or(0, |d| d.len() as u64);
+            }
+            *hot_bytes = hot_bytes.saturating_sub(freed);
+        }
+    }
+
+    /// Accounts for an entry leaving the cache and deletes its files.
+    fn release(&self, inner: &mut Inner, mut entry: Entry) {
+        for (_, artifact) in entry.artifacts.drain() {
+            self.release_artifact(inner, artifact);
+        }
+        inner.bytes = inner.bytes.saturating_sub(entry.body_len);
+        STORED_BYTES.fetch_sub(entry.body_len, Ordering::Relaxed);
+        if entry.body.is_some() {
+            inner.hot_bytes = inner.hot_bytes.saturating_sub(entry.body_len);
+        }
+        self.queue_remove(inner, entry.file);
+    }
+
+    fn release_artifact(&self, inner: &mut Inner, artifact: Artifact) {
+        inner.bytes = inner.bytes.saturating_sub(artifact.len);
+        STORED_BYTES.fetch_sub(artifact.len, Ordering::Relaxed);
+        if artifact.data.is_some() {
+            inner.hot_bytes = inner.hot_bytes.saturating_sub(artifact.len);
+        }
+        self.queue_remove(inner, artifact.file);
+    }
+
+    /// Records that the entry of `key` changed (or went), for the writer thread.
+    fn changed(&self, inner: &mut Inner, key: &str) {
+        if self.dir.is_some() {
+            inner.changed.push(key.to_string());
+        }
+    }
+
+    fn queue_write(&self, inner: &mut Inner, file: u64, data: Bytes) {
+        if self.dir.is_some() {
+            inner.unwritten.insert(file);
+            inner.writes.push((file, data));
+        }
+    }
+
+    /// Queues `file` for deletion; one still waiting to be written is simply never written.
+    fn queue_remove(&self, inner: &mut Inner, file: u64) {
+        if self.dir.is_none() {
+            return;
+        }
+        match inner.writes.iter().position(|(queued, _)| *queued == file) {
+            Some(at) => {
+                inner.writes.swap_remove(at);
+                inner.unwritten.remove(&file);
+            }
+            None => inner.removes.push(file),
+        }
+    }
+
+    /// Unlocks the index and hands the keys changed under it to the writer thread, or writes
+    /// them here when the thread could not be started.
+    fn persist(&self, mut inner: MutexGuard<'_, Inner>) {
+        let changed = std::mem::take(&mut inner.changed);
+        drop(inner);
+        let Some(write_behind) = &self.write_behind else {
+            return;
+        };
+        let unqueued: Vec<String> = changed
+            .into_iter()
+            .filter(|key| !write_behind.mark(key.clone()))
+            .collect();
+        if !unqueued.is_empty() {
+            let _writing = write_behind.take_all();
+            self.write(unqueued);
+        }
+    }
+
+    fn flush(&self) {
+        if let Some(write_behind) = &self.write_behind {
+            let (_writing, keys) = write_behind.drain();
+            self.write(keys);
+        }
+    }
+
+    /// Writes the queued body files, deletes the released ones and records the entries of
+    /// `keys`: appended to the journal, or with the whole index once the journal outgrows it.
+    /// Runs on the writer thread (or in [`Self::flush`]), with the index locked only to take the
+    /// work and to note the files written.
+    fn write(&self, mut keys: Vec<String>) {
+        let Some(dir) = &self.dir else {
+            return;
+        };
+        keys.sort_unstable();
+        keys.dedup();
+        let (writes, removes, index) = {
+            let mut inner = self.inner.lock();
+            let compact = inner.compact || inner.journal_records + keys.len() > 2 * inner.entries.len() + JOURNAL_SLACK;
+            let index = if compact {
+                inner.compact = false;
+                inner.journal_records = 0;
+                IndexWrite::Whole(Index {
+                    version: INDEX_VERSION,
+                    next_file: inner.next_file,
+                    entries: inner
+                        .entries
+                        .iter()
+                        .map(|(key, entry)| Record::new(key, entry))
+                        .collect(),
+                })
+            } else {
+                inner.journal_records += keys.len();
+                IndexWrite::Append(
+                    keys.iter()
+                        .map(|key| match inner.entries.get(key) {
+                            Some(entry) => JournalRecord::Put(Record::new(key, entry)),
+                            None => JournalRecord::Remove(key.clone()),
+                        })
+                        .collect(),
+                )
+            };
+            (
+                std::mem::take(&mut inner.writes),
+                std::mem::take(&mut inner.removes),
+                index,
+            )
+        };
+
+        for (file, data) in &writes {
+            write_file(dir, *file, data);
+        }
+        for file in removes {
+            remove_file(dir, file);
+        }
+        let written = match index {
+            IndexWrite::Append(records) => append_journal(dir, &records),
+            IndexWrite::Whole(index) => write_index(dir, &index),
+        };
+        if let Err(e) = &written {
+            log::warn!("Failed to write HTTP cache index in {}: {e}", dir.display());
+        }
+
+        if written.is_err() || !writes.is_empty() {
+            let mut inner = self.inner.lock();
+            // The next write replaces whatever the journal missed.
+            inner.compact |= written.is_err();
+            for (file, _) in &writes {
+                inner.unwritten.remove(file);
+            }
+            self.shed_hot(&mut inner);
+        }
+    }
+
+    /// Deletes body files no entry refers to, left behind by a run that ended before flushing.
+    fn remove_orphans(&self, inner: &Inner) {
+        let Some(dir) = &self.dir else {
+            return;
+        };
+        let Ok(listing) = std::fs::read_dir(dir.join(BODIES_DIR)) else {
+            return;
+        };
+        let known: HashSet<u64> = inner
+            .entries
+            .values()
+            .flat_map(|e| std::iter::once(e.file).chain(e.artifacts.values().map(|a| a.file)))
+            .collect();
+        for item in listing.flatten() {
+            let name = item.file_name();
+            let file = name.to_str().and_then(|n| u64::from_str_radix(n, 16).ok());
+            if !file.is_some_and(|f| known.contains(&f)) {
+                let _ = std::fs::remove_file(item.path());
+            }
+        }
+    }
+
+    fn entry_from_record(&self, record: Record) -> Option<(String, Entry)> {
+        let final_url = Url::parse(&record.final_url).ok()?;
+        let mut headers = HeaderMap::new();
+        for (name, value) in record.headers {
+            if let (Ok(name), Ok(value)) = (HeaderName::try_from(name), HeaderValue::try_from(value)) {
+                headers.append(name, value);
+            }
+        }
+        let entry = Entry {
+            final_url,
+            status_text: record.status_text,
+            headers,
+            fresh_until: record.fresh_until,
+            body_len: record.body_len,
+            file: record.file,
+            body: None,
+            artifacts: record
+                .artifacts
+                .into_iter()
+                .map(|a| {
+                    let artifact = Artifact {
+                        source: a.source,
+                        file: a.file,
+                        len: a.len,
+                        data: None,
+                    };
+                    (a.kind, artifact)
+                })
+                .collect(),
+            last_used: 0,
+        };
+        Some((record.url, entry))
+    }
+}
+
+impl Drop for Shared {
+    fn drop(&mut self) {
+        STORED_BYTES.fetch_sub(self.inner.get_mut().bytes, Ordering::Relaxed);
+        self.flush();
+    }
+}
+
+fn body_path(dir: &Path, file: u64) -> PathBuf {
+    dir.join(BODIES_DIR).join(format!("{file:016x}"))
+}
+
+fn write_file(dir: &Path, file: u64, data: &[u8]) {
+    let path = body_path(dir, file);
+    if let Err(e) = std::fs::write(&path, data) {
+        log::warn!("Failed to write HTTP cache body {}: {e}", path.display());
+    }
+}
+
+fn read_file(dir: &Path, file: u64, len: u64) -> Option<Bytes> {
+    let path = body_path(dir, file);
+    match std::fs::read(&path) {
+        Ok(data) if data.len() as u64 == len => Some(Bytes::from(data)),
+        Ok(_) => {
+            log::warn!("HTTP cache body {} has the wrong size; dropping it", path.display());
+            None
+        }
+        Err(e) => {
+            log::warn!("Failed to read HTTP cache body {}: {e}", path.display());
+            None
+        }
+    }
+}
+
+fn remove_file(dir: &Path, file: u64) {
+    let path = body_path(dir, file);
+    if let Err(e) = std::fs::remove_file(&path) {
+        if e.kind() != std::io::ErrorKind::NotFound {
+            log::warn!("Failed to remove HTTP cache body {}: {e}", path.display());
+        }
+    }
+}
+
+fn append_journal(dir: &Path, records: &[JournalRecord]) -> std::io::Result<()> {
+    if records.is_empty() {
+        return Ok(());
+    }
+    let mut raw = Vec::new();
+    for record in records {
+        serde_json::to_writer(&mut raw, record)?;
+        raw.push(b'\n');
+    }
+    let mut journal = std::fs::OpenOptions::new()
+        .create(true)
+        .append(true)
+        .open(dir.join(JOURNAL_FILE))?;
+    journal.write_all(&raw)
+}
+
+/// Replaces the index and empties the journal it absorbed.
+fn write_index(dir: &Path, index: &Index) -> std::io::Result<()> {
+    let raw = serde_json::to_vec(index)?;
+    // Written aside and renamed over, so a crash never leaves a torn index.
+    let tmp = dir.join(format!("{INDEX_FILE}.tmp"));
+    std::fs::write(&tmp, raw)?;
+    std::fs::rename(&tmp, dir.join(INDEX_FILE))?;
+    std::fs::write(dir.join(JOURNAL_FILE), b"")
+}
+
+/// Applies the journal in `dir` to the records of the index it follows. Unreadable lines (the
+/// tail of an append cut short) are skipped.
+fn replay_journal(dir: &Path, records: &mut HashMap<String, Record>) {
+    let raw = match std::fs::read(dir.join(JOURNAL_FILE)) {
+        Ok(raw) => raw,
+        Err(e) if e.kind() == std::io::ErrorKind::NotFound => return,
+        Err(e) => {
+            log::warn!("Failed to read HTTP cache journal in {}: {e}", dir.display());
+            return;
+        }
+    };
+    for line in raw.split(|&b| b == b'\n').filter(|line| !line.is_empty()) {
+        match serde_json::from_slice::<JournalRecord>(line) {
+            Ok(JournalRecord::Put(record)) => {
+                records.insert(record.url.clone(), record);
+            }
+            Ok(JournalRecord::Remove(url)) => {
+                records.remove(&url);
+            }
+            Err(e) => log::debug!("Skipping unreadable HTTP cache journal record: {e}"),
+        }
+    }
+}
+
+/// What one write records of the index.
+enum IndexWrite {
+    Append(Vec<JournalRecord>),
+    Whole(Index),
+}
+
+/// One line of the journal: an entry stored or changed, or the key of one that went.
+#[derive(Serialize, Deserialize)]
+#[serde(rename_all = "snake_case")]
+enum JournalRecord {
+    Put(Record),
+    Remove(String),
+}
+
+#[derive(Serialize, Deserialize)]
+struct Index {
+    version: u32,
+    next_file: u64,
+    entries: Vec<Record>,
+}
+
+#[derive(Serialize, Deserialize)]
+struct Record {
+    url: String,
+    final_url: String,
+    status_text: String,
+    headers: Vec<(String, String)>,
+    fresh_until: u64,
+    body_len: u64,
+    file: u64,
+    artifacts: Vec<ArtifactRecord>,
+}
+
+#[derive(Serialize, Deserialize)]
+struct ArtifactRecord {
+    kind: String,
+    source: u64,
+    file: u64,
+    len: u64,
+}
+
+impl Record {
+    fn new(key: &str, entry: &Entry) -> Self {
+        Self {
+            url: key.to_string(),
+            final_url: entry.final_url.to_string(),
+            status_text: entry.status_text.clone(),
+            // Values that are not visible ASCII are dropped; none of the ones the cache reads are.
+            headers: entry
+                .headers
+                .iter()
+                .filter_map(|(name, value)| Some((name.to_string(), value.to_str().ok()?.to_string())))
+                .collect(),
+            fresh_until: entry.fresh_until,
+            body_len: entry.body_len,
+            file: entry.file,
+            artifacts: entry
+                .artifacts
+                .iter()
+                .map(|(kind, a)| ArtifactRecord {
+                    kind: kind.clone(),
+                    source: a.source,
+                    file: a.file,
+                    len: a.len,
+                })
+                .collect(),
+        }
+    }
+}
+
+/// Entries are keyed by URL without its fragment.
+fn cache_key(url: &Url) -> String {
+    let mut url = url.clone();
+    url.set_fragment(None);
+    url.into()
+}
+
+fn fingerprint(source: &[u8]) -> u64 {
+    let mut hasher = std::collections::hash_map::DefaultHasher::new();
+    source.hash(&mut hasher);
+    hasher.finish()
+}
+
+fn unix_now() -> u64 {
+    SystemTime::now().duration_since(UNIX_EPOCH).map_or(0, |d| d.as_secs())
+}
+
+/// The lowercased `Cache-Control` directives, with their values.
+fn cache_control(headers: &HeaderMap) -> Vec<(String, Option<String>)> {
+    headers
+        .get_all(header::CACHE_CONTROL)
+        .iter()
+        .filter_map(|v| v.to_str().ok())
+        .flat_map(|v| v.split(','))
+        .filter_map(|directive| {
+            let mut parts = directive.splitn(2, '=');
+            let name = parts.next()?.trim().to_ascii_lowercase();
+            let value = parts.next().map(|v| v.trim().trim_matches('"').to_string());
+            (!name.is_empty()).then_some((name, value))
+        })
+        .collect()
+}
+
+fn http_date(headers: &HeaderMap, name: HeaderName) -> Option<u64> {
+    let value = headers.get(name)?.to_str().ok()?;
+    let date = chrono::DateTime::parse_from_rfc2822(value).ok()?;
+    u64::try_from(date.timestamp()).ok()
+}
+
+/// Whether a full response may be stored.
+fn storable(meta: &FetchResultMeta) -> bool {
+    if meta.status != 200 {
+        return false;
+    }
+    if cache_control(&meta.headers).iter().any(|(name, _)| name == "no-store") {
+        return false;
+    }
+    // Bodies are stored decoded, so varying on the encoding is fine; anything else would need
+    // the request headers as part of the key.
+    let varies = meta
+        .headers
+        .get_all(header::VARY)
+        .iter()
+        .filter_map(|v| v.to_str().ok())
+        .flat_map(|v| v.split(','))
+        .any(|field| !field.trim().eq_ignore_ascii_case("accept-encoding"));
+    if varies {
+        return false;
+    }
+    let has_validator = meta.headers.contains_key(header::ETAG) || meta.headers.contains_key(header::LAST_MODIFIED);
+    has_validator || fresh_until(&meta.headers) > unix_now()
+}
+
+/// Unix seconds until which a response received now with `headers` is fresh.
+fn fresh_until(headers: &HeaderMap) -> u64 {
+    let now = unix_now();
+    let directives = cache_control(headers);
+    if directives.iter().any(|(name, _)| name == "no-cache") {
+        return now;
+    }
+
+    let date = http_date(headers, header::DATE).unwrap_or(now);
+    let lifetime = directives
+        .iter()
+        .find(|(name, _)| name == "max-age")
+        .and_then(|(_, value)| value.as_deref()?.parse::<u64>().ok())
+        .or_else(|| {
+            // An invalid `Expires` (such as "0") means already expired.
+            headers
+                .contains_key(header::EXPIRES)
+                .then(|| http_date(headers, header::EXPIRES).map_or(0, |at| at.saturating_sub(date)))
+        })
+        .unwrap_or_else(|| {
+            http_date(headers, header::LAST_MODIFIED).map_or(0, |modified| {
+                (date.saturating_sub(modified) / 10).min(MAX_HEURISTIC_LIFETIME)
+            })
+        });
+
+    let age = headers
+        .get(header::AGE)
+        .and_then(|v| v.to_str().ok()?.trim().parse::<u64>().ok())
+        .unwrap_or(0)
+        .max(now.saturating_sub(date));
+    now + lifetime.saturating_sub(age)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn url(path: &str) -> Url {
+        Url::parse("https://example.com/").unwrap().join(path).unwrap()
+    }
+
+    fn meta(status: u16, headers: &[(&'static str, &'static str)]) -> FetchResultMeta {
+        let mut map = HeaderMap::new();
+        for (name, value) in headers {
+            map.append(HeaderName::from_static(name), HeaderValue::from_static(value));
+        }
+        FetchResultMeta {
+            final_url: url("a.css"),
+            status,
+            status_text: "OK".into(),
+            headers: map,
+            content_length: None,
+            content_type: None,
+            has_body: status == 200,
+        }
+    }
+
+    fn response(status: u16, headers: &[(&'static str, &'static str)], body: &'static [u8]) -> FetchResult {
+        FetchResult::Buffered {
+            meta: meta(status, headers),
+            body: Bytes::from_static(body),
+        }
+    }
+
+    async fn hit_body(lookup: CacheLookup) -> Option<Bytes> {
+        let CacheLookup::Hit(cached) = lookup else {
+            return None;
+        };
+        match cached.load().await {
+            Some(FetchResult::Buffered { body, .. }) => Some(body),
+            _ => None,
+        }
+    }
+
+    fn temp_dir(name: &str) -> PathBuf {
+        let dir = std::env::temp_dir().join(format!("gosub-http-cache-{name}-{}", std::process::id()));
+        let _ = std::fs::remove_dir_all(&dir);
+        dir
+    }
+
+    #[tokio::test(flavor = "current_thread")]
+    async fn fresh_responses_are_served_without_copying() {
+        let cache = HttpCache::default();
+        let body = Bytes::from_static(b"body { color: red }");
+        let stored = FetchResult::Buffered {
+            meta: meta(200, &[("cache-control", "max-age=3600")]),
+            body: body.clone(),
+        };
+        cache.complete(&url("a.css"), stored).await;
+
+        let served = hit_body(cache.lookup(&url("a.css#top"))).await.expect("fresh hit");
+        assert_eq!(served.as_ptr(), body.as_ptr(), "hits share the stored buffer");
+        assert!(matches!(cache.lookup(&url("b.css")), CacheLookup::Miss));
+    }
+
+    #[tokio::test(flavor = "current_thread")]
+    async fn stale_responses_are_revalidated() {
+        let cache = HttpCache::default();
+        cache
+            .complete(
+                &url("a.css"),
+                response(200, &[("cache-control", "no-cache"), ("etag", "\"v1\"")], b"old"),
+            )
+            .await;
+
+        let CacheLookup::Revalidate(validators) = cache.lookup(&url("a.css")) else {
+            panic!("no-cache responses are revalidated");
+        };
+        assert_eq!(validators.get(header::IF_NONE_MATCH).unwrap(), "\"v1\"");
+
+        let before = stats().revalidated;
+        let served = cache
+            .complete(&url("a.css"), response(304, &[("etag", "\"v1\"")], b""))
+            .await;
+        match served {
+            FetchResult::Buffered { meta, body } => {
+                assert_eq!(meta.status, 200);
+                assert_eq!(&body[..], b"old");
+            }
+            _ => panic!("a 304 is served from the stored body"),
+        }
+        assert!(stats().revalidated > before);
+    }
+
+    #[tokio::test(flavor = "current_thread")]
+    async fn uncacheable_responses_are_not_stored() {
+        let cache = HttpCache::default();
+        cache
+            .complete(&url("a.css"), response(200, &[("cache-control", "max-age=60")], b"a"))
+            .await;
+        cache
+            .complete(&url("a.css"), response(200, &[("cache-control", "no-store")], b"b"))
+            .await;
+        assert!(
+            matches!(cache.lookup(&url("a.css")), CacheLookup::Miss),
+            "no-store drops the old entry"
+        );
+
+        cache
+            .complete(
+                &url("b.css"),
+                response(200, &[("cache-control", "max-age=60"), ("vary", "cookie")], b"b"),
+            )
+            .await;
+        assert!(matches!(cache.lookup(&url("b.css")), CacheLookup::Miss));
+
+        cache
+            .complete(&url("c.css"), response(404, &[("cache-control", "max-age=60")], b"c"))
+            .await;
+        assert!(matches!(cache.lookup(&url("c.css")), CacheLookup::Miss));
+
+        cache.complete(&url("d.css"), response(200, &[], b"d")).await;
+        assert!(
+            matches!(cache.lookup(&url("d.css")), CacheLookup::Miss),
+            "no freshness and no validator"
+        );
+    }
+
+    #[tokio::test(flavor = "current_thread")]
+    async fn least_recently_used_entries_are_evicted() {
+        // Eight 7-byte bodies fill the budget exactly.
+        let cache = HttpCache::in_memory(56);
+        for i in 0..8 {
+            let fresh = response(200, &[("cache-control", "max-age=60")], b"1234567");
+            cache.complete(&url(&format!("{i}.css")), fresh).await;
+        }
+        assert!(hit_body(cache.lookup(&url("0.css"))).await.is_some());
+
+        cache
+            .complete(
+                &url("8.css"),
+                response(200, &[("cache-control", "max-age=60")], b"1234567"),
+            )
+            .await;
+        assert!(hit_body(cache.lookup(&url("0.css"))).await.is_some(), "recently used");
+        assert!(
+            matches!(cache.lookup(&url("1.css")), CacheLookup::Miss),
+            "least recently used"
+        );
+        assert!(hit_body(cache.lookup(&url("8.css"))).await.is_some());
+        cache
+            .complete(
+                &url("big.css"),
+                response(200, &[("cache-control", "max-age=60")], b"12345678"),
+            )
+            .await;
+        assert!(
+            matches!(cache.lookup(&url("big.css")), CacheLookup::Miss),
+            "over an eighth of the budget"
+        );
+    }
+
+    #[tokio::test(flavor = "current_thread")]
+    async fn artifacts_follow_their_source() {
+        let cache = HttpCache::default();
+        cache
+            .complete(
+                &url("font.woff2"),
+                response(200, &[("cache-control", "max-age=60")], b"woff2"),
+            )
+            .await;
+        cache.put_artifact(&url("font.woff2"), SFNT_ARTIFACT, b"woff2", Bytes::from_static(b"sfnt"));
+
+        assert_eq!(
+            cache.artifact(&url("font.woff2"), SFNT_ARTIFACT, b"woff2").as_deref(),
+            Some(&b"sfnt"[..])
+        );
+        assert!(cache.artifact(&url("font.woff2"), SFNT_ARTIFACT, b"other").is_none());
+
+        // A new body takes the artifacts of the old one with it.
+        cache
+            .complete(
+                &url("font.woff2"),
+                response(200, &[("cache-control", "max-age=60")], b"new"),
+            )
+            .await;
+        assert!(cache.artifact(&url("font.woff2"), SFNT_ARTIFACT, b"woff2").is_none());
+
+        // Artifacts of responses that are not stored are not kept either.
+        cache.put_artifact(&url("other.woff2"), SFNT_ARTIFACT, b"x", Bytes::from_static(b"y"));
+        assert!(cache.artifact(&url("other.woff2"), SFNT_ARTIFACT, b"x").is_none());
+    }
+
+    #[tokio::test(flavor = "current_thread")]
+    async fn disk_caches_survive_a_reopen() {
+        let dir = temp_dir("reopen");
+        {
+            let cache = HttpCache::open(&dir, 1 << 20).unwrap();
+            cache
+                .complete(
+                    &url("a.css"),
+                    response(200, &[("cache-control", "max-age=3600")], b"kept"),
+                )
+                .await;
+            cache.put_artifact(&url("a.css"), SFNT_ARTIFACT, b"kept", Bytes::from_static(b"derived"));
+        }
+        // The entry went to the journal; the index is only written whole on open.
+        assert!(std::fs::metadata(dir.join(JOURNAL_FILE)).unwrap().len() > 0);
+        // A body file no index entry refers to is cleaned up on open.
+        std::fs::write(dir.join(BODIES_DIR).join("00000000000000ff"), b"orphan").unwrap();
+
+        let cache = HttpCache::open(&dir, 1 << 20).unwrap();
+        assert_eq!(std::fs::metadata(dir.join(JOURNAL_FILE)).unwrap().len(), 0);
+        // Artifacts are loaded with their body, not on their own.
+        assert!(cache.artifact(&url("a.css"), SFNT_ARTIFACT, b"kept").is_none());
+        assert_eq!(
+            hit_body(cache.lookup(&url("a.css"))).await.as_deref(),
+            Some(&b"kept"[..])
+        );
+        assert_eq!(
+            cache.artifact(&url("a.css"), SFNT_ARTIFACT, b"kept").as_deref(),
+            Some(&b"derived"[..])
+        );
+        assert!(!dir.join(BODIES_DIR).join("00000000000000ff").exists());
+
+        drop(cache);
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn freshness_comes_from_the_response_headers() {
+        let now = unix_now();
+        let mut headers = HeaderMap::new();
+        headers.insert(header::CACHE_CONTROL, HeaderValue::from_static("public, max-age=100"));
+        headers.insert(header::AGE, HeaderValue::from_static("40"));
+        let until = fresh_until(&headers);
+        assert!((now + 59..=now + 61).contains(&until));
+
+        let mut headers = HeaderMap::new();
+        headers.insert(header::EXPIRES, HeaderValue::from_static("0"));
+        assert!(fresh_until(&headers) <= unix_now());
+
+        let mut headers = HeaderMap::new();
+        headers.insert(header::DATE, HeaderValue::from_static("Sun, 06 Nov 1994 08:49:37 GMT"));
+        headers.insert(
+            header::LAST_MODIFIED,
+            HeaderValue::from_static("Sun, 06 Nov 1994 08:49:27 GMT"),
+        );
+        // Ten seconds old when served on that date: fresh for one second after it, long gone now.
+        assert!(fresh_until(&headers) <= unix_now());
+    }
+}
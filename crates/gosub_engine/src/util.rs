@@ -4,5 +4,7 @@
 //! that are used throughout the project.
 
 mod spawn;
+mod write_behind;
 
 pub use spawn::spawn_named;
+pub(crate) use write_behind::WriteBehind;
@@ -0,0 +1,128 @@
+use parking_lot::{Condvar, Mutex, MutexGuard};
+use std::collections::HashSet;
+use std::hash::Hash;
+use std::sync::{Arc, Weak};
+use std::time::Duration;
+
+/// Write-behind queue of the persisting stores (cookie JSON and SQLite, SQLite local storage).
+///
+/// A store [marks](Self::mark) a key dirty instead of writing it. A background thread wakes
+/// `delay` after the first change and hands every key changed meanwhile to the store's flush
+/// callback in one call. The thread holds the store weakly and exits when the queue is dropped.
+pub(crate) struct WriteBehind<K> {
+    shared: Arc<WriteBehindShared<K>>,
+}
+
+struct WriteBehindShared<K> {
+    state: Mutex<WriteBehindState<K>>,
+    wake: Condvar,
+    /// Held across each flush, so an older batch never lands after a newer write.
+    writing: Mutex<()>,
+    delay: Duration,
+}
+
+struct WriteBehindState<K> {
+    dirty: HashSet<K>,
+    closed: bool,
+    /// The thread failed to start; stores write each change immediately.
+    inline: bool,
+}
+
+impl<K: Eq + Hash + Send + 'static> WriteBehind<K> {
+    /// Starts the writer thread, which calls `flush` with batches of dirty keys.
+    pub(crate) fn spawn<S, F>(name: &str, delay: Duration, store: Weak<S>, flush: F) -> Self
+    where
+        S: Send + Sync + 'static,
+        F: Fn(&S, Vec<K>) + Send + 'static,
+    {
+        let shared = Arc::new(WriteBehindShared {
+            state: Mutex::new(WriteBehindState {
+                dirty: HashSet::new(),
+                closed: false,
+                inline: false,
+            }),
+            wake: Condvar::new(),
+            writing: Mutex::new(()),
+            delay,
+        });
+        let worker = Arc::clone(&shared);
+        let spawned = std::thread::Builder::new().name(name.to_string()).spawn(move || {
+            while let Some(keys) = worker.next_batch() {
+                let Some(store) = store.upgrade() else {
+                    return;
+                };
+                let _writing = worker.writing.lock();
+                flush(&store, keys);
+            }
+        });
+        if let Err(e) = spawned {
+            log::error!("Failed to start writer thread {name}; writing changes immediately: {e}");
+            shared.state.lock().inline = true;
+        }
+        Self { shared }
+    }
+
+    /// Queues `key` for the next batch. Returns `false` when there is no writer thread,
+    /// in which case the caller has to persist the change itself.
+    pub(crate) fn mark(&self, key: K) -> bool {
+        let mut state = self.shared.state.lock();
+        if state.inline {
+            return false;
+        }
+        if state.dirty.insert(key) && state.dirty.len() == 1 {
+            self.shared.wake.notify_one();
+        }
+        true
+    }
+
+    /// Drops `key` from the queue and returns a guard that keeps the writer thread out
+    /// while the caller writes (or deletes) it synchronously.
+    pub(crate) fn take(&self, key: &K) -> MutexGuard<'_, ()> {
+        let writing = self.shared.writing.lock();
+        self.shared.state.lock().dirty.remove(key);
+        writing
+    }
+
+    /// [`Self::take`] for every queued key.
+    pub(crate) fn take_all(&self) -> MutexGuard<'_, ()> {
+        let writing = self.shared.writing.lock();
+        self.shared.state.lock().dirty.clear();
+        writing
+    }
+
+    /// [`Self::take_all`], handing the queued keys to the caller.
+    pub(crate) fn drain(&self) -> (MutexGuard<'_, ()>, Vec<K>) {
+        let writing = self.shared.writing.lock();
+        let keys = self.shared.state.lock().dirty.drain().collect();
+        (writing, keys)
+    }
+}
+
+impl<K> Drop for WriteBehind<K> {
+    fn drop(&mut self) {
+        self.shared.state.lock().closed = true;
+        self.shared.wake.notify_all();
+    }
+}
+
+impl<K> WriteBehindShared<K> {
+    /// Waits for a change, lets more pile up for `delay` and takes them all.
+    /// `None` once the queue is closed.
+    fn next_batch(&self) -> Option<Vec<K>> {
+        let mut state = self.state.lock();
+        loop {
+            while state.dirty.is_empty() && !state.closed {
+                self.wake.wait(&mut state);
+            }
+            // Only closing cuts the delay short.
+            self.wake.wait_while_for(&mut state, |s| !s.closed, self.delay);
+            if state.closed {
+                return None;
+            }
+            // Empty when a synchronous write took the keys meanwhile.
+            if !state.dirty.is_empty() {
+                return Some(state.dirty.drain().collect());
+            }
+        }
+    }
+}
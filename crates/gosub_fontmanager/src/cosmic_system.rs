@@ -15,11 +15,15 @@ use gosub_interface::font_system::{
     FontQuery, FontStretch, FontSystem, ResolvedFont, RunMetrics, ShapedGlyph, ShapedRun, ShapedText, TextAlign,
     TextStyle,
 };
+use parking_lot::Mutex;
 use std::sync::Arc;
 
 /// A [`FontSystem`] backed by cosmic-text.
+///
+/// cosmic-text keeps its font database and its shaping caches in one mutable object, so unlike
+/// [`crate::ParleyFontSystem`] calls from different threads take turns on an internal lock.
 pub struct CosmicFontSystem {
-    inner: CosmicTextFontSystem,
+    inner: Mutex<CosmicTextFontSystem>,
 }
 
 impl std::fmt::Debug for CosmicFontSystem {
@@ -35,8 +39,8 @@ impl Default for CosmicFontSystem {
 }
 
 /// A run of shaped glyphs that all share one font. Collected while the cosmic-text `buffer`
-/// is borrowed, so the per-run font-blob lookup (which borrows `self.inner`) can run afterward
-/// without overlapping borrows.
+/// is borrowed, so the per-run font-blob lookup (which borrows the locked font system) can run
+/// afterward without overlapping borrows.
 struct RawRun {
     id: fontdb::ID,
     weight: Weight,
@@ -69,59 +73,62 @@ impl CosmicFontSystem {
         inner
             .db_mut()
             .load_font_source(fontdb::Source::Binary(Arc::new(gosub_shared::ROBOTO_FONT)));
-        Self { inner }
+        Self {
+            inner: Mutex::new(inner),
+        }
     }
+}
 
-    /// Build and shape a cosmic-text buffer for `text` in the given style.
-    fn shaped_buffer(&mut self, text: &str, style: &TextStyle) -> Buffer {
-        let metrics = Metrics::new(style.size, style.line_height.unwrap_or(style.size * 1.2));
-        let mut buffer = Buffer::new(&mut self.inner, metrics);
-        buffer.set_size(style.max_width, None);
-        let attrs = Attrs::new()
-            .family(css_family(&style.family))
-            .weight(Weight(style.weight.0))
-            .style(to_style(style.style))
-            .stretch(to_stretch(style.stretch));
-        buffer.set_text(text, &attrs, Shaping::Advanced, None);
-        let align = match style.align {
-            TextAlign::Start => None, // natural per-direction default
-            TextAlign::Center => Some(Align::Center),
-            TextAlign::End => Some(Align::End),
-            TextAlign::Justify => Some(Align::Justified),
-        };
-        if align.is_some() {
-            for line in buffer.lines.iter_mut() {
-                line.set_align(align);
-            }
+/// Build and shape a cosmic-text buffer for `text` in the given style.
+fn shaped_buffer(inner: &mut CosmicTextFontSystem, text: &str, style: &TextStyle) -> Buffer {
+    let metrics = Metrics::new(style.size, style.line_height.unwrap_or(style.size * 1.2));
+    let mut buffer = Buffer::new(inner, metrics);
+    buffer.set_size(style.max_width, None);
+    let attrs = Attrs::new()
+        .family(css_family(&style.family))
+        .weight(Weight(style.weight.0))
+        .style(to_style(style.style))
+        .stretch(to_stretch(style.stretch));
+    buffer.set_text(text, &attrs, Shaping::Advanced, None);
+    let align = match style.align {
+        TextAlign::Start => None, // natural per-direction default
+        TextAlign::Center => Some(Align::Center),
+        TextAlign::End => Some(Align::End),
+        TextAlign::Justify => Some(Align::Justified),
+    };
+    if align.is_some() {
+        for line in buffer.lines.iter_mut() {
+            line.set_align(align);
         }
-        buffer.shape_until_scroll(&mut self.inner, false);
-        buffer
     }
+    buffer.shape_until_scroll(inner, false);
+    buffer
+}
 
-    /// Raw font bytes for a resolved face, as a [`FontBlob`].
-    ///
-    /// cosmic-text doesn't expose the underlying shared `Arc<[u8]>`, so this copies the file
-    /// bytes and assumes face index 0 (correct for single-face files; `.ttc` collections would
-    /// need the real index). Only used to fill `FontBlob`, which a cosmic draw path doesn't yet
-    /// consume - so the copy is harmless for now.
-    fn blob_for(&mut self, id: fontdb::ID, weight: Weight) -> Option<FontBlob> {
-        let font = self.inner.get_font(id, weight)?;
-        Some(FontBlob::new(Arc::new(font.data().to_vec()), 0))
-    }
+/// Raw font bytes for a resolved face, as a [`FontBlob`].
+///
+/// cosmic-text doesn't expose the underlying shared `Arc<[u8]>`, so this copies the file
+/// bytes and assumes face index 0 (correct for single-face files; `.ttc` collections would
+/// need the real index). Only used to fill `FontBlob`, which a cosmic draw path doesn't yet
+/// consume - so the copy is harmless for now.
+fn blob_for(inner: &mut CosmicTextFontSystem, id: fontdb::ID, weight: Weight) -> Option<FontBlob> {
+    let font = inner.get_font(id, weight)?;
+    Some(FontBlob::new(Arc::new(font.data().to_vec()), 0))
 }
 
 impl FontSystem for CosmicFontSystem {
-    fn register_font(&mut self, data: Vec<u8>, _family_override: Option<&str>) -> Result<(), FontError> {
+    fn register_font(&self, data: Vec<u8>, _family_override: Option<&str>) -> Result<(), FontError> {
         // fontdb derives the family name from the font's own `name` table; overrides unsupported.
-        self.inner.db_mut().load_font_data(data);
+        self.inner.lock().db_mut().load_font_data(data);
         Ok(())
     }
 
-    fn measure(&mut self, text: &str, style: &TextStyle) -> (f32, f32) {
+    fn measure(&self, text: &str, style: &TextStyle) -> (f32, f32) {
         if text.is_empty() {
             return (0.0, 0.0);
         }
-        let buffer = self.shaped_buffer(text, style);
+        let mut inner = self.inner.lock();
+        let buffer = shaped_buffer(&mut inner, text, style);
         let mut width = 0.0f32;
         let mut height = 0.0f32;
         for run in buffer.layout_runs() {
@@ -132,7 +139,7 @@ impl FontSystem for CosmicFontSystem {
     }
 
     /// Resolve a CSS font query to a concrete font via fontdb.
-    fn resolve(&mut self, query: &FontQuery<'_>) -> Result<ResolvedFont, FontError> {
+    fn resolve(&self, query: &FontQuery<'_>) -> Result<ResolvedFont, FontError> {
         let mut families: Vec<Family> = query.families.iter().map(|f| css_family(f)).collect();
         // Bundled last-resort fallback so resolution always succeeds even with no system fonts
         // (e.g. headless/CI) - Roboto is registered in `new()`.
@@ -145,14 +152,13 @@ impl FontSystem for CosmicFontSystem {
             style: to_style(query.style),
         };
 
-        let id = self
-            .inner
+        let mut inner = self.inner.lock();
+        let id = inner
             .db_mut()
             .query(&fq)
             .ok_or_else(|| FontError::FontNotFound(query.families.join(", ")))?;
-        let blob = self
-            .blob_for(id, weight)
-            .ok_or_else(|| FontError::FontNotFound(query.families.join(", ")))?;
+        let blob =
+            blob_for(&mut inner, id, weight).ok_or_else(|| FontError::FontNotFound(query.families.join(", ")))?;
 
         Ok(ResolvedFont {
             family: query.families.first().copied().unwrap_or("sans-serif").to_string(),
@@ -163,11 +169,12 @@ impl FontSystem for CosmicFontSystem {
         })
     }
 
-    fn families(&mut self) -> Vec<String> {
+    fn families(&self) -> Vec<String> {
         // A face's `families` holds one name per localisation; the first entry is the
         // primary (typically English) name, which is what CSS matches against.
         let mut out: Vec<String> = self
             .inner
+            .lock()
             .db()
             .faces()
             .filter_map(|face| face.families.first().map(|(name, _)| name.clone()))
@@ -178,15 +185,16 @@ impl FontSystem for CosmicFontSystem {
     }
 
     /// Shape `text` into positioned glyph runs.
-    fn shape(&mut self, text: &str, style: &TextStyle) -> ShapedText {
+    fn shape(&self, text: &str, style: &TextStyle) -> ShapedText {
         if text.is_empty() {
             return ShapedText::empty();
         }
 
-        let buffer = self.shaped_buffer(text, style);
+        let mut inner = self.inner.lock();
+        let buffer = shaped_buffer(&mut inner, text, style);
 
         // Collect owned run data first (borrows `buffer`), then look up font blobs afterwards
-        // (borrows `self.inner`) so the two borrows don't overlap.
+        // (borrows `inner`) so the two borrows don't overlap.
         let mut raw: Vec<RawRun> = Vec::new();
         let mut width = 0.0f32;
         let mut height = 0.0f32;
@@ -237,7 +245,7 @@ impl FontSystem for CosmicFontSystem {
         let runs = raw
             .into_iter()
             .filter_map(|r| {
-                let blob = self.blob_for(r.id, r.weight)?;
+                let blob = blob_for(&mut inner, r.id, r.weight)?;
                 Some(ShapedRun {
                     font: ResolvedFont {
                         family: style.family.clone(),
@@ -319,7 +327,7 @@ mod tests {
     /// and the list must be sorted and de-duplicated.
     #[test]
     fn families_lists_registered_fonts_sorted() {
-        let mut fs = CosmicFontSystem::new();
+        let fs = CosmicFontSystem::new();
         let families = fs.families();
         assert!(families.iter().any(|f| f == "Roboto"), "bundled Roboto must be listed");
         assert!(families.windows(2).all(|w| w[0] < w[1]), "must be sorted and deduped");
@@ -327,7 +335,7 @@ mod tests {
 
     #[test]
     fn resolves_measures_and_shapes() {
-        let mut fs = CosmicFontSystem::new();
+        let fs = CosmicFontSystem::new();
         let query = FontQuery::new(&["sans-serif"]);
         let resolved = fs.resolve(&query).expect("sans-serif should resolve (Roboto fallback)");
 
@@ -421,7 +421,7 @@ impl PangoFontSystem {
     /// `y` on the baseline, per the [`ShapedGlyph`] contract. Each run's font is the one Pango
     /// actually chose (mid-string fallback included), routed back through fontconfig to obtain
     /// its bytes - same database, so the description round-trip lands on the same file.
-    fn runs_from_layout(&mut self, layout: &pango::Layout, style: &TextStyle) -> ShapedText {
+    fn runs_from_layout(&self, layout: &pango::Layout, style: &TextStyle) -> ShapedText {
         let scale = pango::SCALE as f32;
         let (px_w, px_h) = layout.pixel_size();
         let ascent = layout.baseline() as f32 / scale;
@@ -511,11 +511,11 @@ impl PangoFontSystem {
 /// Note: Pango uses its own natural line height (matching how the Cairo rasterizer draws), so
 /// `TextStyle::line_height` is intentionally not applied during measurement or shaping.
 impl FontSystem for PangoFontSystem {
-    fn register_font(&mut self, data: Vec<u8>, family_override: Option<&str>) -> Result<(), FontError> {
+    fn register_font(&self, data: Vec<u8>, family_override: Option<&str>) -> Result<(), FontError> {
         register_font_via_fontconfig(&data, family_override)
     }
 
-    fn resolve(&mut self, query: &FontQuery<'_>) -> Result<ResolvedFont, FontError> {
+    fn resolve(&self, query: &FontQuery<'_>) -> Result<ResolvedFont, FontError> {
         let names = self.fc_family_names(query.families);
         let matched = fontconfig_match(
             &names,
@@ -533,7 +533,7 @@ impl FontSystem for PangoFontSystem {
         })
     }
 
-    fn families(&mut self) -> Vec<String> {
+    fn families(&self) -> Vec<String> {
         // A throwaway pangocairo context (same construction as `build_layout`) reads the
         // default font map - the fontconfig database, including web fonts registered before
         // the font map was first built.
@@ -556,7 +556,7 @@ impl FontSystem for PangoFontSystem {
         out
     }
 
-    fn shape(&mut self, text: &str, style: &TextStyle) -> ShapedText {
+    fn shape(&self, text: &str, style: &TextStyle) -> ShapedText {
         if text.is_empty() {
             return ShapedText::empty();
         }
@@ -566,7 +566,7 @@ impl FontSystem for PangoFontSystem {
         self.runs_from_layout(&layout, style)
     }
 
-    fn measure(&mut self, text: &str, style: &TextStyle) -> (f32, f32) {
+    fn measure(&self, text: &str, style: &TextStyle) -> (f32, f32) {
         if text.is_empty() {
             return (0.0, 0.0);
         }
@@ -670,7 +670,7 @@ mod tests {
     /// with fonts, sorted, de-duplicated.
     #[test]
     fn families_lists_fontconfig_families_sorted() {
-        let mut fs = PangoFontSystem::new();
+        let fs = PangoFontSystem::new();
         let families = fs.families();
         assert!(!families.is_empty(), "fontconfig families must be listed");
         assert!(families.windows(2).all(|w| w[0] < w[1]), "must be sorted and deduped");
@@ -681,7 +681,7 @@ mod tests {
     /// `measure` (both read the same `PangoLayout`).
     #[test]
     fn resolves_and_shapes_via_fontconfig() {
-        let mut fs = PangoFontSystem::new();
+        let fs = PangoFontSystem::new();
 
         let query = FontQuery::new(&["sans-serif"]);
         let resolved = fs.resolve(&query).expect("sans-serif must resolve via fontconfig");
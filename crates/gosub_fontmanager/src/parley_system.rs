@@ -4,22 +4,45 @@ use gosub_interface::font_system::{
     FontQuery, FontStretch, FontSystem, FontWeight, ResolvedFont, RunMetrics, ShapedGlyph, ShapedRun, ShapedText,
     TextAlign, TextStyle,
 };
-use parley::fontique::{Attributes, FontWidth, GenericFamily, QueryFamily, QueryStatus, SourceCache};
+use parking_lot::Mutex;
+use parley::fontique::{
+    Attributes, Collection, CollectionOptions, FontWidth, GenericFamily, QueryFamily, QueryStatus, SourceCache,
+};
 use parley::style::{FontStyle as ParleyStyle, FontWeight as ParleyWeight};
 use parley::{Alignment, AlignmentOptions, FontContext, LayoutContext, PositionedLayoutItem};
+use std::cell::RefCell;
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicU64, Ordering};
 
 /// A [`FontSystem`] implementation backed by Parley + Fontique.
 ///
-/// Holds a single `FontContext` (fontique collection) and `LayoutContext` so that
-/// all callers - the layout engine and every renderer - share the same font data and
-/// produce consistent glyph metrics.
+/// The font data is shared and immutable: the fontique collection and source cache are created
+/// in shared mode, so every clone of them sees the same system fonts, the same loaded font
+/// blobs, and every font registered through any clone. Shaping scratch state is not shared:
+/// each thread that uses the font system gets its own `FontContext` clone and `LayoutContext`,
+/// so the layouter and all rasterizer workers can measure and shape at the same time without
+/// taking a lock.
 ///
-/// Construct once at application start, wrap in `Arc<Mutex<ParleyFontSystem>>`, and
-/// pass the same `Arc` into both the Taffy layouter and the rendering backend.
+/// Construct once at application start, wrap in an `Arc`, and pass the same `Arc` into both the
+/// Taffy layouter and the rendering backend.
 pub struct ParleyFontSystem {
+    /// Distinguishes this instance's per-thread contexts from those of other instances
+    id: u64,
+    /// The context each thread's context is cloned from. Only locked to seed a new thread and to
+    /// register fonts; the clones pick up registrations through the shared collection.
+    template: Mutex<FontContext>,
+}
+
+/// One thread's shaping state for one [`ParleyFontSystem`]
+struct ThreadContext {
     font_cx: FontContext,
     layout_cx: LayoutContext<()>,
-    source_cache: SourceCache,
+}
+
+thread_local! {
+    /// Per-thread contexts, keyed by [`ParleyFontSystem::id`]. Font systems live as long as the
+    /// engine, so entries of dropped instances are not reclaimed.
+    static CONTEXTS: RefCell<HashMap<u64, ThreadContext>> = RefCell::new(HashMap::new());
 }
 
 impl std::fmt::Debug for ParleyFontSystem {
@@ -38,7 +61,15 @@ impl ParleyFontSystem {
     /// Create a new font system with system fonts loaded and Roboto registered as
     /// the built-in fallback.
     pub fn new() -> Self {
-        let mut font_cx = FontContext::new();
+        static NEXT_ID: AtomicU64 = AtomicU64::new(0);
+
+        let mut font_cx = FontContext {
+            collection: Collection::new(CollectionOptions {
+                shared: true,
+                system_fonts: true,
+            }),
+            source_cache: SourceCache::new_shared(),
+        };
 
         // Register Roboto as a bundled fallback so there is always something to
         // render with even on systems that have no fonts installed.
@@ -47,31 +78,106 @@ impl ParleyFontSystem {
             .register_fonts(gosub_shared::ROBOTO_FONT.to_vec().into(), None);
 
         Self {
-            font_cx,
-            layout_cx: LayoutContext::new(),
-            source_cache: SourceCache::new_shared(),
+            id: NEXT_ID.fetch_add(1, Ordering::Relaxed),
+            template: Mutex::new(font_cx),
         }
     }
-}
 
-impl ParleyFontSystem {
-    /// Grants direct access to the underlying Parley font collection.
+    /// Runs `f` with the calling thread's Parley font context.
     ///
-    /// Used by `TaffyLayouter` so that the same font collection is shared between
-    /// the layout engine and rendering, ensuring consistent shaping.
-    pub fn font_cx_mut(&mut self) -> &mut FontContext {
-        &mut self.font_cx
+    /// Used by the Vello backend so that the same font collection is shared between the layout
+    /// engine and rendering, ensuring consistent shaping. `f` must not call back into this font
+    /// system.
+    pub fn with_font_cx<R>(&self, f: impl FnOnce(&mut FontContext) -> R) -> R {
+        self.with_context(|cx| f(&mut cx.font_cx))
+    }
+
+    fn with_context<R>(&self, f: impl FnOnce(&mut ThreadContext) -> R) -> R {
+        CONTEXTS.with(|contexts| {
+            let mut contexts = contexts.borrow_mut();
+            let cx = contexts.entry(self.id).or_insert_with(|| {
+                let template = self.template.lock();
+                ThreadContext {
+                    font_cx: FontContext {
+                        collection: template.collection.clone(),
+                        source_cache: template.source_cache.clone(),
+                    },
+                    layout_cx: LayoutContext::new(),
+                }
+            });
+            f(cx)
+        })
     }
 }
 
 impl FontSystem for ParleyFontSystem {
-    fn register_font(&mut self, data: Vec<u8>, _family_override: Option<&str>) -> Result<(), FontError> {
+    fn register_font(&self, data: Vec<u8>, _family_override: Option<&str>) -> Result<(), FontError> {
         // fontique derives the family name from the font's own `name` table;
-        // custom name overrides are not yet supported here.
-        self.font_cx.collection.register_fonts(data.into(), None);
+        // custom name overrides are not yet supported here. The collection is shared, so every
+        // thread's clone sees the font on its next query.
+        self.template.lock().collection.register_fonts(data.into(), None);
         Ok(())
     }
 
+    /// Resolve a CSS font query to a concrete font + its bytes via fontique.
+    fn resolve(&self, query: &FontQuery<'_>) -> Result<ResolvedFont, FontError> {
+        self.with_context(|cx| cx.resolve(query))
+    }
+
+    fn families(&self) -> Vec<String> {
+        let mut out: Vec<String> =
+            self.with_context(|cx| cx.font_cx.collection.family_names().map(str::to_string).collect());
+        out.sort_unstable();
+        out.dedup();
+        out
+    }
+
+    /// Shape `text` into positioned glyph runs, resolving `style.family` first so shaping starts
+    /// from the same concrete font that [`FontSystem::measure`] used.
+    fn shape(&self, text: &str, style: &TextStyle) -> ShapedText {
+        if text.is_empty() {
+            return ShapedText::empty();
+        }
+        let families = split_css_families(&style.family);
+        let query = FontQuery {
+            families: &families,
+            style: style.style,
+            weight: style.weight,
+            stretch: style.stretch,
+        };
+        self.with_context(|cx| {
+            let Ok(font) = cx.resolve(&query) else {
+                return ShapedText::empty();
+            };
+            cx.shape_resolved(text, &font, style)
+        })
+    }
+
+    /// Measure the bounding box of `text` laid out in `style`, in CSS pixels.
+    ///
+    /// Resolves the family (mapping generics, appending a `sans-serif` fallback) then lays it out
+    /// with Parley and reads the line extents.
+    fn measure(&self, text: &str, style: &TextStyle) -> (f32, f32) {
+        if text.is_empty() {
+            return (0.0, 0.0);
+        }
+        let families = split_css_families(&style.family);
+        let query = FontQuery {
+            families: &families,
+            style: style.style,
+            weight: style.weight,
+            stretch: style.stretch,
+        };
+        self.with_context(|cx| {
+            let Ok(resolved) = cx.resolve(&query) else {
+                return (text.chars().count() as f32 * style.size * 0.5, style.size * 1.2);
+            };
+            cx.measure_resolved(text, &resolved, style)
+        })
+    }
+}
+
+impl ThreadContext {
     /// Resolve a CSS font query to a concrete font + its bytes via fontique.
     fn resolve(&mut self, query: &FontQuery<'_>) -> Result<ResolvedFont, FontError> {
         let families: Vec<QueryFamily> = query.families.iter().map(|&name| css_family_to_query(name)).collect();
@@ -83,7 +189,7 @@ impl FontSystem for ParleyFontSystem {
         );
 
         let mut col_clone = self.font_cx.collection.clone();
-        let mut q = self.font_cx.collection.query(&mut self.source_cache);
+        let mut q = self.font_cx.collection.query(&mut self.font_cx.source_cache);
         q.set_families(families);
         q.set_attributes(attrs);
 
@@ -113,51 +219,8 @@ impl FontSystem for ParleyFontSystem {
         found.ok_or_else(|| FontError::FontNotFound(query.families.join(", ")))
     }
 
-    fn families(&mut self) -> Vec<String> {
-        let mut out: Vec<String> = self.font_cx.collection.family_names().map(str::to_string).collect();
-        out.sort_unstable();
-        out.dedup();
-        out
-    }
-
-    /// Shape `text` into positioned glyph runs, resolving `style.family` first so shaping starts
-    /// from the same concrete font that [`FontSystem::measure`] used.
-    fn shape(&mut self, text: &str, style: &TextStyle) -> ShapedText {
-        if text.is_empty() {
-            return ShapedText::empty();
-        }
-        let families = split_css_families(&style.family);
-        let query = FontQuery {
-            families: &families,
-            style: style.style,
-            weight: style.weight,
-            stretch: style.stretch,
-        };
-        let Ok(font) = self.resolve(&query) else {
-            return ShapedText::empty();
-        };
-        self.shape_resolved(text, &font, style)
-    }
-
-    /// Measure the bounding box of `text` laid out in `style`, in CSS pixels.
-    ///
-    /// Resolves the family (mapping generics, appending a `sans-serif` fallback) then lays it out
-    /// with Parley and reads the line extents.
-    fn measure(&mut self, text: &str, style: &TextStyle) -> (f32, f32) {
-        if text.is_empty() {
-            return (0.0, 0.0);
-        }
-        let families = split_css_families(&style.family);
-        let query = FontQuery {
-            families: &families,
-            style: style.style,
-            weight: style.weight,
-            stretch: style.stretch,
-        };
-        let Ok(resolved) = self.resolve(&query) else {
-            return (text.chars().count() as f32 * style.size * 0.5, style.size * 1.2);
-        };
-
+    /// Lay `text` out with the resolved font and read the line extents.
+    fn measure_resolved(&mut self, text: &str, resolved: &ResolvedFont, style: &TextStyle) -> (f32, f32) {
         let mut builder = self
             .layout_cx
             .ranged_builder(&mut self.font_cx, text, style.display_scale, false);
@@ -193,9 +256,7 @@ impl FontSystem for ParleyFontSystem {
         }
         (width, height)
     }
-}
 
-impl ParleyFontSystem {
     /// Shape `text` with an already-resolved font. Layout parameters (size, line height, wrap
     /// width, letter spacing, display scale) come from `style`; the font identity comes from
     /// `font` - which is why measurement and drawing agree when both go through this path.
@@ -390,7 +451,7 @@ mod tests {
     /// `new()`) proves registered fonts are included, sortedness proves the ordering contract.
     #[test]
     fn families_lists_registered_fonts_sorted() {
-        let mut fs = ParleyFontSystem::new();
+        let fs = ParleyFontSystem::new();
         let families = fs.families();
         assert!(families.iter().any(|f| f == "Roboto"), "bundled Roboto must be listed");
         assert!(families.windows(2).all(|w| w[0] < w[1]), "must be sorted and deduped");
@@ -398,7 +459,7 @@ mod tests {
 
     #[test]
     fn shape_agrees_with_measure_and_applies_letter_spacing() {
-        let mut fs = ParleyFontSystem::new();
+        let fs = ParleyFontSystem::new();
         let mut style = TextStyle::new("sans-serif", 16.0);
 
         let shaped = fs.shape("Hello", &style);
@@ -423,7 +484,7 @@ mod tests {
 
     #[test]
     fn letter_spacing_widens_measurement() {
-        let mut fs = ParleyFontSystem::new();
+        let fs = ParleyFontSystem::new();
         let mut style = TextStyle::new("sans-serif", 16.0);
         let (base_width, _) = fs.measure("Hello", &style);
         assert!(base_width > 0.0, "expected a non-zero base width");
@@ -435,4 +496,29 @@ mod tests {
             "letter-spacing should widen the measurement: {base_width} -> {spaced_width}"
         );
     }
+
+    /// Threads shape with their own contexts over the shared collection, so the results agree
+    /// with the calling thread's and no shaping call waits on another.
+    #[test]
+    fn shapes_concurrently_from_many_threads() {
+        let fs = std::sync::Arc::new(ParleyFontSystem::new());
+        let style = TextStyle::new("sans-serif", 16.0);
+        let expected = fs.measure("Hello, world", &style);
+
+        let handles: Vec<_> = (0..8)
+            .map(|_| {
+                let fs = std::sync::Arc::clone(&fs);
+                let style = style.clone();
+                std::thread::spawn(move || {
+                    let shaped = fs.shape("Hello, world", &style);
+                    (fs.measure("Hello, world", &style), shaped.width)
+                })
+            })
+            .collect();
+        for handle in handles {
+            let (measured, shaped_width) = handle.join().expect("shaping thread panicked");
+            assert_eq!(measured, expected);
+            assert!((shaped_width - expected.0).abs() < 0.01);
+        }
+    }
 }
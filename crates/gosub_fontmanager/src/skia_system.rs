@@ -374,7 +374,7 @@ fn build_style_paragraph(fc: &FontCollection, text: &str, style: &GosubTextStyle
 pub struct SkiaFontSystem;
 
 impl FontSystem for SkiaFontSystem {
-    fn register_font(&mut self, data: Vec<u8>, family_override: Option<&str>) -> Result<(), FontError> {
+    fn register_font(&self, data: Vec<u8>, family_override: Option<&str>) -> Result<(), FontError> {
         // Validate the bytes and derive the family name if none was supplied.
         let family = match family_override {
             Some(f) => f.to_string(),
@@ -392,7 +392,7 @@ impl FontSystem for SkiaFontSystem {
         Ok(())
     }
 
-    fn resolve(&mut self, query: &FontQuery<'_>) -> Result<ResolvedFont, FontError> {
+    fn resolve(&self, query: &FontQuery<'_>) -> Result<ResolvedFont, FontError> {
         let font_style = FontStyle::new(
             skia_safe::font_style::Weight::from(query.weight.0 as i32),
             width_from_css_percent((query.stretch.0 * 100.0).round() as i32),
@@ -429,7 +429,7 @@ impl FontSystem for SkiaFontSystem {
         Err(FontError::FontNotFound(joined))
     }
 
-    fn families(&mut self) -> Vec<String> {
+    fn families(&self) -> Vec<String> {
         // System fonts plus the registered web fonts, which live in a separate provider
         // (`web_font_mgr`) rather than the platform font manager.
         let mut out: Vec<String> = FontMgr::new().family_names().collect();
@@ -441,7 +441,7 @@ impl FontSystem for SkiaFontSystem {
         out
     }
 
-    fn shape(&mut self, text: &str, style: &GosubTextStyle) -> ShapedText {
+    fn shape(&self, text: &str, style: &GosubTextStyle) -> ShapedText {
         if text.is_empty() {
             return ShapedText::empty();
         }
@@ -512,7 +512,7 @@ impl FontSystem for SkiaFontSystem {
         })
     }
 
-    fn measure(&mut self, text: &str, style: &GosubTextStyle) -> (f32, f32) {
+    fn measure(&self, text: &str, style: &GosubTextStyle) -> (f32, f32) {
         if text.is_empty() {
             return (0.0, 0.0);
         }
@@ -550,7 +550,7 @@ mod tests {
     /// machine with fonts) and the process-global web-font registry.
     #[test]
     fn families_includes_system_and_web_fonts() {
-        let mut fs = SkiaFontSystem;
+        let fs = SkiaFontSystem;
         fs.register_font(gosub_shared::ROBOTO_FONT.to_vec(), Some("Gosub Families Test"))
             .expect("bundled Roboto must register");
         let families = fs.families();
@@ -567,7 +567,7 @@ mod tests {
     /// (both read the same textlayout paragraph).
     #[test]
     fn resolves_and_shapes_via_skia() {
-        let mut fs = SkiaFontSystem;
+        let fs = SkiaFontSystem;
 
         let query = FontQuery::new(&["sans-serif"]);
         let resolved = fs.resolve(&query).expect("sans-serif must resolve");
@@ -1,5 +1,15 @@
-use criterion::{criterion_group, criterion_main, Criterion};
+// Benchmark code: panicking on bad input is the desired behavior, as in any test code.
+#![allow(clippy::unwrap_used, clippy::expect_used, clippy::panic)]
+use std::cell::RefCell;
+use std::hint::black_box;
+use std::io::Read as _;
+use std::rc::Rc;
+
+use criterion::{criterion_group, criterion_main, Criterion, Throughput};
+use gosub_html5::parser::errors::ErrorLogger;
 use gosub_html5::testing::tokenizer::{self, FixtureFile};
+use gosub_html5::tokenizer::{ParserData, Tokenizer};
+use gosub_shared::byte_stream::{ByteStream, Config, Encoding, Location};
 
 fn criterion_benchmark(c: &mut Criterion) {
     // Criterion can report inconsistent results from run to run in some cases.  We attempt to
@@ -29,5 +39,77 @@ fn criterion_benchmark(c: &mut Criterion) {
     group.finish();
 }
 
-criterion_group!(benches, criterion_benchmark);
+/// Loads a real-world page relative to the workspace root.
+fn load_page(path: &str) -> String {
+    let path = std::path::Path::new(env!("CARGO_MANIFEST_DIR"))
+        .join("../..")
+        .join(path);
+    std::fs::read_to_string(&path).unwrap_or_else(|e| panic!("failed to read {}: {e}", path.display()))
+}
+
+/// Loads the full WHATWG HTML Living Standard (~15.5 MB) from `resources/whatwg.html.gz`.
+fn load_whatwg_spec() -> String {
+    let path = std::path::Path::new(env!("CARGO_MANIFEST_DIR")).join("../../resources/whatwg.html.gz");
+    let file = std::fs::File::open(&path).unwrap_or_else(|e| panic!("failed to open {}: {e}", path.display()));
+    let mut html = String::new();
+    flate2::read::GzDecoder::new(file)
+        .read_to_string(&mut html)
+        .expect("failed to decompress whatwg.html.gz");
+    html
+}
+
+/// Runs the tokenizer alone (no tree construction) over `stream` until EOF.
+fn tokenize(stream: &mut ByteStream) -> usize {
+    let error_logger = Rc::new(RefCell::new(ErrorLogger::new()));
+    let mut tokenizer = Tokenizer::new(stream, None, error_logger, Location::default());
+    let mut count = 0;
+    loop {
+        let token = tokenizer.next_token(ParserData::default()).unwrap();
+        if token.is_eof() {
+            return count;
+        }
+        count += 1;
+        black_box(token);
+    }
+}
+
+/// Tokenizes large real-world pages once with the UTF-8 in-place stream (which enables
+/// run scanning in the Data and quoted attribute-value states) and once with the
+/// pre-decoded stream, which takes the per-character path.
+fn real_pages(c: &mut Criterion) {
+    let pages = [
+        (
+            "stackoverflow",
+            load_page("tests/data/tree_iterator/stackoverflow.html"),
+        ),
+        ("wikipedia", load_page("tests/data/tree_iterator/wikipedia_main.html")),
+        ("whatwg", load_whatwg_spec()),
+    ];
+
+    let mut group = c.benchmark_group("Tokenizer/pages");
+    group.sample_size(10);
+    for (name, html) in &pages {
+        group.throughput(Throughput::Bytes(html.len() as u64));
+        for (mode, in_place) in [("runs", true), ("per-char", false)] {
+            let mut stream = ByteStream::new(
+                Encoding::UTF8,
+                Some(Config {
+                    utf8_in_place: in_place,
+                    ..Config::default()
+                }),
+            );
+            stream.read_from_str(html, None);
+            stream.close();
+            group.bench_function(format!("{name}/{mode}"), |b| {
+                b.iter(|| {
+                    stream.reset_stream();
+                    black_box(tokenize(&mut stream));
+                });
+            });
+        }
+    }
+    group.finish();
+}
+
+criterion_group!(benches, criterion_benchmark, real_pages);
 criterion_main!(benches);
@@ -1,6 +1,6 @@
 use core::fmt::Debug;
 use gosub_interface::css3::CssSystem;
-use gosub_interface::document::{Document, DocumentType};
+use gosub_interface::document::{Document, DocumentType, DomDamage};
 use std::collections::hash_map::Entry;
 use std::collections::HashMap;
 use std::fmt;
@@ -16,6 +16,7 @@ use crate::node::node_impl::{NodeDataTypeInternal, NodeImpl};
 use crate::node::visitor::Visitor;
 use gosub_interface::config::HasDocument;
 use gosub_interface::node::{NodeType, QuirksMode};
+use gosub_shared::atom::Atom;
 use gosub_shared::byte_stream::Location;
 use gosub_shared::node::NodeId;
 
@@ -32,6 +33,8 @@ pub struct DocumentImpl<C: HasDocument> {
     pub quirks_mode: QuirksMode,
     pub stylesheets: Vec<<C::CssSystem as CssSystem>::Stylesheet>,
     hovered_nodes: parking_lot::RwLock<std::collections::HashSet<NodeId>>,
+    /// Mutations recorded since the last `take_damage`; `None` while tracking is off.
+    damage: Option<Vec<(NodeId, DomDamage)>>,
 }
 
 impl<C: HasDocument> PartialEq for DocumentImpl<C> {
@@ -45,6 +48,27 @@ impl<C: HasDocument> PartialEq for DocumentImpl<C> {
     }
 }
 
+/// Deep copy, for copy-on-write edits of a document that is shared behind an `Arc`. The hover
+/// set is snapshotted; damage tracking carries over along with anything not yet taken.
+impl<C: HasDocument> Clone for DocumentImpl<C>
+where
+    <C::CssSystem as CssSystem>::Stylesheet: Clone,
+{
+    fn clone(&self) -> Self {
+        Self {
+            url: self.url.clone(),
+            arena: self.arena.clone(),
+            named_id_elements: self.named_id_elements.clone(),
+            named_ids_by_node: self.named_ids_by_node.clone(),
+            doctype: self.doctype,
+            quirks_mode: self.quirks_mode,
+            stylesheets: self.stylesheets.clone(),
+            hovered_nodes: parking_lot::RwLock::new(self.hovered_nodes.read().clone()),
+            damage: self.damage.clone(),
+        }
+    }
+}
+
 // ── new Document<C> trait impl ──────────────────────────────────────────────
 
 impl<C: HasDocument<Document = Self>> Document<C> for DocumentImpl<C> {
@@ -58,6 +82,7 @@ impl<C: HasDocument<Document = Self>> Document<C> for DocumentImpl<C> {
             quirks_mode: QuirksMode::NoQuirks,
             stylesheets: Vec::new(),
             hovered_nodes: parking_lot::RwLock::new(std::collections::HashSet::new()),
+            damage: None,
         };
         let root = NodeImpl::new_document(Location::default(), QuirksMode::NoQuirks);
         doc.arena.register_node(root);
@@ -139,19 +164,24 @@ impl<C: HasDocument<Document = Self>> Document<C> for DocumentImpl<C> {
 
     fn attach(&mut self, node: NodeId, parent: NodeId, position: Option<usize>) {
         self.attach_node(node, parent, position);
+        self.record_damage(parent, DomDamage::Style);
     }
 
     fn detach(&mut self, node: NodeId) {
+        self.record_parent_damage(node);
         self.detach_node(node);
     }
 
     fn remove(&mut self, node: NodeId) {
+        self.record_parent_damage(node);
         self.delete_node_by_id(node);
     }
 
     fn relocate_node(&mut self, node: NodeId, parent: NodeId) {
+        self.record_parent_damage(node);
         self.detach_node(node);
         self.attach_node(node, parent, None);
+        self.record_damage(parent, DomDamage::Style);
     }
 
     // ── node type ──────────────────────────────────────────────────────────
@@ -169,6 +199,13 @@ impl<C: HasDocument<Document = Self>> Document<C> for DocumentImpl<C> {
         }
     }
 
+    fn tag_atom(&self, id: NodeId) -> Option<Atom> {
+        match self.arena.node_ref(id)?.data {
+            NodeDataTypeInternal::Element(ref e) => Some(e.name.clone()),
+            _ => None,
+        }
+    }
+
     fn namespace(&self, id: NodeId) -> Option<&str> {
         match self.arena.node_ref(id)?.data {
             NodeDataTypeInternal::Element(ref e) => e.namespace.as_deref(),
@@ -202,6 +239,9 @@ impl<C: HasDocument<Document = Self>> Document<C> for DocumentImpl<C> {
             false
         };
 
+        if is_element {
+            self.record_damage(id, DomDamage::Style);
+        }
         if is_element && name == "id" && is_valid_id_attribute_value(value) {
             if let Entry::Vacant(e) = self.named_id_elements.entry(value.to_string()) {
                 e.insert(id);
@@ -216,6 +256,7 @@ impl<C: HasDocument<Document = Self>> Document<C> for DocumentImpl<C> {
         };
         if let NodeDataTypeInternal::Element(ref mut e) = node.data {
             e.remove_attribute(name);
+            self.record_damage(id, DomDamage::Style);
         }
     }
 
@@ -225,6 +266,7 @@ impl<C: HasDocument<Document = Self>> Document<C> for DocumentImpl<C> {
         };
         if let NodeDataTypeInternal::Element(ref mut e) = node.data {
             e.add_class(class);
+            self.record_damage(id, DomDamage::Style);
         }
     }
 
@@ -238,6 +280,12 @@ impl<C: HasDocument<Document = Self>> Document<C> for DocumentImpl<C> {
         }
     }
 
+    fn for_each_class(&self, id: NodeId, f: &mut dyn FnMut(&str)) {
+        if let Some(NodeDataTypeInternal::Element(e)) = self.arena.node_ref(id).map(|node| &node.data) {
+            e.classlist().active_names().for_each(f);
+        }
+    }
+
     fn template_contents(&self, id: NodeId) -> Option<NodeId> {
         match self.arena.node_ref(id)?.data {
             NodeDataTypeInternal::Element(ref e) => e.template_contents,
@@ -269,6 +317,7 @@ impl<C: HasDocument<Document = Self>> Document<C> for DocumentImpl<C> {
         };
         if let NodeDataTypeInternal::Text(ref mut t) = node.data {
             t.value = value.to_owned();
+            self.record_damage(id, DomDamage::Layout);
         }
     }
 
@@ -280,6 +329,7 @@ impl<C: HasDocument<Document = Self>> Document<C> for DocumentImpl<C> {
             // In-place append: the backing String grows geometrically, so merging N adjacent
             // text runs into this node stays amortized O(total length) instead of O(N^2).
             t.value.push_str(value);
+            self.record_damage(id, DomDamage::Layout);
             true
         } else {
             false
@@ -356,6 +406,7 @@ impl<C: HasDocument<Document = Self>> Document<C> for DocumentImpl<C> {
 
     fn add_stylesheet(&mut self, sheet: <C::CssSystem as CssSystem>::Stylesheet) {
         self.stylesheets.push(sheet);
+        self.record_damage(NodeId::root(), DomDamage::Style);
     }
 
     // ── serialisation ──────────────────────────────────────────────────────
@@ -371,6 +422,22 @@ impl<C: HasDocument<Document = Self>> Document<C> for DocumentImpl<C> {
     fn is_hovered(&self, id: NodeId) -> bool {
         self.hovered_nodes.read().contains(&id)
     }
+
+    fn track_damage(&mut self, on: bool) {
+        match (on, self.damage.is_some()) {
+            (true, false) => self.damage = Some(Vec::new()),
+            (false, true) => self.damage = None,
+            _ => {}
+        }
+    }
+
+    fn mark_damaged(&mut self, id: NodeId, damage: DomDamage) {
+        self.record_damage(id, damage);
+    }
+
+    fn take_damage(&mut self) -> Vec<(NodeId, DomDamage)> {
+        self.damage.as_mut().map(std::mem::take).unwrap_or_default()
+    }
 }
 
 // ── Internal helpers (not part of Document trait) ───────────────────────────
@@ -392,6 +459,22 @@ impl<C: HasDocument<Document = Self>> DocumentImpl<C> {
         }
     }
 
+    fn record_damage(&mut self, id: NodeId, damage: DomDamage) {
+        if let Some(list) = self.damage.as_mut() {
+            list.push((id, damage));
+        }
+    }
+
+    /// Removing a node changes what its siblings match (`:nth-child`, `+`, `~`), so the damage
+    /// goes to the parent.
+    fn record_parent_damage(&mut self, id: NodeId) {
+        if self.damage.is_some() {
+            if let Some(parent) = self.arena.node_ref(id).and_then(|n| n.parent) {
+                self.record_damage(parent, DomDamage::Style);
+            }
+        }
+    }
+
     fn on_document_node_mutation(&mut self, node: &NodeImpl) {
         self.on_document_node_mutation_update_named_id(node);
     }
@@ -771,3 +854,52 @@ fn internal_visit<C: HasDocument<Document = DocumentImpl<C>>>(
     }
     visitor.document_leave(node);
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::parser::Html5Parser;
+    use gosub_css3::system::Css3System;
+    use gosub_interface::config::ModuleConfiguration;
+
+    #[derive(Clone, Debug, PartialEq)]
+    struct Config;
+
+    impl ModuleConfiguration for Config {
+        type CssSystem = Css3System;
+        type Document = DocumentImpl<Self>;
+        type HtmlParser = Html5Parser<'static, Self>;
+    }
+
+    #[test]
+    fn damage_is_recorded_only_while_tracking() {
+        let mut doc = <DocumentImpl<Config> as Document<Config>>::new(DocumentType::HTML, None);
+        let div = doc.create_element("div", None, HashMap::new(), Location::default());
+        doc.attach(div, NodeId::root(), None);
+        assert!(doc.take_damage().is_empty());
+
+        doc.track_damage(true);
+        let text = doc.create_text("hi", Location::default());
+        doc.attach(text, div, None);
+        doc.set_text_value(text, "hello");
+        doc.set_attribute(div, "class", "x");
+        doc.mark_damaged(div, DomDamage::Paint);
+        doc.detach(text);
+
+        assert_eq!(
+            doc.take_damage(),
+            vec![
+                (div, DomDamage::Style),
+                (text, DomDamage::Layout),
+                (div, DomDamage::Style),
+                (div, DomDamage::Paint),
+                (div, DomDamage::Style),
+            ]
+        );
+        assert!(doc.take_damage().is_empty());
+
+        doc.track_damage(false);
+        doc.set_attribute(div, "id", "y");
+        assert!(doc.take_damage().is_empty());
+    }
+}
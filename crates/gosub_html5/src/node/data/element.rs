@@ -3,6 +3,7 @@ use crate::node::elements::{
 };
 use crate::node::{HTML_NAMESPACE, MATHML_NAMESPACE, SVG_NAMESPACE};
 use core::fmt::{Debug, Formatter};
+use gosub_shared::atom::Atom;
 use gosub_shared::node::NodeId;
 use std::collections::hash_map::IntoIter;
 use std::collections::HashMap;
@@ -97,6 +98,14 @@ impl ClassListImpl {
         self.class_map.keys().cloned().collect()
     }
 
+    /// Iterates the active class names without cloning them
+    pub fn active_names(&self) -> impl Iterator<Item = &str> {
+        self.class_map
+            .iter()
+            .filter(|(_, &active)| active)
+            .map(|(name, _)| name.as_str())
+    }
+
     pub fn active_classes(&self) -> Vec<String> {
         self.class_map
             .iter()
@@ -120,7 +129,8 @@ impl From<&str> for ClassListImpl {
 #[derive(PartialEq, Clone)]
 pub struct ElementData {
     pub node_id: Option<NodeId>,
-    pub name: String,
+    /// Interned tag name
+    pub name: Atom,
     pub namespace: Option<String>,
     pub attributes: HashMap<String, String>,
     pub class_list: ClassListImpl,
@@ -1,10 +1,12 @@
 use core::cell::RefCell;
 use core::option::Option::Some;
+use std::any::Any;
 use std::borrow::Cow;
 use std::collections::HashMap;
 #[cfg(all(feature = "debug_parser", test))]
 use std::io::Write;
 use std::rc::Rc;
+use std::sync::Arc;
 
 use crate::node::{HTML_NAMESPACE, MATHML_NAMESPACE, SVG_NAMESPACE};
 use crate::parser::attr_replacements::{
@@ -109,14 +111,49 @@ impl ActiveElement {
     }
 }
 
+/// Supplies an external stylesheet before the parser fetches it itself, e.g. from a fetch the
+/// embedder started when it first saw the `<link>`. `None` falls back to fetching.
+pub type StylesheetSource = Arc<dyn Fn(&Url) -> Option<SuppliedStylesheet> + Send + Sync>;
+
+/// An external stylesheet handed over by a [`StylesheetSource`].
+pub enum SuppliedStylesheet {
+    /// The text of the stylesheet, which the parser then parses.
+    Text(String),
+    /// The stylesheet already parsed by [`parse_external_stylesheet`], e.g. on another thread
+    /// while the document was still arriving. Must hold the document's
+    /// `CssSystem::Stylesheet`; anything else is dropped with a warning.
+    Parsed(Box<dyn Any + Send>),
+}
+
+/// Parses the text of the external stylesheet at `url` the way the parser does for a
+/// `<link rel="stylesheet">`.
+pub fn parse_external_stylesheet<S: CssSystem>(css: &str, origin: CssOrigin, url: &Url) -> Option<S::Stylesheet> {
+    let config = ParserConfig {
+        source: Some(url.to_string()),
+        ignore_errors: true,
+        ..Default::default()
+    };
+
+    match S::parse_str(css, config, origin, url.as_str()) {
+        Ok(stylesheet) => Some(stylesheet),
+        Err(err) => {
+            warn!("Error while parsing CSS stylesheet: {err}");
+            None
+        }
+    }
+}
+
 pub struct Html5ParserOptions {
     pub scripting_enabled: bool,
+    /// Consulted for each `<link rel="stylesheet">` before fetching it.
+    pub stylesheet_source: Option<StylesheetSource>,
 }
 
 impl ParserOptions for Html5ParserOptions {
     fn new(scripting: bool) -> Self {
         Self {
             scripting_enabled: scripting,
+            stylesheet_source: None,
         }
     }
 }
@@ -125,6 +162,7 @@ impl Default for Html5ParserOptions {
     fn default() -> Self {
         Self {
             scripting_enabled: true,
+            stylesheet_source: None,
         }
     }
 }
@@ -187,6 +225,20 @@ pub struct Html5Parser<'tokens, C: HasDocument> {
     parser_finished: bool,
     /// Context node id for fragment parsing
     context_node_id: Option<NodeId>,
+    /// When true, the end of the input received so far pauses the parser instead of ending the
+    /// document (see [`Html5Parser::start_document`])
+    suspend_at_input_end: bool,
+    /// See [`Html5ParserOptions::stylesheet_source`]
+    stylesheet_source: Option<StylesheetSource>,
+}
+
+/// Where [`Html5Parser::resume`] stopped.
+#[derive(Debug)]
+pub enum ParseProgress {
+    /// All input appended so far has been parsed; append more (or close the stream) and resume.
+    NeedsInput,
+    /// The stream was closed and the document is complete.
+    Finished(Vec<ParseError>),
 }
 
 impl<C: HasDocument> gosub_interface::html5::Html5Parser<C> for Html5Parser<'_, C> {
@@ -278,6 +330,7 @@ impl<'a, C: HasDocument> Html5Parser<'a, C> {
         error_logger: Rc<RefCell<ErrorLogger>>,
         options: Option<Html5ParserOptions>,
     ) -> Self {
+        let options = options.unwrap_or_default();
         Self {
             tokenizer,
             insertion_mode: InsertionMode::Initial,
@@ -292,7 +345,7 @@ impl<'a, C: HasDocument> Html5Parser<'a, C> {
             open_elements: Vec::new(),
             head_element: None,
             form_element: None,
-            scripting_enabled: options.unwrap_or_default().scripting_enabled,
+            scripting_enabled: options.scripting_enabled,
             frameset_ok: true,
             foster_parenting: false,
             script_already_started: false,
@@ -308,6 +361,8 @@ impl<'a, C: HasDocument> Html5Parser<'a, C> {
             ignore_lf: false,
             parser_finished: false,
             context_node_id: None,
+            suspend_at_input_end: false,
+            stylesheet_source: options.stylesheet_source,
         }
     }
 
@@ -347,6 +402,8 @@ impl<'a, C: HasDocument> Html5Parser<'a, C> {
             ignore_lf: false,
             parser_finished: false,
             context_node_id: None,
+            suspend_at_input_end: false,
+            stylesheet_source: None,
         }
     }
 
@@ -451,19 +508,61 @@ impl<'a, C: HasDocument> Html5Parser<'a, C> {
         ret
     }
 
+    /// Starts parsing a document whose input is still arriving, e.g. a response body that is
+    /// being downloaded. Append each chunk to the stream (through [`Self::stream_mut`]) and call
+    /// [`Self::resume`], which builds the tree as far as the input allows. Close the stream after
+    /// the last chunk; the next `resume` then finishes the document.
+    ///
+    /// The tree is the same as [`Self::parse_document`] builds from the whole input at once.
+    pub fn start_document(
+        stream: &'a mut ByteStream,
+        document: &'a mut C::Document,
+        options: Option<Html5ParserOptions>,
+    ) -> Self {
+        let error_logger = Rc::new(RefCell::new(ErrorLogger::new()));
+        let tokenizer = Tokenizer::new(stream, None, error_logger.clone(), Location::default());
+        let mut parser = Html5Parser::<C>::init(tokenizer, document, error_logger, options);
+        parser.suspend_at_input_end = true;
+        parser
+    }
+
+    /// Parses the input appended since the previous call, see [`Self::start_document`].
+    pub fn resume(&mut self) -> Result<ParseProgress> {
+        if self.run() {
+            Ok(ParseProgress::Finished(self.error_logger.borrow().get_errors()))
+        } else {
+            Ok(ParseProgress::NeedsInput)
+        }
+    }
+
+    /// The stream being parsed, to append input to or close.
+    pub fn stream_mut(&mut self) -> &mut ByteStream {
+        self.tokenizer.stream
+    }
+
     /// Internal parser function that does the actual parsing
     fn do_parse(&mut self) -> Result<Vec<ParseError>> {
+        self.run();
+        Ok(self.error_logger.borrow().get_errors())
+    }
+
+    /// Runs the tree builder until the document is finished (returns true) or, while suspending
+    /// at the end of the input, the input received so far is used up (returns false).
+    fn run(&mut self) -> bool {
         let mut dispatcher_mode = DispatcherMode::Html;
 
         loop {
             // When the parser is signalled to finish, we break our main parser loop
             if self.parser_finished {
-                break;
+                return true;
             }
 
             // If reprocess_token is true, we should process the same token again
             if !self.reprocess_token {
-                self.current_token = self.fetch_next_token();
+                let Some(token) = self.fetch_next_token() else {
+                    return false;
+                };
+                self.current_token = token;
 
                 // If we reprocess a given token, the dispatcher mode should stay the same and
                 // should not be re-evaluated
@@ -485,8 +584,6 @@ impl<'a, C: HasDocument> Html5Parser<'a, C> {
             #[cfg(all(feature = "debug_parser", test))]
             self.display_debug_info();
         }
-
-        Ok(self.error_logger.borrow().get_errors())
     }
 
     // Process token in foreign content (svg, mathml)
@@ -3843,14 +3940,17 @@ impl<'a, C: HasDocument> Html5Parser<'a, C> {
 
     /// Fetches the next token from the tokenizer. However, if the token is a text token AND
     /// it starts with one or more whitespaces, the token is split into 2 tokens: the whitespace part
-    /// and the remainder.
-    fn fetch_next_token(&mut self) -> Token {
-        match self.tokenizer.next_token(self.parser_data()) {
-            Ok(token) => token,
-            Err(_) => Token::Eof {
-                location: Location::default(),
-            },
-        }
+    /// and the remainder. Returns `None` when the parser suspends at the end of the input so far.
+    fn fetch_next_token(&mut self) -> Option<Token> {
+        let parser_data = self.parser_data();
+        let next = if self.suspend_at_input_end {
+            self.tokenizer.next_token_or_suspend(parser_data)
+        } else {
+            self.tokenizer.next_token(parser_data).map(Some)
+        };
+        next.unwrap_or(Some(Token::Eof {
+            location: Location::default(),
+        }))
     }
 
     /// Returns the NodeId of the adjusted current node.
@@ -4085,7 +4185,22 @@ impl<'a, C: HasDocument> Html5Parser<'a, C> {
 
     #[cfg(not(target_arch = "wasm32"))]
     fn load_external_stylesheet(&self, origin: CssOrigin, url: Url) -> Option<<C::CssSystem as CssSystem>::Stylesheet> {
-        let css = if url.scheme() == "http" || url.scheme() == "https" {
+        let supplied = match self.stylesheet_source.as_ref().and_then(|source| source(&url)) {
+            Some(SuppliedStylesheet::Parsed(sheet)) => {
+                return match sheet.downcast::<<C::CssSystem as CssSystem>::Stylesheet>() {
+                    Ok(sheet) => Some(*sheet),
+                    Err(_) => {
+                        warn!("Supplied stylesheet for {url} is not of the document's CSS system");
+                        None
+                    }
+                };
+            }
+            Some(SuppliedStylesheet::Text(css)) => Some(css),
+            None => None,
+        };
+        let css = if let Some(css) = supplied {
+            css
+        } else if url.scheme() == "http" || url.scheme() == "https" {
             let response = match gosub_sonar::net::simple::sync_fetch(&url) {
                 Ok(r) => r,
                 Err(err) => {
@@ -4132,19 +4247,7 @@ impl<'a, C: HasDocument> Html5Parser<'a, C> {
             return None;
         };
 
-        let config = ParserConfig {
-            source: Some(url.to_string()),
-            ignore_errors: true,
-            ..Default::default()
-        };
-
-        match C::CssSystem::parse_str(css.as_str(), config, origin, url.as_str()) {
-            Ok(stylesheet) => Some(stylesheet),
-            Err(err) => {
-                warn!("Error while parsing CSS stylesheet: {err}");
-                None
-            }
-        }
+        parse_external_stylesheet::<C::CssSystem>(&css, origin, &url)
     }
 
     fn handle_link_element(&mut self, attributes: HashMap<String, String>) {
@@ -4561,4 +4664,98 @@ mod test {
         assert_eq!(div.id, NodeId::from(4usize));
         assert_eq!(div.get_element_data().unwrap().name(), "div");
     }
+
+    #[test]
+    fn parsing_in_chunks_builds_the_same_tree() {
+        let html = "<!DOCTYPE html>\r\n<html><head><title>A &amp; B</title>\
+            <script>if (a < b) { document.write('</div>'); }</script></head>\
+            <body class=\"x\" data-v='1'><!-- note --><p>caf\u{e9} &notin; &copy \u{1F600}\r\n\
+            <pre>\nkeep</pre><table><tr><td>cell</td>stray</table><svg><circle r=\"1\"/></svg>\
+            <textarea>&lt;raw&gt;</textarea></body></html>";
+
+        let mut stream = ByteStream::from_str(html, Encoding::UTF8);
+        let mut expected = DocumentBuilderImpl::new_document::<Config>(None);
+        let _ = Parser::parse_document(&mut stream, &mut expected, None);
+
+        for chunk_size in [1, 2, 7, 64, html.len()] {
+            let mut stream = ByteStream::new(Encoding::UTF8, None);
+            let mut doc = DocumentBuilderImpl::new_document::<Config>(None);
+            {
+                let mut parser = Parser::start_document(&mut stream, &mut doc, None);
+                for chunk in html.as_bytes().chunks(chunk_size) {
+                    parser.stream_mut().append_bytes(chunk);
+                    assert!(matches!(parser.resume(), Ok(ParseProgress::NeedsInput)));
+                }
+                parser.stream_mut().close();
+                assert!(matches!(parser.resume(), Ok(ParseProgress::Finished(_))));
+            }
+            assert!(doc == expected, "chunks of {chunk_size} bytes built a different tree");
+        }
+    }
+
+    #[test]
+    fn builds_the_tree_as_input_arrives() {
+        let mut stream = ByteStream::new(Encoding::UTF8, None);
+        let mut doc = DocumentBuilderImpl::new_document::<Config>(None);
+        let mut parser = Parser::start_document(&mut stream, &mut doc, None);
+
+        parser
+            .stream_mut()
+            .append_bytes(b"<body><div id=\"first\">one</div><div id=\"sec");
+        assert!(matches!(parser.resume(), Ok(ParseProgress::NeedsInput)));
+        assert!(parser.document.get_node_by_named_id("first").is_some());
+        assert!(parser.document.get_node_by_named_id("second").is_none());
+
+        parser.stream_mut().append_bytes(b"ond\">two</div>");
+        parser.stream_mut().close();
+        assert!(matches!(parser.resume(), Ok(ParseProgress::Finished(_))));
+        assert!(parser.document.get_node_by_named_id("second").is_some());
+    }
+
+    #[test]
+    fn external_stylesheets_come_from_the_stylesheet_source() {
+        let html = r#"<html><head><link rel="stylesheet" href="/a.css"></head><body></body></html>"#;
+        let asked = Arc::new(parking_lot::Mutex::new(Vec::new()));
+        let asked_by_source = asked.clone();
+        let options = Html5ParserOptions {
+            stylesheet_source: Some(Arc::new(move |url: &Url| {
+                asked_by_source.lock().push(url.to_string());
+                Some(SuppliedStylesheet::Text("p { color: red; }".to_string()))
+            })),
+            ..Default::default()
+        };
+
+        let mut stream = ByteStream::from_str(html, Encoding::UTF8);
+        let base = Url::parse("https://example.com/index.html").ok();
+        let mut doc = DocumentBuilderImpl::new_document::<Config>(base);
+        let _ = Parser::parse_document(&mut stream, &mut doc, Some(options));
+
+        assert_eq!(*asked.lock(), ["https://example.com/a.css"]);
+        assert_eq!(doc.stylesheets().len(), 1);
+    }
+
+    #[test]
+    fn stylesheet_sources_can_hand_over_parsed_sheets() {
+        let html =
+            r#"<html><head><link rel="stylesheet" href="/a.css"><link rel="stylesheet" href="/b.css"></head></html>"#;
+        let options = Html5ParserOptions {
+            stylesheet_source: Some(Arc::new(|url: &Url| {
+                if url.path() == "/b.css" {
+                    return Some(SuppliedStylesheet::Parsed(Box::new("not a stylesheet")));
+                }
+                let sheet = parse_external_stylesheet::<Css3System>("p { color: red; }", CssOrigin::Author, url)?;
+                Some(SuppliedStylesheet::Parsed(Box::new(sheet)))
+            })),
+            ..Default::default()
+        };
+
+        let mut stream = ByteStream::from_str(html, Encoding::UTF8);
+        let base = Url::parse("https://example.com/index.html").ok();
+        let mut doc = DocumentBuilderImpl::new_document::<Config>(base);
+        let _ = Parser::parse_document(&mut stream, &mut doc, Some(options));
+
+        let sheets = doc.stylesheets();
+        assert_eq!(sheets.len(), 1, "a sheet of the wrong type is dropped");
+        assert_eq!(sheets[0].url, "https://example.com/a.css");
+    }
 }
@@ -196,6 +196,7 @@ impl TestSpec {
                     cr_lf_as_one: true,
                     replace_cr_as_lf: true,
                     replace_high_ascii: false,
+                    utf8_in_place: true,
                 }),
             );
             let input = if self.double_escaped {
@@ -110,6 +110,7 @@ impl Harness {
                 cr_lf_as_one: true,
                 replace_cr_as_lf: true,
                 replace_high_ascii: false,
+                utf8_in_place: true,
             }),
         );
         stream.read_from_str(self.test.spec_data(), None);
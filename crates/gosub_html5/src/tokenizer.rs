@@ -14,7 +14,7 @@ use crate::tokenizer::state::State;
 use crate::tokenizer::token::Token;
 use cow_utils::CowUtils;
 use gosub_shared::byte_stream::Character::{Ch, StreamEnd};
-use gosub_shared::byte_stream::{ByteStream, Character, Location, Stream};
+use gosub_shared::byte_stream::{ByteStream, Character, Location, RunStops, Stream, StreamMark};
 use gosub_shared::types::Result;
 use std::cell::{Ref, RefCell};
 use std::collections::HashMap;
@@ -29,6 +29,28 @@ pub const CHAR_FF: char = '\u{000C}';
 pub const CHAR_SPACE: char = '\u{0020}';
 pub const CHAR_REPLACEMENT: char = '\u{FFFD}';
 
+/// Bytes that `read_char` would flag (controls, and by UTF-8 lead byte the C1 controls and
+/// noncharacters) on top of a state's own special characters. Runs scanned with these stops
+/// hold only characters that the per-character path would copy through unchanged.
+const fn text_run_stops(specials: &[u8]) -> RunStops {
+    RunStops::new(specials)
+        .with_range(0x00, 0x08)
+        .with_range(0x0B, 0x0B)
+        .with_range(0x0E, 0x1F)
+        .with_range(0x7F, 0x7F)
+        .with_range(0xC2, 0xC2)
+        .with_range(0xEF, 0xEF)
+        .with_range(0xF0, 0xF4)
+}
+
+static DATA_RUN_STOPS: RunStops = text_run_stops(b"<&");
+static ATTR_DOUBLE_QUOTED_RUN_STOPS: RunStops = text_run_stops(b"\"&");
+static ATTR_SINGLE_QUOTED_RUN_STOPS: RunStops = text_run_stops(b"'&");
+
+/// Input a suspended token waits for, at least, before [`Tokenizer::next_token_or_suspend`]
+/// reads it again.
+const MIN_RETRY_BYTES: usize = 4 * 1024;
+
 /// The tokenizer will read the input stream and emit tokens that can be used by the parser.
 pub struct Tokenizer<'tokens> {
     /// HTML character input stream
@@ -57,6 +79,9 @@ pub struct Tokenizer<'tokens> {
     pub last_char: Character,
     /// Error logger to log errors to
     pub error_logger: Rc<RefCell<ErrorLogger>>,
+    /// Received input (see [`ByteStream::received_bytes`]) a suspended token waits for before it
+    /// is read again.
+    retry_at: usize,
 }
 
 impl Tokenizer<'_> {
@@ -68,6 +93,21 @@ impl Tokenizer<'_> {
     }
 }
 
+/// Tokenizer state saved by [`Tokenizer::next_token_or_suspend`] before reading a token.
+struct Checkpoint {
+    mark: StreamMark,
+    state: State,
+    consumed: String,
+    current_attr_name: String,
+    current_attr_value: String,
+    current_attrs: HashMap<String, String>,
+    current_token: Option<Token>,
+    temporary_buffer: String,
+    last_start_token: String,
+    last_token_location: Location,
+    last_char: Character,
+}
+
 /// This struct is a gateway between the parser and the tokenizer. It holds data that can be needed
 /// by the tokenizer in certain cases. See <https://github.com/gosub-browser/gosub-engine/issues/230> for
 /// more information and how we should refactor this properly.
@@ -130,6 +170,7 @@ impl<'stream> Tokenizer<'stream> {
             temporary_buffer: String::new(),
             last_char: StreamEnd,
             error_logger,
+            retry_at: 0,
         }
     }
 
@@ -152,6 +193,77 @@ impl<'stream> Tokenizer<'stream> {
         Ok(self.token_queue.remove(0))
     }
 
+    /// Like [`Self::next_token`], but for a stream that is still being appended to: returns `None`
+    /// instead of a token that ran into the end of the input received so far, since more input
+    /// could still change it. The tokenizer is then left as it was before the call, so calling
+    /// again once more input has been appended reads that token again from its start.
+    ///
+    /// A suspended token is only read again once its input has grown by at least half again
+    /// (and by [`MIN_RETRY_BYTES`]), so a token spanning many small appends is re-read a
+    /// logarithmic number of times instead of once per append.
+    ///
+    /// On a closed stream this is `next_token`.
+    pub fn next_token_or_suspend(&mut self, parser_data: ParserData) -> Result<Option<Token>> {
+        if self.stream.closed() || !self.token_queue.is_empty() {
+            return self.next_token(parser_data).map(Some);
+        }
+        if self.stream.received_bytes() < self.retry_at {
+            return Ok(None);
+        }
+
+        let checkpoint = self.checkpoint();
+        let start = self.stream.tell_bytes();
+        self.stream.take_starved();
+        self.consume_stream(parser_data)?;
+        if self.stream.take_starved() {
+            // Errors reported while reading the token are reported again on the next attempt,
+            // at the same location, where the error logger drops them as duplicates.
+            self.restore(checkpoint);
+            let received = self.stream.received_bytes();
+            self.retry_at = received + (received.saturating_sub(start) / 2).max(MIN_RETRY_BYTES);
+            return Ok(None);
+        }
+
+        if self.token_queue.is_empty() {
+            return Ok(Some(Token::Eof {
+                location: self.get_location(),
+            }));
+        }
+        Ok(Some(self.token_queue.remove(0)))
+    }
+
+    /// Snapshot of everything a token read changes, taken between tokens.
+    fn checkpoint(&self) -> Checkpoint {
+        Checkpoint {
+            mark: self.stream.mark(),
+            state: self.state,
+            consumed: self.consumed.clone(),
+            current_attr_name: self.current_attr_name.clone(),
+            current_attr_value: self.current_attr_value.clone(),
+            current_attrs: self.current_attrs.clone(),
+            current_token: self.current_token.clone(),
+            temporary_buffer: self.temporary_buffer.clone(),
+            last_start_token: self.last_start_token.clone(),
+            last_token_location: self.last_token_location,
+            last_char: self.last_char,
+        }
+    }
+
+    fn restore(&mut self, checkpoint: Checkpoint) {
+        self.stream.reset_to_mark(checkpoint.mark);
+        self.state = checkpoint.state;
+        self.consumed = checkpoint.consumed;
+        self.current_attr_name = checkpoint.current_attr_name;
+        self.current_attr_value = checkpoint.current_attr_value;
+        self.current_attrs = checkpoint.current_attrs;
+        self.current_token = checkpoint.current_token;
+        self.temporary_buffer = checkpoint.temporary_buffer;
+        self.token_queue.clear();
+        self.last_start_token = checkpoint.last_start_token;
+        self.last_token_location = checkpoint.last_token_location;
+        self.last_char = checkpoint.last_char;
+    }
+
     /// Returns the error logger
     #[must_use]
     pub fn get_error_logger(&self) -> Ref<'_, ErrorLogger> {
@@ -173,6 +285,13 @@ impl<'stream> Tokenizer<'stream> {
 
             match self.state {
                 State::Data => {
+                    if let Some(run) = self.stream.take_run(&DATA_RUN_STOPS) {
+                        if let Some(last) = run.chars().next_back() {
+                            self.consumed.push_str(run);
+                            self.last_char = Ch(last);
+                            continue;
+                        }
+                    }
                     let loc = self.get_location();
                     let c = self.read_char();
                     match c {
@@ -1079,6 +1198,13 @@ impl<'stream> Tokenizer<'stream> {
                     }
                 }
                 State::AttributeValueDoubleQuoted => {
+                    if let Some(run) = self.stream.take_run(&ATTR_DOUBLE_QUOTED_RUN_STOPS) {
+                        if let Some(last) = run.chars().next_back() {
+                            self.current_attr_value.push_str(run);
+                            self.last_char = Ch(last);
+                            continue;
+                        }
+                    }
                     let loc = self.get_location();
                     let c = self.read_char();
                     match c {
@@ -1100,6 +1226,13 @@ impl<'stream> Tokenizer<'stream> {
                     }
                 }
                 State::AttributeValueSingleQuoted => {
+                    if let Some(run) = self.stream.take_run(&ATTR_SINGLE_QUOTED_RUN_STOPS) {
+                        if let Some(last) = run.chars().next_back() {
+                            self.current_attr_value.push_str(run);
+                            self.last_char = Ch(last);
+                            continue;
+                        }
+                    }
                     let loc = self.get_location();
                     let c = self.read_char();
                     match c {
@@ -2300,3 +2433,36 @@ impl<'stream> Tokenizer<'stream> {
         }
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use gosub_shared::byte_stream::Encoding;
+
+    #[test]
+    fn a_token_over_many_appends_is_read_a_few_times() {
+        let mut stream = ByteStream::new(Encoding::UTF8, None);
+        let error_logger = Rc::new(RefCell::new(ErrorLogger::new()));
+        let mut tokenizer = Tokenizer::new(&mut stream, None, error_logger, Location::default());
+
+        let comment = format!("<!--{}-->", "x".repeat(256 * 1024));
+        let mut reads = 0;
+        let mut token = None;
+        for chunk in comment.as_bytes().chunks(64) {
+            tokenizer.stream.append_bytes(chunk);
+            let retry_at = tokenizer.retry_at;
+            token = tokenizer.next_token_or_suspend(ParserData::default()).unwrap();
+            if tokenizer.retry_at != retry_at || token.is_some() {
+                reads += 1;
+            }
+        }
+        assert!(reads <= 20, "read the comment {reads} times");
+
+        tokenizer.stream.close();
+        let token = match token {
+            Some(token) => Some(token),
+            None => tokenizer.next_token_or_suspend(ParserData::default()).unwrap(),
+        };
+        assert!(matches!(token, Some(Token::Comment { comment, .. }) if comment.len() == 256 * 1024));
+    }
+}
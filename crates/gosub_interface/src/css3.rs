@@ -4,6 +4,8 @@ use gosub_shared::config::ParserConfig;
 use gosub_shared::errors::CssResult;
 use gosub_shared::node::NodeId;
 use std::fmt::{Debug, Display};
+use std::hash::Hash;
+use std::sync::Arc;
 
 /// Defines the origin of the stylesheet (or declaration)
 #[derive(Debug, PartialEq, Clone, Copy)]
@@ -23,7 +25,7 @@ pub enum CssOrigin {
 /// rule targets. Computed by the [`CssSystem`] (via [`CssSystem::hover_fingerprints`]) because
 /// only the CSS implementation understands its own selector structure - the engine stays
 /// agnostic of how selectors are represented.
-#[derive(Default, Debug, Clone)]
+#[derive(Default, Debug, Clone, PartialEq)]
 pub struct HoverFingerprints {
     /// A bare `:hover` / `*:hover` rule exists - every node is hover-sensitive.
     pub has_universal: bool,
@@ -35,16 +37,46 @@ pub struct HoverFingerprints {
     pub ids: std::collections::HashSet<String>,
 }
 
+impl HoverFingerprints {
+    /// Adds the fingerprints of `other`, e.g. those of another stylesheet.
+    pub fn merge(&mut self, other: &Self) {
+        if self.has_universal {
+            return;
+        }
+        if other.has_universal {
+            *self = Self {
+                has_universal: true,
+                ..Self::default()
+            };
+            return;
+        }
+        self.types.extend(other.types.iter().cloned());
+        self.classes.extend(other.classes.iter().cloned());
+        self.ids.extend(other.ids.iter().cloned());
+    }
+}
+
 /// The `CssSystem` trait is a trait that defines all things CSS3 that are used by other non-css3 crates. This is the main trait that
 /// is used to parse CSS3 files. It contains sub elements like the Stylesheet trait that is used in for instance the Document trait.
 pub trait CssSystem: Clone + Debug + 'static {
-    type Stylesheet: CssStylesheet + WasmNotSendSync;
+    type Stylesheet: CssStylesheet + WasmNotSendSync + 'static;
 
     type PropertyMap: CssPropertyMap<Self> + WasmNotSendSync;
 
     type Property: CssProperty<Self> + WasmNotSendSync;
     type Value: CssValue + WasmNotSendSync;
 
+    /// Result of selector matching for one node. Two nodes whose `MatchedRules` compare equal get
+    /// identical maps from [`CssSystem::properties_from_matched`], so callers may compute the map
+    /// once and share it (style sharing). Implementations fold any per-node input the cascade
+    /// reads (such as `attr()`) into the value.
+    type MatchedRules: Clone + Eq + Hash + WasmNotSendSync;
+
+    /// Matching state a tree walk carries down to the descendants of the elements it has entered
+    /// (such as a Bloom filter of their ids, classes and tags), so matching a node does not walk
+    /// its ancestors again. A walk that forks into parallel subtrees clones it per subtree.
+    type AncestorFilter: Clone + Default + WasmNotSendSync;
+
     /// Parses a string into a CSS3 stylesheet
     fn parse_str(str: &str, config: ParserConfig, origin: CssOrigin, source_url: &str) -> CssResult<Self::Stylesheet>;
 
@@ -56,6 +88,43 @@ pub trait CssSystem: Clone + Debug + 'static {
         sheets: &[Self::Stylesheet],
     ) -> Option<Self::PropertyMap>;
 
+    /// Runs only the selector-matching phase of [`CssSystem::properties_from_node`].
+    /// If `None` is returned, the node is not renderable
+    fn match_rules<C: HasDocument<CssSystem = Self>>(
+        doc: &C::Document,
+        id: NodeId,
+        sheets: &[Self::Stylesheet],
+    ) -> Option<Self::MatchedRules>;
+
+    /// [`CssSystem::match_rules`] for a node reached by a tree walk. `ancestors` must have entered
+    /// exactly the ancestors of `id`, root first.
+    fn match_rules_in<C: HasDocument<CssSystem = Self>>(
+        doc: &C::Document,
+        id: NodeId,
+        sheets: &[Self::Stylesheet],
+        ancestors: &Self::AncestorFilter,
+    ) -> Option<Self::MatchedRules>;
+
+    /// Enters `id` during a tree walk, before any of its descendants are matched. Paired with a
+    /// [`CssSystem::leave_element`] once the walk is done with `id`'s subtree.
+    fn enter_element<C: HasDocument<CssSystem = Self>>(
+        ancestors: &mut Self::AncestorFilter,
+        doc: &C::Document,
+        id: NodeId,
+    );
+
+    /// Leaves the element entered last.
+    fn leave_element(ancestors: &mut Self::AncestorFilter);
+
+    /// Runs the cascade phase of [`CssSystem::properties_from_node`] for rules matched earlier by
+    /// [`CssSystem::match_rules`] on the same node.
+    fn properties_from_matched<C: HasDocument<CssSystem = Self>>(
+        doc: &C::Document,
+        id: NodeId,
+        sheets: &[Self::Stylesheet],
+        matched: &Self::MatchedRules,
+    ) -> Self::PropertyMap;
+
     /// Returns the properties that apply to the `::before` / `::after` pseudo-element of `id`.
     /// `pseudo` is the pseudo-element name without colons (`"before"` or `"after"`). Returns
     /// `None` when no rule targets that pseudo-element (so no generated box should be created).
@@ -75,6 +144,11 @@ pub trait CssSystem: Clone + Debug + 'static {
     /// are the subject of a `:hover` rule. Lets the engine cheaply decide whether a hover change
     /// can affect styling without re-running selector matching.
     fn hover_fingerprints(sheets: &[Self::Stylesheet]) -> HoverFingerprints;
+
+    /// Whether any declaration in `sheets` has a viewport-relative length (`vw`, `vh`, `vmin`,
+    /// `vmax` and their variants). Those resolve against the viewport whenever they are read, so
+    /// the same styles lay out and paint differently at another viewport size.
+    fn uses_viewport_units(sheets: &[Self::Stylesheet]) -> bool;
 }
 
 pub trait CssStylesheet: PartialEq + Debug {
@@ -93,6 +167,22 @@ pub trait CssStylesheet: PartialEq + Debug {
     }
 }
 
+/// Stylesheets shared between documents (such as the user agent stylesheet, parsed once per
+/// process) are handed out behind an `Arc`.
+impl<T: CssStylesheet> CssStylesheet for Arc<T> {
+    fn origin(&self) -> CssOrigin {
+        (**self).origin()
+    }
+
+    fn url(&self) -> &str {
+        (**self).url()
+    }
+
+    fn font_faces(&self) -> Vec<(String, Vec<String>, Option<String>)> {
+        (**self).font_faces()
+    }
+}
+
 pub trait CssPropertyMap<S: CssSystem>: Default + Debug + WasmNotSend {
     fn insert_inherited(&mut self, name: &str, value: S::Property);
 
@@ -1,6 +1,7 @@
 use crate::config::HasCssSystem;
 use crate::css3::CssSystem;
 use crate::node::{NodeType, QuirksMode};
+use gosub_shared::atom::Atom;
 use gosub_shared::byte_stream::Location;
 use gosub_shared::node::NodeId;
 use std::collections::HashMap;
@@ -14,6 +15,20 @@ pub enum DocumentType {
     IframeSrcDoc,
 }
 
+/// How much rendering work a DOM mutation invalidates, from cheapest to most expensive. Each
+/// level implies the ones below it.
+#[derive(PartialEq, Eq, PartialOrd, Ord, Hash, Debug, Copy, Clone)]
+pub enum DomDamage {
+    /// Only the node's own appearance changed (colors, backgrounds); its box stays put. The node
+    /// and its descendants are restyled and repainted, layout is reused.
+    Paint,
+    /// The node's geometry may have changed (text edits), but no selector can match differently.
+    Layout,
+    /// Selector matching may change for the node, its siblings and their descendants (attribute,
+    /// class and tree changes).
+    Style,
+}
+
 /// Storage-agnostic document interface.
 ///
 /// All node data is accessed through `NodeId` handles. The concrete storage
@@ -71,6 +86,11 @@ pub trait Document<C: HasCssSystem>: Sized + Display + Debug + PartialEq + 'stat
     // Element data
 
     fn tag_name(&self, id: NodeId) -> Option<&str>;
+    /// Interned tag name, for identity compares without string compares. Implementations that
+    /// store tag names as atoms should return them directly instead of re-interning.
+    fn tag_atom(&self, id: NodeId) -> Option<Atom> {
+        self.tag_name(id).map(Atom::new)
+    }
     fn namespace(&self, id: NodeId) -> Option<&str>;
 
     fn attribute(&self, id: NodeId, name: &str) -> Option<&str>;
@@ -80,6 +100,13 @@ pub trait Document<C: HasCssSystem>: Sized + Display + Debug + PartialEq + 'stat
 
     fn add_class(&mut self, id: NodeId, class: &str);
     fn has_class(&self, id: NodeId, name: &str) -> bool;
+    /// Calls `f` with every class for which [`Document::has_class`] is true. The default reads the
+    /// `class` attribute; implementations that keep a separate class list must override it.
+    fn for_each_class(&self, id: NodeId, f: &mut dyn FnMut(&str)) {
+        if let Some(classes) = self.attribute(id, "class") {
+            classes.split_whitespace().for_each(f);
+        }
+    }
 
     /// Contents of a `<template>` element (points to a fragment root node)
     fn template_contents(&self, id: NodeId) -> Option<NodeId>;
@@ -141,4 +168,19 @@ pub trait Document<C: HasCssSystem>: Sized + Display + Debug + PartialEq + 'stat
     fn is_hovered(&self, _id: NodeId) -> bool {
         false
     }
+
+    // Mutation tracking
+
+    /// Starts or stops recording [`DomDamage`] for mutations. Off by default, so parsing a
+    /// document records nothing; turn it on once the document has been rendered.
+    fn track_damage(&mut self, _on: bool) {}
+
+    /// Records damage for `id` by hand, for changes the document cannot classify itself (e.g. a
+    /// script that only touched paint properties). Ignored while tracking is off.
+    fn mark_damaged(&mut self, _id: NodeId, _damage: DomDamage) {}
+
+    /// Returns and clears the damage recorded since the last call, in mutation order.
+    fn take_damage(&mut self) -> Vec<(NodeId, DomDamage)> {
+        Vec::new()
+    }
 }
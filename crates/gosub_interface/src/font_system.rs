@@ -1,4 +1,3 @@
-use parking_lot::Mutex;
 use std::sync::Arc;
 
 use crate::font::{FontBlob, FontError, FontStyle};
@@ -232,13 +231,16 @@ impl TextStyle {
 /// are everything a rasterizer needs, so any font system serves any backend.
 ///
 /// # Threading
-/// `Send + Sync` so it can live behind `Arc<Mutex<dyn FontSystem>>`, shared between the layouter
-/// and the renderer.
+/// Every method takes `&self` and may be called from many threads at once: the engine shares one
+/// `Arc<dyn FontSystem>` between the layouter and every rasterizer worker, without a lock around
+/// it. Implementations keep their font database immutable-and-shared (or guarded internally for
+/// the rare [`FontSystem::register_font`]) and give each thread its own shaping scratch state, so
+/// parallel measurement and tile painting don't serialize on the font system.
 pub trait FontSystem: Send + Sync + 'static {
     /// Register a font from raw bytes (`@font-face` web fonts, bundled fallbacks).
     ///
     /// `family_override` assigns a logical name CSS can reference; `None` uses the font's own name.
-    fn register_font(&mut self, data: Vec<u8>, family_override: Option<&str>) -> Result<(), FontError>;
+    fn register_font(&self, data: Vec<u8>, family_override: Option<&str>) -> Result<(), FontError>;
 
     /// Resolve a CSS font query to a concrete font, including its raw bytes.
     ///
@@ -246,15 +248,15 @@ pub trait FontSystem: Send + Sync + 'static {
     /// engine's platform fallback) and returns the first matching face. The returned
     /// [`ResolvedFont::family`] is the family that was actually selected, which may differ from
     /// every requested name when the engine fell back.
-    fn resolve(&mut self, query: &FontQuery<'_>) -> Result<ResolvedFont, FontError>;
+    fn resolve(&self, query: &FontQuery<'_>) -> Result<ResolvedFont, FontError>;
 
     /// Every font family this system can resolve by name: installed system fonts plus fonts
     /// added via [`FontSystem::register_font`], sorted and de-duplicated.
     ///
     /// Generic CSS keywords (`sans-serif`, `monospace`, `system-ui`, …) are aliases handled by
-    /// [`FontSystem::resolve`], not families, so they don't appear here. Takes `&mut self`
-    /// because some engines populate their font database lazily on first enumeration.
-    fn families(&mut self) -> Vec<String>;
+    /// [`FontSystem::resolve`], not families, so they don't appear here. Some engines populate
+    /// their font database lazily on first enumeration.
+    fn families(&self) -> Vec<String>;
 
     /// Shape `text` laid out in `style` into positioned glyph runs.
     ///
@@ -262,14 +264,14 @@ pub trait FontSystem: Send + Sync + 'static {
     /// fallback internally; each returned [`ShapedRun`] names the font that was *actually* used
     /// for its glyphs, so a rasterizer can draw the runs without consulting the font system
     /// again. Returns [`ShapedText::empty`] for empty input or when no font resolves.
-    fn shape(&mut self, text: &str, style: &TextStyle) -> ShapedText;
+    fn shape(&self, text: &str, style: &TextStyle) -> ShapedText;
 
     /// Measure the bounding box of `text` laid out in `style`, in CSS pixels.
     ///
     /// The default implementation shapes and reads the bounding box, guaranteeing measurement
     /// agrees with what [`FontSystem::shape`] produces; implementations may override with a
     /// cheaper path as long as they preserve that agreement.
-    fn measure(&mut self, text: &str, style: &TextStyle) -> (f32, f32) {
+    fn measure(&self, text: &str, style: &TextStyle) -> (f32, f32) {
         if text.is_empty() {
             return (0.0, 0.0);
         }
@@ -283,15 +285,15 @@ pub trait FontSystem: Send + Sync + 'static {
 /// Marker trait: a config type `C` that carries a `FontSystem`.
 ///
 /// Implement this on your top-level `Config` struct, then pass
-/// `Arc<Mutex<dyn FontSystem>>` into both the layout engine and the renderer.
+/// `Arc<dyn FontSystem>` into both the layout engine and the renderer.
 ///
 /// ```ignore
 /// impl HasFontSystem for MyConfig {
-///     fn font_system(&self) -> Arc<Mutex<dyn FontSystem>> {
+///     fn font_system(&self) -> Arc<dyn FontSystem> {
 ///         Arc::clone(&self.font_system)
 ///     }
 /// }
 /// ```
 pub trait HasFontSystem {
-    fn font_system(&self) -> Arc<Mutex<dyn FontSystem>>;
+    fn font_system(&self) -> Arc<dyn FontSystem>;
 }
@@ -1,5 +1,6 @@
 use crate::render::render_context::RenderContext;
 use crate::render::viewport::Viewport;
+use gosub_shared::animation::{Easing, ScrollBehavior};
 use gosub_shared::tab_id::TabId;
 use std::any::Any;
 use std::ptr::NonNull;
@@ -56,7 +57,7 @@ pub enum PresentMode {
 /// because Cargo feature unification (e.g. `cargo build --all`) can enable several
 /// `backend_*` features at once, leaving a single rasterizer to win - its output
 /// must be self-describing or colors silently swap.
-#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+#[derive(Clone, Copy, Debug, PartialEq, Eq, Hash)]
 pub enum PixelFormat {
     /// Little-endian premultiplied ARGB32 - bytes are `[B, G, R, A]`. Produced by
     /// the Cairo and Skia rasterizers (Cairo `Format::ARgb32`, Skia n32).
@@ -274,6 +275,9 @@ pub struct CachedTile {
     pub opacity: f32,
     /// How this tile's layer responds to scroll (normal flow vs. `position: fixed`).
     pub anchor: TileAnchor,
+    /// Id of the tile's layer; selects the tiles a [`CompositorSink::animate_layer`] animation
+    /// applies to.
+    pub layer_id: u64,
     /// True when every pixel is fully opaque (alpha == 255). Computed once when the tile is cached;
     /// lets a CPU compositor blit the tile with a plain row copy instead of a per-pixel source-over.
     pub opaque: bool,
@@ -458,10 +462,7 @@ pub trait RenderBackend: Send {
     /// `font_system` is the engine's single shared font system (the config's `FontSystem`).
     /// The rasterizer exposes it to the layouter so measurement uses the configured instance;
     /// painting consumes the pre-shaped glyph runs carried on the text paint commands.
-    fn create_rasterizer(
-        &self,
-        font_system: Arc<parking_lot::Mutex<dyn crate::font_system::FontSystem>>,
-    ) -> Box<dyn Any + Send + Sync> {
+    fn create_rasterizer(&self, font_system: Arc<dyn crate::font_system::FontSystem>) -> Box<dyn Any + Send + Sync> {
         let _ = font_system;
         Box::new(())
     }
@@ -519,6 +520,49 @@ pub trait RenderBackend: Send {
     }
 }
 
+/// A property of a promoted layer the compositor can animate on already-rasterized tiles.
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub enum LayerProperty {
+    /// Group opacity, replacing the layer's own while the animation applies.
+    Opacity { from: f32, to: f32 },
+    /// Offset in CSS px added to the layer's position (a 2D `translate` transform).
+    Translate { from: (f32, f32), to: (f32, f32) },
+}
+
+/// A compositor-side animation of one promoted layer, see [`CompositorSink::animate_layer`].
+/// Once its last run ends the animation holds its end value until it is replaced or removed.
+#[derive(Clone, Debug)]
+pub struct LayerAnimation {
+    pub property: LayerProperty,
+    /// Length of one run.
+    pub duration: std::time::Duration,
+    pub easing: Easing,
+    /// Number of runs; `None` repeats until the animation is replaced or removed.
+    pub iterations: Option<u32>,
+    /// Every other run plays backwards (CSS `animation-direction: alternate`).
+    pub alternate: bool,
+}
+
+impl LayerAnimation {
+    /// Eased progress `elapsed` after the start, and whether the last run has ended.
+    pub fn progress(&self, elapsed: std::time::Duration) -> (f32, bool) {
+        let duration = self.duration.as_secs_f64();
+        let runs = if duration > 0.0 {
+            elapsed.as_secs_f64() / duration
+        } else {
+            f64::INFINITY
+        };
+        let (run, t, finished) = match self.iterations {
+            Some(n) if runs >= n.max(1) as f64 => ((n.max(1) - 1) as f64, 1.0, true),
+            // An endless zero-length animation sits at its end value.
+            None if runs.is_infinite() => (0.0, 1.0, false),
+            _ => (runs.floor(), runs.fract(), false),
+        };
+        let t = if self.alternate && run % 2.0 == 1.0 { 1.0 - t } else { t };
+        (self.easing.eval(t as f32), finished)
+    }
+}
+
 /// Interface for compositors to receive frames from backends.
 pub trait CompositorSink: Send + Sync {
     /// Submit a finished frame for a tab.
@@ -526,6 +570,26 @@ pub trait CompositorSink: Send + Sync {
     /// Takes `&self`: sinks are shared behind an `Arc` and must manage their own interior
     /// mutability (the frame store is already lock-protected), so no outer `RwLock` is needed.
     fn submit_frame(&self, tab: TabId, handle: ExternalHandle);
+
+    /// Eases the scroll offset the tab's `TileCache` frames are presented at toward `target` (CSS
+    /// px) with `behavior`, on the compositor's own clock. The tab then submits a single frame at
+    /// `target` instead of one per animation step. The animation is dropped as soon as a frame at
+    /// another offset is submitted.
+    ///
+    /// Returns `false` when the sink does not animate scrolling (the default); the caller then
+    /// animates the scroll itself.
+    fn scroll_to(&self, _tab: TabId, _target: (f32, f32), _behavior: &ScrollBehavior) -> bool {
+        false
+    }
+
+    /// Starts `animation` on the tiles of layer `layer_id`, replacing any animation already
+    /// running on it, or removes it when `None`. Applied to every frame presented until then,
+    /// without the tab submitting new frames.
+    ///
+    /// Returns `false` when the sink does not animate layers (the default).
+    fn animate_layer(&self, _tab: TabId, _layer_id: u64, _animation: Option<LayerAnimation>) -> bool {
+        false
+    }
 }
 
 #[cfg(test)]
@@ -605,4 +669,29 @@ mod tests {
         let le = u32::from_le_bytes([0x33, 0x22, 0x11, 0xFF]);
         assert_eq!(PixelFormat::PreMulArgb32.pixel_to_argb_u32(le), 0xFF11_2233);
     }
+
+    #[test]
+    fn layer_animation_progress_alternates_and_ends() {
+        use std::time::Duration;
+        let ms = Duration::from_millis;
+        let mut anim = LayerAnimation {
+            property: LayerProperty::Opacity { from: 0.0, to: 1.0 },
+            duration: ms(100),
+            easing: Easing::Linear,
+            iterations: Some(2),
+            alternate: true,
+        };
+        let (t, done) = anim.progress(ms(25));
+        assert!((t - 0.25).abs() < 1e-3 && !done);
+        // Second run plays backwards.
+        let (t, done) = anim.progress(ms(125));
+        assert!((t - 0.75).abs() < 1e-3 && !done);
+        // Holds the end of the last (backwards) run.
+        assert_eq!(anim.progress(ms(1000)), (0.0, true));
+
+        anim.iterations = None;
+        anim.alternate = false;
+        let (t, done) = anim.progress(ms(1025));
+        assert!((t - 0.25).abs() < 1e-3 && !done);
+    }
 }
@@ -0,0 +1,82 @@
+//! Benchmarks for `compute_table_layout` on large data-grid tables built with `MockTable`.
+//!
+//! Run: cargo bench -p gosub_lattice --bench table_layout
+// Benchmark code: panicking on bad input is the desired behavior, as in any test code.
+#![allow(clippy::unwrap_used, clippy::expect_used, clippy::panic)]
+
+use std::hint::black_box;
+
+use criterion::{criterion_group, criterion_main, BatchSize, Criterion, Throughput};
+use gosub_lattice::mock::{cell, MockTable, MockTree};
+use gosub_lattice::{
+    compute_table_layout, compute_table_layout_cached, compute_table_layout_parallel, TableLayoutCache,
+};
+
+const ROWS: usize = 10_000;
+const COLS: usize = 8;
+const WIDTH: f32 = 1200.0;
+
+/// A data grid: one header row, `ROWS` body rows of `COLS` cells with varying content.
+fn data_grid(fixed: bool) -> (MockTree, u32) {
+    let mut table = MockTable::new(WIDTH).spacing(2.0, 2.0);
+    if fixed {
+        table = table.fixed_layout();
+    }
+    table = table.header_row(
+        (0..COLS)
+            .map(|c| cell(format!("col {c}")).content_width(40.0 + 25.0 * c as f32))
+            .collect(),
+    );
+    for row in 0..ROWS {
+        table = table.body_row(
+            (0..COLS)
+                .map(|c| {
+                    cell(format!("{row}:{c}"))
+                        .padding(4.0)
+                        .content_width(30.0 + (row * 7 + c * 13) as f32 % 90.0)
+                        .content_height(14.0 + (row % 3) as f32 * 4.0)
+                })
+                .collect(),
+        );
+    }
+    table.into_tree()
+}
+
+fn table_layout(c: &mut Criterion) {
+    let mut group = c.benchmark_group("TableLayout");
+    group.sample_size(20);
+    group.throughput(Throughput::Elements((ROWS * COLS) as u64));
+
+    for (name, fixed) in [("auto", false), ("fixed", true)] {
+        let (mut tree, root) = data_grid(fixed);
+
+        group.bench_function(format!("{name}/uncached"), |b| {
+            b.iter(|| black_box(compute_table_layout(&mut tree, root, WIDTH, None).unwrap()));
+        });
+
+        group.bench_function(format!("{name}/parallel_cold"), |b| {
+            b.iter_batched(
+                TableLayoutCache::new,
+                |mut cache| black_box(compute_table_layout_parallel(&mut tree, root, WIDTH, None, &mut cache).unwrap()),
+                BatchSize::LargeInput,
+            );
+        });
+
+        // Relayout of an unchanged table at alternating viewport widths: cell metrics come
+        // from the cache, only cells whose column width changed are laid out again.
+        let mut cache = TableLayoutCache::new();
+        compute_table_layout_cached(&mut tree, root, WIDTH, None, &mut cache).unwrap();
+        let mut widths = [WIDTH, WIDTH - 200.0].into_iter().cycle();
+        group.bench_function(format!("{name}/cached_resize"), |b| {
+            b.iter(|| {
+                let width = widths.next().unwrap_or(WIDTH);
+                black_box(compute_table_layout_cached(&mut tree, root, width, None, &mut cache).unwrap())
+            });
+        });
+    }
+
+    group.finish();
+}
+
+criterion_group!(benches, table_layout);
+criterion_main!(benches);
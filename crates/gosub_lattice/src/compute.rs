@@ -2,10 +2,11 @@ use crate::geo::{Point, Size};
 use anyhow::Result;
 
 use crate::grid::{build_section_grid, PlacedCell, SectionGrid};
+use crate::measure::{measure_parallel, measure_serial, MeasureFn, TableLayoutCache};
 use crate::model::{build_model, RowGroup};
-use crate::sizing::columns::compute_column_widths;
-use crate::sizing::rows::{compute_row_heights, read_border, read_padding};
-use crate::types::{CellLayout, CssLength, CssProp};
+use crate::sizing::columns::{column_element_widths, compute_column_widths, sizing_row};
+use crate::sizing::rows::compute_row_heights;
+use crate::types::{CellLayout, CssLength, CssProp, TableSizing};
 use crate::TableTree;
 
 /// Entry point for the CSS table layout algorithm.
@@ -18,10 +19,56 @@ use crate::TableTree;
 /// table occupies.  The caller is responsible for writing the table node's own
 /// layout (its position in the surrounding flow).
 pub fn compute_table_layout<T: TableTree>(
+    tree: &mut T,
+    table_node: T::NodeId,
+    available_width: f32,
+    available_height: Option<f32>,
+) -> Result<(f32, f32)> {
+    compute_table_layout_cached(
+        tree,
+        table_node,
+        available_width,
+        available_height,
+        &mut TableLayoutCache::new(),
+    )
+}
+
+/// [`compute_table_layout`], reusing the cell measurements that `cache` kept from
+/// earlier layouts of the same table (see [`TableLayoutCache`]).
+pub fn compute_table_layout_cached<T: TableTree>(
+    tree: &mut T,
+    table_node: T::NodeId,
+    available_width: f32,
+    _available_height: Option<f32>,
+    cache: &mut TableLayoutCache<T::NodeId>,
+) -> Result<(f32, f32)> {
+    lay_out_table(tree, table_node, available_width, cache, measure_serial::<T>)
+}
+
+/// [`compute_table_layout_cached`], measuring changed cells on the rayon pool.
+///
+/// Pays off for large tables (thousands of cells) on trees whose style reads are
+/// cheap to share across threads; small tables are measured inline.
+pub fn compute_table_layout_parallel<T>(
     tree: &mut T,
     table_node: T::NodeId,
     available_width: f32,
     _available_height: Option<f32>,
+    cache: &mut TableLayoutCache<T::NodeId>,
+) -> Result<(f32, f32)>
+where
+    T: TableTree + Sync,
+    T::NodeId: Send + Sync,
+{
+    lay_out_table(tree, table_node, available_width, cache, measure_parallel::<T>)
+}
+
+fn lay_out_table<T: TableTree>(
+    tree: &mut T,
+    table_node: T::NodeId,
+    available_width: f32,
+    cache: &mut TableLayoutCache<T::NodeId>,
+    measure: MeasureFn<T>,
 ) -> Result<(f32, f32)> {
     let model = build_model(tree, table_node);
     let (spacing_x, spacing_y) = model.border_spacing;
@@ -52,6 +99,7 @@ pub fn compute_table_layout<T: TableTree>(
         .unwrap_or(0);
 
     if n_cols == 0 {
+        cache.clear();
         return Ok((0.0, 0.0));
     }
 
@@ -62,14 +110,33 @@ pub fn compute_table_layout<T: TableTree>(
         _ => available_width,
     };
 
-    // Column widths
     let all_grids: Vec<&SectionGrid<T::NodeId>> = header_grids
         .iter()
         .chain(body_grids.iter())
         .chain(footer_grids.iter())
         .collect();
 
-    let col_widths = compute_column_widths(tree, n_cols, table_width, spacing_x, &all_grids);
+    // Cell measurements. Only the row that sizes the columns needs natural content
+    // widths, and only under auto layout; its cells come first in the list.
+    let first_row = sizing_row(&all_grids);
+    let mut cells: Vec<(T::NodeId, bool)> = all_grids
+        .iter()
+        .flat_map(|g| g.cells())
+        .map(|c| (c.node, false))
+        .collect();
+    if model.sizing == TableSizing::Auto {
+        for (entry, cell) in cells.iter_mut().zip(first_row) {
+            entry.1 = cell.colspan == 1;
+        }
+    }
+    cache.refresh(tree, &cells, measure);
+
+    // Column widths
+    let columns = match model.sizing {
+        TableSizing::Fixed => column_element_widths(tree, &model.column_groups),
+        TableSizing::Auto => Vec::new(),
+    };
+    let col_widths = compute_column_widths(model.sizing, n_cols, table_width, spacing_x, &columns, first_row, cache);
 
     // Precompute cumulative column x-offsets (relative to the row's left edge).
     // col_x[i] = x of the left edge of column i (within a row).
@@ -83,17 +150,17 @@ pub fn compute_table_layout<T: TableTree>(
     // the model is also borrowed.
     let mut header_heights: Vec<Vec<f32>> = Vec::with_capacity(header_grids.len());
     for grid in &header_grids {
-        header_heights.push(compute_row_heights(tree, grid, &col_widths));
+        header_heights.push(compute_row_heights(tree, grid, &col_widths, cache));
     }
 
     let mut body_heights: Vec<Vec<f32>> = Vec::with_capacity(body_grids.len());
     for grid in &body_grids {
-        body_heights.push(compute_row_heights(tree, grid, &col_widths));
+        body_heights.push(compute_row_heights(tree, grid, &col_widths, cache));
     }
 
     let mut footer_heights: Vec<Vec<f32>> = Vec::with_capacity(footer_grids.len());
     for grid in &footer_grids {
-        footer_heights.push(compute_row_heights(tree, grid, &col_widths));
+        footer_heights.push(compute_row_heights(tree, grid, &col_widths, cache));
     }
 
     // Apply positions
@@ -142,6 +209,7 @@ pub fn compute_table_layout<T: TableTree>(
                 &col_widths,
                 spacing_x,
                 spacing_y,
+                cache,
             );
 
             group_y += group_height + spacing_y;
@@ -164,6 +232,7 @@ fn place_rows<T: TableTree>(
     col_widths: &[f32],
     spacing_x: f32,
     spacing_y: f32,
+    cache: &TableLayoutCache<T::NodeId>,
 ) {
     // Precompute y offset of each row within the group.
     let row_y = row_y_offsets(row_heights, spacing_y);
@@ -187,7 +256,17 @@ fn place_rows<T: TableTree>(
 
         // Cells for this row.
         for cell in grid.cells_in_row(row_idx) {
-            place_cell(tree, cell, row_heights, col_x, col_widths, &row_y, spacing_x, spacing_y);
+            place_cell(
+                tree,
+                cell,
+                row_heights,
+                col_x,
+                col_widths,
+                &row_y,
+                spacing_x,
+                spacing_y,
+                cache,
+            );
         }
     }
 }
@@ -203,6 +282,7 @@ fn place_cell<T: TableTree>(
     row_y: &[f32],
     spacing_x: f32,
     spacing_y: f32,
+    cache: &TableLayoutCache<T::NodeId>,
 ) {
     // Width = sum of spanned column widths, plus the border-spacing gutters the
     // spanning cell covers (a colspan=2 cell runs across the gutter between its
@@ -221,8 +301,8 @@ fn place_cell<T: TableTree>(
     let start_row_y = row_y.get(cell.row).copied().unwrap_or(0.0);
     let y_within_row = cell_row_y - start_row_y; // always 0.0 for row-relative coords
 
-    let border = read_border(tree, cell.node);
-    let padding = read_padding(tree, cell.node);
+    let metrics = cache.metrics(cell.node);
+    let (border, padding) = (metrics.border, metrics.padding);
 
     tree.set_layout(
         cell.node,
@@ -29,7 +29,17 @@ impl<N: Copy> SectionGrid<N> {
 
     /// Iterate over cells whose `row` field equals `row_idx`.
     pub fn cells_in_row(&self, row_idx: usize) -> impl Iterator<Item = &PlacedCell<N>> {
-        self.cells.iter().filter(move |c| c.row == row_idx)
+        self.row_cells(row_idx).iter()
+    }
+
+    /// The cells whose `row` field equals `row_idx`, in column order.
+    ///
+    /// Placement pushes cells row by row, so a row's cells are contiguous and found by binary
+    /// search rather than a scan of the whole section.
+    pub fn row_cells(&self, row_idx: usize) -> &[PlacedCell<N>] {
+        let start = self.cells.partition_point(|c| c.row < row_idx);
+        let end = start + self.cells[start..].partition_point(|c| c.row == row_idx);
+        &self.cells[start..end]
     }
 
     /// For each column, returns `true` if a spanning cell crosses the horizontal
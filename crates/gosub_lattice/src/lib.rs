@@ -1,13 +1,15 @@
 pub mod compute;
 pub mod geo;
 pub mod grid;
+pub mod measure;
 pub mod mock;
 pub mod model;
 pub mod sizing;
 mod tests;
 pub mod types;
 
-pub use compute::compute_table_layout;
+pub use compute::{compute_table_layout, compute_table_layout_cached, compute_table_layout_parallel};
+pub use measure::{CellMetrics, TableLayoutCache};
 pub use types::{BorderCollapse, BoxEdges, CellLayout, CssLength, CssProp, TableRole, TableSizing};
 
 use std::fmt::Debug;
@@ -54,4 +56,14 @@ pub trait TableTree {
     fn cell_content_width(&self, _id: Self::NodeId) -> f32 {
         0.0
     }
+
+    /// A value that changes whenever the content or style of cell `id` changes.
+    ///
+    /// With a [`TableLayoutCache`], cells whose revision is unchanged are not measured
+    /// again, and `layout_cell` is not called again for them at an unchanged width.
+    /// Return `None` (the default) when the tree cannot tell; such cells are measured on
+    /// every layout.
+    fn cell_revision(&self, _id: Self::NodeId) -> Option<u64> {
+        None
+    }
 }
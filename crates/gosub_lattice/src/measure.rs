@@ -0,0 +1,215 @@
+use std::collections::HashMap;
+use std::hash::Hash;
+
+use rayon::prelude::*;
+
+use crate::sizing::rows::{read_border, read_padding};
+use crate::types::{BoxEdges, CssLength, CssProp};
+use crate::TableTree;
+
+/// Below this many cells, handing measurement to the rayon pool costs more than it saves.
+const PARALLEL_MIN_CELLS: usize = 1024;
+
+/// Measures the given cells; the `bool` says whether the cell's content width is needed.
+pub(crate) type MeasureFn<T> = fn(&T, &[(<T as TableTree>::NodeId, bool)]) -> Vec<CellMetrics>;
+
+/// The sizes of one cell that the table algorithm reads from the tree.
+#[derive(Debug, Clone, Copy)]
+pub struct CellMetrics {
+    pub border: BoxEdges,
+    pub padding: BoxEdges,
+    /// Specified CSS `width`.
+    pub width: CssLength,
+    /// Specified CSS `height`.
+    pub height: CssLength,
+    /// Natural width from [`TableTree::cell_content_width`]. Only measured for the cells that
+    /// size columns (the first row of an auto-layout table).
+    pub content_width: Option<f32>,
+}
+
+impl CellMetrics {
+    /// Metrics of a cell without border, padding, or a specified size.
+    pub const EMPTY: Self = Self {
+        border: BoxEdges {
+            top: 0.0,
+            right: 0.0,
+            bottom: 0.0,
+            left: 0.0,
+        },
+        padding: BoxEdges {
+            top: 0.0,
+            right: 0.0,
+            bottom: 0.0,
+            left: 0.0,
+        },
+        width: CssLength::Auto,
+        height: CssLength::Auto,
+        content_width: None,
+    };
+
+    /// Reads the metrics of `node` from `tree`.
+    pub fn measure<T: TableTree>(tree: &T, node: T::NodeId, with_content_width: bool) -> Self {
+        Self {
+            border: read_border(tree, node),
+            padding: read_padding(tree, node),
+            width: tree.css_length(node, CssProp::Width),
+            height: tree.css_length(node, CssProp::Height),
+            content_width: with_content_width.then(|| tree.cell_content_width(node)),
+        }
+    }
+}
+
+pub(crate) fn measure_serial<T: TableTree>(tree: &T, cells: &[(T::NodeId, bool)]) -> Vec<CellMetrics> {
+    cells
+        .iter()
+        .map(|&(node, with_content_width)| CellMetrics::measure(tree, node, with_content_width))
+        .collect()
+}
+
+pub(crate) fn measure_parallel<T>(tree: &T, cells: &[(T::NodeId, bool)]) -> Vec<CellMetrics>
+where
+    T: TableTree + Sync,
+    T::NodeId: Send + Sync,
+{
+    if cells.len() < PARALLEL_MIN_CELLS {
+        return measure_serial(tree, cells);
+    }
+    cells
+        .par_iter()
+        .with_min_len(PARALLEL_MIN_CELLS / 4)
+        .map(|&(node, with_content_width)| CellMetrics::measure(tree, node, with_content_width))
+        .collect()
+}
+
+struct CachedCell {
+    revision: Option<u64>,
+    metrics: CellMetrics,
+    /// Inner width the cell was last laid out at, and the content height `layout_cell` reported.
+    content_height: Option<(f32, f32)>,
+    /// Layout that last saw the cell; cells a layout did not see have left the table.
+    pass: u64,
+}
+
+impl CachedCell {
+    fn is_current(&self, revision: Option<u64>, with_content_width: bool) -> bool {
+        revision.is_some() && self.revision == revision && (!with_content_width || self.metrics.content_width.is_some())
+    }
+}
+
+/// Cell measurements kept across layouts of one table.
+///
+/// A cell's metrics, and its content height at a given width, are reused for as long as its
+/// [`TableTree::cell_revision`] stays the same. A relayout of an unchanged table (e.g. after a
+/// viewport resize) then reads no cell styles and only lays out the cells whose column width
+/// changed. Cells without a revision are measured on every layout.
+///
+/// Keep one cache per table node; cells that leave the table are dropped on the next layout.
+pub struct TableLayoutCache<N> {
+    cells: HashMap<N, CachedCell>,
+    pass: u64,
+}
+
+impl<N> Default for TableLayoutCache<N> {
+    fn default() -> Self {
+        Self {
+            cells: HashMap::new(),
+            pass: 0,
+        }
+    }
+}
+
+impl<N: Copy + Eq + Hash> TableLayoutCache<N> {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Number of cells with cached measurements.
+    pub fn len(&self) -> usize {
+        self.cells.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.cells.is_empty()
+    }
+
+    pub fn clear(&mut self) {
+        self.cells.clear();
+    }
+
+    /// Brings the cache up to date for a layout of exactly `cells`: measures those that are new
+    /// or changed through `measure`, and forgets cells that are no longer in the table.
+    pub(crate) fn refresh<T>(&mut self, tree: &T, cells: &[(N, bool)], measure: MeasureFn<T>)
+    where
+        T: TableTree<NodeId = N>,
+    {
+        self.pass += 1;
+        let pass = self.pass;
+
+        let mut stale = Vec::new();
+        let mut revisions = Vec::new();
+        for &(node, with_content_width) in cells {
+            let revision = tree.cell_revision(node);
+            match self.cells.get_mut(&node) {
+                Some(cached) if cached.is_current(revision, with_content_width) => cached.pass = pass,
+                _ => {
+                    stale.push((node, with_content_width));
+                    revisions.push(revision);
+                }
+            }
+        }
+
+        let measured = measure(tree, &stale);
+        for ((&(node, _), revision), metrics) in stale.iter().zip(revisions).zip(measured) {
+            // A cell only re-measured for its content width keeps its cached content height.
+            let content_height = self
+                .cells
+                .get(&node)
+                .filter(|cached| revision.is_some() && cached.revision == revision)
+                .and_then(|cached| cached.content_height);
+            self.cells.insert(
+                node,
+                CachedCell {
+                    revision,
+                    metrics,
+                    content_height,
+                    pass,
+                },
+            );
+        }
+
+        if self.cells.len() > cells.len() {
+            self.cells.retain(|_, cached| cached.pass == pass);
+        }
+    }
+
+    /// Metrics of `node` as of the last [`Self::refresh`].
+    pub(crate) fn metrics(&self, node: N) -> &CellMetrics {
+        self.cells
+            .get(&node)
+            .map_or(&CellMetrics::EMPTY, |cached| &cached.metrics)
+    }
+
+    /// Content height of `node` laid out at `inner_width`, asking the tree only when the cell
+    /// changed or was last laid out at another width.
+    pub(crate) fn content_height<T>(&mut self, tree: &mut T, node: N, inner_width: f32) -> f32
+    where
+        T: TableTree<NodeId = N>,
+    {
+        let Some(cached) = self.cells.get_mut(&node) else {
+            return tree.layout_cell(node, inner_width);
+        };
+        if cached.revision.is_some() {
+            if let Some((width, height)) = cached.content_height {
+                if width == inner_width {
+                    return height;
+                }
+            }
+        }
+
+        let height = tree.layout_cell(node, inner_width);
+        if cached.revision.is_some() {
+            cached.content_height = Some((inner_width, height));
+        }
+        height
+    }
+}
@@ -4,6 +4,7 @@
 /// diagram, or [`MockTable::into_tree`] to get the raw [`MockTree`] and run
 /// `compute_table_layout` yourself.
 use std::collections::HashMap;
+use std::sync::atomic::{AtomicUsize, Ordering};
 
 use crate::compute::compute_table_layout;
 use crate::grid::{build_section_grid, PlacedCell, SectionGrid};
@@ -94,6 +95,9 @@ pub struct MockTable {
     available_width: f32,
     border_spacing_x: f32,
     border_spacing_y: f32,
+    fixed_layout: bool,
+    /// Specified widths of `<col>` elements, in column order.
+    columns: Vec<Option<f32>>,
     header_rows: Vec<Vec<MockCell>>,
     body_rows: Vec<Vec<MockCell>>,
     footer_rows: Vec<Vec<MockCell>>,
@@ -115,6 +119,18 @@ impl MockTable {
         self
     }
 
+    /// Use `table-layout: fixed`.
+    pub fn fixed_layout(mut self) -> Self {
+        self.fixed_layout = true;
+        self
+    }
+
+    /// Add a `<col>` element, with an explicit pixel width if given.
+    pub fn column(mut self, width: Option<f32>) -> Self {
+        self.columns.push(width);
+        self
+    }
+
     pub fn header_row(mut self, cells: Vec<MockCell>) -> Self {
         self.header_rows.push(cells);
         self
@@ -141,8 +157,18 @@ impl MockTable {
     /// Convert into a raw [`MockTree`] (root NodeId is returned alongside).
     pub fn into_tree(self) -> (MockTree, u32) {
         let mut tree = MockTree::new(self.border_spacing_x, self.border_spacing_y);
+        tree.set_fixed_layout(self.fixed_layout);
         let root = tree.alloc(TableRole::Table, None, 1, 1, None, None, 0.0, 0.0);
 
+        if !self.columns.is_empty() {
+            let cg = tree.alloc(TableRole::ColumnGroup, None, 1, 1, None, None, 0.0, 0.0);
+            tree.add_child(root, cg);
+            for width in self.columns {
+                let col = tree.alloc(TableRole::Column, None, 1, 1, width, None, 0.0, 0.0);
+                tree.add_child(cg, col);
+            }
+        }
+
         if !self.header_rows.is_empty() {
             let hg = tree.alloc(TableRole::HeaderGroup, None, 1, 1, None, None, 0.0, 0.0);
             tree.add_child(root, hg);
@@ -201,6 +227,8 @@ struct MockNode {
     padding: f32,
     content_width: f32,
     content_height: f32,
+    /// Bumped by every change to the node, reported through `cell_revision`.
+    revision: u64,
 }
 
 pub struct MockTree {
@@ -208,6 +236,11 @@ pub struct MockTree {
     next_id: u32,
     border_spacing_x: f32,
     border_spacing_y: f32,
+    fixed_layout: bool,
+    /// Style and content-width reads of cell nodes, for asserting on cache hits.
+    cell_reads: AtomicUsize,
+    /// `layout_cell` calls.
+    cell_layouts: usize,
 }
 
 impl MockTree {
@@ -217,9 +250,36 @@ impl MockTree {
             next_id: 0,
             border_spacing_x,
             border_spacing_y,
+            fixed_layout: false,
+            cell_reads: AtomicUsize::new(0),
+            cell_layouts: 0,
+        }
+    }
+
+    /// Switch the table between `table-layout: fixed` and `auto`.
+    pub fn set_fixed_layout(&mut self, fixed: bool) {
+        self.fixed_layout = fixed;
+    }
+
+    /// Change what laying out cell `id` reports, as a content change would.
+    pub fn set_content(&mut self, id: u32, content_width: f32, content_height: f32) {
+        if let Some(node) = self.nodes.get_mut(&id) {
+            node.content_width = content_width;
+            node.content_height = content_height;
+            node.revision += 1;
         }
     }
 
+    /// Number of `css_length` and `cell_content_width` calls made on cells so far.
+    pub fn cell_reads(&self) -> usize {
+        self.cell_reads.load(Ordering::Relaxed)
+    }
+
+    /// Number of `layout_cell` calls made so far.
+    pub fn cell_layouts(&self) -> usize {
+        self.cell_layouts
+    }
+
     #[allow(clippy::too_many_arguments)]
     pub fn alloc(
         &mut self,
@@ -249,6 +309,7 @@ impl MockTree {
                 padding,
                 content_width: 0.0,
                 content_height: 0.0,
+                revision: 0,
             },
         );
         id
@@ -315,6 +376,9 @@ impl TableTree for MockTree {
         let Some(node) = self.nodes.get(&id) else {
             return CssLength::Auto;
         };
+        if node.role == TableRole::Cell {
+            self.cell_reads.fetch_add(1, Ordering::Relaxed);
+        }
         match prop {
             CssProp::Width => node.width.map(CssLength::Px).unwrap_or(CssLength::Auto),
             CssProp::Height => node.height.map(CssLength::Px).unwrap_or(CssLength::Auto),
@@ -327,6 +391,8 @@ impl TableTree for MockTree {
             }
             CssProp::BorderSpacingX => CssLength::Px(self.border_spacing_x),
             CssProp::BorderSpacingY => CssLength::Px(self.border_spacing_y),
+            // Px(1.0) = fixed sentinel (see model.rs)
+            CssProp::TableLayout if self.fixed_layout && node.role == TableRole::Table => CssLength::Px(1.0),
             _ => CssLength::Auto,
         }
     }
@@ -336,6 +402,8 @@ impl TableTree for MockTree {
         match attr {
             "colspan" => Some(node.colspan),
             "rowspan" => Some(node.rowspan),
+            // `<col span>`; columns keep it in the colspan field.
+            "span" if node.role == TableRole::Column => Some(node.colspan),
             _ => None,
         }
     }
@@ -351,12 +419,18 @@ impl TableTree for MockTree {
         // spec field stands in for the height its children would occupy.
         // Cells without one (the default 0.0) are driven by explicit CSS
         // `height` instead (see rows.rs).
+        self.cell_layouts += 1;
         self.nodes.get(&id).map(|n| n.content_height).unwrap_or(0.0)
     }
 
     fn cell_content_width(&self, id: u32) -> f32 {
+        self.cell_reads.fetch_add(1, Ordering::Relaxed);
         self.nodes.get(&id).map(|n| n.content_width).unwrap_or(0.0)
     }
+
+    fn cell_revision(&self, id: u32) -> Option<u64> {
+        self.nodes.get(&id).map(|n| n.revision)
+    }
 }
 
 // ASCII renderer
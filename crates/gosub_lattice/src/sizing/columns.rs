@@ -1,26 +1,67 @@
-use crate::grid::SectionGrid;
-use crate::types::{CssLength, CssProp};
+use std::hash::Hash;
+
+use crate::grid::{PlacedCell, SectionGrid};
+use crate::measure::TableLayoutCache;
+use crate::model::ColGroup;
+use crate::types::{CssLength, CssProp, TableSizing};
 use crate::TableTree;
 
+/// The cells that size the columns: those of the first non-empty row across all
+/// provided grids (header first, then body, then footer).
+pub fn sizing_row<'a, N: Copy>(grids: &[&'a SectionGrid<N>]) -> &'a [PlacedCell<N>] {
+    grids
+        .iter()
+        .flat_map(|grid| (0..grid.n_rows).map(|row_idx| grid.row_cells(row_idx)))
+        .find(|cells| !cells.is_empty())
+        .unwrap_or(&[])
+}
+
+/// Specified widths of the table's `<col>` elements, one entry per column they
+/// cover (`span`). A column group without `<col>` children covers `span`
+/// columns with its own width.
+pub fn column_element_widths<T: TableTree>(tree: &T, groups: &[ColGroup<T::NodeId>]) -> Vec<CssLength> {
+    let mut widths = Vec::new();
+    for group in groups {
+        if group.columns.is_empty() {
+            let span = tree.attr_usize(group.node, "span").unwrap_or(1).max(1);
+            widths.extend(std::iter::repeat_n(tree.css_length(group.node, CssProp::Width), span));
+        }
+        for &col in &group.columns {
+            let span = tree.attr_usize(col, "span").unwrap_or(1).max(1);
+            widths.extend(std::iter::repeat_n(tree.css_length(col, CssProp::Width), span));
+        }
+    }
+    widths
+}
+
 /// Compute column widths for a table with `n_cols` columns.
 ///
 /// Algorithm:
 /// 1. The available space is `table_width` minus the horizontal border-spacing
 ///    gutters (one between each pair of columns plus the outer two).
-/// 2. Scan the first non-empty row across all provided grids (header first,
-///    then body, then footer).  For each single-column cell in that row:
+/// 2. Scan `first_row` (see [`sizing_row`]).  For each single-column cell in that row:
 ///    - If it has an explicit CSS `width` in px or %, assign that to its column.
 ///    - Record its pre-pass natural width (from `cell_content_width`) for use
 ///      in step 3.
 /// 3. Remaining space is distributed to auto columns proportionally to their
 ///    natural content width. Falls back to equal distribution if no content
 ///    width information is available.
-pub fn compute_column_widths<T: TableTree>(
-    tree: &T,
+///
+/// With `table-layout: fixed` content is never consulted: widths come from the
+/// `<col>` elements (`columns`), then from the first row's cells (a spanning
+/// cell's width is split evenly over its columns), and the remaining space is
+/// divided equally among the other columns (CSS 2.1 §17.5.2.1).
+///
+/// Cell widths and natural widths are read from `cache`, which must have been
+/// refreshed for the table's cells.
+pub fn compute_column_widths<N: Copy + Eq + Hash>(
+    sizing: TableSizing,
     n_cols: usize,
     table_width: f32,
     border_spacing_x: f32,
-    grids: &[&SectionGrid<T::NodeId>],
+    columns: &[CssLength],
+    first_row: &[PlacedCell<N>],
+    cache: &TableLayoutCache<N>,
 ) -> Vec<f32> {
     if n_cols == 0 {
         return Vec::new();
@@ -30,34 +71,30 @@ pub fn compute_column_widths<T: TableTree>(
     let spacing_total = (n_cols as f32 + 1.0) * border_spacing_x;
     let available = (table_width - spacing_total).max(0.0);
 
+    if sizing == TableSizing::Fixed {
+        return fixed_column_widths(n_cols, table_width, available, columns, first_row, cache);
+    }
+
     let mut explicit: Vec<Option<f32>> = vec![None; n_cols];
     let mut natural: Vec<f32> = vec![0.0; n_cols];
 
-    // Scan the first non-empty row for explicit widths and natural content widths.
-    'outer: for grid in grids {
-        for row_idx in 0..grid.n_rows {
-            let mut found_any = false;
-            for cell in grid.cells_in_row(row_idx) {
-                found_any = true;
-                if cell.colspan == 1 {
-                    let cw = tree.cell_content_width(cell.node);
-                    if explicit[cell.col].is_none() {
-                        // A specified width cannot shrink a cell below its content's min-width
-                        // (CSS: used width = max(specified, min-content)). Without this, e.g. a
-                        // `width:18px` cell holding a 20px image clips it and eats the padding.
-                        match tree.css_length(cell.node, CssProp::Width) {
-                            CssLength::Px(px) => explicit[cell.col] = Some(px.max(cw)),
-                            CssLength::Percent(p) => explicit[cell.col] = Some((p / 100.0 * table_width).max(cw)),
-                            _ => {}
-                        }
-                    }
-                    if cw > natural[cell.col] {
-                        natural[cell.col] = cw;
-                    }
+    // Explicit widths and natural content widths of the first non-empty row.
+    for cell in first_row {
+        if cell.colspan == 1 {
+            let metrics = cache.metrics(cell.node);
+            let cw = metrics.content_width.unwrap_or(0.0);
+            if explicit[cell.col].is_none() {
+                // A specified width cannot shrink a cell below its content's min-width
+                // (CSS: used width = max(specified, min-content)). Without this, e.g. a
+                // `width:18px` cell holding a 20px image clips it and eats the padding.
+                match metrics.width {
+                    CssLength::Px(px) => explicit[cell.col] = Some(px.max(cw)),
+                    CssLength::Percent(p) => explicit[cell.col] = Some((p / 100.0 * table_width).max(cw)),
+                    _ => {}
                 }
             }
-            if found_any {
-                break 'outer;
+            if cw > natural[cell.col] {
+                natural[cell.col] = cw;
             }
         }
     }
@@ -118,3 +155,39 @@ pub fn compute_column_widths<T: TableTree>(
 
     explicit.iter().map(|w| w.unwrap_or(0.0)).collect()
 }
+
+fn fixed_column_widths<N: Copy + Eq + Hash>(
+    n_cols: usize,
+    table_width: f32,
+    available: f32,
+    columns: &[CssLength],
+    first_row: &[PlacedCell<N>],
+    cache: &TableLayoutCache<N>,
+) -> Vec<f32> {
+    let resolve = |length: CssLength| match length {
+        CssLength::Px(px) => Some(px),
+        CssLength::Percent(p) => Some(p / 100.0 * table_width),
+        _ => None,
+    };
+
+    let mut widths: Vec<Option<f32>> = (0..n_cols)
+        .map(|col| columns.get(col).copied().and_then(resolve))
+        .collect();
+
+    for cell in first_row {
+        let Some(width) = resolve(cache.metrics(cell.node).width) else {
+            continue;
+        };
+        let span = cell.colspan.min(n_cols.saturating_sub(cell.col));
+        let share = width / span.max(1) as f32;
+        for slot in widths.iter_mut().skip(cell.col).take(span) {
+            slot.get_or_insert(share);
+        }
+    }
+
+    let fixed_total: f32 = widths.iter().flatten().sum();
+    let auto_count = widths.iter().filter(|w| w.is_none()).count();
+    let equal = (available - fixed_total).max(0.0) / auto_count.max(1) as f32;
+
+    widths.iter().map(|w| w.unwrap_or(equal)).collect()
+}
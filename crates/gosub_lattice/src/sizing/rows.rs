@@ -1,4 +1,5 @@
 use crate::grid::SectionGrid;
+use crate::measure::TableLayoutCache;
 use crate::types::{BoxEdges, CssLength, CssProp};
 use crate::TableTree;
 
@@ -7,13 +8,23 @@ use crate::TableTree;
 /// For each non-spanning cell we:
 /// 1. Call [`TableTree::layout_cell`] to let the implementor run normal layout
 ///    (block/flex/inline) inside the cell and get the actual content height.
+///    The cache answers instead when the cell is unchanged and was last laid
+///    out at the same width.
 /// 2. Also read any explicit CSS `height` on the cell.
 /// 3. Take the maximum of the two, add the cell's own border + padding, and
 ///    use that as the candidate height for the row.
 ///
 /// Cells with `rowspan > 1` are skipped here; their height distribution across
 /// multiple rows is a Phase 2 concern.
-pub fn compute_row_heights<T: TableTree>(tree: &mut T, grid: &SectionGrid<T::NodeId>, col_widths: &[f32]) -> Vec<f32> {
+///
+/// Border, padding and `height` come from `cache`, which must have been
+/// refreshed for the section's cells.
+pub fn compute_row_heights<T: TableTree>(
+    tree: &mut T,
+    grid: &SectionGrid<T::NodeId>,
+    col_widths: &[f32],
+    cache: &mut TableLayoutCache<T::NodeId>,
+) -> Vec<f32> {
     let mut heights = vec![0.0_f32; grid.n_rows];
 
     for cell in grid.cells() {
@@ -21,8 +32,8 @@ pub fn compute_row_heights<T: TableTree>(tree: &mut T, grid: &SectionGrid<T::Nod
             continue;
         }
 
-        let border = read_border(tree, cell.node);
-        let padding = read_padding(tree, cell.node);
+        let metrics = *cache.metrics(cell.node);
+        let (border, padding) = (metrics.border, metrics.padding);
 
         // Inner width available to the cell's children.
         let cell_col_w: f32 = col_widths
@@ -33,10 +44,10 @@ pub fn compute_row_heights<T: TableTree>(tree: &mut T, grid: &SectionGrid<T::Nod
         let inner_w = (cell_col_w - border.horizontal() - padding.horizontal()).max(0.0);
 
         // Ask the implementor to lay out the cell's children and report their height.
-        let content_h = tree.layout_cell(cell.node, inner_w);
+        let content_h = cache.content_height(tree, cell.node, inner_w);
 
         // Explicit CSS `height` is a minimum - content can be taller.
-        let explicit_h = match tree.css_length(cell.node, CssProp::Height) {
+        let explicit_h = match metrics.height {
             CssLength::Px(px) => px,
             CssLength::Zero => 0.0,
             _ => 0.0,
@@ -51,7 +62,7 @@ pub fn compute_row_heights<T: TableTree>(tree: &mut T, grid: &SectionGrid<T::Nod
     heights
 }
 
-// Helpers shared with compute.rs
+// Helpers shared with measure.rs
 
 pub(crate) fn read_border<T: TableTree>(tree: &T, node: T::NodeId) -> BoxEdges {
     BoxEdges {
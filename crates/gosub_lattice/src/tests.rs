@@ -646,4 +646,152 @@ mod layout_tests {
         let host_layout = tree.outer.layout(host_cell).expect("host cell");
         assert_approx!(host_layout.size.height, 40.0, "host cell height");
     }
+
+    // Fixed layout: widths come from <col> elements and the first row only;
+    // content widths are never read and later rows cannot widen a column.
+    #[test]
+    fn fixed_layout_sizes_columns_from_first_row() {
+        let (mut tree, root) = MockTable::new(200.0)
+            .spacing(0.0, 0.0)
+            .fixed_layout()
+            .body_row(vec![
+                cell("A").width(40.0).content_width(120.0),
+                cell("B").content_width(300.0),
+                cell("C"),
+            ])
+            .body_row(vec![cell("D").width(150.0), cell("E"), cell("F")])
+            .into_tree();
+
+        compute_table_layout(&mut tree, root, 200.0, None).expect("layout must succeed");
+
+        let cells = tree.nodes_with_role(TableRole::Cell);
+        let widths: Vec<f32> = cells[..3]
+            .iter()
+            .map(|&c| tree.layout(c).expect("cell layout").size.width)
+            .collect();
+        assert_approx!(widths[0], 40.0, "specified width, not clamped to content");
+        assert_approx!(widths[1], 80.0, "remaining 160px split equally");
+        assert_approx!(widths[2], 80.0, "remaining 160px split equally");
+        let d = tree.layout(cells[3]).expect("cell D");
+        assert_approx!(d.size.width, 40.0, "second-row width is ignored");
+    }
+
+    #[test]
+    fn fixed_layout_prefers_column_elements() {
+        let (mut tree, root) = MockTable::new(100.0)
+            .spacing(0.0, 0.0)
+            .fixed_layout()
+            .column(Some(30.0))
+            .column(None)
+            .body_row(vec![cell("A").width(60.0), cell("B").width(50.0)])
+            .into_tree();
+
+        compute_table_layout(&mut tree, root, 100.0, None).expect("layout must succeed");
+
+        let cells = tree.nodes_with_role(TableRole::Cell);
+        let a = tree.layout(cells[0]).expect("cell A");
+        let b = tree.layout(cells[1]).expect("cell B");
+        assert_approx!(a.size.width, 30.0, "<col> width wins over the cell's");
+        assert_approx!(b.size.width, 50.0, "cell width where the <col> is auto");
+        assert_approx!(b.position.x, 30.0, "B x");
+    }
+
+    // A cached relayout of an unchanged table reads no cell styles; after a
+    // content change only that cell is measured and laid out again.
+    #[test]
+    fn cache_remeasures_only_changed_cells() {
+        use crate::measure::TableLayoutCache;
+        use crate::{compute_table_layout_cached, compute_table_layout_parallel};
+
+        let build = || {
+            let mut table = MockTable::new(300.0).spacing(2.0, 2.0);
+            for row in 0..50 {
+                table = table.body_row(vec![
+                    cell(format!("n{row}")).width(40.0).content_height(10.0),
+                    cell(format!("v{row}")).content_width(80.0).content_height(12.0),
+                ]);
+            }
+            table.into_tree()
+        };
+
+        let (mut reference, ref_root) = build();
+        compute_table_layout(&mut reference, ref_root, 300.0, None).expect("reference layout");
+
+        let (mut tree, root) = build();
+        let mut cache = TableLayoutCache::new();
+        let size = compute_table_layout_cached(&mut tree, root, 300.0, None, &mut cache).expect("first layout");
+        assert_eq!(cache.len(), 100);
+        let (reads, layouts) = (tree.cell_reads(), tree.cell_layouts());
+        assert_eq!(layouts, 100);
+
+        let again = compute_table_layout_cached(&mut tree, root, 300.0, None, &mut cache).expect("second layout");
+        assert_eq!(again, size);
+        assert_eq!(tree.cell_reads(), reads, "unchanged cells are not re-read");
+        assert_eq!(tree.cell_layouts(), layouts, "unchanged cells are not re-laid out");
+
+        // Same layout as without a cache.
+        let cells = tree.nodes_with_role(TableRole::Cell);
+        let ref_cells = reference.nodes_with_role(TableRole::Cell);
+        for (&c, &r) in cells.iter().zip(&ref_cells) {
+            let (got, want) = (tree.layout(c).expect("cell"), reference.layout(r).expect("ref cell"));
+            assert_approx!(got.position.x, want.position.x, "cell x");
+            assert_approx!(got.size.width, want.size.width, "cell width");
+            assert_approx!(got.size.height, want.size.height, "cell height");
+        }
+
+        // A content change re-measures and re-lays out that cell only.
+        tree.set_content(cells[21], 80.0, 30.0);
+        let (reads, layouts) = (tree.cell_reads(), tree.cell_layouts());
+        let (_, h) = compute_table_layout_parallel(&mut tree, root, 300.0, None, &mut cache).expect("relayout");
+        assert_eq!(tree.cell_layouts(), layouts + 1);
+        assert!(tree.cell_reads() > reads && tree.cell_reads() <= reads + 12);
+        assert_approx!(h, size.1 + 18.0, "row 10 grew from 12 to 30");
+        let row = tree.layout(cells[20]).expect("row 10 cell");
+        assert_approx!(row.size.height, 32.0, "30 content + 2 padding");
+
+        // A wider viewport re-lays out only the auto column, whose width changed.
+        let layouts = tree.cell_layouts();
+        compute_table_layout_cached(&mut tree, root, 400.0, None, &mut cache).expect("resize");
+        assert_eq!(tree.cell_layouts(), layouts + 50);
+    }
+
+    #[test]
+    fn parallel_measurement_matches_serial() {
+        use crate::compute_table_layout_parallel;
+        use crate::measure::TableLayoutCache;
+
+        let build = || {
+            let mut table = MockTable::new(800.0).spacing(1.0, 1.0);
+            table = table.header_row(
+                (0..4)
+                    .map(|c| cell(format!("h{c}")).content_width(60.0 + c as f32))
+                    .collect(),
+            );
+            for row in 0..600 {
+                table = table.body_row(
+                    (0..4)
+                        .map(|c| cell(format!("{row}:{c}")).content_height((row % 7 + c) as f32))
+                        .collect(),
+                );
+            }
+            table.into_tree()
+        };
+
+        let (mut serial, root) = build();
+        let serial_size = compute_table_layout(&mut serial, root, 800.0, None).expect("serial layout");
+        let (mut parallel, root) = build();
+        let mut cache = TableLayoutCache::new();
+        let parallel_size =
+            compute_table_layout_parallel(&mut parallel, root, 800.0, None, &mut cache).expect("parallel layout");
+
+        assert_eq!(parallel_size, serial_size);
+        for id in serial.nodes_with_role(TableRole::Cell) {
+            let (s, p) = (
+                serial.layout(id).expect("serial"),
+                parallel.layout(id).expect("parallel"),
+            );
+            assert_eq!((s.position.x, s.position.y), (p.position.x, p.position.y));
+            assert_eq!((s.size.width, s.size.height), (p.size.width, p.size.height));
+        }
+    }
 }
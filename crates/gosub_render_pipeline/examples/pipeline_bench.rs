@@ -30,6 +30,7 @@ use gosub_render_pipeline::common::geo::{Dimension, Rect};
 use gosub_render_pipeline::layering::layer::LayerList;
 use gosub_render_pipeline::layouter::taffy::TaffyLayouter;
 use gosub_render_pipeline::layouter::CanLayout;
+use gosub_render_pipeline::painter::display_list::DisplayList;
 use gosub_render_pipeline::painter::Painter;
 use gosub_render_pipeline::rendertree_builder::RenderTree;
 use gosub_render_pipeline::tiler::{TileList, TileState};
@@ -173,13 +174,14 @@ fn run_pipeline_once(html: &str, layouter: &mut TaffyLayouter) -> StageTimes {
         dpi_scale_factor: 1.0,
     };
     let painter = Painter::new(tile_list.layer_list.clone(), Some(layouter.font_system()));
+    let display_list = DisplayList::build(&painter, &paint_state, None, &Default::default());
     for &layer_id in &layer_ids {
         let tile_ids = tile_list.get_intersecting_tiles(layer_id, full_rect);
         for tile_id in tile_ids {
             if let Some(tile) = tile_list.get_tile_mut(tile_id) {
                 if tile.state == TileState::Dirty {
                     for tiled_element in &mut tile.elements {
-                        tiled_element.paint_commands = painter.paint(tiled_element, &paint_state);
+                        tiled_element.paint_commands = display_list.slice(tiled_element.id);
                     }
                 }
             }
@@ -237,6 +239,8 @@ fn main() {
         let mut paint_times = Vec::with_capacity(iterations);
 
         for _ in 0..iterations {
+            // Measure a full layout, not a relayout against the tree the previous run left.
+            layouter.reset_tree();
             let t = run_pipeline_once(&fixture.html, &mut layouter);
             rt_times.push(t.render_tree);
             layout_times.push(t.layout);
@@ -3,8 +3,10 @@ pub mod document;
 pub mod font;
 pub mod geo;
 pub mod media;
+pub mod shape_cache;
 pub mod texture;
 pub mod texture_store;
+pub mod tile_cache;
 
 mod hash;
 
@@ -4,7 +4,7 @@ use crate::tiler::TileList;
 use parking_lot::RwLock;
 use std::fmt::Debug;
 
-#[derive(Debug)]
+#[derive(Debug, Clone, Copy, PartialEq)]
 pub enum WireframeState {
     None,
     Only,
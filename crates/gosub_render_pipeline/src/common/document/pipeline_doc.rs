@@ -5,13 +5,16 @@ use crate::common::document::style::{
 use crate::painter::commands::color::Color;
 use crate::painter::commands::gradient::{ColorStop, Gradient, LinearGradient, Tiling};
 use cow_utils::CowUtils;
-use gosub_interface::config::HasDocument;
+use gosub_interface::config::{HasCssSystem, HasDocument};
 use gosub_interface::css3::{CssProperty, CssPropertyMap, CssSystem, CssValue};
 use gosub_interface::document::Document as _;
 use gosub_interface::node::NodeType as GosubNodeType;
+use gosub_shared::atom::Atom;
+use gosub_shared::counter_add;
 use gosub_shared::node::NodeId;
 use parking_lot::Mutex;
-use std::collections::HashMap;
+use rayon::prelude::*;
+use std::collections::{HashMap, HashSet};
 use std::sync::Arc;
 
 // ── Bridge: CssProperty → Value ──────────────────────────────────────────────
@@ -638,7 +641,7 @@ pub enum BgSize {
 /// Resolved `background-repeat`/`-size`/`-position` for an element's first background layer. Read
 /// from the `background` shorthand as well as the longhands, since pages write `background: url(x)
 /// repeat`. `cover`/`contain` need the box size, so final tile geometry is computed at paint time.
-#[derive(Debug, Clone, Copy)]
+#[derive(Debug, Clone, Copy, PartialEq)]
 pub struct BgImageLayout {
     /// Whether the tile repeats on the x / y axis (`background-repeat`; default repeat both).
     pub repeat: (bool, bool),
@@ -667,7 +670,7 @@ pub trait PipelineDocument: Send + Sync {
     fn root(&self) -> Option<NodeId>;
     fn children(&self, id: NodeId) -> Vec<NodeId>;
     fn node_kind(&self, id: NodeId) -> PipelineNodeKind;
-    fn tag_name(&self, id: NodeId) -> Option<String>;
+    fn tag_name(&self, id: NodeId) -> Option<Atom>;
     fn is_display_none(&self, id: NodeId) -> bool;
     fn parent(&self, id: NodeId) -> Option<NodeId>;
     fn html_node_id(&self) -> Option<NodeId>;
@@ -794,6 +797,11 @@ fn decode_pseudo(id: NodeId) -> (NodeId, u64) {
     (NodeId::from(v >> 2), v & 0b11)
 }
 
+/// The element a synthetic pseudo-element id hangs off, or `None` for real DOM ids.
+pub fn pseudo_owner(id: NodeId) -> Option<NodeId> {
+    is_pseudo_id(u64::from(id)).then(|| decode_pseudo(id).0)
+}
+
 const fn role_is_after(role: u64) -> bool {
     matches!(role, ROLE_AFTER_ELEM | ROLE_AFTER_TEXT)
 }
@@ -883,6 +891,55 @@ fn resolve_content<S: CssSystem>(p: &S::Property) -> Option<String> {
 
 // ── GosubDocumentAdapter ──────────────────────────────────────────────────────
 
+/// Style resolution stops forking after this many nested splits; each fork is a stack frame, and
+/// by then there are far more tasks than cores.
+const MAX_SPLIT_DEPTH: usize = 12;
+
+/// Selector-matching state a style traversal carries down the tree.
+type AncestorFilterOf<C> = <<C as HasCssSystem>::CssSystem as CssSystem>::AncestorFilter;
+
+type PropertyMapOf<C> = <<C as HasCssSystem>::CssSystem as CssSystem>::PropertyMap;
+type MatchedRulesOf<C> = <<C as HasCssSystem>::CssSystem as CssSystem>::MatchedRules;
+type StyleWalkSeed<C> = WalkSeed<PropertyMapOf<C>, MatchedRulesOf<C>>;
+type StyleWalkOutput<C> = WalkOutput<PropertyMapOf<C>, MatchedRulesOf<C>>;
+
+/// The adapter's caches as the style walk found them, read-only while it runs.
+struct WalkSeed<M, K> {
+    styles: HashMap<NodeId, Arc<M>>,
+    inline: HashMap<NodeId, NodeStyle>,
+    shared: HashMap<K, Arc<M>>,
+}
+
+/// Styles resolved by one task of the style walk: `(node, cascaded map, inline style)` and the
+/// maps it cascaded, by matched rules, for style sharing within the task.
+struct WalkOutput<M, K> {
+    styles: Vec<(NodeId, Arc<M>, NodeStyle)>,
+    shared: HashMap<K, Arc<M>>,
+}
+
+impl<M, K> Default for WalkOutput<M, K> {
+    fn default() -> Self {
+        Self {
+            styles: Vec::new(),
+            shared: HashMap::new(),
+        }
+    }
+}
+
+impl<M, K: Eq + std::hash::Hash> WalkOutput<M, K> {
+    /// Combines the outputs of two tasks, moving the smaller into the larger.
+    fn merge(mut self, mut other: Self) -> Self {
+        if self.styles.len() < other.styles.len() {
+            std::mem::swap(&mut self, &mut other);
+        }
+        self.styles.append(&mut other.styles);
+        for (matched, map) in other.shared {
+            self.shared.entry(matched).or_insert(map);
+        }
+        self
+    }
+}
+
 /// Adapts any `gosub_interface::document::Document<C>` into a `PipelineDocument`.
 pub struct GosubDocumentAdapter<C>
 where
@@ -894,6 +951,13 @@ where
     style_cache: Mutex<HashMap<NodeId, Arc<<C::CssSystem as CssSystem>::PropertyMap>>>,
     /// Per-node inline-style cache (from the `style` attribute, highest specificity).
     inline_style_cache: Mutex<HashMap<NodeId, NodeStyle>>,
+    /// Style sharing: property maps keyed by the rules that matched. Nodes matching the same
+    /// rules (list items, table cells, ...) point at one map instead of each running the cascade.
+    /// Maps hold declared values only - inheritance is resolved by `get_style` and inline style
+    /// lives in `inline_style_cache` - so the parent and `style` attribute need not be in the key.
+    #[allow(clippy::type_complexity)]
+    shared_styles:
+        Mutex<HashMap<<C::CssSystem as CssSystem>::MatchedRules, Arc<<C::CssSystem as CssSystem>::PropertyMap>>>,
     /// Materialized `::before` / `::after` pseudo-boxes, keyed by `(owner, is_after)`.
     /// `None` means "no generated box". Populated lazily.
     #[allow(clippy::type_complexity)]
@@ -911,10 +975,69 @@ where
             doc,
             style_cache: Mutex::new(HashMap::new()),
             inline_style_cache: Mutex::new(HashMap::new()),
+            shared_styles: Mutex::new(HashMap::new()),
             pseudo_cache: Mutex::new(HashMap::new()),
         }
     }
 
+    /// Creates an adapter for `doc`, a mutated version of `prev`'s document, that starts from
+    /// `prev`'s resolved styles minus the subtrees rooted at `restyle_roots`. Only those subtrees
+    /// go through selector matching again. Restyling the document root starts from scratch,
+    /// including the style-sharing cache, since that is how stylesheet changes are reported.
+    pub fn with_styles_from(doc: Arc<C::Document>, prev: &Self, restyle_roots: &[NodeId]) -> Self {
+        let adapter = Self::new(doc);
+        if restyle_roots.contains(&adapter.doc.root()) {
+            return adapter;
+        }
+
+        let mut stale = HashSet::new();
+        let mut stack = restyle_roots.to_vec();
+        while let Some(id) = stack.pop() {
+            if stale.insert(id) {
+                stack.extend(adapter.doc.children(id));
+            }
+        }
+
+        // Entries of removed nodes are carried along but never read: node ids are not reused.
+        *adapter.style_cache.lock() = prev
+            .style_cache
+            .lock()
+            .iter()
+            .filter(|(id, _)| !stale.contains(*id))
+            .map(|(id, map)| (*id, Arc::clone(map)))
+            .collect();
+        *adapter.inline_style_cache.lock() = prev
+            .inline_style_cache
+            .lock()
+            .iter()
+            .filter(|(id, _)| !stale.contains(*id))
+            .map(|(id, style)| (*id, style.clone()))
+            .collect();
+        *adapter.pseudo_cache.lock() = prev
+            .pseudo_cache
+            .lock()
+            .iter()
+            .filter(|((owner, _), _)| !stale.contains(owner))
+            .map(|(key, pseudo)| (*key, pseudo.clone()))
+            .collect();
+        *adapter.shared_styles.lock() = prev.shared_styles.lock().clone();
+
+        adapter
+    }
+
+    /// Creates an adapter for `doc` holding `prev`'s resolved styles, which `prev` gives up. The
+    /// engine uses this to keep the styles of a render whose document it is about to edit in
+    /// place: they move to an adapter over a placeholder document for
+    /// [`Self::with_styles_from`] to start from, and nothing keeps the edited document alive.
+    pub fn with_styles_taken_from(doc: Arc<C::Document>, prev: &Self) -> Self {
+        let adapter = Self::new(doc);
+        *adapter.style_cache.lock() = std::mem::take(&mut *prev.style_cache.lock());
+        *adapter.inline_style_cache.lock() = std::mem::take(&mut *prev.inline_style_cache.lock());
+        *adapter.shared_styles.lock() = std::mem::take(&mut *prev.shared_styles.lock());
+        *adapter.pseudo_cache.lock() = std::mem::take(&mut *prev.pseudo_cache.lock());
+        adapter
+    }
+
     /// `None` if no rule generates one. Computed and cached on first access.
     fn pseudo_box(
         &self,
@@ -959,42 +1082,237 @@ where
         }))
     }
 
-    fn cached_styles(&self, id: NodeId) -> Arc<<C::CssSystem as CssSystem>::PropertyMap> {
+    /// The (possibly shared) property map of `id`, computed and cached on first access.
+    pub(crate) fn cached_styles(&self, id: NodeId) -> Arc<<C::CssSystem as CssSystem>::PropertyMap> {
         {
             if let Some(arc) = self.style_cache.lock().get(&id) {
                 return arc.clone();
             }
         }
-        let (prop_map, inline_ns) = self.compute_styles(id);
-        let arc = Arc::new(prop_map);
+        let (arc, inline_ns) = self.compute_styles(id);
         self.style_cache.lock().insert(id, arc.clone());
         self.inline_style_cache.lock().insert(id, inline_ns);
         arc
     }
 
-    fn compute_styles(&self, id: NodeId) -> (<C::CssSystem as CssSystem>::PropertyMap, NodeStyle) {
+    /// Resolves and caches the styles of every element up front, walking sibling subtrees in
+    /// parallel on rayon's work-stealing pool. Later `get_own_style` calls are then cache hits.
+    ///
+    /// The cascade of a node only reads the (immutable) document and stylesheets; inheritance is
+    /// resolved lazily by `get_style` against the parent's cached map, so subtrees are
+    /// independent. Each task collects its results in its own output, and the outputs are merged
+    /// into the caches once at the end, so workers never contend on a lock. `init` runs at the
+    /// start of every task so per-thread style state (such as the CSS viewport) matches the
+    /// calling thread.
+    pub fn resolve_styles_parallel(&self, init: &(dyn Fn() + Sync)) {
+        self.walk_styles(init, 0);
+    }
+
+    /// Resolves and caches the styles of every element up front on the calling thread, in one
+    /// walk that enters and leaves each element once instead of matching it against a filter
+    /// rebuilt from all its ancestors.
+    pub fn resolve_styles(&self) {
+        self.walk_styles(&|| {}, MAX_SPLIT_DEPTH);
+    }
+
+    /// Runs the style walk from the document root. Forks only while `split_depth` is below
+    /// [`MAX_SPLIT_DEPTH`].
+    fn walk_styles(&self, init: &(dyn Fn() + Sync), split_depth: usize) {
+        // The caches are read-only for the walk: take them out of their locks so workers can read
+        // them freely, and put them back (with the walk's results) when it is done.
+        let seed = WalkSeed {
+            styles: std::mem::take(&mut *self.style_cache.lock()),
+            inline: std::mem::take(&mut *self.inline_style_cache.lock()),
+            shared: std::mem::take(&mut *self.shared_styles.lock()),
+        };
+        let mut ancestors = AncestorFilterOf::<C>::default();
+        let out = self.resolve_subtree(self.doc.root(), &mut ancestors, &seed, init, split_depth);
+
+        // Anything styled lazily through the (emptied) caches meanwhile is kept as well.
+        {
+            let mut styles = self.style_cache.lock();
+            let meanwhile = std::mem::replace(&mut *styles, seed.styles);
+            styles.extend(meanwhile);
+            styles.extend(out.styles.iter().map(|(id, map, _)| (*id, Arc::clone(map))));
+        }
+        {
+            let mut inline = self.inline_style_cache.lock();
+            let meanwhile = std::mem::replace(&mut *inline, seed.inline);
+            inline.extend(meanwhile);
+            inline.extend(out.styles.into_iter().map(|(id, _, inline_ns)| (id, inline_ns)));
+        }
+        let mut shared = self.shared_styles.lock();
+        let meanwhile = std::mem::replace(&mut *shared, seed.shared);
+        for (matched, map) in meanwhile.into_iter().chain(out.shared) {
+            shared.entry(matched).or_insert(map);
+        }
+    }
+
+    /// Styles the subtree of `root` that `seed` has no styles for. `ancestors` has entered the
+    /// ancestors of `root` and is left as it was found.
+    fn resolve_subtree(
+        &self,
+        root: NodeId,
+        ancestors: &mut AncestorFilterOf<C>,
+        seed: &StyleWalkSeed<C>,
+        init: &(dyn Fn() + Sync),
+        split_depth: usize,
+    ) -> StyleWalkOutput<C> {
+        init();
+
+        let mut out = WalkOutput::default();
+
+        // Single-child chains (wrapper divs) are walked iteratively; only nodes with several
+        // children fork, so recursion depth is bounded by the number of splits, not DOM depth.
+        // `None` marks where the walk leaves the subtree of the node entered before it.
+        let mut stack = vec![Some(root)];
+        while let Some(next) = stack.pop() {
+            let Some(id) = next else {
+                C::CssSystem::leave_element(ancestors);
+                continue;
+            };
+            // Nothing below a `display: none` element renders, so the walk does not style it;
+            // anything that asks anyway is styled lazily.
+            if self.doc.node_type(id) == GosubNodeType::ElementNode
+                && self.resolve_element(id, ancestors, seed, &mut out)
+            {
+                continue;
+            }
+
+            let children = self.doc.children(id);
+            if children.is_empty() {
+                continue;
+            }
+            C::CssSystem::enter_element::<C>(ancestors, &*self.doc, id);
+            if children.len() > 1 && split_depth < MAX_SPLIT_DEPTH {
+                let parent_filter = &*ancestors;
+                let forked = children
+                    .par_iter()
+                    .map(|&child| self.resolve_subtree(child, &mut parent_filter.clone(), seed, init, split_depth + 1))
+                    .reduce(WalkOutput::default, WalkOutput::merge);
+                out = out.merge(forked);
+                C::CssSystem::leave_element(ancestors);
+            } else {
+                stack.push(None);
+                stack.extend(children.iter().rev().map(|&child| Some(child)));
+            }
+        }
+
+        out
+    }
+
+    /// Styles element `id` into `out`, unless `seed` already has its styles. Returns whether the
+    /// element is `display: none`.
+    fn resolve_element(
+        &self,
+        id: NodeId,
+        ancestors: &AncestorFilterOf<C>,
+        seed: &StyleWalkSeed<C>,
+        out: &mut StyleWalkOutput<C>,
+    ) -> bool {
+        if let Some(map) = seed.styles.get(&id) {
+            return self.hides_subtree(id, map, seed.inline.get(&id));
+        }
+
+        let sheets = self.doc.stylesheets();
+        let map = match C::CssSystem::match_rules_in::<C>(&*self.doc, id, sheets, ancestors) {
+            Some(matched) => match out.shared.get(&matched).or_else(|| seed.shared.get(&matched)) {
+                Some(shared) => {
+                    counter_add!("css.style_sharing.hit");
+                    Arc::clone(shared)
+                }
+                None => {
+                    counter_add!("css.style_sharing.miss");
+                    let map = Arc::new(self.cascade(id, &matched));
+                    out.shared.insert(matched, Arc::clone(&map));
+                    map
+                }
+            },
+            None => Arc::default(),
+        };
+        let inline_ns = self.inline_style(id);
+
+        let hidden = self.hides_subtree(id, &map, Some(&inline_ns));
+        out.styles.push((id, map, inline_ns));
+        hidden
+    }
+
+    /// Whether `id` is `display: none` by the resolved `map` and `inline` style, checked in the
+    /// same order as `get_own_style`.
+    fn hides_subtree(
+        &self,
+        id: NodeId,
+        map: &<C::CssSystem as CssSystem>::PropertyMap,
+        inline: Option<&NodeStyle>,
+    ) -> bool {
+        let prop = StyleProperty::Display;
+        let display = match inline.and_then(|inline| inline.get_own(&prop)) {
+            Some(v) => Some(v.clone()),
+            None => self.style_from_map(id, &prop, map).or_else(|| {
+                self.doc
+                    .attributes(id)
+                    .and_then(|attrs| crate::common::document::inline_style::html_presentation_attr(attrs, &prop))
+            }),
+        };
+        matches!(display, Some(Value::Display(Display::None)))
+    }
+
+    fn compute_styles(&self, id: NodeId) -> (Arc<<C::CssSystem as CssSystem>::PropertyMap>, NodeStyle) {
         // CSS selectors cannot target text nodes - only elements.
         if self.doc.node_type(id) == GosubNodeType::TextNode {
-            return (Default::default(), NodeStyle::new());
+            return (Arc::default(), NodeStyle::new());
         }
-        let sheets = self.doc.stylesheets();
-        let mut prop_map = C::CssSystem::properties_from_node::<C>(&*self.doc, id, sheets).unwrap_or_default();
+        let prop_map = match C::CssSystem::match_rules::<C>(&*self.doc, id, self.doc.stylesheets()) {
+            Some(matched) => self.shared_style_map(id, matched),
+            None => Arc::default(),
+        };
+
+        (prop_map, self.inline_style(id))
+    }
+
+    /// The inline `style` attribute of `id`. It has the highest specificity, so it is stored
+    /// separately from the cascaded map.
+    fn inline_style(&self, id: NodeId) -> NodeStyle {
+        match self.doc.attributes(id).and_then(|attrs| attrs.get("style")) {
+            Some(style_attr) => crate::common::document::inline_style::parse_inline_style_attr(style_attr),
+            None => NodeStyle::new(),
+        }
+    }
+
+    /// Runs the cascade for `id`'s `matched` rules and computes the values.
+    fn cascade(
+        &self,
+        id: NodeId,
+        matched: &<C::CssSystem as CssSystem>::MatchedRules,
+    ) -> <C::CssSystem as CssSystem>::PropertyMap {
+        let mut prop_map = C::CssSystem::properties_from_matched::<C>(&*self.doc, id, self.doc.stylesheets(), matched);
         for (_, prop) in prop_map.iter_mut() {
             prop.compute_value();
         }
+        prop_map
+    }
 
-        // Inline `style` attribute has highest specificity - store separately.
-        let inline_ns = if let Some(attrs) = self.doc.attributes(id) {
-            if let Some(style_attr) = attrs.get("style") {
-                crate::common::document::inline_style::parse_inline_style_attr(style_attr)
-            } else {
-                NodeStyle::new()
-            }
-        } else {
-            NodeStyle::new()
-        };
+    /// Returns the shared map for `matched`, running the cascade for `id` if no node with the
+    /// same matched rules has been styled yet.
+    fn shared_style_map(
+        &self,
+        id: NodeId,
+        matched: <C::CssSystem as CssSystem>::MatchedRules,
+    ) -> Arc<<C::CssSystem as CssSystem>::PropertyMap> {
+        if let Some(shared) = self.shared_styles.lock().get(&matched) {
+            counter_add!("css.style_sharing.hit");
+            return shared.clone();
+        }
+        counter_add!("css.style_sharing.miss");
+
+        let prop_map = self.cascade(id, &matched);
 
-        (prop_map, inline_ns)
+        // Another thread may have cascaded an equal match meanwhile; keep the first.
+        self.shared_styles
+            .lock()
+            .entry(matched)
+            .or_insert_with(|| Arc::new(prop_map))
+            .clone()
     }
 
     /// Own style for a pseudo-element id, read from its generated style map.
@@ -1178,12 +1496,12 @@ where
         }
     }
 
-    fn tag_name(&self, id: NodeId) -> Option<String> {
+    fn tag_name(&self, id: NodeId) -> Option<Atom> {
         // Pseudo-elements have no tag name.
         if is_pseudo_id(u64::from(id)) {
             return None;
         }
-        self.doc.tag_name(id).map(|s| s.to_string())
+        self.doc.tag_atom(id)
     }
 
     fn is_display_none(&self, id: NodeId) -> bool {
@@ -1378,6 +1696,7 @@ where
     fn clear_style_cache(&self) {
         self.style_cache.lock().clear();
         self.inline_style_cache.lock().clear();
+        self.shared_styles.lock().clear();
         self.pseudo_cache.lock().clear();
     }
 
@@ -1,4 +1,4 @@
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, PartialEq)]
 pub enum FontAlignment {
     /// Start of the line (left for LTR, right for RTL)
     Start,
@@ -8,7 +8,7 @@ pub enum FontAlignment {
     Justify,
 }
 
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, PartialEq)]
 pub struct FontInfo {
     pub family: String,
     /// Font size in px
@@ -1,6 +1,8 @@
 mod decoder;
 mod image;
+mod image_cache;
 mod svg;
+mod svg_cache;
 
 #[allow(clippy::module_inception)]
 mod media;
@@ -11,6 +13,7 @@ pub use decoder::{
     SvgDecoder,
 };
 
+pub use media::ImageSource;
 pub use media::Media;
 pub use media::MediaId;
 pub use media::MediaImage;
@@ -18,7 +21,15 @@ pub use media::MediaSvg;
 pub use media::MediaType;
 
 pub use image::Image;
-pub use svg::Svg;
+pub use image_cache::{DecodedImageCache, DecodedImageCacheStats, DecodedImageKey, DEFAULT_IMAGE_CACHE_BUDGET};
+pub use svg::{RenderedSvg, Svg};
+pub use svg_cache::{svg_raster_bucket, SvgRasterCache, SvgRasterCacheStats, SvgRasterKey, DEFAULT_SVG_RASTER_BUDGET};
 
+pub use media_store::BlockingMediaFetcher;
+pub use media_store::FetchedMedia;
+pub use media_store::MediaFetchCancelled;
+pub use media_store::MediaFetchDone;
+pub use media_store::MediaFetcher;
 pub use media_store::MediaRequest;
 pub use media_store::MediaStore;
+pub use media_store::DEFAULT_MAX_FETCHES_PER_ORIGIN;
@@ -0,0 +1,260 @@
+//! Process-wide cache of decoded raster images.
+//!
+//! Entries are keyed by the hash of the encoded bytes and the size they were decoded (or
+//! downscaled) to, so the same image shown by several tabs is decoded once, and each display size
+//! is produced once. The cache is bounded by a byte budget; over it, the least recently used
+//! entries go first. An evicted image stays alive for as long as a media store still displays it;
+//! anything else is decoded again from the source bytes the next time it is asked for.
+
+use crate::common::hash::Sha256Hash;
+use crate::common::media::Image;
+use parking_lot::Mutex;
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, OnceLock};
+
+/// Budget of [`DecodedImageCache::global`] until the engine configures one.
+pub const DEFAULT_IMAGE_CACHE_BUDGET: u64 = 512 << 20;
+
+/// Which decode of an image an entry holds.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct DecodedImageKey {
+    /// Hash of the encoded bytes.
+    pub content: Sha256Hash,
+    /// Pixel size of the decode; `None` for the image's natural size.
+    pub size: Option<(u32, u32)>,
+}
+
+/// Current size and event counts of a [`DecodedImageCache`]. `hits`, `misses` and `evictions`
+/// count since startup or the last [`DecodedImageCache::reset_stats`].
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct DecodedImageCacheStats {
+    pub bytes: u64,
+    pub images: u64,
+    pub limit: u64,
+    pub hits: u64,
+    pub misses: u64,
+    pub evictions: u64,
+}
+
+struct Entry {
+    image: Arc<Image>,
+    bytes: u64,
+    last_used: u64,
+}
+
+#[derive(Default)]
+struct Inner {
+    entries: HashMap<DecodedImageKey, Entry>,
+    bytes: u64,
+    /// Use counter; an entry's `last_used` is the value at its last insert or hit.
+    clock: u64,
+}
+
+/// See the module documentation. Safe to share between the media stores of every tab.
+pub struct DecodedImageCache {
+    inner: Mutex<Inner>,
+    limit: AtomicU64,
+    hits: AtomicU64,
+    misses: AtomicU64,
+    evictions: AtomicU64,
+}
+
+impl DecodedImageCache {
+    /// A cache holding at most `limit_bytes` of decoded pixels.
+    pub fn new(limit_bytes: u64) -> Self {
+        Self {
+            inner: Mutex::new(Inner::default()),
+            limit: AtomicU64::new(limit_bytes),
+            hits: AtomicU64::new(0),
+            misses: AtomicU64::new(0),
+            evictions: AtomicU64::new(0),
+        }
+    }
+
+    /// The cache every [`MediaStore`](crate::common::media::MediaStore) shares.
+    pub fn global() -> &'static DecodedImageCache {
+        static CACHE: OnceLock<DecodedImageCache> = OnceLock::new();
+        CACHE.get_or_init(|| DecodedImageCache::new(DEFAULT_IMAGE_CACHE_BUDGET))
+    }
+
+    /// Changes the byte budget, evicting right away if the cache is now over it.
+    pub fn set_limit(&self, limit_bytes: u64) {
+        self.limit.store(limit_bytes, Ordering::Relaxed);
+        self.evict(&mut self.inner.lock());
+    }
+
+    /// Looks up a decode, marking it as recently used.
+    pub fn get(&self, key: &DecodedImageKey) -> Option<Arc<Image>> {
+        let mut inner = self.inner.lock();
+        inner.clock += 1;
+        let clock = inner.clock;
+        match inner.entries.get_mut(key) {
+            Some(entry) => {
+                entry.last_used = clock;
+                self.hits.fetch_add(1, Ordering::Relaxed);
+                Some(Arc::clone(&entry.image))
+            }
+            None => {
+                self.misses.fetch_add(1, Ordering::Relaxed);
+                None
+            }
+        }
+    }
+
+    /// Caches `image` under `key`, evicting older entries if that takes the cache over budget.
+    pub fn insert(&self, key: DecodedImageKey, image: Arc<Image>) {
+        let bytes = image.as_raw().len() as u64;
+        let mut inner = self.inner.lock();
+        inner.clock += 1;
+        let entry = Entry {
+            image,
+            bytes,
+            last_used: inner.clock,
+        };
+        inner.bytes += bytes;
+        if let Some(old) = inner.entries.insert(key, entry) {
+            inner.bytes -= old.bytes;
+        }
+        self.evict(&mut inner);
+    }
+
+    /// Drops the entry under `key`, if any. Stores still showing the image keep their pixels.
+    pub fn remove(&self, key: &DecodedImageKey) {
+        let mut inner = self.inner.lock();
+        if let Some(old) = inner.entries.remove(key) {
+            inner.bytes -= old.bytes;
+        }
+    }
+
+    /// The cached decode under `key`, or the result of `decode` (cached) on a miss. `decode` runs
+    /// without the cache locked; two threads missing on the same key may both decode.
+    pub fn get_or_insert_with<E>(
+        &self,
+        key: DecodedImageKey,
+        decode: impl FnOnce() -> Result<Arc<Image>, E>,
+    ) -> Result<Arc<Image>, E> {
+        if let Some(image) = self.get(&key) {
+            return Ok(image);
+        }
+        let image = decode()?;
+        self.insert(key, Arc::clone(&image));
+        Ok(image)
+    }
+
+    pub fn stats(&self) -> DecodedImageCacheStats {
+        let inner = self.inner.lock();
+        DecodedImageCacheStats {
+            bytes: inner.bytes,
+            images: inner.entries.len() as u64,
+            limit: self.limit.load(Ordering::Relaxed),
+            hits: self.hits.load(Ordering::Relaxed),
+            misses: self.misses.load(Ordering::Relaxed),
+            evictions: self.evictions.load(Ordering::Relaxed),
+        }
+    }
+
+    /// Zeroes the event counters. The size totals are left alone.
+    pub fn reset_stats(&self) {
+        for counter in [&self.hits, &self.misses, &self.evictions] {
+            counter.store(0, Ordering::Relaxed);
+        }
+    }
+
+    /// Evicts least recently used entries until the cache is back within budget.
+    fn evict(&self, inner: &mut Inner) {
+        let limit = self.limit.load(Ordering::Relaxed);
+        if inner.bytes <= limit {
+            return;
+        }
+
+        let mut order: Vec<(u64, DecodedImageKey)> = inner.entries.iter().map(|(k, e)| (e.last_used, *k)).collect();
+        order.sort_unstable_by_key(|(last_used, _)| *last_used);
+
+        for (_, key) in order {
+            if inner.bytes <= limit {
+                break;
+            }
+            if let Some(entry) = inner.entries.remove(&key) {
+                inner.bytes -= entry.bytes;
+                self.evictions.fetch_add(1, Ordering::Relaxed);
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn image(side: u32) -> Arc<Image> {
+        Arc::new(Image::new_rgba8(side, side, vec![0; (side * side * 4) as usize]).unwrap())
+    }
+
+    fn key(n: u8, size: Option<(u32, u32)>) -> DecodedImageKey {
+        DecodedImageKey { content: [n; 32], size }
+    }
+
+    #[test]
+    fn evicts_least_recently_used_over_budget() {
+        // 10×10 RGBA = 400 bytes per image.
+        let cache = DecodedImageCache::new(1200);
+        for n in 0..3 {
+            cache.insert(key(n, None), image(10));
+        }
+        assert!(cache.get(&key(0, None)).is_some());
+        cache.insert(key(3, None), image(10));
+
+        let stats = cache.stats();
+        assert_eq!((stats.images, stats.bytes, stats.evictions), (3, 1200, 1));
+        assert!(cache.get(&key(0, None)).is_some());
+        assert!(cache.get(&key(1, None)).is_none());
+    }
+
+    #[test]
+    fn sizes_of_one_image_are_separate_entries() {
+        let cache = DecodedImageCache::new(u64::MAX);
+        cache.insert(key(0, None), image(10));
+        cache.insert(key(0, Some((5, 5))), image(5));
+        assert_eq!(cache.get(&key(0, Some((5, 5)))).map(|i| i.width()), Some(5));
+        assert_eq!(cache.get(&key(0, None)).map(|i| i.width()), Some(10));
+        assert!(cache.get(&key(0, Some((4, 4)))).is_none());
+    }
+
+    #[test]
+    fn decodes_only_on_a_miss() {
+        let cache = DecodedImageCache::new(u64::MAX);
+        let mut decodes = 0;
+        for _ in 0..3 {
+            let got = cache.get_or_insert_with(key(7, None), || {
+                decodes += 1;
+                Ok::<_, ()>(image(4))
+            });
+            assert_eq!(got.map(|i| i.width()), Ok(4));
+        }
+        assert_eq!(decodes, 1);
+        assert_eq!(cache.stats().hits, 2);
+    }
+
+    #[test]
+    fn removing_releases_the_bytes() {
+        let cache = DecodedImageCache::new(u64::MAX);
+        cache.insert(key(0, None), image(10));
+        cache.insert(key(0, Some((5, 5))), image(5));
+        cache.remove(&key(0, None));
+        cache.remove(&key(1, None));
+        let stats = cache.stats();
+        assert_eq!((stats.images, stats.bytes), (1, 100));
+        assert!(cache.get(&key(0, None)).is_none());
+    }
+
+    #[test]
+    fn lowering_the_limit_evicts() {
+        let cache = DecodedImageCache::new(u64::MAX);
+        cache.insert(key(0, None), image(10));
+        cache.insert(key(1, None), image(10));
+        cache.set_limit(400);
+        assert_eq!(cache.stats().images, 1);
+        assert!(cache.get(&key(1, None)).is_some());
+    }
+}
@@ -35,12 +35,64 @@ pub struct MediaSvg {
     pub svg: Svg,
 }
 
+/// Encoded bytes a raster image was decoded from, kept so it can be decoded again at another size.
+pub struct ImageSource {
+    /// Hash of `bytes`; the [`DecodedImageCache`](crate::common::media::DecodedImageCache) key.
+    pub content: Sha256Hash,
+    /// `Content-Type` hint the bytes arrived with.
+    pub mime: Option<String>,
+    pub bytes: bytes::Bytes,
+}
+
+impl std::fmt::Debug for ImageSource {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("ImageSource")
+            .field("mime", &self.mime)
+            .field("bytes", &self.bytes.len())
+            .finish()
+    }
+}
+
 #[allow(unused)]
 #[derive(Debug, Clone)]
 pub struct MediaImage {
     src: String,
     hash: Sha256Hash,
-    pub image: Image,
+    /// Decoded pixels. May be smaller than the natural size when the image is only displayed
+    /// smaller; rasterizers scale `image` to the box they draw into either way.
+    pub image: Arc<Image>,
+    /// Intrinsic size of the image in pixels, what layout sizes the element by.
+    natural: (u32, u32),
+    /// Every pixel is fully transparent.
+    transparent: bool,
+    source: Option<Arc<ImageSource>>,
+}
+
+impl MediaImage {
+    /// Intrinsic (width, height), independent of the size `image` is currently decoded at.
+    pub fn natural_size(&self) -> (u32, u32) {
+        self.natural
+    }
+
+    pub fn is_transparent(&self) -> bool {
+        self.transparent
+    }
+
+    /// The encoded bytes, when the image can be decoded again at another size.
+    pub fn source(&self) -> Option<&Arc<ImageSource>> {
+        self.source.as_ref()
+    }
+
+    /// The same image with its pixels replaced by `image`, a decode at another size.
+    pub fn with_pixels(&self, image: Arc<Image>) -> MediaImage {
+        MediaImage { image, ..self.clone() }
+    }
+}
+
+fn is_transparent(image: &Image) -> bool {
+    // `.all()` short-circuits on the first opaque pixel, so this is cheap for the common
+    // (visible) image and only scans fully when the image really is transparent.
+    image.width() > 0 && image.as_raw().chunks_exact(4).all(|px| px[3] == 0)
 }
 
 #[derive(Clone)]
@@ -59,10 +111,18 @@ impl Media {
     }
 
     pub fn image(src: &str, image: Image) -> Self {
+        Self::decoded_image(src, Arc::new(image), None)
+    }
+
+    /// A raster image at its natural size, optionally with the bytes it was decoded from.
+    pub fn decoded_image(src: &str, image: Arc<Image>, source: Option<Arc<ImageSource>>) -> Self {
         Media::Image(Arc::new(MediaImage {
             src: src.to_string(),
             hash: hash_from_string(src),
+            natural: (image.width(), image.height()),
+            transparent: is_transparent(&image),
             image,
+            source,
         }))
     }
 }
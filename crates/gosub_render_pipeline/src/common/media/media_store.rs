@@ -1,18 +1,34 @@
 use crate::common::hash::{hash_from_data, hash_from_string, Sha256Hash};
 use crate::common::media::{
-    DecodedMedia, Image, Media, MediaDecoderRegistry, MediaId, MediaImage, MediaSvg, MediaType, Svg,
+    svg_raster_bucket, DecodedImageCache, DecodedImageKey, DecodedMedia, Image, ImageSource, Media,
+    MediaDecoderRegistry, MediaId, MediaImage, MediaSvg, MediaType, RenderedSvg, Svg,
 };
+use crate::render::backend::PixelFormat;
+use crate::render::DEVICE_PIXEL_RATIO;
 use bytes::Bytes;
-use parking_lot::RwLock;
-use std::collections::{HashMap, HashSet};
-use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
-use std::sync::Arc;
+use parking_lot::{Mutex, RwLock};
+use std::collections::hash_map::Entry;
+use std::collections::{HashMap, HashSet, VecDeque};
+use std::sync::atomic::{AtomicBool, AtomicU64, AtomicUsize, Ordering};
+use std::sync::{Arc, OnceLock};
 use url::Url;
 
 const DEFAULT_SVG_ID: MediaId = MediaId::new(0);
 const DEFAULT_IMAGE_ID: MediaId = MediaId::new(1);
 const FIRST_FREE_IMAGE_ID: u64 = 100;
 
+/// Media fetches one store keeps in flight per origin until [`MediaStore::set_max_fetches_per_origin`]
+/// says otherwise. Matches the usual HTTP/1.1 connection limit per origin.
+pub const DEFAULT_MAX_FETCHES_PER_ORIGIN: usize = 6;
+
+/// Display sizes are rounded up to a multiple of 1/16th of the natural size, so an image whose box
+/// changes by a pixel or two keeps its decode.
+const DISPLAY_SCALE_STEPS: f32 = 16.0;
+
+/// Bytes of SVG background tiles (see [`MediaStore::svg_raster_tile`]) one store keeps resident.
+/// Over it the least recently used tiles are dropped, and rendered again if painted again.
+const SVG_TILE_BUDGET: u64 = 32 << 20;
+
 const DEFAULT_SVG_DATA: &[u8] = include_bytes!("../../../resources/not-found.svg");
 const DEFAULT_IMAGE_DATA: &[u8] = include_bytes!("../../../resources/default-image.png");
 
@@ -25,13 +41,154 @@ pub enum MediaRequest {
     Pending,
 }
 
+/// Raw response of a media fetch: the `Content-Type` header (a hint for the decoder registry) and
+/// the body.
+#[derive(Debug, Clone)]
+pub struct FetchedMedia {
+    pub content_type: Option<String>,
+    pub body: Bytes,
+}
+
+/// Error a [`MediaFetcher`] completes a fetch with when the load was cancelled, e.g. because the
+/// document that wanted it was navigated away from. Unlike other failures it is not cached as the
+/// placeholder, so the next document asking for the same URL fetches it again.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct MediaFetchCancelled;
+
+impl std::fmt::Display for MediaFetchCancelled {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.write_str("media fetch cancelled")
+    }
+}
+
+impl std::error::Error for MediaFetchCancelled {}
+
+/// Completion callback handed to a [`MediaFetcher`]. Called exactly once, from any thread.
+pub type MediaFetchDone = Box<dyn FnOnce(anyhow::Result<FetchedMedia>) + Send>;
+
+/// Transport for the store's background media loads. The engine plugs in its zone fetcher (with
+/// the tab's cookies and the zone's connection pool); without one the store falls back to
+/// [`BlockingMediaFetcher`].
+pub trait MediaFetcher: Send + Sync {
+    /// Start fetching `url` and return without blocking. `done` receives the response once it
+    /// has been read in full, or the error ([`MediaFetchCancelled`] if the load was cancelled).
+    fn fetch(&self, url: Url, done: MediaFetchDone);
+}
+
+/// Fallback transport: one short-lived thread per fetch running a blocking request. The store's
+/// per-origin limit bounds how many of these threads exist at once.
+pub struct BlockingMediaFetcher;
+
+impl MediaFetcher for BlockingMediaFetcher {
+    fn fetch(&self, url: Url, done: MediaFetchDone) {
+        // Shared with the thread so the completion is still reachable if spawning fails.
+        let job = Arc::new(Mutex::new(Some((url, done))));
+        let thread_job = Arc::clone(&job);
+        let spawned = std::thread::Builder::new().name("media-fetch".into()).spawn(move || {
+            if let Some((url, done)) = thread_job.lock().take() {
+                done(blocking_fetch(&url));
+            }
+        });
+        if let Err(e) = spawned {
+            if let Some((_, done)) = job.lock().take() {
+                done(Err(anyhow::anyhow!("failed to spawn media fetch thread: {e}")));
+            }
+        }
+    }
+}
+
+/// Blocking fetch returning the raw `Content-Type` header and body. Classification is left to the
+/// decoder registry, which treats the content type as a hint only.
+fn blocking_fetch(url: &Url) -> anyhow::Result<FetchedMedia> {
+    let response = gosub_sonar::net::simple::sync_fetch(url)?;
+
+    if !response.is_ok() {
+        anyhow::bail!("HTTP {} fetching resource", response.status);
+    }
+
+    Ok(FetchedMedia {
+        content_type: response.headers.get("content-type").cloned(),
+        body: Bytes::from(response.body),
+    })
+}
+
+/// Thread pool that decodes fetched media, shared by every store. Kept apart from rayon's global
+/// pool so a page full of images does not hold up style resolution and rasterization there.
+fn decode_pool() -> Option<&'static rayon::ThreadPool> {
+    static POOL: OnceLock<Option<rayon::ThreadPool>> = OnceLock::new();
+    POOL.get_or_init(|| {
+        let threads = std::thread::available_parallelism().map_or(2, |n| (n.get() / 2).max(1));
+        rayon::ThreadPoolBuilder::new()
+            .num_threads(threads)
+            .thread_name(|i| format!("media-decode-{i}"))
+            .build()
+            .map_err(|e| log::warn!("Failed to build the media decode pool, using the global pool: {e}"))
+            .ok()
+    })
+    .as_ref()
+}
+
+fn spawn_decode(job: impl FnOnce() + Send + 'static) {
+    match decode_pool() {
+        Some(pool) => pool.spawn(job),
+        None => rayon::spawn(job),
+    }
+}
+
+/// A network load waiting for a free slot of its origin.
+struct QueuedFetch {
+    hash: Sha256Hash,
+    generation: u64,
+    src: String,
+    url: Url,
+}
+
+/// Per-origin admission for network loads: at most `max_per_origin` fetches of one origin are
+/// handed to the fetcher at a time, the rest wait here in request order.
+#[derive(Default)]
+struct FetchQueue {
+    in_flight: HashMap<String, usize>,
+    waiting: HashMap<String, VecDeque<QueuedFetch>>,
+}
+
+/// Which SVG an SVG background tile shows, and at which bucketed size.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+struct SvgTileKey {
+    svg: MediaId,
+    width: u32,
+    height: u32,
+}
+
+/// A resident SVG background tile.
+struct SvgTile {
+    bytes: u64,
+    last_used: u64,
+}
+
+/// Book-keeping for [`MediaStore::svg_raster_tile`]. A tile keeps its media id for good, so a
+/// display list still referring to an evicted tile paints it again; only its pixels in `entries`
+/// come and go.
+#[derive(Default)]
+struct SvgTiles {
+    ids: HashMap<SvgTileKey, MediaId>,
+    keys: HashMap<MediaId, SvgTileKey>,
+    resident: HashMap<MediaId, SvgTile>,
+    bytes: u64,
+    /// Use counter; a tile's `last_used` is the value at its last render or use.
+    clock: u64,
+}
+
 /// Keeps all loaded media in memory so it can be referenced by MediaId.
 pub struct MediaStore {
     pub entries: RwLock<HashMap<MediaId, Arc<Media>>>,
     /// Keyed by hash(src)
     pub cache: RwLock<HashMap<Sha256Hash, MediaId>>,
-    /// Hashes of resources currently being fetched in the background (dedupes in-flight requests)
-    pending: RwLock<HashSet<Sha256Hash>>,
+    /// Hashes of resources currently being fetched in the background (dedupes in-flight requests),
+    /// with the load generation that started them
+    pending: RwLock<HashMap<Sha256Hash, u64>>,
+    /// Bumped by [`abandon_loads`](Self::abandon_loads); loads started before a bump no longer own
+    /// their `pending` entry
+    load_generation: AtomicU64,
     /// Set whenever a background fetch lands, so the engine knows a reflow is needed
     completed: AtomicBool,
     /// Next media ID (atomic to prevent allocation races)
@@ -41,6 +198,17 @@ pub struct MediaStore {
     /// Compiled-in placeholder returned when an image is missing or failed to load
     default_image: Arc<Media>,
     decoders: MediaDecoderRegistry,
+    /// Transport for network loads started by [`request_media`](Self::request_media)
+    fetcher: RwLock<Arc<dyn MediaFetcher>>,
+    /// Network loads admitted or waiting, per origin
+    fetch_queue: Mutex<FetchQueue>,
+    max_fetches_per_origin: AtomicUsize,
+    /// Largest device-pixel size each image was laid out at since the last
+    /// [`apply_display_sizes`](Self::apply_display_sizes)
+    display_sizes: Mutex<HashMap<MediaId, (u32, u32)>>,
+    /// Images with a redecode at another size in flight
+    resizing: Mutex<HashSet<MediaId>>,
+    svg_tiles: Mutex<SvgTiles>,
 }
 
 impl Default for MediaStore {
@@ -83,19 +251,39 @@ impl MediaStore {
         MediaStore {
             entries: RwLock::new(entries),
             cache: RwLock::new(HashMap::new()),
-            pending: RwLock::new(HashSet::new()),
+            pending: RwLock::new(HashMap::new()),
+            load_generation: AtomicU64::new(0),
             completed: AtomicBool::new(false),
             next_id: AtomicU64::new(FIRST_FREE_IMAGE_ID),
             default_svg,
             default_image,
             decoders,
+            fetcher: RwLock::new(Arc::new(BlockingMediaFetcher)),
+            fetch_queue: Mutex::new(FetchQueue::default()),
+            max_fetches_per_origin: AtomicUsize::new(DEFAULT_MAX_FETCHES_PER_ORIGIN),
+            display_sizes: Mutex::new(HashMap::new()),
+            resizing: Mutex::new(HashSet::new()),
+            svg_tiles: Mutex::new(SvgTiles::default()),
         }
     }
 
-    /// Non-blocking media load: cached hits return `Ready`, otherwise a background fetch (deduped
-    /// per src) starts and `Pending` is returned without blocking layout. On completion the
-    /// `completed` flag rises and the engine's [`take_completed`](Self::take_completed) poll
-    /// triggers a reflow. Takes `&Arc<Self>` so the fetch thread can share the store.
+    /// Route subsequent background loads through `fetcher`. Loads already in flight finish on the
+    /// transport that started them.
+    pub fn set_fetcher(&self, fetcher: Arc<dyn MediaFetcher>) {
+        *self.fetcher.write() = fetcher;
+    }
+
+    /// Limit how many background loads of one origin are in flight at once (at least one).
+    pub fn set_max_fetches_per_origin(&self, max: usize) {
+        self.max_fetches_per_origin.store(max.max(1), Ordering::Relaxed);
+    }
+
+    /// Non-blocking media load: cached hits return `Ready`, otherwise a background load (deduped
+    /// per src) starts and `Pending` is returned without blocking layout. Network loads go through
+    /// the store's [`MediaFetcher`], at most [`set_max_fetches_per_origin`](Self::set_max_fetches_per_origin)
+    /// per origin at a time, and decode on a dedicated pool. On completion the `completed` flag
+    /// rises and the engine's [`take_completed`](Self::take_completed) poll triggers a reflow.
+    /// Takes `&Arc<Self>` so the background work can share the store.
     pub fn request_media(self: &Arc<Self>, src: &str) -> MediaRequest {
         let h = hash_from_string(src);
 
@@ -104,26 +292,154 @@ impl MediaStore {
         }
 
         // Register as in-flight; if another request already owns this hash, just report Pending.
-        if !self.pending.write().insert(h) {
+        let generation = self.load_generation.load(Ordering::Acquire);
+        match self.pending.write().entry(h) {
+            Entry::Occupied(_) => return MediaRequest::Pending,
+            Entry::Vacant(slot) => slot.insert(generation),
+        };
+
+        // `data:` URIs carry their bytes inline, so they skip the network and go straight to decode.
+        if let Some(rest) = src.strip_prefix("data:") {
+            let fetched = decode_data_uri(rest).map(|(content_type, bytes)| FetchedMedia {
+                content_type,
+                body: Bytes::from(bytes),
+            });
+            self.decode_in_background(h, generation, src.to_string(), fetched);
             return MediaRequest::Pending;
         }
 
+        match Url::parse(src) {
+            Ok(url) => self.enqueue_fetch(QueuedFetch {
+                hash: h,
+                generation,
+                src: src.to_string(),
+                url,
+            }),
+            Err(e) => self.finish_load(h, generation, src, Err(anyhow::anyhow!("invalid media url: {e}"))),
+        }
+
+        MediaRequest::Pending
+    }
+
+    /// Hand `fetch` to the fetcher if its origin has a free slot, otherwise queue it.
+    fn enqueue_fetch(self: &Arc<Self>, fetch: QueuedFetch) {
+        let origin = fetch.url.origin().ascii_serialization();
+        let max = self.max_fetches_per_origin.load(Ordering::Relaxed);
+        {
+            let mut queue = self.fetch_queue.lock();
+            let in_flight = queue.in_flight.entry(origin.clone()).or_insert(0);
+            if *in_flight >= max {
+                queue.waiting.entry(origin).or_default().push_back(fetch);
+                return;
+            }
+            *in_flight += 1;
+        }
+        self.start_fetch(origin, fetch);
+    }
+
+    fn start_fetch(self: &Arc<Self>, origin: String, fetch: QueuedFetch) {
+        let fetcher = Arc::clone(&*self.fetcher.read());
         let store = Arc::clone(self);
-        let src_owned = src.to_string();
-        let spawned = std::thread::Builder::new().name("media-fetch".into()).spawn(move || {
-            // `load_media` handles caching, and caches the placeholder on failure so a dead URL
-            // is never re-fetched. We only need to clear the in-flight marker and signal completion.
-            let _ = store.load_media(&src_owned);
-            store.pending.write().remove(&h);
-            store.completed.store(true, Ordering::Relaxed);
+        let QueuedFetch {
+            hash,
+            generation,
+            src,
+            url,
+        } = fetch;
+        fetcher.fetch(
+            url,
+            Box::new(move |result| {
+                store.release_fetch_slot(origin);
+                store.decode_in_background(hash, generation, src, result);
+            }),
+        );
+    }
+
+    /// A fetch of `origin` finished: start the next waiting one in its slot, or free the slot.
+    fn release_fetch_slot(self: &Arc<Self>, origin: String) {
+        let next = {
+            let mut queue = self.fetch_queue.lock();
+            let next = queue.waiting.get_mut(&origin).and_then(VecDeque::pop_front);
+            if next.is_none() {
+                queue.waiting.remove(&origin);
+                if let Some(in_flight) = queue.in_flight.get_mut(&origin) {
+                    *in_flight = in_flight.saturating_sub(1);
+                    if *in_flight == 0 {
+                        queue.in_flight.remove(&origin);
+                    }
+                }
+            }
+            next
+        };
+        if let Some(fetch) = next {
+            self.start_fetch(origin, fetch);
+        }
+    }
+
+    fn decode_in_background(
+        self: &Arc<Self>,
+        h: Sha256Hash,
+        generation: u64,
+        src: String,
+        fetched: anyhow::Result<FetchedMedia>,
+    ) {
+        // Failures have nothing to decode.
+        let fetched = match fetched {
+            Ok(fetched) => fetched,
+            Err(e) => return self.finish_load(h, generation, &src, Err(e)),
+        };
+        let store = Arc::clone(self);
+        spawn_decode(move || {
+            let media = store.decode_media(&src, fetched.content_type.as_deref(), fetched.body);
+            store.finish_load(h, generation, &src, media);
         });
+    }
 
-        if spawned.is_err() {
-            // Couldn't spawn - drop the in-flight marker so a later attempt can retry.
-            self.pending.write().remove(&h);
+    /// Store the outcome of a background load and signal completion. Failures cache the
+    /// placeholder id, so a dead URL is never re-fetched in this session. Cancelled loads, and
+    /// failures of loads abandoned by [`abandon_loads`](Self::abandon_loads), cache nothing: the
+    /// URL may well load for the next document.
+    fn finish_load(&self, h: Sha256Hash, generation: u64, src: &str, media: anyhow::Result<Media>) {
+        let abandoned = generation != self.load_generation.load(Ordering::Acquire);
+        let media_id = match media {
+            Ok(media) => {
+                let media_id = self.allocate_media_id();
+                self.entries.write().insert(media_id, Arc::new(media));
+                Some(media_id)
+            }
+            Err(e) if abandoned || e.is::<MediaFetchCancelled>() => {
+                log::debug!("Dropped cancelled media load of '{}': {}", src, e);
+                None
+            }
+            Err(e) => {
+                log::warn!("Failed to load media from '{}': {}", src, e);
+                Some(DEFAULT_IMAGE_ID)
+            }
+        };
+        if let Some(media_id) = media_id {
+            self.cache.write().entry(h).or_insert(media_id);
+        }
+        {
+            // A newer load of the same src may own the entry by now; leave it to that one.
+            let mut pending = self.pending.write();
+            if pending.get(&h) == Some(&generation) {
+                pending.remove(&h);
+            }
+        }
+        if media_id.is_some() {
+            self.completed.store(true, Ordering::Relaxed);
         }
+    }
 
-        MediaRequest::Pending
+    /// Forgets every background load started so far, for a navigation that cancels them. Loads
+    /// still waiting for a fetch slot are dropped, and in-flight ones no longer count as pending,
+    /// so the next document's requests for the same URLs start fresh loads instead of waiting on
+    /// ones that will never deliver. Whatever the abandoned loads still bring in is cached only if
+    /// it succeeded.
+    pub fn abandon_loads(&self) {
+        self.load_generation.fetch_add(1, Ordering::AcqRel);
+        self.fetch_queue.lock().waiting.clear();
+        self.pending.write().clear();
     }
 
     /// Returns and clears the "background fetch completed" flag; `true` means the engine should
@@ -132,10 +448,29 @@ impl MediaStore {
         self.completed.swap(false, Ordering::Relaxed)
     }
 
-    /// Shared by the data, source and inline decode paths.
-    fn decode_media(&self, src: &str, mime: Option<&str>, data: &[u8]) -> anyhow::Result<Media> {
-        match self.decoders.decode(mime, data) {
-            Ok(DecodedMedia::Raster(img)) => Ok(Media::image(src, img)),
+    /// Shared by the data, source and inline decode paths. Raster images are decoded at their
+    /// natural size through the [`DecodedImageCache`], so bytes another store already decoded are
+    /// not decoded again, and keep `data` for redecodes at their display size.
+    fn decode_media(&self, src: &str, mime: Option<&str>, data: Bytes) -> anyhow::Result<Media> {
+        let content = hash_from_data(&data);
+        let natural = DecodedImageKey { content, size: None };
+        let source = || {
+            Some(Arc::new(ImageSource {
+                content,
+                mime: mime.map(str::to_string),
+                bytes: data.clone(),
+            }))
+        };
+
+        if let Some(image) = DecodedImageCache::global().get(&natural) {
+            return Ok(Media::decoded_image(src, image, source()));
+        }
+        match self.decoders.decode(mime, &data) {
+            Ok(DecodedMedia::Raster(img)) => {
+                let image = Arc::new(img);
+                DecodedImageCache::global().insert(natural, Arc::clone(&image));
+                Ok(Media::decoded_image(src, image, source()))
+            }
             Ok(DecodedMedia::Vector(tree)) => Ok(Media::svg(src, Svg::new(*tree))),
             Err(e) => Err(anyhow::anyhow!("Failed to decode media from '{}': {}", src, e)),
         }
@@ -190,7 +525,7 @@ impl MediaStore {
             MediaType::Svg => Some("image/svg+xml"),
             MediaType::Image => None,
         };
-        let media = self.decode_media("gosub://data", mime, data)?;
+        let media = self.decode_media("gosub://data", mime, Bytes::copy_from_slice(data))?;
 
         let media_id = self.allocate_media_id();
         self.entries.write().insert(media_id, Arc::new(media));
@@ -199,28 +534,80 @@ impl MediaStore {
         Ok(media_id)
     }
 
-    /// Rasterize an SVG background to a `w`×`h` raster tile and return its media id, so a tiled
-    /// `background-image: url(x.svg)` reuses the raster tiling path. Cached per (svg id, w, h) so
-    /// it renders once. Returns `None` if the source is not an SVG or the pixmap can't allocate.
+    /// Rasterize an SVG background to a raster tile for a `w`×`h` px box and return its media id,
+    /// so a tiled `background-image: url(x.svg)` reuses the raster tiling path. The tile is
+    /// rendered at [`svg_raster_bucket`] size through the shared
+    /// [`SvgRasterCache`](crate::common::media::SvgRasterCache), so nearby sizes share one tile,
+    /// and the store keeps at most [`SVG_TILE_BUDGET`] bytes of tiles resident. Returns `None` if
+    /// the source is not an SVG or the pixmap can't allocate.
     pub fn svg_raster_tile(&self, svg_media_id: MediaId, w: u32, h: u32) -> Option<MediaId> {
         if w == 0 || h == 0 {
             return None;
         }
-        let key = hash_from_string(&format!("svg-tile:{}:{}x{}", svg_media_id.as_u64(), w, h));
-        if let Some(id) = self.cache.read().get(&key) {
-            return Some(*id);
+        let key = SvgTileKey {
+            svg: svg_media_id,
+            width: svg_raster_bucket(w),
+            height: svg_raster_bucket(h),
+        };
+        let media_id = {
+            let mut tiles = self.svg_tiles.lock();
+            match tiles.ids.get(&key) {
+                Some(media_id) => *media_id,
+                None => {
+                    let media_id = self.allocate_media_id();
+                    tiles.ids.insert(key, media_id);
+                    tiles.keys.insert(media_id, key);
+                    media_id
+                }
+            }
+        };
+        self.svg_tile_media(media_id, key).map(|_| media_id)
+    }
+
+    /// The pixels of SVG tile `media_id`, rendered (again) if they are not resident. Evicts the
+    /// least recently used other tiles while the store is over [`SVG_TILE_BUDGET`].
+    fn svg_tile_media(&self, media_id: MediaId, key: SvgTileKey) -> Option<Arc<Media>> {
+        {
+            let mut tiles = self.svg_tiles.lock();
+            tiles.clock += 1;
+            let clock = tiles.clock;
+            if let Some(tile) = tiles.resident.get_mut(&media_id) {
+                tile.last_used = clock;
+                drop(tiles);
+                if let Some(media) = self.entries.read().get(&media_id) {
+                    return Some(Arc::clone(media));
+                }
+            }
         }
-        let media = self.get(svg_media_id, MediaType::Svg);
-        let Media::Svg(svg) = &*media else {
+
+        let svg = self.get(key.svg, MediaType::Svg);
+        let Media::Svg(svg) = &*svg else {
             return None;
         };
-        let image = render_svg_tree_to_image(&svg.svg.tree, w, h)?;
-        let media_id = self.allocate_media_id();
-        self.entries
-            .write()
-            .insert(media_id, Arc::new(Media::image("gosub://svg-tile", image)));
-        self.cache.write().insert(key, media_id);
-        Some(media_id)
+        let raster = svg.svg.raster(key.width, key.height, PixelFormat::Rgba8)?;
+        let media = Arc::new(Media::image("gosub://svg-tile", straight_alpha_image(&raster)?));
+        self.entries.write().insert(media_id, Arc::clone(&media));
+
+        let evicted = {
+            let mut tiles = self.svg_tiles.lock();
+            tiles.clock += 1;
+            let tile = SvgTile {
+                bytes: raster.data.len() as u64,
+                last_used: tiles.clock,
+            };
+            tiles.bytes += tile.bytes;
+            if let Some(old) = tiles.resident.insert(media_id, tile) {
+                tiles.bytes -= old.bytes;
+            }
+            evict_svg_tiles(&mut tiles, media_id)
+        };
+        if !evicted.is_empty() {
+            let mut entries = self.entries.write();
+            for media_id in evicted {
+                entries.remove(&media_id);
+            }
+        }
+        Some(media)
     }
 
     fn load_media_from_source(&self, src: &str) -> anyhow::Result<MediaId> {
@@ -228,10 +615,10 @@ impl MediaStore {
         // `data:` URIs carry the bytes inline - decode them directly instead of going to the network.
         let media = if let Some(rest) = src.strip_prefix("data:") {
             let (mime, bytes) = decode_data_uri(rest)?;
-            self.decode_media(src, mime.as_deref(), &bytes)?
+            self.decode_media(src, mime.as_deref(), Bytes::from(bytes))?
         } else {
-            let (content_type, raw_data) = self.fetch_resource(src)?;
-            self.decode_media(src, content_type.as_deref(), &raw_data)?
+            let fetched = blocking_fetch(&Url::parse(src)?)?;
+            self.decode_media(src, fetched.content_type.as_deref(), fetched.body)?
         };
 
         let media_id = self.allocate_media_id();
@@ -240,6 +627,137 @@ impl MediaStore {
         Ok(media_id)
     }
 
+    /// Records that image `media_id` is laid out in a `css_width`×`css_height` box. The next
+    /// [`apply_display_sizes`](Self::apply_display_sizes) decodes it at the largest size it was
+    /// shown at (in device pixels, never above its natural size) instead of keeping the natural
+    /// decode resident.
+    pub fn note_display_size(&self, media_id: MediaId, css_width: f32, css_height: f32) {
+        let media = self.get(media_id, MediaType::Image);
+        let Media::Image(image) = &*media else {
+            return;
+        };
+        if image.source().is_none() {
+            return;
+        }
+        let (nw, nh) = image.natural_size();
+        if nw == 0 || nh == 0 {
+            return;
+        }
+
+        let dpr = DEVICE_PIXEL_RATIO.load(Ordering::Relaxed).max(1) as f32;
+        let scale = (css_width * dpr / nw as f32).max(css_height * dpr / nh as f32);
+        if !scale.is_finite() || scale <= 0.0 {
+            return;
+        }
+        let scale = ((scale * DISPLAY_SCALE_STEPS).ceil() / DISPLAY_SCALE_STEPS).min(1.0);
+        let target = (
+            ((nw as f32 * scale).round() as u32).clamp(1, nw),
+            ((nh as f32 * scale).round() as u32).clamp(1, nh),
+        );
+
+        self.display_sizes
+            .lock()
+            .entry(media_id)
+            .and_modify(|size| *size = (size.0.max(target.0), size.1.max(target.1)))
+            .or_insert(target);
+    }
+
+    /// Redecodes, on the decode pool, every image noted since the last call whose display size
+    /// needs more pixels than it has, or less than half of them. Each size comes from the shared
+    /// [`DecodedImageCache`] when another store already produced it. Swapped pixels raise the
+    /// `completed` flag so the engine repaints; tiles showing the image miss the tile cache, as
+    /// their key covers the image's pixel size.
+    pub fn apply_display_sizes(self: &Arc<Self>) {
+        let sizes = std::mem::take(&mut *self.display_sizes.lock());
+        for (media_id, target) in sizes {
+            let media = self.get(media_id, MediaType::Image);
+            let Media::Image(image) = &*media else {
+                continue;
+            };
+            let Some(source) = image.source().cloned() else {
+                continue;
+            };
+
+            let (w, h) = (image.image.width(), image.image.height());
+            let grow = target.0 > w || target.1 > h;
+            let shrink = u64::from(target.0) * u64::from(target.1) * 2 <= u64::from(w) * u64::from(h);
+            if !(grow || shrink) || !self.resizing.lock().insert(media_id) {
+                continue;
+            }
+
+            let size = (target != image.natural_size()).then_some(target);
+            let store = Arc::clone(self);
+            spawn_decode(move || {
+                match store.decode_at(&source, size) {
+                    Ok(pixels) => store.replace_pixels(media_id, &source, pixels),
+                    Err(e) => log::warn!("Failed to decode media {:?} at {:?}: {}", media_id, size, e),
+                }
+                store.resizing.lock().remove(&media_id);
+                store.completed.store(true, Ordering::Relaxed);
+            });
+        }
+    }
+
+    /// `source` decoded at `size` (`None` for the natural size), from the shared cache or decoded
+    /// again from the encoded bytes. A decode at a display size takes the place of the natural
+    /// one in the cache: the natural pixels are only borrowed for the resize, and a later size
+    /// that needs more of them decodes `source` again.
+    fn decode_at(&self, source: &ImageSource, size: Option<(u32, u32)>) -> anyhow::Result<Arc<Image>> {
+        let cache = DecodedImageCache::global();
+        let natural = DecodedImageKey {
+            content: source.content,
+            size: None,
+        };
+        let decode = || match self.decoders.decode(source.mime.as_deref(), &source.bytes) {
+            Ok(DecodedMedia::Raster(img)) => Ok(Arc::new(img)),
+            Ok(DecodedMedia::Vector(_)) => Err(anyhow::anyhow!("image source decoded as an svg")),
+            Err(e) => Err(anyhow::anyhow!("failed to decode image source: {}", e)),
+        };
+        let Some((w, h)) = size else {
+            return cache.get_or_insert_with(natural, decode);
+        };
+
+        let sized = DecodedImageKey {
+            content: source.content,
+            size,
+        };
+        if let Some(image) = cache.get(&sized) {
+            return Ok(image);
+        }
+        let full = match cache.get(&natural) {
+            Some(full) => full,
+            None => decode()?,
+        };
+        let resized = Arc::new(resize_image(&full, w, h)?);
+        cache.insert(sized, Arc::clone(&resized));
+        cache.remove(&natural);
+        Ok(resized)
+    }
+
+    /// Swap the pixels of image `media_id`, unless the entry was replaced by other media meanwhile.
+    fn replace_pixels(&self, media_id: MediaId, source: &Arc<ImageSource>, pixels: Arc<Image>) {
+        let mut entries = self.entries.write();
+        let Some(entry) = entries.get_mut(&media_id) else {
+            return;
+        };
+        let Media::Image(image) = &**entry else {
+            return;
+        };
+        if !image.source().is_some_and(|s| Arc::ptr_eq(s, source)) {
+            return;
+        }
+        let updated = Arc::new(Media::Image(Arc::new(image.with_pixels(pixels))));
+        *entry = updated;
+    }
+
+    /// Pixel size image `media_id` is currently decoded at, or (0, 0) if it is not an image.
+    pub fn image_pixel_size(&self, media_id: MediaId) -> (u32, u32) {
+        match self.entries.read().get(&media_id).map(|m| &**m) {
+            Some(Media::Image(image)) => (image.image.width(), image.image.height()),
+            _ => (0, 0),
+        }
+    }
+
     /// Falls back to the default image if `media_id` is missing or is not an image.
     pub fn get_image(&self, media_id: MediaId) -> Arc<MediaImage> {
         let media = self.get(media_id, MediaType::Image);
@@ -285,12 +803,13 @@ impl MediaStore {
 
     /// Falls back to `media_type`'s default resource if `media_id` does not exist.
     pub fn get(&self, media_id: MediaId, media_type: MediaType) -> Arc<Media> {
-        let entries = self.entries.read();
-
-        match entries.get(&media_id) {
-            Some(media) => media.clone(),
-            None => self.default_media(media_type),
+        if let Some(media) = self.entries.read().get(&media_id) {
+            return Arc::clone(media);
         }
+        // An evicted SVG tile is still referenced by its id; render it again.
+        let tile = self.svg_tiles.lock().keys.get(&media_id).copied();
+        tile.and_then(|key| self.svg_tile_media(media_id, key))
+            .unwrap_or_else(|| self.default_media(media_type))
     }
 
     fn default_media(&self, media_type: MediaType) -> Arc<Media> {
@@ -299,22 +818,6 @@ impl MediaStore {
             MediaType::Image => Arc::clone(&self.default_image),
         }
     }
-
-    /// Blocking fetch returning the raw `Content-Type` header and body. Classification is left to
-    /// the decoder registry, which treats the content type as a hint only.
-    fn fetch_resource(&self, src: &str) -> anyhow::Result<(Option<String>, Bytes)> {
-        let url = Url::parse(src)?;
-        let response = gosub_sonar::net::simple::sync_fetch(&url)?;
-
-        if !response.is_ok() {
-            anyhow::bail!("HTTP {} fetching resource", response.status);
-        }
-
-        let content_type = response.headers.get("content-type").cloned();
-        let raw_bytes = Bytes::from(response.body);
-
-        Ok((content_type, raw_bytes))
-    }
 }
 
 /// Decodes a `data:` URI body (everything after `data:`) in its `[<mime>][;base64],<data>` form.
@@ -363,20 +866,52 @@ fn percent_decode(s: &str) -> Vec<u8> {
     out
 }
 
-/// Rasterize a `usvg` tree to a straight-alpha RGBA [`Image`] of `w`×`h` px (scaling the tree's
-/// intrinsic size to fit). Returns `None` if the pixmap can't be allocated.
-fn render_svg_tree_to_image(tree: &resvg::usvg::Tree, w: u32, h: u32) -> Option<Image> {
-    let size = tree.size();
-    let (iw, ih) = (size.width().max(1.0), size.height().max(1.0));
-    let (sx, sy) = (w as f32 / iw, h as f32 / ih);
+/// Scale `image` to `w`×`h` px.
+fn resize_image(pixels: &Image, w: u32, h: u32) -> anyhow::Result<Image> {
+    let view = image::ImageBuffer::<image::Rgba<u8>, &[u8]>::from_raw(pixels.width(), pixels.height(), pixels.as_raw())
+        .ok_or_else(|| anyhow::anyhow!("pixel buffer does not match its dimensions"))?;
+    Ok(Image::from(image::imageops::resize(
+        &view,
+        w,
+        h,
+        image::imageops::FilterType::Triangle,
+    )))
+}
 
-    let mut pixmap = resvg::tiny_skia::Pixmap::new(w, h)?;
-    resvg::render(tree, resvg::usvg::Transform::from_scale(sx, sy), &mut pixmap.as_mut());
+/// Drops the least recently used resident tiles other than `keep` until `tiles` is within
+/// [`SVG_TILE_BUDGET`], returning their ids.
+fn evict_svg_tiles(tiles: &mut SvgTiles, keep: MediaId) -> Vec<MediaId> {
+    if tiles.bytes <= SVG_TILE_BUDGET {
+        return Vec::new();
+    }
+    let mut order: Vec<(u64, MediaId)> = tiles
+        .resident
+        .iter()
+        .filter(|(media_id, _)| **media_id != keep)
+        .map(|(media_id, tile)| (tile.last_used, *media_id))
+        .collect();
+    order.sort_unstable_by_key(|(last_used, _)| *last_used);
 
-    // tiny_skia pixmaps are premultiplied RGBA; the store wants straight (unpremultiplied) alpha.
-    let mut rgba = Vec::with_capacity((w as usize) * (h as usize) * 4);
-    for px in pixmap.pixels() {
-        let c = px.demultiply();
+    let mut evicted = Vec::new();
+    for (_, media_id) in order {
+        if tiles.bytes <= SVG_TILE_BUDGET {
+            break;
+        }
+        if let Some(tile) = tiles.resident.remove(&media_id) {
+            tiles.bytes -= tile.bytes;
+            evicted.push(media_id);
+        }
+    }
+    evicted
+}
+
+/// A premultiplied RGBA SVG raster as a straight-alpha RGBA [`Image`], the form the store keeps
+/// raster media in.
+fn straight_alpha_image(raster: &RenderedSvg) -> Option<Image> {
+    let (w, h) = (raster.dimension.width as u32, raster.dimension.height as u32);
+    let mut rgba = Vec::with_capacity(raster.data.len());
+    for px in raster.data.chunks_exact(4) {
+        let c = resvg::tiny_skia::PremultipliedColorU8::from_rgba(px[0], px[1], px[2], px[3])?.demultiply();
         rgba.extend_from_slice(&[c.red(), c.green(), c.blue(), c.alpha()]);
     }
     Image::new_rgba8(w, h, rgba).ok()
@@ -440,4 +975,220 @@ mod tests {
         let size = svg.svg.tree.size();
         assert_eq!((size.width() as u32, size.height() as u32), (20, 10));
     }
+
+    /// Records fetches instead of performing them, so a test decides when each one lands.
+    #[derive(Default)]
+    struct ManualFetcher {
+        started: Mutex<Vec<(Url, MediaFetchDone)>>,
+    }
+
+    impl MediaFetcher for ManualFetcher {
+        fn fetch(&self, url: Url, done: MediaFetchDone) {
+            self.started.lock().push((url, done));
+        }
+    }
+
+    fn wait_for_completion(store: &MediaStore) {
+        let deadline = std::time::Instant::now() + std::time::Duration::from_secs(5);
+        while !store.take_completed() {
+            assert!(
+                std::time::Instant::now() < deadline,
+                "background decode never completed"
+            );
+            std::thread::sleep(std::time::Duration::from_millis(1));
+        }
+    }
+
+    /// Loads of one origin beyond the limit wait until an earlier one lands; other origins are
+    /// not held up. A landed fetch decodes in the background and turns `Pending` into `Ready`.
+    #[test]
+    fn background_loads_are_bounded_per_origin() {
+        let store = Arc::new(MediaStore::new());
+        let fetcher = Arc::new(ManualFetcher::default());
+        store.set_fetcher(fetcher.clone());
+        store.set_max_fetches_per_origin(2);
+
+        for i in 0..4 {
+            let src = format!("https://a.example/{i}.png");
+            assert_eq!(store.request_media(&src), MediaRequest::Pending);
+        }
+        assert_eq!(store.request_media("https://b.example/x.png"), MediaRequest::Pending);
+        // Repeats of an in-flight src are deduped, not fetched again.
+        assert_eq!(store.request_media("https://a.example/0.png"), MediaRequest::Pending);
+
+        let started: Vec<String> = fetcher.started.lock().iter().map(|(u, _)| u.to_string()).collect();
+        assert_eq!(
+            started,
+            [
+                "https://a.example/0.png",
+                "https://a.example/1.png",
+                "https://b.example/x.png"
+            ]
+        );
+
+        let (_, done) = fetcher.started.lock().remove(0);
+        done(Ok(FetchedMedia {
+            content_type: Some("image/png".into()),
+            body: Bytes::from(encode(ImageFormat::Png)),
+        }));
+        assert_eq!(
+            fetcher.started.lock().len(),
+            3,
+            "the freed slot starts the next queued load"
+        );
+        assert_eq!(fetcher.started.lock()[2].0.as_str(), "https://a.example/2.png");
+
+        wait_for_completion(&store);
+        let MediaRequest::Ready(media_id) = store.request_media("https://a.example/0.png") else {
+            panic!("landed load is not ready");
+        };
+        assert!(!store.is_placeholder(media_id));
+        assert_eq!(store.get_image(media_id).image.width(), 8);
+    }
+
+    fn encode_png(w: u32, h: u32, color: [u8; 4]) -> Vec<u8> {
+        let mut buf = Cursor::new(Vec::new());
+        DynamicImage::ImageRgba8(RgbaImage::from_pixel(w, h, Rgba(color)))
+            .write_to(&mut buf, ImageFormat::Png)
+            .expect("encode png");
+        buf.into_inner()
+    }
+
+    /// An image laid out smaller than its natural size is redecoded at the (quantized) display
+    /// size, while layout keeps seeing the natural size. The natural decode leaves the shared
+    /// cache once the smaller one is installed.
+    #[test]
+    fn redecodes_at_the_display_size() {
+        let bytes = encode_png(64, 32, [1, 2, 3, 255]);
+        let natural = DecodedImageKey {
+            content: hash_from_data(&bytes),
+            size: None,
+        };
+        let store = Arc::new(MediaStore::new());
+        let media_id = store.load_media_from_data(MediaType::Image, &bytes).expect("load png");
+        assert_eq!(store.image_pixel_size(media_id), (64, 32));
+
+        store.note_display_size(media_id, 15.0, 7.0);
+        store.note_display_size(media_id, 16.0, 8.0);
+        store.apply_display_sizes();
+        wait_for_completion(&store);
+
+        assert_eq!(store.image_pixel_size(media_id), (16, 8));
+        assert_eq!(store.get_image(media_id).natural_size(), (64, 32));
+        assert!(DecodedImageCache::global().get(&natural).is_none());
+
+        // Growing back past the current decode restores the natural pixels.
+        store.note_display_size(media_id, 64.0, 32.0);
+        store.apply_display_sizes();
+        wait_for_completion(&store);
+        assert_eq!(store.image_pixel_size(media_id), (64, 32));
+    }
+
+    /// Identical bytes loaded by two stores share one decode.
+    #[test]
+    fn stores_share_decoded_images() {
+        let bytes = encode_png(5, 3, [9, 8, 7, 255]);
+        let (a, b) = (MediaStore::new(), MediaStore::new());
+        let a_id = a.load_media_from_data(MediaType::Image, &bytes).expect("load png");
+        let b_id = b.load_media_from_data(MediaType::Image, &bytes).expect("load png");
+        assert!(Arc::ptr_eq(&a.get_image(a_id).image, &b.get_image(b_id).image));
+    }
+
+    /// A failed fetch resolves to the placeholder and is not fetched again.
+    #[test]
+    fn failed_background_load_caches_the_placeholder() {
+        let store = Arc::new(MediaStore::new());
+        let fetcher = Arc::new(ManualFetcher::default());
+        store.set_fetcher(fetcher.clone());
+
+        assert_eq!(store.request_media("https://a.example/gone.png"), MediaRequest::Pending);
+        let (_, done) = fetcher.started.lock().remove(0);
+        done(Err(anyhow::anyhow!("HTTP 404 fetching resource")));
+
+        wait_for_completion(&store);
+        let MediaRequest::Ready(media_id) = store.request_media("https://a.example/gone.png") else {
+            panic!("failed load is not resolved");
+        };
+        assert!(store.is_placeholder(media_id));
+        assert!(fetcher.started.lock().is_empty());
+    }
+
+    fn load_svg(store: &MediaStore) -> MediaId {
+        let markup = r#"<svg xmlns="http://www.w3.org/2000/svg" width="10" height="10"><rect width="10" height="10" fill="red"/></svg>"#;
+        store
+            .load_media_from_data(MediaType::Svg, markup.as_bytes())
+            .expect("load svg")
+    }
+
+    /// Nearby box sizes share one bucketed tile.
+    #[test]
+    fn svg_tiles_share_size_buckets() {
+        let store = MediaStore::new();
+        let svg = load_svg(&store);
+        let a = store.svg_raster_tile(svg, 300, 300).expect("tile");
+        let b = store.svg_raster_tile(svg, 310, 305).expect("tile");
+        assert_eq!(a, b);
+        assert_eq!(store.image_pixel_size(a), (320, 320));
+        assert_eq!(store.get_image(a).image.as_raw()[..4], [255, 0, 0, 255]);
+        assert_ne!(store.svg_raster_tile(svg, 400, 300), Some(a));
+    }
+
+    /// Resident tiles stay within the budget; an evicted tile keeps its id and renders again when
+    /// painted.
+    #[test]
+    fn svg_tiles_are_evicted_over_budget() {
+        let store = MediaStore::new();
+        let svg = load_svg(&store);
+        let tiles: Vec<MediaId> = (0..8)
+            .map(|i| store.svg_raster_tile(svg, 1024 + 128 * i, 1024).expect("tile"))
+            .collect();
+        assert!(store.svg_tiles.lock().bytes <= SVG_TILE_BUDGET);
+
+        assert_eq!(store.image_pixel_size(tiles[0]), (0, 0), "oldest tile is evicted");
+        assert_eq!(store.get_image(tiles[0]).image.width(), 1024);
+        assert!(!store.is_placeholder(tiles[0]));
+        assert_eq!(store.svg_raster_tile(svg, 1024, 1024), Some(tiles[0]));
+    }
+
+    /// A cancelled fetch is not cached as the placeholder: asking again fetches again.
+    #[test]
+    fn cancelled_background_load_is_not_cached() {
+        let store = Arc::new(MediaStore::new());
+        let fetcher = Arc::new(ManualFetcher::default());
+        store.set_fetcher(fetcher.clone());
+
+        assert_eq!(store.request_media("https://a.example/x.png"), MediaRequest::Pending);
+        let (_, done) = fetcher.started.lock().remove(0);
+        done(Err(MediaFetchCancelled.into()));
+
+        assert!(!store.take_completed(), "nothing new to lay out");
+        assert_eq!(store.request_media("https://a.example/x.png"), MediaRequest::Pending);
+        assert_eq!(fetcher.started.lock().len(), 1, "the load starts over");
+    }
+
+    /// Loads abandoned on navigation stop waiting for a slot and stop deduping the next document's
+    /// requests, and their late failures are not cached.
+    #[test]
+    fn abandoned_loads_release_their_waiters() {
+        let store = Arc::new(MediaStore::new());
+        let fetcher = Arc::new(ManualFetcher::default());
+        store.set_fetcher(fetcher.clone());
+        store.set_max_fetches_per_origin(1);
+
+        assert_eq!(store.request_media("https://a.example/0.png"), MediaRequest::Pending);
+        assert_eq!(store.request_media("https://a.example/1.png"), MediaRequest::Pending);
+        assert_eq!(fetcher.started.lock().len(), 1, "the second load waits for the slot");
+
+        store.abandon_loads();
+        let (_, done) = fetcher.started.lock().remove(0);
+        done(Err(anyhow::anyhow!("media fetch response channel closed")));
+        assert!(fetcher.started.lock().is_empty(), "the abandoned waiter never starts");
+        assert!(!store.take_completed());
+
+        // The next document asks for both again and gets fresh loads.
+        assert_eq!(store.request_media("https://a.example/0.png"), MediaRequest::Pending);
+        assert_eq!(store.request_media("https://a.example/1.png"), MediaRequest::Pending);
+        let started: Vec<String> = fetcher.started.lock().iter().map(|(u, _)| u.to_string()).collect();
+        assert_eq!(started, ["https://a.example/0.png"]);
+    }
 }
@@ -1,10 +1,12 @@
 use crate::common::geo::Dimension;
+use crate::common::media::{svg_raster_bucket, SvgRasterCache, SvgRasterKey};
 use crate::render::backend::PixelFormat;
-use parking_lot::RwLock;
 use resvg::usvg;
+use std::sync::atomic::{AtomicU64, Ordering};
 use std::sync::Arc;
 
-/// Cached render of an SVG at a specific dimension and byte order.
+/// Render of an SVG at a specific dimension and byte order, as kept by the
+/// [`SvgRasterCache`].
 pub struct RenderedSvg {
     pub dimension: Dimension,
     pub data: Vec<u8>,
@@ -29,23 +31,59 @@ impl RenderedSvg {
 
 #[derive(Clone)]
 pub struct Svg {
+    /// Parsed once when the SVG loads; every raster is rendered from it.
     pub tree: usvg::Tree,
-    /// Rendered cache - dimension and pixel data kept under one lock for consistency.
-    pub rendered: Arc<RwLock<RenderedSvg>>,
+    /// Identity of the parsed document in the [`SvgRasterCache`]. Clones share it, and with it
+    /// their rasters.
+    id: u64,
 }
 
 impl Svg {
     pub fn new(tree: usvg::Tree) -> Svg {
+        static NEXT_ID: AtomicU64 = AtomicU64::new(1);
         Svg {
             tree,
-            rendered: Arc::new(RwLock::new(RenderedSvg {
-                dimension: Dimension::ZERO,
-                data: vec![],
-                // Arbitrary until the first render; `is_usable` rejects the empty buffer first.
-                format: PixelFormat::Rgba8,
-            })),
+            id: NEXT_ID.fetch_add(1, Ordering::Relaxed),
         }
     }
+
+    pub fn id(&self) -> u64 {
+        self.id
+    }
+
+    /// The SVG rasterized for a `width`×`height` device-pixel box, in `format`. Comes from the
+    /// shared [`SvgRasterCache`], rendered at [`svg_raster_bucket`] size: up to 1/8th larger than
+    /// the box, so callers scale it to the box when drawing. `None` if the pixmap can't allocate.
+    pub fn raster(&self, width: u32, height: u32, format: PixelFormat) -> Option<Arc<RenderedSvg>> {
+        let key = SvgRasterKey {
+            svg: self.id,
+            width: svg_raster_bucket(width),
+            height: svg_raster_bucket(height),
+            format,
+        };
+        SvgRasterCache::global().get_or_render(key, || self.render(key.width, key.height, format))
+    }
+
+    fn render(&self, width: u32, height: u32, format: PixelFormat) -> Option<RenderedSvg> {
+        let size = self.tree.size().to_int_size();
+        let sx = width as f32 / size.width().max(1) as f32;
+        let sy = height as f32 / size.height().max(1) as f32;
+        let mut pixmap = resvg::tiny_skia::Pixmap::new(width, height)?;
+        resvg::render(&self.tree, usvg::Transform::from_scale(sx, sy), &mut pixmap.as_mut());
+
+        // tiny_skia renders premultiplied RGBA.
+        let mut data = pixmap.take();
+        if format == PixelFormat::PreMulArgb32 {
+            for px in data.chunks_exact_mut(4) {
+                px.swap(0, 2);
+            }
+        }
+        Some(RenderedSvg {
+            dimension: Dimension::new(width as f64, height as f64),
+            data,
+            format,
+        })
+    }
 }
 
 impl std::fmt::Debug for Svg {
@@ -58,6 +96,36 @@ impl std::fmt::Debug for Svg {
 mod tests {
     use super::*;
 
+    fn svg(side: u32) -> Svg {
+        let markup = format!(
+            r#"<svg xmlns="http://www.w3.org/2000/svg" width="{side}" height="{side}"><rect width="{side}" height="{side}" fill="red"/></svg>"#
+        );
+        Svg::new(usvg::Tree::from_str(&markup, &usvg::Options::default()).expect("parse svg"))
+    }
+
+    /// Nearby sizes share one raster, rendered at the bucket size.
+    #[test]
+    fn nearby_sizes_share_a_raster() {
+        let icon = svg(10);
+        let a = icon.raster(300, 300, PixelFormat::Rgba8).expect("raster");
+        let b = icon.raster(310, 305, PixelFormat::Rgba8).expect("raster");
+        assert!(Arc::ptr_eq(&a, &b));
+        assert_eq!(a.dimension, Dimension::new(320.0, 320.0));
+        assert_eq!(&a.data[..4], &[255, 0, 0, 255]);
+
+        // Clones share rasters; other documents and byte orders do not.
+        assert!(Arc::ptr_eq(
+            &icon.clone().raster(300, 300, PixelFormat::Rgba8).expect("raster"),
+            &a
+        ));
+        assert!(!Arc::ptr_eq(
+            &svg(10).raster(300, 300, PixelFormat::Rgba8).expect("raster"),
+            &a
+        ));
+        let bgra = icon.raster(300, 300, PixelFormat::PreMulArgb32).expect("raster");
+        assert_eq!(&bgra.data[..4], &[0, 0, 255, 255]);
+    }
+
     fn entry(format: PixelFormat) -> RenderedSvg {
         RenderedSvg {
             dimension: Dimension::new(16.0, 16.0),
@@ -0,0 +1,255 @@
+//! Process-wide cache of rasterized SVGs.
+//!
+//! An SVG drawn at many sizes (an icon sprite repeated down a page, or a graphic resized
+//! continuously during a window resize or zoom) would otherwise be rendered again for every size
+//! it is painted at. Rasters are keyed by the parsed SVG, a size bucket and the pixel format, so
+//! nearby sizes share one render that the backends scale to the box when drawing. The cache is
+//! bounded by a byte budget; over it, the least recently used rasters go first.
+
+use crate::common::media::svg::RenderedSvg;
+use crate::render::backend::PixelFormat;
+use parking_lot::Mutex;
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, OnceLock};
+
+/// Budget of [`SvgRasterCache::global`] until the engine configures one.
+pub const DEFAULT_SVG_RASTER_BUDGET: u64 = 64 << 20;
+
+/// Sizes up to this many pixels are rendered exactly; icons stay pixel-crisp.
+const EXACT_BUCKET_MAX: u32 = 64;
+
+/// Size a raster for a `px` pixel wide (or high) box is rendered at: `px` itself up to 64, above
+/// that rounded up to the next multiple of an eighth of its power of two, so a raster is never
+/// more than 1/8th larger than the box it is drawn into.
+pub fn svg_raster_bucket(px: u32) -> u32 {
+    if px <= EXACT_BUCKET_MAX {
+        return px.max(1);
+    }
+    let step = 1u32 << (u32::BITS - 1 - px.leading_zeros() - 3);
+    px.div_ceil(step).saturating_mul(step)
+}
+
+/// Which raster of an SVG an entry holds.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct SvgRasterKey {
+    /// [`Svg::id`](crate::common::media::Svg::id) of the parsed document.
+    pub svg: u64,
+    /// Bucketed pixel size, see [`svg_raster_bucket`].
+    pub width: u32,
+    pub height: u32,
+    pub format: PixelFormat,
+}
+
+/// Current size and event counts of an [`SvgRasterCache`]. `hits`, `misses` and `evictions`
+/// count since startup or the last [`SvgRasterCache::reset_stats`].
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct SvgRasterCacheStats {
+    pub bytes: u64,
+    pub rasters: u64,
+    pub limit: u64,
+    pub hits: u64,
+    pub misses: u64,
+    pub evictions: u64,
+}
+
+struct Entry {
+    raster: Arc<RenderedSvg>,
+    bytes: u64,
+    last_used: u64,
+}
+
+#[derive(Default)]
+struct Inner {
+    entries: HashMap<SvgRasterKey, Entry>,
+    bytes: u64,
+    /// Use counter; an entry's `last_used` is the value at its last insert or hit.
+    clock: u64,
+}
+
+/// See the module documentation. Shared by every tile, tab and rasterizer backend.
+pub struct SvgRasterCache {
+    inner: Mutex<Inner>,
+    limit: AtomicU64,
+    hits: AtomicU64,
+    misses: AtomicU64,
+    evictions: AtomicU64,
+}
+
+impl SvgRasterCache {
+    /// A cache holding at most `limit_bytes` of rasterized pixels.
+    pub fn new(limit_bytes: u64) -> Self {
+        Self {
+            inner: Mutex::new(Inner::default()),
+            limit: AtomicU64::new(limit_bytes),
+            hits: AtomicU64::new(0),
+            misses: AtomicU64::new(0),
+            evictions: AtomicU64::new(0),
+        }
+    }
+
+    /// The cache [`Svg::raster`](crate::common::media::Svg::raster) renders into.
+    pub fn global() -> &'static SvgRasterCache {
+        static CACHE: OnceLock<SvgRasterCache> = OnceLock::new();
+        CACHE.get_or_init(|| SvgRasterCache::new(DEFAULT_SVG_RASTER_BUDGET))
+    }
+
+    /// Changes the byte budget, evicting right away if the cache is now over it.
+    pub fn set_limit(&self, limit_bytes: u64) {
+        self.limit.store(limit_bytes, Ordering::Relaxed);
+        self.evict(&mut self.inner.lock());
+    }
+
+    /// The cached raster under `key`, or the result of `render` (cached) on a miss. `render` runs
+    /// without the cache locked; tiles missing on the same key at once may both render.
+    pub fn get_or_render(
+        &self,
+        key: SvgRasterKey,
+        render: impl FnOnce() -> Option<RenderedSvg>,
+    ) -> Option<Arc<RenderedSvg>> {
+        {
+            let mut inner = self.inner.lock();
+            inner.clock += 1;
+            let clock = inner.clock;
+            if let Some(entry) = inner.entries.get_mut(&key) {
+                entry.last_used = clock;
+                self.hits.fetch_add(1, Ordering::Relaxed);
+                return Some(Arc::clone(&entry.raster));
+            }
+        }
+        self.misses.fetch_add(1, Ordering::Relaxed);
+
+        let raster = Arc::new(render()?);
+        let bytes = raster.data.len() as u64;
+        let mut inner = self.inner.lock();
+        inner.clock += 1;
+        let entry = Entry {
+            raster: Arc::clone(&raster),
+            bytes,
+            last_used: inner.clock,
+        };
+        inner.bytes += bytes;
+        if let Some(old) = inner.entries.insert(key, entry) {
+            inner.bytes -= old.bytes;
+        }
+        self.evict(&mut inner);
+        Some(raster)
+    }
+
+    pub fn stats(&self) -> SvgRasterCacheStats {
+        let inner = self.inner.lock();
+        SvgRasterCacheStats {
+            bytes: inner.bytes,
+            rasters: inner.entries.len() as u64,
+            limit: self.limit.load(Ordering::Relaxed),
+            hits: self.hits.load(Ordering::Relaxed),
+            misses: self.misses.load(Ordering::Relaxed),
+            evictions: self.evictions.load(Ordering::Relaxed),
+        }
+    }
+
+    /// Zeroes the event counters. The size totals are left alone.
+    pub fn reset_stats(&self) {
+        for counter in [&self.hits, &self.misses, &self.evictions] {
+            counter.store(0, Ordering::Relaxed);
+        }
+    }
+
+    /// Evicts least recently used entries until the cache is back within budget.
+    fn evict(&self, inner: &mut Inner) {
+        let limit = self.limit.load(Ordering::Relaxed);
+        if inner.bytes <= limit {
+            return;
+        }
+
+        let mut order: Vec<(u64, SvgRasterKey)> = inner.entries.iter().map(|(k, e)| (e.last_used, *k)).collect();
+        order.sort_unstable_by_key(|(last_used, _)| *last_used);
+
+        for (_, key) in order {
+            if inner.bytes <= limit {
+                break;
+            }
+            if let Some(entry) = inner.entries.remove(&key) {
+                inner.bytes -= entry.bytes;
+                self.evictions.fetch_add(1, Ordering::Relaxed);
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::common::geo::Dimension;
+
+    fn raster(side: u32) -> RenderedSvg {
+        RenderedSvg {
+            dimension: Dimension::new(side as f64, side as f64),
+            data: vec![0; (side * side * 4) as usize],
+            format: PixelFormat::Rgba8,
+        }
+    }
+
+    fn key(svg: u64, side: u32) -> SvgRasterKey {
+        SvgRasterKey {
+            svg,
+            width: side,
+            height: side,
+            format: PixelFormat::Rgba8,
+        }
+    }
+
+    #[test]
+    fn buckets_small_sizes_exactly_and_large_ones_coarsely() {
+        assert_eq!(svg_raster_bucket(0), 1);
+        assert_eq!(svg_raster_bucket(16), 16);
+        assert_eq!(svg_raster_bucket(64), 64);
+        assert_eq!(svg_raster_bucket(65), 72);
+        assert_eq!(svg_raster_bucket(1000), 1024);
+        for px in 1..5000 {
+            let bucket = svg_raster_bucket(px);
+            assert!(bucket >= px && bucket - px <= px / 8, "{px} -> {bucket}");
+        }
+        // A continuous resize lands on a handful of buckets.
+        let buckets: std::collections::HashSet<u32> = (300..400).map(svg_raster_bucket).collect();
+        assert!(buckets.len() <= 4, "{buckets:?}");
+    }
+
+    #[test]
+    fn renders_once_per_key() {
+        let cache = SvgRasterCache::new(u64::MAX);
+        let mut renders = 0;
+        for _ in 0..3 {
+            let got = cache.get_or_render(key(1, 8), || {
+                renders += 1;
+                Some(raster(8))
+            });
+            assert!(got.is_some());
+        }
+        assert_eq!(renders, 1);
+        assert_eq!((cache.stats().hits, cache.stats().misses), (2, 1));
+    }
+
+    #[test]
+    fn failed_renders_are_not_cached() {
+        let cache = SvgRasterCache::new(u64::MAX);
+        assert!(cache.get_or_render(key(1, 8), || None).is_none());
+        assert!(cache.get_or_render(key(1, 8), || Some(raster(8))).is_some());
+        assert_eq!(cache.stats().rasters, 1);
+    }
+
+    #[test]
+    fn evicts_least_recently_used_over_budget() {
+        // 10×10 RGBA = 400 bytes per raster.
+        let cache = SvgRasterCache::new(800);
+        cache.get_or_render(key(0, 10), || Some(raster(10)));
+        cache.get_or_render(key(1, 10), || Some(raster(10)));
+        cache.get_or_render(key(0, 10), || None);
+        cache.get_or_render(key(2, 10), || Some(raster(10)));
+
+        let stats = cache.stats();
+        assert_eq!((stats.rasters, stats.bytes, stats.evictions), (2, 800, 1));
+        assert!(cache.get_or_render(key(0, 10), || None).is_some());
+        assert!(cache.get_or_render(key(1, 10), || None).is_none());
+    }
+}
@@ -0,0 +1,533 @@
+//! Process-wide cache of text measurements and shaped glyph runs.
+//!
+//! Taffy measures every text box several times per layout pass, the painter shapes each text
+//! box again for every tile it overlaps, and both repeat the work on the next frame. The cache
+//! sits in front of the font system: hits take only a shard's read lock, and the font system
+//! shapes on a miss alone.
+//!
+//! Entries are keyed by the font system they came from plus the text and the complete
+//! [`TextStyle`], so tabs sharing a zone's font system share its entries. Each shard is capped
+//! at its slice of the byte budget and evicts its least recently used entries when it overflows.
+//!
+//! Registering a font only invalidates the text whose family list names it (see
+//! [`ShapeCache::forget_family`]), and lazily: every entry remembers the registration generation
+//! it was last known valid at, and a lookup that finds it behind checks the registrations made
+//! since against the entry's families, without taking any write lock.
+use gosub_interface::font::FontStyle;
+use gosub_interface::font_system::{FontSystem, ShapedGlyph, ShapedRun, ShapedText, TextAlign, TextStyle};
+use gosub_shared::counter_add;
+use parking_lot::RwLock;
+use std::collections::hash_map::RandomState;
+use std::collections::HashMap;
+use std::hash::{BuildHasher, Hash, Hasher};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, OnceLock, Weak};
+
+/// Byte budget of the [global](ShapeCache::global) cache
+pub const DEFAULT_CAPACITY: usize = 32 * 1024 * 1024;
+
+const SHARD_COUNT: usize = 16;
+
+/// What is cached for a key: [`FontSystem::measure`] and [`FontSystem::shape`] may disagree on
+/// fallback paths, so each keeps its own entries.
+#[derive(Clone, Copy, PartialEq, Eq, Hash)]
+enum Kind {
+    Measure,
+    Shape,
+}
+
+/// The fixed-size part of a key. The text and family are stored (and compared) separately so a
+/// lookup does not have to allocate.
+#[derive(Clone, Copy, PartialEq, Eq, Hash)]
+struct Params {
+    system: usize,
+    kind: Kind,
+    size: u32,
+    weight: u16,
+    style: u8,
+    stretch: u32,
+    line_height: Option<u32>,
+    letter_spacing: u32,
+    max_width: Option<u32>,
+    align: u8,
+    display_scale: u32,
+}
+
+impl Params {
+    fn new(system: usize, kind: Kind, style: &TextStyle) -> Self {
+        Self {
+            system,
+            kind,
+            size: style.size.to_bits(),
+            weight: style.weight.0,
+            style: match style.style {
+                FontStyle::Normal => 0,
+                FontStyle::Italic => 1,
+                FontStyle::Oblique => 2,
+            },
+            stretch: style.stretch.0.to_bits(),
+            line_height: style.line_height.map(f32::to_bits),
+            letter_spacing: style.letter_spacing.to_bits(),
+            max_width: style.max_width.map(f32::to_bits),
+            align: match style.align {
+                TextAlign::Start => 0,
+                TextAlign::Center => 1,
+                TextAlign::End => 2,
+                TextAlign::Justify => 3,
+            },
+            display_scale: style.display_scale.to_bits(),
+        }
+    }
+}
+
+#[derive(Clone)]
+enum Value {
+    Measured(f32, f32),
+    Shaped(Arc<ShapedText>),
+}
+
+struct Entry {
+    params: Params,
+    text: Box<str>,
+    family: Box<str>,
+    value: Value,
+    bytes: usize,
+    /// Shard clock tick of the last lookup that returned this entry
+    last_used: AtomicU64,
+    /// Registration generation the entry was last known to be valid at
+    generation: AtomicU64,
+    /// Keeps the font system's allocation alive, so its address (the `system` key) cannot be
+    /// reused by another font system while this entry exists.
+    _system: Weak<dyn FontSystem>,
+}
+
+impl Entry {
+    fn matches(&self, params: &Params, text: &str, family: &str) -> bool {
+        self.params == *params && &*self.text == text && &*self.family == family
+    }
+}
+
+#[derive(Default)]
+struct ShardMap {
+    /// Entries by key hash; collisions share a bucket.
+    buckets: HashMap<u64, Vec<Entry>>,
+    bytes: usize,
+    len: usize,
+}
+
+#[derive(Default)]
+struct Shard {
+    map: RwLock<ShardMap>,
+    clock: AtomicU64,
+}
+
+/// A family registered with a font system, at the generation the registration started.
+struct Registration {
+    system: usize,
+    generation: u64,
+    family: Box<str>,
+}
+
+impl Registration {
+    /// True if `families`, a CSS family list, names the registered family.
+    fn named_in(&self, families: &str) -> bool {
+        families
+            .split(',')
+            .map(|f| f.trim().trim_matches(|c| c == '"' || c == '\''))
+            .any(|f| f.eq_ignore_ascii_case(&self.family))
+    }
+}
+
+/// Sharded, size-capped cache of text measurements and shaped runs. See the module
+/// documentation.
+pub struct ShapeCache {
+    shards: Vec<Shard>,
+    hasher: RandomState,
+    shard_capacity: usize,
+    /// Bumped by every [`Self::forget_family`]
+    generation: AtomicU64,
+    /// Every registration so far, oldest first
+    registrations: RwLock<Vec<Registration>>,
+}
+
+impl Default for ShapeCache {
+    fn default() -> Self {
+        Self::new(DEFAULT_CAPACITY)
+    }
+}
+
+impl ShapeCache {
+    /// Creates a cache that holds about `capacity` bytes of text and glyph data.
+    pub fn new(capacity: usize) -> Self {
+        Self {
+            shards: (0..SHARD_COUNT).map(|_| Shard::default()).collect(),
+            hasher: RandomState::new(),
+            shard_capacity: (capacity / SHARD_COUNT).max(1),
+            generation: AtomicU64::new(0),
+            registrations: RwLock::new(Vec::new()),
+        }
+    }
+
+    /// The cache shared by every layouter and painter in the process
+    pub fn global() -> &'static ShapeCache {
+        static CACHE: OnceLock<ShapeCache> = OnceLock::new();
+        CACHE.get_or_init(ShapeCache::default)
+    }
+
+    /// [`FontSystem::measure`] through the cache
+    pub fn measure(&self, font_system: &Arc<dyn FontSystem>, text: &str, style: &TextStyle) -> (f32, f32) {
+        match self.get_or_insert(font_system, Kind::Measure, text, style, |fs| {
+            let (w, h) = fs.measure(text, style);
+            Value::Measured(w, h)
+        }) {
+            Value::Measured(w, h) => (w, h),
+            Value::Shaped(shaped) => (shaped.width, shaped.height),
+        }
+    }
+
+    /// [`FontSystem::shape`] through the cache. The result is shared with every other caller
+    /// that shapes the same text in the same style.
+    pub fn shape(&self, font_system: &Arc<dyn FontSystem>, text: &str, style: &TextStyle) -> Arc<ShapedText> {
+        match self.get_or_insert(font_system, Kind::Shape, text, style, |fs| {
+            Value::Shaped(Arc::new(fs.shape(text, style)))
+        }) {
+            Value::Shaped(shaped) => shaped,
+            Value::Measured(..) => Arc::new(ShapedText::empty()),
+        }
+    }
+
+    /// Invalidates the entries of `font_system` whose family list names `family`. Call after
+    /// registering a font for `family` with it: text that fell back past that family resolves to
+    /// the new font now. The entries are only marked; they are shaped again on their next lookup.
+    pub fn forget_family<T: ?Sized>(&self, font_system: &Arc<T>, family: &str) {
+        let mut registrations = self.registrations.write();
+        let generation = self.generation.load(Ordering::Acquire);
+        registrations.push(Registration {
+            system: system_key(font_system),
+            generation,
+            family: family.into(),
+        });
+        self.generation.store(generation + 1, Ordering::Release);
+    }
+
+    /// Number of cached entries
+    pub fn len(&self) -> usize {
+        self.shards.iter().map(|s| s.map.read().len).sum()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Approximate memory held by the cached entries
+    pub fn bytes(&self) -> usize {
+        self.shards.iter().map(|s| s.map.read().bytes).sum()
+    }
+
+    pub fn clear(&self) {
+        for shard in &self.shards {
+            *shard.map.write() = ShardMap::default();
+        }
+    }
+
+    fn get_or_insert(
+        &self,
+        font_system: &Arc<dyn FontSystem>,
+        kind: Kind,
+        text: &str,
+        style: &TextStyle,
+        compute: impl FnOnce(&dyn FontSystem) -> Value,
+    ) -> Value {
+        let params = Params::new(system_key(font_system), kind, style);
+        let hash = {
+            let mut h = self.hasher.build_hasher();
+            params.hash(&mut h);
+            text.hash(&mut h);
+            style.family.hash(&mut h);
+            h.finish()
+        };
+        let shard = &self.shards[(hash % SHARD_COUNT as u64) as usize];
+
+        let generation = self.generation.load(Ordering::Acquire);
+        if let Some(value) = self.lookup(shard, hash, &params, text, &style.family, generation) {
+            counter_add!("text.shape_cache.hit");
+            return value;
+        }
+        counter_add!("text.shape_cache.miss");
+
+        let value = compute(font_system.as_ref());
+        let bytes = std::mem::size_of::<Entry>() + text.len() + style.family.len() + value_bytes(&value);
+        let entry = Entry {
+            params,
+            text: text.into(),
+            family: style.family.as_str().into(),
+            value: value.clone(),
+            bytes,
+            last_used: AtomicU64::new(shard.clock.fetch_add(1, Ordering::Relaxed)),
+            generation: AtomicU64::new(generation),
+            _system: Arc::downgrade(font_system),
+        };
+
+        let mut map = shard.map.write();
+        let bucket = map.buckets.entry(hash).or_default();
+        match bucket.iter().position(|e| e.matches(&params, text, &style.family)) {
+            // Another thread shaped the same text in the meantime.
+            Some(i) if bucket[i].generation.load(Ordering::Relaxed) >= generation => {
+                return bucket[i].value.clone();
+            }
+            // The entry the lookup found stale.
+            Some(i) => {
+                let stale = std::mem::replace(&mut bucket[i], entry);
+                map.bytes = map.bytes - stale.bytes + bytes;
+            }
+            None => {
+                bucket.push(entry);
+                map.bytes += bytes;
+                map.len += 1;
+            }
+        }
+        if map.bytes > self.shard_capacity {
+            Self::evict(&mut map, self.shard_capacity - self.shard_capacity / 4);
+        }
+        value
+    }
+
+    /// The value cached for the key, unless a font registered since the entry was last checked
+    /// serves one of its families. `generation` is the current registration generation.
+    fn lookup(
+        &self,
+        shard: &Shard,
+        hash: u64,
+        params: &Params,
+        text: &str,
+        family: &str,
+        generation: u64,
+    ) -> Option<Value> {
+        let map = shard.map.read();
+        let entry = map
+            .buckets
+            .get(&hash)?
+            .iter()
+            .find(|e| e.matches(params, text, family))?;
+        let checked = entry.generation.load(Ordering::Relaxed);
+        if checked < generation {
+            let registrations = self.registrations.read();
+            let newer = registrations.iter().rev().take_while(|r| r.generation >= checked);
+            if newer
+                .filter(|r| r.generation < generation)
+                .any(|r| r.system == params.system && r.named_in(family))
+            {
+                counter_add!("text.shape_cache.invalidated");
+                return None;
+            }
+            entry.generation.fetch_max(generation, Ordering::Relaxed);
+        }
+        entry
+            .last_used
+            .store(shard.clock.fetch_add(1, Ordering::Relaxed), Ordering::Relaxed);
+        Some(entry.value.clone())
+    }
+
+    /// Drops the least recently used entries until the shard holds at most `target` bytes.
+    fn evict(map: &mut ShardMap, target: usize) {
+        let mut ages: Vec<(u64, usize)> = map
+            .buckets
+            .values()
+            .flatten()
+            .map(|e| (e.last_used.load(Ordering::Relaxed), e.bytes))
+            .collect();
+        ages.sort_unstable_by_key(|(tick, _)| *tick);
+
+        let mut remaining = map.bytes;
+        let mut cutoff = None;
+        for (tick, bytes) in ages {
+            if remaining <= target {
+                break;
+            }
+            remaining -= bytes;
+            cutoff = Some(tick);
+        }
+        let Some(cutoff) = cutoff else {
+            return;
+        };
+
+        let ShardMap { buckets, bytes, len } = map;
+        buckets.retain(|_, bucket| {
+            bucket.retain(|e| {
+                let keep = e.last_used.load(Ordering::Relaxed) > cutoff;
+                if !keep {
+                    *bytes -= e.bytes;
+                    *len -= 1;
+                    counter_add!("text.shape_cache.evicted");
+                }
+                keep
+            });
+            !bucket.is_empty()
+        });
+    }
+}
+
+fn system_key<T: ?Sized>(font_system: &Arc<T>) -> usize {
+    Arc::as_ptr(font_system).cast::<()>() as usize
+}
+
+fn value_bytes(value: &Value) -> usize {
+    match value {
+        Value::Measured(..) => 0,
+        Value::Shaped(shaped) => {
+            std::mem::size_of::<ShapedText>()
+                + shaped
+                    .runs
+                    .iter()
+                    .map(|run| {
+                        std::mem::size_of::<ShapedRun>()
+                            + run.font.family.len()
+                            + run.glyphs.len() * std::mem::size_of::<ShapedGlyph>()
+                    })
+                    .sum::<usize>()
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use gosub_interface::font::FontError;
+    use gosub_interface::font_system::{FontQuery, ResolvedFont};
+    use std::sync::atomic::AtomicUsize;
+
+    /// Counts calls; "shapes" a string as one glyph per byte.
+    #[derive(Default)]
+    struct CountingFontSystem {
+        measured: AtomicUsize,
+        shaped: AtomicUsize,
+    }
+
+    impl CountingFontSystem {
+        fn measured(&self) -> usize {
+            self.measured.load(Ordering::Relaxed)
+        }
+
+        fn shaped(&self) -> usize {
+            self.shaped.load(Ordering::Relaxed)
+        }
+    }
+
+    impl FontSystem for CountingFontSystem {
+        fn register_font(&self, _data: Vec<u8>, _family_override: Option<&str>) -> Result<(), FontError> {
+            Ok(())
+        }
+
+        fn resolve(&self, query: &FontQuery<'_>) -> Result<ResolvedFont, FontError> {
+            Err(FontError::FontNotFound(query.families.join(",")))
+        }
+
+        fn families(&self) -> Vec<String> {
+            Vec::new()
+        }
+
+        fn shape(&self, text: &str, style: &TextStyle) -> ShapedText {
+            self.shaped.fetch_add(1, Ordering::Relaxed);
+            ShapedText {
+                width: text.len() as f32 * style.size,
+                height: style.size,
+                ..ShapedText::empty()
+            }
+        }
+
+        fn measure(&self, text: &str, style: &TextStyle) -> (f32, f32) {
+            self.measured.fetch_add(1, Ordering::Relaxed);
+            (text.len() as f32 * style.size, style.size)
+        }
+    }
+
+    fn counting() -> (Arc<CountingFontSystem>, Arc<dyn FontSystem>) {
+        let fs = Arc::new(CountingFontSystem::default());
+        let shared: Arc<dyn FontSystem> = fs.clone();
+        (fs, shared)
+    }
+
+    #[test]
+    fn hits_skip_the_font_system() {
+        let cache = ShapeCache::new(1024 * 1024);
+        let (fs, shared) = counting();
+        let style = TextStyle::new("serif", 10.0);
+
+        assert_eq!(cache.measure(&shared, "hello", &style), (50.0, 10.0));
+        assert_eq!(cache.measure(&shared, "hello", &style), (50.0, 10.0));
+        let a = cache.shape(&shared, "hello", &style);
+        let b = cache.shape(&shared, "hello", &style);
+        assert!(Arc::ptr_eq(&a, &b));
+        assert_eq!((fs.measured(), fs.shaped()), (1, 1));
+
+        // Any change to the text or the style is a different entry.
+        cache.measure(&shared, "hello!", &style);
+        let mut wrapped = style.clone();
+        wrapped.max_width = Some(20.0);
+        cache.measure(&shared, "hello", &wrapped);
+        assert_eq!(fs.measured(), 3);
+        assert_eq!(cache.len(), 4);
+    }
+
+    #[test]
+    fn font_systems_do_not_share_entries() {
+        let cache = ShapeCache::new(1024 * 1024);
+        let (first, first_shared) = counting();
+        let (second, second_shared) = counting();
+        let style = TextStyle::new("serif", 10.0);
+
+        cache.measure(&first_shared, "hello", &style);
+        cache.measure(&second_shared, "hello", &style);
+        assert_eq!((first.measured(), second.measured()), (1, 1));
+
+        cache.forget_family(&first, "serif");
+        cache.measure(&first_shared, "hello", &style);
+        cache.measure(&second_shared, "hello", &style);
+        assert_eq!((first.measured(), second.measured()), (2, 1));
+    }
+
+    #[test]
+    fn registering_a_family_invalidates_only_text_that_names_it() {
+        let cache = ShapeCache::new(1024 * 1024);
+        let (fs, shared) = counting();
+        let web = TextStyle::new("\"Web Font\", sans-serif", 10.0);
+        let plain = TextStyle::new("serif", 10.0);
+
+        cache.measure(&shared, "hello", &web);
+        cache.measure(&shared, "hello", &plain);
+        cache.forget_family(&fs, "web font");
+        cache.measure(&shared, "hello", &web);
+        cache.measure(&shared, "hello", &plain);
+        assert_eq!(fs.measured(), 3);
+        // The entry was replaced, not duplicated, and is valid again.
+        assert_eq!(cache.len(), 2);
+        cache.measure(&shared, "hello", &web);
+        assert_eq!(fs.measured(), 3);
+
+        // Registering an unrelated family leaves both entries alone.
+        cache.forget_family(&fs, "Other");
+        cache.measure(&shared, "hello", &web);
+        cache.measure(&shared, "hello", &plain);
+        assert_eq!(fs.measured(), 3);
+    }
+
+    #[test]
+    fn evicts_least_recently_used_over_capacity() {
+        let entry_size = std::mem::size_of::<Entry>() + "text-000".len() + "serif".len();
+        let cache = ShapeCache::new(entry_size * 8 * SHARD_COUNT);
+        let (fs, shared) = counting();
+        let style = TextStyle::new("serif", 10.0);
+
+        for i in 0..200 {
+            cache.measure(&shared, &format!("text-{i:03}"), &style);
+            // Keep one entry hot; it must survive every eviction.
+            cache.measure(&shared, "text-hot", &style);
+        }
+        assert!(cache.bytes() <= entry_size * 8 * SHARD_COUNT);
+        assert!(cache.len() < 201);
+
+        let before = fs.measured();
+        cache.measure(&shared, "text-hot", &style);
+        assert_eq!(fs.measured(), before);
+    }
+}
@@ -1,4 +1,5 @@
 use crate::common::texture::{Texture, TextureId, TilePixels};
+use crate::common::tile_cache::TileBufferPool;
 use parking_lot::RwLock;
 use std::collections::HashMap;
 use std::sync::Arc;
@@ -8,6 +9,8 @@ use std::sync::Arc;
 pub struct TextureStore {
     textures: HashMap<TextureId, Arc<Texture>>,
     next_id: RwLock<TextureId>,
+    /// Where [`Self::take_buffer`] gets recycled pixel buffers from, if anywhere.
+    buffers: Option<Arc<TileBufferPool>>,
 }
 
 impl Default for TextureStore {
@@ -21,6 +24,24 @@ impl TextureStore {
         Self {
             textures: HashMap::new(),
             next_id: RwLock::new(TextureId::new(0)),
+            buffers: None,
+        }
+    }
+
+    /// A store whose [`Self::take_buffer`] recycles buffers from `buffers`.
+    pub fn with_buffer_pool(buffers: Arc<TileBufferPool>) -> Self {
+        Self {
+            buffers: Some(buffers),
+            ..Self::new()
+        }
+    }
+
+    /// An empty buffer with room for `len` bytes for a rasterizer to copy tile pixels into before
+    /// passing it to [`Self::add`]; a recycled one when this store has a buffer pool.
+    pub fn take_buffer(&self, len: usize) -> Vec<u8> {
+        match &self.buffers {
+            Some(pool) => pool.take(len),
+            None => Vec::with_capacity(len),
         }
     }
 
@@ -72,6 +93,11 @@ impl TextureStore {
         self.textures.get(&texture_id).cloned()
     }
 
+    /// Removes a texture from the store, handing it to the caller.
+    pub fn remove(&mut self, texture_id: TextureId) -> Option<Arc<Texture>> {
+        self.textures.remove(&texture_id)
+    }
+
     fn next_id(&self) -> TextureId {
         let mut nid = self.next_id.write();
         let id = *nid;
@@ -0,0 +1,525 @@
+//! Persistent, memory-budgeted cache of rasterized tile pixels.
+//!
+//! Tiles are keyed by page position, layer and a hash of their paint commands (see
+//! `rasterizer::tile_cache_key`), so a tile whose content did not change between renders is taken
+//! from here instead of being rasterized again. A cache lives as long as its tab and is bounded by
+//! two byte budgets: its own, and a [`TileCacheBudget`] shared by every tab of a zone. Over budget,
+//! entries outside the viewport go first, least recently used first. Over the zone budget, the
+//! caches of the tabs that rendered least recently (background tabs) give up their entries
+//! first, and the cache whose insert went over goes last.
+//!
+//! Evicted pixel buffers that nothing else still references go back to the cache's
+//! [`TileBufferPool`], from which the rasterizers take the buffers they fill.
+
+use crate::common::geo::Rect;
+use crate::common::texture::TilePixels;
+use crate::render::backend::PixelFormat;
+use parking_lot::Mutex;
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Weak};
+
+/// Key that uniquely identifies a tile's content for cache lookup.
+/// Format: (page_x bits, page_y bits, layer_id, paint-command hash).
+pub type TileCacheKey = (u64, u64, u64, u64);
+
+// Process-wide totals over every tile cache, for the metrics endpoint.
+static CACHED_BYTES: AtomicU64 = AtomicU64::new(0);
+static CACHED_TILES: AtomicU64 = AtomicU64::new(0);
+static HITS: AtomicU64 = AtomicU64::new(0);
+static MISSES: AtomicU64 = AtomicU64::new(0);
+static EVICTIONS: AtomicU64 = AtomicU64::new(0);
+static RECYCLED: AtomicU64 = AtomicU64::new(0);
+
+/// Totals over every tile cache in the process. `bytes` and `tiles` are current sizes; the rest
+/// count events since startup.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct TileCacheStats {
+    pub bytes: u64,
+    pub tiles: u64,
+    pub hits: u64,
+    pub misses: u64,
+    pub evictions: u64,
+    /// Evicted pixel buffers handed back to a [`TileBufferPool`].
+    pub recycled: u64,
+}
+
+/// Snapshot of the process-wide tile cache totals.
+pub fn stats() -> TileCacheStats {
+    TileCacheStats {
+        bytes: CACHED_BYTES.load(Ordering::Relaxed),
+        tiles: CACHED_TILES.load(Ordering::Relaxed),
+        hits: HITS.load(Ordering::Relaxed),
+        misses: MISSES.load(Ordering::Relaxed),
+        evictions: EVICTIONS.load(Ordering::Relaxed),
+        recycled: RECYCLED.load(Ordering::Relaxed),
+    }
+}
+
+/// Zeroes the event counters (hits, misses, evictions, recycled). The size totals track live
+/// caches and are left alone.
+pub fn reset_stats() {
+    for counter in [&HITS, &MISSES, &EVICTIONS, &RECYCLED] {
+        counter.store(0, Ordering::Relaxed);
+    }
+}
+
+/// A byte budget shared by several tile caches (one per zone). Each cache charges its entries to
+/// it; while the shared total is over the limit, the caches evict in order of activity, least
+/// recently active first.
+#[derive(Debug)]
+pub struct TileCacheBudget {
+    limit: u64,
+    used: AtomicU64,
+    /// Activity counter; a cache's `last_active` is the value at its last insert or viewport change.
+    clock: AtomicU64,
+    /// Every cache charging this budget. Dropped caches are pruned on the next reclaim.
+    members: Mutex<Vec<Weak<Shared>>>,
+}
+
+impl TileCacheBudget {
+    pub fn new(limit_bytes: u64) -> Self {
+        Self {
+            limit: limit_bytes,
+            used: AtomicU64::new(0),
+            clock: AtomicU64::new(0),
+            members: Mutex::new(Vec::new()),
+        }
+    }
+
+    pub fn limit(&self) -> u64 {
+        self.limit
+    }
+
+    /// Bytes currently charged by all caches sharing this budget.
+    pub fn used(&self) -> u64 {
+        self.used.load(Ordering::Relaxed)
+    }
+
+    fn over_limit(&self) -> bool {
+        self.used() > self.limit
+    }
+
+    fn touch(&self, cache: &Shared) {
+        cache
+            .last_active
+            .store(self.clock.fetch_add(1, Ordering::Relaxed) + 1, Ordering::Relaxed);
+    }
+
+    /// Brings the budget back under its limit after `current` inserted `keep`: the other caches
+    /// evict first, the least recently active one first, then `current` itself, never evicting
+    /// `keep`. Locks one cache at a time.
+    fn reclaim(&self, current: &Arc<Shared>, keep: &TileCacheKey) {
+        let mut caches: Vec<Arc<Shared>> = {
+            let mut members = self.members.lock();
+            members.retain(|m| m.strong_count() > 0);
+            members
+                .iter()
+                .filter_map(Weak::upgrade)
+                .filter(|m| !Arc::ptr_eq(m, current))
+                .collect()
+        };
+        caches.sort_by_key(|m| m.last_active.load(Ordering::Relaxed));
+        caches.push(Arc::clone(current));
+
+        for cache in caches {
+            if !self.over_limit() {
+                break;
+            }
+            let protected = Arc::ptr_eq(&cache, current).then_some(keep);
+            cache.evict(&mut cache.inner.lock(), protected, |_| self.over_limit());
+        }
+    }
+}
+
+/// Free-list of tile pixel buffers. Rasterizers [`take`](Self::take) the buffer they copy a tile's
+/// pixels into, and the cache hands back the buffers of tiles it evicts.
+pub struct TileBufferPool {
+    free: Mutex<Vec<Vec<u8>>>,
+    max_buffers: usize,
+}
+
+impl TileBufferPool {
+    /// A pool keeping at most `max_buffers` free buffers; extra buffers are dropped.
+    pub fn new(max_buffers: usize) -> Self {
+        Self {
+            free: Mutex::new(Vec::new()),
+            max_buffers,
+        }
+    }
+
+    /// An empty buffer with room for at least `len` bytes, recycled when the pool has one.
+    pub fn take(&self, len: usize) -> Vec<u8> {
+        let recycled = {
+            let mut free = self.free.lock();
+            free.iter()
+                .position(|b| b.capacity() >= len)
+                .map(|i| free.swap_remove(i))
+        };
+        match recycled {
+            Some(mut buf) => {
+                buf.clear();
+                buf
+            }
+            None => Vec::with_capacity(len),
+        }
+    }
+
+    /// Puts `buf` on the free-list (or drops it when the pool is full).
+    pub fn give(&self, buf: Vec<u8>) {
+        let mut free = self.free.lock();
+        if free.len() < self.max_buffers {
+            free.push(buf);
+        }
+    }
+
+    /// Puts the allocation behind `pixels` on the free-list, provided nothing else (a baked tile,
+    /// a frame handed to the compositor) still references it. Returns whether it did.
+    pub fn recycle(&self, pixels: TilePixels) -> bool {
+        let TilePixels::Cpu(bytes) = pixels else {
+            return false;
+        };
+        match bytes.try_into_mut() {
+            Ok(buf) => {
+                self.give(Vec::from(buf));
+                true
+            }
+            Err(_) => false,
+        }
+    }
+
+    /// Number of free buffers.
+    pub fn len(&self) -> usize {
+        self.free.lock().len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+}
+
+/// A cached tile's pixels as its rasterizer produced them.
+#[derive(Clone, Debug)]
+pub struct CachedTilePixels {
+    /// Physical width in pixels.
+    pub width: u32,
+    /// Physical height in pixels.
+    pub height: u32,
+    pub pixels: TilePixels,
+    pub format: PixelFormat,
+}
+
+struct Entry {
+    tile: CachedTilePixels,
+    /// Page rect of the tile, for visibility-aware eviction.
+    rect: Rect,
+    bytes: u64,
+    last_used: u64,
+}
+
+#[derive(Default)]
+struct Inner {
+    entries: HashMap<TileCacheKey, Entry>,
+    bytes: u64,
+    /// Use counter; an entry's `last_used` is the value at its last insert or hit.
+    clock: u64,
+    /// The viewport in page coordinates, if known. Entries intersecting it are evicted last.
+    visible: Option<Rect>,
+}
+
+/// The part of a cache the other caches of its zone reach when the zone is over budget.
+struct Shared {
+    inner: Mutex<Inner>,
+    buffers: Arc<TileBufferPool>,
+    /// Zone clock at the cache's last insert or viewport change.
+    last_active: AtomicU64,
+    /// Zone the entries are charged to.
+    zone: Option<Arc<TileCacheBudget>>,
+}
+
+/// Rasterized tile cache: maps a [`TileCacheKey`] to the tile's [`CachedTilePixels`].
+/// See the module documentation. Safe to use from the rayon workers rasterizing a frame.
+pub struct TilePixelCache {
+    shared: Arc<Shared>,
+    limit: u64,
+}
+
+impl Default for TilePixelCache {
+    /// An unbounded cache with no zone budget.
+    fn default() -> Self {
+        Self::new(u64::MAX, None)
+    }
+}
+
+impl TilePixelCache {
+    /// Free buffers kept per cache; a few frames' worth of freshly rasterized tiles.
+    const POOLED_BUFFERS: usize = 64;
+
+    /// A cache holding at most `limit_bytes` of pixels, also charging `zone` when given.
+    pub fn new(limit_bytes: u64, zone: Option<Arc<TileCacheBudget>>) -> Self {
+        let shared = Arc::new(Shared {
+            inner: Mutex::new(Inner::default()),
+            buffers: Arc::new(TileBufferPool::new(Self::POOLED_BUFFERS)),
+            last_active: AtomicU64::new(0),
+            zone,
+        });
+        if let Some(zone) = &shared.zone {
+            zone.members.lock().push(Arc::downgrade(&shared));
+            zone.touch(&shared);
+        }
+        Self {
+            shared,
+            limit: limit_bytes,
+        }
+    }
+
+    /// The pool rasterizers should take their tile buffers from.
+    pub fn buffers(&self) -> &Arc<TileBufferPool> {
+        &self.shared.buffers
+    }
+
+    /// Looks up a tile, marking it as recently used.
+    pub fn get(&self, key: &TileCacheKey) -> Option<CachedTilePixels> {
+        let mut inner = self.shared.inner.lock();
+        inner.clock += 1;
+        let clock = inner.clock;
+        match inner.entries.get_mut(key) {
+            Some(entry) => {
+                entry.last_used = clock;
+                HITS.fetch_add(1, Ordering::Relaxed);
+                Some(entry.tile.clone())
+            }
+            None => {
+                MISSES.fetch_add(1, Ordering::Relaxed);
+                None
+            }
+        }
+    }
+
+    /// Caches a freshly rasterized tile covering `rect` (page coordinates), evicting other entries
+    /// if that takes the cache or its zone over budget. The new tile itself is never evicted.
+    pub fn insert(&self, key: TileCacheKey, rect: Rect, tile: CachedTilePixels) {
+        let bytes = match &tile.pixels {
+            TilePixels::Cpu(data) => data.len() as u64,
+            // Not in this process's memory, but it still occupies the GPU.
+            TilePixels::Gpu(_) => u64::from(tile.width) * u64::from(tile.height) * 4,
+        };
+
+        let shared = &self.shared;
+        {
+            let mut inner = shared.inner.lock();
+            inner.clock += 1;
+            let entry = Entry {
+                tile,
+                rect,
+                bytes,
+                last_used: inner.clock,
+            };
+            shared.charge(bytes);
+            inner.bytes += bytes;
+            match inner.entries.insert(key, entry) {
+                Some(old) => {
+                    inner.bytes -= old.bytes;
+                    shared.release(old.bytes, 0);
+                    if shared.buffers.recycle(old.tile.pixels) {
+                        RECYCLED.fetch_add(1, Ordering::Relaxed);
+                    }
+                }
+                None => {
+                    CACHED_TILES.fetch_add(1, Ordering::Relaxed);
+                }
+            }
+            let limit = self.limit;
+            shared.evict(&mut inner, Some(&key), |inner| inner.bytes > limit);
+        }
+
+        // The other caches of the zone are locked one at a time, never while holding this one.
+        if let Some(zone) = &shared.zone {
+            zone.touch(shared);
+            if zone.over_limit() {
+                zone.reclaim(shared, &key);
+            }
+        }
+    }
+
+    /// Sets the viewport (page coordinates) whose tiles are evicted last.
+    pub fn set_viewport(&self, visible: Rect) {
+        self.shared.inner.lock().visible = Some(visible);
+        if let Some(zone) = &self.shared.zone {
+            zone.touch(&self.shared);
+        }
+    }
+
+    /// Number of cached tiles.
+    pub fn len(&self) -> usize {
+        self.shared.inner.lock().entries.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Bytes of pixels held by this cache.
+    pub fn bytes(&self) -> u64 {
+        self.shared.inner.lock().bytes
+    }
+}
+
+impl Shared {
+    /// Evicts entries while `over` holds: off-screen entries before visible ones, least recently
+    /// used first. `keep` is never evicted.
+    fn evict(&self, inner: &mut Inner, keep: Option<&TileCacheKey>, over: impl Fn(&Inner) -> bool) {
+        if !over(inner) {
+            return;
+        }
+
+        let visible = inner.visible;
+        let mut order: Vec<(bool, u64, TileCacheKey)> = inner
+            .entries
+            .iter()
+            .filter(|(key, _)| Some(*key) != keep)
+            .map(|(key, e)| (visible.is_some_and(|v| e.rect.intersects(&v)), e.last_used, *key))
+            .collect();
+        order.sort_unstable();
+
+        for (_, _, key) in order {
+            if !over(inner) {
+                break;
+            }
+            let Some(entry) = inner.entries.remove(&key) else {
+                continue;
+            };
+            inner.bytes -= entry.bytes;
+            self.release(entry.bytes, 1);
+            EVICTIONS.fetch_add(1, Ordering::Relaxed);
+            if self.buffers.recycle(entry.tile.pixels) {
+                RECYCLED.fetch_add(1, Ordering::Relaxed);
+            }
+        }
+    }
+
+    fn charge(&self, bytes: u64) {
+        CACHED_BYTES.fetch_add(bytes, Ordering::Relaxed);
+        if let Some(zone) = &self.zone {
+            zone.used.fetch_add(bytes, Ordering::Relaxed);
+        }
+    }
+
+    fn release(&self, bytes: u64, tiles: u64) {
+        CACHED_BYTES.fetch_sub(bytes, Ordering::Relaxed);
+        CACHED_TILES.fetch_sub(tiles, Ordering::Relaxed);
+        if let Some(zone) = &self.zone {
+            zone.used.fetch_sub(bytes, Ordering::Relaxed);
+        }
+    }
+}
+
+impl Drop for TilePixelCache {
+    fn drop(&mut self) {
+        let inner = std::mem::take(&mut *self.shared.inner.lock());
+        self.shared.release(inner.bytes, inner.entries.len() as u64);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn pixels(len: usize) -> CachedTilePixels {
+        CachedTilePixels {
+            width: 1,
+            height: 1,
+            pixels: TilePixels::Cpu(bytes::Bytes::from(vec![0u8; len])),
+            format: PixelFormat::PreMulArgb32,
+        }
+    }
+
+    fn key(n: u64) -> TileCacheKey {
+        (0, n, 0, n)
+    }
+
+    fn rect_at(y: f64) -> Rect {
+        Rect::new(0.0, y, 256.0, 256.0)
+    }
+
+    #[test]
+    fn evicts_least_recently_used_over_budget() {
+        let cache = TilePixelCache::new(3000, None);
+        for n in 0..3 {
+            cache.insert(key(n), rect_at(n as f64 * 256.0), pixels(1000));
+        }
+        assert!(cache.get(&key(0)).is_some());
+        cache.insert(key(3), rect_at(768.0), pixels(1000));
+
+        assert_eq!(cache.len(), 3);
+        assert_eq!(cache.bytes(), 3000);
+        assert!(cache.get(&key(0)).is_some());
+        assert!(cache.get(&key(1)).is_none());
+    }
+
+    #[test]
+    fn visible_tiles_are_evicted_last() {
+        let cache = TilePixelCache::new(2000, None);
+        cache.set_viewport(Rect::new(0.0, 0.0, 800.0, 300.0));
+        cache.insert(key(0), rect_at(0.0), pixels(1000));
+        cache.insert(key(1), rect_at(4096.0), pixels(1000));
+        cache.insert(key(2), rect_at(8192.0), pixels(1000));
+
+        // The oldest entry is on screen, so the oldest off-screen one goes instead.
+        assert!(cache.get(&key(0)).is_some());
+        assert!(cache.get(&key(1)).is_none());
+        assert!(cache.get(&key(2)).is_some());
+    }
+
+    #[test]
+    fn zone_budget_is_shared_between_caches() {
+        let zone = Arc::new(TileCacheBudget::new(2000));
+        let a = TilePixelCache::new(u64::MAX, Some(Arc::clone(&zone)));
+        let b = TilePixelCache::new(u64::MAX, Some(Arc::clone(&zone)));
+        a.insert(key(0), rect_at(0.0), pixels(1000));
+        b.insert(key(0), rect_at(0.0), pixels(1000));
+        assert_eq!(zone.used(), 2000);
+
+        // Over the zone budget, the cache that was active least recently gives up its entries.
+        b.insert(key(1), rect_at(256.0), pixels(1000));
+        assert_eq!(zone.used(), 2000);
+        assert_eq!(a.len(), 0);
+        assert_eq!(b.len(), 2);
+
+        // Once the others are empty, the inserting cache evicts its own, but never the new tile.
+        b.insert(key(2), rect_at(512.0), pixels(1500));
+        assert_eq!(b.len(), 1);
+        assert!(b.get(&key(2)).is_some());
+
+        a.insert(key(0), rect_at(0.0), pixels(500));
+        drop(b);
+        assert_eq!(zone.used(), 500);
+    }
+
+    #[test]
+    fn replaced_buffers_are_recycled() {
+        let cache = TilePixelCache::new(u64::MAX, None);
+        cache.insert(key(0), rect_at(0.0), pixels(1000));
+        cache.insert(key(0), rect_at(0.0), pixels(1000));
+        assert_eq!(cache.len(), 1);
+        assert_eq!(cache.bytes(), 1000);
+        assert_eq!(cache.buffers().len(), 1);
+    }
+
+    #[test]
+    fn evicted_unshared_buffers_are_recycled() {
+        let cache = TilePixelCache::new(1000, None);
+        cache.insert(key(0), rect_at(0.0), pixels(1000));
+        let held = cache.get(&key(0));
+        cache.insert(key(1), rect_at(256.0), pixels(1000));
+        // Still referenced by `held`, so it can't be reused.
+        assert!(cache.buffers().is_empty());
+
+        drop(held);
+        cache.insert(key(2), rect_at(512.0), pixels(1000));
+        assert_eq!(cache.buffers().len(), 1);
+        let buf = cache.buffers().take(1000);
+        assert!(buf.is_empty() && buf.capacity() >= 1000);
+        assert!(cache.buffers().is_empty());
+    }
+}
@@ -1,8 +1,11 @@
 use crate::common::document::node::NodeId;
+use crate::common::document::pipeline_doc::PipelineDocument;
 use crate::common::document::style::{lookup, StyleProperty, Unit, Value};
 use crate::layouter::{LayoutElementId, LayoutElementNode, LayoutTree};
 use crate::render::backend::{StickyConstraint, TileAnchor};
 use parking_lot::RwLock;
+use rstar::primitives::{GeomWithData, Rectangle};
+use rstar::RTree;
 use std::collections::{HashMap, HashSet};
 use std::ops::AddAssign;
 use std::sync::Arc;
@@ -31,6 +34,10 @@ impl std::fmt::Display for LayerId {
     }
 }
 
+/// Hit-test index entry: an element's margin box, tagged with the element's position in the
+/// layer's paint order (higher paints later, so it is on top) and its id.
+type ElementBox = GeomWithData<Rectangle<[f64; 2]>, (usize, LayoutElementId)>;
+
 #[derive(Clone)]
 pub struct Layer {
     pub layer_id: LayerId,
@@ -42,6 +49,8 @@ pub struct Layer {
     /// How the layer responds to scroll - `Fixed` layers composite without the scroll offset.
     pub anchor: TileAnchor,
     pub elements: Vec<LayoutElementId>,
+    /// R* tree over the margin boxes of `elements`, built once the layer is complete
+    hit_index: RTree<ElementBox>,
 }
 
 impl Layer {
@@ -52,12 +61,51 @@ impl Layer {
             opacity: 1.0,
             anchor: TileAnchor::Scroll,
             elements: Vec::new(),
+            hit_index: RTree::new(),
         }
     }
 
     fn add_element(&mut self, element_id: LayoutElementId) {
         self.elements.push(element_id);
     }
+
+    /// Bulk-loads the hit-test index from the current `elements`. Empty boxes can never contain
+    /// a point, so they are left out.
+    fn build_index(&mut self, layout_tree: &LayoutTree) {
+        let boxes: Vec<ElementBox> = self
+            .elements
+            .iter()
+            .enumerate()
+            .filter_map(|(paint_order, &element_id)| {
+                let Some(element) = layout_tree.get_node_by_id(element_id) else {
+                    log::warn!("Layout element {:?} not found while indexing layer", element_id);
+                    return None;
+                };
+                let m = element.box_model.margin_box;
+                if m.width <= 0.0 || m.height <= 0.0 {
+                    return None;
+                }
+                Some(GeomWithData::new(
+                    Rectangle::from_corners([m.x, m.y], [m.x + m.width, m.y + m.height]),
+                    (paint_order, element_id),
+                ))
+            })
+            .collect();
+        self.hit_index = RTree::bulk_load(boxes);
+    }
+
+    /// Topmost element whose margin box contains the layer-space point `(x, y)`. Boxes are
+    /// half-open like the tiles: a point on the right or bottom edge is outside.
+    fn element_at(&self, x: f64, y: f64) -> Option<LayoutElementId> {
+        self.hit_index
+            .locate_all_at_point(&[x, y])
+            .filter(|entry| {
+                let upper = entry.geom().upper();
+                x < upper[0] && y < upper[1]
+            })
+            .max_by_key(|entry| entry.data.0)
+            .map(|entry| entry.data.1)
+    }
 }
 
 impl std::fmt::Debug for Layer {
@@ -76,6 +124,8 @@ pub struct LayerList {
     /// DOM nodes that must NOT get per-element opacity: their layer is faded once at composite
     /// time, so applying it twice would darken them. See [`LayerList::is_opacity_grouped`].
     opacity_group_nodes: RwLock<HashSet<NodeId>>,
+    /// The layer each element was assigned to. See [`LayerList::layer_of`].
+    element_layers: RwLock<HashMap<LayoutElementId, LayerId>>,
 }
 
 impl std::fmt::Debug for LayerList {
@@ -95,6 +145,7 @@ impl Clone for LayerList {
             layers: RwLock::new(self.layers.read().clone()),
             next_layer_id: RwLock::new(*self.next_layer_id.read()),
             opacity_group_nodes: RwLock::new(self.opacity_group_nodes.read().clone()),
+            element_layers: RwLock::new(self.element_layers.read().clone()),
         }
     }
 }
@@ -107,20 +158,32 @@ impl LayerList {
             layer_ids: RwLock::new(Vec::new()),
             next_layer_id: RwLock::new(LayerId::new(0)),
             opacity_group_nodes: RwLock::new(HashSet::new()),
+            element_layers: RwLock::new(HashMap::new()),
         };
 
         layer_list.generate_layers();
         layer_list
     }
 
-    /// @TODO: This must be done through rstar!
+    /// Points the render tree under `list` at `doc`, provided nothing else owns `list` or its
+    /// layout tree. Lets the engine edit a document in place while a finished render of it is
+    /// kept around for its geometry. Returns false, changing nothing, while another owner remains.
+    pub fn retarget_document(list: &mut Arc<Self>, doc: Arc<dyn PipelineDocument>) -> bool {
+        let Some(tree) = Arc::get_mut(list).and_then(|l| Arc::get_mut(&mut l.layout_tree)) else {
+            return false;
+        };
+        tree.render_tree.doc = doc;
+        true
+    }
+
     /// Topmost element at the given viewport coordinates. Element boxes are in page space, so a
     /// scrolling layer is hit-tested at `viewport + scroll`, a `fixed` layer at the raw viewport.
     pub fn find_element_at(&self, vp_x: f64, vp_y: f64, scroll_x: f64, scroll_y: f64) -> Option<LayoutElementId> {
+        let layers = self.layers.read();
+
         // This assumes that the layers are ordered from top to bottom
         for layer_id in self.layer_ids.read().iter().rev() {
-            let binding = self.layers.read();
-            let Some(layer) = binding.get(layer_id) else {
+            let Some(layer) = layers.get(layer_id) else {
                 continue;
             };
 
@@ -135,27 +198,19 @@ impl LayerList {
                 }
             };
 
-            for element_id in layer.elements.iter().rev() {
-                let Some(layout_element) = self.layout_tree.get_node_by_id(*element_id) else {
-                    log::warn!("Layout element {:?} not found during hit test", element_id);
-                    continue;
-                };
-                let box_model = &layout_element.box_model;
-
-                // @TODO: use rtree for this
-                if x >= box_model.margin_box.x
-                    && x < box_model.margin_box.x + box_model.margin_box.width
-                    && y >= box_model.margin_box.y
-                    && y < box_model.margin_box.y + box_model.margin_box.height
-                {
-                    return Some(*element_id);
-                }
+            if let Some(element_id) = layer.element_at(x, y) {
+                return Some(element_id);
             }
         }
 
         None
     }
 
+    /// The layer `element_id` was assigned to, or `None` if it is not in any layer.
+    pub fn layer_of(&self, element_id: LayoutElementId) -> Option<LayerId> {
+        self.element_layers.read().get(&element_id).copied()
+    }
+
     /// Sticky constraint for a `position: sticky` element, else `None`. The cage should be the
     /// containing block's content box; we approximate it with the parent's, as there are no
     /// sub-scroll-containers yet. A root sticky element gets a zero-slack cage and never sticks.
@@ -231,6 +286,7 @@ impl LayerList {
         if let Some(mut layers) = self.get_layer_mut(layer_id) {
             if let Some(layer) = layers.get_mut(&layer_id) {
                 layer.add_element(element_id);
+                self.element_layers.write().insert(element_id, layer_id);
             } else {
                 log::warn!("Layer {} not found in HashMap", layer_id);
             }
@@ -248,6 +304,7 @@ impl LayerList {
 
     fn generate_layers(&mut self) {
         self.layers.write().clear();
+        self.element_layers.write().clear();
 
         let root_id = self.layout_tree.root_id;
         let default_layer_id = self.new_layer(0);
@@ -257,10 +314,14 @@ impl LayerList {
         // Composite order = stacking order. Sort layers by their `order` (z-index level); the sort is
         // stable, so layers at the same level keep DOM/creation order (the correct tie-break for
         // equal z-index). The compositor and hit-test both walk `layer_ids` in this order.
-        let layers = self.layers.read();
+        let mut layers = self.layers.write();
         self.layer_ids
             .write()
             .sort_by_key(|id| layers.get(id).map(|l| l.order).unwrap_or(0));
+
+        for layer in layers.values_mut() {
+            layer.build_index(&self.layout_tree);
+        }
     }
 
     /// Walk the layout tree assigning each element to a layer. An element is *promoted* to its own
@@ -1,11 +1,12 @@
 use crate::common::document::node::NodeId as DomNodeId;
+use crate::common::document::pipeline_doc::pseudo_owner;
 use crate::common::font::FontInfo;
-use crate::common::geo::{Coordinate, Dimension};
+use crate::common::geo::{Coordinate, Dimension, Rect};
 use crate::common::media::MediaId;
 use crate::layouter::box_model::BoxModel;
 use crate::rendertree_builder::{RenderNodeId, RenderTree};
 use parking_lot::RwLock;
-use std::collections::HashMap;
+use std::collections::{HashMap, HashSet};
 use std::ops::AddAssign;
 use std::sync::Arc;
 
@@ -41,7 +42,7 @@ impl std::fmt::Display for LayoutElementId {
     }
 }
 
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, PartialEq)]
 pub struct ElementContextText {
     pub node_id: DomNodeId,
     pub font_info: FontInfo,
@@ -56,7 +57,7 @@ pub struct ElementContextText {
     pub available_width: f64,
 }
 
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, PartialEq)]
 pub struct ElementContextSvg {
     pub node_id: DomNodeId,
     pub src: String,
@@ -65,7 +66,7 @@ pub struct ElementContextSvg {
     pub dimension: Dimension,
 }
 
-#[derive(Clone, Debug)]
+#[derive(Clone, Debug, PartialEq)]
 pub struct ElementContextImage {
     pub node_id: DomNodeId,
     pub src: String,
@@ -83,7 +84,7 @@ pub struct ElementContextImage {
 }
 
 /// Per-element data (text, image, svg) needed by later phases of the rendering pipeline.
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, PartialEq)]
 pub enum ElementContext {
     None,
     Text(ElementContextText),
@@ -157,7 +158,7 @@ pub struct LayoutElementNode {
 /// A resolved CSS `background-image` and its media kind. The painter finalizes tile geometry once
 /// the border box is known. A tiling SVG is rasterized to an `Image` during layout so only one
 /// tiling path exists downstream; a `cover`/`contain` SVG stays `Svg`.
-#[derive(Debug, Clone, Copy)]
+#[derive(Debug, Clone, Copy, PartialEq)]
 pub enum BackgroundMedia {
     Image {
         media_id: MediaId,
@@ -192,6 +193,51 @@ impl LayoutTree {
         *nid += 1;
         id
     }
+
+    /// Page areas that may render differently in `self` than in `prev`: the boxes of elements
+    /// for `damaged` DOM nodes (and their pseudo-elements), plus the old and new boxes of every
+    /// element that moved, resized, appeared or disappeared. Tiles outside these rects can be
+    /// reused as they are.
+    pub fn changed_rects(&self, prev: &LayoutTree, damaged: &HashSet<DomNodeId>) -> Vec<Rect> {
+        /// Union of the margin boxes of each DOM node's layout elements, and their count
+        fn boxes(tree: &LayoutTree) -> HashMap<DomNodeId, (Rect, usize)> {
+            let mut out: HashMap<DomNodeId, (Rect, usize)> = HashMap::with_capacity(tree.arena.len());
+            for el in tree.arena.values() {
+                let m = el.box_model.margin_box;
+                out.entry(el.dom_node_id)
+                    .and_modify(|(r, n)| {
+                        *r = r.union(&m);
+                        *n += 1;
+                    })
+                    .or_insert((m, 1));
+            }
+            out
+        }
+
+        let is_damaged =
+            |id: &DomNodeId| damaged.contains(id) || pseudo_owner(*id).is_some_and(|o| damaged.contains(&o));
+
+        let old = boxes(prev);
+        let new = boxes(self);
+        let mut rects = Vec::new();
+        for (id, entry) in &new {
+            match old.get(id) {
+                Some(prev_entry) if prev_entry == entry && !is_damaged(id) => {}
+                Some((prev_rect, _)) => {
+                    rects.push(*prev_rect);
+                    rects.push(entry.0);
+                }
+                None => rects.push(entry.0),
+            }
+        }
+        for (id, (rect, _)) in &old {
+            if !new.contains_key(id) {
+                rects.push(*rect);
+            }
+        }
+        rects.retain(|r| r.width > 0.0 && r.height > 0.0);
+        rects
+    }
 }
 
 impl std::fmt::Debug for LayoutTree {
@@ -1,7 +1,7 @@
 use crate::common::geo;
 
 /// Represents the thickness (or spacing) on each side.
-#[derive(Debug, Clone, Copy)]
+#[derive(Debug, Clone, Copy, PartialEq)]
 pub struct Edges {
     pub top: f64,
     pub right: f64,
@@ -10,7 +10,7 @@ pub struct Edges {
 }
 
 /// Represents a boxmodel of an element.
-#[derive(Clone, Copy)]
+#[derive(Clone, Copy, PartialEq)]
 pub struct BoxModel {
     pub content_box: geo::Rect,
     pub padding_box: geo::Rect,
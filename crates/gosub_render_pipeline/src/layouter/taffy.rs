@@ -16,10 +16,11 @@ use crate::layouter::{
     box_model, BackgroundMedia, CanLayout, ElementContext, ElementContextImage, ElementContextSvg, ElementContextText,
     LayoutElementId, LayoutElementNode, LayoutTree,
 };
+use crate::painter::compute_bg_tiling;
 use crate::rendertree_builder::{RenderNodeId, RenderTree};
 use gosub_fontmanager::ParleyFontSystem;
 use gosub_interface::font_system::FontSystem;
-use parking_lot::{Mutex, RwLock};
+use parking_lot::RwLock;
 use std::borrow::Borrow;
 use std::collections::HashMap;
 use std::sync::Arc;
@@ -37,10 +38,6 @@ fn parse_px_attr(v: &str) -> Option<f32> {
     s.trim().parse::<f32>().ok().filter(|n| *n >= 0.0)
 }
 
-// Cache key: (text, font_family, size_bits, line_height_bits, weight, max_width_bits,
-// letter_spacing_bits). Floats are stored as their bit pattern so the tuple is Hash + Eq.
-type MeasureKey = (String, String, u32, u32, i32, u32, u32);
-
 /// CSS `text-align` on a block, as `justify_content` for the anonymous flex containers holding its
 /// line boxes. A line box *is* that container, so this is what positions a run too short to fill it
 /// - a run that wraps already fills the line and is aligned by the shaper instead.
@@ -66,10 +63,38 @@ enum InlineEntry {
     Break(f64),
 }
 
+/// Identifies a taffy node across layout passes, so the next pass can find and update it instead
+/// of building a new one. Layout element ids are handed out afresh on every pass; DOM node ids
+/// are not.
+#[derive(Clone, Copy, Debug, PartialEq, Eq, Hash)]
+enum TaffyKey {
+    /// The box generated for a DOM node
+    Node(DomNodeId),
+    /// The n-th word (or space) box a text node is split into in a mixed inline run
+    Word(DomNodeId, usize),
+    /// An anonymous line box of a block, by its position among the block's taffy children
+    Line(DomNodeId, usize),
+}
+
 /// Layouter structure that uses taffy as layout engine
+///
+/// The taffy tree outlives a layout pass: the next pass updates the nodes whose style, context or
+/// children changed, which marks only them and their ancestors dirty. Everything else keeps
+/// taffy's per-node layout cache, so relayout after a small change skips the untouched subtrees.
 pub struct TaffyLayouter {
     tree: TaffyTree<TaffyContext>,
     root_id: TaffyNodeId,
+    /// Taffy nodes built or reused by the current pass
+    nodes: HashMap<TaffyKey, TaffyNodeId>,
+    /// Taffy nodes of the previous pass that this pass has not reused (yet). Removed from the
+    /// tree when the pass ends.
+    prev_nodes: HashMap<TaffyKey, TaffyNodeId>,
+    /// Nodes whose key was already taken in the current pass. They cannot be found again, so the
+    /// next pass removes them.
+    unkeyed: Vec<TaffyNodeId>,
+    /// The children each node of the current pass should end up with. Applied once every node
+    /// exists, see `sync_children`.
+    pending_children: Vec<(TaffyNodeId, Vec<TaffyNodeId>)>,
     layout_taffy_mapping: HashMap<LayoutElementId, TaffyNodeId>,
     /// Maps each layout element that lives inside an anonymous flex container to that
     /// container's taffy node id. The anonymous container exists in the taffy tree (between
@@ -80,13 +105,10 @@ pub struct TaffyLayouter {
     /// Media store for loading images/SVGs during layout. Shared (Arc) so the media loaded
     /// here is visible to the rasterization stage, which looks resources up by the same id.
     media_store: Arc<MediaStore>,
-    /// Locked once per measurement call rather than across the whole layout pass, so other
-    /// threads (e.g. the rasterizer) can access the font collection between calls. `dyn` so the
-    /// same instance can be shared with the rasterizer and swapped for a non-Parley impl.
-    font_system: Arc<Mutex<dyn FontSystem>>,
-    /// Taffy calls the measure function 2-4× per node (MinContent, MaxContent, actual width);
-    /// memoizing eliminates the redundant Parley shaping calls.
-    measure_cache: HashMap<MeasureKey, Size<f32>>,
+    /// Shared with the rasterizer (and any other layouter) as-is, without a lock: the font system
+    /// is `Sync` and keeps its shaping state per thread, so measurements the shape cache misses
+    /// run concurrently with rasterization. `dyn` so a non-Parley impl can be swapped in.
+    font_system: Arc<dyn FontSystem>,
     /// Reverse index used by the table post-processing pass.
     dom_to_layout_mapping: HashMap<DomNodeId, LayoutElementId>,
 }
@@ -122,7 +144,7 @@ fn apply_text_transform(text: String, transform: Value) -> String {
 }
 
 /// Context structures to pass to taffy measure functions so we can calculate the size of the text or images.
-#[derive(Clone, Debug)]
+#[derive(Clone, Debug, PartialEq)]
 pub enum TaffyContext {
     Text(ElementContextText),
     Image(ElementContextImage),
@@ -187,25 +209,28 @@ impl TaffyLayouter {
     /// To share the font collection with other components (e.g. a `VelloRasterizer`)
     /// use [`TaffyLayouter::with_font_system`] and pass the same `Arc` to both.
     pub fn new() -> Self {
-        Self::with_font_system(Arc::new(Mutex::new(ParleyFontSystem::new())))
+        Self::with_font_system(Arc::new(ParleyFontSystem::new()))
     }
 
     /// Create a layouter that shares an existing font system.
-    pub fn with_font_system(font_system: Arc<Mutex<dyn FontSystem>>) -> Self {
+    pub fn with_font_system(font_system: Arc<dyn FontSystem>) -> Self {
         Self {
-            tree: TaffyTree::new(),
+            tree: new_taffy_tree(),
             root_id: TaffyNodeId::new(0),
+            nodes: HashMap::new(),
+            prev_nodes: HashMap::new(),
+            unkeyed: Vec::new(),
+            pending_children: Vec::new(),
             layout_taffy_mapping: HashMap::new(),
             anon_container_map: HashMap::new(),
             media_store: Arc::new(MediaStore::new()),
             font_system,
-            measure_cache: HashMap::new(),
             dom_to_layout_mapping: HashMap::new(),
         }
     }
 
     /// Expose the font system so callers can share it with other components.
-    pub fn font_system(&self) -> Arc<Mutex<dyn FontSystem>> {
+    pub fn font_system(&self) -> Arc<dyn FontSystem> {
         Arc::clone(&self.font_system)
     }
 
@@ -221,11 +246,35 @@ impl TaffyLayouter {
         Arc::clone(&self.media_store)
     }
 
+    /// Drops the taffy tree kept from earlier passes, so the next layout starts from scratch.
+    pub fn reset_tree(&mut self) {
+        self.tree = new_taffy_tree();
+        self.nodes.clear();
+        self.prev_nodes.clear();
+        self.unkeyed.clear();
+    }
+
+    /// Number of nodes in the retained taffy tree
+    pub fn taffy_node_count(&self) -> usize {
+        self.tree.total_node_count()
+    }
+
     pub fn print_tree(&mut self) {
         self.tree.print_tree(self.root_id);
     }
 }
 
+fn new_taffy_tree() -> TaffyTree<TaffyContext> {
+    let mut tree = TaffyTree::new();
+    // Taffy's built-in rounding snaps layout values to integer CSS pixels, which causes
+    // text containers to lose sub-pixel width (e.g. 52.344 → 52.0). This makes pango
+    // render at a surface too narrow for the text and produces spurious line wraps.
+    // Our renderer handles DPR scaling itself via ceil(width) * dpr, so we disable
+    // taffy's rounding here.
+    tree.disable_rounding();
+    tree
+}
+
 impl CanLayout for TaffyLayouter {
     fn layout(
         &mut self,
@@ -256,10 +305,9 @@ impl CanLayout for TaffyLayouter {
             None => Size::MAX_CONTENT,
         };
 
-        // Clone the Arc and take the measure cache so the closure can capture them
-        // without holding a borrow of `self` while `self.tree` is mutably borrowed.
+        // Clone the Arc so the closure can capture it without holding a borrow of `self` while
+        // `self.tree` is mutably borrowed.
         let font_system = Arc::clone(&self.font_system);
-        let mut measure_cache: HashMap<MeasureKey, Size<f32>> = std::mem::take(&mut self.measure_cache);
 
         if let Err(e) = self
             .tree
@@ -282,26 +330,11 @@ impl CanLayout for TaffyLayouter {
                             }
                         };
 
-                        let cache_key: MeasureKey = (
-                            text_ctx.text.clone(),
-                            text_ctx.font_info.family.clone(),
-                            (text_ctx.font_info.size as f32).to_bits(),
-                            (text_ctx.font_info.line_height as f32).to_bits(),
-                            text_ctx.font_info.weight,
-                            (max_width as f32).to_bits(),
-                            (text_ctx.font_info.letter_spacing as f32).to_bits(),
-                        );
-                        if let Some(&cached) = measure_cache.get(&cache_key) {
-                            return cached;
-                        }
-
-                        // Measure through the shared font system. The lock is released
-                        // immediately after the call so other callers (e.g. the
-                        // rasterizer) can interleave without contention.
-                        let text_layout = {
-                            let mut fs = font_system.lock();
-                            get_text_layout(text_ctx.text.as_str(), &text_ctx.font_info, max_width, &mut *fs)
-                        };
+                        // Taffy calls the measure function 2-4× per node (MinContent,
+                        // MaxContent, actual width); the shape cache answers the repeats without
+                        // locking the font system.
+                        let text_layout =
+                            get_text_layout(text_ctx.text.as_str(), &text_ctx.font_info, max_width, &font_system);
                         match text_layout {
                             Ok(text_layout) => {
                                 // Ceil width to the nearest CSS pixel. Parley returns a fractional
@@ -328,7 +361,6 @@ impl CanLayout for TaffyLayouter {
                                     // that pango creates (prevents descenders from overflowing the box).
                                     height: text_layout.height.ceil() as f32,
                                 };
-                                measure_cache.insert(cache_key, result);
                                 result
                             }
                             Err(_) => Size::ZERO,
@@ -347,10 +379,8 @@ impl CanLayout for TaffyLayouter {
             })
         {
             log::error!("Failed to compute taffy layout: {:?}", e);
-            self.measure_cache = measure_cache;
             return layout_tree;
         }
-        self.measure_cache = measure_cache;
 
         // Since we are not interested in taffy layout after this stage in the pipeline, we convert
         // the taffy layout to a box model layout tree. This makes the rest of the pipeline
@@ -359,6 +389,7 @@ impl CanLayout for TaffyLayouter {
         let root_width = layout_tree.root_dimension.width;
         self.populate_boxmodel(&mut layout_tree, root_id, Coordinate::ZERO, root_width);
         post_process_tables(&mut layout_tree, &self.dom_to_layout_mapping);
+        self.note_image_display_sizes(&layout_tree);
 
         if let Some(root) = layout_tree.get_node_by_id(root_id) {
             let w = root.box_model.margin_box.width as f32;
@@ -371,6 +402,32 @@ impl CanLayout for TaffyLayouter {
 }
 
 impl TaffyLayouter {
+    /// Tell the media store how large every raster image ends up on the page, so images laid out
+    /// smaller than their natural size are redecoded at the size they are drawn at.
+    fn note_image_display_sizes(&self, layout_tree: &LayoutTree) {
+        for el in layout_tree.arena.values() {
+            let border_box = el.box_model.border_box;
+            if let ElementContext::Image(ctx) = &el.context {
+                if !ctx.placeholder {
+                    self.media_store
+                        .note_display_size(ctx.media_id, border_box.width as f32, border_box.height as f32);
+                }
+            }
+            if let Some(BackgroundMedia::Image {
+                media_id,
+                natural,
+                layout,
+            }) = &el.background_media
+            {
+                let (w, h) = (border_box.width as f32, border_box.height as f32);
+                // Without a tiling the image is stretched over the border box.
+                let size = compute_bg_tiling(*natural, layout, w, h).map_or((w, h), |t| t.tile_size);
+                self.media_store.note_display_size(*media_id, size.0, size.1);
+            }
+        }
+        self.media_store.apply_display_sizes();
+    }
+
     fn populate_boxmodel(
         &self,
         layout_tree: &mut LayoutTree,
@@ -441,14 +498,9 @@ impl TaffyLayouter {
     }
 
     fn generate_tree(&mut self, render_tree: RenderTree, root_id: RenderNodeId) -> LayoutTree {
-        self.measure_cache.clear();
-        self.tree = TaffyTree::new();
-        // Taffy's built-in rounding snaps layout values to integer CSS pixels, which causes
-        // text containers to lose sub-pixel width (e.g. 52.344 → 52.0). This makes pango
-        // render at a surface too narrow for the text and produces spurious line wraps.
-        // Our renderer handles DPR scaling itself via ceil(width) * dpr, so we disable
-        // taffy's rounding here.
-        self.tree.disable_rounding();
+        self.prev_nodes = std::mem::take(&mut self.nodes);
+        let stale_unkeyed = std::mem::take(&mut self.unkeyed);
+        self.pending_children.clear();
         self.root_id = TaffyNodeId::new(0); // Will be filled in later
         self.layout_taffy_mapping.clear();
         self.anon_container_map.clear();
@@ -462,8 +514,9 @@ impl TaffyLayouter {
             root_dimension: geo::Dimension::ZERO,
         };
 
-        let Some((layout_element_root_id, taffy_root_id)) = self.generate_taffy_element(&mut layout_tree, root_id)
-        else {
+        let generated = self.generate_taffy_element(&mut layout_tree, root_id);
+        self.sync_children(stale_unkeyed);
+        let Some((layout_element_root_id, taffy_root_id)) = generated else {
             log::error!("Failed to generate taffy element for root node {:?}", root_id);
             return layout_tree;
         };
@@ -474,6 +527,71 @@ impl TaffyLayouter {
         layout_tree
     }
 
+    /// Returns the node `key` had in the previous pass, updated to `style` and `context`, or a
+    /// new node if it had none. An update marks the node (and its ancestors) dirty only when the
+    /// style or context actually differs.
+    fn retained_leaf(&mut self, key: TaffyKey, style: Style, context: Option<TaffyContext>) -> Option<TaffyNodeId> {
+        let id = match self.prev_nodes.remove(&key) {
+            Some(id) => {
+                if self.tree.style(id).ok() != Some(&style) {
+                    if let Err(e) = self.tree.set_style(id, style) {
+                        log::warn!("Failed to update taffy style: {:?}", e);
+                    }
+                }
+                if self.tree.get_node_context(id) != context.as_ref() {
+                    if let Err(e) = self.tree.set_node_context(id, context) {
+                        log::warn!("Failed to update taffy node context: {:?}", e);
+                    }
+                }
+                id
+            }
+            None => match context {
+                Some(ctx) => self.tree.new_leaf_with_context(style, ctx).ok()?,
+                None => self.tree.new_leaf(style).ok()?,
+            },
+        };
+        if let Some(shadowed) = self.nodes.insert(key, id) {
+            self.unkeyed.push(shadowed);
+        }
+        Some(id)
+    }
+
+    /// Ends a pass: removes the previous pass's nodes that were not reused, then gives every
+    /// node whose children changed its new children. Running this after all nodes exist lets a
+    /// reused node move to a new parent; unchanged parents are left alone (and clean).
+    fn sync_children(&mut self, stale_unkeyed: Vec<TaffyNodeId>) {
+        let stale: Vec<TaffyNodeId> = self.prev_nodes.drain().map(|(_, id)| id).chain(stale_unkeyed).collect();
+        for id in stale {
+            // The parent's remaining children may equal what this pass wants, in which case it is
+            // not updated below; it still has to be laid out again without this child.
+            if let Some(parent) = self.tree.parent(id) {
+                if let Err(e) = self.tree.mark_dirty(parent) {
+                    log::warn!("Failed to mark taffy node dirty: {:?}", e);
+                }
+            }
+            if let Err(e) = self.tree.remove(id) {
+                log::warn!("Failed to remove stale taffy node: {:?}", e);
+            }
+        }
+
+        let changed: Vec<(TaffyNodeId, Vec<TaffyNodeId>)> = std::mem::take(&mut self.pending_children)
+            .into_iter()
+            .filter(|(parent, children)| self.tree.children(*parent).map_or(true, |current| current != *children))
+            .collect();
+        // Detach first: setting a parent's children clears the parent link of its old ones, which
+        // would undo an earlier move of one of them to a parent processed before it.
+        for (parent, _) in &changed {
+            if let Err(e) = self.tree.set_children(*parent, &[]) {
+                log::warn!("Failed to detach taffy children: {:?}", e);
+            }
+        }
+        for (parent, children) in &changed {
+            if let Err(e) = self.tree.set_children(*parent, children) {
+                log::warn!("Failed to add children to taffy tree: {:?}", e);
+            }
+        }
+    }
+
     // Process inline elements by adding them to the taffy tree, wrapped in anonymous flex
     // containers. A run with no `<br>` produces a single wrapping container (the old behaviour); a
     // run containing `<br>` is split into one container per line box, which the block parent stacks
@@ -482,7 +600,7 @@ impl TaffyLayouter {
         &mut self,
         current_inline_group: &[InlineEntry],
         element_node: &mut LayoutElementNode,
-        leaf_id: TaffyNodeId,
+        taffy_children: &mut Vec<TaffyNodeId>,
         justify: Option<taffy::JustifyContent>,
     ) {
         log::debug!("Processing inline elements: {:?}", current_inline_group.len());
@@ -500,16 +618,16 @@ impl TaffyLayouter {
                 InlineEntry::Item(id, taffy) => segment.push((*id, *taffy)),
                 InlineEntry::Break(lh) => {
                     if segment.is_empty() {
-                        self.emit_line(&[], Some(*lh), element_node, leaf_id, justify);
+                        self.emit_line(&[], Some(*lh), element_node, taffy_children, justify);
                     } else {
-                        self.emit_line(&segment, None, element_node, leaf_id, justify);
+                        self.emit_line(&segment, None, element_node, taffy_children, justify);
                         segment.clear();
                     }
                 }
             }
         }
         if !segment.is_empty() {
-            self.emit_line(&segment, None, element_node, leaf_id, justify);
+            self.emit_line(&segment, None, element_node, taffy_children, justify);
         }
     }
 
@@ -521,7 +639,7 @@ impl TaffyLayouter {
         items: &[(LayoutElementId, TaffyNodeId)],
         empty_line_height: Option<f64>,
         element_node: &mut LayoutElementNode,
-        leaf_id: TaffyNodeId,
+        taffy_children: &mut Vec<TaffyNodeId>,
         justify: Option<taffy::JustifyContent>,
     ) {
         // All inline elements (even a single one) are wrapped in an anonymous flex container.
@@ -557,23 +675,22 @@ impl TaffyLayouter {
             }
         }
 
-        let Ok(taffy_container_id) = self.tree.new_leaf(style) else {
+        let key = TaffyKey::Line(element_node.dom_node_id, taffy_children.len());
+        let Some(taffy_container_id) = self.retained_leaf(key, style, None) else {
             return;
         };
-        if let Err(e) = self.tree.add_child(leaf_id, taffy_container_id) {
-            log::warn!("Failed to add anonymous container to taffy tree: {:?}", e);
-        }
+        taffy_children.push(taffy_container_id);
 
+        let mut line_children = Vec::with_capacity(items.len());
         for (inline_layout_element_id, inline_taffy_node_id) in items {
-            if let Err(e) = self.tree.add_child(taffy_container_id, *inline_taffy_node_id) {
-                log::warn!("Failed to add inline child to taffy tree: {:?}", e);
-            }
+            line_children.push(*inline_taffy_node_id);
             element_node.children.push(*inline_layout_element_id);
             // Record that this layout element sits inside an anonymous container so that
             // populate_boxmodel can add the container's taffy-computed offset.
             self.anon_container_map
                 .insert(*inline_layout_element_id, taffy_container_id);
         }
+        self.pending_children.push((taffy_container_id, line_children));
     }
 
     /// Split a text node in a *mixed* inline run (alongside inline-level elements) into one inline
@@ -620,10 +737,10 @@ impl TaffyLayouter {
             tokens.push(" ".to_string());
         }
 
-        for tok in tokens {
+        for (index, tok) in tokens.into_iter().enumerate() {
             let mut token_node = text_node.clone();
             token_node.node_type = NodeType::Text(tok);
-            if let Some(pair) = self.build_text_word_leaf(layout_tree, &token_node, render_node_id) {
+            if let Some(pair) = self.build_text_word_leaf(layout_tree, &token_node, render_node_id, index) {
                 group.push(InlineEntry::Item(pair.0, pair.1));
             }
         }
@@ -637,13 +754,12 @@ impl TaffyLayouter {
         layout_tree: &mut LayoutTree,
         word_node: &Node,
         render_node_id: RenderNodeId,
+        index: usize,
     ) -> Option<(LayoutElementId, TaffyNodeId)> {
         let (taffy_context, taffy_style) = self.extract_taffy_data(layout_tree, word_node)?;
         let element_context = to_element_context(taffy_context.as_ref());
-        let taffy_id = match taffy_context {
-            Some(ctx) => self.tree.new_leaf_with_context(taffy_style, ctx).ok()?,
-            None => self.tree.new_leaf(taffy_style).ok()?,
-        };
+        let taffy_id = self.retained_leaf(TaffyKey::Word(word_node.node_id, index), taffy_style, taffy_context)?;
+        self.pending_children.push((taffy_id, Vec::new()));
         let element_node = LayoutElementNode {
             id: layout_tree.next_node_id(),
             dom_node_id: word_node.node_id,
@@ -695,14 +811,8 @@ impl TaffyLayouter {
             None => to_element_context(None),
         };
 
-        let result = match taffy_context {
-            Some(ctx) => self.tree.new_leaf_with_context(taffy_style.to_owned(), ctx),
-            None => self.tree.new_leaf(taffy_style.to_owned()),
-        };
-
-        let Ok(leaf_id) = result else {
-            return None;
-        };
+        let leaf_id = self.retained_leaf(TaffyKey::Node(dom_node.node_id), taffy_style, taffy_context)?;
+        let mut taffy_children = Vec::new();
 
         let background_media = self.resolve_background_media(layout_tree, dom_node.node_id);
 
@@ -778,9 +888,7 @@ impl TaffyLayouter {
                         }
                     }
                 }
-                if let Err(e) = self.tree.add_child(leaf_id, child_taffy_id) {
-                    log::warn!("Failed to add child to taffy tree: {:?}", e);
-                }
+                taffy_children.push(child_taffy_id);
                 element_node.children.push(child_layout_element_id);
                 continue;
             }
@@ -836,19 +944,28 @@ impl TaffyLayouter {
 
             // Strip trailing whitespace before flushing, then flush.
             current_inline_group.truncate(current_inline_group.len().saturating_sub(trailing_ws_count));
-            self.process_inlines(&current_inline_group, &mut element_node, leaf_id, line_justify);
+            self.process_inlines(
+                &current_inline_group,
+                &mut element_node,
+                &mut taffy_children,
+                line_justify,
+            );
             current_inline_group = Vec::new();
             trailing_ws_count = 0;
 
-            if let Err(e) = self.tree.add_child(leaf_id, child_taffy_id) {
-                log::warn!("Failed to add child to taffy tree: {:?}", e);
-            }
+            taffy_children.push(child_taffy_id);
             element_node.children.push(child_layout_element_id);
         }
 
         // Strip trailing whitespace and deal with any remaining inline elements
         current_inline_group.truncate(current_inline_group.len().saturating_sub(trailing_ws_count));
-        self.process_inlines(&current_inline_group, &mut element_node, leaf_id, line_justify);
+        self.process_inlines(
+            &current_inline_group,
+            &mut element_node,
+            &mut taffy_children,
+            line_justify,
+        );
+        self.pending_children.push((leaf_id, taffy_children));
 
         // The layout-tree is the structure handed to the rest of the pipeline; taffy stays
         // internal to this layouter so other layout engines can be swapped in.
@@ -903,7 +1020,7 @@ impl TaffyLayouter {
         match &*self.media_store.get(media_id, MediaType::Image) {
             Media::Image(mi) => Some(BackgroundMedia::Image {
                 media_id,
-                natural: (mi.image.width() as f32, mi.image.height() as f32),
+                natural: (mi.natural_size().0 as f32, mi.natural_size().1 as f32),
                 layout,
             }),
             Media::Svg(ms) => {
@@ -980,18 +1097,10 @@ impl TaffyLayouter {
                                     let d = if is_placeholder {
                                         geo::Dimension::new(32.0, 32.0)
                                     } else {
-                                        geo::Dimension::new(
-                                            media_image.image.width() as f64,
-                                            media_image.image.height() as f64,
-                                        )
+                                        let (w, h) = media_image.natural_size();
+                                        geo::Dimension::new(w as f64, h as f64)
                                     };
-                                    // `.all()` short-circuits on the first opaque pixel, so this is
-                                    // cheap for the common (visible) image and only scans fully when
-                                    // the image really is transparent.
-                                    let transparent = !is_placeholder
-                                        && media_image.image.width() > 0
-                                        && media_image.image.as_raw().chunks_exact(4).all(|px| px[3] == 0);
-                                    (d, false, transparent)
+                                    (d, false, !is_placeholder && media_image.is_transparent())
                                 }
                             };
 
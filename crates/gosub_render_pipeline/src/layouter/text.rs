@@ -1,15 +1,18 @@
 use crate::common::font::FontInfo;
 use crate::common::geo::Dimension;
+use crate::common::shape_cache::ShapeCache;
 use gosub_interface::font::FontStyle;
 use gosub_interface::font_system::{FontStretch, FontSystem, FontWeight, TextAlign, TextStyle};
+use std::sync::Arc;
 
 /// Measure `text`'s bounding box via the configured [`FontSystem`], so layout boxes are sized by
-/// the same engine that will draw the text.
+/// the same engine that will draw the text. Goes through the global [`ShapeCache`], which only
+/// locks the font system for text it has not measured before.
 pub fn get_text_layout(
     text: &str,
     font_info: &FontInfo,
     max_width: f64,
-    font_system: &mut dyn FontSystem,
+    font_system: &Arc<dyn FontSystem>,
 ) -> Result<Dimension, anyhow::Error> {
     let style = TextStyle {
         family: font_info.family.clone(),
@@ -27,7 +30,7 @@ pub fn get_text_layout(
         display_scale: 1.0,
     };
 
-    let (width, height) = font_system.measure(text, &style);
+    let (width, height) = ShapeCache::global().measure(font_system, text, &style);
 
     Ok(Dimension {
         width: width as f64,
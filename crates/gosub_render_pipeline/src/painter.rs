@@ -1,4 +1,5 @@
 pub mod commands;
+pub mod display_list;
 
 use crate::common::browser_state::{BrowserState, WireframeState};
 use crate::common::document::node::NodeId;
@@ -7,6 +8,7 @@ use crate::common::document::style::{lookup, BorderStyle as CssBorderStyle, Disp
 use crate::common::font::{FontAlignment, FontInfo};
 use crate::common::geo::Rect;
 use crate::common::media::MediaStore;
+use crate::common::shape_cache::ShapeCache;
 use crate::layering::layer::LayerList;
 use crate::layouter::{BackgroundMedia, ElementContext, LayoutElementId, LayoutElementNode};
 use crate::painter::commands::border::{Border, BorderStyle};
@@ -20,7 +22,6 @@ use crate::render::backend::TileAnchor;
 use crate::tiler::TiledLayoutElement;
 use gosub_interface::font::FontStyle;
 use gosub_interface::font_system::{FontStretch, FontSystem, FontWeight, ShapedText, TextAlign, TextStyle};
-use parking_lot::Mutex;
 use std::sync::Arc;
 
 /// A whole-viewport paint command list for the GPU-scene path, translated by a backend's `render`
@@ -74,27 +75,28 @@ pub struct Painter {
     /// The same instance the layouter measured with; text is shaped here once at command-build
     /// time. `None` (e.g. the null backend) yields empty glyph runs, drawable only by
     /// engine-native text rasterizers.
-    font_system: Option<Arc<Mutex<dyn FontSystem>>>,
+    font_system: Option<Arc<dyn FontSystem>>,
 }
 
 impl Painter {
-    pub fn new(layer_list: Arc<LayerList>, font_system: Option<Arc<Mutex<dyn FontSystem>>>) -> Painter {
+    pub fn new(layer_list: Arc<LayerList>, font_system: Option<Arc<dyn FontSystem>>) -> Painter {
         Painter {
             layer_list,
             font_system,
         }
     }
 
-    /// Shape `text` into the positioned glyph runs a glyph-based rasterizer will paint.
-    fn shape_text(&self, text: &str, font_info: &FontInfo, rect_width: f64, available_width: f64) -> ShapedText {
+    /// Shape `text` into the positioned glyph runs a glyph-based rasterizer will paint. Shaped
+    /// once per text and style across tiles and frames (see [`ShapeCache`]).
+    fn shape_text(&self, text: &str, font_info: &FontInfo, rect_width: f64, available_width: f64) -> Arc<ShapedText> {
         let Some(ref fs) = self.font_system else {
-            return ShapedText::empty();
+            return Arc::new(ShapedText::empty());
         };
         if text.is_empty() || font_info.size <= 0.0 {
-            return ShapedText::empty();
+            return Arc::new(ShapedText::empty());
         }
         let style = paint_text_style(font_info, rect_width, available_width);
-        fs.lock().shape(text, &style)
+        ShapeCache::global().shape(fs, text, &style)
     }
 
     pub fn paint(&self, element: &TiledLayoutElement, state: &BrowserState) -> Vec<PaintCommand> {
@@ -607,7 +609,7 @@ fn css_border_style_to_paint(s: &CssBorderStyle) -> BorderStyle {
 /// Resolves `background-size`/`-position` into a [`Tiling`], now that the border box is known.
 /// `cover`/`contain` yield a single aspect-preserved tile (no repeat), so the backend paints it
 /// once and lets the box clip (cover) or the background-color show (contain).
-fn compute_bg_tiling(natural: (f32, f32), layout: &BgImageLayout, box_w: f32, box_h: f32) -> Option<Tiling> {
+pub(crate) fn compute_bg_tiling(natural: (f32, f32), layout: &BgImageLayout, box_w: f32, box_h: f32) -> Option<Tiling> {
     let (nw, nh) = natural;
     if nw <= 0.0 || nh <= 0.0 || box_w <= 0.0 || box_h <= 0.0 {
         return None;
@@ -2,6 +2,7 @@ use crate::common::font::FontInfo;
 use crate::common::geo::Rect;
 use crate::painter::commands::brush::Brush;
 use gosub_interface::font_system::ShapedText;
+use std::sync::Arc;
 
 #[derive(Clone, Debug)]
 pub struct Text {
@@ -15,7 +16,8 @@ pub struct Text {
     /// Shaped by the same `FontSystem` instance the layouter measured with, so painted glyphs are
     /// by construction the measured ones. Glyph-based rasterizers paint these runs; engine-native
     /// ones (Pango, Parley, Skia textlayout) re-shape from `text` + `font_info` and ignore this.
-    pub shaped: ShapedText,
+    /// Shared with the shape cache, so repainting the same text does not copy its glyphs.
+    pub shaped: Arc<ShapedText>,
 }
 
 impl Text {
@@ -25,7 +27,7 @@ impl Text {
         font_info: &FontInfo,
         brush: Brush,
         available_width: f64,
-        shaped: ShapedText,
+        shaped: impl Into<Arc<ShapedText>>,
     ) -> Self {
         Text {
             rect,
@@ -33,7 +35,7 @@ impl Text {
             font_info: font_info.clone(),
             brush,
             available_width,
-            shaped,
+            shaped: shaped.into(),
         }
     }
 }
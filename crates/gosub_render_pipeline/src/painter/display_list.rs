@@ -0,0 +1,472 @@
+//! Retained paint commands for a whole page.
+//!
+//! A [`DisplayList`] holds the paint commands of every element of a [`LayerList`] in one arena,
+//! in paint order, each element's commands a contiguous span of it. Tiles are fed
+//! [`DisplaySlice`]s of that arena instead of painting an element again for every tile it
+//! overlaps. A list built against the previous one copies over the spans of elements whose box,
+//! context and styles did not change, and only paints the others.
+
+use crate::common::browser_state::{BrowserState, WireframeState};
+use crate::common::document::node::NodeId as DomNodeId;
+use crate::common::document::pipeline_doc::{pseudo_owner, PipelineDocument};
+use crate::common::media::MediaId;
+use crate::layering::layer::LayerList;
+use crate::layouter::{LayoutElementId, LayoutElementNode};
+use crate::painter::commands::border::{BorderRadius, BorderStyle};
+use crate::painter::commands::brush::Brush;
+use crate::painter::commands::gradient::Gradient;
+use crate::painter::commands::PaintCommand;
+use crate::painter::Painter;
+use std::collections::{HashMap, HashSet};
+use std::ops::Deref;
+use std::sync::Arc;
+
+/// The parts of a [`BrowserState`] that paint output depends on. Spans are only carried over
+/// between lists painted under the same values.
+#[derive(Debug, Clone, Copy, PartialEq)]
+struct PaintStateKey {
+    wireframed: WireframeState,
+    debug_hover: bool,
+    hovered: Option<LayoutElementId>,
+    debug_table_cells: bool,
+}
+
+impl PaintStateKey {
+    fn of(state: &BrowserState) -> Self {
+        Self {
+            wireframed: state.wireframed,
+            debug_hover: state.debug_hover,
+            hovered: state.current_hovered_element,
+            debug_table_cells: state.debug_table_cells,
+        }
+    }
+}
+
+/// One element's commands within the arena, with their content hash.
+#[derive(Debug, Clone, Copy)]
+struct Span {
+    start: usize,
+    end: usize,
+    hash: u64,
+    images: bool,
+}
+
+/// The paint commands of every element of a layer list. See the module documentation.
+pub struct DisplayList {
+    layer_list: Arc<LayerList>,
+    state: PaintStateKey,
+    commands: Arc<[PaintCommand]>,
+    spans: HashMap<LayoutElementId, Span>,
+    /// Elements the build painted rather than carried over.
+    painted: usize,
+}
+
+impl DisplayList {
+    /// Paints every element of the painter's layer list once. Elements `prev` already holds are
+    /// carried over unless their layout element changed or their DOM node is in `damaged`;
+    /// `damaged` must therefore hold every node whose styles changed since `prev` was built,
+    /// including the descendants that inherit from them. Without `prev` everything is painted.
+    pub fn build(
+        painter: &Painter,
+        state: &BrowserState,
+        prev: Option<&DisplayList>,
+        damaged: &HashSet<DomNodeId>,
+    ) -> DisplayList {
+        let layer_list = Arc::clone(&painter.layer_list);
+        let key = PaintStateKey::of(state);
+        let prev = prev.filter(|p| p.state == key);
+
+        let mut commands = Vec::new();
+        let mut spans = HashMap::with_capacity(layer_list.layout_tree.arena.len());
+        let mut painted = 0;
+        {
+            let layer_ids = layer_list.layer_ids.read();
+            let layers = layer_list.layers.read();
+            for layer_id in layer_ids.iter() {
+                let Some(layer) = layers.get(layer_id) else {
+                    continue;
+                };
+                for &element_id in &layer.elements {
+                    if spans.contains_key(&element_id) {
+                        continue;
+                    }
+                    let start = commands.len();
+                    let retained = prev.and_then(|p| p.retained(&layer_list, element_id, damaged));
+                    let (hash, images) = match retained {
+                        Some((carried, span)) => {
+                            commands.extend_from_slice(carried);
+                            (span.hash, span.images)
+                        }
+                        None => {
+                            painted += 1;
+                            commands.extend(painter.paint_element(element_id, state));
+                            let own = &commands[start..];
+                            (hash_commands(own), uses_images(own))
+                        }
+                    };
+                    let span = Span {
+                        start,
+                        end: commands.len(),
+                        hash,
+                        images,
+                    };
+                    spans.insert(element_id, span);
+                }
+            }
+        }
+
+        DisplayList {
+            layer_list,
+            state: key,
+            commands: Arc::from(commands),
+            spans,
+            painted,
+        }
+    }
+
+    /// The commands of `element_id`; empty for an element the list does not hold.
+    pub fn slice(&self, element_id: LayoutElementId) -> DisplaySlice {
+        match self.spans.get(&element_id) {
+            Some(span) => DisplaySlice {
+                commands: Arc::clone(&self.commands),
+                start: span.start,
+                end: span.end,
+                hash: span.hash,
+                images: span.images,
+            },
+            None => DisplaySlice::default(),
+        }
+    }
+
+    /// The layer list the commands were painted from.
+    pub fn layer_list(&self) -> &Arc<LayerList> {
+        &self.layer_list
+    }
+
+    /// [`LayerList::retarget_document`] for the layer list the commands were painted from. The
+    /// spans stay valid: they are keyed by layout element, not by document.
+    pub fn retarget_document(&mut self, doc: Arc<dyn PipelineDocument>) -> bool {
+        LayerList::retarget_document(&mut self.layer_list, doc)
+    }
+
+    /// Number of commands in the arena.
+    pub fn len(&self) -> usize {
+        self.commands.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.commands.is_empty()
+    }
+
+    /// Number of elements the build painted; the rest were carried over from the previous list.
+    pub fn painted(&self) -> usize {
+        self.painted
+    }
+
+    /// The span of `element_id` if it is still valid for `layer_list`.
+    fn retained(
+        &self,
+        layer_list: &Arc<LayerList>,
+        element_id: LayoutElementId,
+        damaged: &HashSet<DomNodeId>,
+    ) -> Option<(&[PaintCommand], Span)> {
+        let span = *self.spans.get(&element_id)?;
+        let node = layer_list.layout_tree.get_node_by_id(element_id)?;
+        if !Arc::ptr_eq(&self.layer_list, layer_list) {
+            let prev = self.layer_list.layout_tree.get_node_by_id(element_id)?;
+            if !same_element(node, prev)
+                || layer_list.is_opacity_grouped(node.dom_node_id)
+                    != self.layer_list.is_opacity_grouped(prev.dom_node_id)
+            {
+                return None;
+            }
+        }
+        let dom = node.dom_node_id;
+        if damaged.contains(&dom) || pseudo_owner(dom).is_some_and(|o| damaged.contains(&o)) {
+            return None;
+        }
+        Some((&self.commands[span.start..span.end], span))
+    }
+}
+
+/// Whether two layout elements paint the same, given the same styles.
+fn same_element(a: &LayoutElementNode, b: &LayoutElementNode) -> bool {
+    a.dom_node_id == b.dom_node_id
+        && a.box_model == b.box_model
+        && a.context == b.context
+        && a.background_media == b.background_media
+}
+
+/// The paint commands of one element, shared with the [`DisplayList`] they were sliced from.
+/// Also built from a plain command list, for callers painting elements one by one.
+#[derive(Clone)]
+pub struct DisplaySlice {
+    commands: Arc<[PaintCommand]>,
+    start: usize,
+    end: usize,
+    hash: u64,
+    images: bool,
+}
+
+impl DisplaySlice {
+    /// Hash of the commands, computed once when they were painted. Image brushes are hashed by
+    /// media id only; the size an image is currently decoded at is up to the caller.
+    pub fn content_hash(&self) -> u64 {
+        self.hash
+    }
+
+    /// Calls `f` for the media id of every image brush in the commands.
+    pub fn for_each_image(&self, mut f: impl FnMut(MediaId)) {
+        if !self.images {
+            return;
+        }
+        for cmd in self.iter() {
+            for_each_brush(cmd, |brush| {
+                if let Brush::Image(media_id, _) = brush {
+                    f(*media_id);
+                }
+            });
+        }
+    }
+}
+
+impl Default for DisplaySlice {
+    fn default() -> Self {
+        DisplaySlice::from(Vec::new())
+    }
+}
+
+impl From<Vec<PaintCommand>> for DisplaySlice {
+    fn from(commands: Vec<PaintCommand>) -> Self {
+        DisplaySlice {
+            hash: hash_commands(&commands),
+            images: uses_images(&commands),
+            start: 0,
+            end: commands.len(),
+            commands: Arc::from(commands),
+        }
+    }
+}
+
+impl Deref for DisplaySlice {
+    type Target = [PaintCommand];
+
+    fn deref(&self) -> &[PaintCommand] {
+        &self.commands[self.start..self.end]
+    }
+}
+
+impl<'a> IntoIterator for &'a DisplaySlice {
+    type Item = &'a PaintCommand;
+    type IntoIter = std::slice::Iter<'a, PaintCommand>;
+
+    fn into_iter(self) -> Self::IntoIter {
+        self.iter()
+    }
+}
+
+impl std::fmt::Debug for DisplaySlice {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_list().entries(self.iter()).finish()
+    }
+}
+
+fn for_each_brush(cmd: &PaintCommand, mut f: impl FnMut(&Brush)) {
+    match cmd {
+        PaintCommand::Rectangle(r) => {
+            if let Some(b) = r.background() {
+                f(b);
+            }
+            for b in r.border().brushes() {
+                f(&b);
+            }
+        }
+        PaintCommand::Text(t) => f(&t.brush),
+        PaintCommand::Svg(_) | PaintCommand::PushLayer { .. } | PaintCommand::PopLayer => {}
+    }
+}
+
+fn uses_images(commands: &[PaintCommand]) -> bool {
+    let mut images = false;
+    for cmd in commands {
+        for_each_brush(cmd, |b| images |= matches!(b, Brush::Image(..)));
+    }
+    images
+}
+
+/// FNV-1a hash over everything in `commands` that affects the pixels they draw.
+fn hash_commands(commands: &[PaintCommand]) -> u64 {
+    // Minimal inline FNV-1a hasher - no trait bounds needed on the types being hashed.
+    let mut h: u64 = 14695981039346656037;
+    macro_rules! fnv {
+        ($bytes:expr) => {
+            for b in $bytes {
+                h ^= *b as u64;
+                h = h.wrapping_mul(1099511628211);
+            }
+        };
+    }
+    macro_rules! hf32 {
+        ($v:expr) => {
+            fnv!(&$v.to_bits().to_le_bytes())
+        };
+    }
+    macro_rules! hf64 {
+        ($v:expr) => {
+            fnv!(&$v.to_bits().to_le_bytes())
+        };
+    }
+    macro_rules! hu64 {
+        ($v:expr) => {
+            fnv!(&($v as u64).to_le_bytes())
+        };
+    }
+    macro_rules! hbool {
+        ($v:expr) => {
+            fnv!(&[$v as u8])
+        };
+    }
+    macro_rules! hstr {
+        ($s:expr) => {
+            fnv!($s.as_bytes());
+            fnv!(&[0u8])
+        };
+    }
+
+    macro_rules! hash_brush {
+        ($b:expr) => {
+            match $b {
+                Brush::Solid(c) => {
+                    fnv!(&[0]);
+                    hf32!(c.r());
+                    hf32!(c.g());
+                    hf32!(c.b());
+                    hf32!(c.a());
+                }
+                Brush::Image(m, tiling) => {
+                    fnv!(&[1]);
+                    hu64!(m.as_u64());
+                    match tiling {
+                        Some(t) => {
+                            hbool!(true);
+                            hf32!(t.tile_size.0);
+                            hf32!(t.tile_size.1);
+                            hf32!(t.position.0);
+                            hf32!(t.position.1);
+                            hbool!(t.repeat.0);
+                            hbool!(t.repeat.1);
+                        }
+                        None => hbool!(false),
+                    }
+                }
+                Brush::Gradient(Gradient::Linear(g)) => {
+                    fnv!(&[2]);
+                    hf32!(g.angle_deg);
+                    for stop in &g.stops {
+                        hf32!(stop.offset);
+                        hf32!(stop.color.r());
+                        hf32!(stop.color.g());
+                        hf32!(stop.color.b());
+                        hf32!(stop.color.a());
+                    }
+                }
+            }
+        };
+    }
+
+    for cmd in commands {
+        match cmd {
+            // Scene-only layer-group markers; never present in per-tile commands, so they don't
+            // affect a tile's content hash.
+            PaintCommand::PushLayer { .. } | PaintCommand::PopLayer => {}
+            PaintCommand::Rectangle(r) => {
+                fnv!(&[0u8]);
+                let rect = r.rect();
+                hf64!(rect.x);
+                hf64!(rect.y);
+                hf64!(rect.width);
+                hf64!(rect.height);
+                fnv!(&[r.blend_mode().id()]);
+                match r.background() {
+                    None => hbool!(false),
+                    Some(b) => {
+                        hbool!(true);
+                        hash_brush!(b);
+                    }
+                }
+                let border = r.border();
+                hf32!(border.width());
+                fnv!(&[match border.style() {
+                    BorderStyle::Solid => 1,
+                    BorderStyle::Dashed => 2,
+                    BorderStyle::Dotted => 3,
+                    BorderStyle::Double => 4,
+                    BorderStyle::Groove => 5,
+                    BorderStyle::Ridge => 6,
+                    BorderStyle::Inset => 7,
+                    BorderStyle::Outset => 8,
+                    BorderStyle::Hidden => 9,
+                    BorderStyle::None => 0,
+                }]);
+                for b in border.brushes() {
+                    hash_brush!(&b);
+                }
+                if let Some(tr) = border.radius() {
+                    hbool!(true);
+                    for br in [&tr.top, &tr.right, &tr.bottom, &tr.left] {
+                        match br {
+                            BorderRadius::Uniform(v) => {
+                                fnv!(&[0]);
+                                hf32!(*v);
+                            }
+                            BorderRadius::Elliptical { horizontal, vertical } => {
+                                fnv!(&[1]);
+                                hf32!(*horizontal);
+                                hf32!(*vertical);
+                            }
+                        }
+                    }
+                } else {
+                    hbool!(false);
+                }
+                let (tl, tr, br, bl) = r.radius_x();
+                hf64!(tl);
+                hf64!(tr);
+                hf64!(br);
+                hf64!(bl);
+                let (tl, tr, br, bl) = r.radius_y();
+                hf64!(tl);
+                hf64!(tr);
+                hf64!(br);
+                hf64!(bl);
+            }
+            PaintCommand::Text(t) => {
+                fnv!(&[1u8]);
+                hf64!(t.rect.x);
+                hf64!(t.rect.y);
+                hf64!(t.rect.width);
+                hf64!(t.rect.height);
+                hstr!(&t.text);
+                hstr!(&t.font_info.family);
+                hf64!(t.font_info.size);
+                hf64!(t.font_info.line_height);
+                hu64!(t.font_info.weight as u64);
+                hu64!(t.font_info.width as u64);
+                hu64!(t.font_info.slant as u64);
+                hbool!(t.font_info.underline);
+                hbool!(t.font_info.line_through);
+                hash_brush!(&t.brush);
+            }
+            PaintCommand::Svg(s) => {
+                fnv!(&[2u8]);
+                hu64!(s.media_id.as_u64());
+                let rect = s.rect.rect();
+                hf64!(rect.x);
+                hf64!(rect.y);
+                hf64!(rect.width);
+                hf64!(rect.height);
+            }
+        }
+    }
+    h
+}
@@ -3,7 +3,6 @@ use crate::common::texture::TextureId;
 use crate::common::texture_store::TextureStore;
 use crate::tiler::Tile;
 use gosub_interface::font_system::FontSystem;
-use parking_lot::Mutex;
 use std::any::Any;
 use std::sync::Arc;
 
@@ -17,9 +16,16 @@ pub trait Rasterable {
     /// The font system this rasterizer draws with, so the layouter can measure against the very
     /// same font collection. `None` for rasterizers that don't shape through a [`FontSystem`]
     /// (null, Pango/Cairo); the layouter then uses its own instance.
-    fn font_system(&self) -> Option<Arc<Mutex<dyn FontSystem>>> {
+    fn font_system(&self) -> Option<Arc<dyn FontSystem>> {
         None
     }
+
+    /// Keeps the GPU-resident tile `gpu_id` (a `TilePixels::Gpu` this rasterizer produced) around
+    /// because the tile cache is about to reuse it. `false` when the backend has released it in
+    /// the meantime; the tile is then rasterized again. CPU rasterizers never see this called.
+    fn retain_gpu_tile(&self, _gpu_id: u64) -> bool {
+        true
+    }
 }
 
 /// No-op rasterizer for backends that don't rasterize tiles (e.g. the null backend).
@@ -76,24 +82,17 @@ pub struct BakedTile {
     pub anchor: crate::render::backend::TileAnchor,
 }
 
-/// Key that uniquely identifies a tile's content for cache lookup.
-/// Format: (page_x bits, page_y bits, layer_id, paint-command hash).
-pub type TileCacheKey = (u64, u64, u64, u64);
-
-/// Rasterized tile cache: maps a [`TileCacheKey`] to `(physical_width, physical_height, pixels)`.
-/// Carried between renders so unchanged tiles skip rasterization.
-pub type TilePixelCache = std::collections::HashMap<TileCacheKey, (u32, u32, TilePixels)>;
+// The tile pixel cache lives in `common::tile_cache`; re-exported here next to the rasterizers
+// that fill it.
+pub use crate::common::tile_cache::{CachedTilePixels, TileCacheKey, TilePixelCache};
 
 /// Compute a stable cache key for a tile: (page_x bits, page_y bits, layer_id, content hash).
-/// The content hash covers all paint commands so any visual change produces a different key.
-fn tile_cache_key(tile: &crate::tiler::Tile) -> TileCacheKey {
-    use crate::painter::commands::{
-        border::{BorderRadius, BorderStyle},
-        brush::Brush,
-        gradient::Gradient,
-        PaintCommand,
-    };
-
+/// The content hash covers all paint commands (through the hash each [`DisplaySlice`] carries) so
+/// any visual change produces a different key, including the size image brushes are currently
+/// decoded at in `media_store`.
+///
+/// [`DisplaySlice`]: crate::painter::display_list::DisplaySlice
+fn tile_cache_key(tile: &crate::tiler::Tile, media_store: &MediaStore) -> TileCacheKey {
     // Minimal inline FNV-1a hasher - no trait bounds needed on the types being hashed.
     let mut h: u64 = 14695981039346656037;
     macro_rules! fnv {
@@ -124,53 +123,6 @@ fn tile_cache_key(tile: &crate::tiler::Tile) -> TileCacheKey {
             fnv!(&[$v as u8])
         };
     }
-    macro_rules! hstr {
-        ($s:expr) => {
-            fnv!($s.as_bytes());
-            fnv!(&[0u8])
-        };
-    }
-
-    macro_rules! hash_brush {
-        ($b:expr) => {
-            match $b {
-                Brush::Solid(c) => {
-                    fnv!(&[0]);
-                    hf32!(c.r());
-                    hf32!(c.g());
-                    hf32!(c.b());
-                    hf32!(c.a());
-                }
-                Brush::Image(m, tiling) => {
-                    fnv!(&[1]);
-                    hu64!(m.as_u64());
-                    match tiling {
-                        Some(t) => {
-                            hbool!(true);
-                            hf32!(t.tile_size.0);
-                            hf32!(t.tile_size.1);
-                            hf32!(t.position.0);
-                            hf32!(t.position.1);
-                            hbool!(t.repeat.0);
-                            hbool!(t.repeat.1);
-                        }
-                        None => hbool!(false),
-                    }
-                }
-                Brush::Gradient(Gradient::Linear(g)) => {
-                    fnv!(&[2]);
-                    hf32!(g.angle_deg);
-                    for stop in &g.stops {
-                        hf32!(stop.offset);
-                        hf32!(stop.color.r());
-                        hf32!(stop.color.g());
-                        hf32!(stop.color.b());
-                        hf32!(stop.color.a());
-                    }
-                }
-            }
-        };
-    }
 
     match tile.bgcolor {
         Some((r, g, b, a)) => {
@@ -189,101 +141,13 @@ fn tile_cache_key(tile: &crate::tiler::Tile) -> TileCacheKey {
         hf64!(elem.rect.y);
         hf64!(elem.rect.width);
         hf64!(elem.rect.height);
-
-        for cmd in &elem.paint_commands {
-            match cmd {
-                // Scene-only layer-group markers; never present in per-tile commands, so they don't
-                // affect a tile's content hash.
-                PaintCommand::PushLayer { .. } | PaintCommand::PopLayer => {}
-                PaintCommand::Rectangle(r) => {
-                    fnv!(&[0u8]);
-                    let rect = r.rect();
-                    hf64!(rect.x);
-                    hf64!(rect.y);
-                    hf64!(rect.width);
-                    hf64!(rect.height);
-                    fnv!(&[r.blend_mode().id()]);
-                    match r.background() {
-                        None => hbool!(false),
-                        Some(b) => {
-                            hbool!(true);
-                            hash_brush!(b);
-                        }
-                    }
-                    let border = r.border();
-                    hf32!(border.width());
-                    fnv!(&[match border.style() {
-                        BorderStyle::Solid => 1,
-                        BorderStyle::Dashed => 2,
-                        BorderStyle::Dotted => 3,
-                        BorderStyle::Double => 4,
-                        BorderStyle::Groove => 5,
-                        BorderStyle::Ridge => 6,
-                        BorderStyle::Inset => 7,
-                        BorderStyle::Outset => 8,
-                        BorderStyle::Hidden => 9,
-                        BorderStyle::None => 0,
-                    }]);
-                    for b in border.brushes() {
-                        hash_brush!(&b);
-                    }
-                    if let Some(tr) = border.radius() {
-                        hbool!(true);
-                        for br in [&tr.top, &tr.right, &tr.bottom, &tr.left] {
-                            match br {
-                                BorderRadius::Uniform(v) => {
-                                    fnv!(&[0]);
-                                    hf32!(*v);
-                                }
-                                BorderRadius::Elliptical { horizontal, vertical } => {
-                                    fnv!(&[1]);
-                                    hf32!(*horizontal);
-                                    hf32!(*vertical);
-                                }
-                            }
-                        }
-                    } else {
-                        hbool!(false);
-                    }
-                    let (tl, tr, br, bl) = r.radius_x();
-                    hf64!(tl);
-                    hf64!(tr);
-                    hf64!(br);
-                    hf64!(bl);
-                    let (tl, tr, br, bl) = r.radius_y();
-                    hf64!(tl);
-                    hf64!(tr);
-                    hf64!(br);
-                    hf64!(bl);
-                }
-                PaintCommand::Text(t) => {
-                    fnv!(&[1u8]);
-                    hf64!(t.rect.x);
-                    hf64!(t.rect.y);
-                    hf64!(t.rect.width);
-                    hf64!(t.rect.height);
-                    hstr!(&t.text);
-                    hstr!(&t.font_info.family);
-                    hf64!(t.font_info.size);
-                    hf64!(t.font_info.line_height);
-                    hu64!(t.font_info.weight as u64);
-                    hu64!(t.font_info.width as u64);
-                    hu64!(t.font_info.slant as u64);
-                    hbool!(t.font_info.underline);
-                    hbool!(t.font_info.line_through);
-                    hash_brush!(&t.brush);
-                }
-                PaintCommand::Svg(s) => {
-                    fnv!(&[2u8]);
-                    hu64!(s.media_id.as_u64());
-                    let rect = s.rect.rect();
-                    hf64!(rect.x);
-                    hf64!(rect.y);
-                    hf64!(rect.width);
-                    hf64!(rect.height);
-                }
-            }
-        }
+        hu64!(elem.paint_commands.content_hash());
+        // A redecode at another size must not be covered by tiles drawn from the old one.
+        elem.paint_commands.for_each_image(|media_id| {
+            let (pw, ph) = media_store.image_pixel_size(media_id);
+            hu64!(pw);
+            hu64!(ph);
+        });
     }
 
     // Fold the tile's own dimensions into the content hash: an edge tile whose size changes
@@ -296,30 +160,54 @@ fn tile_cache_key(tile: &crate::tiler::Tile) -> TileCacheKey {
 }
 
 /// Sequential per-tile rasterization, used by GPU backends (e.g. Vello) whose shared
-/// `Mutex<Renderer>` rules out parallelism. No dirty-tile cache, so it returns an empty one.
+/// `Mutex<Renderer>` rules out parallelism. Dirty tiles whose content hash is still in
+/// `tile_cache` (and, for GPU tiles, still resident) reuse those pixels; the rest are rasterized
+/// one by one and added to the cache.
 pub fn rasterize_sequential(
     rasterizer: &(dyn Rasterable + Send + Sync),
     layer_ids: &[crate::layering::layer::LayerId],
     tile_list: &mut crate::tiler::TileList,
     full_page_rect: crate::common::geo::Rect,
     media_store: &crate::common::media::MediaStore,
-) -> (Vec<BakedTile>, TilePixelCache) {
+    tile_cache: &TilePixelCache,
+) -> Vec<BakedTile> {
     use crate::common::texture_store::TextureStore;
     use crate::tiler::TileState;
     use gosub_shared::{timing_start, timing_stop};
 
     let ts6 = timing_start!("pipeline.rasterize");
     let mut texture_store = TextureStore::new();
+    let mut reused: std::collections::HashMap<crate::tiler::TileId, CachedTilePixels> =
+        std::collections::HashMap::new();
 
     for &layer_id in layer_ids {
         let tile_ids = tile_list.get_intersecting_tiles(layer_id, full_page_rect);
         for tile_id in tile_ids {
             if let Some(tile) = tile_list.get_tile_mut(tile_id) {
                 if tile.state == TileState::Dirty {
+                    let key = tile_cache_key(tile, media_store);
+                    if let Some(hit) = cached_tile_pixels(rasterizer, tile_cache, &key) {
+                        tile.texture_id = None;
+                        tile.state = TileState::Ready;
+                        reused.insert(tile_id, hit);
+                        continue;
+                    }
                     match rasterizer.rasterize(tile, &mut texture_store, media_store) {
                         Some(texture_id) => {
                             tile.texture_id = Some(texture_id);
                             tile.state = TileState::Ready;
+                            if let Some(tex) = texture_store.get(texture_id) {
+                                tile_cache.insert(
+                                    key,
+                                    tile.rect,
+                                    CachedTilePixels {
+                                        width: tex.width as u32,
+                                        height: tex.height as u32,
+                                        pixels: tex.pixels.clone(),
+                                        format: tex.format,
+                                    },
+                                );
+                            }
                         }
                         None => tile.state = TileState::Empty,
                     }
@@ -329,117 +217,167 @@ pub fn rasterize_sequential(
     }
 
     let mut tiles: Vec<BakedTile> = Vec::with_capacity(tile_list.arena.len());
-    for tile in tile_list.arena.values() {
-        if let (Some(texture_id), true) = (tile.texture_id, tile.state == TileState::Ready) {
-            if let Some(tex) = texture_store.get(texture_id) {
-                tiles.push(BakedTile {
-                    page_x: tile.rect.x,
-                    page_y: tile.rect.y,
-                    layer_id: tile.layer_id.as_u64(),
-                    width: tex.width as u32,
-                    height: tex.height as u32,
-                    pixels: tex.pixels.clone(),
-                    format: tex.format,
-                    opacity: tile_list.layer_list.layer_opacity(tile.layer_id),
-                    anchor: tile_list.layer_list.layer_anchor(tile.layer_id),
-                });
-            }
+    for (tile_id, tile) in tile_list.arena.iter() {
+        if tile.state != TileState::Ready {
+            continue;
+        }
+        let pixels = match tile.texture_id {
+            Some(texture_id) => texture_store.get(texture_id).map(|tex| CachedTilePixels {
+                width: tex.width as u32,
+                height: tex.height as u32,
+                pixels: tex.pixels.clone(),
+                format: tex.format,
+            }),
+            None => reused.remove(tile_id),
+        };
+        if let Some(pixels) = pixels {
+            tiles.push(baked_tile(tile_list, tile, pixels));
         }
     }
 
     timing_stop!(ts6);
-    (tiles, std::collections::HashMap::new())
+    tiles
+}
+
+/// The cached pixels for `key`, unless they name a GPU tile the rasterizer has since released.
+fn cached_tile_pixels(
+    rasterizer: &(dyn Rasterable + Send + Sync),
+    tile_cache: &TilePixelCache,
+    key: &TileCacheKey,
+) -> Option<CachedTilePixels> {
+    let hit = tile_cache.get(key)?;
+    match hit.pixels {
+        TilePixels::Gpu(gpu_id) if !rasterizer.retain_gpu_tile(gpu_id) => None,
+        _ => Some(hit),
+    }
+}
+
+fn baked_tile(tile_list: &crate::tiler::TileList, tile: &Tile, pixels: CachedTilePixels) -> BakedTile {
+    BakedTile {
+        page_x: tile.rect.x,
+        page_y: tile.rect.y,
+        layer_id: tile.layer_id.as_u64(),
+        width: pixels.width,
+        height: pixels.height,
+        pixels: pixels.pixels,
+        format: pixels.format,
+        opacity: tile_list.layer_list.layer_opacity(tile.layer_id),
+        anchor: tile_list.layer_list.layer_anchor(tile.layer_id),
+    }
 }
 
 /// Parallel per-tile rasterization with the dirty-tile pixel cache, used by CPU backends
-/// (Cairo, Skia) whose rasterizers are `Send + Sync`. Dirty tiles whose content hash still
-/// matches `prev_tile_cache` reuse those pixels; the rest go to a rayon worker.
+/// (Cairo, Skia) whose rasterizers are `Send + Sync`. Dirty tiles whose content hash is still in
+/// `tile_cache` reuse those pixels; the rest go to a rayon worker and are added to the cache.
 pub fn rasterize_parallel(
     rasterizer: &(dyn Rasterable + Send + Sync),
     layer_ids: &[crate::layering::layer::LayerId],
     tile_list: &mut crate::tiler::TileList,
     full_page_rect: crate::common::geo::Rect,
     media_store: &crate::common::media::MediaStore,
-    prev_tile_cache: &TilePixelCache,
+    tile_cache: &TilePixelCache,
     timing_label: &str,
-) -> (Vec<BakedTile>, TilePixelCache) {
-    use crate::common::texture_store::TextureStore;
-    use crate::render::backend::PixelFormat;
+) -> Vec<BakedTile> {
     use crate::tiler::{TileId, TileState};
     use gosub_shared::{timing_start, timing_stop};
-    use rayon::prelude::*;
-
-    // Cairo and Skia both emit premultiplied ARGB32 (BGRA byte order).
-    let tile_format = PixelFormat::PreMulArgb32;
 
     let ts6 = timing_start!(timing_label);
 
-    // Phase 1: collect IDs of dirty tiles across all layers.
+    // Collect IDs of dirty tiles across all layers, in back-to-front layer order.
     let dirty_ids: Vec<TileId> = layer_ids
         .iter()
         .flat_map(|&layer_id| tile_list.get_intersecting_tiles(layer_id, full_page_rect))
         .filter(|&id| tile_list.arena.get(&id).is_some_and(|t| t.state == TileState::Dirty))
         .collect();
 
-    // Phase 2: parallel rasterization, yielding (tile_id, baked tile, new cache entry).
-    type CacheEntry = (TileCacheKey, (u32, u32, TilePixels));
-    let results: Vec<(TileId, Option<BakedTile>, Option<CacheEntry>)> = dirty_ids
-        .par_iter()
-        .map(|&tile_id| {
-            let Some(tile) = tile_list.arena.get(&tile_id) else {
-                return (tile_id, None, None);
-            };
+    let results = rasterize_tile_batch(rasterizer, tile_list, &dirty_ids, media_store, tile_cache);
+    let baked = collect_tile_results(tile_list, results);
+
+    timing_stop!(ts6);
+    baked
+}
+
+/// Parallel rasterization of exactly `tile_ids`, in that order, with the same pixel-cache reuse
+/// as [`rasterize_parallel`]. Used for the viewport-first pass of a progressive render (see
+/// [`split_viewport_tiles`]).
+pub fn rasterize_tiles(
+    rasterizer: &(dyn Rasterable + Send + Sync),
+    tile_list: &mut crate::tiler::TileList,
+    tile_ids: &[crate::tiler::TileId],
+    media_store: &crate::common::media::MediaStore,
+    tile_cache: &TilePixelCache,
+    timing_label: &str,
+) -> Vec<BakedTile> {
+    use gosub_shared::{timing_start, timing_stop};
+
+    let ts6 = timing_start!(timing_label);
+    let results = rasterize_tile_batch(rasterizer, tile_list, tile_ids, media_store, tile_cache);
+    let baked = collect_tile_results(tile_list, results);
+    timing_stop!(ts6);
+    baked
+}
+
+type TileResult = (crate::tiler::TileId, Option<BakedTile>);
+
+/// Rasterizes `tile_ids` on the rayon pool, yielding (tile_id, baked tile) in input order and
+/// adding newly rasterized tiles to `tile_cache`. Does not touch tile state; see
+/// [`collect_tile_results`].
+fn rasterize_tile_batch(
+    rasterizer: &(dyn Rasterable + Send + Sync),
+    tile_list: &crate::tiler::TileList,
+    tile_ids: &[crate::tiler::TileId],
+    media_store: &crate::common::media::MediaStore,
+    tile_cache: &TilePixelCache,
+) -> Vec<TileResult> {
+    use crate::common::texture_store::TextureStore;
+    use rayon::prelude::*;
 
-            let key = tile_cache_key(tile);
-
-            if let Some(&(w, h, ref data)) = prev_tile_cache.get(&key) {
-                let baked = BakedTile {
-                    page_x: tile.rect.x,
-                    page_y: tile.rect.y,
-                    layer_id: tile.layer_id.as_u64(),
-                    width: w,
-                    height: h,
-                    pixels: data.clone(),
-                    format: tile_format,
-                    opacity: tile_list.layer_list.layer_opacity(tile.layer_id),
-                    anchor: tile_list.layer_list.layer_anchor(tile.layer_id),
+    tile_ids
+        .par_iter()
+        .map_init(
+            // One texture store per rayon work split, recycling the cache's pixel buffers.
+            || TextureStore::with_buffer_pool(Arc::clone(tile_cache.buffers())),
+            |texture_store, &tile_id| {
+                let Some(tile) = tile_list.arena.get(&tile_id) else {
+                    return (tile_id, None);
                 };
-                return (tile_id, Some(baked), None);
-            }
 
-            let mut local_store = TextureStore::new();
-            let baked = rasterizer
-                .rasterize(tile, &mut local_store, media_store)
-                .and_then(|tid| local_store.get(tid))
-                .map(|tex| BakedTile {
-                    page_x: tile.rect.x,
-                    page_y: tile.rect.y,
-                    layer_id: tile.layer_id.as_u64(),
-                    width: tex.width as u32,
-                    height: tex.height as u32,
-                    pixels: tex.pixels.clone(),
-                    format: tex.format,
-                    opacity: tile_list.layer_list.layer_opacity(tile.layer_id),
-                    anchor: tile_list.layer_list.layer_anchor(tile.layer_id),
-                });
-
-            let cache_entry = baked.as_ref().map(|b| (key, (b.width, b.height, b.pixels.clone())));
-            (tile_id, baked, cache_entry)
-        })
-        .collect();
+                let key = tile_cache_key(tile, media_store);
 
-    // Phase 3: update tile states, gather BakedTiles, and build the new tile cache.
-    let mut tiles: Vec<BakedTile> = Vec::with_capacity(results.len());
-    let mut new_tile_cache: TilePixelCache = std::collections::HashMap::with_capacity(results.len());
+                if let Some(hit) = cached_tile_pixels(rasterizer, tile_cache, &key) {
+                    return (tile_id, Some(baked_tile(tile_list, tile, hit)));
+                }
 
-    for (tile_id, baked, cache_entry) in results {
+                let _t = gosub_shared::timing_guard!("pipeline.rasterize.tile");
+                let pixels = rasterizer
+                    .rasterize(tile, texture_store, media_store)
+                    .and_then(|tid| texture_store.remove(tid))
+                    .map(|tex| CachedTilePixels {
+                        width: tex.width as u32,
+                        height: tex.height as u32,
+                        pixels: tex.pixels.clone(),
+                        format: tex.format,
+                    });
+
+                if let Some(p) = &pixels {
+                    tile_cache.insert(key, tile.rect, p.clone());
+                }
+                (tile_id, pixels.map(|p| baked_tile(tile_list, tile, p)))
+            },
+        )
+        .collect()
+}
+
+/// Updates tile states from a batch of results and gathers the baked tiles (in result order).
+fn collect_tile_results(tile_list: &mut crate::tiler::TileList, results: Vec<TileResult>) -> Vec<BakedTile> {
+    use crate::tiler::TileState;
+
+    let mut tiles: Vec<BakedTile> = Vec::with_capacity(results.len());
+    for (tile_id, baked) in results {
         if let Some(tile) = tile_list.arena.get_mut(&tile_id) {
             match baked {
                 Some(b) => {
                     tile.state = TileState::Ready;
-                    if let Some(entry) = cache_entry {
-                        new_tile_cache.insert(entry.0, entry.1);
-                    }
                     tiles.push(b);
                 }
                 None => {
@@ -448,9 +386,7 @@ pub fn rasterize_parallel(
             }
         }
     }
-
-    timing_stop!(ts6);
-    (tiles, new_tile_cache)
+    tiles
 }
 
 /// Build the CPU `CachedTile` list for the zero-copy scroll handle. GPU-resident tiles have no
@@ -468,6 +404,7 @@ pub fn cpu_cached_tiles(baked: &[BakedTile]) -> Vec<CachedTile> {
                 format: t.format,
                 opacity: t.opacity,
                 anchor: t.anchor,
+                layer_id: t.layer_id,
                 // Alpha is the 4th byte in both supported formats ([B,G,R,A] / [R,G,B,A]). Scanned
                 // once here (per cache build, not per scroll) so the compositor can fast-path it.
                 opaque: d.chunks_exact(4).all(|px| px[3] == 0xFF),
@@ -500,6 +437,214 @@ pub fn collect_placed_gpu_tiles(baked: &[BakedTile]) -> Vec<crate::render::backe
         .collect()
 }
 
+// ---------------------------------------------------------------------------
+// Progressive rasterization: viewport first, the rest of the page in the background.
+// ---------------------------------------------------------------------------
+
+use crate::common::geo::Rect;
+use crate::layering::layer::LayerId;
+use crate::tiler::{TileId, TileList, TileState};
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::mpsc;
+
+/// Splits the dirty tiles of `tile_list` into those the first frame needs and those that can be
+/// filled in after it is shown: tiles intersecting `visible` (the viewport, in page coordinates)
+/// plus every tile of a fixed or sticky layer, and the rest. Both lists are in back-to-front
+/// layer order.
+pub fn split_viewport_tiles(
+    tile_list: &TileList,
+    layer_ids: &[LayerId],
+    full_page_rect: Rect,
+    visible: Rect,
+) -> (Vec<TileId>, Vec<TileId>) {
+    use crate::render::backend::TileAnchor;
+
+    let mut now = Vec::new();
+    let mut later = Vec::new();
+    for &layer_id in layer_ids {
+        // Fixed and sticky layers move with the viewport, so their page position says little
+        // about whether they are on screen. They are small; take them whole.
+        let pinned = !matches!(tile_list.layer_list.layer_anchor(layer_id), TileAnchor::Scroll);
+        for tile_id in tile_list.get_intersecting_tiles(layer_id, full_page_rect) {
+            let Some(tile) = tile_list.arena.get(&tile_id) else {
+                continue;
+            };
+            if tile.state != TileState::Dirty {
+                continue;
+            }
+            if pinned || tile.rect.intersects(&visible) {
+                now.push(tile_id);
+            } else {
+                later.push(tile_id);
+            }
+        }
+    }
+    (now, later)
+}
+
+/// Fill-in priority of a tile outside the viewport; lower goes first. This is the tile's distance
+/// from `visible`, counted double for tiles behind the scroll direction (`scroll_dir` > 0 means
+/// the page was last scrolled down), since those are the least likely to be revealed next.
+pub fn fill_priority(tile: Rect, visible: Rect, scroll_dir: f64) -> f64 {
+    let above = visible.y - (tile.y + tile.height);
+    let below = tile.y - (visible.y + visible.height);
+    let left = visible.x - (tile.x + tile.width);
+    let right = tile.x - (visible.x + visible.width);
+    let distance = left.max(right).max(0.0) + above.max(below).max(0.0);
+    let behind = (above > 0.0 && scroll_dir > 0.0) || (below > 0.0 && scroll_dir < 0.0);
+    if behind {
+        distance * 2.0
+    } else {
+        distance
+    }
+}
+
+/// One finished batch of a [`RasterFill`].
+pub struct FillBatch {
+    pub tiles: Vec<BakedTile>,
+    /// [`cpu_cached_tiles`] of `tiles`, built on the fill thread.
+    pub cached_tiles: Vec<CachedTile>,
+    /// Page rect and layer of every tile the batch covered, including those that came out empty
+    /// and so have no entry in `tiles`.
+    pub covered: Vec<(Rect, LayerId)>,
+}
+
+/// Background fill-in of the tiles a viewport-first render deferred (see [`split_viewport_tiles`]).
+///
+/// A dedicated thread rasterizes the deferred tiles on the rayon pool in small batches, each
+/// batch taking the tiles nearest the viewport (see [`fill_priority`]), and hands finished
+/// batches back through [`Self::try_take`]. The order is recomputed before every batch from the
+/// latest [`Self::set_viewport`], so scrolling steers the fill. Dropping the fill (or
+/// [`Self::cancel`]) stops it at the next batch boundary; a new layout makes the rest worthless.
+pub struct RasterFill {
+    cancelled: Arc<AtomicBool>,
+    viewport: Arc<parking_lot::Mutex<(Rect, f64)>>,
+    batches: mpsc::Receiver<FillBatch>,
+}
+
+impl RasterFill {
+    /// Starts filling in `deferred`, which must be dirty tiles of `tile_list` (already painted).
+    /// Returns `None` when there is nothing to fill, or when the fill thread can't be spawned; the
+    /// deferred tiles then stay blank until the next render.
+    #[allow(clippy::too_many_arguments)]
+    pub fn spawn(
+        rasterizer: Arc<dyn Rasterable + Send + Sync>,
+        mut tile_list: TileList,
+        mut deferred: Vec<TileId>,
+        media_store: Arc<MediaStore>,
+        tile_cache: Arc<TilePixelCache>,
+        visible: Rect,
+        scroll_dir: f64,
+    ) -> Option<Self> {
+        if deferred.is_empty() {
+            return None;
+        }
+
+        let cancelled = Arc::new(AtomicBool::new(false));
+        let viewport = Arc::new(parking_lot::Mutex::new((visible, scroll_dir)));
+        let (tx, rx) = mpsc::channel();
+
+        let thread_cancelled = Arc::clone(&cancelled);
+        let thread_viewport = Arc::clone(&viewport);
+        let spawned = std::thread::Builder::new().name("raster-fill".into()).spawn(move || {
+            use gosub_shared::{counter_add, timing_start, timing_stop};
+
+            // Small enough that one batch finishes quickly (cancellation and re-prioritisation
+            // happen between batches), large enough to keep every rayon worker busy.
+            let batch_len = rayon::current_num_threads().max(1) * 2;
+            while !deferred.is_empty() {
+                if thread_cancelled.load(Ordering::Relaxed) {
+                    counter_add!("pipeline.rasterize.fill.cancelled");
+                    break;
+                }
+
+                // Highest priority last, so the next batch splits off the end.
+                let (visible, scroll_dir) = *thread_viewport.lock();
+                let priority = |id: &TileId| {
+                    tile_list
+                        .arena
+                        .get(id)
+                        .map_or(f64::MAX, |t| fill_priority(t.rect, visible, scroll_dir))
+                };
+                deferred.sort_by(|a, b| priority(b).total_cmp(&priority(a)));
+                let ids = deferred.split_off(deferred.len().saturating_sub(batch_len));
+
+                let ts = timing_start!("pipeline.rasterize.fill");
+                let results = rasterize_tile_batch(rasterizer.as_ref(), &tile_list, &ids, &media_store, &tile_cache);
+                let tiles = collect_tile_results(&mut tile_list, results);
+                timing_stop!(ts);
+
+                let cached_tiles = cpu_cached_tiles(&tiles);
+                let covered = ids
+                    .iter()
+                    .filter_map(|id| tile_list.arena.get(id).map(|t| (t.rect, t.layer_id)))
+                    .collect();
+                let batch = FillBatch {
+                    tiles,
+                    cached_tiles,
+                    covered,
+                };
+                if tx.send(batch).is_err() {
+                    // The render this fill belonged to is gone.
+                    break;
+                }
+            }
+            // Let go of the layer list before hanging up, so whoever waits for the fill owns
+            // the render again once `RasterFill::wait` returns.
+            drop(tile_list);
+            drop(tx);
+        });
+
+        match spawned {
+            Ok(_) => Some(Self {
+                cancelled,
+                viewport,
+                batches: rx,
+            }),
+            Err(e) => {
+                log::error!("Failed to spawn raster fill thread: {e}");
+                None
+            }
+        }
+    }
+
+    /// Updates the viewport (in page coordinates) and scroll direction the remaining tiles are
+    /// prioritised against.
+    pub fn set_viewport(&self, visible: Rect, scroll_dir: f64) {
+        *self.viewport.lock() = (visible, scroll_dir);
+    }
+
+    /// Stops the fill at the next batch boundary. Batches already finished can still be taken.
+    pub fn cancel(&self) {
+        self.cancelled.store(true, Ordering::Relaxed);
+    }
+
+    /// Takes the batches finished since the last call, without blocking. The flag is `true` once
+    /// the fill is over (every batch has been taken, or it was cancelled).
+    pub fn try_take(&self) -> (Vec<FillBatch>, bool) {
+        let mut batches = Vec::new();
+        loop {
+            match self.batches.try_recv() {
+                Ok(batch) => batches.push(batch),
+                Err(mpsc::TryRecvError::Empty) => return (batches, false),
+                Err(mpsc::TryRecvError::Disconnected) => return (batches, true),
+            }
+        }
+    }
+
+    /// Blocks until the fill is over and returns every batch not taken yet. By then the fill
+    /// thread holds no reference to the tile list it was started with.
+    pub fn wait(self) -> Vec<FillBatch> {
+        self.batches.iter().collect()
+    }
+}
+
+impl Drop for RasterFill {
+    fn drop(&mut self) {
+        self.cancel();
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -7,11 +7,11 @@ pub mod tile_composite;
 pub mod viewport;
 
 pub use backend::{
-    blend_over_argb_u32, CompositorSink, ErasedSurface, ExternalHandle, GpuPixelFormat, PixelFormat, PresentMode,
-    RenderBackend, RgbaImage, SurfaceRect, SurfaceSize, WgpuTextureId,
+    blend_over_argb_u32, CompositorSink, ErasedSurface, ExternalHandle, GpuPixelFormat, LayerAnimation, LayerProperty,
+    PixelFormat, PresentMode, RenderBackend, RgbaImage, SurfaceRect, SurfaceSize, WgpuTextureId,
 };
 pub use compositor::DefaultCompositor;
 pub use render_context::RenderContext;
 pub use render_list::{Color, DisplayItem, RenderList};
-pub use tile_composite::{argb_u32_to_rgba8, composite_tiles, TileTarget};
+pub use tile_composite::{argb_u32_to_rgba8, argb_u32_to_rgba8_into, composite_tiles, TileTarget};
 pub use viewport::{DevicePixelRatio, Viewport, DEVICE_PIXEL_RATIO};
@@ -1,15 +1,114 @@
-use crate::render::backend::{CompositorSink, ExternalHandle};
+use crate::render::backend::{CompositorSink, ExternalHandle, LayerAnimation, LayerProperty};
+use gosub_shared::animation::{ScrollAnimator, ScrollBehavior};
 use gosub_shared::tab_id::TabId;
-use parking_lot::RwLock;
+use parking_lot::{Mutex, RwLock};
 use std::collections::HashMap;
 use std::sync::Arc;
+use std::time::Instant;
 
 /// Default compositor: keeps the latest frame per tab and requests a redraw on submit.
+///
+/// Scroll and layer animations handed to it ([`CompositorSink::scroll_to`],
+/// [`CompositorSink::animate_layer`]) run on the host's draw loop: [`Self::frame_for`] advances
+/// them to the current time, applies them to the tab's latest `TileCache` frame and requests the
+/// next redraw while any is still running. The tab's worker is not involved until it submits a
+/// new frame.
 pub struct DefaultCompositor {
     frames: Arc<RwLock<HashMap<TabId, ExternalHandle>>>,
+    animations: Mutex<HashMap<TabId, TabAnimations>>,
     redraw_cb: Box<dyn Fn() + Send + Sync + 'static>,
 }
 
+/// A smooth scroll in flight, eased per axis toward `target`.
+struct ScrollTrack {
+    pos: (f64, f64),
+    target: (f64, f64),
+    axes: (Box<dyn ScrollAnimator>, Box<dyn ScrollAnimator>),
+    /// When `pos` was last advanced.
+    last: Instant,
+}
+
+struct RunningLayer {
+    animation: LayerAnimation,
+    started: Instant,
+}
+
+/// The animations applied to one tab's frames.
+#[derive(Default)]
+struct TabAnimations {
+    scroll: Option<ScrollTrack>,
+    layers: HashMap<u64, RunningLayer>,
+}
+
+impl TabAnimations {
+    /// Advances the animations to `now` and applies them to `handle`. Returns whether any is still
+    /// running. Only `TileCache` frames can be animated; anything else is presented as-is.
+    fn apply(&mut self, handle: &mut ExternalHandle, now: Instant) -> bool {
+        let ExternalHandle::TileCache {
+            scroll_x,
+            scroll_y,
+            tiles,
+            ..
+        } = handle
+        else {
+            return false;
+        };
+        let mut running = false;
+
+        if let Some(track) = &mut self.scroll {
+            let dt = now.saturating_duration_since(track.last).as_secs_f64();
+            track.last = now;
+            track.pos.0 = track.axes.0.step(track.target.0, dt);
+            track.pos.1 = track.axes.1.step(track.target.1, dt);
+            *scroll_x = track.pos.0 as f32;
+            *scroll_y = track.pos.1 as f32;
+            if track.axes.0.settled() && track.axes.1.settled() {
+                *scroll_x = track.target.0 as f32;
+                *scroll_y = track.target.1 as f32;
+                self.scroll = None;
+            } else {
+                running = true;
+            }
+        }
+
+        if !self.layers.is_empty() {
+            let values: HashMap<u64, (LayerProperty, f32)> = self
+                .layers
+                .iter()
+                .map(|(&id, layer)| {
+                    let (t, finished) = layer.animation.progress(now.saturating_duration_since(layer.started));
+                    running |= !finished;
+                    (id, (layer.animation.property, t))
+                })
+                .collect();
+            let mut animated = tiles.as_ref().clone();
+            for tile in &mut animated {
+                match values.get(&tile.layer_id) {
+                    Some((LayerProperty::Opacity { from, to }, t)) => {
+                        tile.opacity = (from + (to - from) * t).clamp(0.0, 1.0);
+                    }
+                    Some((LayerProperty::Translate { from, to }, t)) => {
+                        tile.page_x += from.0 + (to.0 - from.0) * t;
+                        tile.page_y += from.1 + (to.1 - from.1) * t;
+                    }
+                    None => {}
+                }
+            }
+            *tiles = Arc::new(animated);
+        }
+
+        running
+    }
+}
+
+/// Scroll offset a frame is presented at, if it is a `TileCache` frame.
+fn frame_scroll(handle: &ExternalHandle) -> Option<(f32, f32)> {
+    match handle {
+        ExternalHandle::TileCache { scroll_x, scroll_y, .. } => Some((*scroll_x, *scroll_y)),
+        _ => None,
+    }
+}
+
 impl Default for DefaultCompositor {
     fn default() -> Self {
         Self::new(|| {})
@@ -20,6 +119,7 @@ impl DefaultCompositor {
     pub fn new<F: Fn() + Send + Sync + 'static>(redraw_cb: F) -> Self {
         Self {
             frames: Arc::new(RwLock::new(HashMap::new())),
+            animations: Mutex::new(HashMap::new()),
             redraw_cb: Box::new(redraw_cb),
         }
     }
@@ -29,19 +129,252 @@ impl DefaultCompositor {
     }
 
     /// Lets external code (e.g. a UI layer) read the latest frame per tab without owning
-    /// the compositor.
+    /// the compositor. Frames read this way are as submitted, without running animations.
     pub fn frames_arc(&self) -> Arc<RwLock<HashMap<TabId, ExternalHandle>>> {
         self.frames.clone()
     }
 
+    /// The tab's latest frame with its running animations applied at the current time.
     pub fn frame_for(&self, tab_id: TabId) -> Option<ExternalHandle> {
-        self.frames.read().get(&tab_id).cloned()
+        self.frame_at(tab_id, Instant::now())
+    }
+
+    fn frame_at(&self, tab_id: TabId, now: Instant) -> Option<ExternalHandle> {
+        let mut handle = self.frames.read().get(&tab_id).cloned()?;
+        let running = {
+            let mut animations = self.animations.lock();
+            match animations.get_mut(&tab_id) {
+                Some(tab) => tab.apply(&mut handle, now),
+                None => false,
+            }
+        };
+        if running {
+            self.request_redraw();
+        }
+        Some(handle)
     }
 }
 
 impl CompositorSink for DefaultCompositor {
     fn submit_frame(&self, tab_id: TabId, handle: ExternalHandle) {
+        // A frame away from the scroll target means the tab moved the scroll itself (navigation,
+        // an instant scroll); it wins over the animation.
+        if let Some((x, y)) = frame_scroll(&handle) {
+            if let Some(tab) = self.animations.lock().get_mut(&tab_id) {
+                let moved = tab
+                    .scroll
+                    .as_ref()
+                    .is_some_and(|s| (s.target.0 - x as f64).abs() >= 0.5 || (s.target.1 - y as f64).abs() >= 0.5);
+                if moved {
+                    tab.scroll = None;
+                }
+            }
+        }
         self.frames.write().insert(tab_id, handle);
         self.request_redraw();
     }
+
+    fn scroll_to(&self, tab_id: TabId, target: (f32, f32), behavior: &ScrollBehavior) -> bool {
+        let mut animations = self.animations.lock();
+        let tab = animations.entry(tab_id).or_default();
+        let target = (target.0 as f64, target.1 as f64);
+        if matches!(behavior, ScrollBehavior::Instant) {
+            // Nothing to animate: the tab's next frame lands at the target.
+            tab.scroll = None;
+            return true;
+        }
+        if let Some(track) = &mut tab.scroll {
+            // Retarget: the animators carry on from where they are.
+            track.target = target;
+            return true;
+        }
+
+        // Start from where the latest frame is presented.
+        let Some(start) = self.frames.read().get(&tab_id).and_then(frame_scroll) else {
+            return false;
+        };
+        let start = (start.0 as f64, start.1 as f64);
+        let (Some(ax), Some(ay)) = (behavior.make_animator(start.0), behavior.make_animator(start.1)) else {
+            return true;
+        };
+        tab.scroll = Some(ScrollTrack {
+            pos: start,
+            target,
+            axes: (ax, ay),
+            last: Instant::now(),
+        });
+        drop(animations);
+        self.request_redraw();
+        true
+    }
+
+    fn animate_layer(&self, tab_id: TabId, layer_id: u64, animation: Option<LayerAnimation>) -> bool {
+        {
+            let mut animations = self.animations.lock();
+            let tab = animations.entry(tab_id).or_default();
+            match animation {
+                Some(animation) => {
+                    tab.layers.insert(
+                        layer_id,
+                        RunningLayer {
+                            animation,
+                            started: Instant::now(),
+                        },
+                    );
+                }
+                None => {
+                    tab.layers.remove(&layer_id);
+                }
+            }
+        }
+        self.request_redraw();
+        true
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::render::backend::{CachedTile, PixelFormat, TileAnchor};
+    use gosub_shared::animation::Easing;
+    use std::sync::atomic::{AtomicUsize, Ordering};
+    use std::time::Duration;
+
+    fn tile(layer_id: u64) -> CachedTile {
+        CachedTile {
+            page_x: 0.0,
+            page_y: 0.0,
+            width: 1,
+            height: 1,
+            data: bytes::Bytes::from_static(&[0, 0, 0, 255]),
+            format: PixelFormat::Rgba8,
+            opacity: 1.0,
+            anchor: TileAnchor::Scroll,
+            layer_id,
+            opaque: true,
+        }
+    }
+
+    fn frame(scroll_y: f32) -> ExternalHandle {
+        ExternalHandle::TileCache {
+            viewport_width: 100,
+            viewport_height: 100,
+            dpr: 1,
+            scroll_x: 0.0,
+            scroll_y,
+            page_height: 1000.0,
+            tiles: Arc::new(vec![tile(0), tile(1)]),
+        }
+    }
+
+    fn presented(handle: &ExternalHandle) -> (f32, Vec<(f32, f32)>) {
+        match handle {
+            ExternalHandle::TileCache { scroll_y, tiles, .. } => {
+                (*scroll_y, tiles.iter().map(|t| (t.opacity, t.page_y)).collect())
+            }
+            _ => panic!("not a tile cache frame"),
+        }
+    }
+
+    fn linear(ms: u64) -> ScrollBehavior {
+        ScrollBehavior::Tween {
+            duration: Duration::from_millis(ms),
+            easing: Easing::Linear,
+        }
+    }
+
+    #[test]
+    fn eases_scroll_between_frames() {
+        let redraws = Arc::new(AtomicUsize::new(0));
+        let counter = Arc::clone(&redraws);
+        let compositor = DefaultCompositor::new(move || {
+            counter.fetch_add(1, Ordering::Relaxed);
+        });
+        let tab = TabId::new();
+        compositor.submit_frame(tab, frame(0.0));
+        assert!(compositor.scroll_to(tab, (0.0, 100.0), &linear(100)));
+        compositor.submit_frame(tab, frame(100.0));
+
+        let start = compositor.animations.lock()[&tab]
+            .scroll
+            .as_ref()
+            .map(|s| s.last)
+            .expect("track");
+        let half = compositor
+            .frame_at(tab, start + Duration::from_millis(50))
+            .expect("frame");
+        assert!((presented(&half).0 - 50.0).abs() < 1.0, "{:?}", presented(&half));
+
+        let before = redraws.load(Ordering::Relaxed);
+        let end = compositor
+            .frame_at(tab, start + Duration::from_millis(150))
+            .expect("frame");
+        assert_eq!(presented(&end).0, 100.0);
+        // Settled: nothing left to redraw for.
+        assert_eq!(redraws.load(Ordering::Relaxed), before);
+        assert!(compositor.animations.lock()[&tab].scroll.is_none());
+    }
+
+    #[test]
+    fn a_frame_elsewhere_cancels_the_scroll() {
+        let compositor = DefaultCompositor::default();
+        let tab = TabId::new();
+        assert!(
+            !compositor.scroll_to(tab, (0.0, 100.0), &linear(100)),
+            "no frame to start from"
+        );
+
+        compositor.submit_frame(tab, frame(0.0));
+        assert!(compositor.scroll_to(tab, (0.0, 100.0), &linear(100)));
+        compositor.submit_frame(tab, frame(0.0));
+        let now = compositor.frame_at(tab, Instant::now() + Duration::from_millis(50));
+        assert_eq!(presented(&now.expect("frame")).0, 0.0);
+    }
+
+    #[test]
+    fn animates_one_layer_and_holds_the_end_value() {
+        let compositor = DefaultCompositor::default();
+        let tab = TabId::new();
+        compositor.submit_frame(tab, frame(0.0));
+        let fade = LayerAnimation {
+            property: LayerProperty::Opacity { from: 1.0, to: 0.0 },
+            duration: Duration::from_millis(100),
+            easing: Easing::Linear,
+            iterations: Some(1),
+            alternate: false,
+        };
+        assert!(compositor.animate_layer(tab, 1, Some(fade)));
+        let slide = LayerAnimation {
+            property: LayerProperty::Translate {
+                from: (0.0, 0.0),
+                to: (0.0, 40.0),
+            },
+            duration: Duration::from_millis(100),
+            easing: Easing::Linear,
+            iterations: None,
+            alternate: true,
+        };
+        assert!(compositor.animate_layer(tab, 0, Some(slide)));
+
+        let started = compositor.animations.lock()[&tab].layers[&1].started;
+        let (_, tiles) = presented(
+            &compositor
+                .frame_at(tab, started + Duration::from_millis(50))
+                .expect("frame"),
+        );
+        assert!((tiles[1].0 - 0.5).abs() < 0.01, "{tiles:?}");
+        assert!((tiles[0].1 - 20.0).abs() < 1.0, "{tiles:?}");
+
+        let (_, tiles) = presented(
+            &compositor
+                .frame_at(tab, started + Duration::from_millis(500))
+                .expect("frame"),
+        );
+        assert_eq!(tiles[1].0, 0.0);
+        assert_eq!(tiles[0].0, 1.0);
+
+        compositor.animate_layer(tab, 1, None);
+        let (_, tiles) = presented(&compositor.frame_for(tab).expect("frame"));
+        assert_eq!(tiles[1].0, 1.0);
+    }
 }
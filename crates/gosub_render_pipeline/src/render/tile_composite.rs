@@ -11,8 +11,24 @@
 //! composite into a [`TileTarget`] region of it, and then either present the `u32` buffer directly
 //! (softbuffer ignores the high byte) or convert it to RGBA8 for a GPU texture via
 //! [`argb_u32_to_rgba8`].
+//!
+//! # Kernels
+//!
+//! Rows are blended [`LANES`] pixels at a time. Each CPU gets the widest hand-written kernel it
+//! supports, picked at runtime: AVX2 or SSE2 on x86_64, NEON on little-endian aarch64. Everything
+//! else runs the portable SWAR kernel (two 8-bit channels per 32-bit lane, as in
+//! [`blend_over_argb_u32`]), which is also the reference the SIMD kernels are tested against. All
+//! kernels are monomorphized per source format and opacity so the inner loops carry no per-pixel
+//! decisions. Whole lane groups that are fully transparent are skipped, fully opaque ones copied,
+//! and tiles known to be opaque take a plain row copy.
+//!
+//! The crate denies `unsafe_code` rather than forbidding it, so each call into a
+//! `#[target_feature]` kernel is allowed at its call site, directly behind the runtime feature
+//! check that makes it sound.
+//!
+//! [`blend_over_argb_u32`]: crate::render::backend::blend_over_argb_u32
 
-use crate::render::backend::{anchored_tile_pos, blend_over_argb_u32, scale_premul_argb_u32, CachedTile};
+use crate::render::backend::{anchored_tile_pos, CachedTile, PixelFormat};
 
 /// A rectangular region of a premultiplied-ARGB (`0xAARRGGBB`) `u32` buffer that tiles composite
 /// into.
@@ -70,6 +86,7 @@ pub fn composite_tiles(tiles: &[CachedTile], dpr: u32, scroll: (f32, f32), targe
         let th = th as usize;
 
         let src_u32 = bytemuck::cast_slice::<u8, u32>(&tile.data);
+        let kernel = row_kernel(tile);
 
         for tile_row in row0..th {
             let dst_y = dst_y0 + (tile_row - row0);
@@ -82,12 +99,401 @@ pub fn composite_tiles(tiles: &[CachedTile], dpr: u32, scroll: (f32, f32), targe
             }
             let buf_row = (target.origin_y + dst_y) * target.stride + target.origin_x + dst_x;
             let src_row = tile_row * tw + col0;
-            for col in 0..copy_w {
-                let src_argb = tile.format.pixel_to_argb_u32(src_u32[src_row + col]);
-                target.buf[buf_row + col] =
-                    blend_over_argb_u32(scale_premul_argb_u32(src_argb, tile.opacity), target.buf[buf_row + col]);
+            kernel(
+                &mut target.buf[buf_row..buf_row + copy_w],
+                &src_u32[src_row..src_row + copy_w],
+            );
+        }
+    }
+}
+
+/// Pixels per kernel step: one AVX2 register of `u32`s, two SSE2 ones, one NEON four-register
+/// load.
+pub const LANES: usize = 8;
+
+/// Picks the row kernel for `tile`: a copy for opaque tiles at full opacity, otherwise a
+/// source-over blend, each specialised for the tile's pixel format.
+fn row_kernel(tile: &CachedTile) -> impl Fn(&mut [u32], &[u32]) {
+    let swap = tile.format == PixelFormat::Rgba8;
+    let fade = tile.opacity < 1.0;
+    let factor = opacity_factor(tile.opacity);
+    let opaque = tile.opaque && !fade;
+    move |dst, src| match (opaque, swap, fade) {
+        (true, false, _) => dst.copy_from_slice(src),
+        (true, true, _) => copy_row::<true>(dst, src),
+        (false, false, false) => simd::blend_row::<false, false>(dst, src, factor),
+        (false, false, true) => simd::blend_row::<false, true>(dst, src, factor),
+        (false, true, false) => simd::blend_row::<true, false>(dst, src, factor),
+        (false, true, true) => simd::blend_row::<true, true>(dst, src, factor),
+    }
+}
+
+/// `opacity` (0.0..=1.0) as an 8-bit factor, rounded like [`scale_premul_argb_u32`].
+///
+/// [`scale_premul_argb_u32`]: crate::render::backend::scale_premul_argb_u32
+fn opacity_factor(opacity: f32) -> u32 {
+    (opacity.clamp(0.0, 1.0) * 255.0 + 0.5) as u32
+}
+
+/// Copies a row of opaque source pixels into `dst`, converting RGBA8 to ARGB when `SWAP`.
+fn copy_row<const SWAP: bool>(dst: &mut [u32], src: &[u32]) {
+    for (d, &s) in dst.iter_mut().zip(src) {
+        *d = if SWAP { swap_rb(s) } else { s };
+    }
+}
+
+/// Source-over blends a row of premultiplied source pixels onto `dst`, converting RGBA8 to ARGB
+/// when `SWAP` and scaling every channel by `factor` / 255 first when `FADE`.
+///
+/// This is the portable SWAR kernel: the fallback where no SIMD kernel applies, and the reference
+/// the SIMD kernels must match bit for bit.
+fn blend_row<const SWAP: bool, const FADE: bool>(dst: &mut [u32], src: &[u32], factor: u32) {
+    let mut dst_chunks = dst.chunks_exact_mut(LANES);
+    let mut src_chunks = src.chunks_exact(LANES);
+    for (d, s) in (&mut dst_chunks).zip(&mut src_chunks) {
+        match classify_group::<FADE>(s) {
+            Group::Transparent => {}
+            Group::Opaque => copy_row::<SWAP>(d, s),
+            Group::Mixed => blend_lanes::<SWAP, FADE>(d, s, factor),
+        }
+    }
+    blend_lanes::<SWAP, FADE>(dst_chunks.into_remainder(), src_chunks.remainder(), factor);
+}
+
+/// What a group of [`LANES`] source pixels needs from the blend.
+enum Group {
+    /// Every pixel is fully transparent: nothing to add.
+    Transparent,
+    /// Every pixel is opaque and the tile isn't faded: a plain copy.
+    Opaque,
+    Mixed,
+}
+
+#[inline(always)]
+fn classify_group<const FADE: bool>(src: &[u32]) -> Group {
+    if src.iter().fold(0, |acc, &p| acc | p) >> 24 == 0 {
+        Group::Transparent
+    } else if !FADE && src.iter().fold(u32::MAX, |acc, &p| acc & p) >> 24 == 0xFF {
+        Group::Opaque
+    } else {
+        Group::Mixed
+    }
+}
+
+/// The per-pixel kernel: straight-line integer code with no data-dependent branches, so it
+/// vectorizes across the lanes.
+#[inline(always)]
+fn blend_lanes<const SWAP: bool, const FADE: bool>(dst: &mut [u32], src: &[u32], factor: u32) {
+    for (d, &s) in dst.iter_mut().zip(src) {
+        let s = if SWAP { swap_rb(s) } else { s };
+        let s = if FADE { scale_pairs(s, factor) } else { s };
+        let inv = 255 - (s >> 24);
+        let rb = (s & 0x00FF_00FF) + mul_div255_pair(*d & 0x00FF_00FF, inv);
+        let ag = ((s >> 8) & 0x00FF_00FF) + mul_div255_pair((*d >> 8) & 0x00FF_00FF, inv);
+        *d = (rb & 0x00FF_00FF) | ((ag & 0x00FF_00FF) << 8);
+    }
+}
+
+/// Swaps the red and blue channels: RGBA8 read as `0xAABBGGRR` becomes `0xAARRGGBB`, and back.
+#[inline(always)]
+fn swap_rb(px: u32) -> u32 {
+    (px & 0xFF00_FF00) | ((px >> 16) & 0xFF) | ((px & 0xFF) << 16)
+}
+
+/// Multiplies all four channels of `px` by `factor` (0..=255) / 255 with rounding, R/B and A/G as
+/// two channel pairs.
+#[inline(always)]
+fn scale_pairs(px: u32, factor: u32) -> u32 {
+    let rb = mul_div255_pair(px & 0x00FF_00FF, factor);
+    let ag = mul_div255_pair((px >> 8) & 0x00FF_00FF, factor);
+    rb | (ag << 8)
+}
+
+/// `x * factor / 255`, rounded, for both channels of `0x00XX00YY` at once.
+#[inline(always)]
+fn mul_div255_pair(pair: u32, factor: u32) -> u32 {
+    let t = pair * factor + 0x0080_0080;
+    ((t + ((t >> 8) & 0x00FF_00FF)) >> 8) & 0x00FF_00FF
+}
+
+/// Hand-written SIMD versions of the SWAR [`blend_row`], picked at runtime.
+///
+/// Each kernel computes exactly what [`blend_lanes`] does, with one 16-bit lane per channel instead
+/// of two channels per 32-bit lane: `x * f / 255` rounds as `t = x * f + 128; (t + (t >> 8)) >> 8`
+/// and the channel sum wraps to 8 bits, so the results are bit-identical. Group classification and
+/// the row tail are shared with the SWAR kernel.
+mod simd {
+    /// [`blend_row`](super::blend_row) on the widest kernel this CPU supports.
+    pub(super) fn blend_row<const SWAP: bool, const FADE: bool>(dst: &mut [u32], src: &[u32], factor: u32) {
+        #[cfg(target_arch = "x86_64")]
+        if std::arch::is_x86_feature_detected!("avx2") {
+            // SAFETY: the CPU supports AVX2, checked just above.
+            #[allow(unsafe_code)]
+            unsafe {
+                x86::blend_row_avx2::<SWAP, FADE>(dst, src, factor)
+            };
+            return;
+        } else if std::arch::is_x86_feature_detected!("sse2") {
+            // SAFETY: the CPU supports SSE2, checked just above.
+            #[allow(unsafe_code)]
+            unsafe {
+                x86::blend_row_sse2::<SWAP, FADE>(dst, src, factor)
+            };
+            return;
+        }
+        #[cfg(all(target_arch = "aarch64", target_endian = "little"))]
+        if std::arch::is_aarch64_feature_detected!("neon") {
+            // SAFETY: the CPU supports NEON, checked just above.
+            #[allow(unsafe_code)]
+            unsafe {
+                neon::blend_row_neon::<SWAP, FADE>(dst, src, factor)
+            };
+            return;
+        }
+        super::blend_row::<SWAP, FADE>(dst, src, factor)
+    }
+
+    /// Row kernel signature shared by every implementation.
+    #[cfg(test)]
+    pub(super) type RowFn = fn(&mut [u32], &[u32], u32);
+
+    /// Every SIMD kernel this CPU can run, by name.
+    #[cfg(test)]
+    pub(super) fn available<const SWAP: bool, const FADE: bool>() -> Vec<(&'static str, RowFn)> {
+        #[allow(unused_mut)]
+        let mut kernels: Vec<(&'static str, RowFn)> = Vec::new();
+        #[cfg(target_arch = "x86_64")]
+        {
+            if std::arch::is_x86_feature_detected!("avx2") {
+                // SAFETY: only handed out after the AVX2 check above.
+                #[allow(unsafe_code)]
+                kernels.push(("avx2", |d, s, f| unsafe { x86::blend_row_avx2::<SWAP, FADE>(d, s, f) }));
+            }
+            if std::arch::is_x86_feature_detected!("sse2") {
+                // SAFETY: only handed out after the SSE2 check above.
+                #[allow(unsafe_code)]
+                kernels.push(("sse2", |d, s, f| unsafe { x86::blend_row_sse2::<SWAP, FADE>(d, s, f) }));
             }
         }
+        #[cfg(all(target_arch = "aarch64", target_endian = "little"))]
+        if std::arch::is_aarch64_feature_detected!("neon") {
+            // SAFETY: only handed out after the NEON check above.
+            #[allow(unsafe_code)]
+            kernels.push(("neon", |d, s, f| unsafe { neon::blend_row_neon::<SWAP, FADE>(d, s, f) }));
+        }
+        kernels
+    }
+
+    #[cfg(target_arch = "x86_64")]
+    mod x86 {
+        use super::super::{blend_lanes, classify_group, copy_row, Group, LANES};
+        use std::arch::x86_64::*;
+
+        /// Eight pixels per group in one 256-bit register.
+        ///
+        /// # Safety
+        ///
+        /// The CPU must support AVX2.
+        #[allow(unsafe_code)]
+        #[target_feature(enable = "avx2")]
+        pub(super) unsafe fn blend_row_avx2<const SWAP: bool, const FADE: bool>(
+            dst: &mut [u32],
+            src: &[u32],
+            factor: u32,
+        ) {
+            let f = _mm256_set1_epi16(factor as i16);
+            let zero = _mm256_setzero_si256();
+            let mut dst_chunks = dst.chunks_exact_mut(LANES);
+            let mut src_chunks = src.chunks_exact(LANES);
+            for (d, s) in (&mut dst_chunks).zip(&mut src_chunks) {
+                match classify_group::<FADE>(s) {
+                    Group::Transparent => {}
+                    Group::Opaque => copy_row::<SWAP>(d, s),
+                    Group::Mixed => {
+                        // SAFETY: both chunks are exactly LANES = 8 `u32`s, i.e. one unaligned
+                        // 256-bit load or store each.
+                        let dv = _mm256_loadu_si256(d.as_ptr().cast());
+                        let sv = _mm256_loadu_si256(s.as_ptr().cast());
+                        // Unpacking and packing both work per 128-bit half, so pixel order
+                        // survives the round trip.
+                        let lo = blend_wide_avx2::<SWAP, FADE>(
+                            _mm256_unpacklo_epi8(dv, zero),
+                            _mm256_unpacklo_epi8(sv, zero),
+                            f,
+                        );
+                        let hi = blend_wide_avx2::<SWAP, FADE>(
+                            _mm256_unpackhi_epi8(dv, zero),
+                            _mm256_unpackhi_epi8(sv, zero),
+                            f,
+                        );
+                        _mm256_storeu_si256(d.as_mut_ptr().cast(), _mm256_packus_epi16(lo, hi));
+                    }
+                }
+            }
+            blend_lanes::<SWAP, FADE>(dst_chunks.into_remainder(), src_chunks.remainder(), factor);
+        }
+
+        /// Source-over on four pixels widened to 16-bit channels `[c0, c1, c2, a]`.
+        #[allow(unsafe_code)]
+        #[target_feature(enable = "avx2")]
+        #[inline]
+        unsafe fn blend_wide_avx2<const SWAP: bool, const FADE: bool>(d: __m256i, s: __m256i, f: __m256i) -> __m256i {
+            let s = if SWAP {
+                _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, SWAP_C0_C2), SWAP_C0_C2)
+            } else {
+                s
+            };
+            let s = if FADE { mul_div255_avx2(s, f) } else { s };
+            let alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, BROADCAST_A), BROADCAST_A);
+            let inv = _mm256_sub_epi16(_mm256_set1_epi16(255), alpha);
+            let sum = _mm256_add_epi16(s, mul_div255_avx2(d, inv));
+            _mm256_and_si256(sum, _mm256_set1_epi16(0xFF))
+        }
+
+        #[allow(unsafe_code)]
+        #[target_feature(enable = "avx2")]
+        #[inline]
+        unsafe fn mul_div255_avx2(x: __m256i, f: __m256i) -> __m256i {
+            let t = _mm256_add_epi16(_mm256_mullo_epi16(x, f), _mm256_set1_epi16(0x80));
+            _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8)
+        }
+
+        /// Eight pixels per group in two 128-bit registers.
+        ///
+        /// # Safety
+        ///
+        /// The CPU must support SSE2.
+        #[allow(unsafe_code)]
+        #[target_feature(enable = "sse2")]
+        pub(super) unsafe fn blend_row_sse2<const SWAP: bool, const FADE: bool>(
+            dst: &mut [u32],
+            src: &[u32],
+            factor: u32,
+        ) {
+            let f = _mm_set1_epi16(factor as i16);
+            let mut dst_chunks = dst.chunks_exact_mut(LANES);
+            let mut src_chunks = src.chunks_exact(LANES);
+            for (d, s) in (&mut dst_chunks).zip(&mut src_chunks) {
+                match classify_group::<FADE>(s) {
+                    Group::Transparent => {}
+                    Group::Opaque => copy_row::<SWAP>(d, s),
+                    Group::Mixed => {
+                        for (d, s) in d.chunks_exact_mut(4).zip(s.chunks_exact(4)) {
+                            // SAFETY: LANES is a multiple of four, so both halves are exactly four
+                            // `u32`s, i.e. one unaligned 128-bit load or store each.
+                            let dv = _mm_loadu_si128(d.as_ptr().cast());
+                            let sv = _mm_loadu_si128(s.as_ptr().cast());
+                            _mm_storeu_si128(d.as_mut_ptr().cast(), blend4_sse2::<SWAP, FADE>(dv, sv, f));
+                        }
+                    }
+                }
+            }
+            blend_lanes::<SWAP, FADE>(dst_chunks.into_remainder(), src_chunks.remainder(), factor);
+        }
+
+        #[allow(unsafe_code)]
+        #[target_feature(enable = "sse2")]
+        #[inline]
+        unsafe fn blend4_sse2<const SWAP: bool, const FADE: bool>(d: __m128i, s: __m128i, f: __m128i) -> __m128i {
+            let zero = _mm_setzero_si128();
+            let lo = blend_wide_sse2::<SWAP, FADE>(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero), f);
+            let hi = blend_wide_sse2::<SWAP, FADE>(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero), f);
+            _mm_packus_epi16(lo, hi)
+        }
+
+        /// Source-over on two pixels widened to 16-bit channels `[c0, c1, c2, a]`.
+        #[allow(unsafe_code)]
+        #[target_feature(enable = "sse2")]
+        #[inline]
+        unsafe fn blend_wide_sse2<const SWAP: bool, const FADE: bool>(d: __m128i, s: __m128i, f: __m128i) -> __m128i {
+            let s = if SWAP {
+                _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, SWAP_C0_C2), SWAP_C0_C2)
+            } else {
+                s
+            };
+            let s = if FADE { mul_div255_sse2(s, f) } else { s };
+            let alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, BROADCAST_A), BROADCAST_A);
+            let inv = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+            let sum = _mm_add_epi16(s, mul_div255_sse2(d, inv));
+            _mm_and_si128(sum, _mm_set1_epi16(0xFF))
+        }
+
+        #[allow(unsafe_code)]
+        #[target_feature(enable = "sse2")]
+        #[inline]
+        unsafe fn mul_div255_sse2(x: __m128i, f: __m128i) -> __m128i {
+            let t = _mm_add_epi16(_mm_mullo_epi16(x, f), _mm_set1_epi16(0x80));
+            _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8)
+        }
+
+        /// 16-bit shuffle swapping channels 0 and 2 of each pixel (RGBA8 to ARGB order).
+        const SWAP_C0_C2: i32 = 0b11_00_01_10;
+        /// 16-bit shuffle broadcasting each pixel's alpha to all four of its channels.
+        const BROADCAST_A: i32 = 0b11_11_11_11;
+    }
+
+    #[cfg(all(target_arch = "aarch64", target_endian = "little"))]
+    mod neon {
+        use super::super::{blend_lanes, classify_group, copy_row, Group, LANES};
+        use std::arch::aarch64::*;
+
+        /// Eight pixels per group, de-interleaved into one 8×8-bit register per channel.
+        ///
+        /// # Safety
+        ///
+        /// The CPU must support NEON.
+        #[allow(unsafe_code)]
+        #[target_feature(enable = "neon")]
+        pub(super) unsafe fn blend_row_neon<const SWAP: bool, const FADE: bool>(
+            dst: &mut [u32],
+            src: &[u32],
+            factor: u32,
+        ) {
+            let f = vdup_n_u8(factor as u8);
+            let mut dst_chunks = dst.chunks_exact_mut(LANES);
+            let mut src_chunks = src.chunks_exact(LANES);
+            for (d, s) in (&mut dst_chunks).zip(&mut src_chunks) {
+                match classify_group::<FADE>(s) {
+                    Group::Transparent => {}
+                    Group::Opaque => copy_row::<SWAP>(d, s),
+                    Group::Mixed => {
+                        // SAFETY: both chunks are exactly LANES = 8 `u32`s, i.e. the 32 bytes one
+                        // four-register load or store covers. Little-endian pixels de-interleave to
+                        // channels [c0, c1, c2, a].
+                        let dv = vld4_u8(d.as_ptr().cast());
+                        let sv = vld4_u8(s.as_ptr().cast());
+                        let (s0, s2) = if SWAP { (sv.2, sv.0) } else { (sv.0, sv.2) };
+                        let (s0, s1, s2, s3) = if FADE {
+                            (
+                                mul_div255(s0, f),
+                                mul_div255(sv.1, f),
+                                mul_div255(s2, f),
+                                mul_div255(sv.3, f),
+                            )
+                        } else {
+                            (s0, sv.1, s2, sv.3)
+                        };
+                        let inv = vmvn_u8(s3);
+                        let out = uint8x8x4_t(
+                            vadd_u8(s0, mul_div255(dv.0, inv)),
+                            vadd_u8(s1, mul_div255(dv.1, inv)),
+                            vadd_u8(s2, mul_div255(dv.2, inv)),
+                            vadd_u8(s3, mul_div255(dv.3, inv)),
+                        );
+                        vst4_u8(d.as_mut_ptr().cast(), out);
+                    }
+                }
+            }
+            blend_lanes::<SWAP, FADE>(dst_chunks.into_remainder(), src_chunks.remainder(), factor);
+        }
+
+        #[allow(unsafe_code)]
+        #[target_feature(enable = "neon")]
+        #[inline]
+        unsafe fn mul_div255(x: uint8x8_t, f: uint8x8_t) -> uint8x8_t {
+            let t = vaddq_u16(vmull_u8(x, f), vdupq_n_u16(0x80));
+            vshrn_n_u16::<8>(vaddq_u16(t, vshrq_n_u16::<8>(t)))
+        }
     }
 }
 
@@ -96,18 +502,21 @@ pub fn composite_tiles(tiles: &[CachedTile], dpr: u32, scroll: (f32, f32), targe
 /// Alpha is forced opaque: the compositor blends onto an opaque background, so every output pixel
 /// is opaque, and this is the layout wgpu/egui textures expect.
 pub fn argb_u32_to_rgba8(buf: &[u32]) -> Vec<u8> {
-    let mut rgba = Vec::with_capacity(buf.len() * 4);
-    for &px in buf {
-        rgba.extend_from_slice(&[
-            ((px >> 16) & 0xFF) as u8, // R
-            ((px >> 8) & 0xFF) as u8,  // G
-            (px & 0xFF) as u8,         // B
-            255,                       // A (opaque)
-        ]);
-    }
+    let mut rgba = Vec::new();
+    argb_u32_to_rgba8_into(buf, &mut rgba);
     rgba
 }
 
+/// [`argb_u32_to_rgba8`] into a caller-owned buffer, so a host converting every frame can reuse
+/// one allocation. `out` is resized to `buf.len() * 4`.
+pub fn argb_u32_to_rgba8_into(buf: &[u32], out: &mut Vec<u8>) {
+    out.resize(buf.len() * 4, 0);
+    for (rgba, &px) in out.chunks_exact_mut(4).zip(buf) {
+        // `0xAARRGGBB` -> `0xFFBBGGRR`, whose little-endian bytes are [R, G, B, 255].
+        rgba.copy_from_slice(&(swap_rb(px) | 0xFF00_0000).to_le_bytes());
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -127,6 +536,7 @@ mod tests {
             format: PixelFormat::Rgba8,
             opacity: 1.0,
             anchor: TileAnchor::Scroll,
+            layer_id: 0,
             opaque: rgba[3] == 255,
         }
     }
@@ -205,4 +615,138 @@ mod tests {
         // 0xAARRGGBB red → [R,G,B,255].
         assert_eq!(argb_u32_to_rgba8(&[0xFF12_3456]), vec![0x12, 0x34, 0x56, 255]);
     }
+
+    /// Premultiplied pixels with a mix of transparent, opaque and translucent alphas.
+    fn premul_pixels(n: usize, seed: u32) -> Vec<u32> {
+        let mut state = seed;
+        (0..n)
+            .map(|i| {
+                state = state.wrapping_mul(1_664_525).wrapping_add(1_013_904_223);
+                let a = match i % 5 {
+                    0 => 0,
+                    1 => 255,
+                    _ => state >> 24,
+                };
+                let channel = |shift: u32| ((state >> shift) & 0xFF) * a / 255;
+                (a << 24) | (channel(16) << 16) | (channel(8) << 8) | channel(0)
+            })
+            .collect()
+    }
+
+    #[test]
+    fn row_kernels_match_the_scalar_blend() {
+        use crate::render::backend::{blend_over_argb_u32, scale_premul_argb_u32};
+
+        // Lengths around the lane width exercise both the chunked loop and the remainder.
+        for len in [1, LANES - 1, LANES, LANES + 3, 4 * LANES + 5] {
+            for format in [PixelFormat::PreMulArgb32, PixelFormat::Rgba8] {
+                for opacity in [1.0, 0.5, 0.0] {
+                    let src = premul_pixels(len, len as u32);
+                    let dst = premul_pixels(len, 7)
+                        .into_iter()
+                        .map(|p| p | 0xFF00_0000)
+                        .collect::<Vec<_>>();
+                    let tile = CachedTile {
+                        page_x: 0.0,
+                        page_y: 0.0,
+                        width: len as u32,
+                        height: 1,
+                        data: Bytes::new(),
+                        format,
+                        opacity,
+                        anchor: TileAnchor::Scroll,
+                        layer_id: 0,
+                        opaque: false,
+                    };
+                    // Source pixels as the tile stores them.
+                    let stored: Vec<u32> = match format {
+                        PixelFormat::PreMulArgb32 => src.clone(),
+                        PixelFormat::Rgba8 => src.iter().map(|&p| swap_rb(p)).collect(),
+                    };
+
+                    let mut expected = dst.clone();
+                    for (d, &s) in expected.iter_mut().zip(&stored) {
+                        let argb = format.pixel_to_argb_u32(s);
+                        *d = blend_over_argb_u32(scale_premul_argb_u32(argb, opacity), *d);
+                    }
+                    let mut got = dst.clone();
+                    row_kernel(&tile)(&mut got, &stored);
+                    assert_eq!(got, expected, "len {len}, {format:?}, opacity {opacity}");
+                }
+            }
+        }
+    }
+
+    /// Runs every SIMD kernel the test machine has on one configuration and compares it with the
+    /// SWAR kernel, including non-premultiplied input where the channel sums wrap.
+    fn assert_simd_matches_swar<const SWAP: bool, const FADE: bool>() {
+        for len in [0, 1, LANES - 1, LANES, LANES + 3, 4 * LANES + 5, 125] {
+            for factor in [0, 1, 128, 254, 255] {
+                let premul = premul_pixels(len, len as u32 + factor);
+                let mut state = factor;
+                let raw: Vec<u32> = (0..len)
+                    .map(|_| {
+                        state = state.wrapping_mul(1_664_525).wrapping_add(1_013_904_223);
+                        state
+                    })
+                    .collect();
+                for src in [premul, raw] {
+                    let dst = premul_pixels(len, 7);
+                    let mut expected = dst.clone();
+                    blend_row::<SWAP, FADE>(&mut expected, &src, factor);
+                    for (name, kernel) in simd::available::<SWAP, FADE>() {
+                        let mut got = dst.clone();
+                        kernel(&mut got, &src, factor);
+                        assert_eq!(
+                            got, expected,
+                            "{name}, len {len}, swap {SWAP}, fade {FADE}, factor {factor}"
+                        );
+                    }
+                    let mut got = dst.clone();
+                    simd::blend_row::<SWAP, FADE>(&mut got, &src, factor);
+                    assert_eq!(
+                        got, expected,
+                        "dispatch, len {len}, swap {SWAP}, fade {FADE}, factor {factor}"
+                    );
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn simd_kernels_match_the_swar_kernel() {
+        assert_simd_matches_swar::<false, false>();
+        assert_simd_matches_swar::<false, true>();
+        assert_simd_matches_swar::<true, false>();
+        assert_simd_matches_swar::<true, true>();
+    }
+
+    #[test]
+    fn opaque_tiles_are_copied() {
+        let src: Vec<u32> = (0..LANES as u32 + 1).map(|i| 0xFF00_0000 | i).collect();
+        let tile = CachedTile {
+            page_x: 0.0,
+            page_y: 0.0,
+            width: src.len() as u32,
+            height: 1,
+            data: Bytes::new(),
+            format: PixelFormat::PreMulArgb32,
+            opacity: 1.0,
+            anchor: TileAnchor::Scroll,
+            layer_id: 0,
+            opaque: true,
+        };
+        let mut dst = vec![WHITE; src.len()];
+        row_kernel(&tile)(&mut dst, &src);
+        assert_eq!(dst, src);
+    }
+
+    #[test]
+    fn rgba8_conversion_reuses_the_output_buffer() {
+        let mut out = Vec::with_capacity(64);
+        let ptr = out.as_ptr();
+        argb_u32_to_rgba8_into(&[0x8011_2233, 0xFFAA_BBCC], &mut out);
+        assert_eq!(out, vec![0x11, 0x22, 0x33, 255, 0xAA, 0xBB, 0xCC, 255]);
+        assert_eq!(out.as_ptr(), ptr);
+    }
 }
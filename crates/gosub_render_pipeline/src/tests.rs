@@ -294,8 +294,8 @@ mod rendertree_from_engine {
         assert!(body_id.is_some(), "body_node_id must resolve");
         assert_ne!(html_id, body_id);
 
-        assert_eq!(adapter.tag_name(html_id.unwrap()), Some("html".to_string()));
-        assert_eq!(adapter.tag_name(body_id.unwrap()), Some("body".to_string()));
+        assert_eq!(adapter.tag_name(html_id.unwrap()), Some("html".into()));
+        assert_eq!(adapter.tag_name(body_id.unwrap()), Some("body".into()));
     }
 
     fn find_node_by_class_dfs(
@@ -364,6 +364,537 @@ mod rendertree_from_engine {
         assert_eq!(url_of(plain), "none", "plain element should be `none`");
     }
 
+    #[test]
+    fn parallel_style_resolution_matches_lazy() {
+        use crate::common::document::pipeline_doc::PipelineDocument;
+        use crate::common::document::style::StyleProperty;
+
+        let html = r#"
+            <html>
+            <head>
+                <style>
+                    .a { color: red; margin-top: 3px; }
+                    div p { font-size: 20px; }
+                    #x { display: none; }
+                    .b > span { font-weight: bold; }
+                </style>
+            </head>
+            <body>
+                <div class="a"><p>one</p><p id="x">two <span class="a">hidden</span></p></div>
+                <div class="b"><span>three</span><p>four <em>five</em></p></div>
+                <section><div><div><p style="color: blue">six</p></div></div></section>
+            </body>
+            </html>
+        "#;
+        let build = || {
+            let mut doc = html_compile::<Config>(html);
+            doc.add_stylesheet(Css3System::load_default_useragent_stylesheet());
+            GosubDocumentAdapter::<Config>::new(Arc::new(doc))
+        };
+        let lazy = build();
+        let parallel = build();
+        parallel.resolve_styles_parallel(&|| {});
+        let sequential = build();
+        sequential.resolve_styles();
+
+        let props = [
+            StyleProperty::Color,
+            StyleProperty::FontSize,
+            StyleProperty::FontWeight,
+            StyleProperty::MarginTop,
+            StyleProperty::Display,
+        ];
+        let mut stack = vec![lazy.doc.root()];
+        let mut checked = 0;
+        while let Some(id) = stack.pop() {
+            for prop in &props {
+                let expected = lazy.get_style(id, prop);
+                assert_eq!(expected, parallel.get_style(id, prop), "{prop:?} of {id:?}");
+                assert_eq!(expected, sequential.get_style(id, prop), "{prop:?} of {id:?}");
+            }
+            checked += 1;
+            stack.extend(lazy.doc.children(id));
+        }
+        assert!(checked > 20);
+    }
+
+    #[test]
+    fn siblings_with_equal_matches_share_styles() {
+        let html = r#"
+            <html>
+            <head>
+                <style>
+                    :root { --gap: 4px; }
+                    li { color: red; }
+                    li.x { color: green; }
+                    .v { margin-top: var(--gap); }
+                </style>
+            </head>
+            <body>
+                <ul>
+                    <li id="a">one</li>
+                    <li id="b" style="color: blue">two</li>
+                    <li id="c" class="x">three</li>
+                    <li id="d" class="v">four</li>
+                    <li id="e" class="v">five</li>
+                </ul>
+            </body>
+            </html>
+        "#;
+        let mut doc = html_compile::<Config>(html);
+        doc.add_stylesheet(Css3System::load_default_useragent_stylesheet());
+        let adapter = GosubDocumentAdapter::<Config>::new(Arc::new(doc));
+        let root = adapter.doc.root();
+        let styles = |id: &str| {
+            let node = find_node_by_id_attr(&adapter.doc, root, id).expect("find node");
+            adapter.cached_styles(node)
+        };
+
+        // Inline style is kept outside the shared map, so it does not prevent sharing.
+        assert!(Arc::ptr_eq(&styles("a"), &styles("b")));
+        assert!(!Arc::ptr_eq(&styles("a"), &styles("c")));
+        // `var()` makes the cascade node dependent.
+        assert!(!Arc::ptr_eq(&styles("d"), &styles("e")));
+    }
+
+    #[test]
+    fn restyle_keeps_styles_outside_damaged_subtrees() {
+        use crate::common::document::pipeline_doc::PipelineDocument;
+        use crate::common::document::style::StyleProperty;
+
+        let html = r#"
+            <html>
+            <head><style>li { color: red; } li.x { color: green; } p { color: teal; }</style></head>
+            <body>
+                <p id="p">para</p>
+                <ul id="list"><li id="a">one</li><li id="b">two</li></ul>
+            </body>
+            </html>
+        "#;
+        let build = || {
+            let mut doc = html_compile::<Config>(html);
+            doc.add_stylesheet(Css3System::load_default_useragent_stylesheet());
+            doc
+        };
+        let prev = GosubDocumentAdapter::<Config>::new(Arc::new(build()));
+        let root = prev.doc.root();
+        let node = |id: &str| find_node_by_id_attr(&prev.doc, root, id).expect("find node");
+        let (p, list, a) = (node("p"), node("list"), node("a"));
+        let prev_p = prev.cached_styles(p);
+        let prev_a = prev.cached_styles(a);
+
+        // Same markup, so the same node ids; then the mutation a script would make.
+        let mut doc = build();
+        doc.add_class(a, "x");
+        let next = GosubDocumentAdapter::with_styles_from(Arc::new(doc), &prev, &[list]);
+
+        assert!(Arc::ptr_eq(&prev_p, &next.cached_styles(p)));
+        assert!(!Arc::ptr_eq(&prev_a, &next.cached_styles(a)));
+        assert_ne!(
+            prev.get_style(a, &StyleProperty::Color),
+            next.get_style(a, &StyleProperty::Color)
+        );
+    }
+
+    #[test]
+    fn relayout_reuses_the_taffy_tree() {
+        use crate::common::geo::Dimension;
+        use crate::layouter::taffy::TaffyLayouter;
+        use crate::layouter::CanLayout;
+
+        let html = r#"
+            <html>
+            <head><style>.wide { width: 300px; } div { height: 20px; }</style></head>
+            <body><div id="a">one</div><div id="b">two <b>bold</b> three</div><div id="c"></div></body>
+            </html>
+        "#;
+        let build = |mutate: bool| {
+            let mut doc = html_compile::<Config>(html);
+            doc.add_stylesheet(Css3System::load_default_useragent_stylesheet());
+            if mutate {
+                let root = doc.root();
+                let c = find_node_by_id_attr(&doc, root, "c").expect("find #c");
+                doc.add_class(c, "wide");
+            }
+            let mut rt = RenderTree::new(Arc::new(GosubDocumentAdapter::<Config>::new(Arc::new(doc))));
+            rt.parse().expect("failed to build render tree");
+            rt
+        };
+        let boxes = |tree: &crate::layouter::LayoutTree| {
+            let mut out: Vec<_> = tree
+                .arena
+                .values()
+                .map(|el| {
+                    let m = el.box_model.margin_box;
+                    (el.dom_node_id, (m.x, m.y, m.width, m.height))
+                })
+                .collect();
+            out.sort_by(|a, b| a.partial_cmp(b).unwrap_or(std::cmp::Ordering::Equal));
+            out
+        };
+        let viewport = Some(Dimension::new(800.0, 600.0));
+
+        let mut layouter = TaffyLayouter::new();
+        let first = layouter.layout(build(false), viewport, 1.0);
+        let nodes = layouter.taffy_node_count();
+        let second = layouter.layout(build(false), viewport, 1.0);
+        assert_eq!(layouter.taffy_node_count(), nodes);
+        assert_eq!(boxes(&first), boxes(&second));
+
+        // A style change updates the retained tree to the same result as a fresh layout.
+        let changed = layouter.layout(build(true), viewport, 1.0);
+        assert_eq!(layouter.taffy_node_count(), nodes);
+        let fresh = TaffyLayouter::new().layout(build(true), viewport, 1.0);
+        assert_eq!(boxes(&changed), boxes(&fresh));
+        assert_ne!(boxes(&changed), boxes(&first));
+    }
+
+    #[test]
+    fn changed_rects_cover_damaged_and_moved_boxes() {
+        use crate::common::geo::{Dimension, Rect};
+        use crate::layouter::taffy::TaffyLayouter;
+        use crate::layouter::{CanLayout, LayoutTree};
+        use std::collections::HashSet;
+
+        let html = r#"
+            <html>
+            <head><style>div { height: 20px; } .tall { height: 50px; }</style></head>
+            <body><div id="a"></div><div id="b"></div><div id="c"></div></body>
+            </html>
+        "#;
+        let build = |grow_b: bool| {
+            let mut doc = html_compile::<Config>(html);
+            doc.add_stylesheet(Css3System::load_default_useragent_stylesheet());
+            let root = doc.root();
+            let ids = ["a", "b", "c"].map(|id| find_node_by_id_attr(&doc, root, id).expect("find node"));
+            if grow_b {
+                doc.add_class(ids[1], "tall");
+            }
+            let mut rt = RenderTree::new(Arc::new(GosubDocumentAdapter::<Config>::new(Arc::new(doc))));
+            rt.parse().expect("failed to build render tree");
+            (rt, ids)
+        };
+        let margin_box = |tree: &LayoutTree, id| -> Rect {
+            tree.arena
+                .values()
+                .find(|el| el.dom_node_id == id)
+                .map(|el| el.box_model.margin_box)
+                .expect("element has a box")
+        };
+        let viewport = Some(Dimension::new(800.0, 600.0));
+        let mut layouter = TaffyLayouter::new();
+
+        let (rt, [a, b, c]) = build(false);
+        let prev = layouter.layout(rt, viewport, 1.0);
+        let (rt, _) = build(false);
+        let same = layouter.layout(rt, viewport, 1.0);
+
+        // Nothing moved and nothing is damaged: every tile can be reused.
+        assert!(same.changed_rects(&prev, &HashSet::new()).is_empty());
+
+        // A damaged box is repainted in place even though its geometry is unchanged.
+        let rects = same.changed_rects(&prev, &HashSet::from([a]));
+        assert!(!rects.is_empty());
+        assert!(rects.iter().all(|r| *r == margin_box(&prev, a)));
+
+        // #b grows: its old and new boxes change, #c moves down, #a stays clean.
+        let (rt, _) = build(true);
+        let grown = layouter.layout(rt, viewport, 1.0);
+        let rects = grown.changed_rects(&prev, &HashSet::from([b]));
+        for rect in [
+            margin_box(&prev, b),
+            margin_box(&grown, b),
+            margin_box(&prev, c),
+            margin_box(&grown, c),
+        ] {
+            assert!(rects.contains(&rect), "missing {rect:?} in {rects:?}");
+        }
+        assert!(!rects.contains(&margin_box(&prev, a)));
+    }
+
+    #[test]
+    fn hit_test_index_matches_linear_scan() {
+        use crate::common::geo::Dimension;
+        use crate::layering::layer::LayerList;
+        use crate::layouter::taffy::TaffyLayouter;
+        use crate::layouter::CanLayout;
+        use crate::tiler::TileList;
+
+        let html = r#"
+            <html>
+            <head><style>
+                div { height: 30px; margin: 4px; }
+                .over { position: relative; z-index: 2; width: 120px; height: 80px; }
+                .faded { opacity: 0.5; width: 60px; }
+            </style></head>
+            <body>
+                <div>one</div><div class="over">over <b>bold</b></div>
+                <div class="faded">faded</div><div>two <i>three</i></div><img src="x.png">
+            </body>
+            </html>
+        "#;
+        let layout = TaffyLayouter::new().layout(parse_to_rendertree(html), Some(Dimension::new(400.0, 300.0)), 1.0);
+        let layers = LayerList::new(layout);
+
+        // The old hit test: every element of every layer, topmost layer and last element first.
+        let linear = |x: f64, y: f64| {
+            let all = layers.layers.read();
+            layers.layer_ids.read().iter().rev().find_map(|id| {
+                all.get(id)?.elements.iter().rev().copied().find(|&eid| {
+                    layers.layout_tree.get_node_by_id(eid).is_some_and(|el| {
+                        let m = el.box_model.margin_box;
+                        x >= m.x && x < m.x + m.width && y >= m.y && y < m.y + m.height
+                    })
+                })
+            })
+        };
+        for y in (0..300).step_by(3) {
+            for x in (0..400).step_by(7) {
+                let (x, y) = (x as f64, y as f64);
+                assert_eq!(layers.find_element_at(x, y, 0.0, 0.0), linear(x, y), "at ({x}, {y})");
+            }
+        }
+
+        let mut tiles = TileList::new(layers, Dimension::new(64.0, 64.0));
+        tiles.generate();
+        for &element_id in tiles.layer_list.layout_tree.arena.keys() {
+            let expected: std::collections::HashSet<_> = tiles
+                .arena
+                .values()
+                .filter(|t| t.elements.iter().any(|e| e.id == element_id))
+                .map(|t| t.id)
+                .collect();
+            let indexed: std::collections::HashSet<_> = tiles.get_tiles_for_element(element_id).into_iter().collect();
+            assert_eq!(indexed, expected, "tiles of {element_id:?}");
+        }
+    }
+
+    /// Stand-in rasterizer: an opaque tile of the tile's size. Holding `gate` stalls it.
+    struct SolidRasterizer {
+        gate: parking_lot::Mutex<()>,
+    }
+
+    impl crate::rasterizer::Rasterable for SolidRasterizer {
+        fn rasterize(
+            &self,
+            tile: &crate::tiler::Tile,
+            texture_store: &mut crate::common::texture_store::TextureStore,
+            _media_store: &crate::common::media::MediaStore,
+        ) -> Option<crate::common::texture::TextureId> {
+            let _gate = self.gate.lock();
+            let (w, h) = (tile.rect.width as usize, tile.rect.height as usize);
+            Some(texture_store.add(
+                w,
+                h,
+                vec![0xFF; w * h * 4],
+                crate::render::backend::PixelFormat::PreMulArgb32,
+            ))
+        }
+    }
+
+    fn tall_page_tiles() -> crate::tiler::TileList {
+        use crate::common::geo::Dimension;
+        use crate::layering::layer::LayerList;
+        use crate::layouter::taffy::TaffyLayouter;
+        use crate::layouter::CanLayout;
+        use crate::tiler::TileList;
+
+        let html = format!(
+            "<html><head><style>div {{ height: 100px; background: #ccc; }}</style></head><body>{}</body></html>",
+            "<div>row</div>".repeat(60)
+        );
+        let layout = TaffyLayouter::new().layout(parse_to_rendertree(&html), Some(Dimension::new(400.0, 300.0)), 1.0);
+        let mut tiles = TileList::new(LayerList::new(layout), Dimension::new(64.0, 64.0));
+        tiles.generate();
+        tiles
+    }
+
+    #[test]
+    fn viewport_first_fill_covers_every_dirty_tile() {
+        use crate::common::geo::Rect;
+        use crate::common::media::MediaStore;
+        use crate::rasterizer::{fill_priority, rasterize_tiles, split_viewport_tiles, RasterFill, TilePixelCache};
+        use std::collections::HashSet;
+
+        let mut tiles = tall_page_tiles();
+        let page_height = tiles.layer_list.layout_tree.root_dimension.height;
+        let full = Rect::new(0.0, 0.0, 400.0, page_height);
+        let visible = Rect::new(0.0, 2000.0, 400.0, 300.0);
+        let layer_ids = tiles.layer_list.layer_ids.read().clone();
+
+        let (now, later) = split_viewport_tiles(&tiles, &layer_ids, full, visible);
+        assert!(!now.is_empty() && !later.is_empty());
+        let key = |t: &crate::tiler::Tile| (t.rect.x.to_bits(), t.rect.y.to_bits(), t.layer_id.as_u64());
+        let expected: HashSet<_> = later.iter().filter_map(|id| tiles.arena.get(id)).map(key).collect();
+        assert!(now
+            .iter()
+            .filter_map(|id| tiles.arena.get(id))
+            .all(|t| t.rect.intersects(&visible)));
+
+        let rasterizer = Arc::new(SolidRasterizer {
+            gate: parking_lot::Mutex::new(()),
+        });
+        let media = Arc::new(MediaStore::new());
+        let cache = Arc::new(TilePixelCache::default());
+        let first = rasterize_tiles(rasterizer.as_ref(), &mut tiles, &now, &media, &cache, "test");
+        assert_eq!(first.len(), now.len());
+
+        let fill = RasterFill::spawn(rasterizer, tiles, later, media, Arc::clone(&cache), visible, 1.0).expect("fill");
+        let batches = fill.wait();
+        let filled: HashSet<_> = batches
+            .iter()
+            .flat_map(|b| &b.tiles)
+            .map(|t| (t.page_x.to_bits(), t.page_y.to_bits(), t.layer_id))
+            .collect();
+        assert_eq!(filled, expected);
+
+        // Each batch is no further from the viewport than the next one.
+        let worst_and_best: Vec<(f64, f64)> = batches
+            .iter()
+            .map(|b| {
+                b.tiles
+                    .iter()
+                    .map(|t| {
+                        fill_priority(
+                            Rect::new(t.page_x, t.page_y, t.width as f64, t.height as f64),
+                            visible,
+                            1.0,
+                        )
+                    })
+                    .fold((f64::MIN, f64::MAX), |(worst, best), p| (worst.max(p), best.min(p)))
+            })
+            .collect();
+        for pair in worst_and_best.windows(2) {
+            assert!(pair[0].0 <= pair[1].1, "{worst_and_best:?}");
+        }
+        assert!(batches.iter().all(|b| b.cached_tiles.len() == b.tiles.len()));
+        // Both passes feed the same persistent pixel cache.
+        assert_eq!(cache.len(), now.len() + expected.len());
+    }
+
+    #[test]
+    fn cancelled_fill_stops_at_a_batch_boundary() {
+        use crate::common::geo::Rect;
+        use crate::common::media::MediaStore;
+        use crate::rasterizer::{split_viewport_tiles, RasterFill, TilePixelCache};
+
+        let tiles = tall_page_tiles();
+        let page_height = tiles.layer_list.layout_tree.root_dimension.height;
+        let full = Rect::new(0.0, 0.0, 400.0, page_height);
+        let visible = Rect::new(0.0, 0.0, 400.0, 300.0);
+        let layer_ids = tiles.layer_list.layer_ids.read().clone();
+        let (_, later) = split_viewport_tiles(&tiles, &layer_ids, full, visible);
+        let deferred = later.len();
+
+        let rasterizer = Arc::new(SolidRasterizer {
+            gate: parking_lot::Mutex::new(()),
+        });
+        let gate = rasterizer.gate.lock();
+        let fill = RasterFill::spawn(
+            rasterizer.clone(),
+            tiles,
+            later,
+            Arc::new(MediaStore::new()),
+            Arc::new(TilePixelCache::default()),
+            visible,
+            1.0,
+        )
+        .expect("fill");
+        fill.cancel();
+        drop(gate);
+
+        let filled: usize = fill.wait().iter().map(|b| b.tiles.len()).sum();
+        if deferred > rayon::current_num_threads() * 2 {
+            assert!(filled < deferred, "{filled} of {deferred} tiles filled after cancel");
+        }
+    }
+
+    #[test]
+    fn display_list_repaints_only_damaged_elements() {
+        use crate::common::browser_state::{BrowserState, WireframeState};
+        use crate::common::geo::{Dimension, Rect};
+        use crate::layering::layer::LayerList;
+        use crate::layouter::taffy::TaffyLayouter;
+        use crate::layouter::{CanLayout, LayoutTree};
+        use crate::painter::display_list::{DisplayList, DisplaySlice};
+        use crate::painter::Painter;
+        use std::collections::HashSet;
+
+        let html = r#"
+            <html>
+            <head><style>
+                div { height: 20px; margin: 4px; background: #c00; border: 1px solid #000; }
+                .b { background: #0c0; opacity: 0.5; }
+            </style></head>
+            <body><div>one</div><div class="b">two</div><div>three <b>four</b></div></body>
+            </html>
+        "#;
+        let layout = TaffyLayouter::new().layout(parse_to_rendertree(html), Some(Dimension::new(400.0, 300.0)), 1.0);
+        let first_layers = Arc::new(LayerList::new(LayoutTree::clone(&layout)));
+        let state = BrowserState {
+            visible_layer_list: vec![true; first_layers.layer_ids.read().len()],
+            wireframed: WireframeState::None,
+            debug_hover: false,
+            current_hovered_element: None,
+            show_tilegrid: false,
+            debug_table_cells: false,
+            viewport: Rect::new(0.0, 0.0, 400.0, 300.0),
+            tile_list: None,
+            dpi_scale_factor: 1.0,
+        };
+        let element_ids: Vec<_> = {
+            let layers = first_layers.layers.read();
+            let mut seen = HashSet::new();
+            first_layers
+                .layer_ids
+                .read()
+                .iter()
+                .filter_map(|id| layers.get(id))
+                .flat_map(|layer| layer.elements.iter().copied())
+                .filter(|id| seen.insert(*id))
+                .collect()
+        };
+
+        let painter = Painter::new(Arc::clone(&first_layers), None);
+        let first = DisplayList::build(&painter, &state, None, &HashSet::new());
+        assert_eq!(first.painted(), element_ids.len());
+        for &id in &element_ids {
+            let direct = DisplaySlice::from(painter.paint_element(id, &state));
+            assert_eq!(first.slice(id).content_hash(), direct.content_hash(), "{id:?}");
+            assert_eq!(first.slice(id).len(), direct.len());
+        }
+
+        // Same layout, nothing damaged: every element is carried over.
+        let second_layers = Arc::new(LayerList::new(LayoutTree::clone(&layout)));
+        let second_painter = Painter::new(Arc::clone(&second_layers), None);
+        let second = DisplayList::build(&second_painter, &state, Some(&first), &HashSet::new());
+        assert_eq!(second.painted(), 0);
+        assert_eq!(second.len(), first.len());
+        for &id in &element_ids {
+            assert_eq!(second.slice(id).content_hash(), first.slice(id).content_hash());
+        }
+
+        // A damaged node repaints its own elements only.
+        let &last = element_ids.last().expect("elements");
+        let dom = layout.get_node_by_id(last).expect("node").dom_node_id;
+        let own = element_ids
+            .iter()
+            .filter(|&&id| layout.get_node_by_id(id).is_some_and(|n| n.dom_node_id == dom))
+            .count();
+        let third = DisplayList::build(&second_painter, &state, Some(&second), &HashSet::from([dom]));
+        assert_eq!(third.painted(), own);
+
+        // Other paint settings invalidate everything.
+        let wireframe = BrowserState {
+            wireframed: WireframeState::Both,
+            visible_layer_list: state.visible_layer_list.clone(),
+            tile_list: None,
+            ..state
+        };
+        let fourth = DisplayList::build(&second_painter, &wireframe, Some(&third), &HashSet::new());
+        assert_eq!(fourth.painted(), element_ids.len());
+    }
+
     fn find_node_by_id_attr(
         doc: &DocumentImpl<Config>,
         node: gosub_shared::node::NodeId,
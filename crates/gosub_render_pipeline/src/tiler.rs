@@ -5,7 +5,7 @@ use crate::common::geo::{Coordinate, Dimension, Rect};
 use crate::common::texture::TextureId;
 use crate::layering::layer::{LayerId, LayerList};
 use crate::layouter::LayoutElementId;
-use crate::painter::commands::PaintCommand;
+use crate::painter::display_list::DisplaySlice;
 use parking_lot::RwLock;
 use rstar::primitives::GeomWithData;
 use rstar::AABB;
@@ -44,7 +44,8 @@ pub struct TiledLayoutElement {
     pub rect: Rect,
     /// Where inside the tile the element starts. See the diagram below.
     pub position: Coordinate,
-    pub paint_commands: Vec<PaintCommand>,
+    /// This element's commands, sliced from the page's display list.
+    pub paint_commands: DisplaySlice,
 }
 
 /*
@@ -147,18 +148,25 @@ impl Debug for TileList {
 }
 
 impl TileList {
+    /// Tiles that draw (part of) `element_id`. Only the tiles of the element's layer under its
+    /// margin box are inspected, through the layer's R* tree.
     pub fn get_tiles_for_element(&self, element_id: LayoutElementId) -> Vec<TileId> {
-        let mut matching_tiles = vec![];
-
-        for tile in self.arena.values() {
-            for element in &tile.elements {
-                if element.id == element_id {
-                    matching_tiles.push(tile.id);
-                }
-            }
-        }
+        let Some(tile_layer) = self.layer_list.layer_of(element_id).and_then(|id| self.tiles.get(&id)) else {
+            return vec![];
+        };
+        let Some(element) = self.layer_list.layout_tree.get_node_by_id(element_id) else {
+            return vec![];
+        };
 
-        matching_tiles
+        tile_layer
+            .intersects_with(element.box_model.margin_box)
+            .into_iter()
+            .filter(|tile_id| {
+                self.arena
+                    .get(tile_id)
+                    .is_some_and(|tile| tile.elements.iter().any(|e| e.id == element_id))
+            })
+            .collect()
     }
 
     pub fn invalidate_all(&mut self) {
@@ -173,6 +181,18 @@ impl TileList {
         }
     }
 
+    /// Marks every tile, on any layer, that overlaps `rect` as dirty.
+    pub fn invalidate_rect(&mut self, rect: Rect) {
+        let tile_ids: Vec<TileId> = self
+            .tiles
+            .values()
+            .flat_map(|layer| layer.intersects_with(rect))
+            .collect();
+        for tile_id in tile_ids {
+            self.invalidate_tile(tile_id);
+        }
+    }
+
     pub fn get_tile_mut(&mut self, tile_id: TileId) -> Option<&mut Tile> {
         self.arena.get_mut(&tile_id)
     }
@@ -358,7 +378,7 @@ impl TileList {
                         id: element_id,
                         rect: dimension,
                         position,
-                        paint_commands: vec![],
+                        paint_commands: DisplaySlice::default(),
                     };
 
                     tile.elements.push(tiled_element);
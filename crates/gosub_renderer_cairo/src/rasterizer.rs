@@ -6,7 +6,6 @@ use gosub_render_pipeline::common::TextureStore;
 use gosub_render_pipeline::painter::commands::PaintCommand;
 use gosub_render_pipeline::rasterizer::Rasterable;
 use gosub_render_pipeline::tiler::Tile;
-use parking_lot::Mutex;
 use std::sync::Arc;
 
 mod brush;
@@ -19,7 +18,7 @@ use gosub_render_pipeline::render::DEVICE_PIXEL_RATIO;
 pub struct CairoRasterizer {
     /// Exposed to the layouter so it measures with the configured instance. Painting doesn't
     /// need it - text commands carry their pre-shaped glyph runs.
-    config_font_system: Option<Arc<Mutex<dyn FontSystem>>>,
+    config_font_system: Option<Arc<dyn FontSystem>>,
 }
 
 impl Default for CairoRasterizer {
@@ -38,7 +37,7 @@ impl CairoRasterizer {
 
     /// Create a rasterizer that shares the engine's font system (used by the layouter for
     /// measurement).
-    pub fn with_font_system(font_system: Arc<Mutex<dyn FontSystem>>) -> Self {
+    pub fn with_font_system(font_system: Arc<dyn FontSystem>) -> Self {
         Self {
             config_font_system: Some(font_system),
         }
@@ -46,7 +45,7 @@ impl CairoRasterizer {
 }
 
 impl Rasterable for CairoRasterizer {
-    fn font_system(&self) -> Option<Arc<Mutex<dyn FontSystem>>> {
+    fn font_system(&self) -> Option<Arc<dyn FontSystem>> {
         self.config_font_system.clone()
     }
 
@@ -102,10 +101,14 @@ impl Rasterable for CairoRasterizer {
             return None;
         };
 
+        // Copy out of the Cairo surface into a (recycled) tile buffer.
+        let mut pixels = texture_store.take_buffer(data.len());
+        pixels.extend_from_slice(&data);
+
         let texture_id = texture_store.add(
             w,
             h,
-            data.to_vec(),
+            pixels,
             gosub_render_pipeline::render::backend::PixelFormat::PreMulArgb32,
         );
 
@@ -1,10 +1,8 @@
 use cairo::Context;
-use gosub_render_pipeline::common::geo::Dimension;
-use gosub_render_pipeline::common::media::{MediaId, MediaStore};
+use gosub_render_pipeline::common::media::{MediaId, MediaStore, RenderedSvg};
 use gosub_render_pipeline::painter::commands::rectangle::Rectangle;
 use gosub_render_pipeline::render::backend::PixelFormat;
 use gosub_render_pipeline::tiler::Tile;
-use resvg::usvg::Transform;
 
 pub(crate) fn do_paint_svg(
     cr: &Context,
@@ -27,64 +25,39 @@ pub(crate) fn do_paint_svg(
     let dest_y = (rect.rect().y - tile.rect.y).round();
 
     // Rasterize at physical resolution (CSS size × dpr) so the icon is crisp instead of being
-    // upscaled from CSS-pixel resolution by the dpr-scaled context. `set_device_scale(dpr)`
-    // then maps the physical surface back to its CSS logical size for placement.
-    let phys_w = (target_dim.width as u32 * dpr.max(1) as u32).max(1);
-    let phys_h = (target_dim.height as u32 * dpr.max(1) as u32).max(1);
-    // The cache stores physical pixels, so key it on the physical dimension (which also
-    // encodes dpr) - a dpr change re-renders rather than reusing a stale-resolution bitmap.
-    let phys_dim = Dimension::new(phys_w as f64, phys_h as f64);
-
-    {
-        let cached = media.svg.rendered.read();
-        if cached.is_usable(phys_dim, PixelFormat::PreMulArgb32) {
-            paint_surface(cr, &cached.data, phys_w, phys_h, dpr, dest_x, dest_y, media_id);
-            return;
-        }
-    }
-
-    let pixmap_size = media.svg.tree.size().to_int_size();
-    let intrinsic_w = pixmap_size.width().max(1) as f32;
-    let intrinsic_h = pixmap_size.height().max(1) as f32;
-    let sx = phys_w as f32 / intrinsic_w;
-    let sy = phys_h as f32 / intrinsic_h;
-
-    let Some(mut pixmap) = resvg::tiny_skia::Pixmap::new(phys_w, phys_h) else {
+    // upscaled from CSS-pixel resolution by the dpr-scaled context.
+    let dpr = dpr.max(1);
+    let phys_w = (target_dim.width as u32 * dpr as u32).max(1);
+    let phys_h = (target_dim.height as u32 * dpr as u32).max(1);
+    let Some(raster) = media.svg.raster(phys_w, phys_h, PixelFormat::PreMulArgb32) else {
         log::warn!("SVG has zero or invalid dimensions, skipping render");
         return;
     };
-    resvg::render(&media.svg.tree, Transform::from_scale(sx, sy), &mut pixmap.as_mut());
-
-    let mut new_data = pixmap.data().to_vec();
-    for chunk in new_data.chunks_exact_mut(4) {
-        chunk.swap(0, 2);
-    }
 
-    let mut cached = media.svg.rendered.write();
-    cached.store(phys_dim, PixelFormat::PreMulArgb32, new_data);
-
-    paint_surface(cr, &cached.data, phys_w, phys_h, dpr, dest_x, dest_y, media_id);
+    let draw_w = phys_w as f64 / dpr as f64;
+    let draw_h = phys_h as f64 / dpr as f64;
+    paint_surface(cr, &raster, draw_w, draw_h, dest_x, dest_y, media_id);
 }
 
-/// Wrap the physical-pixel ARGB32 buffer in a Cairo surface, scale it back to CSS logical size
-/// via `device_scale`, and paint it at the (grid-aligned) destination.
-#[allow(clippy::too_many_arguments)]
+/// Wrap the cached ARGB32 raster in a Cairo surface and paint it scaled to `draw_w`×`draw_h` CSS
+/// px at the (grid-aligned) destination. The raster is rendered at a size bucket, so the scale is
+/// 1/dpr (1:1 on the device grid) when the box size is a bucket and slightly below otherwise.
 fn paint_surface(
     cr: &Context,
-    data: &[u8],
-    phys_w: u32,
-    phys_h: u32,
-    dpr: i32,
+    raster: &RenderedSvg,
+    draw_w: f64,
+    draw_h: f64,
     dest_x: f64,
     dest_y: f64,
     media_id: MediaId,
 ) {
+    let (raster_w, raster_h) = (raster.dimension.width, raster.dimension.height);
     let surface = match cairo::ImageSurface::create_for_data(
-        data.to_vec(),
+        raster.data.clone(),
         cairo::Format::ARgb32,
-        phys_w as i32,
-        phys_h as i32,
-        phys_w as i32 * 4,
+        raster_w as i32,
+        raster_h as i32,
+        raster_w as i32 * 4,
     ) {
         Ok(s) => s,
         Err(e) => {
@@ -92,11 +65,12 @@ fn paint_surface(
             return;
         }
     };
-    // device_scale maps the physical surface (phys = CSS × dpr) back to CSS logical units, so it
-    // places 1:1 on the device grid in the dpr-scaled tile context.
-    surface.set_device_scale(dpr.max(1) as f64, dpr.max(1) as f64);
 
-    _ = cr.set_source_surface(&surface, dest_x, dest_y);
+    _ = cr.save();
+    cr.translate(dest_x, dest_y);
+    cr.scale(draw_w / raster_w, draw_h / raster_h);
+    _ = cr.set_source_surface(&surface, 0.0, 0.0);
     cr.source().set_filter(cairo::Filter::Good);
     _ = cr.paint();
+    _ = cr.restore();
 }
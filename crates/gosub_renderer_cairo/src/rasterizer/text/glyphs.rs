@@ -168,7 +168,7 @@ mod tests {
     /// the carried runs via FreeType + `show_glyphs`, and assert dark pixels landed.
     #[test]
     fn paints_visible_glyphs() {
-        let mut fs = PangoFontSystem::new();
+        let fs = PangoFontSystem::new();
 
         let Ok(surface) = cairo::ImageSurface::create(cairo::Format::ARgb32, 200, 60) else {
             panic!("failed to create surface");
@@ -119,7 +119,7 @@ impl RenderBackend for DynamicRenderBackend {
 
     fn create_rasterizer(
         &self,
-        font_system: std::sync::Arc<parking_lot::Mutex<dyn gosub_interface::font_system::FontSystem>>,
+        font_system: std::sync::Arc<dyn gosub_interface::font_system::FontSystem>,
     ) -> Box<dyn std::any::Any + Send + Sync> {
         self.active_backend().create_rasterizer(font_system)
     }
@@ -175,7 +175,7 @@ impl RenderBackend for SkiaBackend {
 
     fn create_rasterizer(
         &self,
-        font_system: std::sync::Arc<parking_lot::Mutex<dyn gosub_interface::font_system::FontSystem>>,
+        font_system: std::sync::Arc<dyn gosub_interface::font_system::FontSystem>,
     ) -> Box<dyn Any + Send + Sync> {
         // Share the engine's font system so the layouter measures with it. Skia still draws text
         // through its own skia_safe text layout (using the config's font system for Skia drawing
@@ -7,7 +7,6 @@ use gosub_render_pipeline::painter::commands::PaintCommand;
 use gosub_render_pipeline::rasterizer::Rasterable;
 use gosub_render_pipeline::render::DEVICE_PIXEL_RATIO;
 use gosub_render_pipeline::tiler::Tile;
-use parking_lot::Mutex;
 use skia_safe::Rect;
 use std::sync::Arc;
 
@@ -19,7 +18,7 @@ pub struct SkiaRasterizer {
     dpi_scale_factor: f32,
     /// Exposed to the layouter so it measures with the configured instance. Not used for drawing:
     /// Skia draws text through `skia_safe`'s own text layout.
-    font_system: Option<Arc<Mutex<dyn FontSystem>>>,
+    font_system: Option<Arc<dyn FontSystem>>,
 }
 
 impl SkiaRasterizer {
@@ -31,7 +30,7 @@ impl SkiaRasterizer {
     }
 
     /// Create a rasterizer that shares the engine's font system (used for measurement).
-    pub fn with_font_system(dpi_scale_factor: f32, font_system: Arc<Mutex<dyn FontSystem>>) -> Self {
+    pub fn with_font_system(dpi_scale_factor: f32, font_system: Arc<dyn FontSystem>) -> Self {
         Self {
             dpi_scale_factor,
             font_system: Some(font_system),
@@ -40,7 +39,7 @@ impl SkiaRasterizer {
 }
 
 impl Rasterable for SkiaRasterizer {
-    fn font_system(&self) -> Option<Arc<Mutex<dyn FontSystem>>> {
+    fn font_system(&self) -> Option<Arc<dyn FontSystem>> {
         self.font_system.clone()
     }
 
@@ -116,7 +115,9 @@ impl Rasterable for SkiaRasterizer {
             log::error!("Failed to get bytes from Skia pixel info");
             return None;
         };
-        let pixels = bytes.to_vec();
+        // Copy out of the Skia surface into a (recycled) tile buffer.
+        let mut pixels = texture_store.take_buffer(bytes.len());
+        pixels.extend_from_slice(bytes);
 
         let texture_id = texture_store.add(
             width as usize,
@@ -1,16 +1,18 @@
-use gosub_render_pipeline::common::geo::Dimension;
 use gosub_render_pipeline::common::media::{MediaId, MediaStore};
 use gosub_render_pipeline::painter::commands::rectangle::Rectangle;
 use gosub_render_pipeline::render::backend::PixelFormat;
 use gosub_render_pipeline::tiler::Tile;
-use resvg::usvg::Transform;
-use skia_safe::{images, AlphaType, Canvas, ColorType, Data, ImageInfo, Paint, Rect as SkRect, SamplingOptions};
+use skia_safe::{
+    images, AlphaType, Canvas, ColorType, Data, FilterMode, ImageInfo, MipmapMode, Paint, Rect as SkRect,
+    SamplingOptions,
+};
 
 /// Rasterize an SVG at physical resolution (CSS size × dpr) and blit it onto the tile canvas.
 ///
 /// The tile canvas is already dpr-scaled and translated into page space, so placing the image at
-/// its CSS-unit rect maps it 1:1 onto device pixels - crisp on HiDPI. The rendered pixels are
-/// cached on the `Svg` and shared with the Cairo backend (same premultiplied-BGRA byte order).
+/// its CSS-unit rect maps it onto device pixels - crisp on HiDPI. The raster comes from the shared
+/// SVG raster cache (the Cairo backend uses the same premultiplied-BGRA entries); it is rendered at
+/// a size bucket and scaled into the rect.
 pub fn do_paint_svg(
     canvas: &Canvas,
     _tile: &Tile,
@@ -25,42 +27,23 @@ pub fn do_paint_svg(
 
     let phys_w = (target_dim.width as u32 * dpr).max(1);
     let phys_h = (target_dim.height as u32 * dpr).max(1);
-    // Key the cache on physical dimension (which encodes dpr) so a dpr change re-renders instead
-    // of reusing a stale-resolution bitmap.
-    let phys_dim = Dimension::new(phys_w as f64, phys_h as f64);
-
-    {
-        let cached = media.svg.rendered.read();
-        if cached.is_usable(phys_dim, PixelFormat::PreMulArgb32) {
-            blit(canvas, &cached.data, phys_w, phys_h, rect);
-            return;
-        }
-    }
-
-    // Render the SVG tree into a physical-resolution pixmap, then convert tiny_skia's premultiplied
-    // RGBA to the premultiplied BGRA byte order Skia (and the shared cache) expect.
-    let size = media.svg.tree.size().to_int_size();
-    let sx = phys_w as f32 / size.width().max(1) as f32;
-    let sy = phys_h as f32 / size.height().max(1) as f32;
-    let Some(mut pixmap) = resvg::tiny_skia::Pixmap::new(phys_w, phys_h) else {
+    // Premultiplied BGRA is the byte order Skia's n32 (and the Cairo backend) use.
+    let Some(raster) = media.svg.raster(phys_w, phys_h, PixelFormat::PreMulArgb32) else {
         log::warn!("SVG {media_id:?} has zero or invalid dimensions, skipping render");
         return;
     };
-    resvg::render(&media.svg.tree, Transform::from_scale(sx, sy), &mut pixmap.as_mut());
-
-    let mut data = pixmap.data().to_vec();
-    for chunk in data.chunks_exact_mut(4) {
-        chunk.swap(0, 2); // RGBA -> BGRA
-    }
-
-    let mut cached = media.svg.rendered.write();
-    cached.store(phys_dim, PixelFormat::PreMulArgb32, data);
-    blit(canvas, &cached.data, phys_w, phys_h, rect);
+    blit(
+        canvas,
+        &raster.data,
+        raster.dimension.width as u32,
+        raster.dimension.height as u32,
+        rect,
+    );
 }
 
 /// Wrap a premultiplied-BGRA physical-pixel buffer in a Skia image and draw it into the element's
-/// CSS-space rect. The canvas' dpr scale turns that CSS rect back into the physical pixels the
-/// buffer holds, so the blit lands 1:1 on device pixels.
+/// CSS-space rect. The canvas' dpr scale turns that CSS rect back into physical pixels, so the
+/// blit lands 1:1 on device pixels when the buffer is exactly the box size.
 fn blit(canvas: &Canvas, data: &[u8], phys_w: u32, phys_h: u32, rect: &Rectangle) {
     let info = ImageInfo::new(
         skia_safe::ISize::new(phys_w as i32, phys_h as i32),
@@ -77,5 +60,7 @@ fn blit(canvas: &Canvas, data: &[u8], phys_w: u32, phys_h: u32, rect: &Rectangle
     let dest = SkRect::new(r.x as f32, r.y as f32, (r.x + r.width) as f32, (r.y + r.height) as f32);
     let mut paint = Paint::default();
     paint.set_anti_alias(true);
-    canvas.draw_image_rect_with_sampling_options(&image, None, dest, SamplingOptions::default(), &paint);
+    // Linear: the raster is up to a bucket step larger than the rect. At 1:1 it samples pixel centers.
+    let sampling = SamplingOptions::new(FilterMode::Linear, MipmapMode::None);
+    canvas.draw_image_rect_with_sampling_options(&image, None, dest, sampling, &paint);
 }
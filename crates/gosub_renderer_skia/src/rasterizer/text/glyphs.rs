@@ -113,7 +113,7 @@ mod tests {
     /// onto a white raster canvas, and assert dark pixels landed inside the text box.
     #[test]
     fn paints_visible_glyphs() {
-        let mut fs = SkiaFontSystem;
+        let fs = SkiaFontSystem;
 
         let info = skia_safe::ImageInfo::new(
             skia_safe::ISize::new(200, 60),
@@ -55,25 +55,9 @@ pub struct WgpuResources {
     pub queue: Arc<wgpu::Queue>,
     pub renderer: Mutex<Renderer>,
     /// GPU-resident tiles, keyed by an opaque id handed to the engine inside a `TilePixels::Gpu`.
-    /// The GPU sibling of the pipeline's CPU `TextureStore`; shared by the rasterizer (stores) and
-    /// the backend compositor (resolves ids → views to blit).
-    pub tile_textures: Mutex<std::collections::HashMap<u64, (wgpu::Texture, wgpu::TextureView)>>,
-    pub next_tile_id: std::sync::atomic::AtomicU64,
-}
-
-impl WgpuResources {
-    /// Store a rasterized GPU tile and return its opaque id.
-    pub fn store_tile(&self, texture: wgpu::Texture) -> u64 {
-        let view = texture.create_view(&Default::default());
-        let id = self.next_tile_id.fetch_add(1, std::sync::atomic::Ordering::Relaxed);
-        self.tile_textures.lock().insert(id, (texture, view));
-        id
-    }
-
-    /// Resolve a tile id to its texture view (cloned handle), if still resident.
-    pub fn tile_view(&self, id: u64) -> Option<wgpu::TextureView> {
-        self.tile_textures.lock().get(&id).map(|(_, v)| v.clone())
-    }
+    /// The GPU sibling of the pipeline's CPU `TextureStore`; shared by the rasterizer (allocates
+    /// slots) and the backend compositor (resolves ids to atlas layers to blit).
+    pub(crate) tile_atlas: Mutex<crate::gpu_tiles::TileAtlas>,
 }
 
 pub struct VelloBackend<C: WgpuContextProvider + Send + Sync> {
@@ -83,13 +67,11 @@ pub struct VelloBackend<C: WgpuContextProvider + Send + Sync> {
     font_manager: Mutex<FontManager>,
     font_cache: Mutex<FontCache>,
     /// Shared so all text shaping in this backend uses one font discovery context.
-    font_system: Arc<Mutex<ParleyFontSystem>>,
+    font_system: Arc<ParleyFontSystem>,
     /// `GOSUB_VELLO_GPU_TILES=1`: opt into the shared tile pipeline (rasterize to GPU textures +
     /// `composite_tiles`) instead of the one-shot whole-viewport scene path.
     gpu_tile_pipeline: bool,
     gpu_compositor: Mutex<crate::gpu_tiles::GpuTileCompositor>,
-    /// Frame counter for rate-limited GPU-tile diagnostics.
-    diag_frame: std::sync::atomic::AtomicU64,
 }
 
 impl<C: WgpuContextProvider + Send + Sync> VelloBackend<C> {
@@ -107,8 +89,7 @@ impl<C: WgpuContextProvider + Send + Sync> VelloBackend<C> {
             device: context.device_arc(),
             queue: context.queue_arc(),
             renderer: Mutex::new(renderer),
-            tile_textures: Mutex::new(std::collections::HashMap::new()),
-            next_tile_id: std::sync::atomic::AtomicU64::new(1),
+            tile_atlas: Mutex::new(crate::gpu_tiles::TileAtlas::default()),
         });
 
         Ok(Self {
@@ -117,15 +98,14 @@ impl<C: WgpuContextProvider + Send + Sync> VelloBackend<C> {
             text_renderer: Mutex::new(TextRenderer::new()),
             font_manager: Mutex::new(FontManager::new()),
             font_cache: Mutex::new(FontCache::new()),
-            font_system: Arc::new(Mutex::new(ParleyFontSystem::new())),
+            font_system: Arc::new(ParleyFontSystem::new()),
             gpu_tile_pipeline: std::env::var("GOSUB_VELLO_GPU_TILES").as_deref() == Ok("1"),
             gpu_compositor: Mutex::new(crate::gpu_tiles::GpuTileCompositor::default()),
-            diag_frame: std::sync::atomic::AtomicU64::new(0),
         })
     }
 
     /// Share with the layouter/rasterizer so layout and render use one font discovery context.
-    pub fn font_system(&self) -> Arc<Mutex<ParleyFontSystem>> {
+    pub fn font_system(&self) -> Arc<ParleyFontSystem> {
         Arc::clone(&self.font_system)
     }
 
@@ -307,9 +287,8 @@ impl<C: WgpuContextProvider + Send + Sync> RenderBackend for VelloBackend<C> {
             let mut tr = self.text_renderer.lock();
             let mut fm = self.font_manager.lock();
             let mut fc = self.font_cache.lock();
-            let mut fs = self.font_system.lock();
-            let font_cx = fs.font_cx_mut();
-            self.build_scene(&mut tr, &mut fm, &mut fc, font_cx, ctx)?
+            self.font_system
+                .with_font_cx(|font_cx| self.build_scene(&mut tr, &mut fm, &mut fc, font_cx, ctx))?
         };
 
         let s = surface
@@ -332,7 +311,7 @@ impl<C: WgpuContextProvider + Send + Sync> RenderBackend for VelloBackend<C> {
 
     fn create_rasterizer(
         &self,
-        font_system: Arc<parking_lot::Mutex<dyn gosub_interface::font_system::FontSystem>>,
+        font_system: Arc<dyn gosub_interface::font_system::FontSystem>,
     ) -> Box<dyn Any + Send + Sync> {
         // The rasterizer re-exposes this to the layouter, so layout and render share one instance.
         erase_rasterizer(Box::new(crate::VelloRasterizer::with_font_system(
@@ -374,12 +353,13 @@ impl<C: WgpuContextProvider + Send + Sync> RenderBackend for VelloBackend<C> {
             .get_texture(s.texture_store_id)
             .ok_or_else(|| anyhow!("invalid texture id in VelloSurface"))?;
 
-        // Cull to the visible viewport, or we'd issue a draw per tile for the WHOLE page every
-        // frame (thousands on a tall page). Mirrors the CPU path's `pipeline_composite`.
+        // Cull to the visible viewport, or we'd upload and draw an instance per tile for the WHOLE
+        // page every frame (thousands on a tall page). Mirrors the CPU path's `pipeline_composite`.
         let (vw, vh) = (viewport.0 as f32, viewport.1 as f32);
         let (sx, sy) = scroll;
         use gosub_render_pipeline::render::backend::TileAnchor;
-        let visible = |t: &gosub_render_pipeline::render::backend::PlacedGpuTile| {
+        // Within `margin` px above or below the viewport.
+        let near = |t: &gosub_render_pipeline::render::backend::PlacedGpuTile, margin: f32| {
             // Fixed tiles are pinned to the viewport, so cull them against [0, viewport] in page
             // space (page == viewport for fixed); scrolling tiles cull against [scroll, +viewport].
             let (ox, oy) = match t.anchor {
@@ -394,22 +374,15 @@ impl<C: WgpuContextProvider + Send + Sync> RenderBackend for VelloBackend<C> {
             };
             t.page_x + t.width as f32 > ox
                 && t.page_x < ox + vw
-                && t.page_y + t.height as f32 > oy
-                && t.page_y < oy + vh
+                && t.page_y + t.height as f32 > oy - margin
+                && t.page_y < oy + vh + margin
         };
 
-        let views: Vec<(
-            wgpu::TextureView,
-            &gosub_render_pipeline::render::backend::PlacedGpuTile,
-        )> = tiles
+        let placed: Vec<crate::gpu_tiles::PlacedTileTex> = tiles
             .iter()
-            .filter(|t| visible(t))
-            .filter_map(|t| self.resources.tile_view(t.texture_id).map(|v| (v, t)))
-            .collect();
-        let placed: Vec<crate::gpu_tiles::PlacedTileTex> = views
-            .iter()
-            .map(|(view, t)| crate::gpu_tiles::PlacedTileTex {
-                view,
+            .filter(|t| near(t, 0.0))
+            .map(|t| crate::gpu_tiles::PlacedTileTex {
+                tile_id: t.texture_id,
                 page_x: t.page_x,
                 page_y: t.page_y,
                 width: t.width,
@@ -420,9 +393,15 @@ impl<C: WgpuContextProvider + Send + Sync> RenderBackend for VelloBackend<C> {
             .collect();
 
         let t0 = std::time::Instant::now();
+        let mut atlas = self.resources.tile_atlas.lock();
+        // Pin what is on screen plus a viewport's worth either way, so the next scroll steps
+        // find their tiles resident. The rest may be evicted under memory pressure; the engine
+        // rasterizes those again once they come near the viewport.
+        atlas.begin_frame(tiles.iter().filter(|t| near(t, vh)).map(|t| t.texture_id));
         self.gpu_compositor.lock().composite(
             self.context.device(),
             self.context.queue(),
+            &atlas,
             &target_view,
             wgpu::TextureFormat::Rgba8Unorm,
             viewport.0,
@@ -432,18 +411,17 @@ impl<C: WgpuContextProvider + Send + Sync> RenderBackend for VelloBackend<C> {
             &placed,
         );
 
-        // Rate-limited diagnostics: `total`/`resident` huge and growing means the whole page is
-        // being rasterized/kept (no eviction); `visible` should stay small while scrolling.
-        let n = self.diag_frame.fetch_add(1, std::sync::atomic::Ordering::Relaxed);
-        if n.is_multiple_of(60) {
-            eprintln!(
-                "[gpu-tile] composite: total={} visible={} resident={} submit={:?}",
-                tiles.len(),
-                placed.len(),
-                self.resources.tile_textures.lock().len(),
-                t0.elapsed(),
-            );
-        }
+        // `total`/`resident` huge and growing means the whole page is being rasterized/kept (no
+        // eviction); `visible` should stay small while scrolling.
+        log::trace!(
+            "gpu tile composite: total={} visible={} resident={} pages={} submit={:?}",
+            tiles.len(),
+            placed.len(),
+            atlas.len(),
+            atlas.page_count(),
+            t0.elapsed(),
+        );
+        drop(atlas);
 
         s.frame_id = s.frame_id.wrapping_add(1);
         Ok(())
@@ -1,8 +1,11 @@
-//! Shared GPU tile compositor for wgpu-based backends.
+//! Shared GPU tile atlas and compositor for wgpu-based backends.
 //!
-//! Blits GPU-resident tiles into the surface; the engine owns all tiling, rasterization and caching.
-//! Nothing here is Vello-specific (it needs only a wgpu device and tile texture views), so it can
-//! move to a shared gpu-support crate and serve any wgpu backend.
+//! Rasterized tiles live in a [`TileAtlas`]: pages of 2D-array textures, one tile per layer, so a
+//! new tile takes a free (or evicted) layer instead of a fresh texture. The compositor blits the
+//! visible tiles into the surface with one instanced draw per run of tiles sharing a page - in
+//! practice one or two draws per frame. The engine owns all tiling, rasterization and caching.
+//! Nothing here is Vello-specific (it needs only a wgpu device and the atlas), so it can move to a
+//! shared gpu-support crate and serve any wgpu backend.
 //!
 //! `copy_texture_to_texture` would be simpler than this blit pass, but the host-created surface has
 //! only `RENDER_ATTACHMENT` (not `COPY_DST`) - and a render pass gives premultiplied-alpha blending
@@ -11,9 +14,10 @@
 use gosub_render_pipeline::render::backend::{anchored_tile_pos, TileAnchor};
 use vello::wgpu;
 
-/// A placed, GPU-resident tile to composite: a texture view plus its page-space rectangle.
-pub struct PlacedTileTex<'a> {
-    pub view: &'a wgpu::TextureView,
+/// A placed, GPU-resident tile to composite: its atlas id plus its page-space rectangle.
+pub struct PlacedTileTex {
+    /// Id returned by [`TileAtlas::allocate`]; tiles no longer resident are skipped.
+    pub tile_id: u64,
     pub page_x: f32,
     pub page_y: f32,
     pub width: u32,
@@ -24,31 +28,297 @@ pub struct PlacedTileTex<'a> {
     pub anchor: TileAnchor,
 }
 
-/// Per-tile blit uniform: destination rect plus target dimensions, so the vertex shader can map to
-/// clip space. 32 bytes, std140-friendly.
-struct BlitUniform {
+// ---------------------------------------------------------------------------
+// Tile atlas
+// ---------------------------------------------------------------------------
+
+/// Layers per atlas page (capped by the device's `max_texture_array_layers`).
+const ATLAS_PAGE_LAYERS: u32 = 64;
+
+/// Atlas memory beyond which tiles no recent frame used are evicted instead of adding a page.
+const ATLAS_BUDGET_BYTES: u64 = 256 << 20;
+
+/// Atlas memory the atlas never grows past. Between the budget and this, pinned tiles force new
+/// pages; at this size even pinned tiles are evicted, all but those of the current frame.
+const ATLAS_MAX_BYTES: u64 = 2 * ATLAS_BUDGET_BYTES;
+
+/// A tile retained by one of the last `PINNED_FRAMES` composites (or allocated or retained since
+/// then) is only evicted at [`ATLAS_MAX_BYTES`], so a frame - or a render still rasterizing the
+/// next one - keeps its tiles. Composites retain the tiles in and near the viewport only.
+const PINNED_FRAMES: u64 = 120;
+
+struct AtlasPage {
+    /// Whole-array view, sampled by the compositor.
+    array_view: wgpu::TextureView,
+    /// One 2D view per layer: the render target for the tile in that layer.
+    layer_views: Vec<wgpu::TextureView>,
+}
+
+#[derive(Clone, Copy, Default)]
+struct Slot {
+    /// Bumped on every allocation so ids handed out for an earlier occupant stop resolving.
+    generation: u32,
+    live: bool,
+    last_used: u64,
+}
+
+/// Pooled storage for GPU-resident tiles. Ids pack `(generation << 32) | slot`; a slot is
+/// `page * layers_per_page + layer`. Every slot is `slot_size` square, and tiles smaller than that
+/// use its top-left corner; the rest of the slot keeps whatever an earlier tile left there, so
+/// the blit clamps its samples to the tile's own texels.
+#[derive(Default)]
+pub struct TileAtlas {
+    slot_size: u32,
+    layers_per_page: u32,
+    pages: Vec<AtlasPage>,
+    slots: Vec<Slot>,
+    free: Vec<u32>,
+    /// Composite counter; see [`PINNED_FRAMES`].
+    frame: u64,
+    next_generation: u32,
+    /// Bumped whenever the pages are dropped, so the compositor rebuilds its bind groups.
+    epoch: u64,
+}
+
+impl TileAtlas {
+    /// Allocates a slot for a `width` x `height` tile, returning its id and the view to render
+    /// into. Prefers a free slot, then a new page while under [`ATLAS_BUDGET_BYTES`], then the
+    /// least recently used unpinned tile, then a new page while under [`ATLAS_MAX_BYTES`], then
+    /// the least recently used tile the current frame does not use. `None` if the tile exceeds
+    /// the device's texture limits, or every slot of a full atlas belongs to the current frame.
+    pub fn allocate(&mut self, device: &wgpu::Device, width: u32, height: u32) -> Option<(u64, wgpu::TextureView)> {
+        let need = width.max(height).max(1);
+        if need > device.limits().max_texture_dimension_2d {
+            return None;
+        }
+        if need > self.slot_size {
+            // Tiles grew (e.g. a larger tile size): start over with bigger slots. Outstanding ids
+            // stop resolving, so the engine's cache re-rasterizes those tiles.
+            if self.slot_size != 0 {
+                log::info!(
+                    "gpu tile atlas: slot size {} -> {need}, dropping resident tiles",
+                    self.slot_size
+                );
+            }
+            *self = TileAtlas {
+                slot_size: need,
+                layers_per_page: ATLAS_PAGE_LAYERS.min(device.limits().max_texture_array_layers).max(1),
+                frame: self.frame,
+                next_generation: self.next_generation,
+                epoch: self.epoch + 1,
+                ..TileAtlas::default()
+            };
+        }
+
+        let grown = self.bytes() + self.page_bytes();
+        let slot = match self.free.pop() {
+            Some(slot) => slot,
+            None if grown <= ATLAS_BUDGET_BYTES => self.add_page(device),
+            None => match self.lru_older_than(PINNED_FRAMES) {
+                Some(slot) => slot,
+                // Every resident tile is pinned (in or near a recent viewport): grow past the
+                // budget, up to the hard limit, rather than evict one.
+                None if grown <= ATLAS_MAX_BYTES => self.add_page(device),
+                None => match self.lru_older_than(0) {
+                    Some(slot) => {
+                        log::debug!("gpu tile atlas at its {ATLAS_MAX_BYTES}-byte limit, evicting a pinned tile");
+                        slot
+                    }
+                    None => {
+                        log::warn!("gpu tile atlas full with tiles of the current frame");
+                        return None;
+                    }
+                },
+            },
+        };
+
+        self.next_generation = self.next_generation.wrapping_add(1);
+        let generation = self.next_generation;
+        self.slots[slot as usize] = Slot {
+            generation,
+            live: true,
+            last_used: self.frame,
+        };
+        let (page, layer) = self.page_and_layer(slot);
+        let view = self.pages[page as usize].layer_views[layer as usize].clone();
+        Some(((u64::from(generation) << 32) | u64::from(slot), view))
+    }
+
+    /// Returns a slot to the free list (e.g. when rendering into it failed).
+    pub fn release(&mut self, tile_id: u64) {
+        if let Some(slot) = self.live_slot(tile_id) {
+            self.slots[slot as usize].live = false;
+            self.free.push(slot);
+        }
+    }
+
+    /// Marks a tile as in use, so it is not evicted before the next frames show it. `false` when
+    /// it has been evicted already.
+    pub fn retain(&mut self, tile_id: u64) -> bool {
+        match self.live_slot(tile_id) {
+            Some(slot) => {
+                self.slots[slot as usize].last_used = self.frame;
+                true
+            }
+            None => false,
+        }
+    }
+
+    /// Starts a composite that shows or is about to show `tile_ids` (the visible tiles plus a
+    /// prefetch margin), pinning them. Tiles left out can be evicted; the engine finds out when
+    /// it next [retains](Self::retain) them and rasterizes them again.
+    pub fn begin_frame(&mut self, tile_ids: impl IntoIterator<Item = u64>) {
+        self.frame += 1;
+        for id in tile_ids {
+            self.retain(id);
+        }
+    }
+
+    /// `(page, layer)` of a resident tile.
+    pub fn resolve(&self, tile_id: u64) -> Option<(u32, u32)> {
+        self.live_slot(tile_id).map(|slot| self.page_and_layer(slot))
+    }
+
+    /// Number of resident tiles.
+    pub fn len(&self) -> usize {
+        self.slots.iter().filter(|s| s.live).count()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Number of pages (2D-array textures).
+    pub fn page_count(&self) -> usize {
+        self.pages.len()
+    }
+
+    /// Edge length of a slot, in pixels.
+    pub fn slot_size(&self) -> u32 {
+        self.slot_size
+    }
+
+    fn page_view(&self, page: u32) -> Option<&wgpu::TextureView> {
+        self.pages.get(page as usize).map(|p| &p.array_view)
+    }
+
+    fn live_slot(&self, tile_id: u64) -> Option<u32> {
+        let slot = (tile_id & u64::from(u32::MAX)) as u32;
+        let generation = (tile_id >> 32) as u32;
+        let s = self.slots.get(slot as usize)?;
+        (s.live && s.generation == generation).then_some(slot)
+    }
+
+    fn page_and_layer(&self, slot: u32) -> (u32, u32) {
+        (slot / self.layers_per_page, slot % self.layers_per_page)
+    }
+
+    fn page_bytes(&self) -> u64 {
+        u64::from(self.slot_size) * u64::from(self.slot_size) * 4 * u64::from(self.layers_per_page)
+    }
+
+    fn bytes(&self) -> u64 {
+        self.page_bytes() * self.pages.len() as u64
+    }
+
+    /// The least recently used live slot not retained during the last `frames` composites.
+    fn lru_older_than(&self, frames: u64) -> Option<u32> {
+        self.slots
+            .iter()
+            .enumerate()
+            .filter(|(_, s)| s.live && self.frame.saturating_sub(s.last_used) > frames)
+            .min_by_key(|(_, s)| s.last_used)
+            .map(|(i, _)| i as u32)
+    }
+
+    /// Adds a page, putting all but its first slot on the free list; returns that first slot.
+    fn add_page(&mut self, device: &wgpu::Device) -> u32 {
+        let texture = device.create_texture(&wgpu::TextureDescriptor {
+            label: Some("gpu-tile-atlas-page"),
+            size: wgpu::Extent3d {
+                width: self.slot_size,
+                height: self.slot_size,
+                depth_or_array_layers: self.layers_per_page,
+            },
+            mip_level_count: 1,
+            sample_count: 1,
+            dimension: wgpu::TextureDimension::D2,
+            format: wgpu::TextureFormat::Rgba8Unorm,
+            // RENDER_ATTACHMENT + STORAGE_BINDING: Vello renders into a layer.
+            // TEXTURE_BINDING: the blit pass samples the array.
+            usage: wgpu::TextureUsages::RENDER_ATTACHMENT
+                | wgpu::TextureUsages::STORAGE_BINDING
+                | wgpu::TextureUsages::TEXTURE_BINDING,
+            view_formats: &[],
+        });
+        let array_view = texture.create_view(&wgpu::TextureViewDescriptor {
+            label: Some("gpu-tile-atlas-array"),
+            dimension: Some(wgpu::TextureViewDimension::D2Array),
+            ..Default::default()
+        });
+        let layer_views = (0..self.layers_per_page)
+            .map(|layer| {
+                texture.create_view(&wgpu::TextureViewDescriptor {
+                    label: Some("gpu-tile-atlas-layer"),
+                    dimension: Some(wgpu::TextureViewDimension::D2),
+                    base_array_layer: layer,
+                    array_layer_count: Some(1),
+                    ..Default::default()
+                })
+            })
+            .collect();
+
+        let first = self.slots.len() as u32;
+        self.pages.push(AtlasPage {
+            array_view,
+            layer_views,
+        });
+        self.slots
+            .resize(self.slots.len() + self.layers_per_page as usize, Slot::default());
+        // Reversed so `pop` hands the slots out in order.
+        self.free.extend((first + 1..first + self.layers_per_page).rev());
+        first
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Compositor
+// ---------------------------------------------------------------------------
+
+/// Frame uniform: target dimensions, so the vertex shader can map to clip space. 16 bytes,
+/// std140-friendly.
+fn viewport_uniform(target_w: u32, target_h: u32) -> [u8; 16] {
+    let mut out = [0u8; 16];
+    out[0..4].copy_from_slice(&(target_w as f32).to_le_bytes());
+    out[4..8].copy_from_slice(&(target_h as f32).to_le_bytes());
+    out
+}
+
+/// Per-tile instance: destination rect, the tile's share of its slot, atlas layer and group
+/// opacity. 32 bytes.
+struct TileInstance {
     dst: [f32; 4],      // x, y, w, h  (target pixels)
-    viewport: [f32; 2], // target width, height
-    opacity: f32,       // group opacity for the tile's layer
+    uv_scale: [f32; 2], // tile size / slot size
+    layer: u32,
+    opacity: f32,
 }
 
-impl BlitUniform {
-    fn to_bytes(&self) -> [u8; 32] {
-        let mut out = [0u8; 32];
-        let floats = [
+impl TileInstance {
+    const SIZE: u64 = 32;
+
+    fn write_to(&self, out: &mut Vec<u8>) {
+        for f in [
             self.dst[0],
             self.dst[1],
             self.dst[2],
             self.dst[3],
-            self.viewport[0],
-            self.viewport[1],
-            self.opacity,
-            0.0,
-        ];
-        for (i, f) in floats.iter().enumerate() {
-            out[i * 4..i * 4 + 4].copy_from_slice(&f.to_le_bytes());
+            self.uv_scale[0],
+            self.uv_scale[1],
+        ] {
+            out.extend_from_slice(&f.to_le_bytes());
         }
-        out
+        out.extend_from_slice(&self.layer.to_le_bytes());
+        out.extend_from_slice(&self.opacity.to_le_bytes());
     }
 }
 
@@ -56,45 +326,61 @@ struct BlitPipeline {
     pipeline: wgpu::RenderPipeline,
     layout: wgpu::BindGroupLayout,
     sampler: wgpu::Sampler,
+    uniforms: wgpu::Buffer,
     target_format: wgpu::TextureFormat,
 }
 
 const BLIT_WGSL: &str = r#"
 struct Uniforms {
-    dst: vec4<f32>,
     viewport: vec2<f32>,
-    opacity: f32,
-    pad: f32,
+    pad: vec2<f32>,
 };
 @group(0) @binding(0) var<uniform> u: Uniforms;
-@group(0) @binding(1) var tex: texture_2d<f32>;
+@group(0) @binding(1) var tex: texture_2d_array<f32>;
 @group(0) @binding(2) var samp: sampler;
 
+struct Instance {
+    @location(0) dst: vec4<f32>,
+    @location(1) uv_scale: vec2<f32>,
+    @location(2) layer: u32,
+    @location(3) opacity: f32,
+};
+
 struct VsOut {
     @builtin(position) pos: vec4<f32>,
     @location(0) uv: vec2<f32>,
+    @location(1) @interpolate(flat) layer: u32,
+    @location(2) @interpolate(flat) opacity: f32,
+    @location(3) @interpolate(flat) uv_max: vec2<f32>,
 };
 
 @vertex
-fn vs(@builtin(vertex_index) vid: u32) -> VsOut {
+fn vs(@builtin(vertex_index) vid: u32, inst: Instance) -> VsOut {
     var corners = array<vec2<f32>, 6>(
         vec2<f32>(0.0, 0.0), vec2<f32>(1.0, 0.0), vec2<f32>(0.0, 1.0),
         vec2<f32>(0.0, 1.0), vec2<f32>(1.0, 0.0), vec2<f32>(1.0, 1.0),
     );
     let c = corners[vid];
-    let px = u.dst.xy + c * u.dst.zw;
+    let px = inst.dst.xy + c * inst.dst.zw;
     let ndc = vec2<f32>(px.x / u.viewport.x * 2.0 - 1.0, 1.0 - px.y / u.viewport.y * 2.0);
     var out: VsOut;
     out.pos = vec4<f32>(ndc, 0.0, 1.0);
-    out.uv = c;
+    out.uv = c * inst.uv_scale;
+    out.layer = inst.layer;
+    out.opacity = inst.opacity;
+    out.uv_max = inst.uv_scale;
     return out;
 }
 
 @fragment
 fn fs(in: VsOut) -> @location(0) vec4<f32> {
+    // Keep the filter footprint inside the tile: past its right and bottom edge the slot holds
+    // stale texels of whatever tile used it before.
+    let half_texel = 0.5 / vec2<f32>(textureDimensions(tex));
+    let uv = min(in.uv, in.uv_max - half_texel);
     // Tiles are premultiplied; scaling all four channels by opacity keeps them premultiplied and
     // fades the whole layer as a group.
-    return textureSample(tex, samp, in.uv) * u.opacity;
+    return textureSample(tex, samp, uv, in.layer) * in.opacity;
 }
 "#;
 
@@ -110,8 +396,7 @@ impl BlitPipeline {
             entries: &[
                 wgpu::BindGroupLayoutEntry {
                     binding: 0,
-                    // Both stages read it: vertex uses dst/viewport, fragment uses `opacity`.
-                    visibility: wgpu::ShaderStages::VERTEX_FRAGMENT,
+                    visibility: wgpu::ShaderStages::VERTEX,
                     ty: wgpu::BindingType::Buffer {
                         ty: wgpu::BufferBindingType::Uniform,
                         has_dynamic_offset: false,
@@ -124,7 +409,7 @@ impl BlitPipeline {
                     visibility: wgpu::ShaderStages::FRAGMENT,
                     ty: wgpu::BindingType::Texture {
                         sample_type: wgpu::TextureSampleType::Float { filterable: true },
-                        view_dimension: wgpu::TextureViewDimension::D2,
+                        view_dimension: wgpu::TextureViewDimension::D2Array,
                         multisampled: false,
                     },
                     count: None,
@@ -159,13 +444,19 @@ impl BlitPipeline {
             },
         };
 
+        let instance_attributes = wgpu::vertex_attr_array![0 => Float32x4, 1 => Float32x2, 2 => Uint32, 3 => Float32];
+
         let pipeline = device.create_render_pipeline(&wgpu::RenderPipelineDescriptor {
             label: Some("gpu-tiles-blit-pipeline"),
             layout: Some(&pipeline_layout),
             vertex: wgpu::VertexState {
                 module: &shader,
                 entry_point: Some("vs"),
-                buffers: &[],
+                buffers: &[wgpu::VertexBufferLayout {
+                    array_stride: TileInstance::SIZE,
+                    step_mode: wgpu::VertexStepMode::Instance,
+                    attributes: &instance_attributes,
+                }],
                 compilation_options: Default::default(),
             },
             fragment: Some(wgpu::FragmentState {
@@ -190,44 +481,140 @@ impl BlitPipeline {
             ..Default::default()
         });
 
+        let uniforms = device.create_buffer(&wgpu::BufferDescriptor {
+            label: Some("gpu-tiles-uniform"),
+            size: 16,
+            usage: wgpu::BufferUsages::UNIFORM | wgpu::BufferUsages::COPY_DST,
+            mapped_at_creation: false,
+        });
+
         Self {
             pipeline,
             layout,
             sampler,
+            uniforms,
             target_format,
         }
     }
 }
 
-/// Clears the target and blits the visible GPU tiles into it. The only state is the lazily-built
-/// blit pipeline, rebuilt when the target format changes.
+/// Clears the target and blits the visible GPU tiles into it. Keeps the lazily-built blit
+/// pipeline (rebuilt when the target format changes), one bind group per atlas page and an
+/// instance buffer that only grows.
 #[derive(Default)]
 pub struct GpuTileCompositor {
     blit: Option<BlitPipeline>,
+    /// Bind groups for the atlas pages, valid for `bind_group_epoch`.
+    bind_groups: Vec<wgpu::BindGroup>,
+    bind_group_epoch: u64,
+    instances: Option<wgpu::Buffer>,
+    /// Reused staging for the instance data.
+    instance_bytes: Vec<u8>,
 }
 
 impl GpuTileCompositor {
-    /// Clear `target_view` to white and composite every tile in `tiles` at `page_pos - scroll`.
+    /// Clear `target_view` to white and composite every tile in `tiles` at `page_pos - scroll`, in
+    /// order. Tiles no longer resident in `atlas` are skipped.
     #[allow(clippy::too_many_arguments)]
     pub fn composite(
         &mut self,
         device: &wgpu::Device,
         queue: &wgpu::Queue,
+        atlas: &TileAtlas,
         target_view: &wgpu::TextureView,
         target_format: wgpu::TextureFormat,
         target_w: u32,
         target_h: u32,
         scroll_x: f32,
         scroll_y: f32,
-        tiles: &[PlacedTileTex<'_>],
+        tiles: &[PlacedTileTex],
     ) {
         if self.blit.as_ref().map(|b| b.target_format) != Some(target_format) {
             self.blit = Some(BlitPipeline::new(device, target_format));
+            self.bind_groups.clear();
         }
         let Some(blit) = self.blit.as_ref() else {
             return;
         };
 
+        if self.bind_group_epoch != atlas.epoch {
+            self.bind_groups.clear();
+            self.bind_group_epoch = atlas.epoch;
+        }
+        while self.bind_groups.len() < atlas.page_count() {
+            let Some(view) = atlas.page_view(self.bind_groups.len() as u32) else {
+                break;
+            };
+            self.bind_groups
+                .push(device.create_bind_group(&wgpu::BindGroupDescriptor {
+                    label: Some("gpu-tiles-bg"),
+                    layout: &blit.layout,
+                    entries: &[
+                        wgpu::BindGroupEntry {
+                            binding: 0,
+                            resource: blit.uniforms.as_entire_binding(),
+                        },
+                        wgpu::BindGroupEntry {
+                            binding: 1,
+                            resource: wgpu::BindingResource::TextureView(view),
+                        },
+                        wgpu::BindGroupEntry {
+                            binding: 2,
+                            resource: wgpu::BindingResource::Sampler(&blit.sampler),
+                        },
+                    ],
+                }));
+        }
+        queue.write_buffer(&blit.uniforms, 0, &viewport_uniform(target_w, target_h));
+
+        // One instance per resident tile, plus the runs of consecutive tiles sharing a page: each
+        // run is one draw, and runs keep the back-to-front order of `tiles`.
+        let slot = atlas.slot_size().max(1) as f32;
+        let mut runs: Vec<(u32, std::ops::Range<u32>)> = Vec::new();
+        self.instance_bytes.clear();
+        let mut count = 0u32;
+        for tile in tiles {
+            let Some((page, layer)) = atlas.resolve(tile.tile_id) else {
+                continue;
+            };
+            // Shared helper keeps fixed/sticky placement in lock-step with the CPU compositor.
+            let (ex, ey) = anchored_tile_pos(
+                tile.page_x as f64,
+                tile.page_y as f64,
+                scroll_x as f64,
+                scroll_y as f64,
+                tile.anchor,
+            );
+            TileInstance {
+                dst: [ex as f32, ey as f32, tile.width as f32, tile.height as f32],
+                uv_scale: [tile.width as f32 / slot, tile.height as f32 / slot],
+                layer,
+                opacity: tile.opacity,
+            }
+            .write_to(&mut self.instance_bytes);
+            match runs.last_mut() {
+                Some((p, range)) if *p == page => range.end = count + 1,
+                _ => runs.push((page, count..count + 1)),
+            }
+            count += 1;
+        }
+
+        let needed = self.instance_bytes.len() as u64;
+        if self.instances.as_ref().is_none_or(|b| b.size() < needed) {
+            self.instances = Some(device.create_buffer(&wgpu::BufferDescriptor {
+                label: Some("gpu-tiles-instances"),
+                size: needed.next_power_of_two().max(TileInstance::SIZE * 64),
+                usage: wgpu::BufferUsages::VERTEX | wgpu::BufferUsages::COPY_DST,
+                mapped_at_creation: false,
+            }));
+        }
+        let Some(instances) = self.instances.as_ref() else {
+            return;
+        };
+        if needed > 0 {
+            queue.write_buffer(instances, 0, &self.instance_bytes);
+        }
+
         let mut encoder = device.create_command_encoder(&wgpu::CommandEncoderDescriptor {
             label: Some("gpu-tiles-composite"),
         });
@@ -249,83 +636,19 @@ impl GpuTileCompositor {
                 multiview_mask: None,
             });
             pass.set_pipeline(&blit.pipeline);
-
-            // Transient per-tile uniform buffers + bind groups, kept alive until the pass ends.
-            let mut keep_alive: Vec<(wgpu::Buffer, wgpu::BindGroup)> = Vec::with_capacity(tiles.len());
-            for tile in tiles {
-                // Shared helper keeps fixed/sticky placement in lock-step with the CPU compositor.
-                let (ex, ey) = anchored_tile_pos(
-                    tile.page_x as f64,
-                    tile.page_y as f64,
-                    scroll_x as f64,
-                    scroll_y as f64,
-                    tile.anchor,
-                );
-                let (ex, ey) = (ex as f32, ey as f32);
-                let uniform = BlitUniform {
-                    dst: [ex, ey, tile.width as f32, tile.height as f32],
-                    viewport: [target_w as f32, target_h as f32],
-                    opacity: tile.opacity,
+            pass.set_vertex_buffer(0, instances.slice(..));
+            for (page, range) in runs {
+                let Some(bind_group) = self.bind_groups.get(page as usize) else {
+                    continue;
                 };
-                let ubuf = device.create_buffer(&wgpu::BufferDescriptor {
-                    label: Some("gpu-tiles-uniform"),
-                    size: 32,
-                    usage: wgpu::BufferUsages::UNIFORM | wgpu::BufferUsages::COPY_DST,
-                    mapped_at_creation: false,
-                });
-                queue.write_buffer(&ubuf, 0, &uniform.to_bytes());
-
-                let bind_group = device.create_bind_group(&wgpu::BindGroupDescriptor {
-                    label: Some("gpu-tiles-bg"),
-                    layout: &blit.layout,
-                    entries: &[
-                        wgpu::BindGroupEntry {
-                            binding: 0,
-                            resource: ubuf.as_entire_binding(),
-                        },
-                        wgpu::BindGroupEntry {
-                            binding: 1,
-                            resource: wgpu::BindingResource::TextureView(tile.view),
-                        },
-                        wgpu::BindGroupEntry {
-                            binding: 2,
-                            resource: wgpu::BindingResource::Sampler(&blit.sampler),
-                        },
-                    ],
-                });
-                let idx = keep_alive.len();
-                keep_alive.push((ubuf, bind_group));
-                pass.set_bind_group(0, &keep_alive[idx].1, &[]);
-                pass.draw(0..6, 0..1);
+                pass.set_bind_group(0, bind_group, &[]);
+                pass.draw(0..6, range);
             }
         }
         queue.submit(std::iter::once(encoder.finish()));
     }
 }
 
-/// Create an offscreen texture for a single rasterized tile, usable both as a Vello render target
-/// and as a sampled source in the blit compositor.
-pub(crate) fn create_tile_texture(device: &wgpu::Device, width: u32, height: u32) -> wgpu::Texture {
-    device.create_texture(&wgpu::TextureDescriptor {
-        label: Some("gpu-tile"),
-        size: wgpu::Extent3d {
-            width,
-            height,
-            depth_or_array_layers: 1,
-        },
-        mip_level_count: 1,
-        sample_count: 1,
-        dimension: wgpu::TextureDimension::D2,
-        format: wgpu::TextureFormat::Rgba8Unorm,
-        // RENDER_ATTACHMENT + STORAGE_BINDING: Vello renders into it.
-        // TEXTURE_BINDING: the blit pass samples it.
-        usage: wgpu::TextureUsages::RENDER_ATTACHMENT
-            | wgpu::TextureUsages::STORAGE_BINDING
-            | wgpu::TextureUsages::TEXTURE_BINDING,
-        view_formats: &[],
-    })
-}
-
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -334,21 +657,55 @@ mod tests {
     use vello::peniko::{Color, Fill};
     use vello::{AaConfig, AaSupport, RenderParams, Renderer, RendererOptions, Scene};
 
-    /// Composites two solid-color tiles side by side and reads back to check placement.
-    /// Skips if no wgpu adapter is available.
-    #[test]
-    fn gpu_tile_compositor_smoke() {
+    fn device(test: &str) -> Option<(wgpu::Device, wgpu::Queue)> {
         let instance = wgpu::Instance::new(wgpu::InstanceDescriptor::new_without_display_handle());
         let Ok(adapter) = pollster::block_on(instance.request_adapter(&wgpu::RequestAdapterOptions {
             compatible_surface: None,
             power_preference: wgpu::PowerPreference::default(),
             force_fallback_adapter: false,
         })) else {
-            eprintln!("no wgpu adapter — skipping gpu_tile_compositor_smoke");
+            eprintln!("no wgpu adapter — skipping {test}");
+            return None;
+        };
+        Some(pollster::block_on(adapter.request_device(&wgpu::DeviceDescriptor::default())).expect("device"))
+    }
+
+    /// Released and replaced slots hand out fresh ids; the old ones stop resolving.
+    /// Skips if no wgpu adapter is available.
+    #[test]
+    fn tile_atlas_reuses_slots_with_fresh_ids() {
+        let Some((device, _queue)) = device("tile_atlas_reuses_slots_with_fresh_ids") else {
+            return;
+        };
+        let mut atlas = TileAtlas::default();
+        let (a, _) = atlas.allocate(&device, 256, 256).expect("slot");
+        let (b, _) = atlas.allocate(&device, 200, 256).expect("slot");
+        assert_eq!(atlas.page_count(), 1);
+        assert_eq!(atlas.resolve(a), Some((0, 0)));
+        assert_eq!(atlas.resolve(b), Some((0, 1)));
+
+        atlas.release(a);
+        assert!(!atlas.retain(a));
+        let (c, _) = atlas.allocate(&device, 256, 256).expect("slot");
+        assert_ne!(a, c);
+        assert_eq!(atlas.resolve(c), Some((0, 0)));
+        assert_eq!(atlas.resolve(a), None);
+        assert_eq!(atlas.len(), 2);
+
+        // Bigger tiles need bigger slots: everything resident is dropped.
+        let (d, _) = atlas.allocate(&device, 512, 512).expect("slot");
+        assert_eq!(atlas.resolve(b), None);
+        assert_eq!(atlas.resolve(d), Some((0, 0)));
+        assert_eq!(atlas.slot_size(), 512);
+    }
+
+    /// Composites two solid-color tiles side by side and reads back to check placement.
+    /// Skips if no wgpu adapter is available.
+    #[test]
+    fn gpu_tile_compositor_smoke() {
+        let Some((device, queue)) = device("gpu_tile_compositor_smoke") else {
             return;
         };
-        let (device, queue) =
-            pollster::block_on(adapter.request_device(&wgpu::DeviceDescriptor::default())).expect("device");
         let renderer = Mutex::new(
             Renderer::new(
                 &device,
@@ -360,7 +717,8 @@ mod tests {
             .expect("renderer"),
         );
 
-        let make_tile = |color: Color| -> wgpu::Texture {
+        let mut atlas = TileAtlas::default();
+        let mut make_tile = |color: Color| -> u64 {
             let mut scene = Scene::new();
             scene.fill(
                 Fill::NonZero,
@@ -369,8 +727,7 @@ mod tests {
                 None,
                 &Rect::new(0.0, 0.0, 256.0, 256.0),
             );
-            let tex = create_tile_texture(&device, 256, 256);
-            let view = tex.create_view(&Default::default());
+            let (id, view) = atlas.allocate(&device, 256, 256).expect("atlas slot");
             renderer
                 .lock()
                 .render_to_texture(
@@ -386,13 +743,11 @@ mod tests {
                     },
                 )
                 .expect("render tile");
-            tex
+            id
         };
 
         let red = make_tile(Color::new([0.9, 0.1, 0.1, 1.0]));
         let blue = make_tile(Color::new([0.1, 0.1, 0.9, 1.0]));
-        let red_view = red.create_view(&Default::default());
-        let blue_view = blue.create_view(&Default::default());
 
         let (tw, th) = (512u32, 256u32);
         let target = device.create_texture(&wgpu::TextureDescriptor {
@@ -413,7 +768,7 @@ mod tests {
 
         let tiles = [
             PlacedTileTex {
-                view: &red_view,
+                tile_id: red,
                 page_x: 0.0,
                 page_y: 0.0,
                 width: 256,
@@ -422,7 +777,7 @@ mod tests {
                 anchor: TileAnchor::Scroll,
             },
             PlacedTileTex {
-                view: &blue_view,
+                tile_id: blue,
                 page_x: 256.0,
                 page_y: 0.0,
                 width: 256,
@@ -436,6 +791,7 @@ mod tests {
         compositor.composite(
             &device,
             &queue,
+            &atlas,
             &target_view,
             wgpu::TextureFormat::Rgba8Unorm,
             tw,
@@ -10,7 +10,6 @@ use gosub_render_pipeline::render::backend::TileAnchor;
 use gosub_render_pipeline::tiler::Tile;
 
 use crate::backend::WgpuResources;
-use parking_lot::Mutex;
 use std::sync::Arc;
 use vello::kurbo::{Affine, Rect, Vec2};
 use vello::peniko::{Color, Fill, Mix};
@@ -92,27 +91,32 @@ pub struct VelloRasterizer {
     resources: Arc<WgpuResources>,
     /// Exposed to the layouter via `Rasterable::font_system()` so layout measures with the
     /// configured instance. Painting no longer needs it - commands carry pre-shaped glyph runs.
-    font_system: Arc<Mutex<dyn FontSystem>>,
+    font_system: Arc<dyn FontSystem>,
 }
 
 impl VelloRasterizer {
     /// Create a rasterizer with its own Parley font system.
     pub fn new(resources: Arc<WgpuResources>) -> Self {
-        Self::with_font_system(resources, Arc::new(Mutex::new(ParleyFontSystem::new())))
+        Self::with_font_system(resources, Arc::new(ParleyFontSystem::new()))
     }
 
     /// Create a rasterizer that shares an existing font system.
-    pub fn with_font_system(resources: Arc<WgpuResources>, font_system: Arc<Mutex<dyn FontSystem>>) -> Self {
+    pub fn with_font_system(resources: Arc<WgpuResources>, font_system: Arc<dyn FontSystem>) -> Self {
         Self { resources, font_system }
     }
 }
 
 impl Rasterable for VelloRasterizer {
     /// Shared with the layouter so layout and render measure against the same instance.
-    fn font_system(&self) -> Option<Arc<Mutex<dyn FontSystem>>> {
+    fn font_system(&self) -> Option<Arc<dyn FontSystem>> {
         Some(Arc::clone(&self.font_system))
     }
 
+    /// Cached tiles are reusable for as long as their atlas slot hasn't been handed to another tile.
+    fn retain_gpu_tile(&self, gpu_id: u64) -> bool {
+        self.resources.tile_atlas.lock().retain(gpu_id)
+    }
+
     fn rasterize(&self, tile: &Tile, texture_store: &mut TextureStore, media_store: &MediaStore) -> Option<TextureId> {
         let mut scene = Scene::new();
 
@@ -141,9 +145,22 @@ impl Rasterable for VelloRasterizer {
         let device: &vello::wgpu::Device = &self.resources.device;
         let queue: &vello::wgpu::Queue = &self.resources.queue;
 
-        // The tile stays GPU-resident - no readback. The engine only ever sees the opaque id, which
-        // it carries through the normal tile cache and hands back to `composite_tiles`.
-        let texture = crate::gpu_tiles::create_tile_texture(device, tile_size.width as u32, tile_size.height as u32);
+        // The tile stays GPU-resident in an atlas slot - no readback. The engine only ever sees the
+        // opaque id, which it carries through the normal tile cache and hands back to
+        // `composite_tiles`.
+        let Some((gpu_id, view)) =
+            self.resources
+                .tile_atlas
+                .lock()
+                .allocate(device, tile_size.width as u32, tile_size.height as u32)
+        else {
+            log::warn!(
+                "tile of {}x{} exceeds the GPU texture limits",
+                tile.rect.width,
+                tile.rect.height
+            );
+            return None;
+        };
 
         let render_params = RenderParams {
             base_color: Color::new([0.0, 0.0, 0.0, 0.0]),
@@ -152,19 +169,17 @@ impl Rasterable for VelloRasterizer {
             antialiasing_method: AaConfig::Area,
         };
 
-        if let Err(e) = self.resources.renderer.lock().render_to_texture(
-            device,
-            queue,
-            &scene,
-            &texture.create_view(&Default::default()),
-            &render_params,
-        ) {
+        if let Err(e) = self
+            .resources
+            .renderer
+            .lock()
+            .render_to_texture(device, queue, &scene, &view, &render_params)
+        {
             log::error!("Vello render_to_texture failed: {:?}", e);
+            self.resources.tile_atlas.lock().release(gpu_id);
             return None;
         }
 
-        let gpu_id = self.resources.store_tile(texture);
-
         let texture_id = texture_store.add_gpu(
             tile_size.width as usize,
             tile_size.height as usize,
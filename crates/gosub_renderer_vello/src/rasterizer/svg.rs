@@ -1,7 +1,6 @@
 use gosub_render_pipeline::common::media::{MediaId, MediaStore};
 use gosub_render_pipeline::painter::commands::rectangle::Rectangle;
 use gosub_render_pipeline::render::backend::PixelFormat;
-use resvg::usvg::Transform;
 use vello::kurbo::{Affine, Vec2};
 use vello::peniko::{Blob, ImageAlphaType, ImageData, ImageFormat};
 
@@ -22,27 +21,9 @@ pub(crate) fn do_paint_svg(
     // the position into its shape path, which is why it only needs the bare `affine`.)
     let placement = affine * Affine::translate(Vec2::new(r.x, r.y));
 
-    {
-        let cached = media.svg.rendered.read();
-        if cached.is_usable(target_dim, PixelFormat::Rgba8) {
-            let image = ImageData {
-                data: Blob::from(cached.data.clone()),
-                format: ImageFormat::Rgba8,
-                alpha_type: ImageAlphaType::AlphaPremultiplied,
-                width: cached.dimension.width as u32,
-                height: cached.dimension.height as u32,
-            };
-            scene.draw_image(&image, placement);
-            return;
-        }
-    }
-
-    let intrinsic = media.svg.tree.size().to_int_size();
     let target_w = (target_dim.width as u32).max(1);
     let target_h = (target_dim.height as u32).max(1);
-    let scale_x = target_w as f32 / intrinsic.width().max(1) as f32;
-    let scale_y = target_h as f32 / intrinsic.height().max(1) as f32;
-    let Some(mut pixmap) = resvg::tiny_skia::Pixmap::new(target_w, target_h) else {
+    let Some(raster) = media.svg.raster(target_w, target_h, PixelFormat::Rgba8) else {
         log::error!(
             "Failed to allocate pixmap for SVG {:?} ({}x{})",
             media_id,
@@ -51,22 +32,16 @@ pub(crate) fn do_paint_svg(
         );
         return;
     };
-    resvg::render(
-        &media.svg.tree,
-        Transform::from_scale(scale_x, scale_y),
-        &mut pixmap.as_mut(),
-    );
-    let new_data = pixmap.data().to_vec();
-
-    let mut cached = media.svg.rendered.write();
-    cached.store(target_dim, PixelFormat::Rgba8, new_data);
 
+    let (raster_w, raster_h) = (raster.dimension.width, raster.dimension.height);
     let image = ImageData {
-        data: Blob::from(cached.data.clone()),
+        data: Blob::from(raster.data.clone()),
         format: ImageFormat::Rgba8,
         alpha_type: ImageAlphaType::AlphaPremultiplied,
-        width: cached.dimension.width as u32,
-        height: cached.dimension.height as u32,
+        width: raster_w as u32,
+        height: raster_h as u32,
     };
-    scene.draw_image(&image, placement);
+    // The raster is rendered at a size bucket; scale it back to the box.
+    let scale = Affine::scale_non_uniform(target_w as f64 / raster_w, target_h as f64 / raster_h);
+    scene.draw_image(&image, placement * scale);
 }
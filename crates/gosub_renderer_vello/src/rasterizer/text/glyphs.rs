@@ -82,7 +82,7 @@ mod tests {
     /// Exercises the `FontBlob` → `peniko::FontData` conversion and glyph encoding without a GPU.
     #[test]
     fn encodes_glyphs_into_scene() {
-        let mut fs = ParleyFontSystem::new();
+        let fs = ParleyFontSystem::new();
         let mut scene = Scene::new();
 
         let font_info = FontInfo {
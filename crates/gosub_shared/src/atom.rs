@@ -0,0 +1,264 @@
+//! Interned strings for names that are compared far more often than they are created: tag
+//! names, attribute names and CSS property names.
+//!
+//! An [`Atom`] is a cheap-to-clone handle to a name. Names in the static table of known names
+//! (HTML, SVG and MathML tags, CSS properties) are interned without allocating or locking: the
+//! table is a read-only set, two known atoms are equal exactly when they point at the same
+//! entry, and cloning one copies a pointer. Any other name (a custom element, a custom or
+//! vendor property) is kept in a reference-counted string shared by the atoms made from it
+//! and freed with the last of them, so what a page invents does not outlive the page.
+use lazy_static::lazy_static;
+use std::borrow::Borrow;
+use std::cmp::Ordering;
+use std::collections::HashSet;
+use std::fmt::{self, Debug, Display, Formatter};
+use std::hash::{Hash, Hasher};
+use std::ops::Deref;
+use std::sync::Arc;
+
+mod known;
+
+lazy_static! {
+    static ref KNOWN: HashSet<&'static str> = known::KNOWN_NAMES.iter().copied().collect();
+}
+
+/// Interned string. See the module documentation.
+#[derive(Clone)]
+pub struct Atom(Repr);
+
+#[derive(Clone)]
+enum Repr {
+    /// An entry of the known-name table.
+    Known(&'static str),
+    /// Any other name; never equal to a known name.
+    Other(Arc<str>),
+}
+
+impl Atom {
+    /// Interns `s` and returns its atom. Only names outside the known-name table allocate.
+    #[must_use]
+    pub fn new(s: &str) -> Self {
+        match KNOWN.get(s) {
+            Some(&known) => Self(Repr::Known(known)),
+            None => Self(Repr::Other(Arc::from(s))),
+        }
+    }
+
+    /// Interns a static string; same as [`Self::new`].
+    #[must_use]
+    pub fn from_static(s: &'static str) -> Self {
+        Self::new(s)
+    }
+
+    /// Returns the interned string
+    #[must_use]
+    pub fn as_str(&self) -> &str {
+        match &self.0 {
+            Repr::Known(s) => s,
+            Repr::Other(s) => s,
+        }
+    }
+
+    /// True when the name is in the known-name table (and so never allocated).
+    #[must_use]
+    pub fn is_known(&self) -> bool {
+        matches!(self.0, Repr::Known(_))
+    }
+}
+
+impl PartialEq for Atom {
+    fn eq(&self, other: &Self) -> bool {
+        match (&self.0, &other.0) {
+            (Repr::Known(a), Repr::Known(b)) => std::ptr::eq(*a, *b),
+            (Repr::Other(a), Repr::Other(b)) => Arc::ptr_eq(a, b) || a == b,
+            _ => false,
+        }
+    }
+}
+
+impl Eq for Atom {}
+
+/// Hashes the string contents (not the pointer), so a `HashMap<Atom, _>` can be queried with a
+/// plain `&str` through `Borrow<str>`.
+impl Hash for Atom {
+    fn hash<H: Hasher>(&self, state: &mut H) {
+        self.as_str().hash(state);
+    }
+}
+
+impl PartialOrd for Atom {
+    fn partial_cmp(&self, other: &Self) -> Option<Ordering> {
+        Some(self.cmp(other))
+    }
+}
+
+impl Ord for Atom {
+    fn cmp(&self, other: &Self) -> Ordering {
+        if self == other {
+            return Ordering::Equal;
+        }
+        self.as_str().cmp(other.as_str())
+    }
+}
+
+impl Deref for Atom {
+    type Target = str;
+
+    fn deref(&self) -> &str {
+        self.as_str()
+    }
+}
+
+impl AsRef<str> for Atom {
+    fn as_ref(&self) -> &str {
+        self.as_str()
+    }
+}
+
+impl Borrow<str> for Atom {
+    fn borrow(&self) -> &str {
+        self.as_str()
+    }
+}
+
+impl From<&str> for Atom {
+    fn from(s: &str) -> Self {
+        Self::new(s)
+    }
+}
+
+impl From<&String> for Atom {
+    fn from(s: &String) -> Self {
+        Self::new(s)
+    }
+}
+
+impl From<String> for Atom {
+    fn from(s: String) -> Self {
+        Self::new(&s)
+    }
+}
+
+impl From<Atom> for String {
+    fn from(atom: Atom) -> Self {
+        atom.as_str().to_string()
+    }
+}
+
+impl PartialEq<str> for Atom {
+    fn eq(&self, other: &str) -> bool {
+        self.as_str() == other
+    }
+}
+
+impl PartialEq<&str> for Atom {
+    fn eq(&self, other: &&str) -> bool {
+        self.as_str() == *other
+    }
+}
+
+impl PartialEq<String> for Atom {
+    fn eq(&self, other: &String) -> bool {
+        self.as_str() == other.as_str()
+    }
+}
+
+impl PartialEq<Atom> for str {
+    fn eq(&self, other: &Atom) -> bool {
+        self == other.as_str()
+    }
+}
+
+impl PartialEq<Atom> for &str {
+    fn eq(&self, other: &Atom) -> bool {
+        *self == other.as_str()
+    }
+}
+
+impl PartialEq<Atom> for String {
+    fn eq(&self, other: &Atom) -> bool {
+        self.as_str() == other.as_str()
+    }
+}
+
+impl Display for Atom {
+    fn fmt(&self, f: &mut Formatter<'_>) -> fmt::Result {
+        Display::fmt(self.as_str(), f)
+    }
+}
+
+impl Debug for Atom {
+    fn fmt(&self, f: &mut Formatter<'_>) -> fmt::Result {
+        Debug::fmt(self.as_str(), f)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::collections::HashMap;
+
+    #[test]
+    fn interned_once() {
+        let a = Atom::new("div");
+        let owned = String::from("div");
+        let b = Atom::from(owned.as_str());
+        assert_eq!(a, b);
+        assert!(std::ptr::eq(a.as_str(), b.as_str()));
+        assert_ne!(a, Atom::new("span"));
+    }
+
+    #[test]
+    fn static_and_dynamic_share_storage() {
+        let s = Atom::from_static("background-color");
+        let d = Atom::new(&String::from("background-color"));
+        assert!(s.is_known());
+        assert_eq!(s, d);
+        assert!(std::ptr::eq(s.as_str(), d.as_str()));
+    }
+
+    #[test]
+    fn unknown_names_are_freed_with_their_atoms() {
+        let a = Atom::new("x-atom-test-element");
+        assert!(!a.is_known());
+        let b = a.clone();
+        assert_eq!(a, b);
+        assert_eq!(a, Atom::new("x-atom-test-element"));
+        assert_ne!(a, Atom::new("div"));
+        let Repr::Other(shared) = &a.0 else {
+            panic!("custom name interned as known");
+        };
+        assert_eq!(Arc::strong_count(shared), 2);
+        drop(b);
+        assert_eq!(Arc::strong_count(shared), 1);
+    }
+
+    #[test]
+    fn compares_with_strings() {
+        let a = Atom::new("color");
+        assert_eq!(a, "color");
+        assert_eq!("color", a);
+        assert_eq!(a, String::from("color"));
+        assert_eq!(a.len(), 5);
+        assert_eq!(format!("{a} {a:?}"), "color \"color\"");
+        assert!(Atom::new("a") < Atom::new("b"));
+    }
+
+    #[test]
+    fn map_lookup_by_str() {
+        let mut map = HashMap::new();
+        map.insert(Atom::new("margin-top"), 1);
+        assert_eq!(map.get("margin-top"), Some(&1));
+        assert_eq!(map.get("margin-left"), None);
+    }
+
+    #[test]
+    fn concurrent_interning() {
+        let handles: Vec<_> = (0..8)
+            .map(|_| std::thread::spawn(|| Atom::new("atom-test-concurrent")))
+            .collect();
+        let atoms: Vec<Atom> = handles.into_iter().filter_map(|h| h.join().ok()).collect();
+        assert_eq!(atoms.len(), 8);
+        assert!(atoms.iter().all(|a| *a == atoms[0]));
+    }
+}
@@ -96,6 +96,9 @@ pub struct Config {
     pub replace_cr_as_lf: bool,
     /// Are high ascii characters read as-is or converted to a replacement character
     pub replace_high_ascii: bool,
+    /// Walk valid UTF-8 input in place instead of pre-decoding it into `Character`s.
+    /// Falls back to the pre-decoded representation for other encodings or invalid input.
+    pub utf8_in_place: bool,
 }
 
 impl Default for Config {
@@ -104,6 +107,7 @@ impl Default for Config {
             cr_lf_as_one: true,
             replace_cr_as_lf: false,
             replace_high_ascii: false,
+            utf8_in_place: true,
         }
     }
 }
@@ -111,10 +115,14 @@ impl Default for Config {
 pub struct ByteStream {
     /// Raw bytes of the source data
     buffer: Vec<u8>,
-    /// Pre-decoded characters (filled by decode_buffer)
+    /// Pre-decoded characters (filled by decode_buffer). Empty in UTF-8 in-place mode.
     chars: Vec<Character>,
-    /// Byte offset of each decoded character in `buffer`
+    /// Byte offset of each decoded character in `buffer`. Empty in UTF-8 in-place mode.
     char_byte_offsets: Vec<usize>,
+    /// When true, `buffer` is known-valid UTF-8 and is read in place: `char_pos` and
+    /// `line_starts` hold byte offsets and `chars`/`char_byte_offsets` stay empty. This
+    /// drops the ~24 bytes per input byte the pre-decoded tables cost.
+    in_place: bool,
     /// First byte of `buffer` not yet turned into a `Character`. Lets `append_str`
     /// resume decoding instead of re-scanning the whole buffer (O(n) total, not O(n^2)).
     decoded_bytes: usize,
@@ -122,12 +130,21 @@ pub struct ByteStream {
     line_starts: Vec<usize>,
     /// Cached index into `line_starts` from the last `location()` call (lookup hint)
     last_line_idx: std::cell::Cell<usize>,
-    /// Number of `chars` already scanned by `extend_line_starts` (incremental watermark)
+    /// (byte position, column) of the last in-place `location()` call. Lets the column be
+    /// counted from there instead of from the start of a (possibly very long) line.
+    last_column: std::cell::Cell<(usize, usize)>,
+    /// Number of `chars` (bytes, in in-place mode) already scanned by `extend_line_starts`
     lines_scanned_chars: usize,
-    /// Current position in the decoded chars array
+    /// Current position in the decoded chars array (byte offset in in-place mode)
     char_pos: usize,
     /// True when the stream is closed (no more data will be added)
     closed: bool,
+    /// Leading bytes of a UTF-8 sequence split across two `append_bytes` calls, kept out of
+    /// `buffer` (which must stay valid UTF-8 in in-place mode) until the rest arrives.
+    held_back: Vec<u8>,
+    /// Set when a read ran into the end of the input while the stream was still open, see
+    /// [`ByteStream::take_starved`].
+    starved: std::cell::Cell<bool>,
     /// Current encoding
     encoding: Encoding,
     /// Configuration for the stream
@@ -183,10 +200,16 @@ impl Default for ByteStream {
 
 impl Stream for ByteStream {
     fn read(&self) -> Character {
+        if self.in_place {
+            return match self.buffer.get(self.char_pos) {
+                Some(_) => Ch(utf8_char_at(&self.buffer, self.char_pos).0),
+                None => self.end_of_input(),
+            };
+        }
         if self.char_pos < self.chars.len() {
             self.chars[self.char_pos]
         } else {
-            StreamEnd
+            self.end_of_input()
         }
     }
 
@@ -195,10 +218,10 @@ impl Stream for ByteStream {
         if matches!(ch, StreamEnd) {
             return ch;
         }
-        self.char_pos += 1;
+        self.step_forward();
 
         if self.config.cr_lf_as_one && ch == Ch(CHAR_CR) && self.read() == Ch(CHAR_LF) {
-            self.char_pos += 1;
+            self.step_forward();
             Ch(CHAR_LF)
         } else if self.config.replace_cr_as_lf && ch == Ch(CHAR_CR) && self.read() != Ch(CHAR_LF) {
             Ch(CHAR_LF)
@@ -208,11 +231,24 @@ impl Stream for ByteStream {
     }
 
     fn look_ahead(&self, offset: usize) -> Character {
+        if self.in_place {
+            let mut pos = self.char_pos;
+            for _ in 0..offset {
+                if pos >= self.buffer.len() {
+                    return self.end_of_input();
+                }
+                pos += utf8_len(self.buffer[pos]);
+            }
+            return match self.buffer.get(pos) {
+                Some(_) => Ch(utf8_char_at(&self.buffer, pos).0),
+                None => self.end_of_input(),
+            };
+        }
         let pos = self.char_pos + offset;
         if pos < self.chars.len() {
             self.chars[pos]
         } else {
-            StreamEnd
+            self.end_of_input()
         }
     }
 
@@ -221,6 +257,15 @@ impl Stream for ByteStream {
     }
 
     fn next_n(&mut self, offset: usize) {
+        if self.in_place {
+            for _ in 0..offset {
+                if self.char_pos >= self.buffer.len() {
+                    break;
+                }
+                self.step_forward();
+            }
+            return;
+        }
         self.char_pos = (self.char_pos + offset).min(self.chars.len());
     }
 
@@ -230,25 +275,34 @@ impl Stream for ByteStream {
 
     fn prev_n(&mut self, n: usize) {
         for _ in 0..n {
-            self.char_pos = self.char_pos.saturating_sub(1);
+            self.step_back();
             // read_and_next() consumes CR+LF as a single step, advancing by 2.
             // Stepping back from after the pair lands on LF; skip the CR too.
-            if self.config.cr_lf_as_one
-                && self.read() == Ch(CHAR_LF)
-                && self.char_pos > 0
-                && self.chars[self.char_pos - 1] == Ch(CHAR_CR)
-            {
+            if self.config.cr_lf_as_one && self.read() == Ch(CHAR_LF) && self.char_pos > 0 && self.prev_is_cr() {
                 self.char_pos -= 1;
             }
         }
     }
 
     fn seek_bytes(&mut self, offset: usize) {
+        if self.in_place {
+            // Land on the first character starting at or after `offset`, like the
+            // partition_point lookup below does for the pre-decoded table.
+            let mut pos = offset.min(self.buffer.len());
+            while pos < self.buffer.len() && is_utf8_continuation(self.buffer[pos]) {
+                pos += 1;
+            }
+            self.char_pos = pos;
+            return;
+        }
         let pos = self.char_byte_offsets.partition_point(|&b| b < offset);
         self.char_pos = pos.min(self.chars.len());
     }
 
     fn tell_bytes(&self) -> usize {
+        if self.in_place {
+            return self.char_pos;
+        }
         self.char_byte_offsets
             .get(self.char_pos)
             .copied()
@@ -278,6 +332,9 @@ impl Stream for ByteStream {
     }
 
     fn exhausted(&self) -> bool {
+        if self.in_place {
+            return self.char_pos >= self.buffer.len();
+        }
         self.char_pos >= self.chars.len()
     }
 
@@ -297,6 +354,26 @@ impl Stream for ByteStream {
             idx += 1;
         }
         self.last_line_idx.set(idx);
+
+        if self.in_place {
+            // Columns count characters, not bytes. Count from the previous call when it
+            // was on the same line and not past us; same amortization as the line index.
+            let line_start = self.line_starts[idx];
+            let (hint_pos, hint_col) = self.last_column.get();
+            let (from, col) = if hint_pos >= line_start && hint_pos <= self.char_pos {
+                (hint_pos, hint_col)
+            } else {
+                (line_start, 1)
+            };
+            let column = col + utf8_count_chars(&self.buffer[from..self.char_pos]);
+            self.last_column.set((self.char_pos, column));
+            return Location {
+                line: idx + 1,
+                column,
+                offset: self.char_pos,
+            };
+        }
+
         Location {
             line: idx + 1,
             column: self.char_pos - self.line_starts[idx] + 1,
@@ -312,8 +389,10 @@ impl Stream for ByteStream {
 impl ByteStream {
     #[must_use]
     pub fn new(encoding: Encoding, config: Option<Config>) -> Self {
+        let config = config.unwrap_or_default();
         Self {
-            config: config.unwrap_or_default(),
+            in_place: config.utf8_in_place && encoding == Encoding::UTF8,
+            config,
             char_pos: 0,
             buffer: Vec::new(),
             chars: Vec::new(),
@@ -321,8 +400,11 @@ impl ByteStream {
             decoded_bytes: 0,
             line_starts: vec![0],
             last_line_idx: std::cell::Cell::new(0),
+            last_column: std::cell::Cell::new((0, 1)),
             lines_scanned_chars: 0,
             closed: false,
+            held_back: Vec::new(),
+            starved: std::cell::Cell::new(false),
             encoding,
         }
     }
@@ -349,6 +431,97 @@ impl ByteStream {
         self.char_pos = mark.char_pos;
     }
 
+    /// `StreamEnd` for a read past the last character, noting when more input may still follow.
+    fn end_of_input(&self) -> Character {
+        if !self.closed {
+            self.starved.set(true);
+        }
+        StreamEnd
+    }
+
+    /// Returns whether a read ran into the end of the input received so far since the last
+    /// call, and clears the flag. A reader that cannot act on partial input (a tokenizer in
+    /// the middle of a token) uses this to back off until more has been appended.
+    pub fn take_starved(&self) -> bool {
+        self.starved.replace(false)
+    }
+
+    /// Number of input bytes received so far that can be read, in the units of
+    /// [`Stream::tell_bytes`]. Bytes of a character still waiting for its last byte are not counted.
+    pub fn received_bytes(&self) -> usize {
+        self.buffer.len()
+    }
+
+    /// Returns true when the buffer is walked in place as UTF-8 (no pre-decoded tables).
+    pub fn is_in_place(&self) -> bool {
+        self.in_place
+    }
+
+    /// Approximate heap memory held by the stream: the raw buffer plus the decode and
+    /// line tables. Used by the bytestream bench to compare the two storage modes.
+    pub fn resident_bytes(&self) -> usize {
+        self.buffer.capacity()
+            + self.chars.capacity() * size_of::<Character>()
+            + self.char_byte_offsets.capacity() * size_of::<usize>()
+            + self.line_starts.capacity() * size_of::<usize>()
+    }
+
+    /// Advance over the longest run of characters starting at the current position whose
+    /// first byte is not in `stops`, and return it. The run may be empty. Returns `None`
+    /// when the stream is not in UTF-8 in-place mode; callers then read per character.
+    ///
+    /// This lets a tokenizer copy a whole text run into its buffer in one go instead of
+    /// pulling it through `read_and_next` one `Character` at a time.
+    pub fn take_run(&mut self, stops: &RunStops) -> Option<&str> {
+        if !self.in_place {
+            return None;
+        }
+        let start = self.char_pos.min(self.buffer.len());
+        let end = start + stops.find(&self.buffer[start..]);
+        self.char_pos = end;
+        // SAFETY: in in-place mode the buffer is valid UTF-8. `start` is a character
+        // boundary, and `end` is either the end of the buffer or a byte that RunStops
+        // accepts as a stop, which is never a continuation byte.
+        #[allow(unsafe_code)]
+        let run = unsafe { std::str::from_utf8_unchecked(&self.buffer[start..end]) };
+        Some(run)
+    }
+
+    /// Advance past the current character (one table entry, or one UTF-8 sequence).
+    fn step_forward(&mut self) {
+        if self.in_place {
+            if let Some(&b) = self.buffer.get(self.char_pos) {
+                self.char_pos += utf8_len(b);
+            }
+        } else {
+            self.char_pos += 1;
+        }
+    }
+
+    /// Step back to the start of the previous character, saturating at 0.
+    fn step_back(&mut self) {
+        if self.in_place {
+            self.char_pos = self.char_pos.min(self.buffer.len());
+            while self.char_pos > 0 {
+                self.char_pos -= 1;
+                if !is_utf8_continuation(self.buffer[self.char_pos]) {
+                    break;
+                }
+            }
+        } else {
+            self.char_pos = self.char_pos.saturating_sub(1);
+        }
+    }
+
+    /// True when the character just before `char_pos` is a CR. Callers ensure char_pos > 0.
+    fn prev_is_cr(&self) -> bool {
+        if self.in_place {
+            self.buffer[self.char_pos - 1] == b'\r'
+        } else {
+            self.chars[self.char_pos - 1] == Ch(CHAR_CR)
+        }
+    }
+
     /// Reset all decode state and decode `self.buffer` from scratch. Used by the
     /// full-load paths (`read_from_str`, `read_from_file`, `set_encoding`).
     fn decode_buffer(&mut self) {
@@ -359,15 +532,49 @@ impl ByteStream {
         self.line_starts.push(0);
         self.lines_scanned_chars = 0;
         self.last_line_idx.set(0);
+        self.last_column.set((0, 1));
+        self.in_place =
+            self.config.utf8_in_place && self.encoding == Encoding::UTF8 && std::str::from_utf8(&self.buffer).is_ok();
+        if self.in_place {
+            // Release the tables of a previous decoded pass; in-place mode never fills them.
+            self.chars.shrink_to_fit();
+            self.char_byte_offsets.shrink_to_fit();
+        }
         self.decode_from(0);
     }
 
+    /// Leave in-place mode because the buffer is no longer valid UTF-8 (only possible
+    /// through the raw-byte paths). Re-decodes into the character table and maps the
+    /// current byte position onto it.
+    fn leave_in_place(&mut self) {
+        let byte_pos = self.char_pos;
+        self.config.utf8_in_place = false;
+        self.decode_buffer();
+        self.reset_stream();
+        self.seek_bytes(byte_pos);
+    }
+
     /// Decode `self.buffer[byte_pos..]`, appending to whatever is already decoded.
     /// `byte_pos` must be a decode boundary (normally `self.decoded_bytes`). Advances
     /// `self.decoded_bytes` past the bytes consumed and extends the line table for the
     /// newly-decoded characters. This makes `append_str` O(new bytes) rather than
     /// re-scanning the whole buffer on every call.
     fn decode_from(&mut self, mut byte_pos: usize) {
+        if self.in_place {
+            // Nothing to decode, only validate the new tail. `append_str` only adds whole
+            // `&str`s, so this fails only when raw bytes were pushed into the buffer.
+            if self
+                .buffer
+                .get(byte_pos..)
+                .is_some_and(|tail| std::str::from_utf8(tail).is_err())
+            {
+                self.leave_in_place();
+                return;
+            }
+            self.decoded_bytes = self.buffer.len();
+            self.extend_line_starts();
+            return;
+        }
         match self.encoding {
             Encoding::Unknown => {
                 byte_pos = self.buffer.len();
@@ -443,6 +650,10 @@ impl ByteStream {
                     } else {
                         None
                     };
+                    if next.is_none() && !self.closed && (0xD800..=0xDBFF).contains(&cu) {
+                        // Its low surrogate may still be appended.
+                        break;
+                    }
                     let (ch, len) = decode_utf16_char(cu, || next);
                     self.char_byte_offsets.push(byte_pos);
                     self.chars.push(ch);
@@ -460,6 +671,10 @@ impl ByteStream {
                     } else {
                         None
                     };
+                    if next.is_none() && !self.closed && (0xD800..=0xDBFF).contains(&cu) {
+                        // Its low surrogate may still be appended.
+                        break;
+                    }
                     let (ch, len) = decode_utf16_char(cu, || next);
                     self.char_byte_offsets.push(byte_pos);
                     self.chars.push(ch);
@@ -475,6 +690,10 @@ impl ByteStream {
     /// call, respecting CR/LF config. `line_starts[n]` is the char_pos of the first
     /// character on line n+1. Only the newly-decoded tail is scanned (incremental).
     fn extend_line_starts(&mut self) {
+        if self.in_place {
+            self.extend_line_starts_in_place();
+            return;
+        }
         let mut i = self.lines_scanned_chars;
         // A CR at the previous boundary was classified without its following character
         // available; re-examine it now that more characters may have arrived. Drop any
@@ -510,8 +729,40 @@ impl ByteStream {
         self.lines_scanned_chars = self.chars.len();
     }
 
+    /// In-place variant of `extend_line_starts`: scans bytes and records byte offsets.
+    /// CR and LF never occur inside a multi-byte UTF-8 sequence, so a byte scan is exact.
+    fn extend_line_starts_in_place(&mut self) {
+        let buf = &self.buffer;
+        let mut i = self.lines_scanned_chars;
+        if i > 0 && buf[i - 1] == b'\r' {
+            i -= 1;
+            while self.line_starts.last().is_some_and(|&v| v > i) {
+                self.line_starts.pop();
+            }
+        }
+        while i < buf.len() {
+            match buf[i] {
+                b'\r' if self.config.cr_lf_as_one && i + 1 < buf.len() && buf[i + 1] == b'\n' => {
+                    self.line_starts.push(i + 2);
+                    i += 2;
+                    continue;
+                }
+                b'\r' if self.config.replace_cr_as_lf && (i + 1 >= buf.len() || buf[i + 1] != b'\n') => {
+                    self.line_starts.push(i + 1);
+                }
+                b'\n' => {
+                    self.line_starts.push(i + 1);
+                }
+                _ => {}
+            }
+            i += 1;
+        }
+        self.lines_scanned_chars = buf.len();
+    }
+
     pub fn read_from_file(&mut self, mut f: impl Read) -> io::Result<()> {
         self.buffer.clear();
+        self.held_back.clear();
         f.read_to_end(&mut self.buffer)?;
         self.close();
         self.decode_buffer();
@@ -521,6 +772,7 @@ impl ByteStream {
 
     pub fn read_from_str(&mut self, s: &str, encoding: Option<Encoding>) {
         self.buffer = Vec::from(s.as_bytes());
+        self.held_back.clear();
         self.closed = false;
         if let Some(enc) = encoding {
             self.encoding = enc;
@@ -536,22 +788,60 @@ impl ByteStream {
         self.decode_from(self.decoded_bytes);
     }
 
+    /// Appends raw, still encoded bytes (e.g. a response body chunk as it arrives) and decodes
+    /// them, resuming where the previous append stopped. A character split across two appends
+    /// is decoded once its last byte has arrived.
+    pub fn append_bytes(&mut self, bytes: &[u8]) {
+        if !self.in_place {
+            self.buffer.extend_from_slice(bytes);
+            self.decode_from(self.decoded_bytes);
+            return;
+        }
+        let start = self.buffer.len();
+        self.buffer.append(&mut self.held_back);
+        self.buffer.extend_from_slice(bytes);
+        let split = self.buffer.len() - utf8_incomplete_tail(&self.buffer[start..]);
+        self.held_back.extend_from_slice(&self.buffer[split..]);
+        self.buffer.truncate(split);
+        self.decode_from(start);
+        if !self.in_place {
+            // Invalid input dropped the stream out of in-place mode, which decodes split
+            // sequences itself.
+            self.flush_held_back();
+        }
+    }
+
+    /// Moves held-back bytes into the buffer and decodes them.
+    fn flush_held_back(&mut self) {
+        if self.held_back.is_empty() {
+            return;
+        }
+        self.buffer.append(&mut self.held_back);
+        self.decode_from(self.decoded_bytes);
+    }
+
     pub fn close(&mut self) {
         self.closed = true;
         // Resume from the trailing incomplete sequence (if any) so it resolves to a
         // replacement character. O(tail), not a full re-decode.
+        self.flush_held_back();
         self.decode_from(self.decoded_bytes);
     }
 
     pub fn read_from_bytes(&mut self, bytes: &[u8]) -> io::Result<()> {
         self.buffer = bytes.to_vec();
-        self.close();
+        self.held_back.clear();
+        self.closed = true;
+        self.decode_buffer();
         self.reset_stream();
         Ok(())
     }
 
     #[cfg(test)]
     fn chars_left(&self) -> usize {
+        if self.in_place {
+            return utf8_count_chars(&self.buffer[self.char_pos..]);
+        }
         self.chars.len() - self.char_pos
     }
 }
@@ -599,12 +889,11 @@ impl ByteStream {
         }
         let current_byte_offset = self.tell_bytes();
         self.encoding = e;
+        self.buffer.append(&mut self.held_back);
         self.decode_buffer();
         // Remap char_pos to the same byte offset in the newly-decoded buffer
-        let new_pos = self.char_byte_offsets.partition_point(|&b| b < current_byte_offset);
-        // self.char_pos = new_pos.min(self.chars.len());
         self.reset_stream();
-        self.next_n(new_pos);
+        self.seek_bytes(current_byte_offset);
     }
 }
 
@@ -646,6 +935,163 @@ impl Debug for Location {
     }
 }
 
+/// Set of bytes that end a run scanned by [`ByteStream::take_run`].
+///
+/// Scanning tests eight bytes per step (SWAR) and only falls back to the per-byte table
+/// for words that may hold a stop: a control byte, a non-ASCII byte or one of up to four
+/// printable ASCII stops.
+pub struct RunStops {
+    /// Exact stop table, indexed by byte
+    table: [bool; 256],
+    /// Printable ASCII stops, tested word-at-a-time
+    printable: [u8; 4],
+    /// Number of used entries in `printable`
+    printable_len: usize,
+    /// More than four printable stops: skip the word test and use the table only
+    overflow: bool,
+}
+
+impl RunStops {
+    const LO: u64 = 0x0101_0101_0101_0101;
+    const HI: u64 = 0x8080_8080_8080_8080;
+
+    /// Creates a stop set from the given bytes. CR always ends a run, since its meaning
+    /// depends on the stream's CR/LF config. UTF-8 continuation bytes are ignored, so a
+    /// run always ends on a character boundary.
+    #[must_use]
+    pub const fn new(stops: &[u8]) -> Self {
+        let mut set = Self {
+            table: [false; 256],
+            printable: [0; 4],
+            printable_len: 0,
+            overflow: false,
+        }
+        .with(b'\r');
+        let mut i = 0;
+        while i < stops.len() {
+            set = set.with(stops[i]);
+            i += 1;
+        }
+        set
+    }
+
+    /// Adds all bytes in `lo..=hi` to the stop set.
+    #[must_use]
+    pub const fn with_range(mut self, lo: u8, hi: u8) -> Self {
+        let mut b = lo;
+        while b <= hi {
+            self = self.with(b);
+            if b == u8::MAX {
+                break;
+            }
+            b += 1;
+        }
+        self
+    }
+
+    const fn with(mut self, b: u8) -> Self {
+        if is_utf8_continuation(b) || self.table[b as usize] {
+            return self;
+        }
+        self.table[b as usize] = true;
+        if matches!(b, 0x20..=0x7F) {
+            if self.printable_len < self.printable.len() {
+                self.printable[self.printable_len] = b;
+                self.printable_len += 1;
+            } else {
+                self.overflow = true;
+            }
+        }
+        self
+    }
+
+    /// True when `word` may contain a stop byte (false positives are allowed).
+    #[inline]
+    fn may_stop(&self, word: u64) -> bool {
+        // Bytes below 0x20 or with the high bit set.
+        let mut hit = (word.wrapping_sub(0x20 * Self::LO) | word) & Self::HI;
+        for &b in &self.printable[..self.printable_len] {
+            let x = word ^ (u64::from(b) * Self::LO);
+            hit |= x.wrapping_sub(Self::LO) & !x & Self::HI;
+        }
+        hit != 0
+    }
+
+    /// Index of the first stop byte in `bytes`, or `bytes.len()` when there is none.
+    #[inline]
+    fn find(&self, bytes: &[u8]) -> usize {
+        let mut pos = 0;
+        for chunk in bytes.chunks_exact(8) {
+            let mut word = [0u8; 8];
+            word.copy_from_slice(chunk);
+            if self.overflow || self.may_stop(u64::from_le_bytes(word)) {
+                if let Some(i) = chunk.iter().position(|&b| self.table[b as usize]) {
+                    return pos + i;
+                }
+            }
+            pos += 8;
+        }
+        bytes[pos..]
+            .iter()
+            .position(|&b| self.table[b as usize])
+            .map_or(bytes.len(), |i| pos + i)
+    }
+}
+
+/// Returns true for a UTF-8 continuation byte (`10xxxxxx`).
+#[inline]
+const fn is_utf8_continuation(b: u8) -> bool {
+    (b & 0xC0) == 0x80
+}
+
+/// Length of the UTF-8 sequence starting with lead byte `b`.
+#[inline]
+fn utf8_len(b: u8) -> usize {
+    match b {
+        0xF0.. => 4,
+        0xE0.. => 3,
+        0xC0.. => 2,
+        _ => 1,
+    }
+}
+
+/// Decode the UTF-8 sequence starting at `pos`. The buffer has been validated, so this
+/// only reassembles the code point; a truncated sequence maps to the replacement char.
+#[inline]
+fn utf8_char_at(buf: &[u8], pos: usize) -> (char, usize) {
+    let lead = buf[pos];
+    if lead < 0x80 {
+        return (lead as char, 1);
+    }
+    let len = utf8_len(lead);
+    let mut cp = u32::from(lead & (0x7F >> len));
+    for i in 1..len {
+        match buf.get(pos + i) {
+            Some(&b) => cp = (cp << 6) | u32::from(b & 0x3F),
+            None => return (REPLACEMENT_CHARACTER, len),
+        }
+    }
+    (char::from_u32(cp).unwrap_or(REPLACEMENT_CHARACTER), len)
+}
+
+/// Length of the UTF-8 sequence cut off at the end of `bytes`; 0 when `bytes` ends on a
+/// character boundary.
+fn utf8_incomplete_tail(bytes: &[u8]) -> usize {
+    for back in 1..=bytes.len().min(3) {
+        let b = bytes[bytes.len() - back];
+        if !is_utf8_continuation(b) {
+            return if b >= 0xC0 && utf8_len(b) > back { back } else { 0 };
+        }
+    }
+    0
+}
+
+/// Number of characters in a valid UTF-8 byte slice.
+#[inline]
+fn utf8_count_chars(bytes: &[u8]) -> usize {
+    bytes.iter().filter(|&&b| !is_utf8_continuation(b)).count()
+}
+
 /// Decode one UTF-16 code unit, calling `next_cu` to fetch the following code unit when a
 /// surrogate pair is encountered. Returns `(Character, bytes_consumed)`.
 fn decode_utf16_char(cu: u16, next_cu: impl FnOnce() -> Option<u16>) -> (Character, usize) {
@@ -805,6 +1251,7 @@ mod test {
                 cr_lf_as_one: false,
                 replace_cr_as_lf: true,
                 replace_high_ascii: false,
+                utf8_in_place: true,
             }),
         );
         stream.read_from_str("a\rb\r\nc", Some(Encoding::UTF8));
@@ -895,6 +1342,7 @@ mod test {
                 cr_lf_as_one: false,
                 replace_cr_as_lf: false,
                 replace_high_ascii: false,
+                utf8_in_place: true,
             }),
         );
         stream.read_from_bytes(&[0x41, 0xE9, 0xFC]).unwrap(); // A, é, ü
@@ -911,6 +1359,7 @@ mod test {
                 cr_lf_as_one: false,
                 replace_cr_as_lf: false,
                 replace_high_ascii: true,
+                utf8_in_place: true,
             }),
         );
         stream.read_from_bytes(&[0x41, 0xE9, 0x42]).unwrap(); // A, é (replaced), B
@@ -960,6 +1409,7 @@ mod test {
                 cr_lf_as_one: true,
                 replace_cr_as_lf: false,
                 replace_high_ascii: true,
+                utf8_in_place: true,
             }),
         );
         assert!(stream.exhausted());
@@ -1133,6 +1583,196 @@ mod test {
         }
     }
 
+    #[test]
+    fn append_bytes_joins_characters_split_across_chunks() {
+        let text = "a\r\nb_é_😀_\u{2603}";
+        for in_place in [true, false] {
+            let config = Config {
+                utf8_in_place: in_place,
+                ..Config::default()
+            };
+            let mut stream = ByteStream::new(Encoding::UTF8, Some(config));
+            for byte in text.as_bytes() {
+                stream.append_bytes(std::slice::from_ref(byte));
+            }
+            stream.close();
+            assert_eq!(stream.is_in_place(), in_place);
+
+            let mut decoded = String::new();
+            while let Ch(c) = stream.read_and_next() {
+                decoded.push(c);
+            }
+            assert_eq!(decoded, text.replace("\r\n", "\n"));
+        }
+
+        // A sequence still cut off at close decodes to a replacement character.
+        let mut stream = ByteStream::new(Encoding::UTF8, None);
+        stream.append_bytes(b"a\xE2\x98");
+        stream.close();
+        assert_eq!(stream.read_and_next(), Ch('a'));
+        assert_eq!(stream.read_and_next(), Ch(REPLACEMENT_CHARACTER));
+    }
+
+    #[test]
+    fn reads_past_the_input_of_an_open_stream_starve() {
+        let mut stream = ByteStream::new(Encoding::UTF8, None);
+        stream.append_bytes(b"ab");
+        assert_eq!(stream.look_ahead(1), Ch('b'));
+        assert!(!stream.take_starved());
+        assert_eq!(stream.look_ahead(2), StreamEnd);
+        assert!(stream.take_starved());
+        assert!(!stream.take_starved(), "taking clears the flag");
+
+        stream.close();
+        assert_eq!(stream.look_ahead(2), StreamEnd);
+        assert!(!stream.take_starved(), "a closed stream has simply ended");
+    }
+
+    fn decoded_config() -> Config {
+        Config {
+            utf8_in_place: false,
+            ..Config::default()
+        }
+    }
+
+    #[test]
+    fn in_place_matches_decoded() {
+        // The in-place UTF-8 walk must be indistinguishable from the pre-decoded table:
+        // same characters, look-ahead, locations, and prev/seek behaviour.
+        let text = "a\r\nb\nc\rd\r\n\r\ne_é_😀_f\ng\r\n\u{2603}x";
+
+        let mut decoded = ByteStream::new(Encoding::UTF8, Some(decoded_config()));
+        decoded.read_from_str(text, None);
+        decoded.close();
+        let mut in_place = ByteStream::from_str(text, Encoding::UTF8);
+        assert!(in_place.is_in_place());
+        assert!(!decoded.is_in_place());
+
+        loop {
+            assert_eq!(decoded.read(), in_place.read());
+            assert_eq!(decoded.look_ahead(2), in_place.look_ahead(2));
+            assert_eq!(decoded.location(), in_place.location());
+            assert_eq!(decoded.location().offset, in_place.location().offset);
+            assert_eq!(decoded.tell_bytes(), in_place.tell_bytes());
+            if decoded.eof() {
+                assert!(in_place.eof());
+                break;
+            }
+            assert_eq!(decoded.read_and_next(), in_place.read_and_next());
+        }
+
+        for n in 0..text.chars().count() {
+            decoded.prev_n(n);
+            in_place.prev_n(n);
+            assert_eq!(decoded.read(), in_place.read(), "prev_n({n})");
+            assert_eq!(decoded.location(), in_place.location(), "prev_n({n})");
+            decoded.next_n(n / 2);
+            in_place.next_n(n / 2);
+            assert_eq!(decoded.read(), in_place.read(), "next_n({})", n / 2);
+        }
+
+        for b in 0..=text.len() + 1 {
+            decoded.seek_bytes(b);
+            in_place.seek_bytes(b);
+            assert_eq!(decoded.tell_bytes(), in_place.tell_bytes(), "seek_bytes({b})");
+            assert_eq!(decoded.read(), in_place.read(), "seek_bytes({b})");
+        }
+    }
+
+    #[test]
+    fn in_place_mark_reset_and_append() {
+        let mut stream = ByteStream::new(Encoding::UTF8, None);
+        stream.append_str("ab😀");
+        assert!(stream.is_in_place());
+        stream.next_n(2);
+        let mark = stream.mark();
+        assert_eq!(stream.read_and_next(), Ch('😀'));
+        assert!(stream.exhausted());
+        assert!(!stream.eof());
+        stream.append_str("\ncd");
+        assert_eq!(stream.read_and_next(), Ch('\n'));
+        assert_eq!(stream.location(), Location::new(2, 1, 7));
+        stream.reset_to_mark(mark);
+        assert_eq!(stream.read_and_next(), Ch('😀'));
+        stream.close();
+        assert_eq!(Character::slice_to_string(stream.get_slice(10)), "\ncd\0\0\0\0\0\0\0");
+    }
+
+    #[test]
+    fn in_place_falls_back_on_invalid_utf8() {
+        let mut stream = ByteStream::new(Encoding::UTF8, None);
+        stream.read_from_bytes(b"a\xFFb").unwrap();
+        assert!(!stream.is_in_place());
+        assert_eq!(stream.read_and_next(), Ch('a'));
+        assert_eq!(stream.read_and_next(), Ch(REPLACEMENT_CHARACTER));
+        assert_eq!(stream.read_and_next(), Ch('b'));
+    }
+
+    #[test]
+    fn in_place_uses_less_memory() {
+        let text = "<p>Hëllo wörld</p>\n".repeat(1000);
+        let in_place = ByteStream::from_str(&text, Encoding::UTF8);
+        let mut decoded = ByteStream::new(Encoding::UTF8, Some(decoded_config()));
+        decoded.read_from_str(&text, None);
+        // Raw buffer plus the line table only.
+        assert!(in_place.resident_bytes() < text.len() * 2);
+        assert!(decoded.resident_bytes() > text.len() * 10);
+    }
+
+    #[test]
+    fn take_run_stops_at_special_bytes() {
+        const STOPS: RunStops = RunStops::new(b"<&");
+        let text = "plain text with ümlauts and a long enough tail<b>x&amp;\r\ny";
+        let mut stream = ByteStream::from_str(text, Encoding::UTF8);
+
+        let run = stream.take_run(&STOPS).map(str::to_owned);
+        assert_eq!(run.as_deref(), Some("plain text with ümlauts and a long enough tail"));
+        assert_eq!(stream.read_and_next(), Ch('<'));
+        assert_eq!(stream.take_run(&STOPS), Some("b>x"));
+        assert_eq!(stream.read_and_next(), Ch('&'));
+        // CR always stops a run so CR/LF folding stays with read_and_next.
+        assert_eq!(stream.take_run(&STOPS), Some("amp;"));
+        assert_eq!(stream.read_and_next(), Ch('\n'));
+        assert_eq!(stream.take_run(&STOPS), Some("y"));
+        assert_eq!(stream.take_run(&STOPS), Some(""));
+        assert!(stream.eof());
+        assert_eq!(stream.location(), Location::new(2, 2, text.len()));
+    }
+
+    #[test]
+    fn take_run_matches_table_scan() {
+        // Word-at-a-time prefilter must agree with a plain per-byte scan, including
+        // non-ASCII stops and more printable stops than fit the word test.
+        let sets = [
+            RunStops::new(b"<&\0"),
+            RunStops::new(b"\"&").with_range(0xC2, 0xC2),
+            RunStops::new(b"abcdef"),
+        ];
+        let text = "0123456789<abcdef\u{0}\u{85}ghij&\"klmnopqrstuvwxyz é\u{1F600}-";
+        for stops in &sets {
+            for start in 0..text.len() {
+                if !text.is_char_boundary(start) {
+                    continue;
+                }
+                let bytes = &text.as_bytes()[start..];
+                let expected = bytes
+                    .iter()
+                    .position(|&b| stops.table[b as usize])
+                    .unwrap_or(bytes.len());
+                assert_eq!(stops.find(bytes), expected, "start {start}");
+            }
+        }
+    }
+
+    #[test]
+    fn take_run_not_in_place() {
+        const STOPS: RunStops = RunStops::new(b"<");
+        let mut stream = ByteStream::new(Encoding::UTF8, Some(decoded_config()));
+        stream.read_from_str("abc", None);
+        assert_eq!(stream.take_run(&STOPS), None);
+        assert_eq!(stream.read(), Ch('a'));
+    }
+
     #[test]
     fn advance() {
         let mut stream = ByteStream::new(Encoding::UTF8, None);
@@ -1162,6 +1802,7 @@ mod test {
                 cr_lf_as_one: true,
                 replace_cr_as_lf: false,
                 replace_high_ascii: true,
+                utf8_in_place: true,
             }),
         );
         stream.read_from_str("a👽b", Some(Encoding::UTF8));
@@ -1187,6 +1828,7 @@ mod test {
                 cr_lf_as_one: true,
                 replace_cr_as_lf: false,
                 replace_high_ascii: true,
+                utf8_in_place: true,
             }),
         );
         stream.read_from_str("a👽b", Some(Encoding::UTF8));
@@ -1238,6 +1880,7 @@ mod test {
                 cr_lf_as_one: true,
                 replace_cr_as_lf: false,
                 replace_high_ascii: false,
+                utf8_in_place: true,
             }),
         );
 
@@ -1290,6 +1933,7 @@ mod test {
                 cr_lf_as_one: true,
                 replace_cr_as_lf: false,
                 replace_high_ascii: false,
+                utf8_in_place: true,
             }),
         );
         stream.read_from_str("a\r\nb\nc\r\nd\r\r\n\ne", Some(Encoding::UTF8));
@@ -1339,6 +1983,7 @@ mod test {
                 cr_lf_as_one: true,
                 replace_cr_as_lf: false,
                 replace_high_ascii: false,
+                utf8_in_place: true,
             }),
         );
         stream.read_from_str("a\r\nb", Some(Encoding::UTF8));
@@ -1,6 +1,18 @@
-use parking_lot::Mutex;
-use std::collections::HashMap;
-use std::fmt::{Display, Formatter};
+//! Timing spans and event counters.
+//!
+//! [`timing_start!`](crate::timing_start) / [`timing_stop!`](crate::timing_stop) and
+//! [`timing_guard!`](crate::timing_guard) record a span: a label id, a start and an end time.
+//! Each call site interns its label once. Every thread appends its spans to its own ring buffer
+//! and bumps its own per-label histogram, so recording a span takes no lock and allocates nothing
+//! unless it carries a context string. Readers aggregate across threads on demand:
+//! [`snapshot_histograms`] and [`snapshot_stats`] for the metrics endpoint, [`chrome_trace`] for
+//! `chrome://tracing` / Perfetto, and [`print_timings`] for the console.
+
+use parking_lot::{Mutex, RwLock};
+use std::collections::{BTreeMap, HashMap, VecDeque};
+use std::fmt::Write as _;
+use std::sync::atomic::{fence, AtomicU64, Ordering};
+use std::sync::{Arc, Once, OnceLock};
 #[cfg(not(target_arch = "wasm32"))]
 use std::time::Instant;
 
@@ -8,11 +20,24 @@ use lazy_static::lazy_static;
 #[cfg(target_arch = "wasm32")]
 use web_sys::window;
 
-type TimerId = uuid::Uuid;
+/// Spans each thread keeps for [`chrome_trace`]; older ones are overwritten.
+pub const RING_CAPACITY: usize = 4096;
 
-fn new_timer_id() -> TimerId {
-    uuid::Uuid::new_v4()
-}
+/// Labels that get a histogram. Spans of labels interned beyond this still reach the trace.
+pub const MAX_LABELS: usize = 512;
+
+/// Exited threads whose spans stay in the trace. The histograms of older ones are folded
+/// together, so their counts are kept.
+const RETIRED_THREADS: usize = 8;
+
+/// Spans with a context string kept for [`print_timings`] details and the trace.
+const DETAIL_CAPACITY: usize = 4096;
+
+/// Durations above this (about 18 minutes) land in the last histogram bucket.
+const MAX_TRACKED_NS: u64 = (1 << 40) - 1;
+
+/// Four buckets per power of two: at most 25% wide.
+const BUCKETS: usize = bucket_index(MAX_TRACKED_NS) + 1;
 
 #[derive(Debug, Clone)]
 pub enum Scale {
@@ -22,38 +47,9 @@ pub enum Scale {
     Auto,
 }
 
-#[derive(Debug, Default, Clone, PartialEq, Eq, PartialOrd, Ord)]
-#[allow(dead_code)]
-struct Duration {
-    duration: u64,
-    suffix: String,
-}
-
-impl Display for Duration {
-    fn fmt(&self, f: &mut Formatter<'_>) -> std::fmt::Result {
-        write!(f, "{}{}", self.duration, self.suffix)
-    }
-}
-
-#[derive(Default, Debug, Clone)]
-pub struct TimingTable {
-    timers: HashMap<TimerId, Timer>,
-    namespaces: HashMap<String, Vec<TimerId>>,
-}
-
-pub struct Stats {
-    count: u64,
-    total: u64,
-    min: u64,
-    max: u64,
-    avg: u64,
-    p50: u64,
-    p75: u64,
-    p95: u64,
-    p99: u64,
-}
-
 /// Aggregated timing statistics for a single namespace, suitable for external consumption.
+///
+/// Percentiles come from the namespace's histogram, see [`HistogramSnapshot::percentile`].
 #[derive(Debug, Clone)]
 pub struct NamespaceStats {
     pub namespace: String,
@@ -68,185 +64,696 @@ pub struct NamespaceStats {
     pub p99_us: u64,
 }
 
+/// Duration histogram of one namespace, summed over all threads.
+#[derive(Debug, Clone)]
+pub struct HistogramSnapshot {
+    pub namespace: String,
+    pub count: u64,
+    pub total_ns: u64,
+    pub min_ns: u64,
+    pub max_ns: u64,
+    /// Non-empty buckets as `(lower, upper, count)`; a bucket holds durations in `lower..upper`
+    /// nanoseconds.
+    pub buckets: Vec<(u64, u64, u64)>,
+}
+
+impl HistogramSnapshot {
+    /// The `p` (0.0 to 1.0) percentile in nanoseconds: the middle of the bucket holding it,
+    /// clamped to the recorded minimum and maximum.
+    #[must_use]
+    pub fn percentile(&self, p: f64) -> u64 {
+        let rank = percentage_to_index(self.count, p) as u64;
+        let mut seen = 0;
+        for &(lower, upper, count) in &self.buckets {
+            seen += count;
+            if seen > rank {
+                return (lower + (upper - lower) / 2).clamp(self.min_ns, self.max_ns);
+            }
+        }
+        self.max_ns
+    }
+
+    #[must_use]
+    pub fn stats(&self) -> NamespaceStats {
+        NamespaceStats {
+            namespace: self.namespace.clone(),
+            count: self.count,
+            total_us: self.total_ns / 1000,
+            min_us: self.min_ns / 1000,
+            max_us: self.max_ns / 1000,
+            avg_us: self.total_ns.checked_div(self.count).unwrap_or(0) / 1000,
+            p50_us: self.percentile(0.50) / 1000,
+            p75_us: self.percentile(0.75) / 1000,
+            p95_us: self.percentile(0.95) / 1000,
+            p99_us: self.percentile(0.99) / 1000,
+        }
+    }
+}
+
+/// A recorded span, as returned by [`recent_spans`].
+#[derive(Debug, Clone)]
+pub struct SpanRecord {
+    pub namespace: &'static str,
+    /// Engine-assigned number of the recording thread, see [`thread_names`].
+    pub thread: u64,
+    /// Nanoseconds on the process's monotonic timing clock.
+    pub start_ns: u64,
+    pub end_ns: u64,
+    pub context: Option<String>,
+}
+
 fn percentage_to_index(count: u64, percentage: f64) -> usize {
     ((count as f64 * percentage) as usize).min(count.saturating_sub(1) as usize)
 }
 
-impl TimingTable {
+const fn bucket_index(ns: u64) -> usize {
+    let ns = if ns > MAX_TRACKED_NS { MAX_TRACKED_NS } else { ns };
+    if ns < 4 {
+        return ns as usize;
+    }
+    let exp = (63 - ns.leading_zeros()) as usize;
+    4 * (exp - 1) + ((ns >> (exp - 2)) & 3) as usize
+}
+
+/// `lower..upper` nanoseconds of bucket `index`.
+fn bucket_bounds(index: usize) -> (u64, u64) {
+    if index < 4 {
+        return (index as u64, index as u64 + 1);
+    }
+    let shift = index / 4 - 1;
+    let lower = (4 + (index % 4) as u64) << shift;
+    (lower, lower + (1 << shift))
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+fn now_ns() -> u64 {
+    static EPOCH: OnceLock<Instant> = OnceLock::new();
+    EPOCH.get_or_init(Instant::now).elapsed().as_nanos() as u64
+}
+
+#[cfg(target_arch = "wasm32")]
+fn now_ns() -> u64 {
+    window()
+        .and_then(|w| w.performance())
+        .map(|p| (p.now() * 1_000_000.0) as u64)
+        .unwrap_or(0)
+}
+
+/// Interned timer namespace.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct LabelId(u32);
+
+#[derive(Default)]
+struct Labels {
+    names: Vec<&'static str>,
+    ids: HashMap<&'static str, LabelId>,
+}
+
+impl LabelId {
+    /// Interns `name`. Labels live for the rest of the process, so keep variable parts (URLs,
+    /// ids) in the context instead.
+    pub fn intern(name: &str) -> Self {
+        if let Some(id) = LABELS.read().ids.get(name) {
+            return *id;
+        }
+        let mut labels = LABELS.write();
+        if let Some(id) = labels.ids.get(name) {
+            return *id;
+        }
+        let name: &'static str = Box::leak(name.to_string().into_boxed_str());
+        let id = LabelId(labels.names.len() as u32);
+        labels.names.push(name);
+        labels.ids.insert(name, id);
+        id
+    }
+
     #[must_use]
-    pub fn new() -> TimingTable {
-        TimingTable {
-            timers: HashMap::new(),
-            namespaces: HashMap::new(),
+    pub fn name(self) -> &'static str {
+        LABELS.read().names.get(self.0 as usize).copied().unwrap_or_default()
+    }
+}
+
+/// Per-call-site cache of a [`LabelId`], declared by the timing macros.
+#[derive(Default)]
+pub struct Label {
+    cached: OnceLock<(&'static str, LabelId)>,
+}
+
+impl Label {
+    #[must_use]
+    pub const fn new() -> Self {
+        Self {
+            cached: OnceLock::new(),
+        }
+    }
+
+    /// The id of `name`. Only the first call interns, unless the call site passes a
+    /// different name later on.
+    pub fn id(&self, name: &str) -> LabelId {
+        let (cached, id) = *self.cached.get_or_init(|| {
+            let id = LabelId::intern(name);
+            (id.name(), id)
+        });
+        if cached == name {
+            id
+        } else {
+            LabelId::intern(name)
         }
     }
+}
 
-    pub fn start_timer(&mut self, namespace: &str, context: Option<String>) -> TimerId {
-        let timer = Timer::new(context);
-        self.timers.insert(timer.id, timer.clone());
-        self.namespaces.entry(namespace.to_string()).or_default().push(timer.id);
+struct Histogram {
+    count: AtomicU64,
+    total: AtomicU64,
+    min: AtomicU64,
+    max: AtomicU64,
+    buckets: [AtomicU64; BUCKETS],
+}
 
-        timer.id
+impl Histogram {
+    fn new() -> Self {
+        Self {
+            count: AtomicU64::new(0),
+            total: AtomicU64::new(0),
+            min: AtomicU64::new(u64::MAX),
+            max: AtomicU64::new(0),
+            buckets: std::array::from_fn(|_| AtomicU64::new(0)),
+        }
+    }
+
+    fn record(&self, ns: u64) {
+        self.count.fetch_add(1, Ordering::Relaxed);
+        self.total.fetch_add(ns, Ordering::Relaxed);
+        self.min.fetch_min(ns, Ordering::Relaxed);
+        self.max.fetch_max(ns, Ordering::Relaxed);
+        self.buckets[bucket_index(ns)].fetch_add(1, Ordering::Relaxed);
     }
 
-    pub fn stop_timer(&mut self, timer_id: TimerId) {
-        if let Some(timer) = self.timers.get_mut(&timer_id) {
-            timer.end();
+    fn reset(&self) {
+        self.count.store(0, Ordering::Relaxed);
+        self.total.store(0, Ordering::Relaxed);
+        self.min.store(u64::MAX, Ordering::Relaxed);
+        self.max.store(0, Ordering::Relaxed);
+        for bucket in &self.buckets {
+            bucket.store(0, Ordering::Relaxed);
         }
     }
 
-    #[must_use]
-    pub fn get_stats(&self, timers: &Vec<TimerId>) -> Stats {
-        let mut durations: Vec<u64> = Vec::new();
+    fn add_to(&self, sum: &mut HistogramSum) {
+        sum.count += self.count.load(Ordering::Relaxed);
+        sum.total += self.total.load(Ordering::Relaxed);
+        sum.min = sum.min.min(self.min.load(Ordering::Relaxed));
+        sum.max = sum.max.max(self.max.load(Ordering::Relaxed));
+        for (into, bucket) in sum.buckets.iter_mut().zip(&self.buckets) {
+            *into += bucket.load(Ordering::Relaxed);
+        }
+    }
+}
+
+#[derive(Clone)]
+struct HistogramSum {
+    count: u64,
+    total: u64,
+    min: u64,
+    max: u64,
+    buckets: [u64; BUCKETS],
+}
+
+impl Default for HistogramSum {
+    fn default() -> Self {
+        Self {
+            count: 0,
+            total: 0,
+            min: u64::MAX,
+            max: 0,
+            buckets: [0; BUCKETS],
+        }
+    }
+}
+
+/// One ring buffer entry, guarded by a sequence number: odd while the owning thread writes it,
+/// `2 * index + 2` once span `index` is complete.
+#[derive(Default)]
+struct Slot {
+    seq: AtomicU64,
+    label: AtomicU64,
+    start: AtomicU64,
+    end: AtomicU64,
+}
+
+/// The spans and histograms of one thread. Only that thread writes them.
+struct ThreadTimings {
+    tid: u64,
+    name: String,
+    /// Number of spans ever written to `ring`.
+    head: AtomicU64,
+    ring: Box<[Slot]>,
+    histograms: Box<[OnceLock<Box<Histogram>>]>,
+}
+
+impl ThreadTimings {
+    fn new(tid: u64, name: String) -> Self {
+        Self {
+            tid,
+            name,
+            head: AtomicU64::new(0),
+            ring: (0..RING_CAPACITY).map(|_| Slot::default()).collect(),
+            histograms: (0..MAX_LABELS).map(|_| OnceLock::new()).collect(),
+        }
+    }
+
+    fn record(&self, label: LabelId, start: u64, end: u64, to_ring: bool) {
+        if let Some(histogram) = self.histograms.get(label.0 as usize) {
+            histogram
+                .get_or_init(|| Box::new(Histogram::new()))
+                .record(end.saturating_sub(start));
+        }
+        if !to_ring {
+            return;
+        }
+        let index = self.head.load(Ordering::Relaxed);
+        let slot = &self.ring[index as usize % RING_CAPACITY];
+        slot.seq.store(2 * index + 1, Ordering::Relaxed);
+        fence(Ordering::Release);
+        slot.label.store(u64::from(label.0), Ordering::Relaxed);
+        slot.start.store(start, Ordering::Relaxed);
+        slot.end.store(end, Ordering::Relaxed);
+        slot.seq.store(2 * index + 2, Ordering::Release);
+        self.head.store(index + 1, Ordering::Release);
+    }
+
+    /// Appends the spans still in the ring that started at or after `since`, skipping any the
+    /// owning thread overwrites while they are read.
+    fn spans(&self, since: u64, names: &[&'static str], out: &mut Vec<SpanRecord>) {
+        let head = self.head.load(Ordering::Acquire);
+        for index in head.saturating_sub(RING_CAPACITY as u64)..head {
+            let slot = &self.ring[index as usize % RING_CAPACITY];
+            let seq = slot.seq.load(Ordering::Acquire);
+            if seq != 2 * index + 2 {
+                continue;
+            }
+            let label = slot.label.load(Ordering::Relaxed);
+            let start_ns = slot.start.load(Ordering::Relaxed);
+            let end_ns = slot.end.load(Ordering::Relaxed);
+            fence(Ordering::Acquire);
+            if slot.seq.load(Ordering::Relaxed) != seq || start_ns < since {
+                continue;
+            }
+            out.push(SpanRecord {
+                namespace: names.get(label as usize).copied().unwrap_or_default(),
+                thread: self.tid,
+                start_ns,
+                end_ns,
+                context: None,
+            });
+        }
+    }
+}
 
-        for timer_id in timers {
-            if let Some(timer) = self.timers.get(timer_id) {
-                if !timer.has_finished() {
+#[derive(Default)]
+struct Threads {
+    next_tid: u64,
+    live: Vec<Arc<ThreadTimings>>,
+    retired: VecDeque<Arc<ThreadTimings>>,
+    /// Histograms of threads dropped from `retired`, indexed by label.
+    folded: Vec<HistogramSum>,
+}
+
+impl Threads {
+    fn all(&self) -> impl Iterator<Item = &Arc<ThreadTimings>> {
+        self.live.iter().chain(self.retired.iter())
+    }
+}
+
+struct Detail {
+    label: LabelId,
+    thread: u64,
+    start: u64,
+    end: u64,
+    context: String,
+}
+
+lazy_static! {
+    static ref LABELS: RwLock<Labels> = RwLock::new(Labels::default());
+    static ref THREADS: Mutex<Threads> = Mutex::new(Threads::default());
+    static ref DETAILS: Mutex<VecDeque<Detail>> = Mutex::new(VecDeque::new());
+    static ref COUNTERS: Mutex<Vec<&'static Counter>> = Mutex::new(Vec::new());
+}
+
+/// Spans starting before this are left out of [`recent_spans`]; set by [`reset_stats`].
+static RESET_AT: AtomicU64 = AtomicU64::new(0);
+
+/// Registers the thread's timings on first use and retires them when the thread exits.
+struct LocalTimings(Arc<ThreadTimings>);
+
+impl LocalTimings {
+    fn register() -> Self {
+        let mut threads = THREADS.lock();
+        let tid = threads.next_tid;
+        threads.next_tid += 1;
+        let name = std::thread::current()
+            .name()
+            .map_or_else(|| format!("thread-{tid}"), str::to_string);
+        let timings = Arc::new(ThreadTimings::new(tid, name));
+        threads.live.push(Arc::clone(&timings));
+        Self(timings)
+    }
+}
+
+impl Drop for LocalTimings {
+    fn drop(&mut self) {
+        let mut threads = THREADS.lock();
+        threads.live.retain(|t| !Arc::ptr_eq(t, &self.0));
+        threads.retired.push_back(Arc::clone(&self.0));
+        while threads.retired.len() > RETIRED_THREADS {
+            let Some(oldest) = threads.retired.pop_front() else {
+                break;
+            };
+            for (label, histogram) in oldest.histograms.iter().enumerate() {
+                let Some(histogram) = histogram.get() else {
                     continue;
+                };
+                if threads.folded.len() <= label {
+                    threads.folded.resize_with(label + 1, HistogramSum::default);
                 }
-                durations.push(timer.duration_us);
+                histogram.add_to(&mut threads.folded[label]);
             }
         }
+    }
+}
+
+thread_local! {
+    static LOCAL: LocalTimings = LocalTimings::register();
+}
+
+fn record(label: LabelId, start: u64, end: u64, context: Option<String>) {
+    // Fails only while the thread is shutting down; the span is dropped then.
+    let Ok(thread) = LOCAL.try_with(|local| {
+        local.0.record(label, start, end, context.is_none());
+        local.0.tid
+    }) else {
+        return;
+    };
+    if let Some(context) = context {
+        let mut details = DETAILS.lock();
+        if details.len() == DETAIL_CAPACITY {
+            details.pop_front();
+        }
+        details.push_back(Detail {
+            label,
+            thread,
+            start,
+            end,
+            context,
+        });
+    }
+}
+
+/// A running span, see [`timing_start!`](crate::timing_start).
+#[derive(Debug)]
+#[must_use = "a span is only recorded by timing_stop!"]
+pub struct Span {
+    label: LabelId,
+    start: u64,
+    context: Option<String>,
+}
+
+impl Span {
+    pub fn start(label: LabelId, context: Option<String>) -> Self {
+        Self {
+            label,
+            start: now_ns(),
+            context,
+        }
+    }
 
-        durations.sort_unstable();
-        let count = durations.len() as u64;
-        let total: u64 = durations.iter().sum();
-        let min = *durations.first().unwrap_or(&0);
-        let max = *durations.last().unwrap_or(&0);
-        let avg = total.checked_div(count).unwrap_or(0);
-        let p50 = durations.get(percentage_to_index(count, 0.50)).copied().unwrap_or(0);
-        let p75 = durations.get(percentage_to_index(count, 0.75)).copied().unwrap_or(0);
-        let p95 = durations.get(percentage_to_index(count, 0.95)).copied().unwrap_or(0);
-        let p99 = durations.get(percentage_to_index(count, 0.99)).copied().unwrap_or(0);
+    /// Records the span as ending now and returns its duration in nanoseconds.
+    pub fn stop(self) -> u64 {
+        let end = now_ns();
+        record(self.label, self.start, end, self.context);
+        end.saturating_sub(self.start)
+    }
+}
+
+/// Named event counter (cache hits, misses, ...) for paths too hot for a timer per event.
+///
+/// Counters are statics that register themselves with the global registry on first use, so
+/// bumping one is a single atomic add. Declare them through [`counter_add!`](crate::counter_add).
+pub struct Counter {
+    name: &'static str,
+    value: AtomicU64,
+    registered: Once,
+}
 
-        Stats {
-            count,
-            total,
-            min,
-            max,
-            avg,
-            p50,
-            p75,
-            p95,
-            p99,
+impl Counter {
+    #[must_use]
+    pub const fn new(name: &'static str) -> Self {
+        Self {
+            name,
+            value: AtomicU64::new(0),
+            registered: Once::new(),
         }
     }
 
-    /// Returns aggregated stats for every registered namespace.
+    pub fn add(&'static self, n: u64) {
+        self.registered.call_once(|| COUNTERS.lock().push(self));
+        self.value.fetch_add(n, Ordering::Relaxed);
+    }
+
     #[must_use]
-    pub fn namespace_stats(&self) -> Vec<NamespaceStats> {
-        self.namespaces
-            .iter()
-            .map(|(ns, timer_ids)| {
-                let s = self.get_stats(timer_ids);
-                NamespaceStats {
-                    namespace: ns.clone(),
-                    count: s.count,
-                    total_us: s.total,
-                    min_us: s.min,
-                    max_us: s.max,
-                    avg_us: s.avg,
-                    p50_us: s.p50,
-                    p75_us: s.p75,
-                    p95_us: s.p95,
-                    p99_us: s.p99,
-                }
-            })
-            .collect()
-    }
-
-    /// Clears all recorded timings.
-    pub fn clear(&mut self) {
-        self.timers.clear();
-        self.namespaces.clear();
-    }
-
-    fn scale(&self, value: u64, scale: Scale) -> String {
-        match scale {
-            Scale::MicroSecond => format!("{value}µs"),
-            Scale::MilliSecond => format!("{}ms", value / 1000),
-            Scale::Second => format!("{}s", value / (1000 * 1000)),
-            Scale::Auto => {
-                if value < 1000 {
-                    format!("{value}µs")
-                } else if value < 1000 * 1000 {
-                    format!("{}ms", value / 1000)
-                } else {
-                    format!("{}s", value / (1000 * 1000))
+    pub fn get(&self) -> u64 {
+        self.value.load(Ordering::Relaxed)
+    }
+}
+
+/// Returns the current value of every counter that has been bumped at least once, sorted by
+/// name. Counters declared at several call sites under the same name are summed.
+pub fn snapshot_counters() -> Vec<(&'static str, u64)> {
+    let mut totals = BTreeMap::new();
+    for counter in COUNTERS.lock().iter() {
+        *totals.entry(counter.name).or_insert(0) += counter.get();
+    }
+    totals.into_iter().collect()
+}
+
+/// Returns the histogram of every namespace with at least one span, sorted by name.
+pub fn snapshot_histograms() -> Vec<HistogramSnapshot> {
+    let sums = {
+        let threads = THREADS.lock();
+        let mut sums = threads.folded.clone();
+        for thread in threads.all() {
+            for (label, histogram) in thread.histograms.iter().enumerate() {
+                let Some(histogram) = histogram.get() else {
+                    continue;
+                };
+                if sums.len() <= label {
+                    sums.resize_with(label + 1, HistogramSum::default);
                 }
+                histogram.add_to(&mut sums[label]);
             }
         }
+        sums
+    };
+
+    let names = LABELS.read();
+    let mut snapshots: Vec<HistogramSnapshot> = sums
+        .iter()
+        .enumerate()
+        .filter(|(_, sum)| sum.count > 0)
+        .map(|(label, sum)| HistogramSnapshot {
+            namespace: names.names.get(label).copied().unwrap_or_default().to_string(),
+            count: sum.count,
+            total_ns: sum.total,
+            min_ns: sum.min,
+            max_ns: sum.max,
+            buckets: sum
+                .buckets
+                .iter()
+                .enumerate()
+                .filter(|(_, &count)| count > 0)
+                .map(|(index, &count)| {
+                    let (lower, upper) = bucket_bounds(index);
+                    (lower, upper, count)
+                })
+                .collect(),
+        })
+        .collect();
+    snapshots.sort_by(|a, b| a.namespace.cmp(&b.namespace));
+    snapshots
+}
+
+/// Returns aggregated statistics of every namespace with at least one span, sorted by name.
+pub fn snapshot_stats() -> Vec<NamespaceStats> {
+    snapshot_histograms().iter().map(HistogramSnapshot::stats).collect()
+}
+
+/// The spans still held by the ring buffers (the latest [`RING_CAPACITY`] of each thread) and
+/// the recent spans that carry a context, ordered by start time.
+pub fn recent_spans() -> Vec<SpanRecord> {
+    let since = RESET_AT.load(Ordering::Relaxed);
+    let threads: Vec<Arc<ThreadTimings>> = THREADS.lock().all().cloned().collect();
+    let names = LABELS.read();
+
+    let mut spans = Vec::new();
+    for thread in &threads {
+        thread.spans(since, &names.names, &mut spans);
     }
+    spans.extend(DETAILS.lock().iter().filter(|d| d.start >= since).map(|d| SpanRecord {
+        namespace: names.names.get(d.label.0 as usize).copied().unwrap_or_default(),
+        thread: d.thread,
+        start_ns: d.start,
+        end_ns: d.end,
+        context: Some(d.context.clone()),
+    }));
+    spans.sort_by_key(|s| s.start_ns);
+    spans
+}
 
-    pub fn print_timings(&self, show_details: bool, scale: Scale) {
-        println!("Namespace            |    Count |      Total |        Min |        Max |        Avg |        50% |        75% |        95% |        99%");
-        println!("----------------------------------------------------------------------------------------------------------------------------------------");
-        for (namespace, timers) in &self.namespaces {
-            let stats = self.get_stats(timers);
-            println!(
-                "{:20} | {:>8} | {:>10} | {:>10} | {:>10} | {:>10} | {:>10} | {:>10} | {:>10} | {:>10}",
-                namespace,
-                stats.count,
-                self.scale(stats.total, scale.clone()),
-                self.scale(stats.min, scale.clone()),
-                self.scale(stats.max, scale.clone()),
-                self.scale(stats.avg, scale.clone()),
-                self.scale(stats.p50, scale.clone()),
-                self.scale(stats.p75, scale.clone()),
-                self.scale(stats.p95, scale.clone()),
-                self.scale(stats.p99, scale.clone()),
-            );
+/// Number and name of every thread that recorded a span and is still in the trace.
+pub fn thread_names() -> Vec<(u64, String)> {
+    THREADS.lock().all().map(|t| (t.tid, t.name.clone())).collect()
+}
 
-            if show_details {
-                for timer_id in timers {
-                    if let Some(timer) = self.timers.get(timer_id) {
-                        if timer.has_finished() {
-                            let context = timer.context.clone().unwrap_or_default();
-                            if context.is_empty() {
-                                continue;
-                            }
-                            println!(
-                                "                     | {:>8} | {:>10} | {}",
-                                1,
-                                self.scale(timer.duration_us, scale.clone()),
-                                context
-                            );
-                        }
-                    }
+/// [`recent_spans`] in the Chrome trace event format, for `chrome://tracing` and
+/// <https://ui.perfetto.dev>.
+pub fn chrome_trace() -> String {
+    fn push_str(out: &mut String, s: &str) {
+        out.push('"');
+        for c in s.chars() {
+            match c {
+                '"' => out.push_str("\\\""),
+                '\\' => out.push_str("\\\\"),
+                '\n' => out.push_str("\\n"),
+                '\r' => out.push_str("\\r"),
+                '\t' => out.push_str("\\t"),
+                c if u32::from(c) < 0x20 => {
+                    let _ = write!(out, "\\u{:04x}", u32::from(c));
                 }
+                c => out.push(c),
             }
         }
+        out.push('"');
     }
 
-    #[must_use]
-    pub fn duration(&self, timer_id: TimerId) -> u64 {
-        if let Some(timer) = self.timers.get(&timer_id) {
-            timer.duration()
-        } else {
-            0
+    fn push_us(out: &mut String, ns: u64) {
+        let _ = write!(out, "{}.{:03}", ns / 1000, ns % 1000);
+    }
+
+    let mut out = String::from(r#"{"displayTimeUnit":"ms","traceEvents":["#);
+    let mut first = true;
+    let mut separator = |out: &mut String| {
+        if !std::mem::take(&mut first) {
+            out.push(',');
         }
+    };
+
+    for (tid, name) in thread_names() {
+        separator(&mut out);
+        let _ = write!(
+            out,
+            r#"{{"name":"thread_name","ph":"M","pid":1,"tid":{tid},"args":{{"name":"#
+        );
+        push_str(&mut out, &name);
+        out.push_str("}}");
     }
+
+    for span in recent_spans() {
+        separator(&mut out);
+        out.push_str(r#"{"name":"#);
+        push_str(&mut out, span.namespace);
+        let _ = write!(out, r#","cat":"gosub","ph":"X","pid":1,"tid":{},"ts":"#, span.thread);
+        push_us(&mut out, span.start_ns);
+        out.push_str(r#","dur":"#);
+        push_us(&mut out, span.end_ns.saturating_sub(span.start_ns));
+        if let Some(context) = &span.context {
+            out.push_str(r#","args":{"context":"#);
+            push_str(&mut out, context);
+            out.push('}');
+        }
+        out.push('}');
+    }
+
+    out.push_str("]}");
+    out
 }
 
-lazy_static! {
-    pub static ref TIMING_TABLE: Mutex<TimingTable> = Mutex::new(TimingTable::default());
+/// Clears all recorded timings and zeroes all counters.
+pub fn reset_stats() {
+    RESET_AT.store(now_ns(), Ordering::Relaxed);
+    {
+        let mut threads = THREADS.lock();
+        threads.folded.clear();
+        for thread in threads.all() {
+            for histogram in thread.histograms.iter().filter_map(OnceLock::get) {
+                histogram.reset();
+            }
+        }
+    }
+    DETAILS.lock().clear();
+    for counter in COUNTERS.lock().iter() {
+        counter.value.store(0, Ordering::Relaxed);
+    }
 }
 
-/// Returns a snapshot of all namespace statistics from the global timing table.
-pub fn snapshot_stats() -> Vec<NamespaceStats> {
-    TIMING_TABLE.lock().namespace_stats()
+fn scale(value: u64, scale: &Scale) -> String {
+    match scale {
+        Scale::MicroSecond => format!("{value}µs"),
+        Scale::MilliSecond => format!("{}ms", value / 1000),
+        Scale::Second => format!("{}s", value / (1000 * 1000)),
+        Scale::Auto => {
+            if value < 1000 {
+                format!("{value}µs")
+            } else if value < 1000 * 1000 {
+                format!("{}ms", value / 1000)
+            } else {
+                format!("{}s", value / (1000 * 1000))
+            }
+        }
+    }
 }
 
-/// Clears all recorded timings from the global timing table.
-pub fn reset_stats() {
-    TIMING_TABLE.lock().clear();
+/// Print the statistics of every namespace to stdout. When `show_details` is true, also print
+/// the duration and context of each recent span that carries a context.
+pub fn print_timings(show_details: bool, unit: Scale) {
+    let details: Vec<SpanRecord> = if show_details {
+        recent_spans().into_iter().filter(|s| s.context.is_some()).collect()
+    } else {
+        Vec::new()
+    };
+
+    println!("Namespace            |    Count |      Total |        Min |        Max |        Avg |        50% |        75% |        95% |        99%");
+    println!("----------------------------------------------------------------------------------------------------------------------------------------");
+    for stats in snapshot_stats() {
+        println!(
+            "{:20} | {:>8} | {:>10} | {:>10} | {:>10} | {:>10} | {:>10} | {:>10} | {:>10} | {:>10}",
+            stats.namespace,
+            stats.count,
+            scale(stats.total_us, &unit),
+            scale(stats.min_us, &unit),
+            scale(stats.max_us, &unit),
+            scale(stats.avg_us, &unit),
+            scale(stats.p50_us, &unit),
+            scale(stats.p75_us, &unit),
+            scale(stats.p95_us, &unit),
+            scale(stats.p99_us, &unit),
+        );
+
+        for span in details.iter().filter(|s| s.namespace == stats.namespace) {
+            println!(
+                "                     | {:>8} | {:>10} | {}",
+                1,
+                scale(span.end_ns.saturating_sub(span.start_ns) / 1000, &unit),
+                span.context.as_deref().unwrap_or_default()
+            );
+        }
+    }
 }
 
 /// Print the full timing table (all namespaces, aggregated stats) to stdout, auto-scaling units.
-/// When `details` is true, also prints each individual timer's duration and context.
+/// When `details` is true, also prints each recent span's duration and context.
 pub fn dump(details: bool) {
     println!("\n=== Timing table (all values aggregated since start) ===");
-    TIMING_TABLE.lock().print_timings(details, Scale::Auto);
+    print_timings(details, Scale::Auto);
     println!();
 }
 
@@ -255,46 +762,53 @@ pub fn dump(details: bool) {
 ///
 /// Obtain one via [`timing_guard!`](crate::timing_guard) or [`TimerGuard::start`].
 pub struct TimerGuard {
-    id: TimerId,
+    span: Option<Span>,
 }
 
 impl TimerGuard {
     pub fn start(namespace: &str, context: &str) -> Self {
-        let id = TIMING_TABLE.lock().start_timer(namespace, Some(context.to_string()));
-        Self { id }
+        Self::from_span(Span::start(LabelId::intern(namespace), Some(context.to_string())))
     }
 
     pub fn start_anon(namespace: &str) -> Self {
-        let id = TIMING_TABLE.lock().start_timer(namespace, None);
-        Self { id }
+        Self::from_span(Span::start(LabelId::intern(namespace), None))
+    }
+
+    pub fn from_span(span: Span) -> Self {
+        Self { span: Some(span) }
     }
 }
 
 impl Drop for TimerGuard {
     fn drop(&mut self) {
-        TIMING_TABLE.lock().stop_timer(self.id);
+        if let Some(span) = self.span.take() {
+            span.stop();
+        }
     }
 }
 
+/// Start a span; returns a [`Span`](crate::timing::Span) to hand to
+/// [`timing_stop!`](crate::timing_stop). The optional context (formatted with `to_string`) is
+/// kept with the span, at the cost of an allocation and a short lock.
 #[allow(clippy::crate_in_macro_def)]
 #[macro_export]
 macro_rules! timing_start {
     ($namespace:expr, $context:expr) => {{
-        $crate::timing::TIMING_TABLE
-            .lock()
-            .start_timer($namespace, Some($context.to_string()))
+        static LABEL: $crate::timing::Label = $crate::timing::Label::new();
+        $crate::timing::Span::start(LABEL.id($namespace), Some($context.to_string()))
     }};
 
     ($namespace:expr) => {{
-        $crate::timing::TIMING_TABLE.lock().start_timer($namespace, None)
+        static LABEL: $crate::timing::Label = $crate::timing::Label::new();
+        $crate::timing::Span::start(LABEL.id($namespace), None)
     }};
 }
 
 #[allow(clippy::crate_in_macro_def)]
 #[macro_export]
 macro_rules! timing_stop {
-    ($timer_id:expr) => {{
-        $crate::timing::TIMING_TABLE.lock().stop_timer($timer_id);
+    ($span:expr) => {{
+        $crate::timing::Span::stop($span);
     }};
 }
 
@@ -311,10 +825,26 @@ macro_rules! timing_stop {
 #[macro_export]
 macro_rules! timing_guard {
     ($namespace:expr, $context:expr) => {
-        $crate::timing::TimerGuard::start($namespace, $context)
+        $crate::timing::TimerGuard::from_span($crate::timing_start!($namespace, $context))
     };
     ($namespace:expr) => {
-        $crate::timing::TimerGuard::start_anon($namespace)
+        $crate::timing::TimerGuard::from_span($crate::timing_start!($namespace))
+    };
+}
+
+/// Add `n` (default 1) to the counter `name`; see [`Counter`](crate::timing::Counter).
+///
+/// ```rust,ignore
+/// counter_add!("css.style_sharing.hit");
+/// ```
+#[macro_export]
+macro_rules! counter_add {
+    ($name:expr, $n:expr) => {{
+        static COUNTER: $crate::timing::Counter = $crate::timing::Counter::new($name);
+        COUNTER.add($n);
+    }};
+    ($name:expr) => {
+        $crate::counter_add!($name, 1)
     };
 }
 
@@ -322,96 +852,18 @@ macro_rules! timing_guard {
 #[macro_export]
 macro_rules! timing_display {
     () => {{
-        $crate::timing::TIMING_TABLE.lock().print_timings(false, Scale::Auto);
+        $crate::timing::print_timings(false, $crate::timing::Scale::Auto);
     }};
 
     ($scale:expr) => {{
-        $crate::timing::TIMING_TABLE.lock().print_timings(false, $scale);
+        $crate::timing::print_timings(false, $scale);
     }};
 
     ($details:expr, $scale:expr) => {{
-        $crate::timing::TIMING_TABLE.lock().print_timings($details, $scale);
+        $crate::timing::print_timings($details, $scale);
     }};
 }
 
-#[derive(Debug, Clone)]
-pub struct Timer {
-    id: TimerId,
-    context: Option<String>,
-    #[cfg(not(target_arch = "wasm32"))]
-    start: Instant,
-    #[cfg(target_arch = "wasm32")]
-    start: f64,
-    #[cfg(not(target_arch = "wasm32"))]
-    end: Option<Instant>,
-    #[cfg(target_arch = "wasm32")]
-    end: Option<f64>,
-    duration_us: u64,
-}
-
-impl Timer {
-    #[must_use]
-    pub fn new(context: Option<String>) -> Timer {
-        #[cfg(not(target_arch = "wasm32"))]
-        let start = { Instant::now() };
-
-        #[cfg(target_arch = "wasm32")]
-        let start = {
-            window()
-                .and_then(|w| w.performance())
-                .map(|p| p.now())
-                .unwrap_or(f64::NAN)
-        };
-
-        Timer {
-            id: new_timer_id(),
-            context,
-            start,
-            end: None,
-            duration_us: 0,
-        }
-    }
-
-    #[cfg(not(target_arch = "wasm32"))]
-    pub fn start(&mut self) {
-        self.start = Instant::now();
-    }
-
-    #[cfg(target_arch = "wasm32")]
-    pub fn start(&mut self) {
-        self.start = window()
-            .and_then(|w| w.performance())
-            .map(|p| p.now())
-            .unwrap_or(f64::NAN);
-    }
-
-    #[cfg(not(target_arch = "wasm32"))]
-    pub fn end(&mut self) {
-        let now = Instant::now();
-        self.duration_us = now.duration_since(self.start).as_micros() as u64;
-        self.end = Some(now);
-    }
-
-    #[cfg(target_arch = "wasm32")]
-    pub fn end(&mut self) {
-        self.end = window().and_then(|w| w.performance()).map(|p| p.now());
-        self.duration_us = self.end.map(|e| (e - self.start) * 1000.0).unwrap_or(f64::NAN) as u64;
-    }
-
-    pub(crate) fn has_finished(&self) -> bool {
-        self.end.is_some()
-    }
-
-    #[must_use]
-    pub fn duration(&self) -> u64 {
-        if self.end.is_some() {
-            self.duration_us
-        } else {
-            0
-        }
-    }
-}
-
 #[cfg(test)]
 mod tests {
     use rand::random;
@@ -430,6 +882,10 @@ mod tests {
     #[cfg(target_arch = "wasm32")]
     wasm_bindgen_test_configure!(run_in_browser);
 
+    fn histogram(namespace: &str) -> Option<HistogramSnapshot> {
+        snapshot_histograms().into_iter().find(|h| h.namespace == namespace)
+    }
+
     #[test]
     #[cfg(not(target_arch = "wasm32"))]
     fn test_timing_defaults() {
@@ -459,7 +915,9 @@ mod tests {
         sleep(Duration::from_millis(20));
         timing_stop!(t);
 
-        TIMING_TABLE.lock().print_timings(true, Scale::Auto);
+        print_timings(true, Scale::Auto);
+        assert_eq!(histogram("html5.parse").map(|h| h.count), Some(13));
+        assert!(histogram("css.parse").is_some_and(|h| h.min_ns >= 20_000_000));
     }
 
     #[wasm_bindgen_test]
@@ -493,7 +951,108 @@ mod tests {
         sleep(window, Duration::from_millis(20));
         timing_stop!(t);
 
-        TIMING_TABLE.lock().print_timings(true, Scale::Auto);
+        print_timings(true, Scale::Auto);
+    }
+
+    #[test]
+    fn buckets_cover_every_duration() {
+        let mut previous = 0;
+        for ns in (0..5000).chain([1 << 20, (1 << 20) + 1, 123_456_789, MAX_TRACKED_NS]) {
+            let index = bucket_index(ns);
+            let (lower, upper) = bucket_bounds(index);
+            assert!(
+                (lower..upper).contains(&ns),
+                "{ns} outside bucket {index} {lower}..{upper}"
+            );
+            assert!(index >= previous && index < BUCKETS);
+            previous = index;
+        }
+        assert_eq!(bucket_index(u64::MAX), BUCKETS - 1);
+    }
+
+    #[test]
+    fn percentiles_come_from_the_histogram() {
+        let label = LabelId::intern("test.timing.percentiles");
+        for ms in 1..=100 {
+            record(label, 0, ms * 1_000_000, None);
+        }
+        let h = histogram("test.timing.percentiles").unwrap();
+        assert_eq!(h.count, 100);
+        assert_eq!((h.min_ns, h.max_ns), (1_000_000, 100_000_000));
+        for (p, expected_ms) in [(0.5, 51.0), (0.95, 96.0), (0.99, 100.0)] {
+            let got_ms = h.percentile(p) as f64 / 1e6;
+            assert!((got_ms - expected_ms).abs() / expected_ms < 0.15, "p{p}: {got_ms}ms");
+        }
+    }
+
+    #[test]
+    #[cfg(not(target_arch = "wasm32"))]
+    fn spans_from_exited_threads_are_kept() {
+        let workers: Vec<_> = (0..4)
+            .map(|_| {
+                std::thread::spawn(|| {
+                    for _ in 0..100 {
+                        timing_stop!(timing_start!("test.timing.threads"));
+                    }
+                })
+            })
+            .collect();
+        for worker in workers {
+            worker.join().unwrap();
+        }
+        assert_eq!(histogram("test.timing.threads").map(|h| h.count), Some(400));
+    }
+
+    #[test]
+    fn ring_keeps_the_latest_spans() {
+        let label = LabelId::intern("test.timing.ring");
+        for i in 0..RING_CAPACITY as u64 + 10 {
+            record(label, i + 1, i + 2, None);
+        }
+        let spans: Vec<_> = recent_spans()
+            .into_iter()
+            .filter(|s| s.namespace == "test.timing.ring")
+            .collect();
+        assert_eq!(spans.len(), RING_CAPACITY);
+        assert_eq!(spans[0].start_ns, 11);
+        assert_eq!(
+            histogram("test.timing.ring").map(|h| h.count),
+            Some(RING_CAPACITY as u64 + 10)
+        );
+    }
+
+    #[test]
+    fn chrome_trace_lists_spans_with_their_context() {
+        let _t = timing_guard!("test.timing.trace", "say \"hi\"");
+        drop(_t);
+        let trace = chrome_trace();
+        assert!(trace.starts_with(r#"{"displayTimeUnit":"ms","traceEvents":["#));
+        assert!(trace.contains(r#""name":"test.timing.trace","cat":"gosub","ph":"X""#));
+        assert!(trace.contains(r#""args":{"context":"say \"hi\""}"#));
+        assert!(trace.contains(r#""name":"thread_name""#));
+    }
+
+    #[test]
+    fn call_sites_with_changing_labels() {
+        for name in ["test.timing.label.a", "test.timing.label.b", "test.timing.label.a"] {
+            timing_stop!(timing_start!(name));
+        }
+        assert_eq!(histogram("test.timing.label.a").map(|h| h.count), Some(2));
+        assert_eq!(histogram("test.timing.label.b").map(|h| h.count), Some(1));
+    }
+
+    #[test]
+    fn counters_sum_per_name() {
+        for _ in 0..3 {
+            counter_add!("test.counter.sum");
+        }
+        counter_add!("test.counter.sum", 4);
+
+        let value = snapshot_counters()
+            .into_iter()
+            .find(|(name, _)| *name == "test.counter.sum")
+            .map(|(_, v)| v);
+        assert_eq!(value, Some(7));
     }
 
     //This should only be used for testing purposes
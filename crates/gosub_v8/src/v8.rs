@@ -16,6 +16,8 @@ pub use function::*;
 use gosub_shared::types::Result;
 use gosub_webexecutor::js::WebRuntime;
 pub use object::*;
+pub use pool::*;
+pub use snapshot::*;
 pub use value::*;
 
 mod array;
@@ -23,6 +25,8 @@ mod compile;
 mod context;
 mod function;
 mod object;
+mod pool;
+mod snapshot;
 mod value;
 
 // status of the V8 engine
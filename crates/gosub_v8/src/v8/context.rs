@@ -46,6 +46,22 @@ impl V8Ctx {
         }
     }
 
+    /// Replaces the context with a fresh one in the same isolate, dropping every global the old
+    /// one gained. For isolates made from a snapshot, the fresh context starts from the snapshot.
+    ///
+    /// Returns false (and does nothing) while a parent scope is set, as that scope may still
+    /// hold handles into the old context.
+    pub(crate) fn reset_context(&mut self) -> bool {
+        if self.parent_scope.is_some() {
+            return false;
+        }
+
+        let handle_scope = &mut HandleScope::new(&mut self.isolate);
+        let ctx = v8::Context::new(handle_scope, Default::default());
+        self.ctx = Global::new(handle_scope, ctx);
+        true
+    }
+
     pub(crate) fn isolate(&mut self) -> &mut OwnedIsolate {
         &mut self.isolate
     }
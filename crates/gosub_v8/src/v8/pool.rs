@@ -0,0 +1,162 @@
+use std::cell::RefCell;
+use std::rc::Rc;
+
+use gosub_shared::types::Result;
+
+use crate::{V8Context, V8Engine, V8Snapshot};
+
+type Setup = dyn Fn(&mut V8Context) -> Result<()>;
+
+/// A pool of ready-to-run contexts, so a navigation does not pay for isolate creation and
+/// binding setup.
+///
+/// Every context comes from the pool's snapshot (when it has one) and has the setup hook run on
+/// it; the hook is where native bindings such as `console` go, since those cannot be part of a
+/// snapshot. Contexts are tied to the thread that made them, so keep one pool per script
+/// thread (e.g. per zone) rather than sharing it.
+pub struct V8ContextPool {
+    snapshot: Option<V8Snapshot>,
+    setup: Box<Setup>,
+    capacity: usize,
+    idle: RefCell<Vec<V8Context>>,
+}
+
+impl V8ContextPool {
+    /// A pool keeping up to `capacity` idle contexts. Call [`Self::warm`] to fill it up front.
+    pub fn new(
+        snapshot: Option<V8Snapshot>,
+        capacity: usize,
+        setup: impl Fn(&mut V8Context) -> Result<()> + 'static,
+    ) -> Self {
+        V8Engine::initialize();
+        Self {
+            snapshot,
+            setup: Box::new(setup),
+            capacity,
+            idle: RefCell::new(Vec::with_capacity(capacity)),
+        }
+    }
+
+    /// Creates contexts until the pool holds `capacity` idle ones.
+    pub fn warm(&self) -> Result<()> {
+        while self.idle() < self.capacity {
+            let ctx = self.create()?;
+            self.idle.borrow_mut().push(ctx);
+        }
+        Ok(())
+    }
+
+    /// An idle context, or a new one when the pool is empty.
+    pub fn take(&self) -> Result<V8Context> {
+        // Bind first: the `RefMut` must not be alive while `create` runs the setup hook.
+        let ctx = self.idle.borrow_mut().pop();
+        match ctx {
+            Some(ctx) => Ok(ctx),
+            None => self.create(),
+        }
+    }
+
+    /// Returns a context for reuse. Its globals are reset to those of a fresh context before it
+    /// goes back in, so nothing one page did is visible to the next.
+    ///
+    /// A context is dropped instead when the pool is full, when values or compiled scripts still
+    /// refer to it, or when it cannot be reset.
+    pub fn recycle(&self, ctx: V8Context) {
+        if self.idle() >= self.capacity || Rc::strong_count(&ctx.ctx) != 1 {
+            return;
+        }
+        if !ctx.borrow_mut().reset_context() {
+            return;
+        }
+
+        let mut ctx = ctx;
+        if let Err(e) = (self.setup)(&mut ctx) {
+            log::warn!("Failed to set up a recycled V8 context: {e}");
+            return;
+        }
+        self.idle.borrow_mut().push(ctx);
+    }
+
+    /// Number of contexts ready to be taken.
+    pub fn idle(&self) -> usize {
+        self.idle.borrow().len()
+    }
+
+    fn create(&self) -> Result<V8Context> {
+        let mut ctx = match &self.snapshot {
+            Some(snapshot) => V8Context::from_snapshot(snapshot)?,
+            None => V8Context::with_default()?,
+        };
+        (self.setup)(&mut ctx)?;
+        Ok(ctx)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use std::cell::Cell;
+
+    use gosub_webexecutor::js::{WebContext, WebValue};
+
+    use super::*;
+    use crate::V8Value;
+
+    fn counting_pool(snapshot: Option<V8Snapshot>, capacity: usize) -> (V8ContextPool, Rc<Cell<usize>>) {
+        let setups = Rc::new(Cell::new(0));
+        let counter = Rc::clone(&setups);
+        let pool = V8ContextPool::new(snapshot, capacity, move |ctx| {
+            counter.set(counter.get() + 1);
+            ctx.run("globalThis.installed = true;")?;
+            Ok(())
+        });
+        (pool, setups)
+    }
+
+    #[test]
+    fn warm_contexts_are_handed_out_set_up() {
+        let (pool, setups) = counting_pool(None, 2);
+        pool.warm().unwrap();
+        assert_eq!(pool.idle(), 2);
+        assert_eq!(setups.get(), 2);
+
+        let mut ctx = pool.take().unwrap();
+        assert_eq!(pool.idle(), 1);
+        assert!(ctx.run("installed").unwrap().as_bool().unwrap());
+
+        pool.take().unwrap();
+        pool.take().unwrap();
+        assert_eq!(setups.get(), 3, "an empty pool creates contexts on demand");
+    }
+
+    #[test]
+    fn recycled_contexts_forget_the_previous_page() {
+        let snapshot = V8Snapshot::build("globalThis.fromSnapshot = 1;").unwrap();
+        let (pool, setups) = counting_pool(Some(snapshot), 1);
+
+        let mut ctx = pool.take().unwrap();
+        ctx.run("globalThis.leaked = 'secret';").unwrap();
+        pool.recycle(ctx);
+        assert_eq!(pool.idle(), 1);
+        assert_eq!(setups.get(), 2);
+
+        let mut ctx = pool.take().unwrap();
+        assert!(ctx.run("typeof leaked === 'undefined'").unwrap().as_bool().unwrap());
+        assert_eq!(ctx.run("fromSnapshot").unwrap().as_number().unwrap(), 1.0);
+        assert!(ctx.run("installed").unwrap().as_bool().unwrap());
+    }
+
+    #[test]
+    fn contexts_still_in_use_or_over_capacity_are_dropped() {
+        let (pool, _) = counting_pool(None, 1);
+
+        let mut ctx = pool.take().unwrap();
+        let value: V8Value = ctx.run("1").unwrap();
+        pool.recycle(ctx);
+        assert_eq!(pool.idle(), 0);
+        drop(value);
+
+        pool.recycle(pool.take().unwrap());
+        pool.recycle(V8Context::with_default().unwrap());
+        assert_eq!(pool.idle(), 1);
+    }
+}
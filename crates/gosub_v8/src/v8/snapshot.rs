@@ -0,0 +1,213 @@
+use std::path::Path;
+
+use v8::{ContextScope, CreateParams, FunctionCodeHandling, HandleScope, Isolate, Script, TryCatch};
+
+use gosub_shared::types::Result;
+use gosub_webexecutor::js::JSError;
+use gosub_webexecutor::Error;
+
+use crate::{V8Context, V8Ctx, V8Engine};
+
+/// Leading bytes of a snapshot file written by [`V8Snapshot::to_bytes`].
+const MAGIC: &[u8; 8] = b"GOSUBV8S";
+
+/// A V8 startup snapshot: the heap of a context after a prelude script ran.
+///
+/// Isolates created from it start with the prelude's globals in place instead of running it
+/// again. Native (Rust) callbacks cannot be part of a snapshot; install those on each context
+/// after creating it, e.g. through the setup hook of a [`V8ContextPool`](crate::V8ContextPool).
+///
+/// A snapshot only loads into the V8 build that made it. Files carry the V8 version and a hash
+/// of the prelude, and [`Self::from_bytes`] rejects anything else.
+#[derive(Clone, Copy)]
+pub struct V8Snapshot {
+    /// Lives for the rest of the process, as V8 requires of snapshot data. Build one snapshot
+    /// per prelude and share it.
+    blob: &'static [u8],
+    prelude_hash: u64,
+}
+
+impl V8Snapshot {
+    /// Runs `prelude` in a fresh context and snapshots the result.
+    pub fn build(prelude: &str) -> Result<Self> {
+        V8Engine::initialize();
+
+        // A snapshot creator must be turned into a blob before it is dropped (the v8 crate
+        // asserts this), so a failing prelude still goes through `create_blob`.
+        let mut creator = Isolate::snapshot_creator(None, None);
+        let ran = {
+            let scope = &mut HandleScope::new(&mut creator);
+            let context = v8::Context::new(scope, Default::default());
+            let scope = &mut ContextScope::new(scope, context);
+            let ran = run_prelude(&mut TryCatch::new(scope), prelude);
+            scope.set_default_context(context);
+            ran
+        };
+
+        let blob = creator.create_blob(FunctionCodeHandling::Keep);
+        ran?;
+        let Some(blob) = blob else {
+            return Err(Error::JS(JSError::Initialize(
+                "V8 failed to create a startup snapshot".to_string(),
+            ))
+            .into());
+        };
+        Ok(Self {
+            blob: Box::leak(blob.to_vec().into_boxed_slice()),
+            prelude_hash: prelude_hash(prelude),
+        })
+    }
+
+    /// Reads a snapshot written by [`Self::to_bytes`].
+    pub fn from_bytes(bytes: &[u8]) -> Result<Self> {
+        let invalid = |reason: &str| Error::JS(JSError::Initialize(format!("invalid V8 snapshot: {reason}")));
+
+        let rest = bytes
+            .strip_prefix(MAGIC.as_slice())
+            .ok_or_else(|| invalid("not a snapshot file"))?;
+        let (version, rest) = split_field(rest).ok_or_else(|| invalid("truncated header"))?;
+        if version != v8::V8::get_version().as_bytes() {
+            return Err(invalid("made by another V8 version").into());
+        }
+        let (hash, blob) = rest
+            .split_first_chunk::<8>()
+            .ok_or_else(|| invalid("truncated header"))?;
+        if blob.is_empty() {
+            return Err(invalid("empty").into());
+        }
+        Ok(Self {
+            blob: Box::leak(blob.to_vec().into_boxed_slice()),
+            prelude_hash: u64::from_le_bytes(*hash),
+        })
+    }
+
+    /// The snapshot with a header for [`Self::from_bytes`].
+    #[must_use]
+    pub fn to_bytes(&self) -> Vec<u8> {
+        let version = v8::V8::get_version().as_bytes();
+        let mut bytes = Vec::with_capacity(MAGIC.len() + 4 + version.len() + 8 + self.blob.len());
+        bytes.extend_from_slice(MAGIC);
+        bytes.extend_from_slice(&(version.len() as u32).to_le_bytes());
+        bytes.extend_from_slice(version);
+        bytes.extend_from_slice(&self.prelude_hash.to_le_bytes());
+        bytes.extend_from_slice(self.blob);
+        bytes
+    }
+
+    /// The snapshot of `prelude` cached at `path`, building (and caching) it when the file is
+    /// missing, unreadable, or was made from another prelude or V8 version.
+    pub fn load_or_build(path: &Path, prelude: &str) -> Result<Self> {
+        if let Ok(bytes) = std::fs::read(path) {
+            match Self::from_bytes(&bytes) {
+                Ok(snapshot) if snapshot.prelude_hash == prelude_hash(prelude) => return Ok(snapshot),
+                Ok(_) => log::debug!("V8 snapshot {} is of another prelude; rebuilding", path.display()),
+                Err(e) => log::debug!("Rebuilding V8 snapshot {}: {e}", path.display()),
+            }
+        }
+
+        let snapshot = Self::build(prelude)?;
+        if let Err(e) = std::fs::write(path, snapshot.to_bytes()) {
+            log::warn!("Failed to write V8 snapshot {}: {e}", path.display());
+        }
+        Ok(snapshot)
+    }
+
+    pub(crate) fn create_params(&self) -> CreateParams {
+        CreateParams::default().snapshot_blob(v8::StartupData::from(self.blob))
+    }
+}
+
+impl V8Context {
+    /// A context in a new isolate started from `snapshot`.
+    pub fn from_snapshot(snapshot: &V8Snapshot) -> Result<Self> {
+        V8Engine::initialize();
+        Self::new(snapshot.create_params())
+    }
+}
+
+/// Compiles and runs the snapshot prelude, reporting a thrown exception as the error.
+fn run_prelude(try_catch: &mut TryCatch<HandleScope>, prelude: &str) -> Result<()> {
+    let Some(source) = v8::String::new(try_catch, prelude) else {
+        return Err(anyhow::anyhow!("Failed to allocate V8 string for the snapshot prelude"));
+    };
+    let Some(script) = Script::compile(try_catch, source, None) else {
+        return Err(V8Ctx::report_exception(try_catch).into());
+    };
+    if script.run(try_catch).is_none() {
+        return Err(V8Ctx::report_exception(try_catch).into());
+    }
+    Ok(())
+}
+
+/// Splits a `u32` length-prefixed field off `bytes`.
+fn split_field(bytes: &[u8]) -> Option<(&[u8], &[u8])> {
+    let (len, rest) = bytes.split_first_chunk::<4>()?;
+    let len = u32::from_le_bytes(*len) as usize;
+    (rest.len() >= len).then(|| rest.split_at(len))
+}
+
+/// FNV-1a, stable across builds (unlike `DefaultHasher`), so cached files stay valid.
+fn prelude_hash(prelude: &str) -> u64 {
+    prelude.bytes().fold(0xcbf2_9ce4_8422_2325, |hash, byte| {
+        (hash ^ u64::from(byte)).wrapping_mul(0x0000_0100_0000_01b3)
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use gosub_webexecutor::js::{WebContext, WebValue};
+
+    use super::*;
+
+    const PRELUDE: &str = "globalThis.answer = 42; function double(x) { return x * 2; }";
+
+    #[test]
+    fn contexts_start_with_the_prelude() {
+        let snapshot = V8Snapshot::build(PRELUDE).unwrap();
+        let mut context = V8Context::from_snapshot(&snapshot).unwrap();
+
+        let value = context.run("double(answer)").unwrap();
+        assert_eq!(value.as_number().unwrap(), 84.0);
+    }
+
+    #[test]
+    fn bytes_round_trip_and_reject_other_input() {
+        let snapshot = V8Snapshot::build(PRELUDE).unwrap();
+        let bytes = snapshot.to_bytes();
+
+        let loaded = V8Snapshot::from_bytes(&bytes).unwrap();
+        assert_eq!(loaded.prelude_hash, prelude_hash(PRELUDE));
+        let mut context = V8Context::from_snapshot(&loaded).unwrap();
+        assert_eq!(context.run("answer").unwrap().as_number().unwrap(), 42.0);
+
+        assert!(V8Snapshot::from_bytes(b"not a snapshot").is_err());
+        assert!(V8Snapshot::from_bytes(&bytes[..MAGIC.len() + 2]).is_err());
+        let mut other_version = bytes.clone();
+        other_version[MAGIC.len() + 4] ^= 0xff;
+        assert!(V8Snapshot::from_bytes(&other_version).is_err());
+    }
+
+    #[test]
+    fn cached_snapshots_follow_the_prelude() {
+        let dir = std::env::temp_dir().join(format!("gosub-v8-snapshot-{}", std::process::id()));
+        std::fs::create_dir_all(&dir).unwrap();
+        let path = dir.join("prelude.snapshot");
+
+        V8Snapshot::load_or_build(&path, PRELUDE).unwrap();
+        assert!(path.exists());
+        let cached = V8Snapshot::load_or_build(&path, PRELUDE).unwrap();
+        assert_eq!(cached.prelude_hash, prelude_hash(PRELUDE));
+
+        let rebuilt = V8Snapshot::load_or_build(&path, "globalThis.answer = 7;").unwrap();
+        let mut context = V8Context::from_snapshot(&rebuilt).unwrap();
+        assert_eq!(context.run("answer").unwrap().as_number().unwrap(), 7.0);
+
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn failing_preludes_are_reported() {
+        assert!(V8Snapshot::build("throw new Error('boom')").is_err());
+        assert!(V8Snapshot::build("this is not javascript").is_err());
+    }
+}
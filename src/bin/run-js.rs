@@ -1,16 +1,29 @@
 use gosub_shared::types::Result;
-use gosub_v8::{V8Context, V8Engine};
+use gosub_v8::{V8Context, V8Engine, V8Snapshot};
 use gosub_webexecutor::js::{WebContext, WebRuntime, WebValue};
 use std::env::args;
+use std::path::PathBuf;
 
 fn main() -> Result<()> {
-    let Some(file) = args().nth(1) else {
-        eprintln!("Usage: run-js <file>");
-        return Ok(());
+    let mut args = args().skip(1);
+    let (prelude, file) = match (args.next(), args.next(), args.next()) {
+        (Some(flag), Some(prelude), Some(file)) if flag == "--prelude" => (Some(PathBuf::from(prelude)), file),
+        (Some(file), None, None) if file != "--prelude" => (None, file),
+        _ => {
+            eprintln!("Usage: run-js [--prelude <lib.js>] <file>");
+            return Ok(());
+        }
     };
 
-    let mut runtime = V8Engine::new();
-    let mut ctx: V8Context = runtime.new_context()?;
+    let mut ctx: V8Context = match prelude {
+        // The prelude's snapshot is cached next to it, so later runs skip evaluating it
+        Some(prelude) => {
+            let source = std::fs::read_to_string(&prelude)?;
+            let snapshot = V8Snapshot::load_or_build(&prelude.with_extension("js.snapshot"), &source)?;
+            V8Context::from_snapshot(&snapshot)?
+        }
+        None => V8Engine::new().new_context()?,
+    };
 
     let code = std::fs::read_to_string(file)?;
 